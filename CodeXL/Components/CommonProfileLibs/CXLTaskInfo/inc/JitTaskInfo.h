@@ -10,6 +10,9 @@
 #pragma once
 
 #include <tuple>
+#include <atomic>
+#include <memory>
+#include <AMDTBaseTools/Include/gtVector.h>
 #include <inc/JitTaskInfoMapper.h>
 
 #if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
@@ -52,6 +55,11 @@ public:
 protected:
     bool GetUserJitModInfo(TiModuleInfo* pModInfo, TiTimeType systemTimeTick, ModuleMap::value_type& item);
 
+    // build the JIT code index over the module map, once all the JIT info is read
+    void BuildJitCodeIndex();
+    void ClearJitCodeIndex();
+    bool GetIndexedJitModInfo(TiModuleInfo* pModInfo, gtUInt32 rangeIndex);
+
     // processor affinity
     int m_affinity = 0;
 
@@ -59,7 +67,7 @@ protected:
     ModuleMap m_tiModMap;
 
     // JIT data map
-    int m_jnc_counter = 0;
+    std::atomic<int> m_jnc_counter { 0 };
     int m_JitModCount = 0;
     JitBlockInfoMap m_JitInfoMap;
 
@@ -76,6 +84,13 @@ protected:
 
     BitnessMap m_bitnessMap;
 
+    // JIT code index, read-only once built, so that the samples can be looked up by several threads
+    gtVector<JitCodeRange> m_jitCodeRanges;
+    JitCodePidMap m_jitCodePids;
+
+    // jnc index of each range, or JIT_CODE_JNC_UNNAMED / JIT_CODE_JNC_NAMING
+    std::unique_ptr<std::atomic<int>[]> m_jitCodeJncIndices;
+
 #if defined(TI_MULTITHREADED)
     osCriticalSection m_TIMutexJIT;
 #endif
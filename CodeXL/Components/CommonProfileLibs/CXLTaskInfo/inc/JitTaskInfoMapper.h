@@ -198,6 +198,27 @@ typedef gtMap<ModuleKey, ModuleValue> ModuleMap;
 
 typedef gtMap<ModuleKey, JitBlockValue> JitBlockInfoMap;
 
+// An entry of the JIT code index.
+// The ranges of a process are kept in the order of the module map, by descending
+// start address and then descending load time.
+//
+struct JitCodeRange
+{
+    gtUInt64   startAddr;
+    gtUInt64   endAddr;         // start address + JIT block size
+    TiTimeType loadTime;
+    TiTimeType unloadTime;
+    ModuleMap::value_type* pModule;
+    JitBlockValue* pJitBlock;   // nullptr if there is no JIT block info
+};
+
+#define JIT_CODE_JNC_UNNAMED    (-1)
+#define JIT_CODE_JNC_NAMING     (-2)
+
+// JIT code index map
+// key is process id; value is the first range of the process and the number of ranges
+typedef gtMap<gtUInt64, std::pair<gtUInt32, gtUInt32>> JitCodePidMap;
+
 // JIT bitness map
 //      Note: we should keep process bitness in proceessInfo structure.
 //          However it requires to change file format of ti. Since it's close
@@ -13,6 +13,8 @@
 #include <climits>
 #include <string>
 #include <map>
+#include <thread>
+#include <algorithm>
 
 #include <AMDTOSWrappers/Include/osCriticalSectionLocker.h>
 #include <AMDTOSWrappers/Include/osFilePath.h>
@@ -20,6 +22,10 @@
 #include <AMDTProfilingAgentsData/inc/JclReader.h>
 #include <AMDTProfilingAgentsData/inc/JclWriter.h>
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+    #include <AMDTProfilingAgentsData/inc/JitCodeLog.h>
+#endif
+
 #include <inc/JitTaskInfo.h>
 
 
@@ -57,6 +63,8 @@ JitTaskInfo::~JitTaskInfo()
 //
 void JitTaskInfo::Cleanup()
 {
+    ClearJitCodeIndex();
+
 #if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
     m_JitClrMap.clear();
 #endif
@@ -94,6 +102,29 @@ bool CopyFilesToDestionDir(const gtString& srcDirName, const gtString& destDirNa
     return srcDir.copyFilesToDirectory(destDirName, nameFilter);
 }
 
+// Names the JNC file of a JIT block in the session directory. The blocks written to a JIT code log
+// keep referencing their record, as "<log name>#<offset>": the log is moved next to the JCL file.
+static void FormatMovedJncFileName(const wchar_t* pJncFileName, int jncIndex, wchar_t* pName, size_t size)
+{
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+    std::wstring codeLogName;
+    gtUInt64 recordOffset = 0;
+
+    if (JitCodeLogReader::ParseReference(pJncFileName, codeLogName, recordOffset))
+    {
+        size_t pos = codeLogName.rfind(osFilePath::osPathSeparator);
+        const wchar_t* pLogName = codeLogName.c_str() + ((std::wstring::npos != pos) ? (pos + 1) : 0);
+
+        swprintf(pName, size, L"%S%lc%llx", pLogName, JIT_CODE_LOG_REFERENCE_MARK, static_cast<unsigned long long>(recordOffset));
+        return;
+    }
+#else
+    GT_UNREFERENCED_PARAMETER(pJncFileName);
+#endif
+
+    swprintf(pName, size, L"jnc_%d.jnc", jncIndex);
+}
+
 // Note that the directory string should not end in a "\"
 HRESULT JitTaskInfo::ReadJavaJitInformation(const wchar_t* pDirectory, const wchar_t* pSessionDir)
 {
@@ -208,25 +239,23 @@ HRESULT JitTaskInfo::ReadJavaJitInformation(const wchar_t* pDirectory, const wch
                     jitUnloadBlock.unloadTimestamp = CalculateDeltaTick(jitUnloadBlock.unloadTimestamp);
 
                     // find old record module, and alter unload time.
-                    for (auto& mapItem : m_tiModMap)
+                    // The records of the same process and address are adjacent in the map.
+                    ModuleMap::iterator mapIt = m_tiModMap.lower_bound(ModuleKey(tPid, jitUnloadBlock.blockStartAddr, TI_TIMETYPE_MAX));
+
+                    for (ModuleMap::iterator mapEnd = m_tiModMap.end(); mapIt != mapEnd; ++mapIt)
                     {
                         // note that item.first is the key, and item.second is the value
-                        if (mapItem.first.processId != tPid)
+                        if (mapIt->first.processId != tPid || mapIt->first.moduleLoadAddr != jitUnloadBlock.blockStartAddr)
                         {
-                            continue;
-                        }
-
-                        if (mapItem.first.moduleLoadAddr != jitUnloadBlock.blockStartAddr)
-                        {
-                            continue;
+                            break;
                         }
 
-                        if (mapItem.first.moduleLoadTime >= jitUnloadBlock.unloadTimestamp)
+                        if (mapIt->first.moduleLoadTime >= jitUnloadBlock.unloadTimestamp)
                         {
                             continue;
                         }
 
-                        mapItem.second.moduleUnloadTime = (TiTimeType)jitUnloadBlock.unloadTimestamp;
+                        mapIt->second.moduleUnloadTime = (TiTimeType)jitUnloadBlock.unloadTimestamp;
                     }
                 }
             }
@@ -237,6 +266,8 @@ HRESULT JitTaskInfo::ReadJavaJitInformation(const wchar_t* pDirectory, const wch
         }
     }
 
+    BuildJitCodeIndex();
+
     return hr;
 }
 
@@ -255,15 +286,39 @@ HRESULT JitTaskInfo::WriteJavaJncFiles(/*[in]*/ const wchar_t* pDirectory)
 
     std::map<gtUInt64, JclWriter*> jclMap;
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+    // The code logs written by the agent in the asynchronous mode, instead of one JNC file per JIT block.
+    // A log is moved to the session directory once one of its records is used.
+    std::map<std::wstring, bool> codeLogMap;
+#endif
+
     for (const auto& mapItem : m_JitInfoMap)
     {
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+        std::wstring codeLogName;
+        gtUInt64 recordOffset = 0;
+        bool isCodeLogRecord = JitCodeLogReader::ParseReference(mapItem.second.jncFileName, codeLogName, recordOffset);
+        auto codeLogIt = codeLogMap.end();
+
+        if (isCodeLogRecord)
+        {
+            codeLogIt = codeLogMap.insert({ codeLogName, false }).first;
+        }
+#else
+        const bool isCodeLogRecord = false;
+#endif
+
         //If the block wasn't used, go to the next one.
         if (!wcslen(mapItem.second.movedJncFileName))
         {
-            // delete the jit file, if not used
-            osFilePath filepath(mapItem.second.jncFileName);
-            osFile fileToDel(filepath);
-            fileToDel.deleteFile();
+            // delete the jit file, if not used; the code logs are deleted at the end if none of their records is used
+            if (!isCodeLogRecord)
+            {
+                osFilePath filepath(mapItem.second.jncFileName);
+                osFile fileToDel(filepath);
+                fileToDel.deleteFile();
+            }
+
             continue;
         }
 
@@ -313,12 +368,40 @@ HRESULT JitTaskInfo::WriteJavaJncFiles(/*[in]*/ const wchar_t* pDirectory)
             jclIt->second->WriteLoadRecord(&element);
         }
 
-        // Rename from temp->jncFile to temp->translatedJncFile
         gtString newJnc(procDir);
         newJnc.append(osFilePath::osPathSeparator).append(mapItem.second.movedJncFileName);
 
-        osFilePath oldFile(mapItem.second.jncFileName);
-        oldFile.Rename(newJnc);
+        if (isCodeLogRecord)
+        {
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
+            // The record is read in place by JavaJncReader: move the code log next to the JCL file,
+            // where the "<log name>#<offset>" name of the JNC file points
+            if (!codeLogIt->second)
+            {
+                osFilePath oldLog(gtString(codeLogName.c_str()));
+                gtString logFileName;
+                oldLog.getFileNameAndExtension(logFileName);
+
+                gtString newLog(procDir);
+                newLog.append(osFilePath::osPathSeparator).append(logFileName);
+
+                if (oldLog.asString() != newLog)
+                {
+                    oldLog.Rename(newLog);
+                }
+
+                codeLogIt->second = true;
+            }
+
+#endif
+        }
+        else
+        {
+            // Rename from temp->jncFile to temp->translatedJncFile
+            osFilePath oldFile(mapItem.second.jncFileName);
+            oldFile.Rename(newJnc);
+        }
 
         // add unload info, if known
         if (TI_TIMETYPE_MAX != m_tiModMap[mapItem.first].moduleUnloadTime)
@@ -342,6 +425,22 @@ HRESULT JitTaskInfo::WriteJavaJncFiles(/*[in]*/ const wchar_t* pDirectory)
 
     jclMap.clear();
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
+    // delete the code log(s) none of whose records is used
+    for (auto& codeLog : codeLogMap)
+    {
+        if (!codeLog.second)
+        {
+            osFilePath filepath(gtString(codeLog.first.c_str()));
+            osFile fileToDel(filepath);
+            fileToDel.deleteFile();
+        }
+    }
+
+    codeLogMap.clear();
+#endif
+
     return hr;
 }
 
@@ -418,35 +517,35 @@ HRESULT JitTaskInfo::ReadOldJitInfo(/* [in] */ const wchar_t* pDirectory)
                 jclReader.ReadUnLoadRecord(&jit_unload_block);
 
                 // find old record module, and alter unload time.
-                for (auto& mapItem : m_tiModMap)
+                // The records of the same process and address are adjacent in the map.
+                ModuleMap::iterator mapIt = m_tiModMap.lower_bound(ModuleKey(tPid, jit_unload_block.blockStartAddr, TI_TIMETYPE_MAX));
+
+                for (ModuleMap::iterator mapEnd = m_tiModMap.end(); mapIt != mapEnd; ++mapIt)
                 {
                     // note that item.first is the key, and item.second is the value
-                    if (mapItem.first.processId != tPid)
-                    {
-                        continue;
-                    }
-
-                    if (mapItem.first.moduleLoadAddr != jit_unload_block.blockStartAddr)
+                    if (mapIt->first.processId != tPid || mapIt->first.moduleLoadAddr != jit_unload_block.blockStartAddr)
                     {
-                        continue;
+                        break;
                     }
 
-                    if (mapItem.first.moduleLoadTime >= jit_unload_block.unloadTimestamp)
+                    if (mapIt->first.moduleLoadTime >= jit_unload_block.unloadTimestamp)
                     {
                         continue;
                     }
 
-                    if (TI_TIMETYPE_MAX != mapItem.second.moduleUnloadTime)
+                    if (TI_TIMETYPE_MAX != mapIt->second.moduleUnloadTime)
                     {
                         continue;
                     }
 
-                    mapItem.second.moduleUnloadTime = (TiTimeType)jit_unload_block.unloadTimestamp;
+                    mapIt->second.moduleUnloadTime = (TiTimeType)jit_unload_block.unloadTimestamp;
                 }
             }
         }
     }
 
+    BuildJitCodeIndex();
+
     return hr;
 }
 
@@ -495,10 +594,11 @@ bool JitTaskInfo::GetUserJitModInfo(TiModuleInfo* pModInfo, TiTimeType systemTim
 
         if (!item.second.bNameConverted)
         {
-            pJitBlock->jncIndex = m_jnc_counter;
+            int jncIndex = m_jnc_counter++;
+            pJitBlock->jncIndex = jncIndex;
 
-            wchar_t tmpStr[64];
-            swprintf(tmpStr, 64,  L"jnc_%d.jnc", m_jnc_counter++);
+            wchar_t tmpStr[OS_MAX_PATH];
+            FormatMovedJncFileName(pJitBlock->jncFileName, jncIndex, tmpStr, OS_MAX_PATH);
 
 #if defined(TI_MULTITHREADED)
             osCriticalSectionLocker lock(m_TIMutexJIT);
@@ -519,27 +619,165 @@ bool JitTaskInfo::GetUserJitModInfo(TiModuleInfo* pModInfo, TiTimeType systemTim
     return found;
 }
 
-HRESULT JitTaskInfo::GetUserModInfo(TiModuleInfo* pModInfo, TiTimeType systemTimeTick)
+////////////////////////////////////////////////////////////////////////
+// JitTaskInfo::BuildJitCodeIndex()
+//  Build the JIT code index of the module map. The index keeps the
+//  modules of each process in a contiguous array, in the order of the
+//  module map, together with their JIT block info, so that a sample is
+//  resolved with a binary search and without taking any lock.
+//
+//  Param: void.
+//  Redsc: void
+//
+void JitTaskInfo::BuildJitCodeIndex()
 {
-    HRESULT hr = S_FALSE;
+    ClearJitCodeIndex();
+
+    if (m_tiModMap.empty())
+    {
+        return;
+    }
+
+    m_jitCodeRanges.reserve(m_tiModMap.size());
+    m_jitCodeJncIndices.reset(new std::atomic<int>[m_tiModMap.size()]);
 
-    // this is user space, check module map.
-    ModuleMap::iterator i = m_tiModMap.lower_bound(ModuleKey(pModInfo->processID, pModInfo->sampleAddr, TI_TIMETYPE_MAX));
+    for (ModuleMap::iterator it = m_tiModMap.begin(), itEnd = m_tiModMap.end(); it != itEnd; ++it)
+    {
+        JitCodeRange range;
+        range.startAddr = it->first.moduleLoadAddr;
+        range.endAddr = it->first.moduleLoadAddr + it->second.moduleSize;
+        range.loadTime = it->first.moduleLoadTime;
+        range.unloadTime = it->second.moduleUnloadTime;
+        range.pModule = &(*it);
+        range.pJitBlock = nullptr;
+
+        JitBlockInfoMap::iterator jitIter = m_JitInfoMap.find(it->first);
+
+        if (m_JitInfoMap.end() != jitIter)
+        {
+            range.pJitBlock = &jitIter->second;
+        }
 
-    for (ModuleMap::iterator iEnd = m_tiModMap.end(); i != iEnd; ++i)
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+        else
+        {
+            jitIter = m_JitClrMap.find(it->first);
+
+            if (m_JitClrMap.end() != jitIter)
+            {
+                range.pJitBlock = &jitIter->second;
+            }
+        }
+#endif
+
+        gtUInt32 rangeIndex = static_cast<gtUInt32>(m_jitCodeRanges.size());
+        int jncIndex = (nullptr != range.pJitBlock && it->second.bNameConverted) ? range.pJitBlock->jncIndex : JIT_CODE_JNC_UNNAMED;
+        m_jitCodeJncIndices[rangeIndex].store(jncIndex, std::memory_order_relaxed);
+
+        // The module map is sorted by the process id first, so the ranges of a process are adjacent
+        std::pair<gtUInt32, gtUInt32>& pidRanges = m_jitCodePids[it->first.processId];
+
+        if (0 == pidRanges.second)
+        {
+            pidRanges.first = rangeIndex;
+        }
+
+        pidRanges.second++;
+
+        m_jitCodeRanges.push_back(range);
+    }
+}
+
+void JitTaskInfo::ClearJitCodeIndex()
+{
+    m_jitCodeRanges.clear();
+    m_jitCodePids.clear();
+    m_jitCodeJncIndices.reset();
+}
+
+bool JitTaskInfo::GetIndexedJitModInfo(TiModuleInfo* pModInfo, gtUInt32 rangeIndex)
+{
+    const JitCodeRange& range = m_jitCodeRanges[rangeIndex];
+    const ModuleMap::value_type& item = *range.pModule;
+
+    pModInfo->ModuleStartAddr = item.first.moduleLoadAddr;
+    pModInfo->Modulesize = 0;
+    pModInfo->FunStartAddr = item.first.moduleLoadAddr;
+    pModInfo->instanceId = item.second.instanceId;
+
+    // The module name is the JIT function name.
+    wcsncpy(pModInfo->pFunctionName, item.second.moduleName, pModInfo->funNameSize);
+
+    JitBlockValue* pJitBlock = range.pJitBlock;
+    bool found = (nullptr != pJitBlock);
+
+    if (found)
     {
-        ModuleMap::value_type& item = *i;
+        wcsncpy(pModInfo->pModulename, pJitBlock->categoryName.asCharArray(), pModInfo->namesize);
+        wcsncpy(pModInfo->pJavaSrcFileName, pJitBlock->srcFileName, pModInfo->srcfilesize);
+
+        pModInfo->Modulesize = item.second.moduleSize;
+
+        // The first thread to hit the JIT block names its jnc file, the others wait for the name
+        std::atomic<int>& jncIndex = m_jitCodeJncIndices[rangeIndex];
+        int index = jncIndex.load(std::memory_order_acquire);
 
-        // different process
-        if (item.first.processId != pModInfo->processID)
+        if (0 > index)
         {
-            break;
+            int unnamed = JIT_CODE_JNC_UNNAMED;
+
+            if (jncIndex.compare_exchange_strong(unnamed, JIT_CODE_JNC_NAMING, std::memory_order_acquire))
+            {
+                index = m_jnc_counter++;
+
+                pJitBlock->jncIndex = index;
+                FormatMovedJncFileName(pJitBlock->jncFileName, index, pJitBlock->movedJncFileName, OS_MAX_PATH);
+                range.pModule->second.bNameConverted = true;
+
+                jncIndex.store(index, std::memory_order_release);
+            }
+            else
+            {
+                while (0 > jncIndex.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+            }
         }
 
-        // since the module map is sorted by the process id, module address and time.
-        // if module load address is greater than sample address, we don't need
-        // go farther.
-        if ((item.first.moduleLoadAddr + item.second.moduleSize) < pModInfo->sampleAddr)
+        wcsncpy(pModInfo->pJncName, pJitBlock->movedJncFileName, pModInfo->jncNameSize);
+    }
+
+    return found;
+}
+
+HRESULT JitTaskInfo::GetUserModInfo(TiModuleInfo* pModInfo, TiTimeType systemTimeTick)
+{
+    HRESULT hr = S_FALSE;
+
+    // this is user space, check the JIT code index.
+    JitCodePidMap::const_iterator pidIt = m_jitCodePids.find(pModInfo->processID);
+
+    if (m_jitCodePids.end() == pidIt)
+    {
+        return hr;
+    }
+
+    gtUInt64 sampleAddr = pModInfo->sampleAddr;
+    const JitCodeRange* pFirst = &m_jitCodeRanges[pidIt->second.first];
+    const JitCodeRange* pLast = pFirst + pidIt->second.second;
+
+    // since the ranges are sorted by descending start address, skip the ones
+    // starting above the sample address.
+    const JitCodeRange* pRange = std::partition_point(pFirst, pLast, [sampleAddr](const JitCodeRange & range)
+    {
+        return sampleAddr < range.startAddr;
+    });
+
+    for (; pRange != pLast; ++pRange)
+    {
+        // if the block ends below the sample address, we don't need go farther.
+        if (pRange->endAddr < sampleAddr)
         {
             break;
         }
@@ -547,26 +785,40 @@ HRESULT JitTaskInfo::GetUserModInfo(TiModuleInfo* pModInfo, TiTimeType systemTim
         //TODO: Linux: timing between PERF and Agent
 #if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
 
-        // if load time is not in module load frame, try next module
-        if (0 != systemTimeTick && (item.first.moduleLoadTime >= systemTimeTick || item.second.moduleUnloadTime < systemTimeTick))
+        if (0 != systemTimeTick)
         {
-            continue;
+            // the blocks loaded at the same address are sorted by descending load time,
+            // skip the ones loaded after the sample.
+            if (pRange->loadTime >= systemTimeTick)
+            {
+                gtUInt64 startAddr = pRange->startAddr;
+                pRange = std::partition_point(pRange, pLast, [startAddr, systemTimeTick](const JitCodeRange & range)
+                {
+                    return startAddr == range.startAddr && range.loadTime >= systemTimeTick;
+                }) - 1;
+                continue;
+            }
+
+            if (pRange->unloadTime < systemTimeTick)
+            {
+                continue;
+            }
         }
 
 #endif
 
-        pModInfo->moduleType = item.second.moduleType;
+        pModInfo->moduleType = pRange->pModule->second.moduleType;
 
         // We will only handle evJavaModule here
-        if (evJavaModule == item.second.moduleType)
+        if (evJavaModule == pModInfo->moduleType)
         {
-            if (GetUserJitModInfo(pModInfo, systemTimeTick, item))
+            if (GetIndexedJitModInfo(pModInfo, static_cast<gtUInt32>(pRange - &m_jitCodeRanges[0])))
             {
                 hr = S_OK;
                 break;
             }
         } // Java Module
-    } // module iter
+    } // range iter
 
     return hr;
 }
@@ -91,6 +91,12 @@ protected:
     /// \param sample the data of the sample of the thread
     void AddSampleToCore(const AMDTThreadSample& sample);
 
+    /// Fill a thread sample from the columns of the thread timeline:
+    /// \param timeline the samples of the thread
+    /// \param index the index of the sample in the timeline
+    /// \param sample the sample to fill
+    void GetTimelineSample(const AMDTThreadSampleTimeline& timeline, AMDTUInt32 index, AMDTThreadSample& sample);
+
     /// Create a timeline item for the requested thread sample:
     /// \param sample the timeline sample extracted from the backed
     /// \return an acTimelineItem created with the properties set
@@ -196,39 +196,38 @@ void tpThreadsTimeline::AddThreadTimeSamples(acTimelineBranch* pThreadBranch, AM
         AMDTResult rc = AMDTGetThreadData(*m_pSessionData->ReaderHandler(), threadId, &threadData);
         GT_IF_WITH_ASSERT(rc == AMDT_STATUS_OK)
         {
-            AMDTUInt32 samplesCount = 0;
-            rc = AMDTGetThreadSampleData(*m_pSessionData->ReaderHandler(), threadId, &samplesCount, nullptr);
+            // Get all the samples of the thread, without copying them:
+            AMDTThreadSampleTimeline timeline;
+            rc = AMDTGetThreadSampleTimeline(*m_pSessionData->ReaderHandler(), threadId, 0, AMDT_THREAD_SAMPLE_MAX_TS, &timeline);
             GT_IF_WITH_ASSERT(rc == AMDT_STATUS_OK)
             {
+                AMDTUInt32 samplesCount = timeline.m_nbrSamples;
+
                 if (samplesCount > 0)
                 {
                     // Initialize the samples count for this thread in the progress bar:
                     QString progressText = QString(CP_STR_ThreadsTimelineThreadProgress).arg(threadId);
                     afProgressBarWrapper::instance().setProgressDetails(acQStringToGTString(progressText), samplesCount);
 
-                    AMDTThreadSample* pSamples = new AMDTThreadSample[samplesCount];
-                    rc = AMDTGetThreadSampleData(*m_pSessionData->ReaderHandler(), threadId, nullptr, &pSamples);
-                    GT_IF_WITH_ASSERT(rc == AMDT_STATUS_OK)
+                    for (AMDTUInt32 i = 0; i < samplesCount; i++)
                     {
-                        for (AMDTUInt32 i = 0; i < samplesCount; i++)
-                        {
-                            AMDTThreadSample sample = pSamples[i];
+                        AMDTThreadSample sample;
+                        GetTimelineSample(timeline, i, sample);
 
-                            // Create a timeline item for this sample:
-                            tpThreadsTimelineItem* pThreadSampleTime = CreateTimelineItem(sample);
+                        // Create a timeline item for this sample:
+                        tpThreadsTimelineItem* pThreadSampleTime = CreateTimelineItem(sample);
 
-                            GT_IF_WITH_ASSERT(pThreadSampleTime != nullptr)
-                            {
-                                // Add the timeline item:
-                                pThreadBranch->addTimelineItem(pThreadSampleTime);
-                            }
+                        GT_IF_WITH_ASSERT(pThreadSampleTime != nullptr)
+                        {
+                            // Add the timeline item:
+                            pThreadBranch->addTimelineItem(pThreadSampleTime);
+                        }
 
-                            // Add this sample to the branch related to the sample core:
-                            AddSampleToCore(sample);
+                        // Add this sample to the branch related to the sample core:
+                        AddSampleToCore(sample);
 
-                            // Increment the progress bar:
-                            afProgressBarWrapper::instance().incrementProgressBar();
-                        }
+                        // Increment the progress bar:
+                        afProgressBarWrapper::instance().incrementProgressBar();
                     }
 
                     afProgressBarWrapper::instance().hideProgressBar();
@@ -342,6 +341,31 @@ void tpThreadsTimeline::OnSettingsChanged(const tpControlPanalData& cpData)
     }
 }
 
+void tpThreadsTimeline::GetTimelineSample(const AMDTThreadSampleTimeline& timeline, AMDTUInt32 index, AMDTThreadSample& sample)
+{
+    sample.m_processId = timeline.m_processId;
+    sample.m_threadId = timeline.m_threadId;
+    sample.m_coreId = timeline.m_pCoreId[index];
+    sample.m_startTS = timeline.m_pStartTS[index];
+    sample.m_endTS = timeline.m_pEndTS[index];
+    sample.m_execTime = timeline.m_pExecTime[index];
+    sample.m_waitTime = timeline.m_pWaitTime[index];
+    sample.m_transitionTime = timeline.m_pTransitionTime[index];
+    sample.m_threadState = static_cast<AMDTThreadState>(timeline.m_pThreadState[index]);
+    sample.m_waitReason = static_cast<AMDTThreadWaitReason>(timeline.m_pWaitReason[index]);
+    sample.m_waitMode = static_cast<AMDTThreadWaitMode>(timeline.m_pWaitMode[index]);
+    sample.m_nbrStackFrames = 0;
+    sample.m_pStackFrames = nullptr;
+
+    const AMDTUInt64* pFrames = nullptr;
+
+    if ((timeline.m_pStackId[index] != AMDT_THREAD_SAMPLE_NO_STACK) &&
+        (AMDTGetThreadSampleStack(*m_pSessionData->ReaderHandler(), timeline.m_pStackId[index], &sample.m_nbrStackFrames, &pFrames) == AMDT_STATUS_OK))
+    {
+        sample.m_pStackFrames = const_cast<AMDTUInt64*>(pFrames);
+    }
+}
+
 tpThreadsTimelineItem* tpThreadsTimeline::CreateTimelineItem(const AMDTThreadSample& sample)
 {
     // Create a timeline item for this sample:
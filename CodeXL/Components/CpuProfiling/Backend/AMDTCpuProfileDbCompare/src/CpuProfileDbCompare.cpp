@@ -0,0 +1,521 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file CpuProfileDbCompare.cpp
+/// \brief Compares the results of the cxlProfileDataReader queries on two CPU profile DBs.
+///
+/// Translate the same raw data file twice, once with CODEXL_CPU_DB_NO_BULK_LOAD set so that the
+/// DB is written without the bulk load, and compare the two DBs with this tool:
+///
+///     CodeXLCpuProfileDbCompare <reference DB> <bulk-loaded DB>
+///
+/// The exit code is 0 if every query returns the same rows from both DBs.
+//==================================================================================
+
+#include <cstdio>
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+// Infra:
+#include <AMDTBaseTools/Include/gtMap.h>
+#include <AMDTBaseTools/Include/gtString.h>
+#include <AMDTBaseTools/Include/gtVector.h>
+
+// Backend:
+#include <AMDTCpuProfilingDataAccess/inc/AMDTCpuProfilingDataAccess.h>
+
+//
+// Macros
+//
+
+// Number of differing rows printed for each query
+#define CXL_DB_COMPARE_MAX_PRINTED_ROWS     10
+
+#define CXL_DB_COMPARE_SUCCESS              0
+#define CXL_DB_COMPARE_DIFFERENT            1
+#define CXL_DB_COMPARE_ERROR                2
+
+// The rows returned by each query, keyed by the query and its parameters
+typedef gtMap<gtString, gtVector<gtString>> QueryResults;
+
+
+static gtVector<gtString>& GetRows(QueryResults& results, const gtString& query)
+{
+    // An empty result is recorded too, so that it is compared against the other DB
+    return results[query];
+}
+
+static void AppendSampleValues(gtString& row, const AMDTSampleValueVec& sampleValues)
+{
+    for (const auto& value : sampleValues)
+    {
+        row.appendFormattedString(L" [%u %u %.6f %.6f]",
+                                  value.m_counterId,
+                                  value.m_coreId,
+                                  value.m_sampleCount,
+                                  value.m_sampleCountPercentage);
+    }
+}
+
+static void AddProfileData(QueryResults& results, const gtString& query, const AMDTProfileDataVec& profileData)
+{
+    gtVector<gtString>& rows = GetRows(results, query);
+
+    for (const auto& data : profileData)
+    {
+        gtString row;
+        row.appendFormattedString(L"%d %llu %u %ls",
+                                  static_cast<int>(data.m_type),
+                                  static_cast<unsigned long long>(data.m_id),
+                                  data.m_moduleId,
+                                  data.m_name.asCharArray());
+        AppendSampleValues(row, data.m_sampleValue);
+        rows.push_back(row);
+    }
+}
+
+static void AddModuleInfo(gtVector<gtString>& rows, const AMDTProfileModuleInfo& module)
+{
+    gtString row;
+    row.appendFormattedString(L"module %u %d %ls 0x%llx %u %d %d %d",
+                              module.m_moduleId,
+                              static_cast<int>(module.m_type),
+                              module.m_path.asCharArray(),
+                              static_cast<unsigned long long>(module.m_loadAddress),
+                              module.m_size,
+                              module.m_is64Bit,
+                              module.m_isSystemModule,
+                              module.m_foundDebugInfo);
+    rows.push_back(row);
+}
+
+static void AddThreadInfo(gtVector<gtString>& rows, const AMDTProfileThreadInfo& thread)
+{
+    gtString row;
+    row.appendFormattedString(L"thread %u %u", thread.m_pid, thread.m_threadId);
+    rows.push_back(row);
+}
+
+static void AddCallGraphFunctions(QueryResults& results, const gtString& query, const AMDTCallGraphFunctionVec& functions)
+{
+    gtVector<gtString>& rows = GetRows(results, query);
+
+    for (const auto& func : functions)
+    {
+        gtString row;
+        row.appendFormattedString(L"%u %ls %u 0x%llx %d %.6f %.6f %.6f %u",
+                                  func.m_functionInfo.m_functionId,
+                                  func.m_functionInfo.m_name.asCharArray(),
+                                  func.m_functionInfo.m_moduleId,
+                                  static_cast<unsigned long long>(func.m_moduleBaseAddr),
+                                  func.m_isSystemModule,
+                                  func.m_totalSelfSamples,
+                                  func.m_totalDeepSamples,
+                                  func.m_deepSamplesPerc,
+                                  func.m_pathCount);
+        rows.push_back(row);
+    }
+}
+
+static void CollectSessionResults(cxlProfileDataReader& reader, QueryResults& results)
+{
+    // The paths of the DB and of its session directory differ between the two DBs
+    AMDTProfileSessionInfo sessionInfo;
+    reader.GetProfileSessionInfo(sessionInfo);
+
+    gtString sessionRow;
+    sessionRow.appendFormattedString(L"%ls %ls %ls %u %u 0x%llx %d",
+                                     sessionInfo.m_targetAppPath.asCharArray(),
+                                     sessionInfo.m_sessionStartTime.asCharArray(),
+                                     sessionInfo.m_sessionEndTime.asCharArray(),
+                                     sessionInfo.m_cpuFamily,
+                                     sessionInfo.m_cpuModel,
+                                     static_cast<unsigned long long>(sessionInfo.m_coreAffinity),
+                                     sessionInfo.m_cssEnabled);
+    GetRows(results, L"GetProfileSessionInfo").push_back(sessionRow);
+
+    AMDTCpuTopologyVec topology;
+    reader.GetCpuTopology(topology);
+    gtVector<gtString>& topologyRows = GetRows(results, L"GetCpuTopology");
+
+    for (const auto& core : topology)
+    {
+        gtString row;
+        row.appendFormattedString(L"%u %u %u", core.m_coreId, core.m_processorId, core.m_numaNodeId);
+        topologyRows.push_back(row);
+    }
+
+    AMDTProfileCounterDescVec counters;
+    reader.GetSampledCountersList(counters);
+    gtVector<gtString>& counterRows = GetRows(results, L"GetSampledCountersList");
+
+    for (const auto& counter : counters)
+    {
+        gtString row;
+        row.appendFormattedString(L"%u 0x%x %ls", counter.m_id, counter.m_hwEventId, counter.m_name.asCharArray());
+
+        AMDTProfileSamplingConfig samplingConfig;
+
+        if (reader.GetSamplingConfiguration(counter.m_id, samplingConfig))
+        {
+            row.appendFormattedString(L" %llu 0x%x %d %d",
+                                      static_cast<unsigned long long>(samplingConfig.m_samplingInterval),
+                                      static_cast<unsigned int>(samplingConfig.m_unitMask),
+                                      samplingConfig.m_userMode,
+                                      samplingConfig.m_osMode);
+        }
+
+        counterRows.push_back(row);
+    }
+
+    for (int sepByCore = 0; sepByCore < 2; sepByCore++)
+    {
+        AMDTSampleValueVec sampleCount;
+        reader.GetSampleCount(0 != sepByCore, sampleCount);
+
+        gtString row;
+        AppendSampleValues(row, sampleCount);
+
+        gtString query;
+        query.appendFormattedString(L"GetSampleCount(%d)", sepByCore);
+        GetRows(results, query).push_back(row);
+    }
+}
+
+static void CollectInfoResults(cxlProfileDataReader& reader, QueryResults& results)
+{
+    AMDTProfileProcessInfoVec processes;
+    reader.GetProcessInfo(AMDT_PROFILE_ALL_PROCESSES, processes);
+    gtVector<gtString>& processRows = GetRows(results, L"GetProcessInfo");
+
+    for (const auto& process : processes)
+    {
+        gtString row;
+        row.appendFormattedString(L"process %u %ls %d", process.m_pid, process.m_path.asCharArray(), process.m_is64Bit);
+        processRows.push_back(row);
+
+        for (const auto& module : process.m_modulesList)
+        {
+            AddModuleInfo(processRows, module);
+        }
+
+        for (const auto& thread : process.m_threadsList)
+        {
+            AddThreadInfo(processRows, thread);
+        }
+    }
+
+    AMDTProfileModuleInfoVec modules;
+    reader.GetModuleInfo(AMDT_PROFILE_ALL_PROCESSES, AMDT_PROFILE_ALL_MODULES, modules);
+    gtVector<gtString>& moduleRows = GetRows(results, L"GetModuleInfo");
+
+    for (const auto& module : modules)
+    {
+        AddModuleInfo(moduleRows, module);
+    }
+
+    AMDTProfileThreadInfoVec threads;
+    reader.GetThreadInfo(AMDT_PROFILE_ALL_PROCESSES, AMDT_PROFILE_ALL_THREADS, threads);
+    gtVector<gtString>& threadRows = GetRows(results, L"GetThreadInfo");
+
+    for (const auto& thread : threads)
+    {
+        AddThreadInfo(threadRows, thread);
+    }
+}
+
+static void CollectProfileDataResults(cxlProfileDataReader& reader, QueryResults& results)
+{
+    AMDTProfileCounterDescVec counters;
+    reader.GetSampledCountersList(counters);
+
+    AMDTProfileSessionInfo sessionInfo;
+    reader.GetProfileSessionInfo(sessionInfo);
+
+    // The summaries return all the entries, so that the entries of the same sample count
+    // cannot be cut differently from the two DBs
+    AMDTProfileDataOptions options;
+    options.m_coreMask = sessionInfo.m_coreAffinity;
+    options.m_ignoreSystemModules = false;
+    options.m_doSort = true;
+    options.m_summaryCount = 0xFFFF;
+    options.m_isSeperateByCore = false;
+    options.m_othersEntryInSummary = false;
+
+    for (const auto& counter : counters)
+    {
+        options.m_counters.push_back(counter.m_id);
+    }
+
+    reader.SetReportOption(options);
+
+    for (const auto& counter : counters)
+    {
+        AMDTProfileDataVec summary;
+        gtString query;
+
+        reader.GetProcessSummary(counter.m_id, summary);
+        query.appendFormattedString(L"GetProcessSummary(%u)", counter.m_id);
+        AddProfileData(results, query, summary);
+
+        summary.clear();
+        query.makeEmpty();
+        reader.GetThreadSummary(counter.m_id, summary);
+        query.appendFormattedString(L"GetThreadSummary(%u)", counter.m_id);
+        AddProfileData(results, query, summary);
+
+        summary.clear();
+        query.makeEmpty();
+        reader.GetModuleSummary(counter.m_id, summary);
+        query.appendFormattedString(L"GetModuleSummary(%u)", counter.m_id);
+        AddProfileData(results, query, summary);
+
+        summary.clear();
+        query.makeEmpty();
+        reader.GetFunctionSummary(counter.m_id, summary);
+        query.appendFormattedString(L"GetFunctionSummary(%u)", counter.m_id);
+        AddProfileData(results, query, summary);
+    }
+
+    AMDTProfileDataVec processData;
+    reader.GetProcessProfileData(AMDT_PROFILE_ALL_PROCESSES, AMDT_PROFILE_ALL_MODULES, processData);
+    AddProfileData(results, L"GetProcessProfileData", processData);
+
+    AMDTProfileDataVec moduleData;
+    reader.GetModuleProfileData(AMDT_PROFILE_ALL_PROCESSES, AMDT_PROFILE_ALL_MODULES, moduleData);
+    AddProfileData(results, L"GetModuleProfileData", moduleData);
+
+    AMDTProfileDataVec threadData;
+    reader.GetAllThreadsProfileData(threadData);
+    AddProfileData(results, L"GetAllThreadsProfileData", threadData);
+
+    AMDTProfileDataVec functionData;
+    reader.GetFunctionProfileData(AMDT_PROFILE_ALL_PROCESSES, AMDT_PROFILE_ALL_MODULES, functionData);
+    AddProfileData(results, L"GetFunctionProfileData", functionData);
+
+    for (const auto& process : processData)
+    {
+        AMDTProcessId pid = static_cast<AMDTProcessId>(process.m_id);
+        AMDTProfileDataVec data;
+        gtString query;
+
+        reader.GetModuleProfileData(pid, AMDT_PROFILE_ALL_MODULES, data);
+        query.appendFormattedString(L"GetModuleProfileData(%u)", pid);
+        AddProfileData(results, query, data);
+
+        data.clear();
+        query.makeEmpty();
+        reader.GetFunctionProfileData(pid, AMDT_PROFILE_ALL_MODULES, data);
+        query.appendFormattedString(L"GetFunctionProfileData(%u)", pid);
+        AddProfileData(results, query, data);
+    }
+
+    // The samples of each function, by offset
+    for (const auto& function : functionData)
+    {
+        AMDTFunctionId funcId = static_cast<AMDTFunctionId>(function.m_id);
+        AMDTProfileFunctionData data;
+        reader.GetFunctionData(funcId, AMDT_PROFILE_ALL_PROCESSES, AMDT_PROFILE_ALL_THREADS, data);
+
+        gtString query;
+        query.appendFormattedString(L"GetFunctionData(0x%x)", funcId);
+        gtVector<gtString>& rows = GetRows(results, query);
+
+        gtString infoRow;
+        infoRow.appendFormattedString(L"function %ls %u 0x%llx %u 0x%llx",
+                                      data.m_functionInfo.m_name.asCharArray(),
+                                      data.m_functionInfo.m_moduleId,
+                                      static_cast<unsigned long long>(data.m_functionInfo.m_startOffset),
+                                      data.m_functionInfo.m_size,
+                                      static_cast<unsigned long long>(data.m_modBaseAddress));
+        rows.push_back(infoRow);
+
+        for (auto pid : data.m_pidsList)
+        {
+            gtString row;
+            row.appendFormattedString(L"pid %u", pid);
+            rows.push_back(row);
+        }
+
+        for (auto tid : data.m_threadsList)
+        {
+            gtString row;
+            row.appendFormattedString(L"tid %u", tid);
+            rows.push_back(row);
+        }
+
+        for (const auto& inst : data.m_instDataList)
+        {
+            gtString row;
+            row.appendFormattedString(L"offset 0x%x", inst.m_offset);
+            AppendSampleValues(row, inst.m_sampleValues);
+            rows.push_back(row);
+        }
+    }
+}
+
+static void CollectCallGraphResults(cxlProfileDataReader& reader, QueryResults& results)
+{
+    AMDTProfileCounterDescVec counters;
+    reader.GetSampledCountersList(counters);
+
+    gtVector<AMDTProcessId> cssProcesses;
+    reader.GetCallGraphProcesses(cssProcesses);
+    gtVector<gtString>& processRows = GetRows(results, L"GetCallGraphProcesses");
+
+    for (auto pid : cssProcesses)
+    {
+        gtString row;
+        row.appendFormattedString(L"%u", pid);
+        processRows.push_back(row);
+
+        for (const auto& counter : counters)
+        {
+            AMDTCallGraphFunctionVec cgFunctions;
+            reader.GetCallGraphFunctions(pid, counter.m_id, cgFunctions);
+
+            gtString query;
+            query.appendFormattedString(L"GetCallGraphFunctions(%u, %u)", pid, counter.m_id);
+            AddCallGraphFunctions(results, query, cgFunctions);
+
+            for (const auto& cgFunc : cgFunctions)
+            {
+                AMDTFunctionId funcId = cgFunc.m_functionInfo.m_functionId;
+                AMDTCallGraphFunctionVec callers;
+                AMDTCallGraphFunctionVec callees;
+                reader.GetCallGraphFunctionInfo(pid, funcId, callers, callees);
+
+                query.makeEmpty();
+                query.appendFormattedString(L"GetCallGraphFunctionInfo(%u, 0x%x) callers", pid, funcId);
+                AddCallGraphFunctions(results, query, callers);
+
+                query.makeEmpty();
+                query.appendFormattedString(L"GetCallGraphFunctionInfo(%u, 0x%x) callees", pid, funcId);
+                AddCallGraphFunctions(results, query, callees);
+            }
+        }
+    }
+}
+
+static bool CollectResults(const gtString& dbPath, QueryResults& results)
+{
+    cxlProfileDataReader reader;
+
+    if (!reader.OpenProfileData(dbPath))
+    {
+        fprintf(stderr, "Could not open the profile DB (%ls).\n", dbPath.asCharArray());
+        return false;
+    }
+
+    CollectSessionResults(reader, results);
+    CollectInfoResults(reader, results);
+    CollectProfileDataResults(reader, results);
+    CollectCallGraphResults(reader, results);
+
+    reader.CloseProfileData();
+    return true;
+}
+
+static void PrintRows(const char* pPrefix, const gtVector<gtString>& rows)
+{
+    size_t numPrinted = std::min(rows.size(), static_cast<size_t>(CXL_DB_COMPARE_MAX_PRINTED_ROWS));
+
+    for (size_t i = 0; i < numPrinted; i++)
+    {
+        fprintf(stdout, "    %s %ls\n", pPrefix, rows[i].asCharArray());
+    }
+
+    if (numPrinted < rows.size())
+    {
+        fprintf(stdout, "    %s ... %u more rows\n", pPrefix, static_cast<unsigned int>(rows.size() - numPrinted));
+    }
+}
+
+// Returns true if the query returned the same rows from both DBs. The order of the rows is not compared,
+// as the rows of the same sample count may come in any order.
+static bool CompareRows(const gtString& query, gtVector<gtString> refRows, gtVector<gtString> rows)
+{
+    std::sort(refRows.begin(), refRows.end());
+    std::sort(rows.begin(), rows.end());
+
+    gtVector<gtString> missingRows;
+    gtVector<gtString> extraRows;
+    std::set_difference(refRows.begin(), refRows.end(), rows.begin(), rows.end(), std::back_inserter(missingRows));
+    std::set_difference(rows.begin(), rows.end(), refRows.begin(), refRows.end(), std::back_inserter(extraRows));
+
+    bool isSame = missingRows.empty() && extraRows.empty();
+
+    if (!isSame)
+    {
+        fprintf(stdout, "%ls: %u rows in the reference DB, %u rows in the compared DB\n",
+                query.asCharArray(), static_cast<unsigned int>(refRows.size()), static_cast<unsigned int>(rows.size()));
+        PrintRows("-", missingRows);
+        PrintRows("+", extraRows);
+    }
+
+    return isSame;
+}
+
+static int CompareResults(const QueryResults& refResults, const QueryResults& results)
+{
+    const gtVector<gtString> noRows;
+    unsigned int numQueries = 0;
+    unsigned int numDifferent = 0;
+
+    for (const auto& refQuery : refResults)
+    {
+        auto it = results.find(refQuery.first);
+        numQueries++;
+
+        if (!CompareRows(refQuery.first, refQuery.second, (it != results.end()) ? it->second : noRows))
+        {
+            numDifferent++;
+        }
+    }
+
+    // The queries made only on the compared DB, e.g. for a process missing from the reference DB
+    for (const auto& query : results)
+    {
+        if (refResults.find(query.first) == refResults.end())
+        {
+            numQueries++;
+
+            if (!CompareRows(query.first, noRows, query.second))
+            {
+                numDifferent++;
+            }
+        }
+    }
+
+    fprintf(stdout, "%u of %u queries returned different results.\n", numDifferent, numQueries);
+
+    return (0 == numDifferent) ? CXL_DB_COMPARE_SUCCESS : CXL_DB_COMPARE_DIFFERENT;
+}
+
+int main(int argc, char* argv[])
+{
+    if (3 != argc)
+    {
+        fprintf(stderr, "Usage: %s <reference DB> <compared DB>\n", argv[0]);
+        fprintf(stderr, "Compares the results of the profile data queries on two CPU profile DBs (.cxlcpdb).\n");
+        return CXL_DB_COMPARE_ERROR;
+    }
+
+    gtString refDbPath;
+    refDbPath.fromUtf8String(argv[1]);
+
+    gtString dbPath;
+    dbPath.fromUtf8String(argv[2]);
+
+    QueryResults refResults;
+    QueryResults results;
+
+    if (!CollectResults(refDbPath, refResults) || !CollectResults(dbPath, results))
+    {
+        return CXL_DB_COMPARE_ERROR;
+    }
+
+    return CompareResults(refResults, results);
+}
@@ -22,6 +22,7 @@
 // Backend:
 #include <AMDTCpuProfilingControl/inc/CpuProfileControl.h>
 #include <AMDTCpuPerfEventUtils/inc/DcConfig.h>
+#include <AMDTCpuProfilingTranslation/inc/CpuProfileDataTranslation.h>
 
 #if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
     #include <AMDTExecutableFormat/inc/PeFile.h>
@@ -163,6 +164,10 @@ private:
     gtMap<gtUInt64, gtUInt32>   m_pmcEventMsrMap;
     bool                        m_hasPmcEventMsrMap = false;
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+    ReaderHandle*       m_pOnlineHandle = nullptr;  // Translates the samples while profiling
+#endif // AMDT_LINUX_OS
+
     void SetupEnvironment();
     void EnableProfiling();
     void ValidateProfile();
@@ -183,6 +188,12 @@ private:
 
     void WriteRunInfo();
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+    void StartOnlineTranslation();
+    void FinishOnlineTranslation();
+    void CloseOnlineTranslation();
+#endif // AMDT_LINUX_OS
+
     gtString GetTimeStr()
     {
         gtString profTime;
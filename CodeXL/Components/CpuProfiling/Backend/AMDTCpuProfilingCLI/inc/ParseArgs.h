@@ -70,6 +70,7 @@ public:
     bool  IsAttach() const { return m_isAttach; }
     bool  IsProfileChildren() const { return m_profileChildren; }
     bool  IsTerminateApp() const { return m_terminateLaunchApp; }
+    bool  IsOnlineTranslation() const { return m_isOnlineTranslation; }
 
     bool  IsCSSEnabled() const { return m_isCSSEnabled; }
     bool  IsCSSWithDefaultValues() const { return m_cssWithDefaultValues; }
@@ -171,6 +172,7 @@ private:
 
     bool      m_profileChildren = false;
     bool      m_terminateLaunchApp = false;
+    bool      m_isOnlineTranslation = false;
 
     // Report Options
     gtString  m_sectionsToReport;
@@ -189,6 +189,12 @@ int PrintCollectOptions()
     fprintf(stderr, "                           is 0, then wait indefinitely. Used for profile\n");
     fprintf(stderr, "                           control.\n");
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+    fprintf(stderr, "\n    -t                     Translate the samples while profiling. The profile\n");
+    fprintf(stderr, "                           DB (.cxlcpdb) is written next to the raw data file\n");
+    fprintf(stderr, "                           every few seconds and completed at stop.\n");
+#endif
+
     fprintf(stderr, "\n    -w                     Specify the working directory.\n");
     fprintf(stderr, "                           Default will be the path of the launched\n");
     fprintf(stderr, "                           application.\n");
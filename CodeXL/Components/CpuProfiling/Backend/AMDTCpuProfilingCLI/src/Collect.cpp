@@ -144,6 +144,13 @@ HRESULT CpuProfileCollect::StartProfiling(unsigned int* pPidArray, int numPids)
             }
         }
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+        if (isOK() && m_args.IsOnlineTranslation())
+        {
+            StartOnlineTranslation();
+        }
+#endif // AMDT_LINUX_OS
+
         if (isOK())
         {
             m_profStartTime = GetTimeStr();
@@ -161,6 +168,10 @@ HRESULT CpuProfileCollect::StartProfiling(unsigned int* pPidArray, int numPids)
             else
             {
                 reportError(true, L"The driver failed to start profiling. (error code 0x%lx)\n", m_error);
+
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+                CloseOnlineTranslation();
+#endif // AMDT_LINUX_OS
             }
         }
     }
@@ -256,6 +267,11 @@ HRESULT CpuProfileCollect::StopProfiling()
                 // Write TI file
                 WriteRunInfo();
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+                // The translation reads the RI file
+                FinishOnlineTranslation();
+#endif // AMDT_LINUX_OS
+
                 m_profileState = CPUPROF_STATE_READY;
             }
             else
@@ -1812,3 +1828,71 @@ void CpuProfileCollect::WriteRunInfo()
         }
     }
 }
+
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+void CpuProfileCollect::StartOnlineTranslation()
+{
+    osFilePath datafilePath;
+    GetOutputFilePath(datafilePath);
+
+    if (isOK())
+    {
+        datafilePath.setFileExtension(CPUPROFILE_RAWFILE_EXTENSION);
+
+        // The DB is written next to the raw data file, the DB writer sets its extension
+        osFilePath dbFilePath(datafilePath);
+        dbFilePath.setFileExtension(L"ebp");
+
+        m_error = fnOpenOnlineProfile(datafilePath.asString().asCharArray(),
+                                      dbFilePath.asString().asCharArray(),
+                                      &m_pOnlineHandle);
+
+        if (isOK())
+        {
+            // The raw data file is still written, so that it can be translated again
+            m_error = fnSetSampleDataCallback(fnOnlineTranslationSampleData, m_pOnlineHandle, true);
+        }
+
+        if (!isOK())
+        {
+            reportError(true, L"Failed to start translating the samples while profiling. (error code 0x%lx)\n", m_error);
+            CloseOnlineTranslation();
+        }
+    }
+}
+
+void CpuProfileCollect::FinishOnlineTranslation()
+{
+    if (nullptr != m_pOnlineHandle)
+    {
+        osFilePath dbFilePath;
+        GetOutputFilePath(dbFilePath);
+
+        if (isOK())
+        {
+            dbFilePath.setFileExtension(L"ebp");
+
+            HRESULT hr = fnCpuProfileDataTranslate(m_pOnlineHandle, dbFilePath.asString().asCharArray(), nullptr);
+
+            if (S_OK != hr)
+            {
+                // The raw data file can still be translated by the report command
+                reportError(false, L"Could not write the profile data file (" STR_FORMAT L"). (error code 0x%lx)\n",
+                            dbFilePath.asString().asCharArray(), hr);
+            }
+        }
+
+        CloseOnlineTranslation();
+    }
+}
+
+void CpuProfileCollect::CloseOnlineTranslation()
+{
+    if (nullptr != m_pOnlineHandle)
+    {
+        fnSetSampleDataCallback(nullptr, nullptr, true);
+        fnCloseProfile(&m_pOnlineHandle);
+        m_pOnlineHandle = nullptr;
+    }
+}
+#endif // AMDT_LINUX_OS
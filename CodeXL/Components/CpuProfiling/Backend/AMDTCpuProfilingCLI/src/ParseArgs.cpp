@@ -308,7 +308,7 @@ bool ParseArgs::InitializeArgs(int nbrArgs, wchar_t* args[])
     bool printCSSWarning = true;
     gtSet<gtUInt32> coreIdUniqueSet;
 
-    while ((opt = getOption(nbrArgs, args, "C:D:E:F:GIL:NOPR:S:T:V:X:abc:d:e:fg:hi:l:m:o:p:s:vw:")) != -1)
+    while ((opt = getOption(nbrArgs, args, "C:D:E:F:GIL:NOPR:S:T:V:X:abc:d:e:fg:hi:l:m:o:p:s:tvw:")) != -1)
     {
         switch (opt)
         {
@@ -878,6 +878,11 @@ bool ParseArgs::InitializeArgs(int nbrArgs, wchar_t* args[])
 
                 break;
 
+            case 't':
+                // Translate the samples while profiling
+                m_isOnlineTranslation = true;
+                break;
+
             case 'v':
                 m_isPrintVersion = true;
                 break;
@@ -704,6 +704,30 @@ CP_CTRL_API HRESULT fnSetTimerConfiguration(
 
 #if AMDT_BUILD_TARGET == AMDT_LINUX_OS
     CP_CTRL_API HRESULT fnSetThreadProfileConfiguration(bool isCSS);
+
+    /** \typedef PfnSampleDataCallback
+        \brief Receives the raw PERF records while the profile is running.
+        The records in a buffer are complete, except at the end of a buffer which is
+        continued by the next one.
+    */
+    typedef void (*PfnSampleDataCallback)(const void* pData, size_t size, void* pContext);
+
+    /** This function registers a consumer of the sample data, for translating the profile
+        while it is still running. This function should be called before \ref fnStartProfiling.
+
+        \ingroup sampling
+        @param[in] pfnCallback The consumer, NULL unregisters it
+        @param[in] pContext Passed to pfnCallback
+        @param[in] writeRawData If false, the sample data is not written to the profile output file
+        \return The success of registering the consumer
+        \retval S_OK Success
+        \retval E_ACCESSDENIED the profile was not enabled with \ref fnEnableProfiling
+        \retval E_PENDING The profiler is currently profiling
+    */
+    CP_CTRL_API HRESULT fnSetSampleDataCallback(
+        /*in*/ PfnSampleDataCallback pfnCallback,
+        /*in*/ void* pContext,
+        /*in*/ bool writeRawData = true);
 #endif
 
 /** This function will configure the timer-based sampling of the profile.  This
@@ -1199,6 +1199,23 @@ HRESULT fnSetThreadProfileConfiguration(bool isCSS)
 
     return hr;
 } // fnSetThreadProfileConfiguration
+
+
+HRESULT fnSetSampleDataCallback(
+    /*in*/ PfnSampleDataCallback pfnCallback,
+    /*in*/ void* pContext,
+    /*in*/ bool writeRawData)
+{
+    gtUInt32 clientId = helpGetClientId();
+
+    if (INVALID_CLIENT == clientId)
+    {
+        g_invalidClientErr = L"fnEnableProfiling was not called";
+        return E_ACCESSDENIED;
+    }
+
+    return CpuPerfSetSampleDataCallback(pfnCallback, pContext, writeRawData);
+} // fnSetSampleDataCallback
 #endif
 
 
@@ -23,6 +23,7 @@
 #include <errno.h>
 #include <string.h>
 #include <dirent.h>
+#include <sys/uio.h>
 
 // C++ headers
 #include <list>
@@ -31,8 +32,20 @@
 #include "CaPerfConfig.h"
 #include <AMDTOSWrappers/Include/osProcess.h>
 #include <AMDTOSWrappers/Include/osThread.h>
+#include <AMDTOSWrappers/Include/osAtomic.h>
+#include <AMDTOSWrappers/Include/osStopWatch.h>
+#include <AMDTOSWrappers/Include/osTimeInterval.h>
 #include <AMDTOSWrappers/Include/osDebugLog.h>
 
+// Reader threads wake up at least this often to check whether the profile is done
+#define CAPERF_READER_POLL_MSECS       100
+
+// The sample writer sleeps for this long when none of the readers has filled a chunk
+#define CAPERF_WRITER_IDLE_MSECS       1
+
+// Max number of chunks written by one writev()
+#define CAPERF_WRITER_MAX_IOVS         64
+
 static int getCpuInfo(CACpuVec* cpuVec)
 {
     FILE* cpuOnline;
@@ -158,6 +171,26 @@ CaPerfConfig::CaPerfConfig(PerfConfig& cfg, PerfPmuTarget& tgt) : PerfConfig(cfg
     m_pData = new gtByte[m_mmapLen];
 
     m_commRecord = false;
+
+    // The sample-data-buffers are drained by one reader thread per 8 online cpus (up to 8 threads),
+    // unless the number of reader threads is given. 0 drains all of them in the PERF-Sample-Reader-Thread.
+    int nbrCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    m_nbrReaderThreads = (0 < nbrCpus) ? ((nbrCpus + 7) / 8) : 1;
+    m_nbrReaderThreads = (8 < m_nbrReaderThreads) ? 8 : m_nbrReaderThreads;
+
+    gtString envVal;
+    unsigned int nbrReaderThreads = 0;
+
+    if (osGetCurrentProcessEnvVariableValue(L"CODEXL_CPU_PERF_READER_THREADS", envVal) && envVal.toUnsignedIntNumber(nbrReaderThreads))
+    {
+        m_nbrReaderThreads = static_cast<int>(nbrReaderThreads);
+    }
+
+    m_nbrRunningReaderThreads = 0;
+    m_ppReaderThreads = NULL;
+    m_stopReaderThreads = 0;
+
+    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"CaPerfConfig::CaPerfConfig: m_nbrReaderThreads = %d\n", m_nbrReaderThreads);
 }
 
 
@@ -193,6 +226,11 @@ CaPerfConfig::CaPerfConfig(const CaPerfConfig& cfg) : PerfConfig(cfg), m_pmuTgt(
 
     m_useIoctlRedirect = cfg.m_useIoctlRedirect;
     m_commRecord = cfg.m_commRecord;
+
+    m_nbrReaderThreads = cfg.m_nbrReaderThreads;
+    m_nbrRunningReaderThreads = 0;
+    m_ppReaderThreads = NULL;
+    m_stopReaderThreads = 0;
 }
 
 
@@ -232,12 +270,20 @@ CaPerfConfig& CaPerfConfig::operator=(const CaPerfConfig& cfg)
     m_useIoctlRedirect = cfg.m_useIoctlRedirect;
     m_commRecord = cfg.m_commRecord;
 
+    // The reader threads belong to the profile run by this object, they are not copied
+    m_nbrReaderThreads = cfg.m_nbrReaderThreads;
+    m_nbrRunningReaderThreads = 0;
+    m_ppReaderThreads = NULL;
+    m_stopReaderThreads = 0;
+
     return *this;
 }
 
 
 void CaPerfConfig::clear()
 {
+    clearReaderThreads();
+
     m_ctrPerfEventList.clear();
     m_nbrCtrPerfEvents = 0;
 
@@ -432,6 +478,8 @@ HRESULT CaPerfConfig::initialize()
         }
 
         OS_OUTPUT_DEBUG_LOG(L"initializing datafile succeedded...", OS_DEBUG_LOG_EXTENSIVE);
+
+        m_dataWriter.setSampleDataCallback(m_pfnSampleDataCallback, m_pSampleDataContext, m_writeRawSampleData);
     }
 
     return S_OK;
@@ -611,7 +659,7 @@ HRESULT CaPerfConfig::initSamplingEvents()
 
                 // mask used to handle the ring-buffer boundary
                 int mask = (m_mmapPages * m_pageSize) - 1;
-                m_mmap[m_nbrMmaps].set(base, mask, 0);
+                m_mmap[m_nbrMmaps].set(base, mask, 0, cpu);
                 m_nbrMmaps++;
 
                 // add it to pollfd list
@@ -951,6 +999,35 @@ HRESULT CaPerfConfig::printSample(void* data)
 }
 
 
+// Sums up the records dropped by the kernel, reported by PERF_RECORD_LOST records in [from, to) of the ring buffer.
+// The records are u64 aligned and the ring buffer size is a power of 2, hence a header never wraps around.
+static gtUInt64 countLostRecords(const unsigned char* dataBuf, int mask, uint32_t from, uint32_t to)
+{
+    gtUInt64 lostRecords = 0;
+
+    while (from != to)
+    {
+        const struct perf_event_header* hdr = reinterpret_cast<const struct perf_event_header*>(&dataBuf[from & mask]);
+
+        if (0 == hdr->size)
+        {
+            break;
+        }
+
+        if (PERF_RECORD_LOST == hdr->type)
+        {
+            // struct { perf_event_header header; u64 id; u64 lost; }
+            uint32_t lostOffset = from + sizeof(struct perf_event_header) + sizeof(gtUInt64);
+            lostRecords += *reinterpret_cast<const gtUInt64*>(&dataBuf[lostOffset & mask]);
+        }
+
+        from += hdr->size;
+    }
+
+    return lostRecords;
+}
+
+
 HRESULT CaPerfConfig::readMmapBuffers()
 {
     CaPerfMmap* mmapBuffer;
@@ -994,6 +1071,16 @@ HRESULT CaPerfConfig::readMmapBuffers()
 
             unsigned long dataSize = dataHead - prevHead;
 
+            if ((static_cast<unsigned long>(mmapBuffer->m_mask) + 1) < dataSize)
+            {
+                // The kernel overwrote records before they were read. The next record boundary
+                // is only known at the head, so drop the whole range and resync on the head.
+                mmapBuffer->m_lostBytes += dataSize;
+                mmapBuffer->m_prev = dataHead;
+                mmapMetaData->data_tail = dataHead;
+                continue;
+            }
+
             if (((prevHead & mmapBuffer->m_mask) + dataSize)
                 != (dataHead & mmapBuffer->m_mask))
             {
@@ -1030,6 +1117,7 @@ HRESULT CaPerfConfig::readMmapBuffers()
                 OS_OUTPUT_DEBUG_LOG(L"Invalid sample buffer data...", OS_DEBUG_LOG_ERROR);
             }
 
+            mmapBuffer->m_lostRecords += countLostRecords(dataBuf, mmapBuffer->m_mask, mmapBuffer->m_prev, prevHead);
             mmapBuffer->m_prev = prevHead;
 
             // The perf command always sets the data_tail, and we need to do the
@@ -1045,7 +1133,306 @@ HRESULT CaPerfConfig::readMmapBuffers()
     return S_OK;
 }
 
+// Copies the new records in the sample-data-buffer and releases them to the kernel.
+// pBuffer should be able to hold the whole ring buffer. Returns the number of bytes copied.
+size_t CaPerfConfig::copyMmapBuffer(CaPerfMmap& mmapBuffer, gtByte* pBuffer)
+{
+    size_t dataSize = 0;
+
+    if (NULL != mmapBuffer.m_base)
+    {
+        struct perf_event_mmap_page* mmapMetaData = (struct perf_event_mmap_page*)mmapBuffer.m_base;
+        uint32_t dataHead = mmapMetaData->data_head;
+        rmb();
+
+        unsigned char* dataBuf = (unsigned char*)mmapMetaData + m_pageSize;
+        uint32_t prevHead = mmapBuffer.m_prev;
+        dataSize = dataHead - prevHead;
+
+        if ((static_cast<size_t>(mmapBuffer.m_mask) + 1) < dataSize)
+        {
+            // The kernel overwrote records before they were read. The next record boundary
+            // is only known at the head, so drop the whole range and resync on the head.
+            mmapBuffer.m_lostBytes += dataSize;
+            mmapBuffer.m_prev = dataHead;
+            mmapMetaData->data_tail = dataHead;
+            dataSize = 0;
+        }
+        else if (0 < dataSize)
+        {
+            // Copy the records as a whole, even if they wrap around the end of the ring buffer
+            size_t startOffset = prevHead & mmapBuffer.m_mask;
+            size_t firstSize = mmapBuffer.m_mask + 1 - startOffset;
+
+            if (dataSize <= firstSize)
+            {
+                memcpy(pBuffer, &dataBuf[startOffset], dataSize);
+            }
+            else
+            {
+                memcpy(pBuffer, &dataBuf[startOffset], firstSize);
+                memcpy(pBuffer + firstSize, dataBuf, dataSize - firstSize);
+            }
+
+            mmapBuffer.m_lostRecords += countLostRecords(dataBuf, mmapBuffer.m_mask, prevHead, dataHead);
+            mmapBuffer.m_prev = dataHead;
+
+            // Let the kernel reuse the space as soon as the records are copied
+            mmapMetaData->data_tail = dataHead;
+        }
+    }
+
+    return dataSize;
+}
+
+
+void CaPerfConfig::readerThreadEntry(SampleReaderThread& thread)
+{
+    for (;;)
+    {
+        // Check for the profile completion before draining, so that all the mmaps are drained
+        // once more after the sampling events got disabled.
+        bool isLastPass = (0 != AtomicAdd(m_stopReaderThreads, 0));
+
+        for (size_t i = 0; i < thread.m_mmapIndices.size(); ++i)
+        {
+            // Wait for the writer, if all the chunks are in flight
+            while (CAPERF_READER_THREAD_CHUNKS <= static_cast<gtUInt32>(thread.m_filledChunks - AtomicAdd(thread.m_writtenChunks, 0)))
+            {
+                thread.m_nbrStalls++;
+                osSleep(CAPERF_WRITER_IDLE_MSECS);
+            }
+
+            gtUInt32 chunkIndex = static_cast<gtUInt32>(thread.m_filledChunks);
+            size_t dataSize = copyMmapBuffer(m_mmap[thread.m_mmapIndices[i]], thread.getChunk(chunkIndex));
+
+            if (0 < dataSize)
+            {
+                thread.m_chunkDataSize[chunkIndex % CAPERF_READER_THREAD_CHUNKS] = dataSize;
+
+                // Publish the chunk to the writer
+                AtomicAdd(thread.m_filledChunks, 1);
+            }
+        }
+
+        if (isLastPass)
+        {
+            break;
+        }
+
+        int ret = poll(thread.m_pPollFds, thread.m_nbrPollFds, CAPERF_READER_POLL_MSECS);
+
+        if (0 < ret)
+        {
+            // Stop polling the fds of the exited targets, their buffers are still drained
+            for (int i = 0; i < thread.m_nbrPollFds; ++i)
+            {
+                if (0 != (thread.m_pPollFds[i].revents & (POLLHUP | POLLERR | POLLNVAL)))
+                {
+                    thread.m_pPollFds[i].fd = -1;
+                }
+            }
+        }
+    }
+}
+
+
+// Writes all the chunks filled by the reader, returns the number of bytes written
+size_t CaPerfConfig::writeReaderChunks(SampleReaderThread& thread)
+{
+    size_t bytesWritten = 0;
+    gtUInt32 filledChunks = static_cast<gtUInt32>(AtomicAdd(thread.m_filledChunks, 0));
+    gtUInt32 writtenChunks = static_cast<gtUInt32>(thread.m_writtenChunks);
+
+    while (writtenChunks != filledChunks)
+    {
+        struct iovec iov[CAPERF_WRITER_MAX_IOVS];
+        int nbrIovs = 0;
+
+        for (; (writtenChunks + nbrIovs != filledChunks) && (CAPERF_WRITER_MAX_IOVS > nbrIovs); ++nbrIovs)
+        {
+            gtUInt32 chunkIndex = writtenChunks + nbrIovs;
+            iov[nbrIovs].iov_base = thread.getChunk(chunkIndex);
+            iov[nbrIovs].iov_len = thread.m_chunkDataSize[chunkIndex % CAPERF_READER_THREAD_CHUNKS];
+            bytesWritten += iov[nbrIovs].iov_len;
+        }
+
+        m_dataWriter.writePMUSampleData(iov, nbrIovs);
+
+        // Hand the chunks back to the reader
+        writtenChunks += nbrIovs;
+        AtomicAdd(thread.m_writtenChunks, nbrIovs);
+    }
+
+    return bytesWritten;
+}
+
+
+// The mmaps are distributed among the reader threads, which copy the sample-data-buffers into chunks.
+// This thread (the PERF-Sample-Reader-Thread) writes the chunks to the output file, batching them.
+int CaPerfConfig::readSampleDataMT()
+{
+    int nbrReaderThreads = (m_nbrReaderThreads < m_nbrMmaps) ? m_nbrReaderThreads : m_nbrMmaps;
+
+    m_stopReaderThreads = 0;
+    m_ppReaderThreads = new SampleReaderThread*[nbrReaderThreads];
+    m_nbrRunningReaderThreads = nbrReaderThreads;
+
+    for (int i = 0; i < nbrReaderThreads; ++i)
+    {
+        m_ppReaderThreads[i] = new SampleReaderThread(*this, i, m_mmapPages * m_pageSize, m_pollFds);
+    }
+
+    // The poll fd of an mmap is at the same index
+    for (int i = 0; i < m_nbrMmaps; ++i)
+    {
+        SampleReaderThread& thread = *m_ppReaderThreads[i % nbrReaderThreads];
+        thread.m_mmapIndices.push_back(i);
+
+        if (i < m_pollFds)
+        {
+            thread.m_pPollFds[thread.m_nbrPollFds++] = m_samplingPollFds[i];
+        }
+    }
+
+    for (int i = 0; i < nbrReaderThreads; ++i)
+    {
+        m_ppReaderThreads[i]->execute();
+    }
+
+    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"Reading %d sample-data-buffers with %d reader threads", m_nbrMmaps, nbrReaderThreads);
+
+    osStopWatch stopWatch;
+    stopWatch.start();
+    gtUInt64 totalBytesWritten = 0;
+
+    for (;;)
+    {
+        // Sample the readers' state before writing, so that their last chunks are written too
+        bool readersAlive = false;
+
+        for (int i = 0; i < nbrReaderThreads; ++i)
+        {
+            readersAlive = readersAlive || m_ppReaderThreads[i]->isAlive();
+        }
+
+        size_t bytesWritten = 0;
+
+        for (int i = 0; i < nbrReaderThreads; ++i)
+        {
+            bytesWritten += writeReaderChunks(*m_ppReaderThreads[i]);
+        }
+
+        totalBytesWritten += bytesWritten;
+
+        if (!readersAlive)
+        {
+            break;
+        }
+
+        if (m_profileCompleted && (0 == m_stopReaderThreads))
+        {
+            AtomicSwap(m_stopReaderThreads, 1);
+        }
+
+        if (0 == bytesWritten)
+        {
+            osSleep(CAPERF_WRITER_IDLE_MSECS);
+        }
+    }
+
+    double elapsedTime = 0.0;
+    stopWatch.getTimeInterval(elapsedTime);
+
+    gtUInt64 nbrStalls = 0;
+
+    for (int i = 0; i < nbrReaderThreads; ++i)
+    {
+        nbrStalls += m_ppReaderThreads[i]->m_nbrStalls;
+    }
+
+    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"Wrote %llu bytes of sample data in %f seconds, the readers waited %llu times for the writer",
+                               totalBytesWritten, elapsedTime, nbrStalls);
+
+    return 0;
+}
+
+
+void CaPerfConfig::clearReaderThreads()
+{
+    if (NULL != m_ppReaderThreads)
+    {
+        AtomicSwap(m_stopReaderThreads, 1);
+
+        osTimeInterval timeout;
+        timeout.setAsMilliSeconds(CAPERF_READER_POLL_MSECS);
+
+        for (int i = 0; i < m_nbrRunningReaderThreads; ++i)
+        {
+            while (m_ppReaderThreads[i]->isAlive())
+            {
+                m_ppReaderThreads[i]->waitForThreadEnd(timeout);
+            }
+
+            delete m_ppReaderThreads[i];
+        }
+
+        delete [] m_ppReaderThreads;
+        m_ppReaderThreads = NULL;
+        m_nbrRunningReaderThreads = 0;
+    }
+}
+
+
+void CaPerfConfig::getLostRecords(gtMap<int, gtUInt64>& lostRecords) const
+{
+    lostRecords.clear();
+
+    for (int i = 0; i < m_nbrMmaps; i++)
+    {
+        lostRecords[m_mmap[i].m_cpu] += m_mmap[i].m_lostRecords;
+    }
+}
+
+
 int CaPerfConfig::readSampleData()
+{
+    int ret = -1;
+
+    if ((0 < m_nbrReaderThreads) && (0 < m_nbrMmaps))
+    {
+        ret = readSampleDataMT();
+    }
+    else
+    {
+        ret = readSampleDataST();
+    }
+
+    gtMap<int, gtUInt64> lostRecords;
+    getLostRecords(lostRecords);
+
+    for (gtMap<int, gtUInt64>::const_iterator it = lostRecords.begin(), itEnd = lostRecords.end(); it != itEnd; ++it)
+    {
+        if (0 != it->second)
+        {
+            OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"cpu(%d): %llu records lost", it->first, it->second);
+        }
+    }
+
+    for (int i = 0; i < m_nbrMmaps; i++)
+    {
+        if (0 != m_mmap[i].m_lostBytes)
+        {
+            OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"cpu(%d): %llu bytes of sample data overwritten before they were read",
+                                       m_mmap[i].m_cpu, m_mmap[i].m_lostBytes);
+        }
+    }
+
+    return ret;
+}
+
+
+int CaPerfConfig::readSampleDataST()
 {
     int ret = -1;
 
@@ -1093,6 +1480,35 @@ int CaPerfConfig::readSampleData()
 }
 
 
+CaPerfConfig::SampleReaderThread::SampleReaderThread(CaPerfConfig& cfg, int id, size_t chunkSize, int maxPollFds) :
+    osThread(gtString(L"PERF Sample Reader [").appendUnsignedIntNumber(id).append(L']')),
+    m_config(cfg),
+    m_id(id),
+    m_pPollFds(new struct pollfd[maxPollFds]),
+    m_nbrPollFds(0),
+    m_pChunks(new gtByte[CAPERF_READER_THREAD_CHUNKS * chunkSize]),
+    m_chunkSize(chunkSize),
+    m_filledChunks(0),
+    m_writtenChunks(0),
+    m_nbrStalls(0)
+{
+}
+
+
+CaPerfConfig::SampleReaderThread::~SampleReaderThread()
+{
+    delete [] m_pPollFds;
+    delete [] m_pChunks;
+}
+
+
+int CaPerfConfig::SampleReaderThread::entryPoint()
+{
+    m_config.readerThreadEntry(*this);
+    return 0;
+}
+
+
 HRESULT CaPerfConfig::readCounters(PerfEventCountDataList** countData)
 {
     HRESULT ret;
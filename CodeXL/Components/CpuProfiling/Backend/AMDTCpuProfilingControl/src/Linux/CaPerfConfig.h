@@ -44,11 +44,17 @@ extern "C" {
 #include "PerfConfig.h"
 #include "PerfPmuTarget.h"
 #include <AMDTCpuProfilingRawData/inc/Linux/CaPerfDataWriter.h>
+#include <AMDTBaseTools/Include/gtVector.h>
+#include <AMDTOSWrappers/Include/osThread.h>
 
 // Baskar:
 // If this is defined, the PERF-Sample-Reader-Thread will use SIGUSR1.
 #define CAPERF_USES_SIGUSR1    1
 
+// Number of sample-data chunks each reader thread can hand over to the sample writer,
+// before it has to wait for the writer to catch up
+#define CAPERF_READER_THREAD_CHUNKS    64
+
 typedef gtMap<int, int> CpuFdMap;
 
 struct CaPerfMmap
@@ -56,12 +62,18 @@ struct CaPerfMmap
     void*     m_base;
     int       m_mask;   // TODO: Use proper name
     uint32_t  m_prev;
+    int       m_cpu;
+    gtUInt64  m_lostRecords; // records dropped by the kernel (PERF_RECORD_LOST)
+    gtUInt64  m_lostBytes;   // bytes overwritten by the kernel before they were read
 
-    void set(void* base, int mask, uint32_t prev)
+    void set(void* base, int mask, uint32_t prev, int cpu = -1)
     {
         m_base = base;
         m_mask = mask;
         m_prev = prev;
+        m_cpu = cpu;
+        m_lostRecords = 0;
+        m_lostBytes = 0;
     }
 
     void setBase(void* base)
@@ -113,6 +125,9 @@ public:
     const CACpuVec& getCpuVec() const { return m_cpuVec; }
     const CAThreadVec& getThreadVec() const { return m_threadVec; }
 
+    // Number of records dropped by the kernel, per cpu
+    void getLostRecords(gtMap<int, gtUInt64>& lostRecords) const;
+
     void clear();
 
     // Debug APIs
@@ -121,9 +136,53 @@ public:
     HRESULT printCounterValues();
 
 private:
+    // Drains the sample-data-buffers of a subset of the mmaps into chunks, which are
+    // written to the output file by the PERF-Sample-Reader-Thread.
+    class SampleReaderThread : public osThread
+    {
+    public:
+        SampleReaderThread(CaPerfConfig& cfg, int id, size_t chunkSize, int maxPollFds);
+        virtual ~SampleReaderThread();
+
+        SampleReaderThread& operator=(const SampleReaderThread&) = delete;
+
+    protected:
+        virtual int entryPoint();
+
+    private:
+        gtByte* getChunk(gtUInt32 index) { return m_pChunks + ((index % CAPERF_READER_THREAD_CHUNKS) * m_chunkSize); }
+
+        CaPerfConfig& m_config;
+        int m_id;
+
+        // mmaps owned by this reader and their fds
+        gtVector<int> m_mmapIndices;
+        struct pollfd* m_pPollFds;
+        int m_nbrPollFds;
+
+        // Single producer (this reader) / single consumer (the writer) ring of chunks
+        gtByte* m_pChunks;
+        size_t m_chunkSize;
+        size_t m_chunkDataSize[CAPERF_READER_THREAD_CHUNKS];
+        volatile gtInt32 m_filledChunks;
+        volatile gtInt32 m_writtenChunks;
+
+        // Number of times the reader had to wait for a free chunk
+        gtUInt64 m_nbrStalls;
+
+        friend class CaPerfConfig;
+    };
+
     HRESULT initSamplingEvents();
     void _checkPerfEventParanoid();
 
+    size_t copyMmapBuffer(CaPerfMmap& mmapBuffer, gtByte* pBuffer);
+    int readSampleDataST();
+    int readSampleDataMT();
+    void readerThreadEntry(SampleReaderThread& thread);
+    size_t writeReaderChunks(SampleReaderThread& thread);
+    void clearReaderThreads();
+
 protected:
     // PMU Target
     PerfPmuTarget&        m_pmuTgt;
@@ -157,6 +216,13 @@ protected:
     CAThreadVec         m_threadVec;
 
     bool                m_profileCompleted;
+
+    // Sample reader threads; 0 reads all the mmaps in the PERF-Sample-Reader-Thread
+    int                 m_nbrReaderThreads;
+    // The reader threads of the running profile, the size of m_ppReaderThreads
+    int                 m_nbrRunningReaderThreads;
+    SampleReaderThread** m_ppReaderThreads;
+    volatile gtInt32    m_stopReaderThreads;
     bool                m_useIoctlRedirect;
     bool                m_commRecord;
 
@@ -293,6 +293,8 @@ HRESULT CaPerfProfiler::stopProfile()
         stopSampleReaderThread();
     }
 
+    m_pPerfCfg->getLostRecords(m_lostRecords);
+
     // Baskar: we need to close the file-descriptor's opened for the sampling-events.
     // PMCs won't be released by PERF, till we close these fd's.
     //
@@ -70,6 +70,9 @@ public:
 
     int readSampleBuffers();
 
+    // Number of records dropped by the kernel in the last profile, per cpu
+    const gtMap<int, gtUInt64>& getLostRecords() const { return m_lostRecords; }
+
     // Clear the internal data structures
     void clear();
 
@@ -86,6 +89,8 @@ private:
     //   - list of sampling events
     //   - target to be profiled - pids/cpus
     CaPerfConfig*        m_pPerfCfg;
+
+    gtMap<int, gtUInt64> m_lostRecords;
 };
 
 #endif // _CAPERFPROFILER_H_
@@ -2178,6 +2178,38 @@ HRESULT CpuPerfSetThreadProfileConfiguration(bool isCSS)
 } // CpuPerfSetThreadProfileConfiguration
 
 
+HRESULT CpuPerfSetSampleDataCallback(
+    /*in*/ PfnSampleDataCallback pfnCallback,
+    /*in*/ void* pContext,
+    /*in*/ bool writeRawData)
+{
+    gtUInt32 clientId = helpGetClientId();
+
+    if ((NULL == g_pProfileConfig)
+        || (INVALID_CLIENT == clientId))
+    {
+        g_invalidClientErr = L"fnEnableProfiling has not been called";
+        return E_ACCESSDENIED;
+    }
+
+    if (isProfilingNow(clientId))
+    {
+        g_errorString[clientId] = L"Profiling is in progress";
+        return E_PENDING;
+    }
+
+    if (!g_usePERF)
+    {
+        // Oprofile
+        return E_NOTIMPL;
+    }
+
+    g_pProfileConfig->setSampleDataCallback(pfnCallback, pContext, writeRawData);
+
+    return S_OK;
+} // CpuPerfSetSampleDataCallback
+
+
 HRESULT CpuPerfSetEventConfiguration(
     /*in*/ const EventConfiguration* pPerformanceEvents,
     /*in*/ unsigned int count,
@@ -176,6 +176,11 @@ HRESULT CpuPerfSetTimerConfiguration(
 
 HRESULT CpuPerfSetThreadProfileConfiguration(bool isCSS);
 
+HRESULT CpuPerfSetSampleDataCallback(
+    /*in*/ PfnSampleDataCallback pfnCallback,
+    /*in*/ void* pContext,
+    /*in*/ bool writeRawData);
+
 HRESULT CpuPerfSetEventConfiguration(
     /*in*/ const EventConfiguration* pPerformanceEvents,
     /*in*/ unsigned int count,
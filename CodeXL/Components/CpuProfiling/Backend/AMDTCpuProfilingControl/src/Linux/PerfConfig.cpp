@@ -65,6 +65,10 @@ PerfConfig::PerfConfig()
     m_outputFile.clear();
     m_overwriteOutFile = false;
 
+    m_pfnSampleDataCallback = NULL;
+    m_pSampleDataContext = NULL;
+    m_writeRawSampleData = true;
+
 #ifdef ENABLE_FAKETIMER
     m_timerHackIndex = -2;
     m_timerHackInfo.numCpu        = 0;
@@ -146,6 +150,10 @@ void PerfConfig::copyCfg(const PerfConfig& cfg)
     m_outputFile        = cfg.m_outputFile;
     m_overwriteOutFile  = cfg.m_overwriteOutFile;
 
+    m_pfnSampleDataCallback = cfg.m_pfnSampleDataCallback;
+    m_pSampleDataContext    = cfg.m_pSampleDataContext;
+    m_writeRawSampleData    = cfg.m_writeRawSampleData;
+
 #ifdef ENABLE_FAKETIMER
     m_timerHackIndex = cfg.m_timerHackIndex;
     m_timerHackInfo = cfg.m_timerHackInfo;
@@ -295,6 +303,10 @@ void PerfConfig::clear()
     m_outputFile.clear();
     m_overwriteOutFile = false;
 
+    m_pfnSampleDataCallback = NULL;
+    m_pSampleDataContext = NULL;
+    m_writeRawSampleData = true;
+
 #ifdef ENABLE_FAKETIMER
     // Baskar:
     // BUG365178: CodeXL ended data-translation prematurely and missing samples.
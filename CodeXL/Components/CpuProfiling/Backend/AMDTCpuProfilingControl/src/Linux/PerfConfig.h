@@ -123,6 +123,15 @@ public:
     const std::string& getErrStr() const { return m_errStr; }
     bool isOverwrite() const { return m_overwriteOutFile; }
 
+    // The sample data is handed over to pfnCallback while profiling; the raw data file
+    // holds only the headers, unless writeRawData is set
+    void setSampleDataCallback(caperf_sample_data_callback_t pfnCallback, void* pContext, bool writeRawData = true)
+    {
+        m_pfnSampleDataCallback = pfnCallback;
+        m_pSampleDataContext = pContext;
+        m_writeRawSampleData = writeRawData;
+    }
+
     void print();
     void clear();
 
@@ -189,6 +198,11 @@ protected:
     std::string           m_outputFile;
     std::string           m_errStr;
 
+    // Online consumer of the sample data
+    caperf_sample_data_callback_t m_pfnSampleDataCallback;
+    void*                 m_pSampleDataContext;
+    bool                  m_writeRawSampleData;
+
 #ifdef ENABLE_FAKETIMER
     //work around for a bug on kernels < 3.0
     int                 m_timerHackIndex;
@@ -96,6 +96,7 @@ struct ViewConfigInfo
 #define GET_MODULEID_FROM_FUNCTIONID(id_) (((id_) & 0xFFFF0000) >> 16)
 
 #define CXL_MAX_DISASM_INSTS            2048
+#define CXL_DISASM_BATCH_INSTS          256
 #define CXL_MAX_UNKNOWN_FUNC_SIZE       4096
 
 #if AMDT_BUILD_TARGET == AMDT_LINUX_OS
@@ -2927,6 +2928,14 @@ public:
                     }
                 }
 
+                // Decode the code in batches with a single disassembler, the text is generated per instruction
+                LibDisassembler dasm;
+                dasm.SetLongMode(isLongMode);
+
+                BatchInstInfoType batchInfo;
+                const gtUByte* pBatchCode = nullptr;
+                unsigned int batchIndex = 0;
+
                 while (bytesToRead > 0)
                 {
                     AMDTSourceAndDisasmInfo disasmInfo;
@@ -2972,8 +2981,21 @@ public:
 
                         disasmInfo.m_offset = codeOffset + sectionStartRva;
 
+                        if (batchInfo.Offsets.size() <= batchIndex)
+                        {
+                            AMDTUInt32 sectionBytes = sectionEndRva - startRVAddr;
+                            pBatchCode = pCurrentCode;
+                            batchIndex = 0;
+                            dasm.BatchDecode((const BYTE*)pBatchCode, std::min(bytesToRead, sectionBytes), sectionBytes, CXL_DISASM_BATCH_INSTS, &batchInfo);
+                        }
+
                         // Get disassembly for the current pCode from the disassembler
-                        ret = GetDisassemblyString((BYTE*)(pCurrentCode), isLongMode, disasmInfo, NumBytesUsed);
+                        ret = GetDisassemblyString(dasm, (const BYTE*)pBatchCode, batchInfo, batchIndex++, disasmInfo, NumBytesUsed);
+                    }
+                    else
+                    {
+                        // The next batch starts after the skipped byte
+                        batchIndex = static_cast<unsigned int>(batchInfo.Offsets.size());
                     }
 
                     if (ret)
@@ -3448,30 +3470,8 @@ public:
             if (S_OK == hr)
             {
                 bytesUsed = instInfo.NumBytesUsed;
-                gtString& disasmStr = disasmInfo.m_disasmStr;
-                disasmStr.fromASCIIString(dasmArray);
-
-                if (instInfo.bIsPCRelative && instInfo.bHasDispData)
-                {
-                    disasmStr.appendFormattedString(L"(0x%lx)", disasmInfo.m_offset + instInfo.NumBytesUsed + instInfo.DispDataValue);
-                }
-
-                // Get codebytes
-                char codeBytes[16];
-                memcpy(codeBytes, pCurrentCode, instInfo.NumBytesUsed);
-
-                for (int count = 0; count < instInfo.NumBytesUsed; count++)
-                {
-                    gtUByte byteCode = codeBytes[count];
-                    gtUByte btHigh = (byteCode >> 4);
-                    gtUByte btLow = (byteCode & 0xF);
-
-                    disasmInfo.m_codeByteStr.append((btHigh <= 9) ? ('0' + btHigh) : ('A' + btHigh - 0xA));
-                    disasmInfo.m_codeByteStr.append((btLow <= 9) ? ('0' + btLow) : ('A' + btLow - 0xA));
-                    disasmInfo.m_codeByteStr << L" ";
-                }
-
-                disasmInfo.m_size = static_cast<gtUInt16>(bytesUsed);
+                SetDisassemblyInfo(pCurrentCode, dasmArray, instInfo.NumBytesUsed,
+                                   (instInfo.bIsPCRelative && instInfo.bHasDispData), instInfo.DispDataValue, disasmInfo);
                 ret = true;
             }
             else
@@ -3484,6 +3484,58 @@ public:
         return ret;
     }
 
+    // Same as above, for the instruction at index of a batch decoded from pCode
+    bool GetDisassemblyString(LibDisassembler& dasm, const BYTE* pCode, const BatchInstInfoType& batchInfo, unsigned int index,
+                              AMDTSourceAndDisasmInfo& disasmInfo, AMDTUInt32& bytesUsed)
+    {
+        bool ret = false;
+        char dasmArray[256] = { 0 };
+        unsigned int strlength = 255;
+
+        if (S_OK == dasm.BatchDisassemble(pCode, &batchInfo, index, &strlength, (BYTE*)dasmArray))
+        {
+            BYTE flags = batchInfo.Flags[index];
+            bytesUsed = batchInfo.Lengths[index];
+            SetDisassemblyInfo(pCode + batchInfo.Offsets[index], dasmArray, batchInfo.Lengths[index],
+                               (0 != (flags & BATCH_INST_PC_RELATIVE) && 0 != (flags & BATCH_INST_DISP_DATA)),
+                               batchInfo.DispDataValues[index], disasmInfo);
+            ret = true;
+        }
+        else
+        {
+            disasmInfo.m_size = 1;
+            disasmInfo.m_disasmStr.fromASCIIString("BAD DASM");
+        }
+
+        return ret;
+    }
+
+    void SetDisassemblyInfo(const BYTE* pCurrentCode, const char* pDasm, BYTE numBytesUsed, bool hasPcRelativeDisp, unsigned int dispDataValue,
+                            AMDTSourceAndDisasmInfo& disasmInfo)
+    {
+        gtString& disasmStr = disasmInfo.m_disasmStr;
+        disasmStr.fromASCIIString(pDasm);
+
+        if (hasPcRelativeDisp)
+        {
+            disasmStr.appendFormattedString(L"(0x%lx)", disasmInfo.m_offset + numBytesUsed + dispDataValue);
+        }
+
+        // Get codebytes
+        for (int count = 0; count < numBytesUsed; count++)
+        {
+            gtUByte byteCode = pCurrentCode[count];
+            gtUByte btHigh = (byteCode >> 4);
+            gtUByte btLow = (byteCode & 0xF);
+
+            disasmInfo.m_codeByteStr.append((btHigh <= 9) ? ('0' + btHigh) : ('A' + btHigh - 0xA));
+            disasmInfo.m_codeByteStr.append((btLow <= 9) ? ('0' + btLow) : ('A' + btLow - 0xA));
+            disasmInfo.m_codeByteStr << L" ";
+        }
+
+        disasmInfo.m_size = static_cast<gtUInt16>(numBytesUsed);
+    }
+
     bool GetCallGraphProcesses(gtVector<AMDTProcessId>& cssProcesses)
     {
         bool ret = true;
@@ -16,6 +16,7 @@
 
 // System Headers
 #include <linux/perf_event.h>
+#include <sys/uio.h>
 
 // Project Headers
 #include "CaPerfHeader.h"
@@ -68,6 +69,12 @@ public:
 
     HRESULT writePMUSampleData(void* data, ssize_t size);
 
+    // Gathers a batch of sample data buffers with a single system call
+    HRESULT writePMUSampleData(const struct iovec* pIov, int iovCount);
+
+    // Hands the sample data over to pfnCallback too; it is written to the file only if writeToFile is set
+    void setSampleDataCallback(caperf_sample_data_callback_t pfnCallback, void* pContext, bool writeToFile = true);
+
     HRESULT writeSWPProcessMmaps(gtUInt16 sampleRecSize);
 
     HRESULT writePidMmaps(pid_t pid, pid_t tgid, gtUInt16 sampleRecSize);
@@ -146,6 +153,10 @@ private: //Member Variables
     ssize_t m_dataStartOffset;
     ssize_t m_dataSize;
 
+    caperf_sample_data_callback_t m_pfnSampleDataCallback;
+    void* m_pSampleDataContext;
+    bool m_writeSampleData;
+
     ca_event_t* m_pForkEvent;
     ca_event_t* m_pCommEvent;
     ca_event_t* m_pMmapEvent;
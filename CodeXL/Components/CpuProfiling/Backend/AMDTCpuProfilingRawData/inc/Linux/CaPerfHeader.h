@@ -344,6 +344,9 @@ typedef union ca_event_union
     struct ca_fork_event fork;
 } ca_event_t;
 
+// Receives the PERF records of the sample data section, while they are being collected
+typedef void (*caperf_sample_data_callback_t)(const void* pData, size_t size, void* pContext);
+
 #define MAX_EVENT_NAME 64
 struct ca_perf_trace_event_type
 {
@@ -28,6 +28,15 @@ typedef std::map<gtUInt64, gtUInt64> PerfEvtIdToEvtTypeMap;
 
 struct perf_trace_event_type;
 
+// Size of the file window mapped by the memory-mapped record iterator.
+// 64-bit hosts map the whole file at once; 32-bit address spaces cannot
+// hold multi-GB files, so the mapping slides over the file in windows.
+#if defined(__LP64__) || defined(_LP64)
+    #define PERF_DATA_MMAP_WINDOW_SIZE  0ULL
+#else
+    #define PERF_DATA_MMAP_WINDOW_SIZE  (256ULL * 1024ULL * 1024ULL)
+#endif
+
 //
 // Class PerfDataReader
 //
@@ -62,16 +71,34 @@ public:
 
     gtUInt64 getAttrSampleType() { return m_sampleType; }
 
-    virtual HRESULT getFirstRecord(struct perf_event_header* pHdr, const void** ppBuf, gtUInt32* pOffset = NULL);
+    virtual HRESULT getFirstRecord(struct perf_event_header* pHdr, const void** ppBuf, gtUInt64* pOffset = NULL);
 
-    virtual HRESULT getRecordFromOffset(gtUInt32 offset,
+    virtual HRESULT getRecordFromOffset(gtUInt64 offset,
                                         struct perf_event_header* pHdr,
                                         const void** ppBuf,
-                                        gtUInt32* pOffset = NULL);
+                                        gtUInt64* pOffset = NULL);
+
+    virtual HRESULT getNextRecord(struct perf_event_header* pHdr, const void** ppBuf, gtUInt64* pOffset = NULL);
+
+    //////////////////////////
+    // Record Iterator Interfaces
+    //
+    // These return a pointer to the complete record (header followed by the payload).
+    // In mmap mode the pointer refers directly into the mapped data file, otherwise
+    // into an internal buffer. Either way it stays valid only until the next call.
+
+    virtual HRESULT getFirstRecord(const struct perf_event_header** ppRec, gtUInt64* pOffset = NULL);
+
+    virtual HRESULT getRecordFromOffset(gtUInt64 offset, const struct perf_event_header** ppRec, gtUInt64* pOffset = NULL);
 
-    virtual HRESULT getNextRecord(struct perf_event_header* pHdr, const void** ppBuf, gtUInt32* pOffset = NULL);
+    virtual HRESULT getNextRecord(const struct perf_event_header** ppRec, gtUInt64* pOffset = NULL);
 
-    int getCurrentFileOffset() const { return m_offset; }
+    // Select between the memory-mapped (default) and the read() based record iterator
+    void setMmapMode(bool useMmap);
+
+    bool isMmapMode() const { return m_useMmap; }
+
+    gtUInt64 getCurrentFileOffset() const { return m_offset; }
 
     HRESULT getEventAndCpuFromSampleId(gtUInt64 evId,
                                        int* pCpu,
@@ -88,9 +115,9 @@ public:
 
     virtual void dumpData();
 
-    unsigned int getDataSectionSize() { return m_dataSize; }
+    gtUInt64 getDataSectionSize() { return m_dataSize; }
 
-    unsigned int getCurrentDataSize() const { return (m_offset - m_dataStartOffset); }
+    gtUInt64 getCurrentDataSize() const { return (m_offset - m_dataStartOffset); }
 
     bool isEndOfFile() const { return m_isEof; }
 
@@ -112,22 +139,38 @@ private:
 
     virtual HRESULT dump_PERF_RECORD(struct perf_event_header* pHdr, void* ptr, int recNum);
 
+    HRESULT _mapRecord(const struct perf_event_header** ppRec);
+
+    HRESULT _readRecord(const struct perf_event_header** ppRec);
+
+    bool _mapWindow(gtUInt64 offset, gtUInt64 size);
+
 
 protected:
     int _processPerfAttributesSection();
     int _processPerfFileSection();
     int _processPerfEventTypesSection();
 
+    void _unmapWindow();
+
     int                   m_fd;
-    int                   m_offset;
+    gtUInt64              m_offset;
     unsigned int          m_numCpus;
     unsigned int          m_numAttrs;
     unsigned int          m_numEventTypes;
     gtUInt64              m_sampleType;
     int                   m_curBufSz;
     void*                 m_pBuf;
-    ssize_t               m_dataStartOffset;
-    ssize_t               m_dataSize;
+    gtUInt64              m_dataStartOffset;
+    gtUInt64              m_dataSize;
+
+    // Memory-mapped record iterator
+    bool                  m_useMmap;
+    gtUInt64              m_fileSize;
+    gtUByte*              m_pMapBase;
+    gtUInt64              m_mapOffset;
+    gtUInt64              m_mapSize;
+    gtUInt64              m_recOffset;
 
     // Dynamic PMU types used by PERF. We need get these type
     // id from /sys/devices/<profile-type>/type
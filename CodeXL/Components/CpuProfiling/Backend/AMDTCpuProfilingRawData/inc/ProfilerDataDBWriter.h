@@ -18,6 +18,7 @@
 #include <AMDTOSWrappers/Include/osSynchronizedQueue.h>
 #include <AMDTOSWrappers/Include/osThread.h>
 #include <AMDTOSWrappers/Include/osTimeInterval.h>
+#include <AMDTBaseTools/Include/gtHashMap.h>
 #include <AMDTDbAdapter/inc/AMDTProfileDbAdapter.h>
 #include <AMDTCpuCallstackSampling/inc/CallGraph.h>
 #include <AMDTCpuPerfEventUtils/inc/EventsFile.h>
@@ -44,6 +45,7 @@ enum TranslatedDataType
     TRANSLATED_DATA_TYPE_CSS_LEAF_INFO,       // = 13
     TRANSLATED_DATA_TYPE_JITINSTANCE_INFO,    // = 14
     TRANSLATED_DATA_TYPE_JITCODEBLOB_INFO,    // = 15
+    TRANSLATED_DATA_TYPE_FLUSH,               // = 16, no data: writes the aggregated samples and commits the DB
 };
 
 struct TranslatedDataContainer
@@ -60,6 +62,44 @@ struct TranslatedDataContainer
         m_type(type), m_data(data) {}
 };
 
+// Unique key of a row of the SampleContext table
+struct SampleContextKey
+{
+    gtUInt64 m_processThreadId = 0;
+    gtUInt64 m_coreSamplingConfigId = 0;
+    gtUInt64 m_offset = 0;
+    gtUInt32 m_moduleInstanceId = 0;
+    gtUInt32 m_functionId = 0;
+
+    SampleContextKey(gtUInt64 processThreadId, gtUInt32 moduleInstanceId, gtUInt64 coreSamplingConfigId, gtUInt32 functionId, gtUInt64 offset) :
+        m_processThreadId(processThreadId), m_coreSamplingConfigId(coreSamplingConfigId), m_offset(offset), m_moduleInstanceId(moduleInstanceId), m_functionId(functionId) {}
+
+    bool operator==(const SampleContextKey& other) const
+    {
+        return (m_processThreadId == other.m_processThreadId) &&
+               (m_coreSamplingConfigId == other.m_coreSamplingConfigId) &&
+               (m_offset == other.m_offset) &&
+               (m_moduleInstanceId == other.m_moduleInstanceId) &&
+               (m_functionId == other.m_functionId);
+    }
+};
+
+namespace std
+{
+template <>
+struct hash<SampleContextKey>
+{
+    size_t operator()(const SampleContextKey& key) const
+    {
+        gtUInt64 value = key.m_processThreadId;
+        value = (value * 31) ^ key.m_coreSamplingConfigId;
+        value = (value * 31) ^ ((static_cast<gtUInt64>(key.m_functionId) << 32) | key.m_moduleInstanceId);
+        value = (value * 31) ^ key.m_offset;
+        return std::hash<gtUInt64>()(value);
+    }
+};
+}
+
 class ProfilerDataDBWriter;
 
 class ProfilerDataWriterThread : public osThread
@@ -75,6 +115,7 @@ public:
 
     int entryPoint() override;
 
+    // The writer drains the queued data before exiting
     void requestExit()
     {
         exitRequested = true;
@@ -82,7 +123,7 @@ public:
 
 private:
     ProfilerDataDBWriter &m_Writer;
-    bool exitRequested = false;
+    volatile bool exitRequested = false;
 };
 
 class CP_RAWDATA_API ProfilerDataDBWriter
@@ -104,13 +145,18 @@ public:
                 osSleep(100);
             }
 
-            // Writer may be writing the last item
-            // Wait for some more time
+            // Writer may be writing the last item.
+            // It must not be terminated while it is using the DB, so let it finish
+            m_pWriterThread->requestExit();
+
             osTimeInterval timeout;
-            timeout.setAsMilliSeconds(500);
-            m_pWriterThread->waitForThreadEnd(timeout);
+            timeout.setAsMilliSeconds(100);
+
+            while (m_pWriterThread->isAlive())
+            {
+                m_pWriterThread->waitForThreadEnd(timeout);
+            }
 
-            m_pWriterThread->terminate();
             delete m_pWriterThread;
         }
 
@@ -153,6 +199,9 @@ public:
 
     // This will be called by the single writer thread
     void Write(TranslatedDataType type, void* data);
+
+    // Called by the writer thread at the end of the data
+    void FinishSamples();
 #if 0
     bool Write(CpuProfileInfo& profileInfo,
         gtUInt64 cpuAffinity,
@@ -197,6 +246,12 @@ private:
 
     // This thread would be responsible for writing the translated data to DB.
     ProfilerDataWriterThread *m_pWriterThread = nullptr;
+
+    // The translators hand over each sample context once until the DB is flushed,
+    // so the sample contexts are inserted without looking them up first till then.
+    bool m_hasFlushedSamples = false;
+    gtUInt64 m_numSampleRecords = 0;
+    double m_sampleWriteTime = 0.0;
 };
 
 #endif //_CPUPROFILEDATADBWRITER_H_
@@ -162,6 +162,8 @@ HRESULT CaPerfDataReader::init(const std::string& filepath)
 
 void CaPerfDataReader::deinit()
 {
+    _unmapWindow();
+
     if (m_fd != -1)
     {
         close(m_fd);
@@ -537,8 +539,8 @@ HRESULT CaPerfDataReader::dumpCaPerfEvents()
 HRESULT CaPerfDataReader::dump_PERF_RECORD(struct perf_event_header* pHdr, void* ptr, gtUInt32 recNum)
 {
     (void)(ptr); // unused
-    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"[rec#:%5d, offet:0x%05x size:%3d] PERF_RECORD_%hs",
-                               recNum, m_offset, pHdr->size, _ca_perfRecNames[pHdr->type]);
+    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"[rec#:%5d, offet:0x%05llx size:%3d] PERF_RECORD_%hs",
+                               recNum, m_recOffset, pHdr->size, _ca_perfRecNames[pHdr->type]);
 
     return S_OK;
 }
@@ -550,40 +552,28 @@ HRESULT CaPerfDataReader::dumpCaPerfData()
         return E_NOFILE;
     }
 
-    // Move to the data Section
-    if ((m_offset = lseek(m_fd, m_dataStartOffset, SEEK_SET)) < 0)
-    {
-        return E_FAIL;
-    }
-
-    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"-------- PERF DATA SECTION (offset:0x%lx, size:%lu)--------",
+    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"-------- PERF DATA SECTION (offset:0x%llx, size:%llu)--------",
                                m_dataStartOffset, m_dataSize);
 
     int retVal = S_OK;
-    struct perf_event_header hdr;
-    void* pBuf = NULL;
+    const struct perf_event_header* pRec = NULL;
     gtUInt32 recCnt = 0;
 
-    if (getFirstRecord(&hdr, (const void**)(&pBuf)) != S_OK)
+    // Move to the data Section
+    if (getFirstRecord(&pRec) != S_OK)
     {
         return E_FAIL;
     }
 
     do
     {
-        if (hdr.size == 0 || !pBuf)
-        {
-            retVal = E_FAIL;
-            break;
-        }
-
-        dump_PERF_RECORD(&hdr, pBuf, recCnt);
+        dump_PERF_RECORD((struct perf_event_header*) pRec, (void*)(pRec + 1), recCnt);
 
         recCnt++;
     }
-    while (getNextRecord(&hdr, (const void**)(&pBuf)) == S_OK);
+    while ((retVal = getNextRecord(&pRec)) == S_OK);
 
-    return retVal;
+    return isEndOfFile() ? S_OK : retVal;
 }
 
 
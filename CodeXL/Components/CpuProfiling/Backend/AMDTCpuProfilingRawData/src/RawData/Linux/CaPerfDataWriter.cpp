@@ -20,6 +20,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <dirent.h>
+#include <limits.h>
 
 CaPerfDataWriter::CaPerfDataWriter()
 {
@@ -35,6 +36,10 @@ CaPerfDataWriter::CaPerfDataWriter()
     m_dataStartOffset = 0;
     m_dataSize = 0;
 
+    m_pfnSampleDataCallback = NULL;
+    m_pSampleDataContext = NULL;
+    m_writeSampleData = true;
+
     m_pForkEvent = NULL;
     m_pCommEvent = NULL;
     m_pMmapEvent = NULL;
@@ -823,6 +828,16 @@ HRESULT CaPerfDataWriter::writePMUSampleData(void* data, ssize_t size)
         m_offset = lseek(m_fd, 0, SEEK_END);
     }
 
+    if (NULL != m_pfnSampleDataCallback)
+    {
+        m_pfnSampleDataCallback(data, size, m_pSampleDataContext);
+
+        if (!m_writeSampleData)
+        {
+            return S_OK;
+        }
+    }
+
     int ret = write(m_fd, (const void*)data, size);
 
     if (ret != size)
@@ -836,6 +851,88 @@ HRESULT CaPerfDataWriter::writePMUSampleData(void* data, ssize_t size)
     return S_OK;
 }
 
+void CaPerfDataWriter::setSampleDataCallback(caperf_sample_data_callback_t pfnCallback, void* pContext, bool writeToFile)
+{
+    m_pfnSampleDataCallback = pfnCallback;
+    m_pSampleDataContext = pContext;
+    m_writeSampleData = writeToFile || (NULL == pfnCallback);
+}
+
+HRESULT CaPerfDataWriter::writePMUSampleData(const struct iovec* pIov, int iovCount)
+{
+    if (! m_dataStartOffset)
+    {
+        m_dataStartOffset = lseek(m_fd, 0, SEEK_END);
+
+        updateSectionHdr(CAPERF_SECTION_SAMPLE_DATA,
+                         m_dataStartOffset,
+                         m_dataSize);
+
+        m_offset = lseek(m_fd, 0, SEEK_END);
+    }
+
+    if (NULL != m_pfnSampleDataCallback)
+    {
+        for (int i = 0; i < iovCount; i++)
+        {
+            m_pfnSampleDataCallback(pIov[i].iov_base, pIov[i].iov_len, m_pSampleDataContext);
+        }
+
+        if (!m_writeSampleData)
+        {
+            return S_OK;
+        }
+    }
+
+    // The other sections are appended at the current file offset too, hence writev() and not pwritev()
+    struct iovec iov[IOV_MAX];
+
+    while (0 < iovCount)
+    {
+        int count = (IOV_MAX < iovCount) ? IOV_MAX : iovCount;
+        ssize_t size = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            iov[i] = pIov[i];
+            size += pIov[i].iov_len;
+        }
+
+        // Resume the partial writes
+        int first = 0;
+
+        while (first < count)
+        {
+            ssize_t ret = writev(m_fd, &iov[first], count - first);
+
+            if (ret <= 0)
+            {
+                OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"Error writing PMU Sample Data. ret(%d)", ret);
+                return E_FAIL;
+            }
+
+            while ((first < count) && (static_cast<size_t>(ret) >= iov[first].iov_len))
+            {
+                ret -= iov[first].iov_len;
+                first++;
+            }
+
+            if (first < count)
+            {
+                iov[first].iov_base = static_cast<gtByte*>(iov[first].iov_base) + ret;
+                iov[first].iov_len -= ret;
+            }
+        }
+
+        m_dataSize += size;
+        pIov += count;
+        iovCount -= count;
+    }
+
+    m_offset = lseek(m_fd, 0, SEEK_CUR);
+    return S_OK;
+}
+
 //
 // In Systwm Wide mode, we need to add the /proc entries in the caperf.data file
 //
@@ -19,6 +19,8 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <string.h>
 
 extern const char* _ca_perfRecNames[];
 
@@ -47,6 +49,13 @@ void PerfDataReader::clear()
     m_dataStartOffset = 0;
     m_dataSize = 0;
 
+    m_useMmap = true;
+    m_fileSize = 0;
+    m_pMapBase = NULL;
+    m_mapOffset = 0;
+    m_mapSize = 0;
+    m_recOffset = 0;
+
     m_pPerfHdr = NULL;
     m_perfEventAttrVec.clear();
     m_perfEvtIdToEvtTypeMap.clear();
@@ -71,8 +80,9 @@ HRESULT PerfDataReader::init(const std::string& perfDataPath)
     // Get the Perf header
     m_pPerfHdr = (struct perf_file_header*) mmap(NULL, sizeof(struct perf_file_header), PROT_READ, MAP_PRIVATE, m_fd, 0);
 
-    if (!m_pPerfHdr)
+    if (MAP_FAILED == m_pPerfHdr)
     {
+        m_pPerfHdr = NULL;
         return E_FAIL;
     }
 
@@ -110,6 +120,14 @@ HRESULT PerfDataReader::init(const std::string& perfDataPath)
 
 void PerfDataReader::deinit()
 {
+    _unmapWindow();
+
+    if (NULL != m_pPerfHdr)
+    {
+        munmap(m_pPerfHdr, sizeof(struct perf_file_header));
+        m_pPerfHdr = NULL;
+    }
+
     if (m_fd != -1)
     {
         close(m_fd);
@@ -393,50 +411,244 @@ int PerfDataReader::_processPerfEventTypesSection()
 }
 
 
-HRESULT PerfDataReader::getFirstRecord(struct perf_event_header* pHdr, const void** ppBuf, gtUInt32* pOffset)
+HRESULT PerfDataReader::getFirstRecord(struct perf_event_header* pHdr, const void** ppBuf, gtUInt64* pOffset)
 {
     // Go to the offset specified by m_dataStartOffset
     return getRecordFromOffset(m_dataStartOffset, pHdr, ppBuf, pOffset);
 }
 
 
-HRESULT PerfDataReader::getRecordFromOffset(gtUInt32 offset,
+HRESULT PerfDataReader::getRecordFromOffset(gtUInt64 offset,
                                             struct perf_event_header* pHdr,
                                             const void** ppBuf,
-                                            gtUInt32* pOffset)
+                                            gtUInt64* pOffset)
 {
-    // Goto specified offset
-    if ((m_offset = lseek(m_fd, offset, SEEK_SET)) < 0)
+    // Sanity check
+    if (NULL == pHdr || NULL == ppBuf)
     {
-        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"Error: Invalid offset 0x%lx", offset);
-        return E_UNEXPECTED;
+        return E_INVALIDARG;
+    }
+
+    const struct perf_event_header* pRec = NULL;
+    HRESULT retVal = getRecordFromOffset(offset, &pRec, pOffset);
+
+    if (S_OK == retVal)
+    {
+        *pHdr = *pRec;
+        *ppBuf = pRec + 1;
     }
 
-    return getNextRecord(pHdr, ppBuf, pOffset);
+    return retVal;
 }
 
 
-HRESULT PerfDataReader::getNextRecord(
-    struct perf_event_header* pHdr,
-    const void** ppBuf,
-    gtUInt32* pOffset)
+HRESULT PerfDataReader::getNextRecord(struct perf_event_header* pHdr, const void** ppBuf, gtUInt64* pOffset)
 {
-    HRESULT retVal = S_OK;
-    ssize_t rdSz = 0;
+    // Sanity check
+    if (NULL == pHdr || NULL == ppBuf)
+    {
+        return E_INVALIDARG;
+    }
+
+    const struct perf_event_header* pRec = NULL;
+    HRESULT retVal = getNextRecord(&pRec, pOffset);
+
+    if (S_OK == retVal)
+    {
+        *pHdr = *pRec;
+        *ppBuf = pRec + 1;
+    }
+
+    return retVal;
+}
+
+
+HRESULT PerfDataReader::getFirstRecord(const struct perf_event_header** ppRec, gtUInt64* pOffset)
+{
+    // Go to the offset specified by m_dataStartOffset
+    return getRecordFromOffset(m_dataStartOffset, ppRec, pOffset);
+}
+
+
+HRESULT PerfDataReader::getRecordFromOffset(gtUInt64 offset, const struct perf_event_header** ppRec, gtUInt64* pOffset)
+{
+    if (!isOpen())
+    {
+        return E_NOFILE;
+    }
+
+    // The read() path keeps the file position in sync with m_offset
+    if (!m_useMmap && lseek64(m_fd, static_cast<off64_t>(offset), SEEK_SET) < 0)
+    {
+        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"Error: Invalid offset 0x%llx", offset);
+        return E_UNEXPECTED;
+    }
+
+    m_offset = offset;
+    m_isEof = false;
 
+    return getNextRecord(ppRec, pOffset);
+}
+
+
+HRESULT PerfDataReader::getNextRecord(const struct perf_event_header** ppRec, gtUInt64* pOffset)
+{
     // Sanity check
-    if (NULL == pHdr)
+    if (NULL == ppRec)
     {
         return E_INVALIDARG;
     }
 
+    m_recOffset = m_offset;
+
     if (NULL != pOffset)
     {
         *pOffset = m_offset;
     }
 
+    HRESULT retVal = m_useMmap ? _mapRecord(ppRec) : _readRecord(ppRec);
+
+    if (S_OK == retVal)
+    {
+        m_offset += (*ppRec)->size;
+    }
+
+    return retVal;
+}
+
+
+void PerfDataReader::setMmapMode(bool useMmap)
+{
+    if (useMmap != m_useMmap)
+    {
+        _unmapWindow();
+        m_useMmap = useMmap;
+
+        // Resync the file position for the read() path
+        if (!m_useMmap && isOpen())
+        {
+            lseek64(m_fd, static_cast<off64_t>(m_offset), SEEK_SET);
+        }
+    }
+}
+
+
+// Makes sure that the file range [offset, offset + size) is covered by the current mapping.
+// The window is placed at the page containing offset and spans PERF_DATA_MMAP_WINDOW_SIZE
+// bytes (or the whole file), so that sequential iteration remaps only once per window.
+bool PerfDataReader::_mapWindow(gtUInt64 offset, gtUInt64 size)
+{
+    if (NULL != m_pMapBase && offset >= m_mapOffset && (offset + size) <= (m_mapOffset + m_mapSize))
+    {
+        return true;
+    }
+
+    _unmapWindow();
+
+    if (0 == m_fileSize)
+    {
+        struct stat64 st;
+
+        if (0 != fstat64(m_fd, &st))
+        {
+            return false;
+        }
+
+        m_fileSize = static_cast<gtUInt64>(st.st_size);
+    }
+
+    if ((offset + size) > m_fileSize)
+    {
+        return false;
+    }
+
+    gtUInt64 pageSize = static_cast<gtUInt64>(sysconf(_SC_PAGESIZE));
+    gtUInt64 mapOffset = 0;
+    gtUInt64 mapSize = m_fileSize;
+
+    if (0ULL != PERF_DATA_MMAP_WINDOW_SIZE)
+    {
+        mapOffset = offset & ~(pageSize - 1);
+        mapSize = PERF_DATA_MMAP_WINDOW_SIZE;
+
+        // The requested range must fit into the window
+        if ((offset + size - mapOffset) > mapSize)
+        {
+            mapSize = (offset + size - mapOffset + pageSize - 1) & ~(pageSize - 1);
+        }
+
+        if ((mapOffset + mapSize) > m_fileSize)
+        {
+            mapSize = m_fileSize - mapOffset;
+        }
+    }
+
+    void* pMap = mmap64(NULL, static_cast<size_t>(mapSize), PROT_READ, MAP_PRIVATE, m_fd, static_cast<off64_t>(mapOffset));
+
+    if (MAP_FAILED == pMap)
+    {
+        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"Failed to map data file (offset:0x%llx, size:%llu)", mapOffset, mapSize);
+        return false;
+    }
+
+    m_pMapBase = static_cast<gtUByte*>(pMap);
+    m_mapOffset = mapOffset;
+    m_mapSize = mapSize;
+
+    return true;
+}
+
+
+void PerfDataReader::_unmapWindow()
+{
+    if (NULL != m_pMapBase)
+    {
+        munmap(m_pMapBase, static_cast<size_t>(m_mapSize));
+        m_pMapBase = NULL;
+    }
+
+    m_mapOffset = 0;
+    m_mapSize = 0;
+}
+
+
+HRESULT PerfDataReader::_mapRecord(const struct perf_event_header** ppRec)
+{
+    // Check for end-of-file
+    if (!_mapWindow(m_offset, sizeof(struct perf_event_header)))
+    {
+        m_isEof = (m_offset >= m_fileSize);
+        return E_UNEXPECTED;
+    }
+
+    const struct perf_event_header* pRec =
+        reinterpret_cast<const struct perf_event_header*>(m_pMapBase + (m_offset - m_mapOffset));
+
+    // Sanity check
+    if (pRec->size < sizeof(struct perf_event_header))
+    {
+        return E_INVALIDDATA;
+    }
+
+    // The payload may extend past the current window
+    if (!_mapWindow(m_offset, pRec->size))
+    {
+        return E_UNEXPECTED;
+    }
+
+    *ppRec = reinterpret_cast<const struct perf_event_header*>(m_pMapBase + (m_offset - m_mapOffset));
+
+    return S_OK;
+}
+
+
+HRESULT PerfDataReader::_readRecord(const struct perf_event_header** ppRec)
+{
+    struct perf_event_header hdr;
+    ssize_t rdSz = 0;
+
     // Read the header
-    rdSz = read(m_fd, pHdr, sizeof(struct perf_event_header));
+    rdSz = read(m_fd, &hdr, sizeof(struct perf_event_header));
 
     if (rdSz != sizeof(struct perf_event_header))
     {
@@ -447,45 +659,43 @@ HRESULT PerfDataReader::getNextRecord(
     }
 
     // Sanity check
-    if (pHdr->size <= 0)
+    if (hdr.size < sizeof(struct perf_event_header))
     {
         return E_INVALIDDATA;
     }
 
-    // Adjust payload size
-    if (pHdr->size > m_curBufSz)
+    // Adjust buffer size, the record is kept as header followed by the payload
+    if (hdr.size > m_curBufSz)
     {
-        m_pBuf = realloc(m_pBuf, pHdr->size + 10); // add buffer zone
+        void* pNewBuf = realloc(m_pBuf, hdr.size + 10); // add buffer zone
 
-        if (!m_pBuf)
+        if (!pNewBuf)
         {
             return E_OUTOFMEMORY;
         }
 
-        m_curBufSz = pHdr->size;
+        m_pBuf = pNewBuf;
+        m_curBufSz = hdr.size;
     }
 
+    char* pTmp = (char*) m_pBuf;
+    memcpy(pTmp, &hdr, sizeof(struct perf_event_header));
+
     // Read the payload
-    ssize_t sz = pHdr->size - sizeof(struct perf_event_header);
+    ssize_t sz = hdr.size - sizeof(struct perf_event_header);
 
-    rdSz = read(m_fd, m_pBuf, sz);
+    rdSz = read(m_fd, pTmp + sizeof(struct perf_event_header), sz);
 
     if (rdSz != sz)
     {
         return E_UNEXPECTED;
     }
 
-    char* tmp = (char*) m_pBuf;
-    tmp[pHdr->size] = '\0';
+    pTmp[hdr.size] = '\0';
 
-    m_offset += rdSz + sizeof(struct perf_event_header);
-
-    if (retVal == S_OK)
-    {
-        *ppBuf = m_pBuf;
-    }
+    *ppRec = (const struct perf_event_header*) m_pBuf;
 
-    return retVal;
+    return S_OK;
 }
 
 
@@ -514,75 +724,34 @@ int PerfDataReader::dumpPerfData()
         return E_NOFILE;
     }
 
-    lseek(m_fd, 0, SEEK_SET);
-
-    // Move to the data Section
-    if (lseek(m_fd, m_pPerfHdr->data.offset, SEEK_SET) < 0)
-    {
-        return E_UNEXPECTED;
-    }
-
-    m_offset = m_pPerfHdr->data.offset;
-
     OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"-------- PERF DATA SECTION (offset:0x%lx, size:%lu)--------",
                                m_pPerfHdr->data.offset, m_pPerfHdr->data.size);
     int retVal = S_OK;
-    struct perf_event_header hdr;
-    void* pBuf = NULL;
-    int curBufSz = 0;
-    ssize_t rdSz = 0;
+    const struct perf_event_header* pRec = NULL;
     unsigned int recCnt = 0;
 
-    while ((rdSz = read(m_fd, &hdr, sizeof(struct perf_event_header))) > 0)
+    // Move to the data Section
+    if (S_OK != getRecordFromOffset(m_pPerfHdr->data.offset, &pRec))
     {
-        // Adjust payload size
-        if (hdr.size > curBufSz)
-        {
-            void* pNewBuf = realloc(pBuf, hdr.size);
-
-            if (NULL == pNewBuf)
-            {
-                retVal = E_OUTOFMEMORY;
-                break;
-            }
-
-            pBuf = pNewBuf;
-            curBufSz = hdr.size;
-        }
-
-        // Read the payload
-        rdSz = read(m_fd, pBuf, hdr.size - sizeof(struct perf_event_header));
-
-        if (rdSz == 0)
-        {
-            // EOF
-            break;
-        }
-        else if (rdSz < 0 || rdSz != (ssize_t)(hdr.size - sizeof(struct perf_event_header)))
-        {
-            retVal = E_UNEXPECTED;
-            break;
-        }
-
-        dump_PERF_RECORD(&hdr, pBuf, recCnt);
-        m_offset += rdSz + sizeof(struct perf_event_header);
-        recCnt++;
+        return m_isEof ? S_OK : E_UNEXPECTED;
     }
 
-    if (NULL != pBuf)
+    do
     {
-        free(pBuf);
+        dump_PERF_RECORD((struct perf_event_header*) pRec, (void*)(pRec + 1), recCnt);
+        recCnt++;
     }
+    while (S_OK == (retVal = getNextRecord(&pRec)));
 
-    return retVal;
+    return m_isEof ? S_OK : retVal;
 }
 
 
 HRESULT PerfDataReader::dump_PERF_RECORD(struct perf_event_header* pHdr, void* ptr, int recNum)
 {
     (void)(ptr); // unused
-    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"[rec#:%5d, offet:0x%05x size:%3d] PERF_RECORD_%hs",
-                               recNum, m_offset, pHdr->size, _ca_perfRecNames[pHdr->type]);
+    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"[rec#:%5d, offet:0x%05llx size:%3d] PERF_RECORD_%hs",
+                               recNum, m_recOffset, pHdr->size, _ca_perfRecNames[pHdr->type]);
 
     return S_OK;
 }
@@ -16,6 +16,7 @@
 #include <AMDTOSWrappers/Include/osApplication.h>
 #include <AMDTOSWrappers/Include/osGeneralFunctions.h>
 #include <AMDTOSWrappers/Include/osDebugLog.h>
+#include <AMDTOSWrappers/Include/osStopWatch.h>
 #include <AMDTCpuPerfEventUtils/inc/EventEngine.h>
 #include <AMDTCommonProfileDataTypes.h>
 #include <CpuProfileInfo.h>
@@ -36,15 +37,23 @@ int ProfilerDataWriterThread::entryPoint()
 
     while (true)
     {
-        while (m_Writer.isEmpty())
+        while (m_Writer.isEmpty() && !exitRequested)
         {
             osSleep(WRITER_WAIT_MS);
         }
 
+        if (m_Writer.isEmpty())
+        {
+            // The exit was requested before the end of the data
+            m_Writer.FinishSamples();
+            break;
+        }
+
         TranslatedDataContainer dc = m_Writer.Pop();
 
-        if (exitRequested || TRANSLATED_DATA_TYPE_UNKNOWN_INFO == dc.m_type)
+        if (TRANSLATED_DATA_TYPE_UNKNOWN_INFO == dc.m_type)
         {
+            m_Writer.FinishSamples();
             break;
         }
 
@@ -330,7 +339,13 @@ void ProfilerDataDBWriter::PackCounterInfo(gtVector<EventMaskType>& events, AMDT
 
 void ProfilerDataDBWriter::Write(TranslatedDataType type, void* data)
 {
-    if (nullptr != data)
+    // The data written so far becomes visible to the readers of the DB
+    if (TRANSLATED_DATA_TYPE_FLUSH == type)
+    {
+        m_pCpuProfDbAdapter->FlushDb();
+        m_hasFlushedSamples = true;
+    }
+    else if (nullptr != data)
     {
         switch (type)
         {
@@ -430,7 +445,15 @@ void ProfilerDataDBWriter::Write(TranslatedDataType type, void* data)
             CPASampeInfoList *sampleList = reinterpret_cast<CPASampeInfoList*>(data);
             if (sampleList->size() > 0)
             {
-                m_pCpuProfDbAdapter->InsertSamples(*sampleList);
+                osStopWatch stopWatch;
+                stopWatch.start();
+
+                m_pCpuProfDbAdapter->InsertSamples(*sampleList, !m_hasFlushedSamples);
+
+                double elapsedTime = 0.0;
+                stopWatch.getTimeInterval(elapsedTime);
+                m_sampleWriteTime += elapsedTime;
+                m_numSampleRecords += sampleList->size();
             }
             delete sampleList;
             break;
@@ -482,6 +505,15 @@ void ProfilerDataDBWriter::Write(TranslatedDataType type, void* data)
         }
     }
 }
+void ProfilerDataDBWriter::FinishSamples()
+{
+    if (0 != m_numSampleRecords)
+    {
+        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"DB Writer: %llu sample records written in %.3f sec",
+                                   m_numSampleRecords, m_sampleWriteTime);
+    }
+}
+
 #if 0
 gtString ProfilerDataDBWriter::ConvertQtToGTString(const QString& inputStr)
 {
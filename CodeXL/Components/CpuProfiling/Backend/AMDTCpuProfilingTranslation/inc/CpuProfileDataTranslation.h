@@ -100,6 +100,52 @@ CP_TRANS_API HRESULT fnOpenProfile(
     /*in*/ const wchar_t* pPath,
     /*out*/ ReaderHandle** pReaderHandle);
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+/** This function will open a ".caperf" profile data file which is still being
+    collected, and starts translating its records as they are handed over by
+    \ref fnOnlineTranslationSampleData.
+
+    The raw data file must be the profile output file of the profiling session,
+    and \ref fnOnlineTranslationSampleData must be set as its sample data callback
+    (see fnSetSampleDataCallback) before the profiling starts. Once the profiling
+    stopped, \ref fnCpuProfileDataTranslate completes the translation.
+
+    If pDbFilePath is given, the translated data is written to that profile DB
+    every few seconds while the profiling runs, so that it can be read before the
+    profiling stopped. \ref fnCpuProfileDataTranslate must then be given the same
+    DB path to complete it.
+
+    \ingroup datafiles
+    @param[in] pPath The profile data file which is going to be collected
+    @param[in] pDbFilePath The profile DB written during the profiling, or NULL
+    @param[out] pReaderHandle The handle to use for retrieving the data
+    \return The success of opening the profile
+    \retval S_OK Success
+    \retval E_INVALIDARG either pPath or pReaderHandle is not a valid
+    pointer
+    \retval E_HANDLE The reader handle is already open
+    \retval E_OUTOFMEMORY no more memory is available
+    \retval E_FAIL the translation thread could not be started
+*/
+CP_TRANS_API HRESULT fnOpenOnlineProfile(
+    /*in*/ const wchar_t* pPath,
+    /*in*/ const wchar_t* pDbFilePath,
+    /*out*/ ReaderHandle** pReaderHandle);
+
+/** The sample data callback of the profiling session translated online. The
+    reader handle opened by \ref fnOpenOnlineProfile is the callback context, and
+    must stay open until the profiling stopped.
+    \ingroup datafiles
+    @param[in] pData The records read from the sampling buffers
+    @param[in] size The size of the records in bytes
+    @param[in] pReaderHandle The handle opened by \ref fnOpenOnlineProfile
+*/
+CP_TRANS_API void fnOnlineTranslationSampleData(
+    /*in*/ const void* pData,
+    /*in*/ size_t size,
+    /*in*/ void* pReaderHandle);
+#endif // AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
 /** Releases all resources appropriately.  Note that after this call, the
     reader handle will not be valid.
     \ingroup datafiles
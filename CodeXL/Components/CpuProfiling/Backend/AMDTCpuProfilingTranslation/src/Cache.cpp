@@ -10,23 +10,102 @@
 #include "Cache.h"
 
 
+CoreCache::CoreCache(UINT32 numSets, UINT8 assoc) : m_lines(static_cast<size_t>(numSets) * assoc),
+                                                    m_setFill(numSets, 0),
+                                                    m_time(0),
+                                                    m_numSets(numSets),
+                                                    m_assoc(assoc)
+{
+}
+
+CacheNotifications CoreCache::CacheAccess(UINT32 index, UINT64 tag, CacheDataStuff** data)
+{
+    CacheDataStuff* pSet = &m_lines[index * m_assoc];
+    UINT32 numLines = m_setFill[index];
+
+    // Look for a matching tag.  If found, it's a hit
+    // If it's not found, find a candidate for eviction (LRU, based on timestamp)
+    CacheDataStuff* pLRU = NULL;
+    UINT64 LRUValue = MAX_UINT64;
+
+    for (UINT32 i = 0; i < numLines; i++)
+    {
+        if (pSet[i].tag == tag)
+        {
+            // This is the one we're looking for - hit
+            pSet[i].timestamp = m_time++;
+            *data = &pSet[i];
+            return CACHE_NORMAL;
+        }
+
+        if (pSet[i].timestamp < LRUValue)
+        {
+            pLRU = &pSet[i];
+            LRUValue = pSet[i].timestamp;
+        }
+    }
+
+    // Did not find the tag in this set
+    // Check if we've allocated all the ways for this set
+    if (numLines < m_assoc)
+    {
+        CacheDataStuff& line = pSet[numLines];
+
+        line.tag = tag;
+        line.timestamp = m_time++;
+        m_setFill[index]++;
+
+        *data = &line;
+        return CACHE_NORMAL;
+    }
+
+    // Update the tag in the eviction candidate and the timestamp
+    pLRU->timestamp = m_time++;
+    pLRU->tag = tag;
+    *data = pLRU;
+
+    return CACHE_EVICTED;
+}
+
+void CoreCache::Clear()
+{
+    for (UINT32 index = 0; index < m_numSets; index++)
+    {
+        CacheDataStuff* pSet = &m_lines[index * m_assoc];
+
+        for (UINT32 i = 0; i < m_setFill[index]; i++)
+        {
+            pSet[i].pidrips.clear();
+        }
+
+        m_setFill[index] = 0;
+    }
+}
+
+
 Cache::Cache()
 {
     m_isInitialized = false;
-    m_time = 0;     // For LRU
-    m_pCoreCache = NULL;
+    m_numSets = 0;
+
+    for (int i = 0; i < CLU_MAX_CORES; i++)
+    {
+        m_pCoreCaches[i] = NULL;
+    }
 }
 
 Cache::~Cache()
 {
     m_isInitialized = false;
 
-    if (NULL != m_pCoreCache)
+    for (int i = 0; i < CLU_MAX_CORES; i++)
     {
-        delete m_pCoreCache;
+        if (NULL != m_pCoreCaches[i])
+        {
+            delete m_pCoreCaches[i];
+            m_pCoreCaches[i] = NULL;
+        }
     }
-
-    m_pCoreCache = NULL;
 }
 
 bool Cache::Init(UINT8 l1DcAssoc,
@@ -59,146 +138,42 @@ bool Cache::Init(UINT8 l1DcAssoc,
     m_indexShift = CountBits((UINT64) m_offsetMask);
     assert(CountBits(numLines) == 1);
     m_indexMask = numLines - 1;
+    m_numSets = numLines;
 
     m_tagShift = m_indexShift + CountBits((UINT64) m_indexMask);
     m_tagMask = MAX_UINT64 >> m_tagShift;
 
-    m_pCoreCache = new CoreCacheMap;
-    m_isInitialized = (NULL != m_pCoreCache);
+    m_isInitialized = true;
 
     return m_isInitialized;
 }
 
-CacheNotifications Cache::CacheAccess(gtVAddr address, CacheDataStuff** data, unsigned char core)
+CoreCache* Cache::GetCoreCache(unsigned char core)
 {
     if (!m_isInitialized)
     {
-        return CACHE_ERROR;
+        return NULL;
     }
 
-    // Decompose the address
-    UINT64 tag = GetTag(address);
-    UINT32 index = GetIndex(address);
-
-    // See if we have accessed this core before
-    CoreCacheMap::iterator coreIt = m_pCoreCache->find(core);
-
-    if (coreIt == m_pCoreCache->end())
+    if (NULL == m_pCoreCaches[core])
     {
         // First access from this core
-        CacheMap cacheMap;
-        coreIt = m_pCoreCache->insert(std::pair <unsigned char, CacheMap > (core, cacheMap)).first;
-        assert(coreIt != m_pCoreCache->end());
-    }
-
-    CacheMap::iterator SetIt = coreIt->second.find(index);
-    bool newLine = false;
-
-    // If no lines allocated for this set, add a new $line
-    if (SetIt == coreIt->second.end())
-    {
-        CacheDataStuff cacheDataStuff;  // Constructor initializes this
-
-        cacheDataStuff.tag = tag;
-        SetIt = coreIt->second.insert(CacheMap::value_type(index, cacheDataStuff));
-        assert(SetIt != coreIt->second.end());
-        newLine = true;
-    }
-
-    if (newLine)
-    {
-        // We added a new $line - all done
-        SetIt->second.timestamp = m_time++; // Update access time for LRU
-        *data = &(SetIt->second);
-        return CACHE_NORMAL;
-    }
-
-    // We did not insert a new line.
-    // Look for a matching tag.  If found, it's a hit
-    // If it's not found, find a candidate for eviction (LRU, based on timestamp)
-    CacheMap::iterator LRUIt = coreIt->second.end();
-    UINT64 LRUValue = MAX_UINT64;
-    bool bTagFound = false;
-
-    while (SetIt->first == index)
-    {
-        if (SetIt->second.tag == tag)
-        {
-            // This is the one we're looking for - hit
-            bTagFound = true;
-            break;
-        }
-
-        if (SetIt->second.timestamp < LRUValue)
-        {
-            LRUIt = SetIt;
-            LRUValue = SetIt->second.timestamp;
-        }
-
-        SetIt++;
-
-        if (SetIt == coreIt->second.end())
-        {
-            break;
-        }
-    }
-
-    if (bTagFound)
-    {
-        SetIt->second.timestamp = m_time++;
-        *data = &(SetIt->second);
-        return CACHE_NORMAL;
+        m_pCoreCaches[core] = new CoreCache(m_numSets, m_l1DcAssoc);
     }
 
-    // Did not find the tag in this set
-    // Check if we've allocated all the ways for this set
-    if (coreIt->second.count(index) < m_l1DcAssoc)
-    {
-        CacheDataStuff cacheDataStuff;  // Constructor initializes this
-
-        cacheDataStuff.tag = tag;
-        cacheDataStuff.timestamp = m_time++;
-        SetIt = coreIt->second.insert(CacheMap::value_type(index, cacheDataStuff));
-        assert(SetIt != coreIt->second.end());
-        *data = &(SetIt->second);
-        return CACHE_NORMAL;
-    }
-
-    // Did not find the tag in the set.
-    // Update the tag in the eviction candidate and the timestamp
-    LRUIt->second.timestamp = m_time++;
-    LRUIt->second.tag = tag;
-    *data = &(LRUIt->second);
-
-    return CACHE_EVICTED;
+    return m_pCoreCaches[core];
 }
 
-
-CacheDataStuff* Cache::GetNextValidLine(unsigned char& core, unsigned int& index)
+bool Cache::GetFirstCore(unsigned char& core) const
 {
-    CoreCacheMap::iterator coreIt = m_pCoreCache->begin();
-
-    if (coreIt == m_pCoreCache->end())
+    for (int i = 0; i < CLU_MAX_CORES; i++)
     {
-        return NULL;
-    }
-
-    CacheMap::iterator SetIt = coreIt->second.begin();
-
-    if (SetIt == coreIt->second.end())
-    {
-        return NULL;
-    }
-
-    if (MAX_UINT64 == SetIt->second.timestamp)
-    {
-        coreIt->second.erase(SetIt);
-        return GetNextValidLine(core, index);
+        if (NULL != m_pCoreCaches[i])
+        {
+            core = static_cast<unsigned char>(i);
+            return true;
+        }
     }
 
-    SetIt->second.timestamp = MAX_UINT64;
-    core = coreIt->first;
-    index = SetIt->first;
-
-    return &(SetIt->second);
+    return false;
 }
@@ -11,7 +11,7 @@
 #define _CACHE_H_
 
 #include <assert.h>
-#include <map>
+#include <vector>
 
 #include "CluInfo.h"
 
@@ -22,6 +22,39 @@ enum CacheNotifications
     CACHE_ERROR
 };
 
+// The L1 data cache of a single core.
+// The lines are kept in flat set-associative arrays: the ways of a set are allocated in
+// order as the set fills up, and then the least recently used way is replaced.
+class CoreCache
+{
+public:
+    CoreCache(UINT32 numSets, UINT8 assoc);
+
+    CacheNotifications CacheAccess(UINT32 index, UINT64 tag, CacheDataStuff** data);
+
+    // Returns the allocated lines of a set, in allocation order
+    CacheDataStuff* GetSetLines(UINT32 index, UINT32& numLines)
+    {
+        numLines = m_setFill[index];
+        return &m_lines[index * m_assoc];
+    }
+
+    UINT32 GetNumSets() const
+    {
+        return m_numSets;
+    }
+
+    // Invalidates all the lines
+    void Clear();
+
+private:
+    std::vector<CacheDataStuff> m_lines;    // m_numSets * m_assoc lines, set by set
+    std::vector<UINT8>          m_setFill;  // Number of allocated ways of each set
+    UINT64                      m_time;     // Used for LRU
+    UINT32                      m_numSets;
+    UINT8                       m_assoc;
+};
+
 class Cache
 {
 public:
@@ -33,45 +66,47 @@ public:
               UINT8 l1DcLinesPerTag,
               UINT8 l1DcSize);
 
-    CacheNotifications CacheAccess(gtVAddr address,
-                                   CacheDataStuff** data,
-                                   unsigned char core);
+    // The cores are independent: the cache of a core may be accessed by one thread, while
+    // other threads access the caches of other cores. The cache of a core is created by the
+    // first call for that core, which must not run concurrently with any other access.
+    CoreCache* GetCoreCache(unsigned char core);
 
-    CacheDataStuff* GetNextValidLine(unsigned char& core, unsigned int& index);
+    // Returns false if no core has been accessed
+    bool GetFirstCore(unsigned char& core) const;
 
-    UINT64 GetTag(gtVAddr addr)
+    UINT64 GetTag(gtVAddr addr) const
     {
         if (!m_isInitialized) { return MAX_UINT32; }
 
         return (addr >> m_tagShift) & m_tagMask;
     }
 
-    UINT32 GetIndex(gtVAddr addr)
+    UINT32 GetIndex(gtVAddr addr) const
     {
         return static_cast<UINT32>((addr >> m_indexShift) & m_indexMask);
     }
 
-    UINT32 GetOffset(gtVAddr addr)
+    UINT32 GetOffset(gtVAddr addr) const
     {
         return static_cast<UINT32>((addr >> m_offsetShift) & m_offsetMask);
     }
 
-    UINT8 GetBytesPerLine()
+    UINT8 GetBytesPerLine() const
     {
         return m_l1DcLineSize;
     }
 
-    bool SpansLines(UINT32 offset, unsigned char size)
+    bool SpansLines(UINT32 offset, unsigned char size) const
     {
         return ((offset + size - 1) & ~m_offsetMask) != 0;
     }
 
-    inline UINT8 CountBits(UINT64 bitmap)
+    static inline UINT8 CountBits(UINT64 bitmap)
     {
         return CountBits((UINT32) bitmap) + CountBits((UINT32)(bitmap >> 32));
     }
 
-    inline UINT8 CountBits(UINT32 bitmap)
+    static inline UINT8 CountBits(UINT32 bitmap)
     {
         bitmap = (bitmap & 0x55555555) + ((bitmap >>  1) & 0x55555555);
         bitmap = (bitmap & 0x33333333) + ((bitmap >>  2) & 0x33333333);
@@ -80,14 +115,14 @@ public:
         return static_cast<UINT8>((bitmap & 0x0000ffff) + ((bitmap >> 16) & 0x0000ffff));
     }
 
-    inline UINT8 CountBits(UINT8 bitmap)
+    static inline UINT8 CountBits(UINT8 bitmap)
     {
         bitmap = (bitmap & 0x55) + ((bitmap >>  1) & 0x55);
         bitmap = (bitmap & 0x33) + ((bitmap >>  2) & 0x33);
         return (bitmap & 0x0f) + ((bitmap >>  4) & 0x0f);
     }
 
-    inline UINT8 ILog2(UINT32 x)
+    static inline UINT8 ILog2(UINT32 x)
     {
         UINT32 l = 0;
 
@@ -105,15 +140,15 @@ public:
     }
 
 private:
-    CoreCacheMap*   m_pCoreCache;
+    CoreCache*      m_pCoreCaches[CLU_MAX_CORES];
     gtVAddr         m_tagMask;
     UINT32          m_tagShift;
     gtVAddr         m_indexMask;
     UINT32          m_indexShift;
     gtVAddr         m_offsetMask;
     UINT32          m_offsetShift;
+    UINT32          m_numSets;
     bool            m_isInitialized;
-    UINT64          m_time;             // Used for LRU
     UINT8           m_l1DcAssoc;
     UINT8           m_l1DcSize;
     UINT8           m_l1DcLineSize;
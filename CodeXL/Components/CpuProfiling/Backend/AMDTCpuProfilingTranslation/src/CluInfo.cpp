@@ -8,11 +8,41 @@
 ///
 //==================================================================================
 
+#include <algorithm>
+#include <thread>
+
+#include <AMDTOSWrappers/Include/osThread.h>
+#include <AMDTOSWrappers/Include/osAtomic.h>
+#include <AMDTOSWrappers/Include/osTimeInterval.h>
+
 #include "CluInfo.h"
 #include "Cache.h"
 
-// Un-defining MAINTAIN_DATA will not store data accesses with sample data
-#define MAINTAIN_DATA
+#define CLU_WORKER_WAIT_MS  1000
+
+
+// Simulates the caches of the cores picked from CluInfo::m_simulatedCores
+class CluInfo::SimulationWorker : public osThread
+{
+public:
+    SimulationWorker(CluInfo& cluInfo, unsigned int id) :
+        osThread(gtString(L"CLU Simulation Worker [").appendUnsignedIntNumber(id).append(L']')),
+        m_cluInfo(cluInfo)
+    {
+    }
+
+    virtual ~SimulationWorker() {}
+
+protected:
+    virtual int entryPoint()
+    {
+        m_cluInfo.SimulateCores();
+        return 0;
+    }
+
+private:
+    CluInfo& m_cluInfo;
+};
 
 
 CluInfo::CluInfo(UINT8 l1DcAssoc,
@@ -33,6 +63,13 @@ CluInfo::CluInfo(UINT8 l1DcAssoc,
     m_l1DcLinesPerTag = l1DcLinesPerTag;
     m_l1DcSize = l1DcSize;
     m_pCache = NULL;
+    m_nextSimulatedCore = 0;
+    m_numQueuedAccesses = 0;
+
+    for (int i = 0; i < CLU_MAX_CORES; i++)
+    {
+        m_pCoreData[i] = NULL;
+    }
 }
 
 CluInfo::~CluInfo()
@@ -57,6 +94,15 @@ CluInfo::~CluInfo()
         delete m_pCache;
     }
 
+    for (int i = 0; i < CLU_MAX_CORES; i++)
+    {
+        if (NULL != m_pCoreData[i])
+        {
+            delete m_pCoreData[i];
+            m_pCoreData[i] = NULL;
+        }
+    }
+
     m_pCacheUtilMap = NULL;
     m_pCacheErrors = NULL;
     m_pModInfoMap = NULL;
@@ -388,7 +434,7 @@ void CluInfo::RecordCacheLdSt(IBSOpRecordData* ibsOpRec,
 {
     unsigned char size;
     bool bErr;
-    UINT32 modIndex;
+    UINT32 modIndex = MAX_UINT32;
 
     if (!Initialize())
     {
@@ -421,7 +467,7 @@ void CluInfo::RecordCacheLdSt(IBSOpRecordData* ibsOpRec,
 
     if (size < CA_DATA_SIZE_MAX)
     {
-        CacheEvent(ibsOpRec, size, isLoad, bErr, modIndex, false);
+        QueueCacheEvent(ibsOpRec, size, bErr, modIndex);
 
 #ifdef DEBUG_CACHE_EVENT
         PrintMemoryUsage("\nMemory Usage: After CacheEvent.\n");
@@ -433,27 +479,27 @@ void CluInfo::RecordCacheLdSt(IBSOpRecordData* ibsOpRec,
     switch (size)
     {
         case MODULE_NOT_IN_MAP: // Could not find module name in map
-            CacheEvent(ibsOpRec, CLU_DEFAULT_SIZE, isLoad, bErr, modIndex, false);
+            QueueCacheEvent(ibsOpRec, CLU_DEFAULT_SIZE, bErr, modIndex);
             break;
 
         case CANNOT_OPEN:       // Module could not be opened - path error?
-            CacheEvent(ibsOpRec, CLU_DEFAULT_SIZE, isLoad, bErr, modIndex, false);
+            QueueCacheEvent(ibsOpRec, CLU_DEFAULT_SIZE, bErr, modIndex);
             break;
 
         case OFFSET_OVERFLOW:   // RIP outside bounds of code segment
-            CacheEvent(ibsOpRec, CLU_DEFAULT_SIZE, isLoad, bErr, modIndex, false);
+            QueueCacheEvent(ibsOpRec, CLU_DEFAULT_SIZE, bErr, modIndex);
             break;
 
         case DISASM_FAILED:     // EtchDisassemble returned E_FAIL
-            CacheEvent(ibsOpRec, CLU_DEFAULT_SIZE, isLoad, bErr, modIndex, false);
+            QueueCacheEvent(ibsOpRec, CLU_DEFAULT_SIZE, bErr, modIndex);
             break;
 
         case NO_MEMOPS:         // The instruction had no memory operations
-            CacheEvent(ibsOpRec, CLU_DEFAULT_SIZE, isLoad, bErr, modIndex, false);
+            QueueCacheEvent(ibsOpRec, CLU_DEFAULT_SIZE, bErr, modIndex);
             break;
 
         case SIZE_ERROR:        // The parameter size was not in case statement
-            CacheEvent(ibsOpRec, CLU_DEFAULT_SIZE, isLoad, bErr, modIndex, false);
+            QueueCacheEvent(ibsOpRec, CLU_DEFAULT_SIZE, bErr, modIndex);
             break;
 
         default:
@@ -469,215 +515,285 @@ void CluInfo::RecordCacheLdSt(IBSOpRecordData* ibsOpRec,
     return;
 }
 
-void CluInfo::CacheEvent(IBSOpRecordData* ibsOpRec,
-                         unsigned char size,
-                         bool isLoad,
-                         bool bSizeUnknown,
-                         UINT32 modIndex,
-                         bool bSpansLines)
+void CluInfo::QueueCacheEvent(IBSOpRecordData* ibsOpRec,
+                              unsigned char size,
+                              bool bSizeUnknown,
+                              UINT32 modIndex)
 {
-    gtVAddr IbsDcPhysAd = ibsOpRec->m_IbsDcPhysAd;
     unsigned char ProcessorID = ibsOpRec->m_ProcessorID;
-    unsigned index = m_pCache->GetIndex(IbsDcPhysAd);
-    unsigned offset = m_pCache->GetOffset(IbsDcPhysAd);
-    CacheDataStuff* cacheDataStuff = nullptr;
+    CLUCoreData* pCoreData = m_pCoreData[ProcessorID];
 
-    // Check for access spanning 2 cache lines
-    if (m_pCache->SpansLines(offset, size))
+    if (NULL == pCoreData)
     {
-        unsigned char off = m_pCache->GetBytesPerLine() - static_cast<UINT8>(offset); // remaining bytes in 1st cache line
-        CacheEvent(ibsOpRec, off, isLoad, bSizeUnknown, modIndex, false);
-        // Adjust the address
-        ibsOpRec->m_IbsDcPhysAd += off;
-        ibsOpRec->m_IbsDcLinAd += off;
-        CacheEvent(ibsOpRec, size - off, isLoad, bSizeUnknown, modIndex, true);
-
-        // Re-adjust addresses
-        ibsOpRec->m_IbsDcPhysAd -= off;
-        ibsOpRec->m_IbsDcLinAd -= off;
+        // First access from this core - its cache is created now, while no simulation is running
+        if (NULL == m_pCache->GetCoreCache(ProcessorID))
+        {
+            return;
+        }
 
-        return;
+        pCoreData = new CLUCoreData;
+        m_pCoreData[ProcessorID] = pCoreData;
     }
 
-    if (CACHE_EVICTED == m_pCache->CacheAccess(IbsDcPhysAd, &cacheDataStuff, ProcessorID))
+    CLUAccess access;
+    access.physAddr = ibsOpRec->m_IbsDcPhysAd;
+    access.RIP = ibsOpRec->m_RIP;
+    access.PID = static_cast<UINT32>(ibsOpRec->m_PID);
+    access.TID = static_cast<UINT32>(ibsOpRec->m_ThreadHandle);
+    access.modIndex = modIndex;
+    access.size = size;
+    access.bSizeUnknown = bSizeUnknown;
+
+    pCoreData->accesses.push_back(access);
+
+    if (CLU_SIMULATION_BATCH_SIZE <= ++m_numQueuedAccesses)
     {
-        CacheLineEviction(*cacheDataStuff, index, ProcessorID);
+        SimulateCacheEvents();
     }
-
-    IncrCacheByteCount(*cacheDataStuff, ibsOpRec, size, offset, isLoad, bSizeUnknown, modIndex, bSpansLines);
 }
 
-void CluInfo::CacheLineCleanup()
+// The caches of the cores are independent, and so are the CLU data of the cores as the core
+// is a part of the CLU key. The queued accesses of each core are simulated in order by a
+// single thread, so the results do not depend on the number of threads.
+void CluInfo::SimulateCacheEvents()
 {
-    unsigned char core;
-    unsigned int index;
-    CacheDataStuff* data = NULL;
+    m_simulatedCores.clear();
 
-    if (!Initialize())
+    for (int core = 0; core < CLU_MAX_CORES; core++)
     {
-        return;
+        if (NULL != m_pCoreData[core] && !m_pCoreData[core]->accesses.empty())
+        {
+            m_simulatedCores.push_back(static_cast<unsigned char>(core));
+        }
     }
 
-    data = m_pCache->GetNextValidLine(core, index);
+    m_nextSimulatedCore = 0;
+
+    unsigned int numWorkers = std::min(static_cast<unsigned int>(m_simulatedCores.size()), std::thread::hardware_concurrency());
+    std::vector<SimulationWorker*> workers;
 
-    for (; NULL != data; data = m_pCache->GetNextValidLine(core, index))
+    for (unsigned int i = 1; i < numWorkers; i++)
     {
-        data->tot_evictions--;
-        CacheLineEviction(*data, index, core);
+        SimulationWorker* pWorker = new SimulationWorker(*this, i);
+
+        if (pWorker->execute())
+        {
+            workers.push_back(pWorker);
+        }
+        else
+        {
+            delete pWorker;
+        }
     }
+
+    SimulateCores();
+
+    osTimeInterval timeout;
+    timeout.setAsMilliSeconds(CLU_WORKER_WAIT_MS);
+
+    for (std::vector<SimulationWorker*>::iterator it = workers.begin(), itEnd = workers.end(); it != itEnd; ++it)
+    {
+        while ((*it)->isAlive())
+        {
+            (*it)->waitForThreadEnd(timeout);
+        }
+
+        delete *it;
+    }
+
+    m_numQueuedAccesses = 0;
 }
 
-void CluInfo::CacheLineEviction(CacheDataStuff& cData, unsigned int index, unsigned char core)
+void CluInfo::SimulateCores()
 {
-    cData.tot_evictions++;
+    gtInt32 numCores = static_cast<gtInt32>(m_simulatedCores.size());
+    gtInt32 item;
 
-    // When an eviction occurs on a line, be sure to put out all RIPs that accessed the line
+    while ((item = AtomicAdd(m_nextSimulatedCore, 1)) < numCores)
+    {
+        SimulateCore(m_simulatedCores[item]);
+    }
+}
 
-    PidRIPMap::iterator pidrip_it;
+void CluInfo::SimulateCore(unsigned char core)
+{
+    CLUCoreData& coreData = *m_pCoreData[core];
+    CoreCache& coreCache = *m_pCache->GetCoreCache(core);
 
-    // For each instruction that has accessed this line since the last eviction
-    for (pidrip_it = cData.pidripmap.begin(); pidrip_it != cData.pidripmap.end(); ++pidrip_it)
+    for (CLUAccessList::const_iterator it = coreData.accesses.begin(), itEnd = coreData.accesses.end(); it != itEnd; ++it)
     {
-        PidRIPKey prKey = pidrip_it->first; // <PID, TID, RIP>
-        CLUKey cluKey(core, prKey.PID, prKey.TID, prKey.RIP, index);
-        CLUData cluData;    // Constructor initializes this
-        UINT64 bitmap = pidrip_it->second.access_bitmap;    // bitmap of accessed bytes for this instruction
-        cData.access_bitmap |= bitmap;  // Not sure if this is valuable.  All bytes accessed by all instructions since last eviction
+        CacheEvent(coreData, coreCache, core, *it, it->physAddr, it->size, false);
+    }
 
-        bitmap = m_pCache->CountBits(bitmap);
+    coreData.accesses.clear();
+}
 
-        // See if this PID/TID/RIP previously accessed this cache line on this core
-        CLUMap::iterator cluMap_it = m_pCacheUtilMap->find(cluKey);
+void CluInfo::CacheEvent(CLUCoreData& coreData,
+                         CoreCache& coreCache,
+                         unsigned char core,
+                         const CLUAccess& access,
+                         gtVAddr physAddr,
+                         unsigned char size,
+                         bool bSpansLines)
+{
+    unsigned index = m_pCache->GetIndex(physAddr);
+    unsigned offset = m_pCache->GetOffset(physAddr);
+    CacheDataStuff* cacheDataStuff = nullptr;
 
-        if (cluMap_it == m_pCacheUtilMap->end())
-        {
-            cluMap_it = m_pCacheUtilMap->insert(std::pair <CLUKey, CLUData > (cluKey, cluData)).first;
-        }
+    // Check for access spanning 2 cache lines
+    if (m_pCache->SpansLines(offset, size))
+    {
+        unsigned char off = m_pCache->GetBytesPerLine() - static_cast<UINT8>(offset); // remaining bytes in 1st cache line
+        CacheEvent(coreData, coreCache, core, access, physAddr, off, false);
+        CacheEvent(coreData, coreCache, core, access, physAddr + off, size - off, true);
+        return;
+    }
 
-        // Update data for the instruction
-        cluMap_it->second.byteMask |= pidrip_it->second.access_bitmap;
-        cluMap_it->second.tot_evictions++;  // Increment # evictions
+    if (CACHE_EVICTED == coreCache.CacheAccess(index, m_pCache->GetTag(physAddr), &cacheDataStuff))
+    {
+        CacheLineEviction(coreData.cluData, *cacheDataStuff, index, core);
+    }
 
-        UINT64 result = 0;
+    IncrCacheByteCount(*cacheDataStuff, access, core, size, offset, bSpansLines);
+}
 
-        result = std::min(bitmap, (UINT64)cluMap_it->second.min_bytes);
-        cluMap_it->second.min_bytes = static_cast<UINT8>(result);
+void CluInfo::CacheLineCleanup()
+{
+    if (!Initialize())
+    {
+        return;
+    }
 
-        result = std::max(bitmap, (UINT64)cluMap_it->second.max_bytes);
-        cluMap_it->second.max_bytes = static_cast<UINT8>(result);
+    SimulateCacheEvents();
 
-        cluMap_it->second.bSizeUnknown = pidrip_it->second.bSizeUnknown;
-        cluMap_it->second.tot_rw += pidrip_it->second.rw_bytes;
-        cluMap_it->second.num_rw += pidrip_it->second.rw_count;
-        cluMap_it->second.modIndex = pidrip_it->second.modIndex;
-        cluMap_it->second.SpanCount += pidrip_it->second.SpanCount;
-        cluMap_it->second.sumMax += static_cast<UINT32>(bitmap);
+    // The lines still in the cache are flushed as if they were evicted.
+    // Like the original cache model, this only flushes the lines of the first core.
+    unsigned char core;
 
-#ifdef MAINTAIN_DATA
-        AddrMap::iterator amit = pidrip_it->second.dataAddresses.begin();
+    if (m_pCache->GetFirstCore(core) && NULL != m_pCoreData[core])
+    {
+        CoreCache* pCoreCache = m_pCache->GetCoreCache(core);
+        CLUHashMap& cluData = m_pCoreData[core]->cluData;
 
-        for (; amit != pidrip_it->second.dataAddresses.end(); ++amit)
+        for (UINT32 index = 0; index < pCoreCache->GetNumSets(); index++)
         {
-            AddrMap::iterator amit2 = cluMap_it->second.dataAddresses.find(amit->first);
+            UINT32 numLines;
+            CacheDataStuff* pLines = pCoreCache->GetSetLines(index, numLines);
 
-            if (amit2 != cluMap_it->second.dataAddresses.end())
-            {
-                amit2->second.splice(amit2->second.end(), amit->second);
-            }
-            else
+            for (UINT32 i = 0; i < numLines; i++)
             {
-                cluMap_it->second.dataAddresses.insert(AddrMap::value_type(amit->first, amit->second));
+                CacheLineEviction(cluData, pLines[i], index, core);
             }
         }
 
-        pidrip_it->second.dataAddresses.clear();
-#endif
+        pCoreCache->Clear();
+    }
+
+    // Fill the CLU data map
+    m_pCacheUtilMap->clear();
+
+    for (int i = 0; i < CLU_MAX_CORES; i++)
+    {
+        if (NULL == m_pCoreData[i])
+        {
+            continue;
+        }
 
-        // Update data for the line
-        result = std::max(bitmap, (UINT64)cData.max_bytes);
-        cData.max_bytes = static_cast<UINT8>(result);
+        for (CLUHashMap::const_iterator it = m_pCoreData[i]->cluData.begin(), itEnd = m_pCoreData[i]->cluData.end(); it != itEnd; ++it)
+        {
+            const CLUCounters& counters = it->second;
+            CLUData data;   // Constructor initializes this
+
+            data.tot_rw = counters.tot_rw;
+            data.tot_evictions = counters.tot_evictions;
+            data.byteMask = counters.byteMask;
+            data.sumMax = counters.sumMax;
+            data.num_rw = counters.num_rw;
+            data.modIndex = counters.modIndex;
+            data.SpanCount = counters.SpanCount;
+            data.min_bytes = counters.min_bytes;
+            data.max_bytes = counters.max_bytes;
+            data.bSizeUnknown = counters.bSizeUnknown;
+
+            m_pCacheUtilMap->insert(CLUMap::value_type(it->first, data));
+        }
+    }
+}
 
-        result = std::min(bitmap, (UINT64)cData.min_bytes);
-        cData.min_bytes = static_cast<UINT8>(result);
+void CluInfo::CacheLineEviction(CLUHashMap& cluData, CacheDataStuff& cData, unsigned int index, unsigned char core)
+{
+    // When an eviction occurs on a line, be sure to put out all RIPs that accessed the line
+
+    // For each instruction that has accessed this line since the last eviction
+    for (PidRIPList::const_iterator pidrip_it = cData.pidrips.begin(); pidrip_it != cData.pidrips.end(); ++pidrip_it)
+    {
+        const PidRIPKey& prKey = pidrip_it->key; // <PID, TID, RIP>
+        const PidRIPData& prData = pidrip_it->data;
+        CLUKey cluKey(core, prKey.PID, prKey.TID, prKey.RIP, index);
+        UINT64 bitmap = Cache::CountBits(prData.access_bitmap);    // number of accessed bytes for this instruction
+
+        // See if this PID/TID/RIP previously accessed this cache line on this core
+        CLUCounters& counters = cluData[cluKey];
+
+        // Update data for the instruction
+        counters.byteMask |= prData.access_bitmap;
+        counters.tot_evictions++;  // Increment # evictions
+
+        UINT64 result = 0;
 
-        cData.tot_rw += pidrip_it->second.rw_count;
-        cData.tot_rw_bytes += pidrip_it->second.rw_bytes;
+        result = std::min(bitmap, (UINT64)counters.min_bytes);
+        counters.min_bytes = static_cast<UINT8>(result);
+
+        result = std::max(bitmap, (UINT64)counters.max_bytes);
+        counters.max_bytes = static_cast<UINT8>(result);
+
+        counters.bSizeUnknown = prData.bSizeUnknown;
+        counters.tot_rw += prData.rw_bytes;
+        counters.num_rw += prData.rw_count;
+        counters.modIndex = prData.modIndex;
+        counters.SpanCount += prData.SpanCount;
+        counters.sumMax += static_cast<UINT32>(bitmap);
     }
 
-    cData.pidripmap.clear();
+    cData.pidrips.clear();
 }
 
 void CluInfo::IncrCacheByteCount(CacheDataStuff& cacheData,
-                                 IBSOpRecordData* ibsOpRec,
+                                 const CLUAccess& access,
+                                 unsigned char core,
                                  unsigned char size,
                                  unsigned int offset,
-                                 bool isLoad,
-                                 bool bSizeUnknown,
-                                 UINT32 modIndex,
                                  bool bSpansLines)
 {
-    GT_UNREFERENCED_PARAMETER(isLoad);
-
-    UINT32 PID = static_cast<UINT32>(ibsOpRec->m_PID);
-    gtVAddr RIP = ibsOpRec->m_RIP;
-    UINT32 TID = static_cast<UINT32>(ibsOpRec->m_ThreadHandle);
-    UINT8 core = ibsOpRec->m_ProcessorID;
     UINT64 bitmap = (1 << size) - 1;    // Number of bits in low-order bits
     bitmap <<= 64 - offset - size;
 
-    PidRIPMap::iterator it = cacheData.pidripmap.find(PidRIPKey(PID, TID, RIP, core));
+    PidRIPKey key(access.PID, access.TID, access.RIP, core);
+    PidRIPList::iterator it = std::find_if(cacheData.pidrips.begin(), cacheData.pidrips.end(),
+                                           [&key](const PidRIPEntry & entry) { return entry.key == key; });
 
-    if (it == cacheData.pidripmap.end())
+    if (it == cacheData.pidrips.end())
     {
-        PidRIPData pidrip_data;
-        pidrip_data.access_bitmap = 0;
-        pidrip_data.bSizeUnknown = bSizeUnknown;
-        pidrip_data.modIndex = modIndex;
-        pidrip_data.rw_count = 0;
-        pidrip_data.rw_bytes = 0;
-        pidrip_data.SpanCount = 0;
-
-        PidRIPKey key(PID, TID, RIP, core);
+        PidRIPEntry entry(key);
+        entry.data.bSizeUnknown = access.bSizeUnknown;
+        entry.data.modIndex = access.modIndex;
 
-        it = cacheData.pidripmap.insert(std::pair < PidRIPKey, PidRIPData > (key, pidrip_data)).first;
+        it = cacheData.pidrips.insert(cacheData.pidrips.end(), entry);
     }
 
-    it->second.rw_bytes += size;
-    it->second.access_bitmap |= bitmap;
+    it->data.rw_bytes += size;
+    it->data.access_bitmap |= bitmap;
 
     // bSpansLines is true for the second half of a spanning access.
-    // The first half incremented the number of R/W accesses and added
-    // the VADDR of the access.
+    // The first half incremented the number of R/W accesses.
 
     if (!bSpansLines)
     {
-        UINT32 isRemote;
-
-        isRemote = ibsOpRec->m_NbIbsReqSrc ? ibsOpRec->m_NbIbsReqDstProc : 0;
-
-        it->second.rw_count++;
-
-        AddrMapKey key(ibsOpRec->m_IbsDcLinAd, ibsOpRec->m_IbsDcPhysAd);
-
-#ifdef MAINTAIN_DATA
-        AddrMap::iterator prit = it->second.dataAddresses.find(key);
-
-        if (prit == it->second.dataAddresses.end())
-        {
-            AddrData tsVec;
-            tsVec.push_back(TimeStampType(ibsOpRec->m_DeltaTick, isRemote));
-            it->second.dataAddresses.insert(AddrMap::value_type(key, tsVec));
-        }
-        else
-        {
-            prit->second.push_back(TimeStampType(ibsOpRec->m_DeltaTick, isRemote));
-        }
-
-#endif
+        it->data.rw_count++;
     }
     else
     {
-        it->second.SpanCount++;
+        it->data.SpanCount++;
     }
 }
 
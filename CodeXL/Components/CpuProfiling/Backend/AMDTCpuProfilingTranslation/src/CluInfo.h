@@ -15,6 +15,7 @@
 #include <cstdlib>
 #include <map>
 #include <list>
+#include <vector>
 
 #include <AMDTCpuProfilingRawData/inc/Windows/PRDReader.h>
 #include <AMDTCpuProfilingRawData/inc/CpuProfileDataTranslationInfo.h>
@@ -22,6 +23,7 @@
 #include <AMDTExecutableFormat/inc/PeFile.h>
 #include <AMDTDisassembler/inc/LibDisassembler.h>
 #include <CXLTaskInfo/inc/TaskInfoInterface.h>
+#include <AMDTBaseTools/Include/gtHashMap.h>
 
 #define MAX_UINT64 0xffffffffffffffffui64
 #define MAX_UINT32 0xffffffffU
@@ -86,7 +88,6 @@ struct PidRIPData
         modIndex = MAX_UINT32;
         SpanCount = 0;
         bSizeUnknown = 0;
-        dataAddresses.clear();
     }
 
     UINT64  access_bitmap;  // bitmap of bytes accessed by this instruction
@@ -95,7 +96,6 @@ struct PidRIPData
     UINT32  modIndex;       // The index of the module for which this RIP belongs
     UINT32  SpanCount;      // Number of times an access crossed cache line boundaries
     bool    bSizeUnknown;   // Size of operation can't be determined by disassembler
-    AddrMap dataAddresses;  // All VA's of the data accesses and timestamps
 };
 
 struct PidRIPKey
@@ -133,13 +133,27 @@ struct PidRIPKey
         return false;
     };
 
+    bool operator== (const PidRIPKey& other) const
+    {
+        return (other.RIP == this->RIP) && (other.TID == this->TID) && (other.PID == this->PID) && (other.core == this->core);
+    };
+
     UINT32  PID;
     UINT32  TID;
     gtVAddr RIP;
     UINT8   core;
 };
 
-typedef std::map< PidRIPKey, PidRIPData > PidRIPMap; // Key is PID/RIP
+struct PidRIPEntry
+{
+    PidRIPEntry(const PidRIPKey& _key) : key(_key) {};
+
+    PidRIPKey   key;
+    PidRIPData  data;
+};
+
+// A line is accessed by a few instructions between evictions, so they are searched linearly
+typedef std::vector< PidRIPEntry > PidRIPList;
 
 
 struct CacheDataStuff   // "For each cache line" data
@@ -147,29 +161,14 @@ struct CacheDataStuff   // "For each cache line" data
     CacheDataStuff()
     {
         tag = 0;
-        access_bitmap = 0;
-        tot_rw_bytes = 0;
-        tot_rw = 0;
-        tot_evictions = 0;
-        min_bytes = MAX_UINT8;
-        max_bytes = 0;
+        timestamp = 0;
     };
 
     UINT64      tag;            // Cache line tag
-    UINT64      access_bitmap;  // bitmap of bytes accessed in the line, full run
-    UINT64      tot_rw_bytes;   // # bytes read / written - total for this line, full run
     UINT64      timestamp;      // Used for LRU determination
-    PidRIPMap   pidripmap;      // Instructions accessing this line
-    UINT32      tot_rw;         // # reads / writes - total for this line, full run
-    UINT32      tot_evictions;  // # times this line was evicted - total, full run
-    UINT8       min_bytes;      // Minimum access size in bytes
-    UINT8       max_bytes;      // Maximum access size in bytes
+    PidRIPList  pidrips;        // Instructions accessing this line since the last eviction
 };
 
-typedef std::multimap<unsigned int, CacheDataStuff > CacheMap;   // Key is the cache index (phy addr[14:6]), data is cache lines
-
-typedef std::map<unsigned char, CacheMap > CoreCacheMap;     // Key is processor core
-
 
 
 struct CLUKey
@@ -213,6 +212,12 @@ struct CLUKey
         return false;
     };
 
+    bool operator== (const CLUKey& other) const
+    {
+        return (other.RIP == this->RIP) && (other.cache_line == this->cache_line) && (other.ThreadID == this->ThreadID) &&
+               (other.ProcessID == this->ProcessID) && (other.core == this->core);
+    };
+
     gtVAddr         RIP;
     ProcessIdType   ProcessID;
     ThreadIdType    ThreadID;
@@ -220,6 +225,21 @@ struct CLUKey
     UINT32          core;
 };
 
+namespace std
+{
+template <>
+struct hash<CLUKey>
+{
+    size_t operator()(const CLUKey& key) const
+    {
+        UINT64 value = key.RIP;
+        value = (value * 31) ^ ((static_cast<UINT64>(key.ProcessID) << 32) | key.ThreadID);
+        value = (value * 31) ^ ((static_cast<UINT64>(key.core) << 32) | key.cache_line);
+        return std::hash<UINT64>()(value);
+    }
+};
+}
+
 struct CLUData
 {
     CLUData()
@@ -308,6 +328,59 @@ struct CLUData
 
 typedef std::map<CLUKey, CLUData > CLUMap;
 
+// The counters of CLUData, as aggregated by the cache simulation of a core
+struct CLUCounters
+{
+    CLUCounters()
+    {
+        tot_rw = 0;
+        tot_evictions = 0;
+        byteMask = 0;
+        sumMax = 0;
+        num_rw = 0;
+        modIndex = MAX_UINT32;
+        SpanCount = 0;
+        min_bytes = MAX_UINT8;
+        max_bytes = 0;
+        bSizeUnknown = 0;
+    };
+
+    UINT64  tot_rw;
+    UINT64  tot_evictions;
+    UINT64  byteMask;
+    UINT32  sumMax;
+    UINT32  num_rw;
+    UINT32  modIndex;
+    UINT32  SpanCount;
+    UINT8   min_bytes;
+    UINT8   max_bytes;
+    UINT8   bSizeUnknown;
+};
+
+typedef gtHashMap<CLUKey, CLUCounters > CLUHashMap;
+
+
+// A data cache access, queued for the cache simulation of its core
+struct CLUAccess
+{
+    gtVAddr physAddr;
+    gtVAddr RIP;
+    UINT32  PID;
+    UINT32  TID;
+    UINT32  modIndex;
+    UINT8   size;
+    bool    bSizeUnknown;
+};
+
+typedef std::vector<CLUAccess > CLUAccessList;
+
+// The queued accesses of a core and the CLU data of its evictions
+struct CLUCoreData
+{
+    CLUAccessList   accesses;
+    CLUHashMap      cluData;
+};
+
 
 struct CLUripData
 {
@@ -342,7 +415,14 @@ typedef std::map<unsigned char, CLUERRData > CLUErrorMap;
 // On error, assume the access was this size
 #define CLU_DEFAULT_SIZE        4
 
+// Number of cores the core id of an IBS record can address
+#define CLU_MAX_CORES               256
+
+// The accesses are simulated in batches of about this many accesses, one thread per core
+#define CLU_SIMULATION_BATCH_SIZE   (256 * 1024)
+
 class Cache;
+class CoreCache;
 
 class CluInfo
 {
@@ -364,6 +444,7 @@ public:
                          NameModuleMap* pMMap,
                          bool isLoad);
 
+    // Simulates the queued accesses, flushes the cache and fills the CLU data map
     void CacheLineCleanup();
 
     double GetAvgUtil()
@@ -377,13 +458,13 @@ public:
     }
 
 private:
+    class SimulationWorker;
+
     void IncrCacheByteCount(CacheDataStuff& cData,
-                            IBSOpRecordData* ibsOpRec,
+                            const CLUAccess& access,
+                            unsigned char core,
                             unsigned char size,
                             unsigned int offset,
-                            bool isLoad,
-                            bool isUnaligned,
-                            UINT32 modIndex,
                             bool bSpansLines);
 
     unsigned char GetOperationSize(gtVAddr RIP,
@@ -393,20 +474,34 @@ private:
                                    bool& bErr,
                                    UINT32* modIndex);
 
-    void CacheEvent(IBSOpRecordData* ibsOpRec,
+    void QueueCacheEvent(IBSOpRecordData* ibsOpRec,
+                         unsigned char size,
+                         bool bSizeUnknown,
+                         UINT32 modIndex);
+
+    void CacheEvent(CLUCoreData& coreData,
+                    CoreCache& coreCache,
+                    unsigned char core,
+                    const CLUAccess& access,
+                    gtVAddr physAddr,
                     unsigned char size,
-                    bool isLoad,
-                    bool isUnaligned,
-                    UINT32 modIndex,
                     bool bSpansLines);
 
-    void CacheLineEviction(CacheDataStuff& cData, unsigned int index, unsigned char core);
+    void CacheLineEviction(CLUHashMap& cluData, CacheDataStuff& cData, unsigned int index, unsigned char core);
+
+    void SimulateCacheEvents();
+    void SimulateCores();
+    void SimulateCore(unsigned char core);
 
     void AddToErrorMap(unsigned char err, gtVAddr RIPx, const char* mnemx);
 
     bool Initialize();
 
     Cache*          m_pCache;
+    CLUCoreData*    m_pCoreData[CLU_MAX_CORES];
+    std::vector<unsigned char> m_simulatedCores;
+    volatile gtInt32 m_nextSimulatedCore;
+    UINT32          m_numQueuedAccesses;
     CLUMap*         m_pCacheUtilMap;
     CLUErrorMap*    m_pCacheErrors;
     CLUModInfoMap*  m_pModInfoMap;
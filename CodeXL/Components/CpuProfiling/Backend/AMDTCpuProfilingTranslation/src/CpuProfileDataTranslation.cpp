@@ -105,6 +105,26 @@ static HRESULT helpHandlePrdFile(const wchar_t* pFilePath, ReaderHandle** pReade
 #endif // AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
 
 #if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+// The samples are translated, the call stacks built and the sampled modules preloaded on all the online CPUs,
+// unless CODEXL_CPU_TRANS_THREADS gives the number of threads. 1 translates everything on the calling thread.
+static void helpSetupTranslationThreads(CaPerfTranslator* pTrans)
+{
+    gtString envVal;
+    unsigned int numThreads = 0;
+
+    if (osGetCurrentProcessEnvVariableValue(L"CODEXL_CPU_TRANS_THREADS", envVal) && envVal.toUnsignedIntNumber(numThreads))
+    {
+        pTrans->setupNumWorkerThreads(numThreads);
+        pTrans->setupNumCssThreads(numThreads);
+        pTrans->setupNumPreloadThreads(numThreads);
+
+        if (1 == numThreads)
+        {
+            pTrans->setupModulePreload(false);
+        }
+    }
+}
+
 static HRESULT helpHandleCaPerfFile(const wchar_t* pFilePath, ReaderHandle** pReaderHandle)
 {
     HRESULT hr = S_OK;
@@ -118,6 +138,9 @@ static HRESULT helpHandleCaPerfFile(const wchar_t* pFilePath, ReaderHandle** pRe
         return E_OUTOFMEMORY;
     }
 
+    pTrans->setupTranslateMode(CaPerfTranslator::PASS2_MODE_PARALLEL);
+    helpSetupTranslationThreads(pTrans);
+
     *pReaderHandle = static_cast<ReaderHandle*>(pTrans);
     g_validReaders.push_back(*pReaderHandle);
 
@@ -170,6 +193,64 @@ HRESULT fnOpenProfile(
     return hr;
 }
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+HRESULT fnOpenOnlineProfile(
+    /*in*/ const wchar_t* pPath,
+    /*in*/ const wchar_t* pDbFilePath,
+    /*out*/ ReaderHandle** pReaderHandle)
+{
+    if ((NULL == pReaderHandle) || (NULL == pPath))
+    {
+        return E_INVALIDARG;
+    }
+
+    if ((NULL != *pReaderHandle) && (helpCheckValidReader(*pReaderHandle)))
+    {
+        return E_HANDLE;
+    }
+
+    // The file does not exist yet, the profiling has not started
+    gtString path = pPath;
+    CaPerfTranslator* pTrans = new CaPerfTranslator(path.asASCIICharArray());
+
+    if (NULL == pTrans)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    helpSetupTranslationThreads(pTrans);
+
+    gtString dbPath;
+
+    if (NULL != pDbFilePath)
+    {
+        dbPath = pDbFilePath;
+    }
+
+    HRESULT hr = pTrans->startOnlineTranslation(dbPath.asASCIICharArray());
+
+    if (S_OK != hr)
+    {
+        delete pTrans;
+        return hr;
+    }
+
+    *pReaderHandle = static_cast<ReaderHandle*>(pTrans);
+    g_validReaders.push_back(*pReaderHandle);
+
+    return S_OK;
+}
+
+void fnOnlineTranslationSampleData(
+    /*in*/ const void* pData,
+    /*in*/ size_t size,
+    /*in*/ void* pReaderHandle)
+{
+    // Called by the profiling thread for every read of the sampling buffers, so the handle is not looked up
+    static_cast<CaPerfTranslator*>(pReaderHandle)->addOnlineRecords(pData, size);
+}
+#endif // AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
 HRESULT fnCloseProfile(
     /*in*/ ReaderHandle** pReaderHandle)
 {
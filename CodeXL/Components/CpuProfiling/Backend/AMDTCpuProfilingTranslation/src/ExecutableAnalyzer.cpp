@@ -20,21 +20,126 @@ static inline bool IsFunctionExitPoint(const CInstr_Table& inst)
             (evIretdSpecies  == inst.InstSpecies));
 }
 
-ExecutableAnalyzer::ExecutableAnalyzer(ExecutableFile& exe) : m_exe(exe), m_pDasm(new CDisasmwrapper())
+AnalyzedCode::AnalyzedCode(gtRVAddr entryPoint) : m_pDasm(new CDisasmwrapper())
 {
     FunctionSymbolInfo func;
-    func.m_rva = m_exe.GetEntryPoint();
+    func.m_rva = entryPoint;
     func.m_size = 0;
     func.m_pName = const_cast<wchar_t*>(L"!EntryPoint");
 
     m_functions.insert(func);
 }
 
-ExecutableAnalyzer::~ExecutableAnalyzer()
+AnalyzedCode::~AnalyzedCode()
 {
     delete m_pDasm;
 }
 
+gtUInt32 AnalyzedCode::GetFunctionsCount() const
+{
+    m_mapLock.lockRead();
+    gtUInt32 count = static_cast<gtUInt32>(m_functions.size());
+    m_mapLock.unlockRead();
+    return count;
+}
+
+
+bool AnalyzedCodeCache::ImageKey::operator<(const ImageKey& other) const
+{
+    if (m_signature != other.m_signature)
+    {
+        return m_signature < other.m_signature;
+    }
+
+    if (m_size != other.m_size)
+    {
+        return m_size < other.m_size;
+    }
+
+    return m_path < other.m_path;
+}
+
+AnalyzedCodeCache::AnalyzedCodeCache() : m_numAcquired(0U)
+{
+}
+
+AnalyzedCodeCache::~AnalyzedCodeCache()
+{
+    Clear();
+}
+
+AnalyzedCode& AnalyzedCodeCache::Acquire(const ExecutableFile& exe)
+{
+    ImageKey key;
+    key.m_path = exe.GetFilePath();
+    key.m_signature = exe.GetSignature();
+    key.m_size = exe.GetImageSize();
+
+    m_lock.enter();
+
+    AnalyzedCode*& pCode = m_images[key];
+
+    if (nullptr == pCode)
+    {
+        pCode = new AnalyzedCode(exe.GetEntryPoint());
+    }
+
+    m_numAcquired++;
+
+    m_lock.leave();
+
+    return *pCode;
+}
+
+void AnalyzedCodeCache::Clear()
+{
+    m_lock.enter();
+
+    for (gtMap<ImageKey, AnalyzedCode*>::iterator it = m_images.begin(), itEnd = m_images.end(); it != itEnd; ++it)
+    {
+        delete it->second;
+    }
+
+    m_images.clear();
+    m_numAcquired = 0U;
+
+    m_lock.leave();
+}
+
+void AnalyzedCodeCache::GetStatistics(gtUInt32& numImages, gtUInt32& numAcquired, gtUInt64& numFunctions) const
+{
+    m_lock.enter();
+
+    numImages = static_cast<gtUInt32>(m_images.size());
+    numAcquired = m_numAcquired;
+    numFunctions = 0ULL;
+
+    for (gtMap<ImageKey, AnalyzedCode*>::const_iterator it = m_images.begin(), itEnd = m_images.end(); it != itEnd; ++it)
+    {
+        numFunctions += it->second->GetFunctionsCount();
+    }
+
+    m_lock.leave();
+}
+
+
+ExecutableAnalyzer::ExecutableAnalyzer(ExecutableFile& exe) : m_exe(exe),
+    m_pOwnCode(new AnalyzedCode(exe.GetEntryPoint())),
+    m_code(*m_pOwnCode)
+{
+}
+
+ExecutableAnalyzer::ExecutableAnalyzer(ExecutableFile& exe, AnalyzedCode& sharedCode) : m_exe(exe),
+    m_pOwnCode(nullptr),
+    m_code(sharedCode)
+{
+}
+
+ExecutableAnalyzer::~ExecutableAnalyzer()
+{
+    delete m_pOwnCode;
+}
+
 bool ExecutableAnalyzer::AnalyzeIsSystemCall(gtVAddr va)
 {
     bool ret;
@@ -42,9 +147,9 @@ bool ExecutableAnalyzer::AnalyzeIsSystemCall(gtVAddr va)
     gtRVAddr rva = m_exe.VaToRva(va);
     AnalyzeCodeRva(rva);
 
-    m_mapLock.lockRead();
+    m_code.m_mapLock.lockRead();
     ret = IsSystemCall(rva);
-    m_mapLock.unlockRead();
+    m_code.m_mapLock.unlockRead();
 
     return ret;
 }
@@ -65,11 +170,11 @@ gtSet<FunctionSymbolInfo>::const_iterator ExecutableAnalyzer::AnalyzeCodeRva(gtR
     func.m_size = 0;
     func.m_pName = nullptr;
 
-    m_mapLock.lockRead();
-    itContainingFunc = m_functions.end();
-    gtSet<FunctionSymbolInfo>::const_iterator itFuncUpper = m_functions.upper_bound(func);
+    m_code.m_mapLock.lockRead();
+    itContainingFunc = m_code.m_functions.end();
+    gtSet<FunctionSymbolInfo>::const_iterator itFuncUpper = m_code.m_functions.upper_bound(func);
 
-    if (m_functions.begin() != itFuncUpper)
+    if (m_code.m_functions.begin() != itFuncUpper)
     {
         gtSet<FunctionSymbolInfo>::const_iterator itFuncLower = itFuncUpper;
         --itFuncLower;
@@ -107,18 +212,18 @@ gtSet<FunctionSymbolInfo>::const_iterator ExecutableAnalyzer::AnalyzeCodeRva(gtR
         // If we have an upper bound function, then use it as a limit for the function's size.
         //
 
-        if (m_functions.end() != itFuncUpper)
+        if (m_code.m_functions.end() != itFuncUpper)
         {
             func.m_size = itFuncUpper->m_rva - func.m_rva;
         }
 
-        m_mapLock.unlockRead();
+        m_code.m_mapLock.unlockRead();
 
         DisassembleContainingFunctionExcept(rva, func, itContainingFunc);
     }
     else
     {
-        m_mapLock.unlockRead();
+        m_code.m_mapLock.unlockRead();
     }
 
     return itContainingFunc;
@@ -128,9 +233,9 @@ bool ExecutableAnalyzer::IsSystemCall(gtRVAddr rva) const
 {
     bool ret = false;
 
-    gtSet<gtRVAddr>::const_iterator itSysCall = m_systemCalls.upper_bound(rva);
+    gtSet<gtRVAddr>::const_iterator itSysCall = m_code.m_systemCalls.upper_bound(rva);
 
-    if (m_systemCalls.begin() != itSysCall)
+    if (m_code.m_systemCalls.begin() != itSysCall)
     {
         --itSysCall;
 
@@ -162,9 +267,9 @@ const FunctionSymbolInfo* ExecutableAnalyzer::FindAnalyzedFunction(gtVAddr va, b
     {
         gtSet<FunctionSymbolInfo>::const_iterator itFunc = AnalyzeCodeRva(rva);
 
-        m_mapLock.lockRead();
+        m_code.m_mapLock.lockRead();
 
-        if (m_functions.end() != itFunc)
+        if (m_code.m_functions.end() != itFunc)
         {
             pFunc = &(*itFunc);
 
@@ -175,7 +280,7 @@ const FunctionSymbolInfo* ExecutableAnalyzer::FindAnalyzedFunction(gtVAddr va, b
 
             if ((pFunc->m_rva + pFunc->m_size) <= rva)
             {
-                gtSet<FunctionSymbolInfo>::const_iterator itFuncBegin = m_functions.begin();
+                gtSet<FunctionSymbolInfo>::const_iterator itFuncBegin = m_code.m_functions.begin();
 
                 while (itFuncBegin != itFunc)
                 {
@@ -202,7 +307,7 @@ const FunctionSymbolInfo* ExecutableAnalyzer::FindAnalyzedFunction(gtVAddr va, b
             }
         }
 
-        m_mapLock.unlockRead();
+        m_code.m_mapLock.unlockRead();
     }
 
     return pFunc;
@@ -216,21 +321,26 @@ bool ExecutableAnalyzer::AddFunctionEntry(gtRVAddr rva)
     func.m_size = 0;
     func.m_pName = nullptr;
 
-    m_mapLock.lockWrite();
-    ret = m_functions.insert(func).second;
-    m_mapLock.unlockWrite();
+    m_code.m_mapLock.lockWrite();
+    ret = m_code.m_functions.insert(func).second;
+    m_code.m_mapLock.unlockWrite();
     return ret;
 }
 
 bool ExecutableAnalyzer::AddFunction(FunctionSymbolInfo& func, gtSet<FunctionSymbolInfo>::const_iterator& itAddedFunc)
 {
     bool ret = true;
-    m_mapLock.lockWrite();
+    m_code.m_mapLock.lockWrite();
 
-    std::pair<gtSet<FunctionSymbolInfo>::iterator, bool> pairib = m_functions.insert(func);
+    std::pair<gtSet<FunctionSymbolInfo>::iterator, bool> pairib = m_code.m_functions.insert(func);
     itAddedFunc = pairib.first;
 
-    if (!pairib.second)
+    if (pairib.second)
+    {
+        FunctionSymbolInfo& funcSet = const_cast<FunctionSymbolInfo&>(*pairib.first);
+        funcSet.m_pName = CopyFunctionName(func.m_pName);
+    }
+    else
     {
         FunctionSymbolInfo& funcSet = const_cast<FunctionSymbolInfo&>(*pairib.first);
 
@@ -241,7 +351,7 @@ bool ExecutableAnalyzer::AddFunction(FunctionSymbolInfo& func, gtSet<FunctionSym
             // This prevents us from overriding preallocated names.
             if (nullptr != func.m_pName)
             {
-                funcSet.m_pName = func.m_pName;
+                funcSet.m_pName = CopyFunctionName(func.m_pName);
             }
         }
         else
@@ -250,10 +360,24 @@ bool ExecutableAnalyzer::AddFunction(FunctionSymbolInfo& func, gtSet<FunctionSym
         }
     }
 
-    m_mapLock.unlockWrite();
+    m_code.m_mapLock.unlockWrite();
     return ret;
 }
 
+// Must be called while holding the write lock of the map.
+wchar_t* ExecutableAnalyzer::CopyFunctionName(const wchar_t* pName)
+{
+    wchar_t* pCopy = nullptr;
+
+    if (nullptr != pName)
+    {
+        m_code.m_names.push_back(gtString(pName));
+        pCopy = const_cast<wchar_t*>(m_code.m_names.back().asCharArray());
+    }
+
+    return pCopy;
+}
+
 void ExecutableAnalyzer::DisassembleContainingFunctionExcept(gtRVAddr rva, FunctionSymbolInfo& func,
                                                              gtSet<FunctionSymbolInfo>::const_iterator& itContainingFunc)
 {
@@ -427,7 +551,8 @@ bool ExecutableAnalyzer::DisassembleBasicBlock(const gtUByte* pCode, const gtUBy
     while (pCode < pCodeEnd)
     {
         const CInstr_Table* pInst;
-        int instLength = Decode(pCode, pInst);
+        gtInt64 displacement;
+        int instLength = Decode(pCode, pInst, displacement);
 
         if (0 >= instLength)
         {
@@ -448,7 +573,7 @@ bool ExecutableAnalyzer::DisassembleBasicBlock(const gtUByte* pCode, const gtUBy
             {
                 if (J == pInst->OpField1.AddrMethod)
                 {
-                    int offset = static_cast<int>(m_pDasm->GetDisplacement()) + instLength + static_cast<int>(pCode - pCodeBegin);
+                    int offset = static_cast<int>(displacement) + instLength + static_cast<int>(pCode - pCodeBegin);
                     gtRVAddr targetRva = func.m_rva + static_cast<gtRVAddr>(static_cast<gtInt32>(offset));
                     AddFunctionEntry(targetRva);
 
@@ -510,7 +635,7 @@ bool ExecutableAnalyzer::DisassembleBasicBlock(const gtUByte* pCode, const gtUBy
 
                 if (J == pInst->OpField1.AddrMethod)
                 {
-                    int offset = static_cast<int>(m_pDasm->GetDisplacement()) + instLength + static_cast<int>(pCode - pCodeBegin);
+                    int offset = static_cast<int>(displacement) + instLength + static_cast<int>(pCode - pCodeBegin);
 
                     // Verify that the offset is within our range.
                     if (0 < offset && static_cast<gtUInt32>(offset) < func.m_size)
@@ -542,9 +667,9 @@ bool ExecutableAnalyzer::DisassembleBasicBlock(const gtUByte* pCode, const gtUBy
             }
             else if (evSyscallSpecies == pInst->InstSpecies || evSysenterSpecies == pInst->InstSpecies)
             {
-                m_mapLock.lockWrite();
-                m_systemCalls.insert(func.m_rva + static_cast<gtRVAddr>(pCode - pCodeBegin));
-                m_mapLock.unlockWrite();
+                m_code.m_mapLock.lockWrite();
+                m_code.m_systemCalls.insert(func.m_rva + static_cast<gtRVAddr>(pCode - pCodeBegin));
+                m_code.m_mapLock.unlockWrite();
             }
         }
 
@@ -560,20 +685,24 @@ bool ExecutableAnalyzer::DisassembleBasicBlock(const gtUByte* pCode, const gtUBy
     return foundExit;
 }
 
-int ExecutableAnalyzer::Decode(const gtUByte* pCode, const CInstr_Table*& pInst)
+int ExecutableAnalyzer::Decode(const gtUByte* pCode, const CInstr_Table*& pInst, gtInt64& displacement)
 {
     int length = -1;
     pInst = nullptr;
+    displacement = 0;
 
-    m_dasmLock.enter();
+    m_code.m_dasmLock.enter();
 
-    if (m_pDasm->Decode(pCode))
+    if (m_code.m_pDasm->Decode(pCode))
     {
-        length = m_pDasm->GetLength();
+        length = m_code.m_pDasm->GetLength();
+
+        // The disassembler is shared with the other analyzers of the image, so read the displacement while it is locked.
+        displacement = static_cast<gtInt64>(m_code.m_pDasm->GetDisplacement());
 
         if (0 < length)
         {
-            const CInstr_ExtraCodes* pExtraInfo = static_cast<CInstr_ExtraCodes*>(m_pDasm->GetExtraInfoPtr());
+            const CInstr_ExtraCodes* pExtraInfo = static_cast<CInstr_ExtraCodes*>(m_code.m_pDasm->GetExtraInfoPtr());
 
             if (nullptr != pExtraInfo)
             {
@@ -582,7 +711,7 @@ int ExecutableAnalyzer::Decode(const gtUByte* pCode, const CInstr_Table*& pInst)
         }
     }
 
-    m_dasmLock.leave();
+    m_code.m_dasmLock.leave();
 
     return length;
 }
@@ -10,9 +10,11 @@
 #ifndef _EXECUTABLEANALYZER_H_
 #define _EXECUTABLEANALYZER_H_
 
+#include <AMDTBaseTools/Include/gtList.h>
 #include <AMDTBaseTools/Include/gtMap.h>
 #include <AMDTBaseTools/Include/gtSet.h>
 #include <AMDTBaseTools/Include/gtVector.h>
+#include <AMDTBaseTools/Include/gtString.h>
 #include <AMDTOSWrappers/Include/osReadWriteLock.h>
 #include <AMDTOSWrappers/Include/osCriticalSection.h>
 #include <AMDTExecutableFormat/inc/ProcessWorkingSet.h>
@@ -23,10 +25,65 @@
 
 class CDisasmwrapper;
 
+// The code discovered in an executable image. All the addresses are relative to the image base,
+// so the analyzers of an image loaded in several processes may share it.
+class AnalyzedCode
+{
+public:
+    AnalyzedCode(gtRVAddr entryPoint);
+    ~AnalyzedCode();
+    AnalyzedCode& operator=(const AnalyzedCode&) = delete;
+
+    gtUInt32 GetFunctionsCount() const;
+
+private:
+    friend class ExecutableAnalyzer;
+
+    CDisasmwrapper* m_pDasm;
+
+    gtSet<FunctionSymbolInfo> m_functions;
+    gtSet<gtRVAddr> m_systemCalls;
+
+    // Copies of the functions' names, as the symbol engine which provided a name may belong to a process
+    // that is unloaded before the other processes sharing this code.
+    gtList<gtString> m_names;
+    mutable osReadWriteLock m_mapLock;
+    mutable osCriticalSection m_dasmLock;
+};
+
+// Hands out one AnalyzedCode per executable image, identified by its path and signature
+class AnalyzedCodeCache
+{
+public:
+    AnalyzedCodeCache();
+    ~AnalyzedCodeCache();
+    AnalyzedCodeCache& operator=(const AnalyzedCodeCache&) = delete;
+
+    AnalyzedCode& Acquire(const ExecutableFile& exe);
+    void Clear();
+
+    void GetStatistics(gtUInt32& numImages, gtUInt32& numAcquired, gtUInt64& numFunctions) const;
+
+private:
+    struct ImageKey
+    {
+        gtString m_path;
+        gtUInt64 m_signature;
+        gtUInt32 m_size;
+
+        bool operator<(const ImageKey& other) const;
+    };
+
+    gtMap<ImageKey, AnalyzedCode*> m_images;
+    gtUInt32 m_numAcquired;
+    mutable osCriticalSection m_lock;
+};
+
 class ExecutableAnalyzer
 {
 public:
     ExecutableAnalyzer(ExecutableFile& exe);
+    ExecutableAnalyzer(ExecutableFile& exe, AnalyzedCode& sharedCode);
     ~ExecutableAnalyzer();
     ExecutableAnalyzer& operator=(const ExecutableAnalyzer&) = delete;
 
@@ -35,6 +92,9 @@ public:
 
     const FunctionSymbolInfo* FindAnalyzedFunction(gtVAddr va, bool handleInline = false);
 
+    bool IsSharingCode() const { return nullptr == m_pOwnCode; }
+    gtUInt32 GetAnalyzedFunctionsCount() const { return m_code.GetFunctionsCount(); }
+
 private:
     enum CodeSymbolType
     {
@@ -58,18 +118,15 @@ private:
 
     unsigned FindBoundingKnownCode(gtRVAddr rva, FunctionSymbolInfo& func, CodeSymbolType& codeSymType) const;
     const gtUByte* GetCodeBytes(unsigned sectionIndex, gtRVAddr rva) const;
-    int Decode(const gtUByte* pCode, const class CInstr_Table*& pInst);
+    int Decode(const gtUByte* pCode, const class CInstr_Table*& pInst, gtInt64& displacement);
 
     bool AddFunctionEntry(gtRVAddr rva);
     bool AddFunction(FunctionSymbolInfo& func, gtSet<FunctionSymbolInfo>::const_iterator& itAddedFunc);
+    wchar_t* CopyFunctionName(const wchar_t* pName);
 
     ExecutableFile& m_exe;
-    CDisasmwrapper* m_pDasm;
-
-    gtSet<FunctionSymbolInfo> m_functions;
-    gtSet<gtRVAddr> m_systemCalls;
-    mutable osReadWriteLock m_mapLock;
-    mutable osCriticalSection m_dasmLock;
+    AnalyzedCode* m_pOwnCode;
+    AnalyzedCode& m_code;
 };
 
 #endif // _EXECUTABLEANALYZER_H_
@@ -90,17 +90,15 @@ bool            gInlineMode = true;
 // - IBS + BTA LOG
 
 
-/* NOTE: [Suravee]
- * 1: Enable module aggregation caching
- * 0: Disable
- */
-#define _ENABLE_MOD_AGG_CACHED_ 1
 #define CSS_DEPTH_MAX 200
 
 // Maximum number of *inlined* functions will be pushed to the call stack
 // (Along with these, 1 more non-inlined function will also be pushed to call stack
 #define MAX_INLINED_FUNCS 3
 
+// The call-stack samples are built into the call graphs once this many return addresses are waiting
+#define CSS_MAX_QUEUED_IPS (4 * 1024 * 1024)
+
 class SimpleProcessWorkingSetQuery : public ProcessWorkingSetQuery
 {
 public:
@@ -125,8 +123,10 @@ private:
     ProcessWorkingSet& m_workingSet;
 };
 
-CaPerfTranslator::ProcessInfo::ProcessInfo(const wchar_t* pSearchPath, const wchar_t* pServerList, const wchar_t* pCachePath) :
-    m_workingSet(true, pSearchPath, pServerList, pCachePath)
+CaPerfTranslator::ProcessInfo::ProcessInfo(const wchar_t* pSearchPath, const wchar_t* pServerList, const wchar_t* pCachePath,
+                                           AnalyzedCodeCache* pCodeCache) :
+    m_workingSet(true, pSearchPath, pServerList, pCachePath),
+    m_pCodeCache(pCodeCache)
 {
     m_exeAnalyzers.reserve(64);
 }
@@ -168,7 +168,15 @@ ExecutableAnalyzer* CaPerfTranslator::ProcessInfo::AcquireExecutableAnalyzer(gtV
 
             if (nullptr == pMapExeAnalyzer)
             {
-                pMapExeAnalyzer = new ExecutableAnalyzer(*pExe);
+                // The image may be loaded at another address by the other processes, so only the code is shared
+                if (nullptr != m_pCodeCache)
+                {
+                    pMapExeAnalyzer = new ExecutableAnalyzer(*pExe, m_pCodeCache->Acquire(*pExe));
+                }
+                else
+                {
+                    pMapExeAnalyzer = new ExecutableAnalyzer(*pExe);
+                }
             }
 
             pExeAnalyzer = pMapExeAnalyzer;
@@ -190,7 +198,13 @@ CaPerfTranslator::ProcessInfo& CaPerfTranslator::AcquireProcessInfo(ProcessIdTyp
 
     if (nullptr == pProcessInfo)
     {
-        pProcessInfo = new ProcessInfo(m_pSearchPath, m_pServerList, m_pCachePath);
+        if (m_isSharedCodeAnalysis && nullptr == m_pAnalyzedCodeCache)
+        {
+            m_pAnalyzedCodeCache = new AnalyzedCodeCache;
+        }
+
+        pProcessInfo = new ProcessInfo(m_pSearchPath, m_pServerList, m_pCachePath,
+                                       m_isSharedCodeAnalysis ? m_pAnalyzedCodeCache : nullptr);
         m_processInfos.insert(std::pair<ProcessIdType, ProcessInfo*>(pid, pProcessInfo));
     }
 
@@ -250,8 +264,15 @@ void CaPerfTranslator::_init()
     m_lastEvBlkStartTs = 0;
     m_lastEvBlkStopTs = 0;
     m_pass2Mode = PASS2_MODE_SERIAL;
+    m_numWorkerThreads = 0;
+    m_numPass2Workers = 0;
+    m_useMmapReader = true;
     m_lastSortTs = 0;
 
+    m_numQueuedCssIps = 0;
+    m_numCssThreads = 0;
+    m_numCssWorkers = 0;
+
 #ifdef ENABLE_FAKETIMER
     //Initialize the arrays to NULL
     m_aFakeFlags = nullptr;
@@ -262,6 +283,21 @@ void CaPerfTranslator::_init()
     m_pSearchPath = nullptr;
     m_pServerList = nullptr;
     m_pCachePath = nullptr;
+
+    m_isSharedCodeAnalysis = true;
+    m_pAnalyzedCodeCache = nullptr;
+
+    m_pOnlineThread = nullptr;
+    m_onlineStopRequested = false;
+    m_onlineStatus = S_OK;
+    m_onlineRecIndex = 0;
+    m_isOnlineDb = false;
+
+    m_isModulePreload = true;
+    m_numPreloadThreads = 0;
+    m_nextModulePreload = 0;
+    m_preloadStopRequested = false;
+    timerclear(&m_preloadWait);
 }
 
 // This function adds an individual IBS event identifier to
@@ -451,7 +487,7 @@ void CaPerfTranslator::SetDebugSymbolsSearchPath(const wchar_t* pSearchPath, con
     }
 }
 
-inline void CaPerfTranslator::_clearAllHandlers()
+void CaPerfTranslator::_clearAllHandlers()
 {
     // Initialize the record handler dispatcher
     memset(&m_handlers, 0, sizeof(PerfRecordHandler_t) * PERF_RECORD_MAX);
@@ -460,6 +496,9 @@ inline void CaPerfTranslator::_clearAllHandlers()
 
 CaPerfTranslator::~CaPerfTranslator()
 {
+    _stopOnlineTranslation();
+    _stopModulePreload();
+
     if (m_pPerfDataRdr)
     {
         m_pPerfDataRdr->deinit();
@@ -503,6 +542,11 @@ CaPerfTranslator::~CaPerfTranslator()
         }
     }
 
+    if (nullptr != m_pAnalyzedCodeCache)
+    {
+        delete m_pAnalyzedCodeCache;
+    }
+
     // We use 'free' instead of 'delete' because these strings were created by 'wcsdup'
     //
     if (nullptr != m_pSearchPath)
@@ -606,25 +650,12 @@ CaPerfTranslator::_removeJavaJncTmpDir(const gtString& directory)
 }
 
 
-HRESULT CaPerfTranslator::translatePerfDataToCaData(const std::string& outPath, const std::string& perfDataPath, bool bVerb)
+// Everything the translation needs before the records can be processed
+HRESULT CaPerfTranslator::_setupTranslation(const std::string& outPath, bool bVerb)
 {
     HRESULT retVal = S_OK;
 
-    // Sanity check
-    if (perfDataPath.empty())
-    {
-        if (m_inputFile.empty())
-        {
-            return E_INVALIDPATH;
-        }
-    }
-    else
-    {
-        m_inputFile = perfDataPath;
-    }
-
     // Read the Java JIT data
-    wchar_t javaJncTmpDir[OS_MAX_PATH] = L"/tmp/.codexl-java";
     gtString outDir;
 
     if (outPath.empty())
@@ -642,7 +673,7 @@ HRESULT CaPerfTranslator::translatePerfDataToCaData(const std::string& outPath,
         outDir.fromUtf8String(outPath);
     }
 
-    m_javaModInfo.ReadJavaJitInformation(javaJncTmpDir, outDir.asCharArray());
+    m_javaModInfo.ReadJavaJitInformation(CAPERF_JAVA_JNC_TMP_DIR, outDir.asCharArray());
 
     // Initialize the reader
     if (!m_pPerfDataRdr
@@ -709,16 +740,12 @@ HRESULT CaPerfTranslator::translatePerfDataToCaData(const std::string& outPath,
         m_isPerProcess = true;
     }
 
-    _clearAllHandlers();
-
-    retVal = _translate_pass1();
+    return retVal;
+}
 
-    if (S_OK != retVal)
-    {
-        return retVal;
-    }
 
-    //-------------------------------------------------------
+void CaPerfTranslator::_resolveOrphanProcesses()
+{
     // NOTE [Suravee]
     // Perf doesn't guarantee the order of fork records. At this point
     // we should have most of the FORK records in place.  Therefore, we
@@ -740,6 +767,49 @@ HRESULT CaPerfTranslator::translatePerfDataToCaData(const std::string& outPath,
                                         zit->first, zit->second));
         }
     }
+}
+
+
+HRESULT CaPerfTranslator::translatePerfDataToCaData(const std::string& outPath, const std::string& perfDataPath, bool bVerb)
+{
+    HRESULT retVal = S_OK;
+
+    // The records were already translated while they were being collected
+    if (isOnlineTranslation())
+    {
+        return _finishOnlineTranslation();
+    }
+
+    // Sanity check
+    if (perfDataPath.empty())
+    {
+        if (m_inputFile.empty())
+        {
+            return E_INVALIDPATH;
+        }
+    }
+    else
+    {
+        m_inputFile = perfDataPath;
+    }
+
+    retVal = _setupTranslation(outPath, bVerb);
+
+    if (S_OK != retVal)
+    {
+        return retVal;
+    }
+
+    _clearAllHandlers();
+
+    retVal = _translate_pass1();
+
+    if (S_OK != retVal)
+    {
+        return retVal;
+    }
+
+    _resolveOrphanProcesses();
 
     //-------------------------------------------------------
 
@@ -768,6 +838,9 @@ HRESULT CaPerfTranslator::translatePerfDataToCaData(const std::string& outPath,
         m_pass2Mode = PASS2_MODE_SERIAL;
     }
 
+    // The modules hit by the samples are loaded while the records are translated
+    _startModulePreload();
+
     switch (m_pass2Mode)
     {
         case PASS2_MODE_SERIAL:
@@ -778,13 +851,19 @@ HRESULT CaPerfTranslator::translatePerfDataToCaData(const std::string& outPath,
             retVal = _translate_pass2_sort();
             break;
 
+        case PASS2_MODE_PARALLEL:
+            retVal = _translate_pass2_parallel();
+            break;
+
         default:
             OS_OUTPUT_DEBUG_LOG(L"Unknown pass2 translation mode", OS_DEBUG_LOG_ERROR);
     }
 
+    _stopModulePreload();
+
     // Fix for BUG400722: Removed the residual JNC files created from
     // Java profiling on temp dir.
-    _removeJavaJncTmpDir(javaJncTmpDir);
+    _removeJavaJncTmpDir(CAPERF_JAVA_JNC_TMP_DIR);
 
     // If there are no samples collected, return appropriate
     // error code.
@@ -800,8 +879,7 @@ HRESULT CaPerfTranslator::translatePerfDataToCaData(const std::string& outPath,
 HRESULT CaPerfTranslator::_translate_pass1()
 {
     HRESULT retVal = S_OK;
-    struct perf_event_header hdr;
-    const void* pBuf = nullptr;
+    const struct perf_event_header* pRec = nullptr;
 
     if (m_bVerb)
     {
@@ -823,14 +901,21 @@ HRESULT CaPerfTranslator::_translate_pass1()
     m_handlers[PERF_RECORD_SAMPLE] =
         (PerfRecordHandler_t) &CaPerfTranslator::preprocess_PERF_RECORD_SAMPLE_into_block;
 
+    // With a single online CPU, the preload threads would only compete with the translation thread
+    if (m_isModulePreload && 0 == m_numPreloadThreads && 1 >= sysconf(_SC_NPROCESSORS_ONLN))
+    {
+        m_isModulePreload = false;
+    }
+
     gettimeofday(&m_pass1Start, nullptr);
 
     //-------------------------------------------------------------------------
 
     gtUInt32 recIndx = 0;
-    gtUInt32 offset = 0;
+    gtUInt64 offset = 0;
 
-    if (m_pPerfDataRdr->getFirstRecord(&hdr, &pBuf, &offset) != S_OK)
+    // The records are handed out in place, straight from the reader's mapping
+    if (m_pPerfDataRdr->getFirstRecord(&pRec, &offset) != S_OK)
     {
         return E_FAIL;
     }
@@ -839,31 +924,25 @@ HRESULT CaPerfTranslator::_translate_pass1()
 
     do
     {
-        if (hdr.size == 0 || !pBuf)
-        {
-            retVal = E_UNEXPECTED;
-            break;
-        }
-
         // Check for invalide type
-        if (hdr.type >= PERF_RECORD_MAX)
+        if (pRec->type >= PERF_RECORD_MAX)
         {
             if (m_bVerb)
                 fprintf(stdout, "Error: Unknown PERF record type (%x)\n",
-                        hdr.type);
+                        pRec->type);
 
             continue;
         }
 
-        if (m_handlers[hdr.type] != nullptr)
+        if (m_handlers[pRec->type] != nullptr)
         {
-            (this->*(m_handlers[hdr.type]))(&hdr, pBuf, offset, recIndx);
+            (this->*(m_handlers[pRec->type]))(const_cast<struct perf_event_header*>(pRec), pRec + 1, offset, recIndx);
         }
 
         recIndx++;
 
     }
-    while (m_pPerfDataRdr->getNextRecord(&hdr, &pBuf, &offset) == S_OK);
+    while (m_pPerfDataRdr->getNextRecord(&pRec, &offset) == S_OK);
 
     // Insert last EvBlk into EvBlkMap
     if (0 != m_lastEvBlkId)
@@ -891,6 +970,17 @@ HRESULT CaPerfTranslator::_translate_pass1()
         timersub(&m_pass1Stop, &m_pass1Start, &diff);
         fprintf(m_pLogFile, "Pass1 Time                 : %lu sec, %lu usec\n",
                 diff.tv_sec, diff.tv_usec);
+        fprintf(m_pLogFile, "Pass1 Reader Mode          : %s\n",
+                m_pPerfDataRdr->isMmapMode() ? "mmap" : "read");
+        fprintf(m_pLogFile, "Pass1 Records              : %u (%llu bytes)\n",
+                recIndx, m_pPerfDataRdr->getCurrentDataSize());
+
+        double pass1Sec = diff.tv_sec + (diff.tv_usec / 1000000.0);
+
+        if (pass1Sec > 0)
+        {
+            fprintf(m_pLogFile, "Pass1 Throughput           : %.0f records/sec\n", recIndx / pass1Sec);
+        }
     }
 
     return retVal;
@@ -902,9 +992,8 @@ HRESULT CaPerfTranslator::_translate_pass1()
 HRESULT CaPerfTranslator::_translate_pass2_serialize()
 {
     HRESULT retVal = S_OK;
-    struct perf_event_header hdr;
-    const void* pBuf = nullptr;
-    gtUInt32 offset = 0;
+    const struct perf_event_header* pRec = nullptr;
+    gtUInt64 offset = 0;
     gtUInt32 recIndx = 0;
 
     // Re-initialize some stuff
@@ -929,39 +1018,33 @@ HRESULT CaPerfTranslator::_translate_pass2_serialize()
     m_handlers[PERF_RECORD_SAMPLE] =
         (PerfRecordHandler_t) &CaPerfTranslator::process_PERF_RECORD_SAMPLE;
 
-    if (m_pPerfDataRdr->getFirstRecord(&hdr, &pBuf, &offset) != S_OK)
+    if (m_pPerfDataRdr->getFirstRecord(&pRec, &offset) != S_OK)
     {
         return E_FAIL;
     }
 
     do
     {
-        if (hdr.size == 0 || !pBuf)
-        {
-            retVal = E_UNEXPECTED;
-            break;
-        }
-
         // Check for invalide type
-        if (hdr.type >= PERF_RECORD_MAX)
+        if (pRec->type >= PERF_RECORD_MAX)
         {
             if (m_bVerb)
             {
-                OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"Error: Unknown PERF record type (%x)", hdr.type);
+                OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"Error: Unknown PERF record type (%x)", pRec->type);
             }
 
             continue;
         }
 
-        if (m_handlers[hdr.type] != nullptr)
+        if (m_handlers[pRec->type] != nullptr)
         {
-            (this->*(m_handlers[hdr.type]))(&hdr, pBuf, offset, recIndx);
+            (this->*(m_handlers[pRec->type]))(const_cast<struct perf_event_header*>(pRec), pRec + 1, offset, recIndx);
         }
 
         recIndx++;
 
     }
-    while (m_pPerfDataRdr->getNextRecord(&hdr, &pBuf, &offset) == S_OK);
+    while (m_pPerfDataRdr->getNextRecord(&pRec, &offset) == S_OK);
 
     //-------------------------------------------------------
 
@@ -1000,6 +1083,8 @@ HRESULT CaPerfTranslator::_translate_pass2_serialize()
         OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"%hs", pre.str().c_str());
     }
 
+    _flushCssSamples();
+
     //-------------------------------------------------------
     gettimeofday(&m_pass2Stop, nullptr);
 
@@ -1063,12 +1148,13 @@ HRESULT CaPerfTranslator::_translate_pass2_sort()
 
         // Pull-in data of the first block from each EvId
         if (S_OK != _getSampleBlockFromOffset(
+                m_pPerfDataRdr,
                 tit->second.offset,
                 tit->second.bytes,
                 eit->first,
                 &(tit->second.pData)))
         {
-            OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"Couldn't get block. EvId=0x%016llx, offset=%u, size=%u",
+            OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"Couldn't get block. EvId=0x%016llx, offset=%llu, size=%u",
                                        eit->first, tit->second.offset, tit->second.bytes);
             return E_FAIL;
         }
@@ -1147,6 +1233,7 @@ HRESULT CaPerfTranslator::_translate_pass2_sort()
 
                 // Pull-in data of the first block from each EvId
                 if (S_OK != _getSampleBlockFromOffset(
+                        m_pPerfDataRdr,
                         tit->second.offset,
                         tit->second.bytes,
                         m_lastProcessedEvId,
@@ -1189,6 +1276,8 @@ HRESULT CaPerfTranslator::_translate_pass2_sort()
         it =  m_tsRecMap.begin();
     } // while
 
+    _flushCssSamples();
+
     //-------------------------------------------------------
     gettimeofday(&m_pass2Stop, nullptr);
 
@@ -1253,20 +1342,20 @@ HRESULT CaPerfTranslator::_translate_pass2_sort()
 // which should be the beginning of the sample block and read in all
 // sample record from the block
 HRESULT CaPerfTranslator::_getSampleBlockFromOffset(
-    gtUInt32 blkOffset,
+    PerfDataReader* pReader,
+    gtUInt64 blkOffset,
     gtUInt32 blkSize,
     gtUInt64 evId,
     void** ppData)
 {
     (void)(evId); // unused
     int retVal = S_OK;
-    struct perf_event_header hdr;
-    const void* pBuf = nullptr;
+    const struct perf_event_header* pRec = nullptr;
     char* pTmp = nullptr;
     gtUInt32 totSize = 0;
 
 #if 0
-    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"_getSampleBlockFromOffset: evId=0x%016llx, offset=%u, size=%u", evId, blkOffset, blkSize);
+    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"_getSampleBlockFromOffset: evId=0x%016llx, offset=%llu, size=%u", evId, blkOffset, blkSize);
 #endif
 
     *ppData = calloc(1, blkSize);
@@ -1276,10 +1365,8 @@ HRESULT CaPerfTranslator::_getSampleBlockFromOffset(
         return E_OUTOFMEMORY;
     }
 
-    // TODO: [Suravee]: We probably can read the whole size in at once.
-
     // Get the first record of the block
-    if (S_OK != m_pPerfDataRdr->getRecordFromOffset(blkOffset, &hdr, &pBuf))
+    if (S_OK != pReader->getRecordFromOffset(blkOffset, &pRec))
     {
         return E_FAIL;
     }
@@ -1288,15 +1375,16 @@ HRESULT CaPerfTranslator::_getSampleBlockFromOffset(
 
     do
     {
-        // Store into the buffer
-        gtUInt32 hdrSize = sizeof(struct perf_event_header);
-        memcpy(pTmp, &hdr, hdrSize);
-        pTmp += hdrSize;
+        // Records are laid out back to back, store header and payload in one go
+        if ((totSize + pRec->size) > blkSize)
+        {
+            break;
+        }
 
-        memcpy(pTmp, pBuf, hdr.size - hdrSize);
-        pTmp += hdr.size - hdrSize;
+        memcpy(pTmp, pRec, pRec->size);
+        pTmp += pRec->size;
 
-        totSize += (hdr.size);
+        totSize += (pRec->size);
 
         if (totSize >= blkSize)
         {
@@ -1304,12 +1392,55 @@ HRESULT CaPerfTranslator::_getSampleBlockFromOffset(
         }
 
     }
-    while (m_pPerfDataRdr->getNextRecord(&hdr, &pBuf) == S_OK);
+    while (pReader->getNextRecord(&pRec) == S_OK);
 
     return retVal;
 }
 
 
+// The memory is estimated by the tree nodes of the discovered functions
+void CaPerfTranslator::_printCodeAnalysisLog()
+{
+    gtUInt32 numAnalyzers = 0U;
+    gtUInt32 numImages = 0U;
+    gtUInt64 numFunctions = 0ULL;
+
+    for (gtMap<ProcessIdType, ProcessInfo*>::iterator it = m_processInfos.begin(), itEnd = m_processInfos.end(); it != itEnd; ++it)
+    {
+        ExecutableAnalyzersMap& exeAnalyzers = it->second->m_exeAnalyzers;
+
+        for (ExecutableAnalyzersMap::iterator ait = exeAnalyzers.begin(), aitEnd = exeAnalyzers.end(); ait != aitEnd; ++ait)
+        {
+            numAnalyzers++;
+
+            if (!ait->second->IsSharingCode())
+            {
+                numImages++;
+                numFunctions += ait->second->GetAnalyzedFunctionsCount();
+            }
+        }
+    }
+
+    if (nullptr != m_pAnalyzedCodeCache)
+    {
+        gtUInt32 numSharedImages = 0U;
+        gtUInt32 numAcquired = 0U;
+        gtUInt64 numSharedFunctions = 0ULL;
+        m_pAnalyzedCodeCache->GetStatistics(numSharedImages, numAcquired, numSharedFunctions);
+
+        numImages += numSharedImages;
+        numFunctions += numSharedFunctions;
+    }
+
+    gtUInt64 functionsSize = numFunctions * (sizeof(FunctionSymbolInfo) + 4 * sizeof(void*));
+
+    fprintf(m_pLogFile, "Code Analyzers             : %u, %u images (%s)\n",
+            numAnalyzers, numImages, m_isSharedCodeAnalysis ? "shared" : "per process");
+    fprintf(m_pLogFile, "Analyzed Functions         : %llu (%llu KB)\n",
+            static_cast<unsigned long long>(numFunctions), static_cast<unsigned long long>(functionsSize / 1024));
+}
+
+
 void CaPerfTranslator::_printPass2Log()
 {
     if (m_pLogFile)
@@ -1330,6 +1461,25 @@ void CaPerfTranslator::_printPass2Log()
         fprintf(m_pLogFile, "Num IBS Samples            : \n");
         fprintf(m_pLogFile, "Translation Mode           : %u\n", m_pass2Mode);
 
+        if (PASS2_MODE_PARALLEL == m_pass2Mode)
+        {
+            fprintf(m_pLogFile, "Pass2 Worker Threads       : %u\n", m_numPass2Workers);
+        }
+
+        if (0 != m_numCssWorkers)
+        {
+            fprintf(m_pLogFile, "CSS Worker Threads         : %u\n", m_numCssWorkers);
+        }
+
+        _printCodeAnalysisLog();
+
+        double pass2Secs = static_cast<double>(diff.tv_sec) + static_cast<double>(diff.tv_usec) / 1000000.0;
+
+        if (0.0 < pass2Secs)
+        {
+            fprintf(m_pLogFile, "Pass2 Throughput           : %.0f samples/sec\n", m_numSamples / pass2Secs);
+        }
+
         gtMap<gtUInt32, gtUInt32>::iterator it = m_ibsEventMap.begin();
         gtMap<gtUInt32, gtUInt32>::iterator iend = m_ibsEventMap.end();
 
@@ -1352,52 +1502,37 @@ void CaPerfTranslator::_printPass2Log()
 
 ModLoadInfoMap::reverse_iterator CaPerfTranslator::_getModuleForSample(gtUInt32 pid, gtUInt64 time, gtUInt64 ip, bool bIsUser)
 {
-    // Look for module with the corresponded
-    // ip and timestamp
-    ModLoadInfoMap::reverse_iterator rit = m_modLoadInfoMap.rbegin();
-    ModLoadInfoMap::reverse_iterator rend = m_modLoadInfoMap.rend();
+    ModLoadInfoMap::reverse_iterator rit = _findModuleForSample(pid, time, ip, bIsUser);
 
-    if (!pid || !time || !ip)
+    if (rit != m_modLoadInfoMap.rend())
     {
-        return rend;
+        _initModuleBase(pid, rit);
     }
 
-    if (!bIsUser)
-    {
-        ModKey key(time, ip, -1);
+    return rit;
+}
 
-        for (; rit != rend; rit++)
-        {
-            if (-1 != rit->first.pid)
-            {
-                continue;
-            }
+// Only looks up the module load info, this does not modify any translator state.
+ModLoadInfoMap::reverse_iterator CaPerfTranslator::_findModuleForSample(gtUInt32 pid, gtUInt64 time, gtUInt64 ip, bool bIsUser)
+{
+    ModLoadInfoMap::reverse_iterator rend = m_modLoadInfoMap.rend();
 
-            if (rit->first < key || rit->first == key)
-            {
-                break;
-            }
-        }
-    }
-    else
+    if (!pid || !time || !ip)
     {
-        ModKey key(time, ip, pid);
+        return rend;
+    }
 
-        for (; rit != rend; rit++)
-        {
-            if ((int) pid != rit->first.pid)
-            {
-                continue;
-            }
+    // Kernel modules are keyed with pid -1
+    int modPid = bIsUser ? static_cast<int>(pid) : -1;
 
-            if (rit->first < key || rit->first == key)
-            {
-                break;
-            }
-        }
-    }
+    // Look for the last module of the process that is not after the (ip, timestamp)
+    // key, that is, the entry right before the upper bound of the key. The map is
+    // ordered by pid first, so there is no such module if that entry belongs to
+    // another process.
+    ModKey key(time, ip, modPid);
+    ModLoadInfoMap::reverse_iterator rit(m_modLoadInfoMap.upper_bound(key));
 
-    if (rit == rend)
+    if (rit == rend || modPid != rit->first.pid)
     {
         return rend;
     }
@@ -1418,56 +1553,100 @@ ModLoadInfoMap::reverse_iterator CaPerfTranslator::_getModuleForSample(gtUInt32
         return rend;
     }
 
+    return rit;
+}
+
+// The first sample that hits a module sets up its base address and
+// registers the module in the working set of the sample's process.
+void CaPerfTranslator::_initModuleBase(gtUInt32 pid, ModLoadInfoMap::reverse_iterator rit)
+{
     CpuProfileModule* pMod = rit->second.pMod;
 
     if (nullptr != pMod && 0 == pMod->m_base)
     {
         pMod->m_base = rit->first.addr;
 
+        gtUInt64 endRng = rit->first.addr + rit->second.len;
+
+        // Same kernel.kallsyms hack as in _findModuleForSample()
+        if (rit->first.pid == -1 && rit->second.len > rit->first.addr)
+        {
+            endRng = -1ULL;
+        }
+
         if (-1ULL != endRng && 0x7fffffffULL >= rit->second.len)
         {
             pMod->m_size = static_cast<gtUInt32>(rit->second.len);
         }
 
-        AcquireProcessInfo(pid).m_workingSet.AddModule(pMod->m_base, pMod->m_size, pMod->getPath().asCharArray());
-    }
+        ProcessWorkingSet& workingSet = AcquireProcessInfo(pid).m_workingSet;
+        ExecutableFile* pExe = _acquirePreloadedModule(workingSet, rit);
 
-    return rit;
+        if (nullptr == pExe)
+        {
+            workingSet.AddModule(pMod->m_base, pMod->m_size, pMod->getPath().asCharArray());
+        }
+        else if (!workingSet.AdoptModule(pExe, pMod->m_base, pMod->m_size))
+        {
+            delete pExe;
+        }
+    }
 }
 
 const FunctionSymbolInfo* CaPerfTranslator::getFunctionSymbol(ProcessIdType pid, gtVAddr ip, CpuProfileModule* pMod)
 {
-    const FunctionSymbolInfo* pFuncInfo = nullptr;
-    bool handleInline = true;
+    ExecutableAnalyzer* pExeAnalyzer = nullptr;
+    ExecutableFile* pExecutable = nullptr;
+
+    _findExecutableForSample(pid, ip, pExeAnalyzer, pExecutable);
+
+    return _getFunctionSymbol(ip, pExeAnalyzer, pExecutable, pMod);
+}
+
+// Looks up the code analyzer of the module that contains the given address, and
+// the executable itself only when there is no analyzer for it.
+void CaPerfTranslator::_findExecutableForSample(ProcessIdType pid, gtVAddr ip, ExecutableAnalyzer*& pExeAnalyzer, ExecutableFile*& pExecutable)
+{
+    pExeAnalyzer = nullptr;
+    pExecutable = nullptr;
 
     ProcessInfo* pProcessInfo = FindProcessInfo(pid);
 
     if (nullptr != pProcessInfo)
     {
-        ExecutableAnalyzer* pExeAnalyzer = pProcessInfo->AcquireExecutableAnalyzer(ip);
+        pExeAnalyzer = pProcessInfo->AcquireExecutableAnalyzer(ip);
 
-        if (nullptr != pExeAnalyzer)
+        if (nullptr == pExeAnalyzer)
         {
-            pFuncInfo = pExeAnalyzer->FindAnalyzedFunction(ip, handleInline);
+            pExecutable = pProcessInfo->m_workingSet.FindModule(ip);
         }
-        else
-        {
-            ExecutableFile* pExecutable = pProcessInfo->m_workingSet.FindModule(ip);
+    }
+}
 
-            if (nullptr != pExecutable)
-            {
-                if (nullptr != pMod)
-                {
-                    pMod->m_size = pExecutable->GetImageSize();
-                }
+const FunctionSymbolInfo* CaPerfTranslator::_getFunctionSymbol(gtVAddr ip,
+                                                               ExecutableAnalyzer* pExeAnalyzer,
+                                                               ExecutableFile* pExecutable,
+                                                               CpuProfileModule* pMod)
+{
+    const FunctionSymbolInfo* pFuncInfo = nullptr;
+    bool handleInline = true;
 
-                SymbolEngine* pSymbolEngine = pExecutable->GetSymbolEngine();
+    if (nullptr != pExeAnalyzer)
+    {
+        pFuncInfo = pExeAnalyzer->FindAnalyzedFunction(ip, handleInline);
+    }
+    else if (nullptr != pExecutable)
+    {
+        if (nullptr != pMod)
+        {
+            pMod->m_size = pExecutable->GetImageSize();
+        }
 
-                if (nullptr != pSymbolEngine)
-                {
-                    pFuncInfo = pSymbolEngine->LookupFunction(pExecutable->VaToRva(ip), nullptr, handleInline);
-                }
-            }
+        SymbolEngine* pSymbolEngine = pExecutable->GetSymbolEngine();
+
+        if (nullptr != pSymbolEngine)
+        {
+            pFuncInfo = pSymbolEngine->LookupFunction(pExecutable->VaToRva(ip), nullptr, handleInline);
         }
     }
 
@@ -1541,7 +1720,7 @@ CpuProfileProcess* CaPerfTranslator::getProcess(ProcessIdType pid)
 }
 
 
-int CaPerfTranslator::process_PERF_RECORD_MMAP(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index)
+int CaPerfTranslator::process_PERF_RECORD_MMAP(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index)
 {
     (void)(offset); // unused
 
@@ -1617,7 +1796,7 @@ int CaPerfTranslator::process_PERF_RECORD_MMAP(struct perf_event_header* pHdr, v
 }
 
 
-int CaPerfTranslator::process_PERF_RECORD_COMM(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index)
+int CaPerfTranslator::process_PERF_RECORD_COMM(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index)
 {
     (void)(offset); // unused
 
@@ -1720,6 +1899,36 @@ void CaPerfTranslator::_addSampleToProcessAndModule(CpuProfileProcess* pProc,
                                                     gtUInt32 event, gtUInt32 umask, gtUInt32 os, gtUInt32 usr,
                                                     gtUInt32 count,
                                                     const FunctionSymbolInfo* pFuncInfo)
+{
+    ExecutableFile* pExecutable = nullptr;
+
+    // Only the symbolized samples of native modules need their executable
+    if ((nullptr != pProc) && (nullptr != pMod) && (nullptr != pFuncInfo) && (pMod->m_modType == CpuProfileModule::UNMANAGEDPE))
+    {
+        ProcessInfo* pProcessInfo = FindProcessInfo(pid);
+
+        if (nullptr != pProcessInfo)
+        {
+            pExecutable = pProcessInfo->m_workingSet.FindModule(ip);
+        }
+    }
+
+    _addSampleToProcessAndModule(pProc, ldAddr, funcSize, pMod, pExecutable,
+                                 ip, pid, tid, cpu,
+                                 event, umask, os, usr,
+                                 count,
+                                 pFuncInfo);
+}
+
+// The parallel pass2 looks up the executable of a sample ahead of aggregating it
+void CaPerfTranslator::_addSampleToProcessAndModule(CpuProfileProcess* pProc,
+                                                    gtUInt64 ldAddr, gtUInt32 funcSize, CpuProfileModule* pMod,
+                                                    ExecutableFile* pExecutable,
+                                                    gtUInt64 ip,
+                                                    gtUInt32 pid, gtUInt32 tid, gtUInt32 cpu,
+                                                    gtUInt32 event, gtUInt32 umask, gtUInt32 os, gtUInt32 usr,
+                                                    gtUInt32 count,
+                                                    const FunctionSymbolInfo* pFuncInfo)
 
 {
     EventMaskType evMask = _getEvmask(event, umask, os, usr);
@@ -1755,56 +1964,45 @@ void CaPerfTranslator::_addSampleToProcessAndModule(CpuProfileProcess* pProc,
         bool handleInline = true;
         gtUInt32 functionId = UNKNOWN_FUNCTION_ID;
 
-        if (nullptr != pFuncInfo)
+        if ((nullptr != pFuncInfo) && (nullptr != pExecutable))
         {
+            pMod->m_isDebugInfoAvailable = pExecutable->IsDebugInfoAvailable();
 
-            ProcessInfo* pProcessInfo = FindProcessInfo(pid);
+            gtRVAddr rva = pExecutable->VaToRva(sampInfo.address);
+            SymbolEngine* pSymbolEngine = pExecutable->GetSymbolEngine();
 
-            if (nullptr != pProcessInfo)
+            if (nullptr != pSymbolEngine)
             {
-                ExecutableFile* pExecutable = pProcessInfo->m_workingSet.FindModule(ip);
+                gtRVAddr inlineRva = pSymbolEngine->TranslateToInlineeRVA(rva);
+                gtVAddr addr = sampInfo.address - rva + inlineRva;
+                CpuProfileFunction* pFunc = pMod->findFunction(addr);
 
-                if (nullptr != pExecutable)
+                if (nullptr == pFunc || pMod->isUnchartedFunction(*pFunc))
                 {
-                    pMod->m_isDebugInfoAvailable = pExecutable->IsDebugInfoAvailable();
-
-                    gtRVAddr rva = pExecutable->VaToRva(sampInfo.address);
-                    SymbolEngine* pSymbolEngine = pExecutable->GetSymbolEngine();
-
-                    if (nullptr != pSymbolEngine)
+                    if (nullptr != pFuncInfo->m_pName)
                     {
-                        gtRVAddr inlineRva = pSymbolEngine->TranslateToInlineeRVA(rva);
-                        gtVAddr addr = sampInfo.address - rva + inlineRva;
-                        CpuProfileFunction* pFunc = pMod->findFunction(addr);
-
-                        if (nullptr == pFunc || pMod->isUnchartedFunction(*pFunc))
-                        {
-                            if (nullptr != pFuncInfo->m_pName)
-                            {
-                                funcName = pFuncInfo->m_pName;
-                            }
-
-                            SourceLineInfo sourceLine;
+                        funcName = pFuncInfo->m_pName;
+                    }
 
-                            if (pSymbolEngine->FindSourceLine(rva, sourceLine, handleInline))
-                            {
-                                srcFileName = sourceLine.m_filePath;
-                                srcLineNum = sourceLine.m_line;
-                                sampInfo.address = pExecutable->RvaToVa(sourceLine.m_rva);
-                            }
+                    SourceLineInfo sourceLine;
 
-                            functionId = pFuncInfo->m_funcId;
-                        }
-                        else
-                        {
-                            if (nullptr != pFuncInfo->m_pName)
-                            {
-                                funcName = pFuncInfo->m_pName;
-                            }
+                    if (pSymbolEngine->FindSourceLine(rva, sourceLine, handleInline))
+                    {
+                        srcFileName = sourceLine.m_filePath;
+                        srcLineNum = sourceLine.m_line;
+                        sampInfo.address = pExecutable->RvaToVa(sourceLine.m_rva);
+                    }
 
-                            sampInfo.address = pExecutable->RvaToVa(inlineRva);
-                        }
+                    functionId = pFuncInfo->m_funcId;
+                }
+                else
+                {
+                    if (nullptr != pFuncInfo->m_pName)
+                    {
+                        funcName = pFuncInfo->m_pName;
                     }
+
+                    sampInfo.address = pExecutable->RvaToVa(inlineRva);
                 }
             }
         }
@@ -1898,16 +2096,15 @@ void CaPerfTranslator::_dumpEvBlkInfo()
 
         for (int k = 0; tit != tend; ++tit, ++k)
         {
-            OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"    Index:%5d | EvBlkIndex:%4u, ts:0x%016llx, offset:%10u, num:%u",
+            OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"    Index:%5d | EvBlkIndex:%4u, ts:0x%016llx, offset:%10llu, num:%u",
                                        k, tit->second.index, tit->first, tit->second.offset, tit->second.num);
         }
     }
 }
 
 
-int CaPerfTranslator::preprocess_PERF_RECORD_SAMPLE_into_block(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index)
+int CaPerfTranslator::preprocess_PERF_RECORD_SAMPLE_into_block(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index)
 {
-    (void)(pHdr); // unused
     struct CA_PERF_RECORD_SAMPLE rec;
     char* pCur = (char*)ptr;
 
@@ -2013,11 +2210,26 @@ int CaPerfTranslator::preprocess_PERF_RECORD_SAMPLE_into_block(struct perf_event
 
     if (m_bVerb)
     {
-        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"rec#:%5u, SAMP: offset:%x, time:0x%016llx, pid:%d, id:0x%016llx, ip:0x%016llx",
+        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"rec#:%5u, SAMP: offset:%llx, time:0x%016llx, pid:%d, id:0x%016llx, ip:0x%016llx",
                                    index, offset, rec.time, rec.pid, rec.id, rec.ip);
     }
 
-    return S_OK;
+    if (m_isModulePreload)
+    {
+        if (pHdr->misc & PERF_RECORD_MISC_USER)
+        {
+            _countPreloadHit(rec.pid, rec.time, rec.ip, index);
+        }
+
+        // The call-stack output looks up the modules of the call chain entries too, so
+        // an entry may be the first to hit its module
+        if ((m_sampleType & PERF_SAMPLE_CALLCHAIN) && (!m_cssFileDir.empty() || nullptr != m_pCalogCss))
+        {
+            _countPreloadCallchainHits(ptr, index);
+        }
+    }
+
+    return S_OK;
 }
 
 
@@ -2097,7 +2309,160 @@ HRESULT CaPerfTranslator::_prepareBlkForSorting(gtUInt32 blkSize, void* pBlk, gt
 }
 
 
-HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index)
+// Computes the multiplexing weight of a sample from the enabled/running times of its
+// event, and remembers those times for the next sample of the same event id.
+float CaPerfTranslator::_getSampleWeight(const struct CA_PERF_RECORD_SAMPLE& rec)
+{
+    float weight = 1.0;
+
+    EvtIdPreviousMap::iterator prevIt =  m_previousMap.find(rec.id);
+    PreviousTimes prevTime;
+
+    //If we have a record of the previous times for this event id
+    if (m_previousMap.end() != prevIt)
+    {
+        prevTime = prevIt->second;
+    }
+    else
+    {
+        prevTime.previousEnabledTime = 0;
+        prevTime.previousRunningTime = 0;
+    }
+
+    //Calculate the weight of this sample, based on the running time given by perf, rounded up
+    // Baskar: Fix for BUG368631: junk values shown in CSS on RHEL 6.2.
+    // Only if we know the previous running and enabled time, we should
+    // compute the weight
+    if ((!prevTime.previousEnabledTime) && (!prevTime.previousRunningTime))
+    {
+        weight = double(rec.values.time_enabled - prevTime.previousEnabledTime)
+                 / double(rec.values.time_running - prevTime.previousRunningTime) + 0.5;
+    }
+
+    //Save the times to get the correct diff for the next sample weight
+    prevTime.previousEnabledTime = rec.values.time_enabled;
+    prevTime.previousRunningTime = rec.values.time_running;
+    m_previousMap[rec.id] = prevTime;
+
+    if (m_bVerb)
+    {
+        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"read_format:{value:0x%016llx, time_enabled:0x%016llx, "
+                                   L"time_running:0x%016llx, id:0x%016llx}, weighted: %0.2f",
+                                   rec.values.value, rec.values.time_enabled,
+                                   rec.values.time_running, rec.values.id, weight);
+    }
+
+    return weight;
+}
+
+
+// Decodes the fields of a PERF_RECORD_SAMPLE record, without printing them or updating any
+// translator state. This is the only place where the sample fields are parsed: it is used by
+// process_PERF_RECORD_SAMPLE() and by the worker threads of the parallel pass2.
+// On a corrupted call chain, E_FAIL is returned with the fields before the call chain decoded.
+HRESULT CaPerfTranslator::_decodeSampleRecord(const void* pData, struct CA_PERF_RECORD_SAMPLE& rec) const
+{
+    const char* pCur = static_cast<const char*>(pData);
+
+    memset(&rec, 0, sizeof(struct CA_PERF_RECORD_SAMPLE));
+
+    if (m_sampleType & PERF_SAMPLE_IP)
+    {
+        rec.ip = *((const u64*)pCur);
+        pCur += 8;
+    }
+
+    if (m_sampleType & PERF_SAMPLE_TID)
+    {
+        rec.pid = *((const u32*)pCur);
+        pCur += 4;
+
+        rec.tid = *((const u32*)pCur);
+        pCur += 4;
+    }
+
+    if (m_sampleType & PERF_SAMPLE_TIME)
+    {
+        rec.time = *((const u64*)pCur);
+        pCur += 8;
+    }
+
+    if (m_sampleType & PERF_SAMPLE_ADDR)
+    {
+        rec.addr = *((const u64*)pCur);
+        pCur += 8;
+    }
+
+    if (m_sampleType & PERF_SAMPLE_ID)
+    {
+        rec.id = *((const u64*)pCur);
+        pCur += 8;
+    }
+
+    if (m_sampleType & PERF_SAMPLE_CPU)
+    {
+        rec.cpu = *((const u32*)pCur);
+        pCur += 4;
+
+        // This is for the "res" as list in teh perf_event.h
+        pCur += 4;
+    }
+
+    if (m_sampleType & PERF_SAMPLE_PERIOD)
+    {
+        rec.period = *((const u64*)pCur);
+        pCur += 8;
+    }
+
+    if (m_sampleType & PERF_SAMPLE_READ)
+    {
+        // CaPerf reads PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING | PERF_FORMAT_ID,
+        // PERF_FORMAT_GROUP is not used
+        rec.values.value = *((const u64*)pCur);
+        pCur += 8;
+
+        rec.values.time_enabled = *((const u64*)pCur);
+        pCur += 8;
+
+        rec.values.time_running = *((const u64*)pCur);
+        pCur += 8;
+
+        rec.values.id = *((const u64*)pCur);
+        pCur += 8;
+    }
+
+    if (m_sampleType & PERF_SAMPLE_STREAM_ID)
+    {
+        rec.stream_id = *((const u64*)pCur);
+        pCur += 8;
+    }
+
+    if (m_sampleType & PERF_SAMPLE_CALLCHAIN)
+    {
+        rec.callchain = (struct ip_callchain*)pCur;
+
+        // Sanity check. The first entry of call chain must be PERF_CONTEXT_xxx enums
+        if ((0 < rec.callchain->nr) && (rec.callchain->ips[0] < PERF_CONTEXT_MAX))
+        {
+            return E_FAIL;
+        }
+
+        pCur += sizeof(gtUInt64) * (rec.callchain->nr + 1);
+    }
+
+    if (m_sampleType & PERF_SAMPLE_RAW)
+    {
+        rec.raw_size = *((const u32*)pCur);
+        pCur += 4;
+
+        rec.raw_data = (void*)pCur;
+    }
+
+    return S_OK;
+}
+
+
+HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index)
 {
     if (nullptr == ptr)
     {
@@ -2106,7 +2471,7 @@ HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* p
 
     struct CA_PERF_RECORD_SAMPLE rec;
 
-    char* pCur = (char*)ptr;
+    HRESULT hrDecode = _decodeSampleRecord(ptr, rec);
 
     float weight = 1.0;
 
@@ -2126,8 +2491,6 @@ HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* p
 
     std::stringstream ss;
 
-    memset(&rec, 0, sizeof(struct CA_PERF_RECORD_SAMPLE));
-
     if (m_bVerb)
     {
 
@@ -2139,53 +2502,33 @@ HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* p
         {
             ss << "offset:" << std::setw(10) << offset;
         }
-    }
 
-    if (m_bVerb)
-    {
         ss << ", hdr.misc:0x" << std::hex << pHdr->misc;
-    }
-
-    if (m_bVerb && m_sampleType & PERF_SAMPLE_TIME)
-    {
-        ss << ", time:0x" << std::hex << std::setw(16) << std::setfill('0') << *((u64*)(pCur + 8 + 4 + 4));
-    }
 
-    if (m_sampleType & PERF_SAMPLE_IP)
-    {
-        rec.ip = *((u64*)pCur);
-        pCur += 8;
+        if (m_sampleType & PERF_SAMPLE_TIME)
+        {
+            ss << ", time:0x" << std::hex << std::setw(16) << std::setfill('0') << rec.time;
+        }
 
-        if (m_bVerb)
+        if (m_sampleType & PERF_SAMPLE_IP)
         {
             ss << ", ip:0x" << std::hex << std::setw(16) << std::setfill('0') << rec.ip;
         }
-    }
 
-    if (m_sampleType & PERF_SAMPLE_TID)
-    {
-        rec.pid = *((u32*)pCur);
-        pCur += 4;
-
-        if (m_bVerb)
+        if (m_sampleType & PERF_SAMPLE_TID)
         {
             ss << ", pid:" << std::dec << std::setw(10) << rec.pid;
+            ss << ", tid:" << std::dec << std::setw(10) << rec.tid;
         }
 
-        rec.tid = *((u32*)pCur);
-        pCur += 4;
-
-        if (m_bVerb)
+        if (m_sampleType & PERF_SAMPLE_ADDR)
         {
-            ss << ", tid:" << std::dec << std::setw(10) << rec.tid;
+            ss << ", addr:0x" << std::hex << std::setw(16) << std::setfill('0') << rec.addr;
         }
     }
 
     if (m_sampleType & PERF_SAMPLE_TIME)
     {
-        rec.time = *((u64*)pCur);
-        pCur += 8;
-
         if (PASS2_MODE_SERIAL == m_pass2Mode)
         {
             if (0 == m_lastEvBlkStartTs)
@@ -2195,21 +2538,8 @@ HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* p
         }
     }
 
-    if (m_sampleType & PERF_SAMPLE_ADDR)
-    {
-        rec.addr = *((u64*)pCur);
-        pCur += 8;
-
-        if (m_bVerb)
-        {
-            //OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"addr:0x%016llx", rec.ip);
-            ss << ", addr:0x" << std::hex << std::setw(16) << std::setfill('0') << rec.ip;
-        }
-    }
-
     if (m_sampleType & PERF_SAMPLE_ID)
     {
-        rec.id = *((u64*)pCur);
         m_lastProcessedEvId = rec.id;
 
         if (PASS2_MODE_SERIAL == m_pass2Mode)
@@ -2247,13 +2577,9 @@ HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* p
             }
         }
 
-        pCur += 8;
-
         if (m_bVerb)
         {
-            //OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"id:0x%016llx", rec.id);
             ss << ", id:0x" << std::hex << std::setw(16) << std::setfill('0') << rec.id;
-
         }
     }
 
@@ -2265,30 +2591,13 @@ HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* p
         }
 
         OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"%hs", ss.str().c_str());
-    }
 
-    if (m_sampleType & PERF_SAMPLE_CPU)
-    {
-        rec.cpu = *((u32*)pCur);
-        pCur += 4;
-
-        // This is for the "res" as list in teh perf_event.h
-        pCur += 4;
-
-        if (m_bVerb)
+        if (m_sampleType & PERF_SAMPLE_CPU)
         {
             OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"cpu:0x08%x", rec.cpu);
         }
-    }
-
-    //-----------------------------------------------------
-
-    if (m_sampleType & PERF_SAMPLE_PERIOD)
-    {
-        rec.period = *((u64*)pCur);
-        pCur += 8;
 
-        if (m_bVerb)
+        if (m_sampleType & PERF_SAMPLE_PERIOD)
         {
             OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"period:0x%016llx", rec.period);
         }
@@ -2296,148 +2605,45 @@ HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* p
 
     if (m_sampleType & PERF_SAMPLE_READ)
     {
-        gtUInt64 read_format = 0;
-        read_format |= PERF_FORMAT_TOTAL_TIME_ENABLED;
-        read_format |= PERF_FORMAT_TOTAL_TIME_RUNNING;
-        read_format |= PERF_FORMAT_ID;
-
-        // Baskar: PERF_FORMAT_GROUP is not used by CaPerf
-        if (read_format & PERF_FORMAT_GROUP)
-        {
-            return E_NOTSUPPORTED;
-        }
-
-        // Read the event count value
-        rec.values.value = *((u64*)pCur);
-        pCur += 8;
-
-        if (read_format & PERF_FORMAT_TOTAL_TIME_ENABLED)
-        {
-            rec.values.time_enabled = *((u64*)pCur);
-            pCur += 8;
-        }
-
-        if (read_format & PERF_FORMAT_TOTAL_TIME_RUNNING)
-        {
-            rec.values.time_running = *((u64*)pCur);
-            pCur += 8;
-        }
-
-        if (read_format && PERF_FORMAT_ID)
-        {
-            rec.values.id = *((u64*)pCur);
-            pCur += 8;
-        }
-
-        EvtIdPreviousMap::iterator prevIt =  m_previousMap.find(rec.id);
-        PreviousTimes prevTime;
-
-        //If we have a record of the previous times for this event id
-        if (m_previousMap.end() != prevIt)
-        {
-            prevTime = prevIt->second;
-        }
-        else
-        {
-            prevTime.previousEnabledTime = 0;
-            prevTime.previousRunningTime = 0;
-        }
-
-        //Calculate the weight of this sample, based on the running time given by perf, rounded up
-        // Baskar: Fix for BUG368631: junk values shown in CSS on RHEL 6.2.
-        // Only if we know the previous running and enabled time, we should
-        // compute the weight
-        if ((!prevTime.previousEnabledTime) && (!prevTime.previousRunningTime))
-        {
-            weight = double(rec.values.time_enabled - prevTime.previousEnabledTime)
-                     / double(rec.values.time_running - prevTime.previousRunningTime) + 0.5;
-        }
-
-        //Save the times to get the correct diff for the next sample weight
-        prevTime.previousEnabledTime = rec.values.time_enabled;
-        prevTime.previousRunningTime = rec.values.time_running;
-        m_previousMap[rec.id] = prevTime;
-
-        if (m_bVerb)
-        {
-            OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"read_format:{value:0x%016llx, time_enabled:0x%016llx, "
-                                       L"time_running:0x%016llx, id:0x%016llx}, weighted: %0.2f",
-                                       rec.values.value, rec.values.time_enabled,
-                                       rec.values.time_running, rec.values.id, weight);
-        }
+        weight = _getSampleWeight(rec);
     }
 
-    if (m_sampleType & PERF_SAMPLE_STREAM_ID)
+    if (m_bVerb)
     {
-        rec.stream_id = *((u64*)pCur);
-        pCur += 8;
-
-        if (m_bVerb)
+        if (m_sampleType & PERF_SAMPLE_STREAM_ID)
         {
             OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"stream_id:0x%016llx", rec.stream_id);
         }
-    }
 
-    if (m_sampleType & PERF_SAMPLE_CALLCHAIN)
-    {
-        rec.callchain = (struct ip_callchain*)pCur;
-
-        // Sanity check
-        if (!rec.callchain)
-        {
-            return E_UNEXPECTED;
-        }
-
-        if (m_bVerb)
+        if (nullptr != rec.callchain)
         {
             OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"nr_callchain:%03lu", rec.callchain->nr);
         }
+    }
 
-        // Sanity check. The first entry of call chain must be PERF_CONTEXT_xxx enums
-        if ((0 < rec.callchain->nr) && (rec.callchain->ips[0] < PERF_CONTEXT_MAX))
+    if (S_OK != hrDecode)
+    {
+        if (m_bVerb)
         {
-            if (m_bVerb)
-            {
-                OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"Invalid callchain info (nr = %lu(%lx))",
-                                           rec.callchain->nr, rec.callchain->nr);
-            }
-
-            return E_FAIL;
+            OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"Invalid callchain info (nr = %lu(%lx))",
+                                       rec.callchain->nr, rec.callchain->nr);
         }
 
-        pCur += sizeof(gtUInt64) * (rec.callchain->nr + 1);
-    }
-    else
-    {
-        rec.callchain = nullptr;
+        return hrDecode;
     }
 
-    if (m_sampleType & PERF_SAMPLE_RAW)
+    if (m_bVerb && (m_sampleType & PERF_SAMPLE_RAW))
     {
-        rec.raw_size = *((u32*)pCur);
-        pCur += 4;
-
-        rec.raw_data = (void*)pCur;
+        const char* pRaw = static_cast<const char*>(rec.raw_data);
+        gtString outMsg;
+        outMsg.appendFormattedString(L"raw_data[%u]: ", rec.raw_size);
 
-        if (m_bVerb)
-        {
-            gtString outMsg;
-            outMsg.appendFormattedString(L"raw_data[%u]: ", rec.raw_size);
-
-            for (size_t i = 0 ; i < rec.raw_size; i++)
-            {
-                char* tmp = pCur;
-                outMsg.appendFormattedString(L"%02x ", 0xff & *tmp);
-                pCur += 1; //next character
-            }
-
-            OS_OUTPUT_DEBUG_LOG(outMsg.asCharArray(), OS_DEBUG_LOG_INFO);
-        }
-        else
+        for (size_t i = 0 ; i < rec.raw_size; i++)
         {
-            // Skip raw records
-            pCur += (rec.raw_size);
+            outMsg.appendFormattedString(L"%02x ", 0xff & pRaw[i]);
         }
+
+        OS_OUTPUT_DEBUG_LOG(outMsg.asCharArray(), OS_DEBUG_LOG_INFO);
     }
 
     ModLoadInfoMap::reverse_iterator modRit;
@@ -2655,234 +2861,29 @@ HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* p
 
 #endif
 
+    // Java samples go to the JIT'ed module, the others to the module of their mmap record
+    CpuProfileProcess* pSampleProc = pJavaProc;
+    CpuProfileModule* pSampleMod = pJavaMod;
+    gtUInt64 ldAddr = gJavaJclModInfo.ModuleStartAddr;
+    gtUInt32 ldSize = gJavaJclModInfo.Modulesize;
+
+    if (false == isJavaProcess)
+    {
+        pSampleProc = modRit->second.pProc;
+        pSampleMod = modRit->second.pMod;
+        ldAddr = funcBaseAddr;
+        ldSize = funcSize;
+    }
+
     // IBS Fetch event
     if (event == IBS_FETCH_BASE)
     {
-        // Populate trans_fetch
-        struct ibs_fetch_sample trans_fetch;
-        gtUInt32* pTmp = (gtUInt32*) rec.raw_data;
-        pTmp++; // Skipping the first 4 bytes
-
-        trans_fetch.ibs_fetch_ctl_low = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_fetch_ctl_low        = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_fetch.ibs_fetch_ctl_high = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_fetch_ctl_high       = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_fetch.ibs_fetch_lin_addr_low = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_fetch_lin_addr_low   = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_fetch.ibs_fetch_lin_addr_high = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_fetch_lin_addr_high  = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_fetch.ibs_fetch_phys_addr_low = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_fetch_phys_addr_low  = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_fetch.ibs_fetch_phys_addr_high = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_fetch_phys_addr_high = 0x%08x", *pTmp); }
-
-        gtUInt32 ibs_fetch_selected_flag = 0xffffffff;
-
-        gtUInt64 ibsOffset = trans_fetch.ibs_fetch_lin_addr_high;
-        ibsOffset = ibsOffset << 32;
-        ibsOffset += trans_fetch.ibs_fetch_lin_addr_low;
-
-        if (isJavaProcess)
-        {
-            trans_ibs_fetch(
-                &trans_fetch, ibs_fetch_selected_flag,
-                pJavaProc,
-                gJavaJclModInfo.ModuleStartAddr,
-                gJavaJclModInfo.Modulesize,
-                pJavaMod,
-                ibsOffset,
-                rec.pid, rec.tid, cpu,
-                os, usr, weight,
-                pFuncInfo);
-        }
-        else
-        {
-            trans_ibs_fetch(
-                &trans_fetch, ibs_fetch_selected_flag,
-                modRit->second.pProc,
-                funcBaseAddr,
-                funcSize,
-                modRit->second.pMod,
-                ibsOffset,
-                rec.pid, rec.tid, cpu,
-                os, usr, weight,
-                pFuncInfo);
-        }
+        _translateIbsFetchSample(rec, pSampleProc, ldAddr, ldSize, pSampleMod, cpu, os, usr, weight, pFuncInfo);
     }
     // IBS OP events
     else if (event == IBS_OP_BASE)
     {
-        // Populate trans_op
-        struct ibs_op_sample trans_op;
-        gtUInt32* pTmp = (gtUInt32*) rec.raw_data;
-        pTmp++; // Skipping the first 4 bytes
-
-        trans_op.ibs_op_ctrl_low = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_ctrl_low       = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_ctrl_high = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_ctrl_high      = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_lin_addr_low = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_lin_addr_low   = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_lin_addr_high = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_lin_addr_high  = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_data1_low = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_data1_low      = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_data1_high = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_data1_high     = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_data2_low = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_data2_low      = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_data2_high = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_data2_high     = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_data3_low = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_data3_low      = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_data3_high = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_data3_high     = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_ldst_linaddr_low = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_linaddr_low    = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_ldst_linaddr_high = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_linaddr_high   = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_phys_addr_low = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_phys_addr_low  = 0x%08x", *pTmp); }
-
-        pTmp++;
-        trans_op.ibs_op_phys_addr_high = *pTmp;
-
-        if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_phys_addr_high = 0x%08x", *pTmp); }
-
-        trans_op.ibs_op_brtgt_addr = 0;
-
-        trans_ibs_op_mask_reserved(m_family, &trans_op);
-
-        if (trans_ibs_op_rip_invalid(&trans_op) == 0)
-        {
-
-            gtUInt32 ibs_op_selected_flag = 0xffffffff;
-            gtUInt32 ibs_op_ls_selected_flag = 0xffffffff;
-            gtUInt32 ibs_op_nb_selected_flag = 0xffffffff;
-
-            gtUInt64 ibsOffset = trans_op.ibs_op_lin_addr_high;
-            ibsOffset = ibsOffset << 32;
-            ibsOffset += trans_op.ibs_op_lin_addr_low;
-
-            if (isJavaProcess) {
-                trans_ibs_op(
-                    &trans_op, ibs_op_selected_flag,
-                    pJavaProc,
-                    gJavaJclModInfo.ModuleStartAddr,
-                    gJavaJclModInfo.Modulesize,
-                    pJavaMod,
-                    ibsOffset, rec.pid, rec.tid, cpu,
-                    os, usr, weight,
-                    pFuncInfo);
-
-                trans_ibs_op_ls(
-                    &trans_op, ibs_op_ls_selected_flag,
-                    pJavaProc,
-                    gJavaJclModInfo.ModuleStartAddr,
-                    gJavaJclModInfo.Modulesize,
-                    pJavaMod,
-                    ibsOffset, rec.pid, rec.tid, cpu,
-                    os, usr, weight,
-                    pFuncInfo);
-
-                trans_ibs_op_nb(
-                    &trans_op, ibs_op_nb_selected_flag,
-                    pJavaProc,
-                    gJavaJclModInfo.ModuleStartAddr,
-                    gJavaJclModInfo.Modulesize,
-                    pJavaMod,
-                    ibsOffset, rec.pid, rec.tid, cpu,
-                    os, usr, weight,
-                    pFuncInfo);
-            }
-            else
-            {
-                trans_ibs_op(
-                    &trans_op, ibs_op_selected_flag,
-                    modRit->second.pProc,
-                    funcBaseAddr, funcSize, modRit->second.pMod,
-                    ibsOffset, rec.pid, rec.tid, cpu,
-                    os, usr, weight,
-                    pFuncInfo);
-
-                trans_ibs_op_ls(
-                    &trans_op, ibs_op_ls_selected_flag,
-                    modRit->second.pProc,
-                    funcBaseAddr, funcSize, modRit->second.pMod,
-                    ibsOffset, rec.pid, rec.tid, cpu,
-                    os, usr, weight,
-                    pFuncInfo);
-
-                trans_ibs_op_nb(
-                    &trans_op, ibs_op_nb_selected_flag,
-                    modRit->second.pProc,
-                    funcBaseAddr, funcSize, modRit->second.pMod,
-                    ibsOffset, rec.pid, rec.tid, cpu,
-                    os, usr, weight,
-                    pFuncInfo);
-            }
-
-#ifdef HAS_DCMISS
-            trans_ibs_op_ls_dcmiss(trans_op);
-#endif
-#ifdef HAS_BTA
-            trans_ibs_op_bta(trans_op);
-#endif
-        }
-
+        _translateIbsOpSample(rec, pSampleProc, ldAddr, ldSize, pSampleMod, cpu, os, usr, weight, pFuncInfo);
     }
     // Non IBS events
     else
@@ -2919,34 +2920,21 @@ HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* p
                 m_aFakeFlags[cpu] = false;
 
                 // Add fake timer sample
+                _addSampleToProcessAndModule(
+                    pSampleProc,
+                    ldAddr, ldSize, pSampleMod,
+                    rec.ip, rec.pid, rec.tid, cpu,
+                    f_event, f_umask, f_os, f_usr,
+                    weight,
+                    pFuncInfo);
+
                 if (false == isJavaProcess)
                 {
-                    _addSampleToProcessAndModule(
-                        modRit->second.pProc,
-                        funcBaseAddr, funcSize, modRit->second.pMod,
-                        rec.ip, rec.pid, rec.tid, cpu,
-                        f_event, f_umask, f_os, f_usr,
-                        weight,
-                        pFuncInfo);
-
                     evMask = _getEvmask(f_event, f_umask, f_os, f_usr);
 
                     // Process css for fake timer
                     _processCSS(pHdr, rec, evMask, weight, modRit);
                 }
-                else
-                {
-                    _addSampleToProcessAndModule(
-                        pJavaProc,
-                        gJavaJclModInfo.ModuleStartAddr,
-                        gJavaJclModInfo.Modulesize,
-                        pJavaMod,
-                        rec.ip, rec.pid, rec.tid, cpu,
-                        f_event, f_umask, f_os, f_usr,
-                        weight,
-                        pFuncInfo);
-
-                }
 
                 m_numSamples += weight;
 
@@ -2961,28 +2949,13 @@ HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* p
 #endif
 
         // Process sample for normal events
-        if (isJavaProcess)
-        {
-            _addSampleToProcessAndModule(
-                pJavaProc,
-                gJavaJclModInfo.ModuleStartAddr,
-                gJavaJclModInfo.Modulesize,
-                pJavaMod,
-                rec.ip, rec.pid, rec.tid, cpu,
-                event, umask, os, usr,
-                weight,
-                pFuncInfo);
-        }
-        else
-        {
-            _addSampleToProcessAndModule(
-                modRit->second.pProc,
-                funcBaseAddr, funcSize, modRit->second.pMod,
-                rec.ip, rec.pid, rec.tid, cpu,
-                event, umask, os, usr,
-                weight,
-                pFuncInfo);
-        }
+        _addSampleToProcessAndModule(
+            pSampleProc,
+            ldAddr, ldSize, pSampleMod,
+            rec.ip, rec.pid, rec.tid, cpu,
+            event, umask, os, usr,
+            weight,
+            pFuncInfo);
     }
 
     if (false == isJavaProcess)
@@ -2994,12 +2967,196 @@ HRESULT CaPerfTranslator::process_PERF_RECORD_SAMPLE(struct perf_event_header* p
 
     m_numSamples += weight;
 
-    return S_OK;
+    return S_OK;
+
+}
+
+
+// Decodes the raw IBS fetch registers of a sample and aggregates the derived IBS fetch events
+void CaPerfTranslator::_translateIbsFetchSample(const struct CA_PERF_RECORD_SAMPLE& rec,
+                                                CpuProfileProcess* pProc,
+                                                gtUInt64 ldAddr, gtUInt32 funcSize, CpuProfileModule* pMod,
+                                                gtUInt32 cpu, gtUInt32 os, gtUInt32 usr, gtUInt32 count,
+                                                const FunctionSymbolInfo* pFuncInfo)
+{
+    // Populate trans_fetch
+    struct ibs_fetch_sample trans_fetch;
+    const gtUInt32* pTmp = (const gtUInt32*) rec.raw_data;
+    pTmp++; // Skipping the first 4 bytes
+
+    trans_fetch.ibs_fetch_ctl_low = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_fetch_ctl_low        = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_fetch.ibs_fetch_ctl_high = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_fetch_ctl_high       = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_fetch.ibs_fetch_lin_addr_low = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_fetch_lin_addr_low   = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_fetch.ibs_fetch_lin_addr_high = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_fetch_lin_addr_high  = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_fetch.ibs_fetch_phys_addr_low = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_fetch_phys_addr_low  = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_fetch.ibs_fetch_phys_addr_high = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_fetch_phys_addr_high = 0x%08x", *pTmp); }
+
+    gtUInt32 ibs_fetch_selected_flag = 0xffffffff;
+
+    gtUInt64 ibsOffset = trans_fetch.ibs_fetch_lin_addr_high;
+    ibsOffset = ibsOffset << 32;
+    ibsOffset += trans_fetch.ibs_fetch_lin_addr_low;
+
+    trans_ibs_fetch(
+        &trans_fetch, ibs_fetch_selected_flag,
+        pProc, ldAddr, funcSize, pMod,
+        ibsOffset,
+        rec.pid, rec.tid, cpu,
+        os, usr, count,
+        pFuncInfo);
+}
+
+
+// Decodes the raw IBS op registers of a sample and aggregates the derived IBS op events
+void CaPerfTranslator::_translateIbsOpSample(const struct CA_PERF_RECORD_SAMPLE& rec,
+                                             CpuProfileProcess* pProc,
+                                             gtUInt64 ldAddr, gtUInt32 funcSize, CpuProfileModule* pMod,
+                                             gtUInt32 cpu, gtUInt32 os, gtUInt32 usr, gtUInt32 count,
+                                             const FunctionSymbolInfo* pFuncInfo)
+{
+    // Populate trans_op
+    struct ibs_op_sample trans_op;
+    const gtUInt32* pTmp = (const gtUInt32*) rec.raw_data;
+    pTmp++; // Skipping the first 4 bytes
+
+    trans_op.ibs_op_ctrl_low = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_ctrl_low       = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_ctrl_high = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_ctrl_high      = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_lin_addr_low = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_lin_addr_low   = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_lin_addr_high = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_lin_addr_high  = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_data1_low = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_data1_low      = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_data1_high = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_data1_high     = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_data2_low = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_data2_low      = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_data2_high = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_data2_high     = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_data3_low = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_data3_low      = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_data3_high = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_data3_high     = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_ldst_linaddr_low = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_linaddr_low    = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_ldst_linaddr_high = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_linaddr_high   = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_phys_addr_low = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_phys_addr_low  = 0x%08x", *pTmp); }
+
+    pTmp++;
+    trans_op.ibs_op_phys_addr_high = *pTmp;
+
+    if (m_bVerb) { OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"ibs_op_phys_addr_high = 0x%08x", *pTmp); }
+
+    trans_op.ibs_op_brtgt_addr = 0;
+
+    trans_ibs_op_mask_reserved(m_family, &trans_op);
+
+    if (trans_ibs_op_rip_invalid(&trans_op) == 0)
+    {
+
+        gtUInt32 ibs_op_selected_flag = 0xffffffff;
+        gtUInt32 ibs_op_ls_selected_flag = 0xffffffff;
+        gtUInt32 ibs_op_nb_selected_flag = 0xffffffff;
+
+        gtUInt64 ibsOffset = trans_op.ibs_op_lin_addr_high;
+        ibsOffset = ibsOffset << 32;
+        ibsOffset += trans_op.ibs_op_lin_addr_low;
+
+        trans_ibs_op(
+            &trans_op, ibs_op_selected_flag,
+            pProc, ldAddr, funcSize, pMod,
+            ibsOffset, rec.pid, rec.tid, cpu,
+            os, usr, count,
+            pFuncInfo);
+
+        trans_ibs_op_ls(
+            &trans_op, ibs_op_ls_selected_flag,
+            pProc, ldAddr, funcSize, pMod,
+            ibsOffset, rec.pid, rec.tid, cpu,
+            os, usr, count,
+            pFuncInfo);
+
+        trans_ibs_op_nb(
+            &trans_op, ibs_op_nb_selected_flag,
+            pProc, ldAddr, funcSize, pMod,
+            ibsOffset, rec.pid, rec.tid, cpu,
+            os, usr, count,
+            pFuncInfo);
 
+#ifdef HAS_DCMISS
+        trans_ibs_op_ls_dcmiss(trans_op);
+#endif
+#ifdef HAS_BTA
+        trans_ibs_op_bta(trans_op);
+#endif
+    }
 }
 
 
-int CaPerfTranslator::process_PERF_RECORD_FORK(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index)
+int CaPerfTranslator::process_PERF_RECORD_FORK(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index)
 {
     (void)(offset); // unused
     struct CA_PERF_RECORD_FORK_EXIT rec;
@@ -3088,7 +3245,7 @@ int CaPerfTranslator::process_PERF_RECORD_FORK(struct perf_event_header* pHdr, v
 }
 
 
-HRESULT CaPerfTranslator::process_PERF_RECORD_EXIT(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index)
+HRESULT CaPerfTranslator::process_PERF_RECORD_EXIT(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index)
 {
     (void)(offset); // unused
     struct CA_PERF_RECORD_FORK_EXIT rec;
@@ -3364,10 +3521,11 @@ int CaPerfTranslator::writeEbpOutput(const std::string& outputFile)
     gettimeofday(&ebp_timerStop, nullptr);
     memcpy(&css_timerStart, &ebp_timerStop, sizeof(struct timeval));
 
-    m_dbWriter.reset(new ProfilerDataDBWriter);
-
-    if (m_dbWriter)
+    // The online translation has already created the DB and written the data collected until the last flush
+    if (!m_isOnlineDb)
     {
+        m_dbWriter.reset(new ProfilerDataDBWriter);
+
         if (!m_dbWriter->Initialize(woutputFile))
         {
             m_dbWriter.reset(nullptr);
@@ -3516,256 +3674,8 @@ int CaPerfTranslator::writeEbpOutput(const std::string& outputFile)
             funcInfoList = nullptr;
         }
 
-        // Populate process info and insert into DB.
-        CPAProcessList *processList = new (std::nothrow) CPAProcessList;
-
-        if (nullptr != processList)
-        {
-            processList->reserve(m_procMap.size());
-
-            for (auto procIt : m_procMap)
-            {
-                if (procIt.second.getTotal())
-                {
-                    processList->emplace_back(procIt.first, procIt.second.getPath(), procIt.second.m_is32Bit, procIt.second.m_hasCss);
-                }
-            }
-
-            m_dbWriter->Push({ TRANSLATED_DATA_TYPE_PROCESS_INFO, (void*)processList });
-            processList = nullptr;
-        }
-
-        gtSet<gtUInt64> processThreadList;
-
-        for (const auto& module : m_modMap)
-        {
-            if (module.second.getTotal())
-            {
-                for (auto fit = module.second.getBeginFunction(); fit != module.second.getEndFunction(); ++fit)
-                {
-                    for (auto aptIt = fit->second.getBeginSample(); aptIt != fit->second.getEndSample(); ++aptIt)
-                    {
-                        gtUInt32 pid = aptIt->first.m_pid;
-                        gtUInt32 threadId = aptIt->first.m_tid;
-
-                        gtUInt64 ptId = pid;
-                        ptId = (ptId << 32) | threadId;
-
-                        processThreadList.insert(ptId);
-                    }
-                }
-            }
-        }
-
-        CPAProcessThreadList *procThreadIdList = new (std::nothrow) CPAProcessThreadList;
-
-        if (nullptr != procThreadIdList)
-        {
-            procThreadIdList->reserve(processThreadList.size());
-
-            for (auto& ptId : processThreadList)
-            {
-                gtUInt32 pid = ptId >> 32;
-                gtUInt32 threadId = ptId & 0xFFFFFFFF;
-
-                procThreadIdList->emplace_back(ptId, static_cast<gtUInt64>(pid), threadId);
-            }
-
-            m_dbWriter->Push({ TRANSLATED_DATA_TYPE_THREAD_INFO, (void*)procThreadIdList });
-            procThreadIdList = nullptr;
-        }
-
-        processThreadList.clear();
-
-        // Populate module info
-        CPAModuleList *moduleList = new (std::nothrow) CPAModuleList;
-
-        if (nullptr != moduleList)
-        {
-            moduleList->reserve(m_modMap.size());
-
-            for (const auto& m : m_modMap)
-            {
-                //if (m.second.getTotal())
-                {
-                    moduleList->emplace_back(m.second.m_moduleId,
-                        m.first,
-                        m.second.m_size,
-                        m.second.m_modType,
-                        osIsSystemModule(m.first),
-                        m.second.m_is32Bit,
-                        m.second.m_isDebugInfoAvailable);
-                }
-            }
-
-            m_dbWriter->Push({ TRANSLATED_DATA_TYPE_MODULE_INFO, (void*)moduleList });
-            moduleList = nullptr;
-        }
-
-        // Populate module instance info
-        // modInstanceInfoMap : Map of < instanceId, tuple of <modName, pid, loadAddr> >
-        CPAModuleInstanceList *moduleInstanceList = new (std::nothrow) CPAModuleInstanceList;
-
-        if (nullptr != moduleInstanceList)
-        {
-            moduleInstanceList->reserve(m_modLoadInfoMap.size());
-
-            for (const auto& modIns : m_modLoadInfoMap)
-            {
-                // This can be optimized further. Instead of passing module name, we can pass moduleId.
-                gtString modName;
-                modName.fromUtf8String(modIns.second.name);
-
-                // Update module, so that it can be used while inserting samples
-                if (nullptr != modIns.second.pMod)
-                {
-                    modIns.second.pMod->m_moduleInstanceInfo.emplace_back(modIns.first.pid, modIns.first.addr, modIns.second.instanceId);
-                }
-
-                gtUInt32 moduleId = 0;
-                const auto& it = m_modMap.find(modName);
-
-                //if (it != m_modMap.end() && it->second.getTotal())
-                if (it != m_modMap.end())
-                {
-                    // Insert into DB only if the module has samples
-                    moduleId = it->second.m_moduleId;
-                    moduleInstanceList->emplace_back(
-                            modIns.second.instanceId,
-                            moduleId,
-                            static_cast<gtUInt64>(modIns.first.pid),
-                            modIns.first.addr);
-                }
-            }
-
-            m_dbWriter->Push({ TRANSLATED_DATA_TYPE_MODINSTANCE_INFO, (void*)moduleInstanceList });
-            moduleInstanceList = nullptr;
-        }
-
-        // Populate function info
-        funcInfoList = new (std::nothrow) CPAFunctionInfoList;
-
-        if (nullptr != funcInfoList)
-        {
-            // Let us assume one function from each module
-            funcInfoList->reserve(m_modMap.size());
-
-            for (auto& module : m_modMap)
-            {
-                if (module.second.getTotal() > 0)
-                {
-                    gtUInt32 modId = module.second.m_moduleId;
-                    gtUInt64 modLoadAddr = module.second.getBaseAddr();
-
-                    for (auto fit = module.second.getBeginFunction(); fit != module.second.getEndFunction(); ++fit)
-                    {
-                        gtString funcName = fit->second.getFuncName();
-                        gtUInt64 startOffset = fit->second.getBaseAddr() - modLoadAddr;
-                        gtUInt64 size = fit->second.getSize();
-                        gtUInt32 funcId = modId;
-                        funcId = ((funcId << 16) | fit->second.m_functionId);
-
-                        bool doInsert = funcName.isEmpty() ? false : true;
-
-                        if ((!doInsert) && ((funcId & 0x0000ffff) > 0))
-                        {
-                            osFilePath aPath(module.second.getPath());
-                            aPath.getFileNameAndExtension(funcName);
-                            funcName.appendFormattedString(L"!0x%lx", startOffset + modLoadAddr);
-                            doInsert = true;
-                        }
-
-                        if (doInsert)
-                        {
-                            funcInfoList->emplace_back(funcId, modId, funcName, startOffset, size);
-                        }
-                    }
-                }
-            }
-
-            m_dbWriter->Push({ TRANSLATED_DATA_TYPE_FUNCTION_INFO, (void*)funcInfoList });
-            funcInfoList = nullptr;
-        }
-
-        // Populate sample info
-        CPASampeInfoList *sampleList = new (std::nothrow) CPASampeInfoList;
-
-        if (nullptr != sampleList)
-        {
-            const gtUInt32 unusedBitsMask = 0x3FFFFFF;
-
-            // Assume minimum 1000 samples
-            sampleList->reserve(1000);
-
-            for (const auto& module : m_modMap)
-            {
-                gtUInt32 modSize = module.second.m_size;
-
-                bool isJitModule = ((CpuProfileModule::JAVAMODULE == module.second.getModType())
-                    || (CpuProfileModule::MANAGEDPE == module.second.getModType())) ? true : false;
-
-                for (auto fit = module.second.getBeginFunction(); fit != module.second.getEndFunction(); ++fit)
-                {
-                    gtUInt32 funcId = module.second.m_moduleId;
-                    funcId = (funcId << 16) | fit->second.m_functionId;
-
-                    for (auto aptIt = fit->second.getBeginSample(); aptIt != fit->second.getEndSample(); ++aptIt)
-                    {
-                        gtUInt64 pid = aptIt->first.m_pid;
-                        gtUInt32 threadId = aptIt->first.m_tid;
-                        gtVAddr  sampleAddr = aptIt->first.m_addr;
-                        gtUInt32 moduleInstanceid = 0ULL;
-                        gtVAddr  modLoadAddr = 0ULL;
-
-                        if (!isJitModule)
-                        {
-                            for (const auto& it : module.second.m_moduleInstanceInfo)
-                            {
-                                modLoadAddr = std::get<1>(it);
-                                gtVAddr modEndAddr = modLoadAddr + modSize;
-
-                                if ((std::get<0>(it) == pid))
-                                {
-                                    // 1. sampleAddr falls within module size limit.
-                                    // 2. module size is 0, pick the first match.
-                                    if ((modLoadAddr <= sampleAddr) && ((sampleAddr < modEndAddr) || (0 == modSize)))
-                                    {
-                                        moduleInstanceid = std::get<2>(it);
-                                        break;
-                                    }
-                                }
-                            }
-                        }
-                        else
-                        {
-                            modLoadAddr = fit->second.getBaseAddr();
-
-                            if (!module.second.m_moduleInstanceInfo.empty())
-                            {
-                                moduleInstanceid = std::get<2>(module.second.m_moduleInstanceInfo.at(0));
-                            }
-                        }
-
-                        // sample address offset is w.r.t. module load address
-                        gtUInt64 sampleOffset = sampleAddr - modLoadAddr;
-                        gtUInt64 processThreadId = pid;
-                        processThreadId = (processThreadId << 32) | threadId;
-
-                        for (auto skIt = aptIt->second.getBeginSample(); skIt != aptIt->second.getEndSample(); ++skIt)
-                        {
-                            gtUInt64 sampleCount = skIt->second;
-                            gtUInt64 coreSamplingConfigId = skIt->first.cpu;
-                            coreSamplingConfigId = (coreSamplingConfigId << 32) | (skIt->first.event & unusedBitsMask);
-
-                            sampleList->emplace_back(processThreadId, moduleInstanceid, coreSamplingConfigId, funcId, sampleOffset, sampleCount);
-                        }
-                    }
-                }
-            }
-
-            m_dbWriter->Push({ TRANSLATED_DATA_TYPE_SAMPLE_INFO, (void*)sampleList });
-            sampleList = nullptr;
-        }
+        // Populate the processes, threads, modules, functions and samples not written yet
+        _pushProfileData(true);
     }
 
 #if ENABLE_OLD_PROFILE_WRITER
@@ -3907,103 +3817,443 @@ int CaPerfTranslator::writeEbpOutput(const std::string& outputFile)
             }
         }
 
-        // Populate Java JIT instance info
-        CPAJitInstanceInfoList *jitInstanceInfoList = new (std::nothrow) CPAJitInstanceInfoList;
+        // Populate Java JIT instance info
+        CPAJitInstanceInfoList *jitInstanceInfoList = new (std::nothrow) CPAJitInstanceInfoList;
+
+        if (jitInstanceInfoList != nullptr)
+        {
+            // <jncIdx, moduleName, instanceId, pid, loadAddr, size>
+            gtVector<std::tuple<gtUInt32, gtString, gtUInt32, gtUInt64, gtUInt64, gtUInt64>> jitBlockInfo;
+
+            m_javaModInfo.GetJavaJitBlockInfo(jitBlockInfo);
+
+            jitInstanceInfoList->reserve(jitBlockInfo.size() + inlinedJitInfo.size());
+
+            for (const auto& it : jitBlockInfo)
+            {
+                gtUInt32 jitId = std::get<0>(it);
+
+                // Compute function id.
+                gtUInt64 funcId = 0;
+                gtString modName = std::get<1>(it);
+                auto modIt = m_modMap.find(modName);
+
+                if (m_modMap.end() != modIt)
+                {
+                    funcId = modIt->second.m_moduleId;
+                }
+
+                funcId = (funcId << 16) | std::get<2>(it);
+
+                gtUInt64 pid = std::get<3>(it);
+                gtUInt64 loadAddr = std::get<4>(it);
+                gtUInt32 size = static_cast<gtUInt32>(std::get<5>(it));
+
+                jitInstanceInfoList->emplace_back(jitId, funcId, pid, loadAddr, size);
+            }
+
+            jitBlockInfo.clear();
+
+            for (const auto& it : inlinedJitInfo)
+            {
+                gtUInt32 jitId = std::get<0>(it);
+
+                // Compute function id.
+                gtUInt64 funcId = std::get<1>(it);
+                funcId = (funcId << 16) | std::get<2>(it);
+
+                gtUInt64 pid = std::get<3>(it);
+                gtUInt64 loadAddr = std::get<4>(it);
+                gtUInt32 size = static_cast<gtUInt32>(std::get<5>(it));
+
+                jitInstanceInfoList->emplace_back(jitId, funcId, pid, loadAddr, size);
+            }
+
+            m_dbWriter->Push({ TRANSLATED_DATA_TYPE_JITINSTANCE_INFO, (void*)jitInstanceInfoList });
+            jitInstanceInfoList = nullptr;
+            inlinedJitInfo.clear();
+        }
+
+        // Populate Java Jnc info.
+        CPAJitCodeBlobInfoList *jitCodeBlobInfoList = new CPAJitCodeBlobInfoList;
+
+        if (jitCodeBlobInfoList != nullptr)
+        {
+            // <jncIdx, srcFilePath, jncFilePath>
+            gtVector<std::tuple<gtUInt32, gtString, gtString>> jncInfoList;
+
+            m_javaModInfo.GetJavaJncInfo(jncInfoList);
+
+            for (const auto& it : jncInfoList)
+            {
+                gtUInt32 jitId = std::get<0>(it);
+                gtString srcFilePath = std::get<1>(it);
+                gtString jncFilePath = std::get<2>(it);
+
+                jitCodeBlobInfoList->emplace_back(jitId, srcFilePath, jncFilePath);
+            }
+
+            jncInfoList.clear();
+            m_dbWriter->Push({ TRANSLATED_DATA_TYPE_JITCODEBLOB_INFO, (void*)jitCodeBlobInfoList });
+            jitCodeBlobInfoList = nullptr;
+        }
+
+        // Finish writing profile data
+        m_dbWriter->Push({ TRANSLATED_DATA_TYPE_UNKNOWN_INFO, nullptr });
+        m_isOnlineDb = false;
+    }
+
+    gettimeofday(&css_timerStop, nullptr);
+
+    if (m_pLogFile)
+    {
+        struct timeval diff;
+        timersub(&ebp_timerStop, &ebp_timerStart, &diff);
+        fprintf(m_pLogFile, "Write EBP time             : %lu sec, %lu usec\n", diff.tv_sec, diff.tv_usec);
+        timersub(&css_timerStop, &css_timerStart, &diff);
+        fprintf(m_pLogFile, "Write CSS time             : %lu sec, %lu usec\n", diff.tv_sec, diff.tv_usec);
+    }
+
+    return bRet ? 0 : 1;
+}
+
+
+void CaPerfTranslator::_pushProfileData(bool isFinal)
+{
+    // Before the profiling stops, only the data of the native modules is written, and the samples
+    // are written once their module instance is known. The JIT modules are written at the end.
+    // What was written by a previous call is tracked only while the online translation writes the DB.
+
+    // Populate process info and insert into DB.
+    CPAProcessList *processList = new (std::nothrow) CPAProcessList;
+
+    if (nullptr != processList)
+    {
+        processList->reserve(m_procMap.size());
+
+        for (auto procIt : m_procMap)
+        {
+            if (procIt.second.getTotal() && (m_flushedProcesses.find(procIt.first) == m_flushedProcesses.end()))
+            {
+                processList->emplace_back(procIt.first, procIt.second.getPath(), procIt.second.m_is32Bit, procIt.second.m_hasCss);
+
+                if (m_isOnlineDb)
+                {
+                    m_flushedProcesses.insert(procIt.first);
+                }
+            }
+        }
+
+        m_dbWriter->Push({ TRANSLATED_DATA_TYPE_PROCESS_INFO, (void*)processList });
+        processList = nullptr;
+    }
+
+    gtSet<gtUInt64> processThreadList;
+
+    for (const auto& module : m_modMap)
+    {
+        if (module.second.getTotal())
+        {
+            for (auto fit = module.second.getBeginFunction(); fit != module.second.getEndFunction(); ++fit)
+            {
+                for (auto aptIt = fit->second.getBeginSample(); aptIt != fit->second.getEndSample(); ++aptIt)
+                {
+                    gtUInt32 pid = aptIt->first.m_pid;
+                    gtUInt32 threadId = aptIt->first.m_tid;
+
+                    gtUInt64 ptId = pid;
+                    ptId = (ptId << 32) | threadId;
+
+                    if (m_flushedProcessThreads.find(ptId) == m_flushedProcessThreads.end())
+                    {
+                        processThreadList.insert(ptId);
+                    }
+                }
+            }
+        }
+    }
+
+    CPAProcessThreadList *procThreadIdList = new (std::nothrow) CPAProcessThreadList;
 
-        if (jitInstanceInfoList != nullptr)
-        {
-            // <jncIdx, moduleName, instanceId, pid, loadAddr, size>
-            gtVector<std::tuple<gtUInt32, gtString, gtUInt32, gtUInt64, gtUInt64, gtUInt64>> jitBlockInfo;
+    if (nullptr != procThreadIdList)
+    {
+        procThreadIdList->reserve(processThreadList.size());
 
-            m_javaModInfo.GetJavaJitBlockInfo(jitBlockInfo);
+        for (auto& ptId : processThreadList)
+        {
+            gtUInt32 pid = ptId >> 32;
+            gtUInt32 threadId = ptId & 0xFFFFFFFF;
 
-            jitInstanceInfoList->reserve(jitBlockInfo.size() + inlinedJitInfo.size());
+            procThreadIdList->emplace_back(ptId, static_cast<gtUInt64>(pid), threadId);
 
-            for (const auto& it : jitBlockInfo)
+            if (m_isOnlineDb)
             {
-                gtUInt32 jitId = std::get<0>(it);
+                m_flushedProcessThreads.insert(ptId);
+            }
+        }
 
-                // Compute function id.
-                gtUInt64 funcId = 0;
-                gtString modName = std::get<1>(it);
-                auto modIt = m_modMap.find(modName);
+        m_dbWriter->Push({ TRANSLATED_DATA_TYPE_THREAD_INFO, (void*)procThreadIdList });
+        procThreadIdList = nullptr;
+    }
 
-                if (m_modMap.end() != modIt)
+    processThreadList.clear();
+
+    // Populate module info
+    CPAModuleList *moduleList = new (std::nothrow) CPAModuleList;
+
+    if (nullptr != moduleList)
+    {
+        moduleList->reserve(m_modMap.size());
+
+        for (const auto& m : m_modMap)
+        {
+            if (m_flushedModules.find(m.second.m_moduleId) != m_flushedModules.end())
+            {
+                continue;
+            }
+
+            if (isFinal || (m.second.getTotal() && !_isJitModule(m.second)))
+            {
+                moduleList->emplace_back(m.second.m_moduleId,
+                    m.first,
+                    m.second.m_size,
+                    m.second.m_modType,
+                    osIsSystemModule(m.first),
+                    m.second.m_is32Bit,
+                    m.second.m_isDebugInfoAvailable);
+
+                if (m_isOnlineDb)
                 {
-                    funcId = modIt->second.m_moduleId;
+                    m_flushedModules.insert(m.second.m_moduleId);
                 }
+            }
+        }
 
-                funcId = (funcId << 16) | std::get<2>(it);
+        m_dbWriter->Push({ TRANSLATED_DATA_TYPE_MODULE_INFO, (void*)moduleList });
+        moduleList = nullptr;
+    }
 
-                gtUInt64 pid = std::get<3>(it);
-                gtUInt64 loadAddr = std::get<4>(it);
-                gtUInt32 size = static_cast<gtUInt32>(std::get<5>(it));
+    // Populate module instance info
+    // modInstanceInfoMap : Map of < instanceId, tuple of <modName, pid, loadAddr> >
+    CPAModuleInstanceList *moduleInstanceList = new (std::nothrow) CPAModuleInstanceList;
 
-                jitInstanceInfoList->emplace_back(jitId, funcId, pid, loadAddr, size);
+    if (nullptr != moduleInstanceList)
+    {
+        moduleInstanceList->reserve(m_modLoadInfoMap.size());
+
+        for (const auto& modIns : m_modLoadInfoMap)
+        {
+            if (m_flushedModuleInstances.find(modIns.second.instanceId) != m_flushedModuleInstances.end())
+            {
+                continue;
             }
 
-            jitBlockInfo.clear();
+            // This can be optimized further. Instead of passing module name, we can pass moduleId.
+            gtString modName;
+            modName.fromUtf8String(modIns.second.name);
 
-            for (const auto& it : inlinedJitInfo)
-            {
-                gtUInt32 jitId = std::get<0>(it);
+            gtUInt32 moduleId = 0;
+            const auto& it = m_modMap.find(modName);
 
-                // Compute function id.
-                gtUInt64 funcId = std::get<1>(it);
-                funcId = (funcId << 16) | std::get<2>(it);
+            // Wait for the module to be written, so that the instance is written only once
+            if (!isFinal && ((it == m_modMap.end()) || _isJitModule(it->second)))
+            {
+                continue;
+            }
 
-                gtUInt64 pid = std::get<3>(it);
-                gtUInt64 loadAddr = std::get<4>(it);
-                gtUInt32 size = static_cast<gtUInt32>(std::get<5>(it));
+            // Update module, so that it can be used while inserting samples
+            if (nullptr != modIns.second.pMod)
+            {
+                modIns.second.pMod->m_moduleInstanceInfo.emplace_back(modIns.first.pid, modIns.first.addr, modIns.second.instanceId);
+            }
 
-                jitInstanceInfoList->emplace_back(jitId, funcId, pid, loadAddr, size);
+            if (m_isOnlineDb)
+            {
+                m_flushedModuleInstances.insert(modIns.second.instanceId);
             }
 
-            m_dbWriter->Push({ TRANSLATED_DATA_TYPE_JITINSTANCE_INFO, (void*)jitInstanceInfoList });
-            jitInstanceInfoList = nullptr;
-            inlinedJitInfo.clear();
+            //if (it != m_modMap.end() && it->second.getTotal())
+            if (it != m_modMap.end())
+            {
+                // Insert into DB only if the module has samples
+                moduleId = it->second.m_moduleId;
+                moduleInstanceList->emplace_back(
+                        modIns.second.instanceId,
+                        moduleId,
+                        static_cast<gtUInt64>(modIns.first.pid),
+                        modIns.first.addr);
+            }
         }
 
-        // Populate Java Jnc info.
-        CPAJitCodeBlobInfoList *jitCodeBlobInfoList = new CPAJitCodeBlobInfoList;
+        m_dbWriter->Push({ TRANSLATED_DATA_TYPE_MODINSTANCE_INFO, (void*)moduleInstanceList });
+        moduleInstanceList = nullptr;
+    }
 
-        if (jitCodeBlobInfoList != nullptr)
-        {
-            // <jncIdx, srcFilePath, jncFilePath>
-            gtVector<std::tuple<gtUInt32, gtString, gtString>> jncInfoList;
+    // Populate function info
+    CPAFunctionInfoList *funcInfoList = new (std::nothrow) CPAFunctionInfoList;
 
-            m_javaModInfo.GetJavaJncInfo(jncInfoList);
+    if (nullptr != funcInfoList)
+    {
+        // Let us assume one function from each module
+        funcInfoList->reserve(m_modMap.size());
 
-            for (const auto& it : jncInfoList)
+        for (auto& module : m_modMap)
+        {
+            if ((module.second.getTotal() > 0) && (isFinal || !_isJitModule(module.second)))
             {
-                gtUInt32 jitId = std::get<0>(it);
-                gtString srcFilePath = std::get<1>(it);
-                gtString jncFilePath = std::get<2>(it);
+                gtUInt32 modId = module.second.m_moduleId;
+                gtUInt64 modLoadAddr = module.second.getBaseAddr();
 
-                jitCodeBlobInfoList->emplace_back(jitId, srcFilePath, jncFilePath);
-            }
+                for (auto fit = module.second.getBeginFunction(); fit != module.second.getEndFunction(); ++fit)
+                {
+                    gtString funcName = fit->second.getFuncName();
+                    gtUInt64 startOffset = fit->second.getBaseAddr() - modLoadAddr;
+                    gtUInt64 size = fit->second.getSize();
+                    gtUInt32 funcId = modId;
+                    funcId = ((funcId << 16) | fit->second.m_functionId);
 
-            jncInfoList.clear();
-            m_dbWriter->Push({ TRANSLATED_DATA_TYPE_JITCODEBLOB_INFO, (void*)jitCodeBlobInfoList });
-            jitCodeBlobInfoList = nullptr;
+                    if (m_flushedFunctions.find(funcId) != m_flushedFunctions.end())
+                    {
+                        continue;
+                    }
+
+                    bool doInsert = funcName.isEmpty() ? false : true;
+
+                    if ((!doInsert) && ((funcId & 0x0000ffff) > 0))
+                    {
+                        osFilePath aPath(module.second.getPath());
+                        aPath.getFileNameAndExtension(funcName);
+                        funcName.appendFormattedString(L"!0x%lx", startOffset + modLoadAddr);
+                        doInsert = true;
+                    }
+
+                    if (doInsert)
+                    {
+                        funcInfoList->emplace_back(funcId, modId, funcName, startOffset, size);
+
+                        if (m_isOnlineDb)
+                        {
+                            m_flushedFunctions.insert(funcId);
+                        }
+                    }
+                }
+            }
         }
 
-        // Finish writing profile data
-        m_dbWriter->Push({ TRANSLATED_DATA_TYPE_UNKNOWN_INFO, nullptr });
+        m_dbWriter->Push({ TRANSLATED_DATA_TYPE_FUNCTION_INFO, (void*)funcInfoList });
+        funcInfoList = nullptr;
     }
 
-    gettimeofday(&css_timerStop, nullptr);
+    // Populate sample info
+    CPASampeInfoList *sampleList = new (std::nothrow) CPASampeInfoList;
 
-    if (m_pLogFile)
+    if (nullptr != sampleList)
     {
-        struct timeval diff;
-        timersub(&ebp_timerStop, &ebp_timerStart, &diff);
-        fprintf(m_pLogFile, "Write EBP time             : %lu sec, %lu usec\n", diff.tv_sec, diff.tv_usec);
-        timersub(&css_timerStop, &css_timerStart, &diff);
-        fprintf(m_pLogFile, "Write CSS time             : %lu sec, %lu usec\n", diff.tv_sec, diff.tv_usec);
+        const gtUInt32 unusedBitsMask = 0x3FFFFFF;
+
+        // Assume minimum 1000 samples
+        sampleList->reserve(1000);
+
+        for (const auto& module : m_modMap)
+        {
+            gtUInt32 modSize = module.second.m_size;
+
+            bool isJitModule = _isJitModule(module.second);
+
+            if (!isFinal && isJitModule)
+            {
+                continue;
+            }
+
+            for (auto fit = module.second.getBeginFunction(); fit != module.second.getEndFunction(); ++fit)
+            {
+                gtUInt32 funcId = module.second.m_moduleId;
+                funcId = (funcId << 16) | fit->second.m_functionId;
+
+                for (auto aptIt = fit->second.getBeginSample(); aptIt != fit->second.getEndSample(); ++aptIt)
+                {
+                    gtUInt64 pid = aptIt->first.m_pid;
+                    gtUInt32 threadId = aptIt->first.m_tid;
+                    gtVAddr  sampleAddr = aptIt->first.m_addr;
+                    gtUInt32 moduleInstanceid = 0ULL;
+                    gtVAddr  modLoadAddr = 0ULL;
+
+                    if (!isJitModule)
+                    {
+                        for (const auto& it : module.second.m_moduleInstanceInfo)
+                        {
+                            modLoadAddr = std::get<1>(it);
+                            gtVAddr modEndAddr = modLoadAddr + modSize;
+
+                            if ((std::get<0>(it) == pid))
+                            {
+                                // 1. sampleAddr falls within module size limit.
+                                // 2. module size is 0, pick the first match.
+                                if ((modLoadAddr <= sampleAddr) && ((sampleAddr < modEndAddr) || (0 == modSize)))
+                                {
+                                    moduleInstanceid = std::get<2>(it);
+                                    break;
+                                }
+                            }
+                        }
+
+                        // The module instance of the sample is not written yet
+                        if (!isFinal && (0 == moduleInstanceid))
+                        {
+                            continue;
+                        }
+                    }
+                    else
+                    {
+                        modLoadAddr = fit->second.getBaseAddr();
+
+                        if (!module.second.m_moduleInstanceInfo.empty())
+                        {
+                            moduleInstanceid = std::get<2>(module.second.m_moduleInstanceInfo.at(0));
+                        }
+                    }
+
+                    // sample address offset is w.r.t. module load address
+                    gtUInt64 sampleOffset = sampleAddr - modLoadAddr;
+                    gtUInt64 processThreadId = pid;
+                    processThreadId = (processThreadId << 32) | threadId;
+
+                    for (auto skIt = aptIt->second.getBeginSample(); skIt != aptIt->second.getEndSample(); ++skIt)
+                    {
+                        gtUInt64 sampleCount = skIt->second;
+                        gtUInt64 coreSamplingConfigId = skIt->first.cpu;
+                        coreSamplingConfigId = (coreSamplingConfigId << 32) | (skIt->first.event & unusedBitsMask);
+
+                        if (m_isOnlineDb)
+                        {
+                            // Only the samples collected since the last flush are added to the DB
+                            gtUInt64& flushedCount = m_flushedSampleCounts[SampleContextKey(processThreadId, moduleInstanceid, coreSamplingConfigId, funcId, sampleOffset)];
+
+                            if (sampleCount <= flushedCount)
+                            {
+                                continue;
+                            }
+
+                            gtUInt64 newCount = sampleCount - flushedCount;
+                            flushedCount = sampleCount;
+                            sampleCount = newCount;
+                        }
+
+                        sampleList->emplace_back(processThreadId, moduleInstanceid, coreSamplingConfigId, funcId, sampleOffset, sampleCount);
+                    }
+                }
+            }
+        }
+
+        m_dbWriter->Push({ TRANSLATED_DATA_TYPE_SAMPLE_INFO, (void*)sampleList });
+        sampleList = nullptr;
     }
+}
 
-    return bRet ? 0 : 1;
+
+bool CaPerfTranslator::_isJitModule(const CpuProfileModule& module)
+{
+    return (CpuProfileModule::JAVAMODULE == module.getModType()) || (CpuProfileModule::MANAGEDPE == module.getModType());
 }
 
 
@@ -4012,38 +4262,48 @@ HRESULT CaPerfTranslator::_setupReader(const std::string& perfDataPath)
     if (m_pPerfDataRdr)
     {
         delete m_pPerfDataRdr;
+        m_pPerfDataRdr = nullptr;
     }
 
+    return _openReader(perfDataPath, &m_pPerfDataRdr);
+}
+
+
+HRESULT CaPerfTranslator::_openReader(const std::string& perfDataPath, PerfDataReader** ppReader)
+{
     // First, try using PerfDataReader
-    m_pPerfDataRdr = new PerfDataReader();
+    PerfDataReader* pReader = new PerfDataReader();
 
-    if (!m_pPerfDataRdr)
+    if (!pReader)
     {
         return E_OUTOFMEMORY;
     }
 
-    if (S_OK == m_pPerfDataRdr->init(perfDataPath))
+    if (S_OK == pReader->init(perfDataPath))
     {
+        pReader->setMmapMode(m_useMmapReader);
+        *ppReader = pReader;
         return S_OK;
     }
 
-    delete m_pPerfDataRdr;
+    delete pReader;
 
     // Retry using CaPerfDataReader
-    m_pPerfDataRdr = new CaPerfDataReader();
+    pReader = new CaPerfDataReader();
 
-    if (!m_pPerfDataRdr)
+    if (!pReader)
     {
         return E_OUTOFMEMORY;
     }
 
-    if (S_OK == m_pPerfDataRdr->init(perfDataPath))
+    if (S_OK == pReader->init(perfDataPath))
     {
+        pReader->setMmapMode(m_useMmapReader);
+        *ppReader = pReader;
         return S_OK;
     }
 
-    delete m_pPerfDataRdr;
-    m_pPerfDataRdr = nullptr;
+    delete pReader;
 
     return E_FAIL;
 }
@@ -4442,7 +4702,7 @@ bool CaPerfTranslator::_useModuleCaching(
 int CaPerfTranslator::process_PERF_RECORD_READ(
     struct perf_event_header* pHdr,
     void* ptr,
-    gtUInt32 offset,
+    gtUInt64 offset,
     gtUInt32 index)
 {
     (void)(offset); // unused
@@ -4615,22 +4875,16 @@ HRESULT CaPerfTranslator::_processCSS(struct perf_event_header* pHdr,
                 modRit->second.pProc->m_hasCss = true;
             }
 
-            ProcessInfo& processInfo = AcquireProcessInfo(rec.pid);
+            // The call graph of the process is built when the queued samples are flushed
+            AcquireProcessInfo(rec.pid);
 
             const size_t stkSize = rec.callchain->nr;
-            // Multiplied by (MAX_INLINED_FUNCS+1) to include inline functions.
-            // Later introduce handleInline flag and check it.
-            // If true, multiply by (MAX_INLINED_FUNCS+1), else multiply by 1.
-            m_cssBuffer.reserve(stkSize * (MAX_INLINED_FUNCS + 1) + 1);
-            CallStackBuilder callStackBuilder(processInfo.m_callGraph,
-                                              reinterpret_cast<gtUByte*>(m_cssBuffer.data()),
-                                              static_cast<unsigned>(m_cssBuffer.capacity() * sizeof(gtUInt64)));
-
             ModLoadInfoMap::reverse_iterator rit;
-
             bool bIsUser = true;
-            gtUInt64 sampleAddr = 0ULL;
-            bool isCSBInitialized = false;
+
+            // Resolving the modules depends on the order of the samples, building the call
+            // stack only depends on the samples of the process.
+            m_cssIps.clear();
 
             for (size_t i = 0; i < stkSize; i++)
             {
@@ -4681,89 +4935,130 @@ HRESULT CaPerfTranslator::_processCSS(struct perf_event_header* pHdr,
                     continue;
                 }
 
-                gtVector<gtVAddr> funcList;
-                _getInlinedFuncInfoListByVa(rec.pid, tmpIp, funcList);
+                m_cssIps.push_back(tmpIp);
+            }
 
-                if (funcList.size() > 1)
-                {
-                    auto it = funcList.rbegin();
+            // The call stacks are built process by process when the queue is flushed, even with a
+            // single thread: building them in sample order is about 3 times slower
+            if (!m_cssIps.empty())
+            {
+                _queueCssSample(rec.pid, rec.tid, evMask, weight);
+            }
 
-                    if (0ULL == sampleAddr)
-                    {
-                        sampleAddr = *it;
-                        it++;
-                    }
+            gettimeofday(&css_timerStop, nullptr);
 
-                    int count = 1;
+            struct timeval diff;
+            timersub(&css_timerStop, &css_timerStart, &diff);
+            timeradd(&m_pass2Css, &diff, &m_pass2Css);
 
-                    while (count < MAX_INLINED_FUNCS && funcList.rend() != it)
-                    {
-                        gtVAddr callerVa = *it;
+            if (CSS_MAX_QUEUED_IPS <= m_numQueuedCssIps)
+            {
+                _flushCssSamples();
+            }
+        }
 
-                        if (!isCSBInitialized)
-                        {
-                            callStackBuilder.Initialize(callerVa, 0ULL, 0ULL);
-                            isCSBInitialized = true;
-                        }
-                        else
-                        {
-                            callStackBuilder.Push(callerVa);
-                        }
+#endif
+    }
 
-                        it++;
-                        count++;
-                    }
+    return ret;
+}
 
-                    if (funcList.rend() != it)
-                    {
-                        gtVAddr callerVa = funcList.front();
-                        callStackBuilder.Push(callerVa);
-                    }
+// Builds the call stack of a sample into the call graph of its process. The return
+// addresses were already resolved to valid modules.
+void CaPerfTranslator::_buildCallStack(ProcessInfo& processInfo, ProcessIdType pid, gtUInt32 tid, EventMaskType evMask, float weight,
+                                       const gtUInt64* pIps, size_t numIps, gtVector<gtUInt64>& cssBuffer)
+{
+#if HAS_LIBCSS
+    // Multiplied by (MAX_INLINED_FUNCS+1) to include inline functions.
+    // Later introduce handleInline flag and check it.
+    // If true, multiply by (MAX_INLINED_FUNCS+1), else multiply by 1.
+    cssBuffer.reserve(numIps * (MAX_INLINED_FUNCS + 1) + 1);
+    CallStackBuilder callStackBuilder(processInfo.m_callGraph,
+                                      reinterpret_cast<gtUByte*>(cssBuffer.data()),
+                                      static_cast<unsigned>(cssBuffer.capacity() * sizeof(gtUInt64)));
+
+    gtUInt64 sampleAddr = 0ULL;
+    bool isCSBInitialized = false;
+    gtVector<gtVAddr> funcList;
+
+    for (size_t i = 0; i < numIps; i++)
+    {
+        gtUInt64 tmpIp = pIps[i];
+
+        funcList.clear();
+        _getInlinedFuncInfoListByVa(pid, tmpIp, funcList);
+
+        if (funcList.size() > 1)
+        {
+            auto it = funcList.rbegin();
+
+            if (0ULL == sampleAddr)
+            {
+                sampleAddr = *it;
+                it++;
+            }
+
+            int count = 1;
+
+            while (count < MAX_INLINED_FUNCS && funcList.rend() != it)
+            {
+                gtVAddr callerVa = *it;
+
+                if (!isCSBInitialized)
+                {
+                    callStackBuilder.Initialize(callerVa, 0ULL, 0ULL);
+                    isCSBInitialized = true;
                 }
                 else
                 {
-                    if (0ULL == sampleAddr)
-                    {
-                        sampleAddr = tmpIp;
-                    }
-                    else
-                    {
-                        if (!isCSBInitialized)
-                        {
-                            callStackBuilder.Initialize(tmpIp, 0ULL, 0ULL);
-                            isCSBInitialized = true;
-                        }
-                        else
-                        {
-                            callStackBuilder.Push(tmpIp);
-                        }
-                    }
+                    callStackBuilder.Push(callerVa);
                 }
+
+                it++;
+                count++;
             }
 
-            // Store callpath info
-            if (0U != callStackBuilder.GetDepth())
+            if (funcList.rend() != it)
             {
-                EventSampleInfo eventSample;
-                eventSample.m_pSite = processInfo.m_callGraph.AcquireCallSite(sampleAddr);
-                eventSample.m_eventId = evMask;
-                eventSample.m_threadId = rec.tid;
-                eventSample.m_count = static_cast<gtUInt64>(weight);
-
-                callStackBuilder.Finalize(eventSample);
+                gtVAddr callerVa = funcList.front();
+                callStackBuilder.Push(callerVa);
+            }
+        }
+        else
+        {
+            if (0ULL == sampleAddr)
+            {
+                sampleAddr = tmpIp;
+            }
+            else
+            {
+                if (!isCSBInitialized)
+                {
+                    callStackBuilder.Initialize(tmpIp, 0ULL, 0ULL);
+                    isCSBInitialized = true;
+                }
+                else
+                {
+                    callStackBuilder.Push(tmpIp);
+                }
             }
-
-            gettimeofday(&css_timerStop, nullptr);
-
-            struct timeval diff;
-            timersub(&css_timerStop, &css_timerStart, &diff);
-            timeradd(&m_pass2Css, &diff, &m_pass2Css);
         }
-
-#endif
     }
 
-    return ret;
+    // Store callpath info
+    if (0U != callStackBuilder.GetDepth())
+    {
+        EventSampleInfo eventSample;
+        eventSample.m_pSite = processInfo.m_callGraph.AcquireCallSite(sampleAddr);
+        eventSample.m_eventId = evMask;
+        eventSample.m_threadId = tid;
+        eventSample.m_count = static_cast<gtUInt64>(weight);
+
+        callStackBuilder.Finalize(eventSample);
+    }
+#else
+    (void)(processInfo); (void)(pid); (void)(tid); (void)(evMask); (void)(weight); (void)(pIps); (void)(numIps); (void)(cssBuffer); // unused
+#endif
 }
 
 // Function to get the Java module details if the IP is in
@@ -21,11 +21,15 @@
 // Description:
 //
 
+#include <atomic>
 #include <memory>
 #include <linux/perf_event.h>
 
 #include <AMDTBaseTools/Include/gtFlatMap.h>
+#include <AMDTBaseTools/Include/gtHashMap.h>
 #include <AMDTBaseTools/Include/gtList.h>
+#include <AMDTBaseTools/Include/gtSet.h>
+#include <AMDTOSWrappers/Include/osSynchronizedQueue.h>
 #include <AMDTExecutableFormat/inc/ProcessWorkingSet.h>
 #include <AMDTCpuCallstackSampling/inc/CallGraph.h>
 #include <AMDTCpuProfilingRawData/inc/ProfilerDataDBWriter.h>
@@ -35,6 +39,9 @@
 
 #include "CaPerfTranslatorIbs.h"
 
+// The Java profiling agent writes its JNC files here
+#define CAPERF_JAVA_JNC_TMP_DIR L"/tmp/.codexl-java"
+
 // Enable this macro to enable .ebp/.imd files generation, only for debugging purpose
 #define ENABLE_OLD_PROFILE_WRITER  0
 
@@ -43,6 +50,12 @@
 #include <AMDTCpuProfilingRawData/inc/CpuProfileWriter.h>
 #endif
 
+/* NOTE: [Suravee]
+ * 1: Enable module aggregation caching
+ * 0: Disable
+ */
+#define _ENABLE_MOD_AGG_CACHED_ 1
+
 // Aggregate the IBS derived event. Increase the derived event count by one
 #define AGG_IBS_EVENT(EV) _log_ibs(pProc, ldAddr, funcSize, pMod, ip, pid, tid, cpu, EV, 0, os, usr, 1, pFuncInfo)
 
@@ -53,6 +66,7 @@ struct calog;
 struct PROCMODAddress;
 class PerfDataReader;
 class ExecutableAnalyzer;
+class AnalyzedCodeCache;
 
 class EvBlkKey
 {
@@ -77,7 +91,7 @@ public:
 
     EvBlkInfo(gtUInt32 vindex = 0,
               gtUInt32 vevId = 0,
-              gtUInt32 voffset = 0,
+              gtUInt64 voffset = 0,
               gtUInt32 vbytes = 0,
               gtUInt32 vnum = 0,
               gtUInt64 vstartTs = 0,
@@ -103,7 +117,7 @@ public:
 
     gtUInt32 index;
     gtUInt32 evId;
-    gtUInt32 offset;
+    gtUInt64 offset;
     gtUInt32 bytes;
     gtUInt32 num;
     gtUInt32 numUnProcessed;
@@ -200,13 +214,14 @@ typedef gtMap<gtUInt64, PreviousTimes> EvtIdPreviousMap;
 //
 class CaPerfTranslator
 {
-    typedef int (CaPerfTranslator::*PerfRecordHandler_t)(struct perf_event_header* pHdr, const void* ptr, gtUInt32 offset, gtUInt32 index);
+    typedef int (CaPerfTranslator::*PerfRecordHandler_t)(struct perf_event_header* pHdr, const void* ptr, gtUInt64 offset, gtUInt32 index);
 
 public:
     enum Pass2TranslationMode
     {
         PASS2_MODE_SERIAL = 0,
         PASS2_MODE_SORT,
+        PASS2_MODE_PARALLEL,
         PASS2_MODE_MAX,
     };
 
@@ -234,12 +249,41 @@ public:
 
     void setupTranslateMode(gtUInt32 mode) { m_pass2Mode = mode; }
 
+    // Number of worker threads used by PASS2_MODE_PARALLEL (0 means one per online CPU)
+    void setupNumWorkerThreads(gtUInt32 numThreads) { m_numWorkerThreads = numThreads; }
+
+    // Number of threads building the call stacks (0 means one per online CPU, 1 builds them on the translation thread)
+    void setupNumCssThreads(gtUInt32 numThreads) { m_numCssThreads = numThreads; }
+
+    // Load the sampled modules and their symbols in background threads while the samples are translated
+    void setupModulePreload(bool preload) { m_isModulePreload = preload; }
+
+    // Number of threads preloading the modules (0 means one per online CPU, and no preloading with a single CPU)
+    void setupNumPreloadThreads(gtUInt32 numThreads) { m_numPreloadThreads = numThreads; }
+
+    // Share the code discovered in each module by the processes which load it, instead of analyzing it per process
+    void setupSharedCodeAnalysis(bool share) { m_isSharedCodeAnalysis = share; }
+
+    // Select between the memory-mapped (default) and the read() based record iterator
+    void setupReaderMode(bool useMmap) { m_useMmapReader = useMmap; }
+
     PidProcInfoMap* getTargetProcessesAndThreads() { return & m_pidProcInfoMap; }
 
     gtList<std::string>* getErrorList() { return &m_errorList; }
 
     void SetDebugSymbolsSearchPath(const wchar_t* pSearchPath, const wchar_t* pServerList, const wchar_t* pCachePath);
 
+    // Translate the records while the profiling is still running. They are handed over by
+    // addOnlineRecords(), and translatePerfDataToCaData() then only completes the translation.
+    // If a DB path is given, the translated data is flushed to that DB periodically, and
+    // writeEbpOutput() then completes the same DB.
+    HRESULT startOnlineTranslation(const std::string& dbPath = "");
+
+    // Queue the records read from the sampling buffers. The data may end with a partial record.
+    void addOnlineRecords(const void* pData, size_t size);
+
+    bool isOnlineTranslation() const { return nullptr != m_pOnlineThread; }
+
 protected:
     ModLoadInfoMap::reverse_iterator getModuleForSample(struct perf_event_header* pHdr,
                                                         gtUInt32 pid, gtUInt64 time, gtUInt64 ip,
@@ -249,25 +293,25 @@ protected:
 
     CpuProfileProcess* getProcess(ProcessIdType pid);
 
-    virtual int process_PERF_RECORD_MMAP(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index);
+    virtual int process_PERF_RECORD_MMAP(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index);
 
-    //  virtual int process_PERF_RECORD_LOST(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index);
+    //  virtual int process_PERF_RECORD_LOST(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index);
 
-    virtual int process_PERF_RECORD_COMM(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index);
+    virtual int process_PERF_RECORD_COMM(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index);
 
-    virtual int process_PERF_RECORD_EXIT(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index);
+    virtual int process_PERF_RECORD_EXIT(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index);
 
-    //  virtual int process_PERF_RECORD_THROTTLE(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index);
+    //  virtual int process_PERF_RECORD_THROTTLE(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index);
 
-    //  virtual int process_PERF_RECORD_UNTHROTTLE(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index);
+    //  virtual int process_PERF_RECORD_UNTHROTTLE(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index);
 
-    virtual int process_PERF_RECORD_FORK(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index);
+    virtual int process_PERF_RECORD_FORK(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index);
 
-    virtual int process_PERF_RECORD_READ(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index);
+    virtual int process_PERF_RECORD_READ(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index);
 
-    virtual int process_PERF_RECORD_SAMPLE(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index);
+    virtual int process_PERF_RECORD_SAMPLE(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index);
 
-    virtual int preprocess_PERF_RECORD_SAMPLE_into_block(struct perf_event_header* pHdr, void* ptr, gtUInt32 offset, gtUInt32 index);
+    virtual int preprocess_PERF_RECORD_SAMPLE_into_block(struct perf_event_header* pHdr, void* ptr, gtUInt64 offset, gtUInt32 index);
 
     void trans_ibs_fetch(struct ibs_fetch_sample* trans_fetch,
                          gtUInt32 selected_flag,
@@ -311,28 +355,108 @@ protected:
             gtVector<std::tuple<gtUInt32, gtUInt32, gtUInt32, gtUInt64, gtUInt64, gtUInt64>>& inlinedJitInfo);
 
 private:
+    struct Pass2Sample;
+    struct Pass2Entry;
+    struct Pass2Chunk;
+    class Pass2Worker;
+    struct OnlineRecords;
+    class OnlineTranslationThread;
+    struct ProcessInfo;
+    struct CssTask;
+    class CssWorker;
+    struct ModulePreload;
+    class PreloadWorker;
+
+    // A call-stack sample waiting to be built into the call graph of its process
+    struct CssSample
+    {
+        gtUInt32 m_tid;
+        EventMaskType m_evMask;
+        float m_weight;
+        gtUInt32 m_numIps;
+    };
+
+    // The waiting call-stack samples of a process. The return addresses of the samples are stored back to back.
+    struct CssProcessSamples
+    {
+        gtVector<CssSample> m_samples;
+        gtVector<gtUInt64> m_ips;
+    };
+
+    // The user samples and call chain entries of a process counted by pass 1, per 64KB of code
+    struct PreloadHit
+    {
+        gtUInt64 m_ip = 0;
+        gtUInt64 m_time = 0;
+        gtUInt32 m_firstIndex = 0;
+        gtUInt32 m_count = 0;
+    };
+
+    // Per worker aggregation of the process samples, keyed by the translator's process
+    typedef gtMap<CpuProfileProcess*, CpuProfileProcess> Pass2ProcessMap;
+
     void _init();
 
-    inline void _clearAllHandlers();
+    void _clearAllHandlers();
+
+    HRESULT _setupTranslation(const std::string& outPath, bool bVerb);
+
+    void _resolveOrphanProcesses();
 
     HRESULT _setupReader(const std::string& perfDataPath);
 
+    HRESULT _openReader(const std::string& perfDataPath, PerfDataReader** ppReader);
+
     HRESULT _getModuleBitness(const std::string& modName, bool* pIs32Bit);
 
     HRESULT _getElfFileType(const std::string& modName, gtUInt32* pElfType);
 
     ModLoadInfoMap::reverse_iterator _getModuleForSample(gtUInt32 pid, gtUInt64 time, gtUInt64 ip, bool bIsUser);
 
+    ModLoadInfoMap::reverse_iterator _findModuleForSample(gtUInt32 pid, gtUInt64 time, gtUInt64 ip, bool bIsUser);
+
+    void _initModuleBase(gtUInt32 pid, ModLoadInfoMap::reverse_iterator rit);
+
+    float _getSampleWeight(const struct CA_PERF_RECORD_SAMPLE& rec);
+
     const FunctionSymbolInfo* getFunctionSymbol(ProcessIdType pid, gtVAddr ip, CpuProfileModule* pMod = nullptr);
 
+    void _findExecutableForSample(ProcessIdType pid, gtVAddr ip, ExecutableAnalyzer*& pExeAnalyzer, ExecutableFile*& pExecutable);
+
+    const FunctionSymbolInfo* _getFunctionSymbol(gtVAddr ip,
+                                                 ExecutableAnalyzer* pExeAnalyzer,
+                                                 ExecutableFile* pExecutable,
+                                                 CpuProfileModule* pMod);
+
+    void _addSampleToProcessAndModule(CpuProfileProcess* pProc,
+                                      gtUInt64 ldAddr, gtUInt32 funcSize, CpuProfileModule* pMod,
+                                      gtUInt64 ip,
+                                      gtUInt32 pid, gtUInt32 tid, gtUInt32 cpu,
+                                      gtUInt32 event, gtUInt32 umask, gtUInt32 os, gtUInt32 usr,
+                                      gtUInt32 count,
+                                      const FunctionSymbolInfo* pFuncInfo);
+
     void _addSampleToProcessAndModule(CpuProfileProcess* pProc,
                                       gtUInt64 ldAddr, gtUInt32 funcSize, CpuProfileModule* pMod,
+                                      ExecutableFile* pExecutable,
                                       gtUInt64 ip,
                                       gtUInt32 pid, gtUInt32 tid, gtUInt32 cpu,
                                       gtUInt32 event, gtUInt32 umask, gtUInt32 os, gtUInt32 usr,
                                       gtUInt32 count,
                                       const FunctionSymbolInfo* pFuncInfo);
 
+    void _translateIbsFetchSample(const struct CA_PERF_RECORD_SAMPLE& rec,
+                                  CpuProfileProcess* pProc,
+                                  gtUInt64 ldAddr, gtUInt32 funcSize, CpuProfileModule* pMod,
+                                  gtUInt32 cpu, gtUInt32 os, gtUInt32 usr, gtUInt32 count,
+                                  const FunctionSymbolInfo* pFuncInfo);
+
+    void _translateIbsOpSample(const struct CA_PERF_RECORD_SAMPLE& rec,
+                               CpuProfileProcess* pProc,
+                               gtUInt64 ldAddr, gtUInt32 funcSize, CpuProfileModule* pMod,
+                               gtUInt32 cpu, gtUInt32 os, gtUInt32 usr, gtUInt32 count,
+                               const FunctionSymbolInfo* pFuncInfo);
+
     void _log_ibs(CpuProfileProcess* pProc,
                   gtUInt64 ldAddr, gtUInt32 funcSize, CpuProfileModule* pMod,
                   gtUInt64 ip, gtUInt32 pid, gtUInt32 tid, gtUInt32 cpu,
@@ -344,7 +468,7 @@ private:
 
     HRESULT _getTargetPids();
 
-    HRESULT _getSampleBlockFromOffset(gtUInt32 blkOffset, gtUInt32 blkSize, gtUInt64 evId, void** ppDta);
+    HRESULT _getSampleBlockFromOffset(PerfDataReader* pReader, gtUInt64 blkOffset, gtUInt32 blkSize, gtUInt64 evId, void** ppDta);
 
     bool _useModuleCaching(size_t pid, gtUInt64 ip, gtUInt64 time, bool bIsUser);
 
@@ -358,9 +482,42 @@ private:
 
     HRESULT _translate_pass2_sort();
 
+    bool _canTranslatePass2InParallel();
+
+    HRESULT _translate_pass2_parallel();
+
+    HRESULT _decodeSampleRecord(const void* pData, struct CA_PERF_RECORD_SAMPLE& rec) const;
+
+    HRESULT _decodeSampleBlock(PerfDataReader* pReader, EvBlkInfo& blk, gtVector<Pass2Sample>& samples);
+
+    void _schedulePass2Chunk(Pass2Chunk& chunk);
+
+    void _startPass2Workers(Pass2Chunk& chunk, gtVector<Pass2Worker*>& workers);
+
+    void _stopPass2Workers(Pass2Chunk& chunk, gtVector<Pass2Worker*>& workers);
+
+    void _runPass2Workers(Pass2Chunk& chunk, int stage);
+
+    void _replayPass2Sample(const Pass2Entry& entry, Pass2ProcessMap& processes);
+
     HRESULT _prepareBlkForSorting(gtUInt32 blkSize, void* pBlk, gtUInt32& numEntries);
 
     void _printPass2Log();
+    void _printCodeAnalysisLog();
+
+    void _translateOnline();
+
+    void _processOnlineRecords(const OnlineRecords& records, bool isSamplesPhase);
+
+    void _stopOnlineTranslation();
+
+    HRESULT _finishOnlineTranslation();
+
+    void _flushOnlineDb();
+
+    void _pushProfileData(bool isFinal);
+
+    static bool _isJitModule(const CpuProfileModule& module);
 
     HRESULT _processCSS(struct perf_event_header* pHdr,
                         struct CA_PERF_RECORD_SAMPLE& rec,
@@ -368,6 +525,27 @@ private:
                         float weight,
                         ModLoadInfoMap::reverse_iterator modRit);
 
+    void _buildCallStack(ProcessInfo& processInfo, ProcessIdType pid, gtUInt32 tid, EventMaskType evMask, float weight,
+                         const gtUInt64* pIps, size_t numIps, gtVector<gtUInt64>& cssBuffer);
+
+    void _queueCssSample(ProcessIdType pid, gtUInt32 tid, EventMaskType evMask, float weight);
+
+    void _buildProcessCallStacks(const CssTask& task, gtVector<gtUInt64>& cssBuffer);
+
+    void _flushCssSamples();
+
+    void _countPreloadHit(gtUInt32 pid, gtUInt64 time, gtUInt64 ip, gtUInt32 index);
+
+    void _countPreloadCallchainHits(const void* pData, gtUInt32 index);
+
+    void _startModulePreload();
+
+    bool _preloadModule(ModulePreload& preload);
+
+    ExecutableFile* _acquirePreloadedModule(const ProcessWorkingSet& workingSet, ModLoadInfoMap::reverse_iterator rit);
+
+    void _stopModulePreload();
+
     HRESULT _getJavaModuleforSample(TiModuleInfo* pModInfo, gtUInt32 pid, gtUInt64 time, gtUInt64 ip);
 
     bool _removeJavaJncTmpDir(const gtString& directory);
@@ -409,7 +587,11 @@ private:
     // CSS stuff
     std::wstring m_cssFileDir;
     struct calog* m_pCalogCss;
-    gtVector<gtUInt64> m_cssBuffer;
+    gtVector<gtUInt64> m_cssIps;
+    gtMap<ProcessIdType, CssProcessSamples> m_cssSamples;
+    gtUInt64 m_numQueuedCssIps;
+    gtUInt32 m_numCssThreads;
+    gtUInt32 m_numCssWorkers;
 
     // Statistics
     gtUInt32 m_numFork;
@@ -439,17 +621,49 @@ private:
     // EvBlk stuff
     gtUInt64 m_numSampleBlocks;
     gtUInt64 m_lastProcessedEvId;
-    gtUInt32 m_curEvBlkOffset;
+    gtUInt64 m_curEvBlkOffset;
     gtUInt64 m_lastEvBlkId;
     gtUInt64 m_lastEvBlkRecIndex;
     gtUInt64 m_lastEvBlkNumEntries;
     gtUInt64 m_lastEvBlkStartTs;
     gtUInt64 m_lastEvBlkStopTs;
     gtUInt32 m_pass2Mode;
+    gtUInt32 m_numWorkerThreads;
+    gtUInt32 m_numPass2Workers;
+    bool m_useMmapReader;
     gtUInt64 m_lastSortTs;
     EvBlkIdMap m_evBlkIdMap;
     TimeStampRecordMap m_tsRecMap;
 
+    // Online translation stuff
+    OnlineTranslationThread* m_pOnlineThread;
+    osSynchronizedQueue<OnlineRecords*> m_onlineQueue;
+    gtVector<gtUByte> m_onlinePartialRecord;
+    std::atomic<bool> m_onlineStopRequested;
+    HRESULT m_onlineStatus;
+    gtUInt32 m_onlineRecIndex;
+    std::string m_onlineDbPath;
+
+    // What the online translation has already written to the DB
+    bool m_isOnlineDb;
+    gtSet<gtUInt64> m_flushedProcesses;
+    gtSet<gtUInt64> m_flushedProcessThreads;
+    gtSet<gtUInt32> m_flushedModules;
+    gtSet<gtUInt32> m_flushedModuleInstances;
+    gtSet<gtUInt32> m_flushedFunctions;
+    gtHashMap<SampleContextKey, gtUInt64> m_flushedSampleCounts;
+
+    // Module preloading stuff
+    bool m_isModulePreload;
+    gtUInt32 m_numPreloadThreads;
+    gtHashMap<gtUInt64, PreloadHit> m_preloadHits;
+    gtVector<ModulePreload*> m_modulePreloads;
+    gtHashMap<const CpuProfileModule*, ModulePreload*> m_modulePreloadMap;
+    gtVector<PreloadWorker*> m_preloadWorkers;
+    volatile gtInt32 m_nextModulePreload;
+    volatile bool m_preloadStopRequested;
+    struct timeval m_preloadWait;
+
     JitTaskInfo   m_javaModInfo;
 
     // Error/Warning messages
@@ -462,15 +676,19 @@ private:
     {
         ProcessWorkingSet m_workingSet;
         ExecutableAnalyzersMap m_exeAnalyzers;
+        AnalyzedCodeCache* m_pCodeCache;
         CallGraph m_callGraph;
 
-        ProcessInfo(const wchar_t* pSearchPath = nullptr, const wchar_t* pServerList = nullptr, const wchar_t* pCachePath = nullptr);
+        ProcessInfo(const wchar_t* pSearchPath = nullptr, const wchar_t* pServerList = nullptr, const wchar_t* pCachePath = nullptr,
+                    AnalyzedCodeCache* pCodeCache = nullptr);
         ~ProcessInfo();
 
         ExecutableAnalyzer* AcquireExecutableAnalyzer(gtVAddr va);
     };
 
     gtMap<ProcessIdType, ProcessInfo*> m_processInfos;
+    bool m_isSharedCodeAnalysis;
+    AnalyzedCodeCache* m_pAnalyzedCodeCache;
     wchar_t* m_pSearchPath;
     wchar_t* m_pServerList;
     wchar_t* m_pCachePath;
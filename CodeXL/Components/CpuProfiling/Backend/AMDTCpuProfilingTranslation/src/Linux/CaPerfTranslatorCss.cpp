@@ -0,0 +1,204 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file CaPerfTranslatorCss.cpp
+/// \brief Multi-threaded building of the call-stack samples of the CAPERF file translation.
+///
+//==================================================================================
+
+#include <unistd.h>
+#include <sys/time.h>
+#include <algorithm>
+
+#include <AMDTOSWrappers/Include/osThread.h>
+#include <AMDTOSWrappers/Include/osAtomic.h>
+#include <AMDTOSWrappers/Include/osTimeInterval.h>
+#include <AMDTOSWrappers/Include/osDebugLog.h>
+
+#include "CaPerfTranslator.h"
+
+#define CSS_WORKER_WAIT_MS  1000
+
+// The waiting call-stack samples of a process, built by a single worker thread
+struct CaPerfTranslator::CssTask
+{
+    ProcessIdType m_pid;
+    ProcessInfo* m_pProcessInfo;
+    const CssProcessSamples* m_pSamples;
+};
+
+class CaPerfTranslator::CssWorker : public osThread
+{
+public:
+    CssWorker(CaPerfTranslator& translator, const gtVector<CssTask>& tasks, volatile gtInt32& nextTask, unsigned int id) :
+        osThread(gtString(L"CSS Worker [").appendUnsignedIntNumber(id).append(L']')),
+        m_translator(translator),
+        m_tasks(tasks),
+        m_nextTask(nextTask)
+    {
+    }
+
+    virtual ~CssWorker() {}
+
+    void Run()
+    {
+        // Each worker has its own stack buffer
+        gtVector<gtUInt64> cssBuffer;
+        gtInt32 numTasks = static_cast<gtInt32>(m_tasks.size());
+        gtInt32 item;
+
+        while ((item = AtomicAdd(m_nextTask, 1)) < numTasks)
+        {
+            m_translator._buildProcessCallStacks(m_tasks[item], cssBuffer);
+        }
+    }
+
+protected:
+    virtual int entryPoint()
+    {
+        Run();
+        return 0;
+    }
+
+private:
+    CaPerfTranslator& m_translator;
+    const gtVector<CssTask>& m_tasks;
+    volatile gtInt32& m_nextTask;
+};
+
+
+// Called by the translation thread, with the return addresses of the sample in m_cssIps
+void CaPerfTranslator::_queueCssSample(ProcessIdType pid, gtUInt32 tid, EventMaskType evMask, float weight)
+{
+    CssProcessSamples& samples = m_cssSamples[pid];
+
+    CssSample sample;
+    sample.m_tid = tid;
+    sample.m_evMask = evMask;
+    sample.m_weight = weight;
+    sample.m_numIps = static_cast<gtUInt32>(m_cssIps.size());
+
+    samples.m_samples.push_back(sample);
+    samples.m_ips.insert(samples.m_ips.end(), m_cssIps.begin(), m_cssIps.end());
+
+    m_numQueuedCssIps += m_cssIps.size();
+}
+
+
+// Called by the worker threads. The call graph and the executables of a process are
+// only touched by the worker building its call stacks.
+void CaPerfTranslator::_buildProcessCallStacks(const CssTask& task, gtVector<gtUInt64>& cssBuffer)
+{
+    const gtUInt64* pIps = task.m_pSamples->m_ips.data();
+
+    for (gtVector<CssSample>::const_iterator it = task.m_pSamples->m_samples.begin(), itEnd = task.m_pSamples->m_samples.end(); it != itEnd; ++it)
+    {
+        _buildCallStack(*task.m_pProcessInfo, task.m_pid, it->m_tid, it->m_evMask, it->m_weight, pIps, it->m_numIps, cssBuffer);
+        pIps += it->m_numIps;
+    }
+}
+
+
+// Builds the waiting call-stack samples into the call graphs, one process per worker
+// thread at a time. The translation thread waits for the workers, so nothing else
+// touches the process infos meanwhile.
+void CaPerfTranslator::_flushCssSamples()
+{
+    if (m_cssSamples.empty())
+    {
+        return;
+    }
+
+    struct timeval timerStart;
+    gettimeofday(&timerStart, nullptr);
+
+    gtVector<CssTask> tasks;
+    tasks.reserve(m_cssSamples.size());
+
+    for (gtMap<ProcessIdType, CssProcessSamples>::const_iterator it = m_cssSamples.begin(), itEnd = m_cssSamples.end(); it != itEnd; ++it)
+    {
+        ProcessInfo* pProcessInfo = FindProcessInfo(it->first);
+
+        if (nullptr != pProcessInfo)
+        {
+            CssTask task;
+            task.m_pid = it->first;
+            task.m_pProcessInfo = pProcessInfo;
+            task.m_pSamples = &it->second;
+            tasks.push_back(task);
+        }
+    }
+
+    // Largest process first
+    std::sort(tasks.begin(), tasks.end(), [](const CssTask& left, const CssTask& right)
+    {
+        return left.m_pSamples->m_ips.size() > right.m_pSamples->m_ips.size();
+    });
+
+    gtUInt32 numWorkers = m_numCssThreads;
+
+    if (0 == numWorkers)
+    {
+        long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        numWorkers = (0 < numCpus) ? static_cast<gtUInt32>(numCpus) : 1;
+    }
+
+    if (numWorkers > tasks.size())
+    {
+        numWorkers = static_cast<gtUInt32>(tasks.size());
+    }
+
+    volatile gtInt32 nextTask = 0;
+    gtVector<CssWorker*> workers;
+    workers.reserve(numWorkers);
+
+    for (gtUInt32 i = 1; i < numWorkers; i++)
+    {
+        CssWorker* pWorker = new CssWorker(*this, tasks, nextTask, i);
+
+        if (pWorker->execute())
+        {
+            workers.push_back(pWorker);
+        }
+        else
+        {
+            delete pWorker;
+        }
+    }
+
+    CssWorker mainWorker(*this, tasks, nextTask, 0);
+    mainWorker.Run();
+
+    osTimeInterval timeout;
+    timeout.setAsMilliSeconds(CSS_WORKER_WAIT_MS);
+
+    for (gtVector<CssWorker*>::iterator it = workers.begin(), itEnd = workers.end(); it != itEnd; ++it)
+    {
+        while ((*it)->isAlive())
+        {
+            (*it)->waitForThreadEnd(timeout);
+        }
+
+        delete *it;
+    }
+
+    if (m_numCssWorkers < workers.size() + 1)
+    {
+        m_numCssWorkers = static_cast<gtUInt32>(workers.size() + 1);
+    }
+
+    m_cssSamples.clear();
+    m_numQueuedCssIps = 0;
+
+    struct timeval timerStop;
+    gettimeofday(&timerStop, nullptr);
+
+    struct timeval diff;
+    timersub(&timerStop, &timerStart, &diff);
+    timeradd(&m_pass2Css, &diff, &m_pass2Css);
+
+    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"Built the call stacks of %u processes with %u threads in %lu sec, %lu usec",
+                               static_cast<unsigned int>(tasks.size()), static_cast<unsigned int>(workers.size() + 1),
+                               diff.tv_sec, diff.tv_usec);
+}
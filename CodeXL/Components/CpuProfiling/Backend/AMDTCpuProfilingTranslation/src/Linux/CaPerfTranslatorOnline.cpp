@@ -0,0 +1,386 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file CaPerfTranslatorOnline.cpp
+/// \brief Translation of the CAPERF records while the profiling is still running.
+///
+//==================================================================================
+
+#include <sys/time.h>
+#include <linux/perf_event.h>
+
+#include <AMDTOSWrappers/Include/osThread.h>
+#include <AMDTOSWrappers/Include/osTimeInterval.h>
+#include <AMDTOSWrappers/Include/osDebugLog.h>
+#include <AMDTCpuProfilingRawData/inc/Linux/CaPerfDataReader.h>
+
+#include "CaPerfTranslator.h"
+
+// The samples are held back for this long after their records arrive, so that the mmap
+// records collected on the other CPUs around the same time are processed before them.
+#define CAPERF_ONLINE_SAMPLE_DELAY_MS   500
+
+#define CAPERF_ONLINE_POLL_MS           10
+
+#define CAPERF_ONLINE_WAIT_MS           1000
+
+// The translated data is written to the DB this often, when a DB path is given
+#define CAPERF_ONLINE_FLUSH_MS          2000
+
+// Complete records, as read from the sampling buffers
+struct CaPerfTranslator::OnlineRecords
+{
+    gtVector<gtUByte> m_data;
+    struct timeval m_arrivalTime;
+};
+
+class CaPerfTranslator::OnlineTranslationThread : public osThread
+{
+public:
+    OnlineTranslationThread(CaPerfTranslator& translator) :
+        osThread(L"CaPerf Online Translation"),
+        m_translator(translator)
+    {
+    }
+
+    virtual ~OnlineTranslationThread() {}
+
+protected:
+    virtual int entryPoint()
+    {
+        m_translator._translateOnline();
+        return 0;
+    }
+
+private:
+    CaPerfTranslator& m_translator;
+};
+
+
+HRESULT CaPerfTranslator::startOnlineTranslation(const std::string& dbPath)
+{
+    if (nullptr != m_pOnlineThread)
+    {
+        return E_UNEXPECTED;
+    }
+
+    // The samples are processed in the order they arrive
+    m_pass2Mode = PASS2_MODE_SERIAL;
+    m_onlineStopRequested = false;
+    m_onlineStatus = S_OK;
+    m_onlineRecIndex = 0;
+    m_onlineDbPath = dbPath;
+
+    m_pOnlineThread = new OnlineTranslationThread(*this);
+
+    if (!m_pOnlineThread->execute())
+    {
+        delete m_pOnlineThread;
+        m_pOnlineThread = nullptr;
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+
+void CaPerfTranslator::addOnlineRecords(const void* pData, size_t size)
+{
+    if (nullptr == pData || 0 == size)
+    {
+        return;
+    }
+
+    // Continue the record which was split at the end of the previous data
+    OnlineRecords* pRecords = new OnlineRecords;
+    pRecords->m_data.swap(m_onlinePartialRecord);
+
+    const gtUByte* pBytes = static_cast<const gtUByte*>(pData);
+    pRecords->m_data.insert(pRecords->m_data.end(), pBytes, pBytes + size);
+
+    size_t dataSize = pRecords->m_data.size();
+    size_t offset = 0;
+
+    while (offset + sizeof(struct perf_event_header) <= dataSize)
+    {
+        const struct perf_event_header* pHdr = reinterpret_cast<const struct perf_event_header*>(&pRecords->m_data[offset]);
+
+        if (0 == pHdr->size)
+        {
+            // Cannot find the next record, drop the rest of the data
+            OS_OUTPUT_DEBUG_LOG(L"Invalid PERF record size in the online data", OS_DEBUG_LOG_ERROR);
+            dataSize = offset;
+            break;
+        }
+
+        if (offset + pHdr->size > dataSize)
+        {
+            break;
+        }
+
+        offset += pHdr->size;
+    }
+
+    if (offset < dataSize)
+    {
+        m_onlinePartialRecord.assign(pRecords->m_data.begin() + offset, pRecords->m_data.begin() + dataSize);
+    }
+
+    pRecords->m_data.resize(offset);
+
+    if (0 != offset)
+    {
+        gettimeofday(&pRecords->m_arrivalTime, nullptr);
+        m_onlineQueue.push(pRecords);
+    }
+    else
+    {
+        delete pRecords;
+    }
+}
+
+
+void CaPerfTranslator::_translateOnline()
+{
+    gtList<OnlineRecords*> pendingSamples;
+    bool isSetup = false;
+
+    struct timeval lastFlush;
+    gettimeofday(&lastFlush, nullptr);
+
+    for (;;)
+    {
+        // Nothing is queued once the stop was requested, so draining the queue after reading
+        // the flag is enough to get all the records.
+        bool isStopRequested = m_onlineStopRequested;
+        bool hasRecords = false;
+
+        while (!m_onlineQueue.isEmpty())
+        {
+            OnlineRecords* pRecords = m_onlineQueue.pop();
+            hasRecords = true;
+
+            if (!isSetup)
+            {
+                // The headers are written to the raw data file before the first records are read
+                m_onlineStatus = _setupTranslation("", m_bVerb);
+                isSetup = true;
+
+                _clearAllHandlers();
+
+                m_handlers[PERF_RECORD_MMAP] =
+                    (PerfRecordHandler_t) &CaPerfTranslator::process_PERF_RECORD_MMAP;
+
+                m_handlers[PERF_RECORD_COMM] =
+                    (PerfRecordHandler_t) &CaPerfTranslator::process_PERF_RECORD_COMM;
+
+                m_handlers[PERF_RECORD_FORK] =
+                    (PerfRecordHandler_t) &CaPerfTranslator::process_PERF_RECORD_FORK;
+
+                m_handlers[PERF_RECORD_EXIT] =
+                    (PerfRecordHandler_t) &CaPerfTranslator::process_PERF_RECORD_EXIT;
+
+                m_handlers[PERF_RECORD_SAMPLE] =
+                    (PerfRecordHandler_t) &CaPerfTranslator::process_PERF_RECORD_SAMPLE;
+
+                gettimeofday(&m_pass1Start, nullptr);
+            }
+
+            if (S_OK == m_onlineStatus)
+            {
+                _processOnlineRecords(*pRecords, false);
+                pendingSamples.push_back(pRecords);
+            }
+            else
+            {
+                delete pRecords;
+            }
+        }
+
+        struct timeval now;
+        gettimeofday(&now, nullptr);
+
+        while (!pendingSamples.empty())
+        {
+            OnlineRecords* pRecords = pendingSamples.front();
+
+            struct timeval age;
+            timersub(&now, &pRecords->m_arrivalTime, &age);
+
+            if (!isStopRequested && ((age.tv_sec * 1000 + age.tv_usec / 1000) < CAPERF_ONLINE_SAMPLE_DELAY_MS))
+            {
+                break;
+            }
+
+            _processOnlineRecords(*pRecords, true);
+
+            pendingSamples.pop_front();
+            delete pRecords;
+        }
+
+        if (isStopRequested)
+        {
+            break;
+        }
+
+        // The data processed at stop is written by writeEbpOutput()
+        if (isSetup && (S_OK == m_onlineStatus) && !m_onlineDbPath.empty())
+        {
+            struct timeval sinceFlush;
+            timersub(&now, &lastFlush, &sinceFlush);
+
+            if ((sinceFlush.tv_sec * 1000 + sinceFlush.tv_usec / 1000) >= CAPERF_ONLINE_FLUSH_MS)
+            {
+                _flushOnlineDb();
+                lastFlush = now;
+            }
+        }
+
+        if (!hasRecords)
+        {
+            osSleep(CAPERF_ONLINE_POLL_MS);
+        }
+    }
+
+    if (isSetup)
+    {
+        _flushCssSamples();
+
+        gettimeofday(&m_pass2Stop, nullptr);
+    }
+}
+
+
+void CaPerfTranslator::_processOnlineRecords(const OnlineRecords& records, bool isSamplesPhase)
+{
+    size_t dataSize = records.m_data.size();
+    size_t offset = 0;
+
+    while (offset < dataSize)
+    {
+        const struct perf_event_header* pRec = reinterpret_cast<const struct perf_event_header*>(&records.m_data[offset]);
+        offset += pRec->size;
+
+        if (pRec->type >= PERF_RECORD_MAX)
+        {
+            if (m_bVerb)
+            {
+                OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"Error: Unknown PERF record type (%x)", pRec->type);
+            }
+
+            continue;
+        }
+
+        // The samples are processed once the modules they may hit are known
+        if ((PERF_RECORD_SAMPLE == pRec->type) != isSamplesPhase)
+        {
+            continue;
+        }
+
+        if (m_handlers[pRec->type] != nullptr)
+        {
+            (this->*(m_handlers[pRec->type]))(const_cast<struct perf_event_header*>(pRec), pRec + 1, 0, m_onlineRecIndex);
+        }
+
+        m_onlineRecIndex++;
+    }
+
+    if (!isSamplesPhase)
+    {
+        // The new modules invalidate the cached module lookup
+        m_cachedMod = m_modLoadInfoMap.rend();
+        m_cachedPid = 0;
+    }
+}
+
+
+void CaPerfTranslator::_flushOnlineDb()
+{
+    if (!m_isOnlineDb)
+    {
+        gtString dbPath;
+        dbPath.fromUtf8String(m_onlineDbPath);
+
+        m_dbWriter.reset(new ProfilerDataDBWriter);
+
+        if (!m_dbWriter->Initialize(dbPath))
+        {
+            // The DB is then written only by writeEbpOutput()
+            OS_OUTPUT_DEBUG_LOG(L"Could not create the DB of the online translation", OS_DEBUG_LOG_ERROR);
+            m_dbWriter.reset(nullptr);
+            m_onlineDbPath.clear();
+            return;
+        }
+
+        m_isOnlineDb = true;
+    }
+
+    _pushProfileData(false);
+
+    // Commit what was pushed, so that the DB can be read while the profiling is running
+    m_dbWriter->Push({ TRANSLATED_DATA_TYPE_FLUSH, nullptr });
+}
+
+
+void CaPerfTranslator::_stopOnlineTranslation()
+{
+    if (nullptr != m_pOnlineThread)
+    {
+        m_onlineStopRequested = true;
+
+        osTimeInterval timeout;
+        timeout.setAsMilliSeconds(CAPERF_ONLINE_WAIT_MS);
+
+        while (m_pOnlineThread->isAlive())
+        {
+            m_pOnlineThread->waitForThreadEnd(timeout);
+        }
+
+        delete m_pOnlineThread;
+        m_pOnlineThread = nullptr;
+    }
+
+    // Records which arrived after the translation stopped
+    while (!m_onlineQueue.isEmpty())
+    {
+        delete m_onlineQueue.pop();
+    }
+
+    m_onlinePartialRecord.clear();
+}
+
+
+HRESULT CaPerfTranslator::_finishOnlineTranslation()
+{
+    _stopOnlineTranslation();
+
+    HRESULT retVal = m_onlineStatus;
+
+    if (S_OK == retVal && nullptr != m_pPerfDataRdr)
+    {
+        _resolveOrphanProcesses();
+
+        _dumpModLoadInfoMap();
+
+        if (m_pLogFile)
+        {
+            struct timeval diff;
+            timersub(&m_pass2Stop, &m_pass1Start, &diff);
+            fprintf(m_pLogFile, "Online Translation Time    : %lu sec, %lu usec\n",
+                    diff.tv_sec, diff.tv_usec);
+            fprintf(m_pLogFile, "Online Translation Records : %u\n", m_onlineRecIndex);
+        }
+    }
+
+    // Fix for BUG400722: Removed the residual JNC files created from
+    // Java profiling on temp dir.
+    _removeJavaJncTmpDir(CAPERF_JAVA_JNC_TMP_DIR);
+
+    if (!m_numSamples)
+    {
+        retVal = E_NODATA;
+    }
+
+    return retVal;
+}
@@ -0,0 +1,721 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file CaPerfTranslatorPass2.cpp
+/// \brief Multi-threaded pass2 of the CAPERF file translation.
+///
+//==================================================================================
+
+#include <unistd.h>
+#include <sys/time.h>
+#include <cstdlib>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <linux/perf_event.h>
+#include <AMDTCpuProfilingBackendUtils/3rdParty/linux/perfStruct.h>
+
+#include <AMDTBaseTools/Include/gtHashMap.h>
+#include <AMDTOSWrappers/Include/osThread.h>
+#include <AMDTOSWrappers/Include/osAtomic.h>
+#include <AMDTOSWrappers/Include/osTimeInterval.h>
+#include <AMDTOSWrappers/Include/osDebugLog.h>
+#include <AMDTCpuProfilingRawData/inc/Linux/CaPerfDataReader.h>
+#include <AMDTCpuProfilingRawData/inc/Linux/PerfData.h>
+
+#include "CaPerfTranslator.h"
+
+// The sample blocks are translated in chunks of about this many bytes, which bounds
+// the memory taken by the copied blocks and the decoded samples.
+#define PASS2_CHUNK_SIZE        (16 * 1024 * 1024)
+
+#define PASS2_WORKER_WAIT_MS    1000
+
+enum Pass2Stage
+{
+    PASS2_STAGE_DECODE = 0,
+    PASS2_STAGE_REPLAY,
+};
+
+// A sample record of a block, decoded by a worker thread
+struct CaPerfTranslator::Pass2Sample
+{
+    const struct perf_event_header* m_pHdr;
+    struct CA_PERF_RECORD_SAMPLE m_rec;
+    ModLoadInfoMap::reverse_iterator m_modRit;
+    HRESULT m_hr;
+};
+
+// A sample in data file order, with everything that depends on the order of the samples
+// already resolved by the main thread
+struct CaPerfTranslator::Pass2Entry
+{
+    gtUInt64 m_ip;
+    gtUInt64 m_modBase;
+    CpuProfileProcess* m_pProc;
+    CpuProfileModule* m_pMod;
+    ExecutableAnalyzer* m_pExeAnalyzer;
+    ExecutableFile* m_pExecutable;
+    ExecutableFile* m_pSampleExecutable;
+    gtUInt32 m_pid;
+    gtUInt32 m_tid;
+    gtUInt32 m_cpu;
+    gtUInt32 m_event;
+    gtUInt32 m_umask;
+    gtUInt32 m_os;
+    gtUInt32 m_usr;
+    float m_weight;
+    bool m_isRecorded;
+};
+
+struct CaPerfTranslator::Pass2Chunk
+{
+    gtVector<EvBlkInfo*> m_blocks;
+    gtVector<HRESULT> m_blockResults;
+    gtVector< gtVector<Pass2Sample> > m_samples;
+
+    gtVector<Pass2Entry> m_entries;
+
+    // Indices of the entries of each module, largest module first
+    gtVector< gtVector<gtUInt32> > m_modEntries;
+
+    // Set when an executable is looked up by the samples of more than one module
+    bool m_isShared;
+
+    gtVector<PerfDataReader*>* m_pReaders;
+    gtVector<Pass2ProcessMap>* m_pProcesses;
+
+    volatile gtInt32 m_nextItem;
+
+    // The worker threads live for the whole pass2. Each stage of each chunk is handed to them
+    // by bumping m_generation, and they report back by decrementing m_numBusy.
+    std::mutex m_workLock;
+    std::condition_variable m_workCond;
+    std::condition_variable m_doneCond;
+    int m_stage;
+    gtUInt32 m_generation;
+    gtUInt32 m_numWorkers;
+    gtUInt32 m_numBusy;
+    bool m_isStopped;
+};
+
+class CaPerfTranslator::Pass2Worker : public osThread
+{
+public:
+    Pass2Worker(CaPerfTranslator& translator, Pass2Chunk& chunk, unsigned int id) :
+        osThread(gtString(L"Pass2 Worker [").appendUnsignedIntNumber(id).append(L']')),
+        m_translator(translator),
+        m_chunk(chunk),
+        m_id(id)
+    {
+    }
+
+    virtual ~Pass2Worker() {}
+
+    // Also called by the main thread, which takes part in the work as worker 0
+    static void Run(CaPerfTranslator& translator, Pass2Chunk& chunk, int stage, unsigned int id)
+    {
+        if (PASS2_STAGE_DECODE == stage)
+        {
+            PerfDataReader* pReader = (*chunk.m_pReaders)[id];
+            gtInt32 numBlocks = static_cast<gtInt32>(chunk.m_blocks.size());
+            gtInt32 item;
+
+            while ((item = AtomicAdd(chunk.m_nextItem, 1)) < numBlocks)
+            {
+                chunk.m_blockResults[item] = translator._decodeSampleBlock(pReader, *chunk.m_blocks[item], chunk.m_samples[item]);
+            }
+        }
+        else
+        {
+            Pass2ProcessMap& processes = (*chunk.m_pProcesses)[id];
+            gtInt32 numModules = static_cast<gtInt32>(chunk.m_modEntries.size());
+            gtInt32 item;
+
+            while ((item = AtomicAdd(chunk.m_nextItem, 1)) < numModules)
+            {
+                const gtVector<gtUInt32>& indices = chunk.m_modEntries[item];
+
+                for (gtVector<gtUInt32>::const_iterator it = indices.begin(), itEnd = indices.end(); it != itEnd; ++it)
+                {
+                    translator._replayPass2Sample(chunk.m_entries[*it], processes);
+                }
+            }
+        }
+    }
+
+protected:
+    virtual int entryPoint()
+    {
+        gtUInt32 generation = 0;
+
+        for (;;)
+        {
+            int stage;
+
+            {
+                std::unique_lock<std::mutex> lock(m_chunk.m_workLock);
+                m_chunk.m_workCond.wait(lock, [&]() { return m_chunk.m_isStopped || generation != m_chunk.m_generation; });
+
+                if (m_chunk.m_isStopped)
+                {
+                    break;
+                }
+
+                generation = m_chunk.m_generation;
+                stage = m_chunk.m_stage;
+            }
+
+            Run(m_translator, m_chunk, stage, m_id);
+
+            std::lock_guard<std::mutex> lock(m_chunk.m_workLock);
+
+            if (0 == --m_chunk.m_numBusy)
+            {
+                m_chunk.m_doneCond.notify_one();
+            }
+        }
+
+        return 0;
+    }
+
+private:
+    CaPerfTranslator& m_translator;
+    Pass2Chunk& m_chunk;
+    unsigned int m_id;
+};
+
+
+// Returns false if the object is already looked up by the samples of another module
+static bool ClaimForModule(gtHashMap<const void*, CpuProfileModule*>& owners, const void* pObject, CpuProfileModule* pMod)
+{
+    bool ret = true;
+
+    if (nullptr != pObject)
+    {
+        std::pair<gtHashMap<const void*, CpuProfileModule*>::iterator, bool> item = owners.insert(std::make_pair(pObject, pMod));
+        ret = (item.first->second == pMod);
+    }
+
+    return ret;
+}
+
+
+bool CaPerfTranslator::_canTranslatePass2InParallel()
+{
+    // The verbose dump and the call-stack output follow the samples one by one
+    if (m_bVerb)
+    {
+        return false;
+    }
+
+    if ((m_sampleType & PERF_SAMPLE_CALLCHAIN) && (!m_cssFileDir.empty() || nullptr != m_pCalogCss))
+    {
+        return false;
+    }
+
+#ifdef ENABLE_FAKETIMER
+
+    if (nullptr != m_aFakeFlags || nullptr != m_fakeInfo.timerFds)
+    {
+        return false;
+    }
+
+#endif
+
+    gtUInt64 numBlocks = 0;
+
+    for (EvBlkIdMap::iterator eit = m_evBlkIdMap.begin(), eEnd = m_evBlkIdMap.end(); eit != eEnd; ++eit)
+    {
+        int cpu = 0;
+        gtUInt32 event = 0;
+        gtUInt32 umask;
+        gtUInt32 os;
+        gtUInt32 usr;
+
+        // The derived IBS events are aggregated at the IBS linear address, which
+        // does not have to belong to the module of the sample
+        if (S_OK == m_pPerfDataRdr->getEventAndCpuFromSampleId(eit->first, &cpu, &event, &umask, &os, &usr) &&
+            (IBS_FETCH_BASE == event || IBS_OP_BASE == event))
+        {
+            return false;
+        }
+
+        numBlocks += eit->second.size();
+    }
+
+    // All the samples must be covered by the blocks found in pass1
+    if (numBlocks != m_numSampleBlocks || 1 >= numBlocks)
+    {
+        return false;
+    }
+
+    m_numPass2Workers = m_numWorkerThreads;
+
+    if (0 == m_numPass2Workers)
+    {
+        long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        m_numPass2Workers = (0 < numCpus) ? static_cast<gtUInt32>(numCpus) : 1;
+    }
+
+    return (1 < m_numPass2Workers);
+}
+
+
+// In this mode, the samples are translated in chunks of consecutive sample blocks:
+// 1. The worker threads decode the sample blocks of the chunk and look up the
+//    module load info of each sample.
+// 2. The main thread goes through the samples in data file order, and does all the
+//    work that depends on the order of the samples (module caching, multiplexing
+//    weight, module base address, executable lookup, sample count). The samples
+//    are then grouped by module.
+// 3. The worker threads look up the function symbols and aggregate the samples of
+//    the modules. The samples of a module are aggregated by a single thread in data
+//    file order, so the result is the same as in the serial mode.
+HRESULT CaPerfTranslator::_translate_pass2_parallel()
+{
+    HRESULT retVal = S_OK;
+
+    if (!_canTranslatePass2InParallel())
+    {
+        m_pass2Mode = PASS2_MODE_SERIAL;
+        m_numPass2Workers = 0;
+        return _translate_pass2_serialize();
+    }
+
+    // Order the sample blocks as they appear in the data file
+    gtVector<EvBlkInfo*> blocks(static_cast<size_t>(m_numSampleBlocks), nullptr);
+
+    for (EvBlkIdMap::iterator eit = m_evBlkIdMap.begin(), eEnd = m_evBlkIdMap.end(); eit != eEnd; ++eit)
+    {
+        for (TsEvBlkMap::iterator tit = eit->second.begin(), tEnd = eit->second.end(); tit != tEnd; ++tit)
+        {
+            if (tit->second.index < blocks.size())
+            {
+                blocks[tit->second.index] = &tit->second;
+            }
+        }
+    }
+
+    // Each worker thread reads the blocks through its own reader
+    gtVector<PerfDataReader*> readers(m_numPass2Workers, nullptr);
+    bool isValid = (blocks.end() == std::find(blocks.begin(), blocks.end(), static_cast<EvBlkInfo*>(nullptr)));
+
+    readers[0] = m_pPerfDataRdr;
+
+    for (gtUInt32 i = 1; isValid && i < m_numPass2Workers; i++)
+    {
+        isValid = (S_OK == _openReader(m_inputFile, &readers[i]));
+    }
+
+    if (!isValid)
+    {
+        for (gtUInt32 i = 1; i < m_numPass2Workers; i++)
+        {
+            delete readers[i];
+        }
+
+        m_pass2Mode = PASS2_MODE_SERIAL;
+        m_numPass2Workers = 0;
+        return _translate_pass2_serialize();
+    }
+
+    gtVector<Pass2ProcessMap> processes(m_numPass2Workers);
+
+    // Clear the cache
+    m_cachedMod = m_modLoadInfoMap.rend();
+    m_cachedPid = 0;
+
+    gettimeofday(&m_pass2Start, nullptr);
+
+    Pass2Chunk chunk;
+    chunk.m_pReaders = &readers;
+    chunk.m_pProcesses = &processes;
+
+    gtVector<Pass2Worker*> workers;
+    _startPass2Workers(chunk, workers);
+
+    size_t blkIndex = 0;
+
+    while (S_OK == retVal && blkIndex < blocks.size())
+    {
+        gtUInt64 chunkSize = 0;
+        chunk.m_blocks.clear();
+
+        do
+        {
+            chunk.m_blocks.push_back(blocks[blkIndex]);
+            chunkSize += blocks[blkIndex]->bytes;
+            blkIndex++;
+        }
+        while (blkIndex < blocks.size() && PASS2_CHUNK_SIZE > chunkSize);
+
+        chunk.m_blockResults.assign(chunk.m_blocks.size(), S_OK);
+        chunk.m_samples.resize(chunk.m_blocks.size());
+
+        _runPass2Workers(chunk, PASS2_STAGE_DECODE);
+
+        for (size_t i = 0; i < chunk.m_blocks.size(); i++)
+        {
+            if (S_OK != chunk.m_blockResults[i])
+            {
+                std::stringstream ss;
+                ss << "Error: Couldn't get block. EvId=0x" << std::hex << chunk.m_blocks[i]->evId;
+                ss << std::dec << ", offset=" << chunk.m_blocks[i]->offset << ", size=" << chunk.m_blocks[i]->bytes;
+                m_errorList.push_back(ss.str());
+
+                retVal = E_FAIL;
+                break;
+            }
+        }
+
+        if (S_OK == retVal)
+        {
+            _schedulePass2Chunk(chunk);
+
+            if (chunk.m_isShared)
+            {
+                // Keep the data file order for the samples of the modules that share an executable
+                for (gtVector<Pass2Entry>::const_iterator it = chunk.m_entries.begin(), itEnd = chunk.m_entries.end(); it != itEnd; ++it)
+                {
+                    _replayPass2Sample(*it, processes[0]);
+                }
+            }
+            else
+            {
+                _runPass2Workers(chunk, PASS2_STAGE_REPLAY);
+            }
+        }
+
+        for (gtVector<EvBlkInfo*>::iterator it = chunk.m_blocks.begin(), itEnd = chunk.m_blocks.end(); it != itEnd; ++it)
+        {
+            if (nullptr != (*it)->pData)
+            {
+                free((*it)->pData);
+                (*it)->pData = nullptr;
+            }
+        }
+    }
+
+    _stopPass2Workers(chunk, workers);
+
+    // Merge the process samples aggregated by the worker threads
+    for (gtVector<Pass2ProcessMap>::iterator it = processes.begin(), itEnd = processes.end(); it != itEnd; ++it)
+    {
+        for (Pass2ProcessMap::iterator pit = it->begin(), pEnd = it->end(); pit != pEnd; ++pit)
+        {
+            pit->first->addSamples(static_cast<const AggregatedSample*>(&pit->second));
+        }
+    }
+
+    for (gtUInt32 i = 1; i < m_numPass2Workers; i++)
+    {
+        delete readers[i];
+    }
+
+    gettimeofday(&m_pass2Stop, nullptr);
+
+    _printPass2Log();
+
+    return retVal;
+}
+
+
+// Called by the worker threads. Reads a sample block, decodes its samples and
+// looks up the module load info of each of them.
+HRESULT CaPerfTranslator::_decodeSampleBlock(PerfDataReader* pReader, EvBlkInfo& blk, gtVector<Pass2Sample>& samples)
+{
+    samples.clear();
+
+    HRESULT retVal = _getSampleBlockFromOffset(pReader, blk.offset, blk.bytes, blk.evId, &blk.pData);
+
+    if (S_OK == retVal)
+    {
+        samples.reserve(blk.num);
+
+        const char* pCur = static_cast<const char*>(blk.pData);
+        const char* pEnd = pCur + blk.bytes;
+
+        while (pCur + sizeof(struct perf_event_header) <= pEnd)
+        {
+            const struct perf_event_header* pRec = reinterpret_cast<const struct perf_event_header*>(pCur);
+
+            // The rest of the block was not copied
+            if (0 == pRec->size)
+            {
+                break;
+            }
+
+            if (PERF_RECORD_SAMPLE == pRec->type)
+            {
+                samples.push_back(Pass2Sample());
+                Pass2Sample& sample = samples.back();
+
+                sample.m_pHdr = pRec;
+                sample.m_hr = _decodeSampleRecord(pRec + 1, sample.m_rec);
+                sample.m_modRit = m_modLoadInfoMap.rend();
+
+                if (S_OK == sample.m_hr)
+                {
+                    bool bIsUser = ((pRec->misc & PERF_RECORD_MISC_USER) != 0);
+                    sample.m_modRit = _findModuleForSample(sample.m_rec.pid, sample.m_rec.time, sample.m_rec.ip, bIsUser);
+                }
+            }
+
+            pCur += pRec->size;
+        }
+    }
+
+    return retVal;
+}
+
+
+// Runs on the main thread. Goes through the samples of the chunk in data file order,
+// exactly like process_PERF_RECORD_SAMPLE() does, but leaves the symbol lookup and
+// the aggregation of the samples to the worker threads.
+void CaPerfTranslator::_schedulePass2Chunk(Pass2Chunk& chunk)
+{
+    gtHashMap<CpuProfileModule*, gtUInt32> modIndices;
+    gtHashMap<const void*, CpuProfileModule*> exeOwners;
+    bool isModLoadInfoChanged = false;
+
+    chunk.m_entries.clear();
+    chunk.m_modEntries.clear();
+    chunk.m_isShared = false;
+
+    for (gtVector< gtVector<Pass2Sample> >::iterator bit = chunk.m_samples.begin(), bEnd = chunk.m_samples.end(); bit != bEnd; ++bit)
+    {
+        for (gtVector<Pass2Sample>::iterator sit = bit->begin(), sEnd = bit->end(); sit != sEnd; ++sit)
+        {
+            struct CA_PERF_RECORD_SAMPLE& rec = sit->m_rec;
+
+            if (m_sampleType & PERF_SAMPLE_ID)
+            {
+                m_lastProcessedEvId = rec.id;
+            }
+
+            if (S_OK != sit->m_hr)
+            {
+                // The weight is taken before the call chain is checked
+                if (m_sampleType & PERF_SAMPLE_READ)
+                {
+                    _getSampleWeight(rec);
+                }
+
+                continue;
+            }
+
+            bool bIsUser = ((sit->m_pHdr->misc & PERF_RECORD_MISC_USER) != 0);
+            bool bCached = false;
+            ModLoadInfoMap::reverse_iterator modRit = sit->m_modRit;
+
+#if _ENABLE_MOD_AGG_CACHED_
+            bCached = _useModuleCaching(rec.pid, rec.ip, rec.time, bIsUser);
+#endif
+
+            if (bCached)
+            {
+                modRit = m_cachedMod;
+            }
+            else if (isModLoadInfoChanged)
+            {
+                modRit = _findModuleForSample(rec.pid, rec.time, rec.ip, bIsUser);
+            }
+
+            // The unknown and Java samples are translated right away. They may add
+            // Java modules to m_modLoadInfoMap, making the lookups of the workers stale.
+            if (modRit == m_modLoadInfoMap.rend() ||
+                nullptr == modRit->second.pMod ||
+                CpuProfileModule::JAVAMODULE == modRit->second.pMod->m_modType)
+            {
+                size_t numModLoadInfo = m_modLoadInfoMap.size();
+                struct perf_event_header* pHdr = const_cast<struct perf_event_header*>(sit->m_pHdr);
+
+                process_PERF_RECORD_SAMPLE(pHdr, pHdr + 1, 0, 0);
+
+                isModLoadInfoChanged = isModLoadInfoChanged || (numModLoadInfo != m_modLoadInfoMap.size());
+                continue;
+            }
+
+            float weight = 1.0;
+
+            if (m_sampleType & PERF_SAMPLE_READ)
+            {
+                weight = _getSampleWeight(rec);
+            }
+
+            if (!bCached)
+            {
+                _initModuleBase(rec.pid, modRit);
+
+                m_cachedPid = bIsUser ? static_cast<int>(rec.pid) : -1;
+                m_cachedMod = modRit;
+            }
+
+            Pass2Entry entry;
+            entry.m_ip = rec.ip;
+            entry.m_modBase = modRit->first.addr;
+            entry.m_pProc = modRit->second.pProc;
+            entry.m_pMod = modRit->second.pMod;
+            entry.m_pSampleExecutable = nullptr;
+            entry.m_pid = rec.pid;
+            entry.m_tid = rec.tid;
+            entry.m_weight = weight;
+
+            _findExecutableForSample(rec.pid, rec.ip, entry.m_pExeAnalyzer, entry.m_pExecutable);
+
+            int cpu = 0;
+            entry.m_isRecorded = (S_OK == m_pPerfDataRdr->getEventAndCpuFromSampleId(rec.id, &cpu,
+                                                                                    &entry.m_event, &entry.m_umask,
+                                                                                    &entry.m_os, &entry.m_usr));
+            entry.m_cpu = cpu;
+
+            if (entry.m_isRecorded)
+            {
+                if (nullptr != entry.m_pProc && CpuProfileModule::UNMANAGEDPE == entry.m_pMod->m_modType)
+                {
+                    entry.m_pSampleExecutable = entry.m_pExecutable;
+
+                    if (nullptr != entry.m_pExeAnalyzer)
+                    {
+                        entry.m_pSampleExecutable = FindProcessInfo(rec.pid)->m_workingSet.FindModule(rec.ip);
+                    }
+                }
+
+                m_numSamples += weight;
+            }
+
+            if (!ClaimForModule(exeOwners, entry.m_pExeAnalyzer, entry.m_pMod) ||
+                !ClaimForModule(exeOwners, entry.m_pExecutable, entry.m_pMod) ||
+                !ClaimForModule(exeOwners, entry.m_pSampleExecutable, entry.m_pMod))
+            {
+                chunk.m_isShared = true;
+            }
+
+            gtHashMap<CpuProfileModule*, gtUInt32>::iterator mit = modIndices.find(entry.m_pMod);
+
+            if (modIndices.end() == mit)
+            {
+                mit = modIndices.insert(std::make_pair(entry.m_pMod, static_cast<gtUInt32>(chunk.m_modEntries.size()))).first;
+                chunk.m_modEntries.push_back(gtVector<gtUInt32>());
+            }
+
+            chunk.m_modEntries[mit->second].push_back(static_cast<gtUInt32>(chunk.m_entries.size()));
+            chunk.m_entries.push_back(entry);
+        }
+    }
+
+    // Hand out the largest modules first
+    std::sort(chunk.m_modEntries.begin(), chunk.m_modEntries.end(),
+              [](const gtVector<gtUInt32>& a, const gtVector<gtUInt32>& b) { return a.size() > b.size(); });
+}
+
+
+// Starts the worker threads once for the whole pass2. They wait for the stages
+// handed to them by _runPass2Workers().
+void CaPerfTranslator::_startPass2Workers(Pass2Chunk& chunk, gtVector<Pass2Worker*>& workers)
+{
+    chunk.m_nextItem = 0;
+    chunk.m_stage = PASS2_STAGE_DECODE;
+    chunk.m_generation = 0;
+    chunk.m_numWorkers = 0;
+    chunk.m_numBusy = 0;
+    chunk.m_isStopped = false;
+
+    workers.reserve(m_numPass2Workers);
+
+    for (gtUInt32 i = 1; i < m_numPass2Workers; i++)
+    {
+        Pass2Worker* pWorker = new Pass2Worker(*this, chunk, i);
+
+        if (pWorker->execute())
+        {
+            workers.push_back(pWorker);
+        }
+        else
+        {
+            delete pWorker;
+        }
+    }
+
+    chunk.m_numWorkers = static_cast<gtUInt32>(workers.size());
+}
+
+
+void CaPerfTranslator::_stopPass2Workers(Pass2Chunk& chunk, gtVector<Pass2Worker*>& workers)
+{
+    {
+        std::lock_guard<std::mutex> lock(chunk.m_workLock);
+        chunk.m_isStopped = true;
+    }
+
+    chunk.m_workCond.notify_all();
+
+    osTimeInterval timeout;
+    timeout.setAsMilliSeconds(PASS2_WORKER_WAIT_MS);
+
+    for (gtVector<Pass2Worker*>::iterator it = workers.begin(), itEnd = workers.end(); it != itEnd; ++it)
+    {
+        while ((*it)->isAlive())
+        {
+            (*it)->waitForThreadEnd(timeout);
+        }
+
+        delete *it;
+    }
+
+    workers.clear();
+}
+
+
+// Runs a stage of the chunk on the started worker threads, and returns once all of them are
+// done with it. The main thread takes part in the work as worker 0.
+void CaPerfTranslator::_runPass2Workers(Pass2Chunk& chunk, int stage)
+{
+    {
+        std::lock_guard<std::mutex> lock(chunk.m_workLock);
+        chunk.m_nextItem = 0;
+        chunk.m_stage = stage;
+        chunk.m_numBusy = chunk.m_numWorkers;
+        chunk.m_generation++;
+    }
+
+    chunk.m_workCond.notify_all();
+
+    Pass2Worker::Run(*this, chunk, stage, 0);
+
+    std::unique_lock<std::mutex> lock(chunk.m_workLock);
+    chunk.m_doneCond.wait(lock, [&]() { return 0 == chunk.m_numBusy; });
+}
+
+
+// Called by the worker threads. Looks up the function of a sample and aggregates the sample.
+void CaPerfTranslator::_replayPass2Sample(const Pass2Entry& entry, Pass2ProcessMap& processes)
+{
+    const FunctionSymbolInfo* pFuncInfo = _getFunctionSymbol(entry.m_ip, entry.m_pExeAnalyzer, entry.m_pExecutable, entry.m_pMod);
+
+    if (entry.m_isRecorded)
+    {
+        gtVAddr funcBaseAddr = entry.m_modBase;
+        gtUInt32 funcSize = 0;
+
+        if (nullptr != pFuncInfo)
+        {
+            funcBaseAddr += pFuncInfo->m_rva;
+            funcSize = pFuncInfo->m_size;
+        }
+
+        // Each worker sums up the process samples on its own, they are merged at the end of pass2
+        CpuProfileProcess* pProc = (nullptr != entry.m_pProc) ? &processes[entry.m_pProc] : nullptr;
+
+        _addSampleToProcessAndModule(
+            pProc,
+            funcBaseAddr, funcSize, entry.m_pMod, entry.m_pSampleExecutable,
+            entry.m_ip, entry.m_pid, entry.m_tid, entry.m_cpu,
+            entry.m_event, entry.m_umask, entry.m_os, entry.m_usr,
+            entry.m_weight,
+            pFuncInfo);
+    }
+}
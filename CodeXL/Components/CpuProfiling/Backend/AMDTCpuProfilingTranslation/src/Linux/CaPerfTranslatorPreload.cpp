@@ -0,0 +1,399 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file CaPerfTranslatorPreload.cpp
+/// \brief Multi-threaded loading of the sampled modules and their symbols during the CAPERF file translation.
+///
+//==================================================================================
+
+#include <unistd.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <linux/perf_event.h>
+#include <AMDTCpuProfilingBackendUtils/3rdParty/linux/perfStruct.h>
+
+#include <AMDTOSWrappers/Include/osThread.h>
+#include <AMDTOSWrappers/Include/osAtomic.h>
+#include <AMDTOSWrappers/Include/osTimeInterval.h>
+#include <AMDTOSWrappers/Include/osDebugLog.h>
+#include <AMDTExecutableFormat/inc/ElfFile.h>
+#include <AMDTCpuProfilingRawData/inc/Linux/PerfData.h>
+
+#include "CaPerfTranslator.h"
+
+#define PRELOAD_WORKER_WAIT_MS  1000
+
+// The samples are counted per 64KB of code, which is enough to tell the modules apart
+#define PRELOAD_HIT_IP_SHIFT    16
+
+enum ModulePreloadState
+{
+    MODULE_PRELOAD_PENDING = 0,
+    MODULE_PRELOAD_LOADING,
+    MODULE_PRELOAD_DONE
+};
+
+// A module loaded ahead of the first sample that registers it in the working set of its process
+struct CaPerfTranslator::ModulePreload
+{
+    ExecutableFile* m_pExe;                 // Owned until it is adopted by the working set
+    const ProcessWorkingSet* m_pWorkingSet;
+    gtVAddr m_base;
+    gtUInt64 m_weight;
+    volatile gtInt32 m_state;
+};
+
+class CaPerfTranslator::PreloadWorker : public osThread
+{
+public:
+    PreloadWorker(CaPerfTranslator& translator, unsigned int id) :
+        osThread(gtString(L"Preload Worker [").appendUnsignedIntNumber(id).append(L']')),
+        m_translator(translator)
+    {
+    }
+
+    virtual ~PreloadWorker() {}
+
+    void Run()
+    {
+        gtInt32 numTasks = static_cast<gtInt32>(m_translator.m_modulePreloads.size());
+        gtInt32 item;
+
+        while (!m_translator.m_preloadStopRequested && (item = AtomicAdd(m_translator.m_nextModulePreload, 1)) < numTasks)
+        {
+            m_translator._preloadModule(*m_translator.m_modulePreloads[item]);
+        }
+    }
+
+protected:
+    virtual int entryPoint()
+    {
+        Run();
+        return 0;
+    }
+
+private:
+    CaPerfTranslator& m_translator;
+};
+
+
+// Called by pass 1 for the user mode samples
+void CaPerfTranslator::_countPreloadHit(gtUInt32 pid, gtUInt64 time, gtUInt64 ip, gtUInt32 index)
+{
+    gtUInt64 key = (static_cast<gtUInt64>(pid) << 32) | ((ip >> PRELOAD_HIT_IP_SHIFT) & 0xFFFFFFFFULL);
+    PreloadHit& hit = m_preloadHits[key];
+
+    if (0 == hit.m_count)
+    {
+        hit.m_ip = ip;
+        hit.m_time = time;
+        hit.m_firstIndex = index;
+    }
+
+    hit.m_count++;
+}
+
+
+// Called by pass 1 for the samples whose call chain is translated
+void CaPerfTranslator::_countPreloadCallchainHits(const void* pData, gtUInt32 index)
+{
+    struct CA_PERF_RECORD_SAMPLE rec;
+
+    if (S_OK != _decodeSampleRecord(pData, rec) || nullptr == rec.callchain)
+    {
+        return;
+    }
+
+    bool bIsUser = true;
+
+    for (gtUInt64 i = 0; i < rec.callchain->nr; i++)
+    {
+        gtUInt64 ip = rec.callchain->ips[i];
+
+        if (PERF_CONTEXT_MAX <= ip)
+        {
+            if (PERF_CONTEXT_KERNEL == ip)
+            {
+                bIsUser = false;
+            }
+            else if (PERF_CONTEXT_USER == ip)
+            {
+                bIsUser = true;
+            }
+        }
+        else if (0 != ip && bIsUser)
+        {
+            _countPreloadHit(rec.pid, rec.time, ip, index);
+        }
+    }
+}
+
+
+// Queues the modules hit by the pass 1 samples, most sampled first, and starts the workers loading them.
+// Only the module load info which will register its module in pass 2 is loaded, that is, the one of the
+// first sample hitting the module.
+void CaPerfTranslator::_startModulePreload()
+{
+    if (!m_isModulePreload || m_preloadHits.empty())
+    {
+        m_preloadHits.clear();
+        return;
+    }
+
+    struct timeval timerStart;
+    gettimeofday(&timerStart, nullptr);
+
+    struct ModHits
+    {
+        ModLoadInfoMap::reverse_iterator m_rit;
+        gtUInt32 m_pid;
+        gtUInt32 m_firstIndex;
+        gtUInt64 m_count;
+    };
+
+    gtHashMap<const ModInfo*, ModHits> modHits;
+
+    for (gtHashMap<gtUInt64, PreloadHit>::const_iterator it = m_preloadHits.begin(), itEnd = m_preloadHits.end(); it != itEnd; ++it)
+    {
+        gtUInt32 pid = static_cast<gtUInt32>(it->first >> 32);
+        ModLoadInfoMap::reverse_iterator rit = _findModuleForSample(pid, it->second.m_time, it->second.m_ip, true);
+
+        if (rit == m_modLoadInfoMap.rend() || nullptr == rit->second.pMod || 0 != rit->second.pMod->m_base ||
+            CpuProfileModule::UNMANAGEDPE != rit->second.pMod->m_modType)
+        {
+            continue;
+        }
+
+        std::pair<gtHashMap<const ModInfo*, ModHits>::iterator, bool> item =
+            modHits.insert(std::make_pair(&rit->second, ModHits()));
+        ModHits& hits = item.first->second;
+
+        if (item.second)
+        {
+            hits.m_rit = rit;
+            hits.m_pid = pid;
+            hits.m_firstIndex = it->second.m_firstIndex;
+            hits.m_count = 0;
+        }
+        else if (hits.m_firstIndex > it->second.m_firstIndex)
+        {
+            hits.m_firstIndex = it->second.m_firstIndex;
+        }
+
+        hits.m_count += it->second.m_count;
+    }
+
+    m_preloadHits.clear();
+
+    // The module is registered by the first of its load infos to be sampled
+    gtHashMap<CpuProfileModule*, const ModHits*> firstHits;
+
+    for (gtHashMap<const ModInfo*, ModHits>::const_iterator it = modHits.begin(), itEnd = modHits.end(); it != itEnd; ++it)
+    {
+        const ModHits*& pFirst = firstHits[it->first->pMod];
+
+        if (nullptr == pFirst || pFirst->m_firstIndex > it->second.m_firstIndex)
+        {
+            pFirst = &it->second;
+        }
+    }
+
+    m_modulePreloads.reserve(firstHits.size());
+
+    for (gtHashMap<CpuProfileModule*, const ModHits*>::const_iterator it = firstHits.begin(), itEnd = firstHits.end(); it != itEnd; ++it)
+    {
+        const ModHits& hits = *it->second;
+
+        ModulePreload* pPreload = new ModulePreload;
+        pPreload->m_pExe = new ElfFile(it->first->getPath().asCharArray());
+        pPreload->m_pWorkingSet = &AcquireProcessInfo(hits.m_pid).m_workingSet;
+        pPreload->m_base = hits.m_rit->first.addr;
+        pPreload->m_weight = hits.m_count;
+        pPreload->m_state = MODULE_PRELOAD_PENDING;
+
+        m_modulePreloads.push_back(pPreload);
+        m_modulePreloadMap[it->first] = pPreload;
+    }
+
+    // Most sampled first
+    std::sort(m_modulePreloads.begin(), m_modulePreloads.end(), [](const ModulePreload* pLeft, const ModulePreload* pRight)
+    {
+        return pLeft->m_weight > pRight->m_weight;
+    });
+
+    gtUInt32 numWorkers = m_numPreloadThreads;
+
+    if (0 == numWorkers)
+    {
+        long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        numWorkers = (0 < numCpus) ? static_cast<gtUInt32>(numCpus) : 1;
+    }
+
+    if (numWorkers > m_modulePreloads.size())
+    {
+        numWorkers = static_cast<gtUInt32>(m_modulePreloads.size());
+    }
+
+    m_nextModulePreload = 0;
+    m_preloadStopRequested = false;
+    timerclear(&m_preloadWait);
+    m_preloadWorkers.reserve(numWorkers);
+
+    for (gtUInt32 i = 0; i < numWorkers; i++)
+    {
+        PreloadWorker* pWorker = new PreloadWorker(*this, i);
+
+        if (pWorker->execute())
+        {
+            m_preloadWorkers.push_back(pWorker);
+        }
+        else
+        {
+            delete pWorker;
+        }
+    }
+
+    struct timeval timerStop;
+    gettimeofday(&timerStop, nullptr);
+
+    struct timeval diff;
+    timersub(&timerStop, &timerStart, &diff);
+
+    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"Preloading %u modules with %u threads, queued in %lu sec, %lu usec",
+                               static_cast<unsigned int>(m_modulePreloads.size()), static_cast<unsigned int>(m_preloadWorkers.size()),
+                               diff.tv_sec, diff.tv_usec);
+}
+
+
+// Called by the worker threads. Returns false if the module was already taken by another thread.
+bool CaPerfTranslator::_preloadModule(ModulePreload& preload)
+{
+    if (!AtomicCompareAndSwap(preload.m_state, MODULE_PRELOAD_PENDING, MODULE_PRELOAD_LOADING))
+    {
+        return false;
+    }
+
+    preload.m_pWorkingSet->LoadModule(preload.m_pExe, preload.m_base);
+
+    AtomicSwap(preload.m_state, MODULE_PRELOAD_DONE);
+    return true;
+}
+
+
+// Called by the translation thread when the module is registered. Returns the loaded executable of the module,
+// or nullptr if it was not preloaded, in which case it is loaded by the working set as usual.
+//
+// A module is registered once, so the preload is looked up by module. It is only used if it was loaded for the
+// process and the address that register the module.
+ExecutableFile* CaPerfTranslator::_acquirePreloadedModule(const ProcessWorkingSet& workingSet, ModLoadInfoMap::reverse_iterator rit)
+{
+    gtHashMap<const CpuProfileModule*, ModulePreload*>::iterator it = m_modulePreloadMap.find(rit->second.pMod);
+
+    if (m_modulePreloadMap.end() == it)
+    {
+        return nullptr;
+    }
+
+    ModulePreload& preload = *it->second;
+    m_modulePreloadMap.erase(it);
+
+    // Not loaded yet, the working set loads it when needed. The same applies when the module is registered
+    // by another process or at another address than the one it was loaded for.
+    if (AtomicCompareAndSwap(preload.m_state, MODULE_PRELOAD_PENDING, MODULE_PRELOAD_DONE) ||
+        &workingSet != preload.m_pWorkingSet || rit->first.addr != preload.m_base)
+    {
+        return nullptr;
+    }
+
+    if (MODULE_PRELOAD_DONE != preload.m_state)
+    {
+        struct timeval timerStart;
+        gettimeofday(&timerStart, nullptr);
+
+        while (MODULE_PRELOAD_DONE != preload.m_state)
+        {
+            osSleep(1);
+        }
+
+        struct timeval timerStop;
+        gettimeofday(&timerStop, nullptr);
+
+        struct timeval diff;
+        timersub(&timerStop, &timerStart, &diff);
+        timeradd(&m_preloadWait, &diff, &m_preloadWait);
+    }
+
+    ExecutableFile* pExe = preload.m_pExe;
+    preload.m_pExe = nullptr;
+    return pExe;
+}
+
+
+void CaPerfTranslator::_stopModulePreload()
+{
+    if (m_modulePreloads.empty())
+    {
+        return;
+    }
+
+    m_preloadStopRequested = true;
+
+    osTimeInterval timeout;
+    timeout.setAsMilliSeconds(PRELOAD_WORKER_WAIT_MS);
+
+    gtUInt32 numWorkers = static_cast<gtUInt32>(m_preloadWorkers.size());
+
+    for (gtVector<PreloadWorker*>::iterator it = m_preloadWorkers.begin(), itEnd = m_preloadWorkers.end(); it != itEnd; ++it)
+    {
+        while ((*it)->isAlive())
+        {
+            (*it)->waitForThreadEnd(timeout);
+        }
+
+        delete *it;
+    }
+
+    m_preloadWorkers.clear();
+
+    gtUInt32 numLoaded = 0;
+    gtUInt32 numAdopted = 0;
+
+    for (gtVector<ModulePreload*>::iterator it = m_modulePreloads.begin(), itEnd = m_modulePreloads.end(); it != itEnd; ++it)
+    {
+        ModulePreload* pPreload = *it;
+
+        if (nullptr == pPreload->m_pExe)
+        {
+            numAdopted++;
+            numLoaded++;
+        }
+        else
+        {
+            if (pPreload->m_pExe->IsOpen())
+            {
+                numLoaded++;
+            }
+
+            delete pPreload->m_pExe;
+        }
+
+        delete pPreload;
+    }
+
+    if (m_pLogFile)
+    {
+        fprintf(m_pLogFile, "Preload Worker Threads     : %u\n", numWorkers);
+        fprintf(m_pLogFile, "Preloaded Modules          : %u of %u, %u used\n",
+                numLoaded, static_cast<unsigned int>(m_modulePreloads.size()), numAdopted);
+        fprintf(m_pLogFile, "Preload Wait Time          : %lu sec, %lu usec\n",
+                m_preloadWait.tv_sec, m_preloadWait.tv_usec);
+    }
+
+    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"Preloaded %u of %u modules, %u used, waited %lu sec, %lu usec",
+                               numLoaded, static_cast<unsigned int>(m_modulePreloads.size()), numAdopted,
+                               m_preloadWait.tv_sec, m_preloadWait.tv_usec);
+
+    m_modulePreloads.clear();
+    m_modulePreloadMap.clear();
+}
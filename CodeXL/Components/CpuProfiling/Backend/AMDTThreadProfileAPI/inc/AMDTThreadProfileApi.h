@@ -296,11 +296,12 @@ AMDTResult AMDTGetThreadData(AMDTThreadProfileDataHandle readerHandle,
 //  tid                 - TID for which the AMDTThreadSample is requested
 //  pNbrRecords         - pointer of type AMDTUInt32; Number of records is returned
 //  ppThreadSampleData  - AMDTThreadSample records will be returned;
-//                        memory will be allocated by the API
+//                        memory will be allocated by the API;
+//                        NULL to only retrieve the number of records
 //
 // Returns:
 //  AMDT_STATUS_OK          -   On Success
-//  AMDT_ERROR_INVALIDARG   -   If pNbrRecords or ppThreadData or ppReaderHandle is NULL
+//  AMDT_ERROR_INVALIDARG   -   If both pNbrRecords and ppThreadData are NULL
 //  AMDT_ERROR_INTERNAL     -   On internal failures
 //  AMDT_ERROR_NODATA       -   If there is no thread profile data
 //  AMDT_ERROR_OUTOFMEMORY  -   memory issues
@@ -311,6 +312,81 @@ AMDTResult AMDTGetThreadSampleData(AMDTThreadProfileDataHandle readerHandle,
                                    AMDTUInt32* pNbrRecords,
                                    AMDTThreadSample** ppThreadSampleData);
 
+// AMDTGetThreadSampleTimeline
+//
+// API to retrieve the thread profile samples of the given threadId, which overlap a time range.
+// The samples are not copied.
+// Has to be called after AMDTProcessThreadProfileData()
+//
+// Parameters:
+//  readerHandle        - handle returned by AMDTOpenThreadProfile()
+//  tid                 - TID for which the samples are requested
+//  startTS             - start of the time range
+//  endTS               - end of the time range (excluded); AMDT_THREAD_SAMPLE_MAX_TS for all the samples
+//  pTimeline           - pointer of type AMDTThreadSampleTimeline; memory has to be allocated by the caller
+//
+// Returns:
+//  AMDT_STATUS_OK          -   On Success
+//  AMDT_ERROR_INVALIDARG   -   If pTimeline is NULL
+//  AMDT_ERROR_INVALIDDATA  -   If tid is not a valid thread
+//
+AMDT_THREADPROFILE_API
+AMDTResult AMDTGetThreadSampleTimeline(AMDTThreadProfileDataHandle readerHandle,
+                                       AMDTThreadId tid,
+                                       AMDTUInt64 startTS,
+                                       AMDTUInt64 endTS,
+                                       AMDTThreadSampleTimeline* pTimeline);
+
+// AMDTGetThreadSampleStack
+//
+// API to retrieve the call stack of a sample returned by AMDTGetThreadSampleTimeline().
+// The frames remain valid until AMDTCloseThreadProfile() is called.
+//
+// Parameters:
+//  readerHandle        - handle returned by AMDTOpenThreadProfile()
+//  stackId             - the stack id of the sample
+//  pNbrFrames          - number of frames is returned
+//  ppFrames            - the frames are returned
+//
+// Returns:
+//  AMDT_STATUS_OK          -   On Success
+//  AMDT_ERROR_INVALIDARG   -   If pNbrFrames or ppFrames is NULL, or stackId is not valid
+//
+AMDT_THREADPROFILE_API
+AMDTResult AMDTGetThreadSampleStack(AMDTThreadProfileDataHandle readerHandle,
+                                    AMDTUInt32 stackId,
+                                    AMDTUInt32* pNbrFrames,
+                                    const AMDTUInt64** ppFrames);
+
+// AMDTSaveThreadSampleTimelines
+//
+// API to save the samples of all the threads to a compact file, which can later be loaded
+// instead of processing the context switch records again.
+// Has to be called after AMDTProcessThreadProfileData()
+//
+// Returns:
+//  AMDT_STATUS_OK          -   On Success
+//  AMDT_ERROR_INVALIDARG   -   If pFilePath is NULL
+//  AMDT_ERROR_FAIL         -   If the file could not be written
+//
+AMDT_THREADPROFILE_API
+AMDTResult AMDTSaveThreadSampleTimelines(AMDTThreadProfileDataHandle readerHandle, const char* pFilePath);
+
+// AMDTLoadThreadSampleTimelines
+//
+// API to memory-map a file written by AMDTSaveThreadSampleTimelines(). The samples are read from
+// the file, without processing the context switch records.
+// Has to be called after AMDTProcessThreadProfileData(), before the samples are queried
+//
+// Returns:
+//  AMDT_STATUS_OK          -   On Success
+//  AMDT_ERROR_INVALIDARG   -   If pFilePath is NULL
+//  AMDT_ERROR_INVALIDDATA  -   If the file is not a valid timelines file
+//  AMDT_ERROR_FAIL         -   If the file could not be mapped, or the samples were already processed
+//
+AMDT_THREADPROFILE_API
+AMDTResult AMDTLoadThreadSampleTimelines(AMDTThreadProfileDataHandle readerHandle, const char* pFilePath);
+
 // AMDTCloseThreadProfile
 // API to close the thread profile data file. This would cleanup all the internal data.
 //
@@ -194,4 +194,34 @@ typedef struct AMDTThreadSample
     // state, waitreason, wait mode, callstack
 } AMDTThreadSample;
 
+
+#define AMDT_THREAD_SAMPLE_NO_STACK     0xFFFFFFFFUL
+#define AMDT_THREAD_SAMPLE_MAX_TS       0xFFFFFFFFFFFFFFFFULL
+
+// AMDTThreadSampleTimeline
+//
+// The samples of a thread, column by column. The sample i is made of the i-th element of
+// each column. The columns point into the data of the reader handle; they remain valid
+// until AMDTCloseThreadProfile() is called.
+//
+typedef struct AMDTThreadSampleTimeline
+{
+    AMDTProcessId           m_processId;
+    AMDTThreadId            m_threadId;
+    AMDTUInt32              m_nbrSamples;
+
+    const AMDTUInt64*       m_pStartTS;
+    const AMDTUInt64*       m_pEndTS;
+    const AMDTUInt64*       m_pExecTime;        // actual running time in micro seconds
+    const AMDTUInt32*       m_pWaitTime;        // wait time in micro seconds
+    const AMDTUInt32*       m_pTransitionTime;  // ready state to run state transition time
+    const AMDTUInt32*       m_pCoreId;
+
+    const AMDTUInt8*        m_pThreadState;     // AMDTThreadState
+    const AMDTUInt8*        m_pWaitReason;      // AMDTThreadWaitReason
+    const AMDTUInt8*        m_pWaitMode;        // AMDTThreadWaitMode
+
+    const AMDTUInt32*       m_pStackId;         // AMDT_THREAD_SAMPLE_NO_STACK, or an id for AMDTGetThreadSampleStack()
+} AMDTThreadSampleTimeline;
+
 #endif //_AMDTTHREADPROFILEDATATYPES_H_
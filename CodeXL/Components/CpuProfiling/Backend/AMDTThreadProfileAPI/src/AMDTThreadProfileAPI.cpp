@@ -475,6 +475,25 @@ AMDTResult AMDTGetThreadData(AMDTThreadProfileDataHandle readerHandle,
 } // AMDTGetThreadData
 
 
+// Processes the CSWITCH and CALLSTACK records, if it was not done yet
+static AMDTResult ProcessCSRecords(tpTranslate* pTranslate)
+{
+    AMDTResult retVal = AMDT_STATUS_OK;
+
+    if (!pTranslate->IsallCSRecordsProcessed())
+    {
+        retVal = pTranslate->OpenThreadProfileData(false);
+
+        if (AMDT_STATUS_OK == retVal)
+        {
+            retVal = pTranslate->ProcessThreadProfileData();
+        }
+    }
+
+    return retVal;
+}
+
+
 // AMDTGetThreadSampleData
 //
 AMDTResult AMDTGetThreadSampleData(AMDTThreadProfileDataHandle readerHandle,
@@ -489,32 +508,95 @@ AMDTResult AMDTGetThreadSampleData(AMDTThreadProfileDataHandle readerHandle,
     {
         if (pTranslate->IsPassOneCompleted())
         {
-            if (!pTranslate->IsallCSRecordsProcessed())
+            ProcessCSRecords(pTranslate);
+
+            // When only the number of records is requested, the samples are not copied
+            retVal = pTranslate->GetThreadSampleData(tid, pNbrRecords, ppThreaSampledData);
+        }
+        else
+        {
+            fprintf(stderr, "AMDTProcessThreadProfileData() was not called..\n");
+        }
+    }
+
+    return retVal;
+} // AMDTGetThreadSampleData
+
+
+// AMDTGetThreadSampleTimeline
+//
+AMDTResult AMDTGetThreadSampleTimeline(AMDTThreadProfileDataHandle readerHandle,
+                                       AMDTThreadId tid,
+                                       AMDTUInt64 startTS,
+                                       AMDTUInt64 endTS,
+                                       AMDTThreadSampleTimeline* pTimeline)
+{
+    AMDTResult retVal = AMDT_ERROR_INVALIDARG;
+
+    if (NULL != pTimeline)
+    {
+        retVal = AMDT_ERROR_HANDLE;
+        tpTranslate* pTranslate = static_cast<tpTranslate*>(readerHandle);
+
+        if (NULL != pTranslate)
+        {
+            if (pTranslate->IsPassOneCompleted())
             {
-                // Process the CSWITCH and CALLSTACK records
-                retVal = pTranslate->OpenThreadProfileData(false);
+                ProcessCSRecords(pTranslate);
 
-                if (AMDT_STATUS_OK == retVal)
-                {
-                    retVal = pTranslate->ProcessThreadProfileData();
-                }
+                retVal = pTranslate->GetThreadSampleTimeline(tid, startTS, endTS, *pTimeline);
             }
+            else
+            {
+                fprintf(stderr, "AMDTProcessThreadProfileData() was not called..\n");
+            }
+        }
+    }
+
+    return retVal;
+} // AMDTGetThreadSampleTimeline
 
-            AMDTUInt32 nbrRecords = 0;
-            AMDTThreadSample* pThreadSampleData = NULL;
-            retVal = pTranslate->GetThreadSampleData(tid, &nbrRecords, &pThreadSampleData);
+
+// AMDTGetThreadSampleStack
+//
+AMDTResult AMDTGetThreadSampleStack(AMDTThreadProfileDataHandle readerHandle,
+                                    AMDTUInt32 stackId,
+                                    AMDTUInt32* pNbrFrames,
+                                    const AMDTUInt64** ppFrames)
+{
+    AMDTResult retVal = AMDT_ERROR_INVALIDARG;
+
+    if ((NULL != pNbrFrames) && (NULL != ppFrames))
+    {
+        retVal = AMDT_ERROR_HANDLE;
+        tpTranslate* pTranslate = static_cast<tpTranslate*>(readerHandle);
+
+        if (NULL != pTranslate)
+        {
+            retVal = pTranslate->GetThreadSampleStack(stackId, *pNbrFrames, *ppFrames);
+        }
+    }
+
+    return retVal;
+} // AMDTGetThreadSampleStack
+
+
+// AMDTSaveThreadSampleTimelines
+//
+AMDTResult AMDTSaveThreadSampleTimelines(AMDTThreadProfileDataHandle readerHandle, const char* pFilePath)
+{
+    AMDTResult retVal = AMDT_ERROR_HANDLE;
+    tpTranslate* pTranslate = static_cast<tpTranslate*>(readerHandle);
+
+    if (NULL != pTranslate)
+    {
+        if (pTranslate->IsPassOneCompleted())
+        {
+            retVal = ProcessCSRecords(pTranslate);
 
             if (AMDT_STATUS_OK == retVal)
             {
-                if (NULL != pNbrRecords)
-                {
-                    *pNbrRecords = nbrRecords;
-                }
-
-                if (NULL != ppThreaSampledData)
-                {
-                    *ppThreaSampledData = pThreadSampleData;
-                }
+                retVal = pTranslate->SaveThreadSampleTimelines(pFilePath);
             }
         }
         else
@@ -524,7 +606,30 @@ AMDTResult AMDTGetThreadSampleData(AMDTThreadProfileDataHandle readerHandle,
     }
 
     return retVal;
-} // AMDTGetThreadSampleData
+} // AMDTSaveThreadSampleTimelines
+
+
+// AMDTLoadThreadSampleTimelines
+//
+AMDTResult AMDTLoadThreadSampleTimelines(AMDTThreadProfileDataHandle readerHandle, const char* pFilePath)
+{
+    AMDTResult retVal = AMDT_ERROR_HANDLE;
+    tpTranslate* pTranslate = static_cast<tpTranslate*>(readerHandle);
+
+    if (NULL != pTranslate)
+    {
+        if (pTranslate->IsPassOneCompleted())
+        {
+            retVal = pTranslate->LoadThreadSampleTimelines(pFilePath);
+        }
+        else
+        {
+            fprintf(stderr, "AMDTProcessThreadProfileData() was not called..\n");
+        }
+    }
+
+    return retVal;
+} // AMDTLoadThreadSampleTimelines
 
 
 // AMDTCloseThreadProfile
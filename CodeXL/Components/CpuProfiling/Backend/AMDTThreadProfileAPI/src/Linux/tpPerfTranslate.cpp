@@ -137,7 +137,7 @@ AMDTResult tpPerfTranslate::ProcessPerfRecordsPass1()
     struct perf_event_header hdr;
     void* pData = nullptr;
     AMDTUInt32 recIndx = 0;
-    AMDTUInt32 offset = 0;
+    AMDTUInt64 offset = 0;
 
     if (m_pCaperfReader->getFirstRecord(&hdr, (const void**)(&pData), &offset) == S_OK)
     {
@@ -210,7 +210,7 @@ AMDTResult tpPerfTranslate::ProcessPerfRecordsPass2()
     struct perf_event_header hdr;
     void* pData = nullptr;
     AMDTUInt32 recIndx = 0;
-    AMDTUInt32 offset = 0;
+    AMDTUInt64 offset = 0;
 
     if (m_pCaperfReader->getFirstRecord(&hdr, (const void**)(&pData), &offset) == S_OK)
     {
@@ -341,7 +341,7 @@ AMDTResult tpPerfTranslate::ParsePerfRecordSample(void* pData, perfRecordSample*
 
 AMDTResult tpPerfTranslate::ProcessMmapRecord(struct perf_event_header* pHdr,
                                               const void* pData,
-                                              AMDTUInt32 offset,
+                                              AMDTUInt64 offset,
                                               AMDTUInt32 index)
 {
     GT_UNREFERENCED_PARAMETER(offset);
@@ -402,7 +402,7 @@ AMDTResult tpPerfTranslate::ProcessMmapRecord(struct perf_event_header* pHdr,
 
 AMDTResult tpPerfTranslate::ProcessCommRecord(struct perf_event_header* pHdr,
                                               const void* pData,
-                                              AMDTUInt32 offset,
+                                              AMDTUInt64 offset,
                                               AMDTUInt32 index)
 {
     GT_UNREFERENCED_PARAMETER(offset);
@@ -464,7 +464,7 @@ AMDTResult tpPerfTranslate::ProcessCommRecord(struct perf_event_header* pHdr,
 
 AMDTResult tpPerfTranslate::ProcessForkRecord(struct perf_event_header* pHdr,
                                               const void* pData,
-                                              AMDTUInt32 offset,
+                                              AMDTUInt64 offset,
                                               AMDTUInt32 index)
 {
     GT_UNREFERENCED_PARAMETER(offset);
@@ -538,7 +538,7 @@ AMDTResult tpPerfTranslate::ProcessForkRecord(struct perf_event_header* pHdr,
 
 AMDTResult tpPerfTranslate::ProcessExitRecord(struct perf_event_header* pHdr,
                                               const void* pData,
-                                              AMDTUInt32 offset,
+                                              AMDTUInt64 offset,
                                               AMDTUInt32 index)
 {
     GT_UNREFERENCED_PARAMETER(offset);
@@ -609,7 +609,7 @@ AMDTResult tpPerfTranslate::ProcessExitRecord(struct perf_event_header* pHdr,
 
 AMDTResult tpPerfTranslate::ProcessSampleRecord(struct perf_event_header* pHdr,
                                                 const void* pData,
-                                                AMDTUInt32 offset,
+                                                AMDTUInt64 offset,
                                                 AMDTUInt32 index)
 {
     GT_UNREFERENCED_PARAMETER(offset);
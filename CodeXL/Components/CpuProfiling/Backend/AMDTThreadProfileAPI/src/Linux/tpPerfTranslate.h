@@ -148,11 +148,11 @@ private:
     AMDTResult ProcessPerfRecordsPass2();
 
     AMDTResult ParsePerfRecordSample(void* pData, perfRecordSample* pSample);
-    AMDTResult ProcessMmapRecord(struct perf_event_header* pHdr, const void* pData, AMDTUInt32 offset, AMDTUInt32 index);
-    AMDTResult ProcessCommRecord(struct perf_event_header* pHdr, const void* pData, AMDTUInt32 offset, AMDTUInt32 index);
-    AMDTResult ProcessForkRecord(struct perf_event_header* pHdr, const void* pData, AMDTUInt32 offset, AMDTUInt32 index);
-    AMDTResult ProcessExitRecord(struct perf_event_header* pHdr, const void* pData, AMDTUInt32 offset, AMDTUInt32 index);
-    AMDTResult ProcessSampleRecord(struct perf_event_header* pHdr, const void* pData, AMDTUInt32 offset, AMDTUInt32 index);
+    AMDTResult ProcessMmapRecord(struct perf_event_header* pHdr, const void* pData, AMDTUInt64 offset, AMDTUInt32 index);
+    AMDTResult ProcessCommRecord(struct perf_event_header* pHdr, const void* pData, AMDTUInt64 offset, AMDTUInt32 index);
+    AMDTResult ProcessForkRecord(struct perf_event_header* pHdr, const void* pData, AMDTUInt64 offset, AMDTUInt32 index);
+    AMDTResult ProcessExitRecord(struct perf_event_header* pHdr, const void* pData, AMDTUInt64 offset, AMDTUInt32 index);
+    AMDTResult ProcessSampleRecord(struct perf_event_header* pHdr, const void* pData, AMDTUInt64 offset, AMDTUInt32 index);
 
     AMDTResult AddCSRecord(perfRecordSample& sample);
 
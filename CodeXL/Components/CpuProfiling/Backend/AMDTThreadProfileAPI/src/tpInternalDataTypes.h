@@ -38,6 +38,7 @@
 
 // Project Headers
 #include <AMDTThreadProfileDataTypes.h>
+#include <tpThreadTimeline.h>
 
 //
 // Macros
@@ -287,8 +288,7 @@ typedef struct TPThreadSample
     AMDTThreadWaitReason    m_waitReason;       // reason for the wait
     AMDTThreadWaitMode      m_waitMode;         // Kernel or User mode
 
-    AMDTUInt32              m_nbrStackFrames;
-    AMDTUInt64*             m_pStackFrames;
+    AMDTUInt32              m_stackId;          // id in the stack table of the translator
 
     TPThreadSample() : m_intialized(false), m_complete(false),
         m_coreId((AMDTUInt32) - 1), m_startTS(0), m_endTS(0),
@@ -296,7 +296,7 @@ typedef struct TPThreadSample
         m_threadState(AMDT_THREAD_STATE_MAXIMUM),
         m_waitReason(AMDT_THREAD_WAIT_REASON_MAXIMUMWAITREASON),
         m_waitMode(AMDT_THREAD_WAIT_MODE_MAXIMUM),
-        m_nbrStackFrames(0), m_pStackFrames(NULL)
+        m_stackId(AMDT_THREAD_SAMPLE_NO_STACK)
     {
     };
 
@@ -310,14 +310,11 @@ typedef struct TPThreadSample
         m_threadState = AMDT_THREAD_STATE_MAXIMUM;
         m_waitReason = AMDT_THREAD_WAIT_REASON_MAXIMUMWAITREASON;
         m_waitMode = AMDT_THREAD_WAIT_MODE_USER;
-        m_nbrStackFrames = 0;
-        m_pStackFrames = NULL;
+        m_stackId = AMDT_THREAD_SAMPLE_NO_STACK;
     }
 
 } TPThreadSample;
 
-typedef gtList<TPThreadSample> TPThreadSampleList;
-
 typedef struct TPThreadData
 {
     AMDTProcessId       m_processId;
@@ -343,7 +340,7 @@ typedef struct TPThreadData
     TPThreadSample      m_currSample;
     TPThreadSample      m_prevSample;
 
-    TPThreadSampleList  m_sampleList;
+    tpThreadTimeline    m_timeline;
 
     TPThreadData() : m_processId(TP_ALL_PIDS), m_threadId(TP_ALL_TIDS), m_affinity(0),
         m_threadCreateTS(0), m_threadTerminateTS(0),
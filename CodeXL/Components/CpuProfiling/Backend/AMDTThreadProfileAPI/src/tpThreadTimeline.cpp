@@ -0,0 +1,469 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file tpThreadTimeline.cpp
+///
+//==================================================================================
+
+#include <algorithm>
+
+// Project headers
+#include <tpInternalDataTypes.h>
+#include <tpThreadTimeline.h>
+
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+// The columns in the timelines file are padded to this alignment
+#define TP_TIMELINE_FILE_ALIGN  8
+
+//
+// Helper functions
+//
+
+static bool WriteBytes(FILE* pFile, const void* pData, size_t size)
+{
+    return (0 == size) || (fwrite(pData, 1, size, pFile) == size);
+}
+
+template <typename T>
+static bool WriteColumn(FILE* pFile, const T* pColumn, size_t count)
+{
+    static const AMDTUInt8 padding[TP_TIMELINE_FILE_ALIGN] = { 0 };
+    size_t size = count * sizeof(T);
+    size_t remainder = size % TP_TIMELINE_FILE_ALIGN;
+
+    return WriteBytes(pFile, pColumn, size) &&
+           ((0 == remainder) || WriteBytes(pFile, padding, TP_TIMELINE_FILE_ALIGN - remainder));
+}
+
+template <typename T>
+static const T* MapColumn(const AMDTUInt8*& pData, const AMDTUInt8* pEnd, size_t count)
+{
+    const T* pColumn = NULL;
+    size_t available = static_cast<size_t>(pEnd - pData);
+
+    // Check the count before computing the size, which could overflow for a corrupted count
+    if (count > available / sizeof(T))
+    {
+        return NULL;
+    }
+
+    size_t size = (count * sizeof(T) + TP_TIMELINE_FILE_ALIGN - 1) & ~static_cast<size_t>(TP_TIMELINE_FILE_ALIGN - 1);
+
+    if (available >= size)
+    {
+        pColumn = reinterpret_cast<const T*>(pData);
+        pData += size;
+    }
+
+    return pColumn;
+}
+
+//
+// tpStackTable
+//
+
+struct TPStackTableHeader
+{
+    AMDTUInt32  m_nbrStacks;
+    AMDTUInt32  m_reserved;
+    AMDTUInt64  m_nbrFrames;
+};
+
+tpStackTable::tpStackTable() : m_pMappedFrames(NULL),
+    m_pMappedOffsets(NULL),
+    m_nbrStacks(0)
+{
+    m_offsets.push_back(0);
+}
+
+AMDTUInt32 tpStackTable::AddStack(const gtUInt64* pFrames, AMDTUInt32 nbrFrames)
+{
+    // FNV-1a over the frames
+    AMDTUInt64 hash = 14695981039346656037ULL;
+
+    for (AMDTUInt32 i = 0; i < nbrFrames; i++)
+    {
+        hash ^= pFrames[i];
+        hash *= 1099511628211ULL;
+    }
+
+    AMDTUInt32 headStackId = AMDT_THREAD_SAMPLE_NO_STACK;
+    auto it = m_stackIds.find(hash);
+
+    if (it != m_stackIds.end())
+    {
+        headStackId = (*it).second;
+
+        // Look for the same stack among the ones with this hash
+        for (AMDTUInt32 stackId = headStackId; AMDT_THREAD_SAMPLE_NO_STACK != stackId; stackId = m_nextStackId[stackId])
+        {
+            AMDTUInt32 first = m_offsets[stackId];
+
+            if ((m_offsets[stackId + 1] - first) == nbrFrames &&
+                std::equal(pFrames, pFrames + nbrFrames, m_frames.begin() + first))
+            {
+                return stackId;
+            }
+        }
+    }
+
+    if (NULL != m_pMappedFrames)
+    {
+        // The mapped tables are read-only
+        return AMDT_THREAD_SAMPLE_NO_STACK;
+    }
+
+    AMDTUInt32 newStackId = m_nbrStacks++;
+
+    m_frames.insert(m_frames.end(), pFrames, pFrames + nbrFrames);
+    m_offsets.push_back(static_cast<AMDTUInt32>(m_frames.size()));
+    m_nextStackId.push_back(headStackId);
+    m_stackIds[hash] = newStackId;
+
+    return newStackId;
+}
+
+bool tpStackTable::GetStack(AMDTUInt32 stackId, AMDTUInt32& nbrFrames, const AMDTUInt64*& pFrames) const
+{
+    bool retVal = false;
+
+    if (stackId < m_nbrStacks)
+    {
+        const AMDTUInt64* pAllFrames = (NULL != m_pMappedFrames) ? m_pMappedFrames : m_frames.data();
+        const AMDTUInt32* pOffsets = (NULL != m_pMappedOffsets) ? m_pMappedOffsets : m_offsets.data();
+
+        nbrFrames = pOffsets[stackId + 1] - pOffsets[stackId];
+        pFrames = pAllFrames + pOffsets[stackId];
+        retVal = true;
+    }
+
+    return retVal;
+}
+
+bool tpStackTable::Write(FILE* pFile) const
+{
+    const AMDTUInt64* pAllFrames = (NULL != m_pMappedFrames) ? m_pMappedFrames : m_frames.data();
+    const AMDTUInt32* pOffsets = (NULL != m_pMappedOffsets) ? m_pMappedOffsets : m_offsets.data();
+
+    TPStackTableHeader header;
+    header.m_nbrStacks = m_nbrStacks;
+    header.m_reserved = 0;
+    header.m_nbrFrames = pOffsets[m_nbrStacks];
+
+    return WriteBytes(pFile, &header, sizeof(header)) &&
+           WriteColumn(pFile, pAllFrames, static_cast<size_t>(header.m_nbrFrames)) &&
+           WriteColumn(pFile, pOffsets, m_nbrStacks + 1);
+}
+
+bool tpStackTable::Map(const AMDTUInt8*& pData, const AMDTUInt8* pEnd)
+{
+    bool retVal = false;
+    const TPStackTableHeader* pHeader = MapColumn<TPStackTableHeader>(pData, pEnd, 1);
+
+    if (NULL != pHeader)
+    {
+        const AMDTUInt64* pFrames = MapColumn<AMDTUInt64>(pData, pEnd, static_cast<size_t>(pHeader->m_nbrFrames));
+        const AMDTUInt32* pOffsets = (NULL != pFrames) ? MapColumn<AMDTUInt32>(pData, pEnd, static_cast<size_t>(pHeader->m_nbrStacks) + 1) : NULL;
+        bool isValid = (NULL != pOffsets) && (0 == pOffsets[0]) && (pOffsets[pHeader->m_nbrStacks] == pHeader->m_nbrFrames);
+
+        // GetStack() trusts the offsets, so every stack must be within the frames
+        for (AMDTUInt32 i = 0; isValid && (i < pHeader->m_nbrStacks); i++)
+        {
+            isValid = (pOffsets[i] <= pOffsets[i + 1]);
+        }
+
+        if (isValid)
+        {
+            m_frames.clear();
+            m_offsets.clear();
+            m_nextStackId.clear();
+            m_stackIds.clear();
+
+            m_pMappedFrames = pFrames;
+            m_pMappedOffsets = pOffsets;
+            m_nbrStacks = pHeader->m_nbrStacks;
+            retVal = true;
+        }
+    }
+
+    return retVal;
+}
+
+//
+// tpThreadTimeline
+//
+
+tpThreadTimeline::tpThreadTimeline() : m_isMapped(false),
+    m_isOrdered(true),
+    m_nbrSamples(0)
+{
+    memset(&m_mapped, 0, sizeof(m_mapped));
+}
+
+void tpThreadTimeline::Append(const TPThreadSample& sample)
+{
+    if (m_isMapped)
+    {
+        // The mapped timelines are read-only
+        return;
+    }
+
+    if ((m_nbrSamples > 0) && ((sample.m_startTS < m_startTS.back()) || (sample.m_endTS < m_endTS.back())))
+    {
+        m_isOrdered = false;
+    }
+
+    m_startTS.push_back(sample.m_startTS);
+    m_endTS.push_back(sample.m_endTS);
+    m_execTime.push_back(sample.m_execTime);
+    m_waitTime.push_back(sample.m_waitTime);
+    m_transitionTime.push_back(sample.m_transitionTime);
+    m_coreId.push_back(sample.m_coreId);
+    m_stackId.push_back(sample.m_stackId);
+    m_threadState.push_back(static_cast<AMDTUInt8>(sample.m_threadState));
+    m_waitReason.push_back(static_cast<AMDTUInt8>(sample.m_waitReason));
+    m_waitMode.push_back(static_cast<AMDTUInt8>(sample.m_waitMode));
+
+    m_nbrSamples++;
+}
+
+void tpThreadTimeline::GetColumns(AMDTThreadSampleTimeline& columns) const
+{
+    if (m_isMapped)
+    {
+        columns.m_pStartTS = m_mapped.m_pStartTS;
+        columns.m_pEndTS = m_mapped.m_pEndTS;
+        columns.m_pExecTime = m_mapped.m_pExecTime;
+        columns.m_pWaitTime = m_mapped.m_pWaitTime;
+        columns.m_pTransitionTime = m_mapped.m_pTransitionTime;
+        columns.m_pCoreId = m_mapped.m_pCoreId;
+        columns.m_pStackId = m_mapped.m_pStackId;
+        columns.m_pThreadState = m_mapped.m_pThreadState;
+        columns.m_pWaitReason = m_mapped.m_pWaitReason;
+        columns.m_pWaitMode = m_mapped.m_pWaitMode;
+    }
+    else
+    {
+        columns.m_pStartTS = m_startTS.data();
+        columns.m_pEndTS = m_endTS.data();
+        columns.m_pExecTime = m_execTime.data();
+        columns.m_pWaitTime = m_waitTime.data();
+        columns.m_pTransitionTime = m_transitionTime.data();
+        columns.m_pCoreId = m_coreId.data();
+        columns.m_pStackId = m_stackId.data();
+        columns.m_pThreadState = m_threadState.data();
+        columns.m_pWaitReason = m_waitReason.data();
+        columns.m_pWaitMode = m_waitMode.data();
+    }
+
+    columns.m_nbrSamples = m_nbrSamples;
+}
+
+void tpThreadTimeline::FindTimeRange(AMDTUInt64 startTS, AMDTUInt64 endTS, AMDTUInt32& first, AMDTUInt32& count) const
+{
+    first = 0;
+    count = m_nbrSamples;
+
+    if (m_isOrdered)
+    {
+        AMDTThreadSampleTimeline columns;
+        GetColumns(columns);
+
+        // The first sample which ends after startTS, and the first one which starts at or after endTS
+        const AMDTUInt64* pFirst = std::upper_bound(columns.m_pEndTS, columns.m_pEndTS + m_nbrSamples, startTS);
+        const AMDTUInt64* pLast = std::lower_bound(columns.m_pStartTS, columns.m_pStartTS + m_nbrSamples, endTS);
+
+        AMDTUInt32 firstIndex = static_cast<AMDTUInt32>(pFirst - columns.m_pEndTS);
+        AMDTUInt32 lastIndex = static_cast<AMDTUInt32>(pLast - columns.m_pStartTS);
+
+        first = firstIndex;
+        count = (lastIndex > firstIndex) ? (lastIndex - firstIndex) : 0;
+    }
+}
+
+bool tpThreadTimeline::Write(FILE* pFile) const
+{
+    AMDTThreadSampleTimeline columns;
+    GetColumns(columns);
+
+    return WriteColumn(pFile, columns.m_pStartTS, m_nbrSamples) &&
+           WriteColumn(pFile, columns.m_pEndTS, m_nbrSamples) &&
+           WriteColumn(pFile, columns.m_pExecTime, m_nbrSamples) &&
+           WriteColumn(pFile, columns.m_pWaitTime, m_nbrSamples) &&
+           WriteColumn(pFile, columns.m_pTransitionTime, m_nbrSamples) &&
+           WriteColumn(pFile, columns.m_pCoreId, m_nbrSamples) &&
+           WriteColumn(pFile, columns.m_pStackId, m_nbrSamples) &&
+           WriteColumn(pFile, columns.m_pThreadState, m_nbrSamples) &&
+           WriteColumn(pFile, columns.m_pWaitReason, m_nbrSamples) &&
+           WriteColumn(pFile, columns.m_pWaitMode, m_nbrSamples);
+}
+
+bool tpThreadTimeline::Map(const AMDTUInt8*& pData, const AMDTUInt8* pEnd, AMDTUInt32 nbrSamples, bool isOrdered)
+{
+    AMDTThreadSampleTimeline mapped;
+    memset(&mapped, 0, sizeof(mapped));
+
+    mapped.m_pStartTS = MapColumn<AMDTUInt64>(pData, pEnd, nbrSamples);
+    mapped.m_pEndTS = MapColumn<AMDTUInt64>(pData, pEnd, nbrSamples);
+    mapped.m_pExecTime = MapColumn<AMDTUInt64>(pData, pEnd, nbrSamples);
+    mapped.m_pWaitTime = MapColumn<AMDTUInt32>(pData, pEnd, nbrSamples);
+    mapped.m_pTransitionTime = MapColumn<AMDTUInt32>(pData, pEnd, nbrSamples);
+    mapped.m_pCoreId = MapColumn<AMDTUInt32>(pData, pEnd, nbrSamples);
+    mapped.m_pStackId = MapColumn<AMDTUInt32>(pData, pEnd, nbrSamples);
+    mapped.m_pThreadState = MapColumn<AMDTUInt8>(pData, pEnd, nbrSamples);
+    mapped.m_pWaitReason = MapColumn<AMDTUInt8>(pData, pEnd, nbrSamples);
+    mapped.m_pWaitMode = MapColumn<AMDTUInt8>(pData, pEnd, nbrSamples);
+
+    // A truncated column is returned as NULL, and so are all the columns after it
+    bool retVal = (NULL != mapped.m_pWaitMode);
+
+    // FindTimeRange() binary searches the ordered timelines, so verify the ordering claimed by the file
+    for (AMDTUInt32 i = 1; retVal && isOrdered && (i < nbrSamples); i++)
+    {
+        if ((mapped.m_pStartTS[i] < mapped.m_pStartTS[i - 1]) || (mapped.m_pEndTS[i] < mapped.m_pEndTS[i - 1]))
+        {
+            isOrdered = false;
+        }
+    }
+
+    if (retVal)
+    {
+        m_startTS.clear();
+        m_endTS.clear();
+        m_execTime.clear();
+        m_waitTime.clear();
+        m_transitionTime.clear();
+        m_coreId.clear();
+        m_stackId.clear();
+        m_threadState.clear();
+        m_waitReason.clear();
+        m_waitMode.clear();
+
+        m_mapped = mapped;
+        m_isMapped = true;
+        m_isOrdered = isOrdered;
+        m_nbrSamples = nbrSamples;
+    }
+
+    return retVal;
+}
+
+//
+// tpMappedFile
+//
+
+tpMappedFile::tpMappedFile() :
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+    m_fileHandle(INVALID_HANDLE_VALUE),
+    m_mapHandle(NULL),
+#else
+    m_fd(-1),
+#endif
+    m_pData(NULL),
+    m_size(0)
+{
+}
+
+tpMappedFile::~tpMappedFile()
+{
+    Close();
+}
+
+bool tpMappedFile::Open(const char* pFilePath)
+{
+    Close();
+
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+    m_fileHandle = CreateFileA(pFilePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (INVALID_HANDLE_VALUE != m_fileHandle)
+    {
+        LARGE_INTEGER fileSize;
+
+        if (GetFileSizeEx(m_fileHandle, &fileSize) && (fileSize.QuadPart > 0))
+        {
+            m_mapHandle = CreateFileMapping(m_fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+            if (NULL != m_mapHandle)
+            {
+                m_pData = static_cast<const AMDTUInt8*>(MapViewOfFile(m_mapHandle, FILE_MAP_READ, 0, 0, 0));
+                m_size = static_cast<size_t>(fileSize.QuadPart);
+            }
+        }
+    }
+
+#else
+    m_fd = open(pFilePath, O_RDONLY);
+
+    if (-1 != m_fd)
+    {
+        struct stat fileStat;
+
+        if ((0 == fstat(m_fd, &fileStat)) && (fileStat.st_size > 0))
+        {
+            void* pMap = mmap(NULL, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, m_fd, 0);
+
+            if (MAP_FAILED != pMap)
+            {
+                m_pData = static_cast<const AMDTUInt8*>(pMap);
+                m_size = static_cast<size_t>(fileStat.st_size);
+            }
+        }
+    }
+
+#endif
+
+    if (NULL == m_pData)
+    {
+        Close();
+    }
+
+    return (NULL != m_pData);
+}
+
+void tpMappedFile::Close()
+{
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+
+    if (NULL != m_pData)
+    {
+        UnmapViewOfFile(m_pData);
+    }
+
+    if (NULL != m_mapHandle)
+    {
+        CloseHandle(m_mapHandle);
+        m_mapHandle = NULL;
+    }
+
+    if (INVALID_HANDLE_VALUE != m_fileHandle)
+    {
+        CloseHandle(m_fileHandle);
+        m_fileHandle = INVALID_HANDLE_VALUE;
+    }
+
+#else
+
+    if (NULL != m_pData)
+    {
+        munmap(const_cast<AMDTUInt8*>(m_pData), m_size);
+    }
+
+    if (-1 != m_fd)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+
+#endif
+
+    m_pData = NULL;
+    m_size = 0;
+}
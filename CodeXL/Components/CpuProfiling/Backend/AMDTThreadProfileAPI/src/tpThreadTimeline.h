@@ -0,0 +1,167 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file tpThreadTimeline.h
+///
+//==================================================================================
+
+#ifndef _TPTHREADTIMELINE_H_
+#define _TPTHREADTIMELINE_H_
+
+#include <stdio.h>
+
+// Base headers
+#include <AMDTBaseTools/Include/AMDTDefinitions.h>
+#include <AMDTBaseTools/Include/gtVector.h>
+#include <AMDTBaseTools/Include/gtHashMap.h>
+
+// Project Headers
+#include <AMDTThreadProfileDataTypes.h>
+
+#define TP_TIMELINE_FILE_MAGIC      0x4C545054UL    // "TPTL"
+#define TP_TIMELINE_FILE_VERSION    1
+
+#define TP_TIMELINE_THREAD_ORDERED  0x1
+
+// The timelines file is made of the file header, the stack table, and then,
+// for each thread, the thread header followed by the columns of its timeline.
+struct TPTimelineFileHeader
+{
+    AMDTUInt32  m_magic;
+    AMDTUInt32  m_version;
+    AMDTUInt32  m_nbrThreads;
+    AMDTUInt32  m_reserved;
+};
+
+struct TPTimelineFileThread
+{
+    AMDTProcessId   m_processId;
+    AMDTThreadId    m_threadId;
+    AMDTUInt32      m_nbrSamples;
+    AMDTUInt32      m_flags;
+
+    // Thread totals computed from the context switch records
+    AMDTUInt32      m_nbrOfContextSwitches;
+    AMDTUInt32      m_nbrOfCoreSwitches;
+    AMDTUInt64      m_totalExeTime;
+    AMDTUInt64      m_totalWaitTime;
+    AMDTUInt64      m_totalTransitionTime;
+};
+
+struct TPThreadSample;
+
+//
+// tpStackTable
+//
+// The call stacks of the samples. Each distinct call stack is stored once, and
+// the samples refer to it by its id.
+//
+
+class tpStackTable
+{
+public:
+    tpStackTable();
+
+    AMDTUInt32 AddStack(const gtUInt64* pFrames, AMDTUInt32 nbrFrames);
+    bool GetStack(AMDTUInt32 stackId, AMDTUInt32& nbrFrames, const AMDTUInt64*& pFrames) const;
+
+    AMDTUInt32 GetNumberOfStacks() const { return m_nbrStacks; }
+
+    bool Write(FILE* pFile) const;
+    bool Map(const AMDTUInt8*& pData, const AMDTUInt8* pEnd);
+
+private:
+    gtVector<AMDTUInt64>    m_frames;
+    gtVector<AMDTUInt32>    m_offsets;          // stack i is made of the frames [m_offsets[i], m_offsets[i + 1])
+    gtVector<AMDTUInt32>    m_nextStackId;      // next stack with the same hash
+    gtHashMap<AMDTUInt64, AMDTUInt32> m_stackIds;   // hash of the frames -> last added stack with that hash
+
+    // Set when the table is mapped from a file
+    const AMDTUInt64*       m_pMappedFrames;
+    const AMDTUInt32*       m_pMappedOffsets;
+
+    AMDTUInt32              m_nbrStacks;
+};
+
+//
+// tpThreadTimeline
+//
+// The context switch history of a thread, stored column by column.
+// The samples of a thread do not overlap, and they are appended in time order,
+// so that both the start and the end time stamps are sorted.
+//
+
+class tpThreadTimeline
+{
+public:
+    tpThreadTimeline();
+
+    void Append(const TPThreadSample& sample);
+
+    AMDTUInt32 GetNumberOfSamples() const { return m_nbrSamples; }
+
+    // Fills the columns of the timeline; they are invalidated by the next Append()
+    void GetColumns(AMDTThreadSampleTimeline& columns) const;
+
+    // Samples [first, first + count) are the ones which overlap [startTS, endTS)
+    void FindTimeRange(AMDTUInt64 startTS, AMDTUInt64 endTS, AMDTUInt32& first, AMDTUInt32& count) const;
+
+    bool Write(FILE* pFile) const;
+    bool Map(const AMDTUInt8*& pData, const AMDTUInt8* pEnd, AMDTUInt32 nbrSamples, bool isOrdered);
+
+    bool IsOrdered() const { return m_isOrdered; }
+
+private:
+    gtVector<AMDTUInt64>    m_startTS;
+    gtVector<AMDTUInt64>    m_endTS;
+    gtVector<AMDTUInt64>    m_execTime;
+    gtVector<AMDTUInt32>    m_waitTime;
+    gtVector<AMDTUInt32>    m_transitionTime;
+    gtVector<AMDTUInt32>    m_coreId;
+    gtVector<AMDTUInt32>    m_stackId;
+    gtVector<AMDTUInt8>     m_threadState;
+    gtVector<AMDTUInt8>     m_waitReason;
+    gtVector<AMDTUInt8>     m_waitMode;
+
+    // Set when the timeline is mapped from a file
+    AMDTThreadSampleTimeline m_mapped;
+    bool                    m_isMapped;
+
+    // False if a sample was appended out of time order; then the time range can not be searched
+    bool                    m_isOrdered;
+
+    AMDTUInt32              m_nbrSamples;
+};
+
+//
+// tpMappedFile
+//
+// Read-only memory mapping of a whole file
+//
+
+class tpMappedFile
+{
+public:
+    tpMappedFile();
+    ~tpMappedFile();
+
+    bool Open(const char* pFilePath);
+    void Close();
+
+    const AMDTUInt8* GetData() const { return m_pData; }
+    size_t GetSize() const { return m_size; }
+
+private:
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+    void*                   m_fileHandle;
+    void*                   m_mapHandle;
+#else
+    int                     m_fd;
+#endif
+
+    const AMDTUInt8*        m_pData;
+    size_t                  m_size;
+};
+
+#endif //_TPTHREADTIMELINE_H_
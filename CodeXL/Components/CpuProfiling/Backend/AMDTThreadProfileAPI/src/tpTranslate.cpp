@@ -345,46 +345,54 @@ AMDTResult tpTranslate::GetThreadSampleData(AMDTThreadId       tid,
 {
     AMDTResult retVal = AMDT_STATUS_OK;
 
-    if ((NULL != pNbrRecords) && (NULL != ppThreadSampleData))
+    if ((NULL != pNbrRecords) || (NULL != ppThreadSampleData))
     {
         if (IsValidThread(tid))
         {
             auto threadIt = m_tidThreadDataMap.find(tid);
             TPThreadData& data = (*threadIt).second;
 
-            AMDTThreadSample* pSamples = NULL;
-            AMDTUInt32 nbrSamples = data.m_sampleList.size();
+            AMDTThreadSampleTimeline columns;
+            data.m_timeline.GetColumns(columns);
 
-            if (nbrSamples)
+            AMDTUInt32 nbrSamples = columns.m_nbrSamples;
+
+            if (NULL != pNbrRecords)
+            {
+                *pNbrRecords = nbrSamples;
+            }
+
+            // The samples are only copied when they are requested
+            if ((NULL != ppThreadSampleData) && (nbrSamples > 0))
             {
-                pSamples = (AMDTThreadSample*)malloc(sizeof(AMDTThreadSample) * nbrSamples);
+                AMDTThreadSample* pSamples = (AMDTThreadSample*)malloc(sizeof(AMDTThreadSample) * nbrSamples);
 
                 if (NULL != pSamples)
                 {
-                    AMDTUInt32 i = 0;
-
-                    for (TPThreadSampleList::const_iterator it = data.m_sampleList.begin(), itEnd = data.m_sampleList.end();
-                         it != itEnd; ++it, ++i)
+                    for (AMDTUInt32 i = 0; i < nbrSamples; i++)
                     {
                         pSamples[i].m_processId = data.m_processId;
                         pSamples[i].m_threadId = data.m_threadId;
-                        pSamples[i].m_coreId = (*it).m_coreId;
-                        pSamples[i].m_endTS = (*it).m_endTS;
-                        pSamples[i].m_startTS = (*it).m_startTS;
-                        pSamples[i].m_execTime = (*it).m_execTime;
-                        pSamples[i].m_waitTime = (*it).m_waitTime;
-                        pSamples[i].m_transitionTime = (*it).m_transitionTime;
-                        pSamples[i].m_nbrStackFrames = (*it).m_nbrStackFrames;
-
-                        //FIXME: should i alloc memory and copy.. or point to internal struct..
-                        pSamples[i].m_pStackFrames = (*it).m_pStackFrames;
-
-                        pSamples[i].m_threadState = (*it).m_threadState;
-                        pSamples[i].m_waitReason = (*it).m_waitReason;
-                        pSamples[i].m_waitMode = (*it).m_waitMode;
+                        pSamples[i].m_coreId = columns.m_pCoreId[i];
+                        pSamples[i].m_endTS = columns.m_pEndTS[i];
+                        pSamples[i].m_startTS = columns.m_pStartTS[i];
+                        pSamples[i].m_execTime = columns.m_pExecTime[i];
+                        pSamples[i].m_waitTime = columns.m_pWaitTime[i];
+                        pSamples[i].m_transitionTime = columns.m_pTransitionTime[i];
+
+                        // The frames point into the stack table
+                        AMDTUInt32 nbrFrames = 0;
+                        const AMDTUInt64* pFrames = NULL;
+                        m_stackTable.GetStack(columns.m_pStackId[i], nbrFrames, pFrames);
+
+                        pSamples[i].m_nbrStackFrames = nbrFrames;
+                        pSamples[i].m_pStackFrames = const_cast<AMDTUInt64*>(pFrames);
+
+                        pSamples[i].m_threadState = static_cast<AMDTThreadState>(columns.m_pThreadState[i]);
+                        pSamples[i].m_waitReason = static_cast<AMDTThreadWaitReason>(columns.m_pWaitReason[i]);
+                        pSamples[i].m_waitMode = static_cast<AMDTThreadWaitMode>(columns.m_pWaitMode[i]);
                     }
 
-                    *pNbrRecords = nbrSamples;
                     *ppThreadSampleData = pSamples;
                 }
                 else
@@ -407,6 +415,184 @@ AMDTResult tpTranslate::GetThreadSampleData(AMDTThreadId       tid,
 } // GetThreadSampleData
 
 
+AMDTResult tpTranslate::GetThreadSampleTimeline(AMDTThreadId              tid,
+                                                AMDTUInt64                startTS,
+                                                AMDTUInt64                endTS,
+                                                AMDTThreadSampleTimeline& timeline) const
+{
+    AMDTResult retVal = AMDT_ERROR_INVALIDDATA;
+    auto threadIt = m_tidThreadDataMap.find(tid);
+
+    if (threadIt != m_tidThreadDataMap.end())
+    {
+        const TPThreadData& data = (*threadIt).second;
+        AMDTUInt32 first = 0;
+        AMDTUInt32 count = 0;
+
+        data.m_timeline.GetColumns(timeline);
+        data.m_timeline.FindTimeRange(startTS, endTS, first, count);
+
+        // Slice the columns
+        timeline.m_processId = data.m_processId;
+        timeline.m_threadId = data.m_threadId;
+        timeline.m_nbrSamples = count;
+        timeline.m_pStartTS += first;
+        timeline.m_pEndTS += first;
+        timeline.m_pExecTime += first;
+        timeline.m_pWaitTime += first;
+        timeline.m_pTransitionTime += first;
+        timeline.m_pCoreId += first;
+        timeline.m_pThreadState += first;
+        timeline.m_pWaitReason += first;
+        timeline.m_pWaitMode += first;
+        timeline.m_pStackId += first;
+
+        retVal = AMDT_STATUS_OK;
+    }
+
+    return retVal;
+} // GetThreadSampleTimeline
+
+
+AMDTResult tpTranslate::GetThreadSampleStack(AMDTUInt32 stackId, AMDTUInt32& nbrFrames, const AMDTUInt64*& pFrames) const
+{
+    return m_stackTable.GetStack(stackId, nbrFrames, pFrames) ? AMDT_STATUS_OK : AMDT_ERROR_INVALIDARG;
+} // GetThreadSampleStack
+
+
+AMDTResult tpTranslate::SaveThreadSampleTimelines(const char* pFilePath) const
+{
+    AMDTResult retVal = AMDT_ERROR_INVALIDARG;
+
+    if (NULL != pFilePath)
+    {
+        retVal = AMDT_ERROR_FAIL;
+        FILE* pFile = fopen(pFilePath, "wb");
+
+        if (NULL != pFile)
+        {
+            TPTimelineFileHeader header;
+            header.m_magic = TP_TIMELINE_FILE_MAGIC;
+            header.m_version = TP_TIMELINE_FILE_VERSION;
+            header.m_nbrThreads = static_cast<AMDTUInt32>(m_tidThreadDataMap.size());
+            header.m_reserved = 0;
+
+            bool isWritten = (1 == fwrite(&header, sizeof(header), 1, pFile)) && m_stackTable.Write(pFile);
+
+            for (auto threadIt = m_tidThreadDataMap.begin(); isWritten && (threadIt != m_tidThreadDataMap.end()); threadIt++)
+            {
+                const TPThreadData& data = (*threadIt).second;
+
+                TPTimelineFileThread thread;
+                thread.m_processId = data.m_processId;
+                thread.m_threadId = data.m_threadId;
+                thread.m_nbrSamples = data.m_timeline.GetNumberOfSamples();
+                thread.m_flags = data.m_timeline.IsOrdered() ? TP_TIMELINE_THREAD_ORDERED : 0;
+                thread.m_nbrOfContextSwitches = data.m_nbrOfContextSwitches;
+                thread.m_nbrOfCoreSwitches = data.m_nbrOfCoreSwitches;
+                thread.m_totalExeTime = data.m_totalExeTime;
+                thread.m_totalWaitTime = data.m_totalWaitTime;
+                thread.m_totalTransitionTime = data.m_totalTransitionTime;
+
+                isWritten = (1 == fwrite(&thread, sizeof(thread), 1, pFile)) && data.m_timeline.Write(pFile);
+            }
+
+            isWritten = (0 == fclose(pFile)) && isWritten;
+
+            if (isWritten)
+            {
+                retVal = AMDT_STATUS_OK;
+            }
+        }
+    }
+
+    return retVal;
+} // SaveThreadSampleTimelines
+
+
+AMDTResult tpTranslate::LoadThreadSampleTimelines(const char* pFilePath)
+{
+    AMDTResult retVal = AMDT_ERROR_INVALIDARG;
+
+    if (NULL != pFilePath)
+    {
+        retVal = AMDT_ERROR_FAIL;
+    }
+
+    // The timelines can only be loaded once, instead of processing the context switch records
+    if ((AMDT_ERROR_FAIL == retVal) && !IsallCSRecordsProcessed() && m_timelinesFile.Open(pFilePath))
+    {
+        const AMDTUInt8* pEnd = m_timelinesFile.GetData() + m_timelinesFile.GetSize();
+        const TPTimelineFileHeader* pHeader = reinterpret_cast<const TPTimelineFileHeader*>(m_timelinesFile.GetData());
+
+        retVal = AMDT_ERROR_INVALIDDATA;
+
+        if ((m_timelinesFile.GetSize() >= sizeof(TPTimelineFileHeader)) &&
+            (TP_TIMELINE_FILE_MAGIC == pHeader->m_magic) &&
+            (TP_TIMELINE_FILE_VERSION == pHeader->m_version))
+        {
+            // The first pass only validates the file, so that nothing is mapped from an invalid file.
+            // The second pass maps the stack table and the timelines of the threads known from pass one.
+            bool isValid = true;
+
+            for (int pass = 0; isValid && (pass < 2); pass++)
+            {
+                const AMDTUInt8* pData = m_timelinesFile.GetData() + sizeof(TPTimelineFileHeader);
+                tpStackTable validationStackTable;
+
+                isValid = ((0 == pass) ? validationStackTable : m_stackTable).Map(pData, pEnd);
+
+                for (AMDTUInt32 i = 0; isValid && (i < pHeader->m_nbrThreads); i++)
+                {
+                    isValid = (static_cast<size_t>(pEnd - pData) >= sizeof(TPTimelineFileThread));
+
+                    if (isValid)
+                    {
+                        const TPTimelineFileThread* pThread = reinterpret_cast<const TPTimelineFileThread*>(pData);
+                        pData += sizeof(TPTimelineFileThread);
+
+                        auto threadIt = m_tidThreadDataMap.find(pThread->m_threadId);
+                        tpThreadTimeline validationTimeline;
+
+                        if ((0 == pass) || (threadIt == m_tidThreadDataMap.end()))
+                        {
+                            isValid = validationTimeline.Map(pData, pEnd, pThread->m_nbrSamples, false);
+                        }
+                        else
+                        {
+                            TPThreadData& data = (*threadIt).second;
+
+                            isValid = data.m_timeline.Map(pData, pEnd, pThread->m_nbrSamples,
+                                                          0 != (pThread->m_flags & TP_TIMELINE_THREAD_ORDERED));
+
+                            data.m_nbrOfContextSwitches = pThread->m_nbrOfContextSwitches;
+                            data.m_nbrOfCoreSwitches = pThread->m_nbrOfCoreSwitches;
+                            data.m_totalExeTime = pThread->m_totalExeTime;
+                            data.m_totalWaitTime = pThread->m_totalWaitTime;
+                            data.m_totalTransitionTime = pThread->m_totalTransitionTime;
+                        }
+                    }
+                }
+            }
+
+            if (isValid)
+            {
+                // There is no need to process the context switch records
+                m_allCSRecordsProcessed = true;
+                retVal = AMDT_STATUS_OK;
+            }
+        }
+
+        if (AMDT_STATUS_OK != retVal)
+        {
+            m_timelinesFile.Close();
+        }
+    }
+
+    return retVal;
+} // LoadThreadSampleTimelines
+
+
 #if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
 bool tpTranslate::ConvertDeviceNameToFileName(const gtString& deviceName, gtString& fileName)
 {
@@ -1069,8 +1255,8 @@ AMDTResult tpTranslate::AddCSwitchEvent(ThreadProfileEventCSwitch& csRec)
                 oldThreadSample.m_waitReason  = static_cast<AMDTThreadWaitReason>(csRec.m_oldThreadWaitReason);
                 oldThreadSample.m_threadState = static_cast<AMDTThreadState>(csRec.m_oldThreadState);
 
-                // push this sample into the list
-                (*oldThreadIt).second.m_sampleList.push_back(oldThreadSample);
+                // append this sample to the timeline
+                (*oldThreadIt).second.m_timeline.Append(oldThreadSample);
                 (*oldThreadIt).second.m_nbrOfContextSwitches++;
                 //(*oldThreadIt).second.m_prevProcessorId = csRec.m_processorId;
 
@@ -1169,16 +1355,8 @@ AMDTResult tpTranslate::AddStackEvent(ThreadProfileEventStack& stackRec)
 
             if (threadSample.m_intialized)
             {
-                threadSample.m_nbrStackFrames = stackRec.m_nbrFrames;
-
-                threadSample.m_pStackFrames = (AMDTUInt64*)malloc(sizeof(AMDTUInt64) * stackRec.m_nbrFrames);
-
-                for (AMDTUInt32 i = 0; i < stackRec.m_nbrFrames; i++)
-                {
-                    threadSample.m_pStackFrames[i] = stackRec.m_stacks[i];
-                }
-
-                // threadSample.m_pStackFrames - TODO: when will this freed ?
+                // The samples with the same call stack share it in the stack table
+                threadSample.m_stackId = m_stackTable.AddStack(stackRec.m_stacks, stackRec.m_nbrFrames);
             }
             else
             {
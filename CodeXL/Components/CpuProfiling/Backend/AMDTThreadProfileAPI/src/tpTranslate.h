@@ -74,6 +74,11 @@ public:
     size_t GetNumberOfThreads(AMDTProcessId pid) const;
 
     AMDTResult GetThreadSampleData(AMDTThreadId tid, AMDTUInt32* pNbrRecords, AMDTThreadSample** ppThreadSampleData);
+    AMDTResult GetThreadSampleTimeline(AMDTThreadId tid, AMDTUInt64 startTS, AMDTUInt64 endTS, AMDTThreadSampleTimeline& timeline) const;
+    AMDTResult GetThreadSampleStack(AMDTUInt32 stackId, AMDTUInt32& nbrFrames, const AMDTUInt64*& pFrames) const;
+
+    AMDTResult SaveThreadSampleTimelines(const char* pFilePath) const;
+    AMDTResult LoadThreadSampleTimelines(const char* pFilePath);
 
 #if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
     // TODO: This should be in OSWrappers - a generic helper function
@@ -140,6 +145,12 @@ protected:
     TPPidProcessDataMap     m_pidProcessDataMap;
     TPTidThreadDataMap      m_tidThreadDataMap;
 
+    // Call stacks of the samples of all the threads
+    tpStackTable            m_stackTable;
+
+    // Timelines file mapped by LoadThreadSampleTimelines()
+    tpMappedFile            m_timelinesFile;
+
     // Kernel image
 #if AMDT_BUILD_TARGET == AMDT_LINUX_OS
     TPImageData             m_kernelImage;
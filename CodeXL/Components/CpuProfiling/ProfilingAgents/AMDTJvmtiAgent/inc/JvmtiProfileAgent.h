@@ -16,6 +16,10 @@
 #include <jvmticmlr.h>
 #include <BytecodeToSource.h>
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+    #include <AMDTProfilingAgentsData/inc/JitCodeLog.h>
+#endif
+
 //
 //    Macros
 //
@@ -55,6 +59,10 @@ extern std::wstring gJvmCmd;
 extern std::wstring gSampleDir;
 extern std::wstring gProfileDataDir;
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+    extern JitCodeLogWriter* gJitCodeLog;
+#endif
+
 //
 //    Helper Routines
 //
@@ -82,4 +90,93 @@ int WriteNativeToJncFile(const char*    name,
                          jint           code_size,
                          std::wstring*  jncFileName);
 
+// Get the parsed class and method names of a method and the source file of its class,
+// into buffers of OS_MAX_PATH chars
+void GetMethodNames(jvmtiEnv*  pJvmtiEnv,
+                    jmethodID  method,
+                    char*      pClassName,
+                    char*      pMethodName,
+                    char*      pSrcFile);
+
+// Write the JCL load record and the JNC file of a compiled method
+void WriteCompiledMethod(jvmtiEnv*                    pJvmtiEnv,
+                         jmethodID                    method,
+                         jint                         codeSize,
+                         const void*                  codeAddr,
+                         jint                         mapLength,
+                         const jvmtiAddrLocationMap*  map,
+                         const void*                  compileInfo,
+                         gtUInt64                     loadTimeStamp);
+
+// Write the JCL load record and the code of dynamically generated code
+void WriteDynamicCode(const char*  name,
+                      const void*  codeAddr,
+                      jint         codeSize,
+                      const void*  pCode,
+                      gtUInt64     loadTimeStamp);
+
+// Write the JCL unload record
+void WriteUnloadRecord(const void* codeAddr, gtUInt64 unloadTimeStamp);
+
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
+// The .pc2bc, .stringtable and .bc2src sections of the JIT code of a compiled method, as appended to the code log
+struct JncSectionBlobs
+{
+    void*  lineInfoBlob;
+    jint   lineInfoBlobSize;
+    void*  methodTableBlob;
+    jint   methodTableBlobSize;
+    void*  stringTableBlob;
+    jint   stringTableSize;
+};
+
+// Build the JNC sections of a compiled method; they query the JVM about the method and its inlined methods
+bool BuildJncSectionBlobs(jvmtiEnv*                    pJvmtiEnv,
+                          jmethodID                    method,
+                          jint                         codeSize,
+                          const void*                  codeAddr,
+                          jint                         mapLength,
+                          const jvmtiAddrLocationMap*  map,
+                          const void*                  compileInfo,
+                          JncSectionBlobs&             blobs);
+
+void FreeJncSectionBlobs(JncSectionBlobs& blobs);
+
+// Write the JCL load record of a compiled method whose JIT code is in the code log record at recordOffset
+void WriteCodeLogLoadRecord(methodInfo*  mInfo,
+                            jint         codeSize,
+                            const void*  codeAddr,
+                            gtUInt64     recordOffset,
+                            gtUInt64     loadTimeStamp);
+
+//
+//    Asynchronous mode
+//
+//    The event callbacks resolve everything they need from the JVM, copy the events into a lock-free
+//    ring and return, and an agent thread writes them to the JCL file and the JIT code log. The agent
+//    thread makes no JVMTI call other than on raw monitors, so it never waits for a safepoint.
+//
+
+bool IsAsyncModeRequested(const char* options);
+bool InitializeAsyncMode(jvmtiEnv* pJvmtiEnv, const std::wstring& profileDataDir);
+bool IsAsyncModeEnabled();
+void StartAsyncMode(jvmtiEnv* pJvmtiEnv, JNIEnv* pJniEnv);
+void StopAsyncMode(jvmtiEnv* pJvmtiEnv);
+
+bool QueueCompiledMethodLoad(jvmtiEnv*                    pJvmtiEnv,
+                             jmethodID                    method,
+                             jint                         codeSize,
+                             const void*                  codeAddr,
+                             jint                         mapLength,
+                             const jvmtiAddrLocationMap*  map,
+                             const void*                  compileInfo,
+                             gtUInt64                     loadTimeStamp);
+
+bool QueueCompiledMethodUnload(jvmtiEnv* pJvmtiEnv, const void* codeAddr, gtUInt64 unloadTimeStamp);
+
+bool QueueDynamicCode(jvmtiEnv* pJvmtiEnv, const char* name, const void* codeAddr, jint codeSize, gtUInt64 loadTimeStamp);
+
+#endif // AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
 #endif // _JVMTIPROFILEAGENT_H_
@@ -71,6 +71,8 @@ const char*  gUnknownMethodName = "UnknownMethodName";
 
 void JNICALL cbVMInit(jvmtiEnv* pJvmtiEnv, JNIEnv* pJniEnv, jthread thread);
 
+void JNICALL cbVMDeath(jvmtiEnv* pJvmtiEnv, JNIEnv* pJniEnv);
+
 void JNICALL cbCompiledMethodLoad(jvmtiEnv*                    pJvmtiEnv,
                                   jmethodID                    method,
                                   jint                         codeSize,
@@ -111,6 +113,10 @@ static void handleFatalError(jvmtiEnv* pJvmtiEnv, const char* format, ...)
                                             JVMTI_EVENT_VM_INIT,
                                             (jthread)nullptr);
 
+        pJvmtiEnv->SetEventNotificationMode(JVMTI_DISABLE,
+                                            JVMTI_EVENT_VM_DEATH,
+                                            (jthread)nullptr);
+
         pJvmtiEnv->SetEventNotificationMode(JVMTI_DISABLE,
                                             JVMTI_EVENT_COMPILED_METHOD_LOAD,
                                             (jthread)nullptr);
@@ -310,14 +316,12 @@ static void writeJCLFile(jvmtiEnv*     pJvmtiEnv,
 static void writeNativeToJCLFile(wchar_t*      name,
                                  int           codeSize,
                                  const void*   codeAddr,
-                                 std::wstring* jncFileName)
+                                 std::wstring* jncFileName,
+                                 gtUInt64      loadTimeStamp)
 {
     if (nullptr != gJCLWriter)
     {
         JitLoadRecord jclLoadRec;
-        gtUInt64 loadTimeStamp = 0;
-
-        QueryCurrentTime(loadTimeStamp);
 
         jclLoadRec.loadTimestamp  = loadTimeStamp;
         jclLoadRec.blockStartAddr = (gtUInt64)codeAddr;
@@ -481,6 +485,16 @@ JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM* vm, char* options, void* reserved)
     // This just writes the header record
     gJCLWriter->Initialize();
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
+    // The JIT code is appended to the code log by the agent thread, instead of a JNC file per method
+    if (IsAsyncModeRequested(options) && !InitializeAsyncMode(jvmti, profileDataDir))
+    {
+        fprintf(stderr, "JVMTIProfileAgent: could not initialize the asynchronous mode\n");
+    }
+
+#endif
+
     // Preserve the jvmti environment, in case if it is required
     // during unload
     gJvmti = jvmti;
@@ -516,12 +530,14 @@ JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM* vm, char* options, void* reserved)
 
     // Event-Callbacks are implemented for the following Events
     //     VMInit
+    //     VMDeath
     //     JVMTI_EVENT_COMPILED_METHOD_LOAD
     //     JVMTI_EVENT_COMPILED_METHOD_UNLOAD
     //     JVMTI_EVENT_DYNAMIC_CODE_GENERATED
     //     JVMTI_EVENT_CLASS_LOAD
     //
     callbacks.VMInit               = &cbVMInit;
+    callbacks.VMDeath              = &cbVMDeath;
     callbacks.CompiledMethodLoad   = &cbCompiledMethodLoad;
     callbacks.CompiledMethodUnload = &cbCompiledMethodUnload;
     callbacks.DynamicCodeGenerated = &cbDynamicCodeGenerated;
@@ -539,6 +555,7 @@ JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM* vm, char* options, void* reserved)
 
     // Register the interesting Events
     //     JVMTI_EVENT_VM_INIT
+    //     JVMTI_EVENT_VM_DEATH
     //     JVMTI_EVENT_COMPILED_METHOD_LOAD
     //     JVMTI_EVENT_COMPILED_METHOD_UNLOAD
     //     JVMTI_EVENT_DYNAMIC_CODE_GENERATED
@@ -553,6 +570,15 @@ JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM* vm, char* options, void* reserved)
         return JVMTI_ERROR_NONE;
     }
 
+    error = jvmti->SetEventNotificationMode(JVMTI_ENABLE,
+                                            JVMTI_EVENT_VM_DEATH,
+                                            (jthread)nullptr);
+
+    if (0 != handleJvmtiError(jvmti, error, "Cannot set event notification"))
+    {
+        return JVMTI_ERROR_NONE;
+    }
+
     error = jvmti->SetEventNotificationMode(JVMTI_ENABLE,
                                             JVMTI_EVENT_COMPILED_METHOD_LOAD,
                                             (jthread)nullptr);
@@ -635,9 +661,40 @@ void JNICALL cbVMInit(jvmtiEnv* pJvmtiEnv, JNIEnv* pJniEnv, jthread thread)
     GT_UNREFERENCED_PARAMETER(thread);
     // pJvmtiEnv->GenerateEvents (JVMTI_EVENT_COMPILED_METHOD_LOAD);
     // pJvmtiEnv->GenerateEvents (JVMTI_EVENT_DYNAMIC_CODE_GENERATED);
+
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
+    // The agent thread can only be started in the live phase
+    if (IsAsyncModeEnabled())
+    {
+        StartAsyncMode(pJvmtiEnv, pJniEnv);
+    }
+
+#endif
 } // cbVMInit
 
 
+// cbVMDeath
+//
+// Callback to VM Death Event - VMDeath; no events are sent after it
+//
+void JNICALL cbVMDeath(jvmtiEnv* pJvmtiEnv, JNIEnv* pJniEnv)
+{
+    GT_UNREFERENCED_PARAMETER(pJvmtiEnv);
+    GT_UNREFERENCED_PARAMETER(pJniEnv);
+
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
+    // Write the events still in the ring
+    if (IsAsyncModeEnabled())
+    {
+        StopAsyncMode(pJvmtiEnv);
+    }
+
+#endif
+} // cbVMDeath
+
+
 // cbCompiledMethodLoad
 //
 void JNICALL cbCompiledMethodLoad(jvmtiEnv*                    pJvmtiEnv,
@@ -648,14 +705,7 @@ void JNICALL cbCompiledMethodLoad(jvmtiEnv*                    pJvmtiEnv,
                                   const jvmtiAddrLocationMap*  map,
                                   const void*                  compileInfo)
 {
-    jclass       declaringClass;
-    char*        pClassSig = nullptr;
-    char*        pMethodName = nullptr;
-    char*        pMethodSig = nullptr;
-    char*        pSrcFile = nullptr;
-    gtUInt64     loadTimeStamp = 0;
-    std::wstring jncFile;
-    methodInfo   mInfo{nullptr, nullptr, nullptr};
+    gtUInt64 loadTimeStamp = 0;
 
     // Get the module load timestamp
     QueryCurrentTime(loadTimeStamp);
@@ -665,49 +715,121 @@ void JNICALL cbCompiledMethodLoad(jvmtiEnv*                    pJvmtiEnv,
         return;
     }
 
-    // Construct the JNC filename
-    if (gReJitMap.end() == gReJitMap.find((gtUInt64)codeAddr))
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
+    if (IsAsyncModeEnabled() &&
+        QueueCompiledMethodLoad(pJvmtiEnv, method, codeSize, codeAddr, mapLength, map, compileInfo, loadTimeStamp))
     {
-        gReJitMap[(gtUInt64)codeAddr] = 0;
+        return;
     }
 
-    wchar_t tmpPath[OS_MAX_PATH] = { L'\0' };
-    swprintf(tmpPath, OS_MAX_PATH - 1, WIDE_STR_FORMAT PATH_SEPARATOR L"JITCode-%p-%d.jnc",
-             gProfileDataDir.c_str(), codeAddr, gReJitMap[(gtUInt64)codeAddr]);
-    jncFile = tmpPath;
+#endif
 
-    ++gReJitMap[(gtUInt64)codeAddr];
+    WriteCompiledMethod(pJvmtiEnv,
+                        method,
+                        codeSize,
+                        codeAddr,
+                        mapLength,
+                        map,
+                        compileInfo,
+                        loadTimeStamp);
+} // cbCompiledMethodLoad
 
-    // Get the class signature and Method name
-    pJvmtiEnv->GetMethodDeclaringClass(method, &declaringClass);
-    pJvmtiEnv->GetClassSignature(declaringClass, &pClassSig, nullptr);
-    char parsedClassName[OS_MAX_PATH] = {0};
 
-    if (parseClassSignature(pClassSig, parsedClassName))
+// GetMethodNames
+//
+void GetMethodNames(jvmtiEnv*  pJvmtiEnv,
+                    jmethodID  method,
+                    char*      pClassName,
+                    char*      pMethodName,
+                    char*      pSrcFile)
+{
+    jclass declaringClass = nullptr;
+    char*  pClassSig = nullptr;
+    char*  pName = nullptr;
+    char*  pMethodSig = nullptr;
+    char*  pSourceFile = nullptr;
+
+    // Get the class signature and Method name
+    if (JVMTI_ERROR_NONE == pJvmtiEnv->GetMethodDeclaringClass(method, &declaringClass))
     {
-        mInfo.pClassSig = parsedClassName;
+        pJvmtiEnv->GetClassSignature(declaringClass, &pClassSig, nullptr);
     }
-    else
+
+    if (!parseClassSignature(pClassSig, pClassName))
     {
-        mInfo.pClassSig = (char*)gUnknownClassName;
+        strncpy(pClassName, gUnknownClassName, OS_MAX_PATH - 1);
     }
 
     // Get the Method name, signature
-    pJvmtiEnv->GetMethodName(method, &pMethodName, &pMethodSig, nullptr);
-    char parsedMethodName[OS_MAX_PATH] = {0};
+    pJvmtiEnv->GetMethodName(method, &pName, &pMethodSig, nullptr);
 
-    if (parseMethodSignature(pMethodName, pMethodSig, parsedMethodName))
+    if (!parseMethodSignature(pName, pMethodSig, pMethodName))
     {
-        mInfo.pMethodName = parsedMethodName;
+        strncpy(pMethodName, gUnknownMethodName, OS_MAX_PATH - 1);
     }
-    else
+
+    // Get the Source filename of the class
+    if (nullptr != declaringClass)
     {
-        mInfo.pMethodName = (char*)gUnknownMethodName;
+        pJvmtiEnv->GetSourceFileName(declaringClass, &pSourceFile);
     }
 
-    // Get the Source filename of the class
-    pJvmtiEnv->GetSourceFileName(declaringClass, &pSrcFile);
-    mInfo.pSrcFile = (nullptr != pSrcFile) ? pSrcFile : (char*)gUnknownSrcFile;
+    strncpy(pSrcFile, (nullptr != pSourceFile) ? pSourceFile : gUnknownSrcFile, OS_MAX_PATH - 1);
+
+    if (nullptr != pClassSig)
+    {
+        pJvmtiEnv->Deallocate((unsigned char*)pClassSig);
+    }
+
+    if (nullptr != pName)
+    {
+        pJvmtiEnv->Deallocate((unsigned char*)pName);
+    }
+
+    if (nullptr != pMethodSig)
+    {
+        pJvmtiEnv->Deallocate((unsigned char*)pMethodSig);
+    }
+
+    if (nullptr != pSourceFile)
+    {
+        pJvmtiEnv->Deallocate((unsigned char*)pSourceFile);
+    }
+} // GetMethodNames
+
+
+// WriteCompiledMethod
+//
+void WriteCompiledMethod(jvmtiEnv*                    pJvmtiEnv,
+                         jmethodID                    method,
+                         jint                         codeSize,
+                         const void*                  codeAddr,
+                         jint                         mapLength,
+                         const jvmtiAddrLocationMap*  map,
+                         const void*                  compileInfo,
+                         gtUInt64                     loadTimeStamp)
+{
+    std::wstring jncFile;
+    char         parsedClassName[OS_MAX_PATH] = {0};
+    char         parsedMethodName[OS_MAX_PATH] = {0};
+    char         srcFile[OS_MAX_PATH] = {0};
+    methodInfo   mInfo{parsedClassName, parsedMethodName, srcFile};
+
+    GetMethodNames(pJvmtiEnv, method, parsedClassName, parsedMethodName, srcFile);
+
+    // Construct the JNC filename
+    if (gReJitMap.end() == gReJitMap.find((gtUInt64)codeAddr))
+    {
+        gReJitMap[(gtUInt64)codeAddr] = 0;
+    }
+
+    wchar_t tmpPath[OS_MAX_PATH] = { L'\0' };
+    swprintf(tmpPath, OS_MAX_PATH - 1, WIDE_STR_FORMAT PATH_SEPARATOR L"JITCode-%p-%d.jnc",
+             gProfileDataDir.c_str(), codeAddr, gReJitMap[(gtUInt64)codeAddr]);
+    jncFile = tmpPath;
+
+    ++gReJitMap[(gtUInt64)codeAddr];
 
     if (gJvmtiVerbose)
     {
@@ -753,22 +875,49 @@ void JNICALL cbCompiledMethodLoad(jvmtiEnv*                    pJvmtiEnv,
                  &jncFile,      // JNC File name
                  &mInfo,        // method info
                  compileInfo);
+} // WriteCompiledMethod
 
-    if (nullptr != pClassSig)
-    {
-        pJvmtiEnv->Deallocate((unsigned char*)pClassSig);
-    }
 
-    if (nullptr != pMethodName)
-    {
-        pJvmtiEnv->Deallocate((unsigned char*)pMethodName);
-    }
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
+// WriteCodeLogLoadRecord
+//
+// Written by the agent thread of the asynchronous mode, so it does not use the JVM
+//
+void WriteCodeLogLoadRecord(methodInfo*  mInfo,
+                            jint         codeSize,
+                            const void*  codeAddr,
+                            gtUInt64     recordOffset,
+                            gtUInt64     loadTimeStamp)
+{
+    // Reference the record of the code log in the JCL file
+    wchar_t reference[OS_MAX_PATH] = { L'\0' };
+    gJitCodeLog->FormatReference(recordOffset, reference, OS_MAX_PATH);
+    std::wstring jncFile = reference;
 
-    if (nullptr != pSrcFile)
+    if (gJvmtiVerbose)
     {
-        pJvmtiEnv->Deallocate((unsigned char*)pSrcFile);
+        fwprintf(stderr, L"\ncbCompileMethodLoad : 0x%p: " CSTR_FORMAT L"::" CSTR_FORMAT L"",
+                 codeAddr, mInfo->pClassSig, mInfo->pMethodName);
+
+        fwprintf(stderr, L"\njncFile name : " WIDE_STR_FORMAT, jncFile.c_str());
+        fwprintf(stderr, L"\nsource file : " CSTR_FORMAT, mInfo->pSrcFile);
+
+        fwprintf(stderr, L"\ncode addr : %p", codeAddr);
+        fwprintf(stderr, L"\ncode size : %d", codeSize);
+        fwprintf(stderr, L"\nload timestamp : %llu\n", loadTimeStamp);
     }
-} // cbCompiledMethodLoad
+
+    writeJCLFile(nullptr,
+                 nullptr,
+                 codeSize,
+                 codeAddr,
+                 &jncFile,
+                 mInfo,
+                 loadTimeStamp);
+} // WriteCodeLogLoadRecord
+
+#endif
 
 
 // cbCompileMethodUnload
@@ -797,16 +946,35 @@ void JNICALL cbCompiledMethodUnload(jvmtiEnv*    pJvmtiEnv,
         pJvmtiEnv->Deallocate((unsigned char*)pMethodName);
     }
 
-    JitUnloadRecord jclUnloadRec;
     gtUInt64 unloadTimeStamp = 0;
 
     QueryCurrentTime(unloadTimeStamp);
 
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
+    // Queued as well, to be written after the load record of the method
+    if (IsAsyncModeEnabled() && QueueCompiledMethodUnload(pJvmtiEnv, codeAddr, unloadTimeStamp))
+    {
+        return;
+    }
+
+#endif
+
+    WriteUnloadRecord(codeAddr, unloadTimeStamp);
+} // cbCompiledMethodUnload
+
+
+// WriteUnloadRecord
+//
+void WriteUnloadRecord(const void* codeAddr, gtUInt64 unloadTimeStamp)
+{
+    JitUnloadRecord jclUnloadRec;
+
     jclUnloadRec.unloadTimestamp = unloadTimeStamp;
     jclUnloadRec.blockStartAddr  = reinterpret_cast<gtUInt64>(codeAddr);
 
     gJCLWriter->WriteUnloadRecord(&jclUnloadRec);
-} // cbCompiledMethodUnload
+} // WriteUnloadRecord
 
 
 // cbDynamicCodeGenerated
@@ -824,20 +992,64 @@ void JNICALL cbDynamicCodeGenerated(jvmtiEnv* pJvmtiEnv, const char* name, const
         fprintf(stderr, "cbd End address: 0x%zd\n\n", ((size_t)codeAddr + codeSize));
     }
 
-    // Construct the JNC filename
+    gtUInt64 loadTimeStamp = 0;
+
+    QueryCurrentTime(loadTimeStamp);
+
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
+    if (IsAsyncModeEnabled() && QueueDynamicCode(pJvmtiEnv, name, codeAddr, codeSize, loadTimeStamp))
+    {
+        return;
+    }
+
+#endif
+
+    WriteDynamicCode(name, codeAddr, codeSize, nullptr, loadTimeStamp);
+} //cbDynamicCodeGenerated
+
+
+// WriteDynamicCode
+//
+void WriteDynamicCode(const char* name, const void* codeAddr, jint codeSize, const void* pCode, gtUInt64 loadTimeStamp)
+{
     std::wstring jncFile;
 
-    if (gReJitMap.end() == gReJitMap.find((gtUInt64)codeAddr))
+#if AMDT_BUILD_TARGET == AMDT_LINUX_OS
+
+    if (nullptr != pCode)
     {
-        gReJitMap[(gtUInt64)codeAddr] = 0;
+        gtUInt64 recordOffset = 0;
+
+        // There is no line information for the dynamically generated code, only the code itself
+        if (nullptr == gJitCodeLog ||
+            !gJitCodeLog->AppendRecord(name, (gtUInt64)codeAddr, pCode, codeSize, nullptr, 0, nullptr, 0, nullptr, 0, recordOffset))
+        {
+            return;
+        }
+
+        wchar_t reference[OS_MAX_PATH] = { L'\0' };
+        gJitCodeLog->FormatReference(recordOffset, reference, OS_MAX_PATH);
+        jncFile = reference;
     }
 
-    wchar_t tmpPath[OS_MAX_PATH] = { L'\0' };
-    swprintf(tmpPath, OS_MAX_PATH - 1, WIDE_STR_FORMAT PATH_SEPARATOR L"JITCode-%p-%d.jnc",
-             gProfileDataDir.c_str(), codeAddr, gReJitMap[(gtUInt64)codeAddr]);
-    jncFile = tmpPath;
+#endif
 
-    ++gReJitMap[(gtUInt64)codeAddr];
+    if (nullptr == pCode)
+    {
+        // Construct the JNC filename
+        if (gReJitMap.end() == gReJitMap.find((gtUInt64)codeAddr))
+        {
+            gReJitMap[(gtUInt64)codeAddr] = 0;
+        }
+
+        wchar_t tmpPath[OS_MAX_PATH] = { L'\0' };
+        swprintf(tmpPath, OS_MAX_PATH - 1, WIDE_STR_FORMAT PATH_SEPARATOR L"JITCode-%p-%d.jnc",
+                 gProfileDataDir.c_str(), codeAddr, gReJitMap[(gtUInt64)codeAddr]);
+        jncFile = tmpPath;
+
+        ++gReJitMap[(gtUInt64)codeAddr];
+    }
 
     wchar_t methodName[OS_MAX_PATH];
     memset(methodName, 0, sizeof(methodName));
@@ -848,14 +1060,18 @@ void JNICALL cbDynamicCodeGenerated(jvmtiEnv* pJvmtiEnv, const char* name, const
     writeNativeToJCLFile(methodName,
                          codeSize,
                          codeAddr,
-                         &jncFile);
+                         &jncFile,
+                         loadTimeStamp);
 
-    // write the JNC file for dynamic code generated
-    WriteNativeToJncFile(name,          // Method name
-                         codeAddr,
-                         codeSize,
-                         &jncFile);    // JNC file name
-} //cbDynamicCodeGenerated
+    if (nullptr == pCode)
+    {
+        // write the JNC file for dynamic code generated
+        WriteNativeToJncFile(name,          // Method name
+                             codeAddr,
+                             codeSize,
+                             &jncFile);    // JNC file name
+    }
+} // WriteDynamicCode
 
 
 void JNICALL cbClassLoad(jvmtiEnv* pJvmtiEnv, JNIEnv* pJniEnv, jthread thread, jclass klass)
@@ -0,0 +1,596 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file JvmtiAsyncMode_Lin.cpp
+/// \brief JVMTI Java Profile Agent - asynchronous writing of the JIT events.
+///
+//==================================================================================
+
+// System Headers
+#include <sched.h>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cwchar>
+#include <cstdint>
+#include <new>
+#include <atomic>
+#include <string>
+
+#include <JvmtiProfileAgent.h>
+
+extern int gJvmtiVerbose;
+
+//
+//    Macros
+//
+
+#define ASYNC_MODE_OPTION           "async"
+#define ASYNC_MODE_ENV_VARIABLE     "CODEXL_JVMTI_ASYNC"
+
+// Must be a power of 2
+#define ASYNC_EVENT_RING_SIZE       16384
+
+// The agent thread polls the ring, so that the callbacks never have to wake it up
+#define ASYNC_AGENT_POLL_MS         10
+
+#define ASYNC_EVENT_ALIGN(size)     (((size) + 7) & ~static_cast<size_t>(7))
+
+//
+//    Typedefs
+//
+
+enum JitEventType
+{
+    JIT_EVENT_METHOD_LOAD,
+    JIT_EVENT_METHOD_UNLOAD,
+    JIT_EVENT_DYNAMIC_CODE
+};
+
+// A JIT event as copied by the callback. The copied data follows the structure, in the same allocation,
+// except for the JNC sections of a compiled method which are allocated by BuildJncSectionBlobs.
+// Nothing in it refers to the JVM, as the method may be unloaded before the event is written.
+struct JitEvent
+{
+    JitEventType     type;
+    gtUInt64         timestamp;
+    const void*      codeAddr;
+    jint             codeSize;
+    const void*      pCode;
+    const char*      name;
+    methodInfo       mInfo;
+    JncSectionBlobs  sections;
+};
+
+// Bounded multi-producer queue of the events (D. Vyukov's bounded MPMC queue).
+// The sequence number of each slot tells whether it is free for the producer of the position,
+// or holds the event for the consumer.
+class JitEventRing
+{
+public:
+    JitEventRing() : m_pSlots(nullptr), m_mask(0), m_enqueuePos(0), m_dequeuePos(0) {}
+
+    bool Initialize(size_t size)
+    {
+        m_pSlots = new (std::nothrow) Slot[size];
+
+        if (nullptr == m_pSlots)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < size; i++)
+        {
+            m_pSlots[i].sequence.store(i, std::memory_order_relaxed);
+            m_pSlots[i].pEvent = nullptr;
+        }
+
+        m_mask = size - 1;
+        return true;
+    }
+
+    // Returns false if the ring is full
+    bool Push(JitEvent* pEvent)
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Slot& slot = m_pSlots[pos & m_mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (0 == diff)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.pEvent = pEvent;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (0 > diff)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns false if the ring is empty
+    bool Pop(JitEvent*& pEvent)
+    {
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Slot& slot = m_pSlots[pos & m_mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+            if (0 == diff)
+            {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    pEvent = slot.pEvent;
+                    slot.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (0 > diff)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool IsEmpty() const
+    {
+        return m_dequeuePos.load(std::memory_order_relaxed) == m_enqueuePos.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        JitEvent*           pEvent;
+    };
+
+    Slot*   m_pSlots;
+    size_t  m_mask;
+
+    // The producers and the consumer update their positions on different cache lines
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    alignas(64) std::atomic<size_t> m_dequeuePos;
+};
+
+//
+//    Globals
+//
+
+JitCodeLogWriter* gJitCodeLog = nullptr;
+
+static JitEventRing       gEventRing;
+static std::atomic<bool>  gAsyncMode(false);
+
+// Serializes the writing of the events, by the agent thread or by a callback finding the ring full
+static jrawMonitorID      gWriteMonitor = nullptr;
+
+// The agent thread waits on it, guards the agent thread state
+static jrawMonitorID      gAgentMonitor = nullptr;
+static std::atomic<bool>  gAgentThreadRunning(false);
+static bool               gAgentStopRequested = false;
+
+static std::atomic<gtUInt32> gQueuedEvents(0);
+static std::atomic<gtUInt32> gRingFullCount(0);
+
+
+//
+//    Helper Routines
+//
+
+// Appends the JIT code of a compiled method to the code log, the method is dropped if it fails
+static void writeCompiledMethod(JitEvent& event)
+{
+    std::string strName = event.mInfo.pClassSig;
+    strName += "::";
+    strName += event.mInfo.pMethodName;
+
+    gtUInt64 recordOffset = 0;
+
+    if (gJitCodeLog->AppendRecord(strName.c_str(),
+                                  (gtUInt64)event.codeAddr,
+                                  event.pCode,
+                                  event.codeSize,
+                                  event.sections.lineInfoBlob,
+                                  event.sections.lineInfoBlobSize,
+                                  event.sections.stringTableBlob,
+                                  event.sections.stringTableSize,
+                                  event.sections.methodTableBlob,
+                                  event.sections.methodTableBlobSize,
+                                  recordOffset))
+    {
+        WriteCodeLogLoadRecord(&event.mInfo, event.codeSize, event.codeAddr, recordOffset, event.timestamp);
+    }
+
+    FreeJncSectionBlobs(event.sections);
+} // writeCompiledMethod
+
+
+static void writeEvent(JitEvent& event)
+{
+    switch (event.type)
+    {
+        case JIT_EVENT_METHOD_LOAD:
+            writeCompiledMethod(event);
+            break;
+
+        case JIT_EVENT_METHOD_UNLOAD:
+            WriteUnloadRecord(event.codeAddr, event.timestamp);
+            break;
+
+        case JIT_EVENT_DYNAMIC_CODE:
+            WriteDynamicCode(event.name, event.codeAddr, event.codeSize, event.pCode, event.timestamp);
+            break;
+    }
+} // writeEvent
+
+
+// Writes the queued events, in their queuing order
+static void writeQueuedEvents(jvmtiEnv* pJvmtiEnv)
+{
+    JitEvent* pEvent;
+
+    pJvmtiEnv->RawMonitorEnter(gWriteMonitor);
+
+    while (gEventRing.Pop(pEvent))
+    {
+        writeEvent(*pEvent);
+        free(pEvent);
+    }
+
+    pJvmtiEnv->RawMonitorExit(gWriteMonitor);
+} // writeQueuedEvents
+
+
+static JitEvent* allocateEvent(JitEventType type, gtUInt64 timestamp, const void* codeAddr, jint codeSize, size_t dataSize)
+{
+    JitEvent* pEvent = static_cast<JitEvent*>(malloc(ASYNC_EVENT_ALIGN(sizeof(JitEvent)) + dataSize));
+
+    if (nullptr != pEvent)
+    {
+        memset(pEvent, 0, sizeof(JitEvent));
+        pEvent->type      = type;
+        pEvent->timestamp = timestamp;
+        pEvent->codeAddr  = codeAddr;
+        pEvent->codeSize  = codeSize;
+    }
+
+    return pEvent;
+} // allocateEvent
+
+
+// Waits for room in the ring when it is full. This is safe even at a safepoint: writing the events
+// only takes raw monitors and does file I/O, so the agent thread keeps draining the ring.
+static void queueEvent(jvmtiEnv* pJvmtiEnv, JitEvent* pEvent)
+{
+    gQueuedEvents.fetch_add(1, std::memory_order_relaxed);
+
+    while (!gEventRing.Push(pEvent))
+    {
+        gRingFullCount.fetch_add(1, std::memory_order_relaxed);
+
+        // Wait for the agent thread to make room, or write the events if it is not running
+        if (gAgentThreadRunning)
+        {
+            sched_yield();
+        }
+        else
+        {
+            writeQueuedEvents(pJvmtiEnv);
+        }
+    }
+} // queueEvent
+
+
+// The agent thread
+static void JNICALL asyncAgentThread(jvmtiEnv* pJvmtiEnv, JNIEnv* pJniEnv, void* pArg)
+{
+    GT_UNREFERENCED_PARAMETER(pJniEnv);
+    GT_UNREFERENCED_PARAMETER(pArg);
+
+    pJvmtiEnv->RawMonitorEnter(gAgentMonitor);
+
+    while (!gAgentStopRequested)
+    {
+        pJvmtiEnv->RawMonitorExit(gAgentMonitor);
+
+        writeQueuedEvents(pJvmtiEnv);
+
+        pJvmtiEnv->RawMonitorEnter(gAgentMonitor);
+
+        if (!gAgentStopRequested && gEventRing.IsEmpty())
+        {
+            pJvmtiEnv->RawMonitorWait(gAgentMonitor, ASYNC_AGENT_POLL_MS);
+        }
+    }
+
+    gAgentThreadRunning.store(false);
+    pJvmtiEnv->RawMonitorNotifyAll(gAgentMonitor);
+    pJvmtiEnv->RawMonitorExit(gAgentMonitor);
+} // asyncAgentThread
+
+
+//
+//    Asynchronous mode
+//
+
+// IsAsyncModeRequested
+//
+// The asynchronous mode is requested by the agent option "async" (-agentpath:<agent>=async),
+// or by setting the CODEXL_JVMTI_ASYNC environment variable to a non-zero value.
+//
+bool IsAsyncModeRequested(const char* options)
+{
+    bool ret = false;
+
+    if (nullptr != options)
+    {
+        const char* pOption = options;
+        size_t optionLength = strlen(ASYNC_MODE_OPTION);
+
+        while (!ret && nullptr != pOption)
+        {
+            ret = (0 == strncmp(pOption, ASYNC_MODE_OPTION, optionLength)) &&
+                  ('\0' == pOption[optionLength] || ',' == pOption[optionLength]);
+
+            pOption = strchr(pOption, ',');
+
+            if (nullptr != pOption)
+            {
+                pOption++;
+            }
+        }
+    }
+
+    if (!ret)
+    {
+        const char* pValue = getenv(ASYNC_MODE_ENV_VARIABLE);
+        ret = (nullptr != pValue) && ('\0' != pValue[0]) && (0 != strcmp(pValue, "0"));
+    }
+
+    return ret;
+} // IsAsyncModeRequested
+
+
+// InitializeAsyncMode
+//
+bool InitializeAsyncMode(jvmtiEnv* pJvmtiEnv, const std::wstring& profileDataDir)
+{
+    if (!gEventRing.Initialize(ASYNC_EVENT_RING_SIZE))
+    {
+        return false;
+    }
+
+    if (JVMTI_ERROR_NONE != pJvmtiEnv->CreateRawMonitor("CodeXL JIT event writer", &gWriteMonitor) ||
+        JVMTI_ERROR_NONE != pJvmtiEnv->CreateRawMonitor("CodeXL JIT agent thread", &gAgentMonitor))
+    {
+        return false;
+    }
+
+    wchar_t codeLogFile[OS_MAX_PATH] = { L'\0' };
+    swprintf(codeLogFile, OS_MAX_PATH - 1, WIDE_STR_FORMAT L"/%d" JIT_CODE_LOG_EXTENSION, profileDataDir.c_str(), gJvmPID);
+
+    gJitCodeLog = new JitCodeLogWriter(codeLogFile, gJvmPID);
+
+    if (!gJitCodeLog->Initialize())
+    {
+        delete gJitCodeLog;
+        gJitCodeLog = nullptr;
+        return false;
+    }
+
+    gAsyncMode.store(true);
+    return true;
+} // InitializeAsyncMode
+
+
+bool IsAsyncModeEnabled()
+{
+    return gAsyncMode.load(std::memory_order_relaxed);
+} // IsAsyncModeEnabled
+
+
+// StartAsyncMode
+//
+// Starts the agent thread; until it runs the events stay in the ring.
+//
+void StartAsyncMode(jvmtiEnv* pJvmtiEnv, JNIEnv* pJniEnv)
+{
+    jthread thread = nullptr;
+    jclass threadClass = pJniEnv->FindClass("java/lang/Thread");
+
+    if (nullptr != threadClass)
+    {
+        jmethodID threadCtor = pJniEnv->GetMethodID(threadClass, "<init>", "(Ljava/lang/String;)V");
+        jstring threadName = pJniEnv->NewStringUTF("CodeXL JIT Writer");
+
+        if (nullptr != threadCtor && nullptr != threadName)
+        {
+            thread = pJniEnv->NewObject(threadClass, threadCtor, threadName);
+        }
+    }
+
+    if (nullptr == thread)
+    {
+        pJniEnv->ExceptionClear();
+        fprintf(stderr, "JVMTIProfileAgent: could not create the agent thread, the JIT events are written by the JVM threads\n");
+        return;
+    }
+
+    pJvmtiEnv->RawMonitorEnter(gAgentMonitor);
+
+    bool isRunning = (JVMTI_ERROR_NONE == pJvmtiEnv->RunAgentThread(thread, &asyncAgentThread, nullptr, JVMTI_THREAD_NORM_PRIORITY));
+    gAgentThreadRunning.store(isRunning);
+
+    pJvmtiEnv->RawMonitorExit(gAgentMonitor);
+
+    if (!isRunning)
+    {
+        fprintf(stderr, "JVMTIProfileAgent: could not run the agent thread, the JIT events are written by the JVM threads\n");
+    }
+} // StartAsyncMode
+
+
+// StopAsyncMode
+//
+void StopAsyncMode(jvmtiEnv* pJvmtiEnv)
+{
+    pJvmtiEnv->RawMonitorEnter(gAgentMonitor);
+
+    gAgentStopRequested = true;
+    pJvmtiEnv->RawMonitorNotifyAll(gAgentMonitor);
+
+    while (gAgentThreadRunning)
+    {
+        pJvmtiEnv->RawMonitorWait(gAgentMonitor, 0);
+    }
+
+    pJvmtiEnv->RawMonitorExit(gAgentMonitor);
+
+    // The events queued while the agent thread was not running
+    writeQueuedEvents(pJvmtiEnv);
+
+    if (gJvmtiVerbose)
+    {
+        fprintf(stderr, "JVMTIProfileAgent: %u JIT events queued, ring full %u times\n",
+                gQueuedEvents.load(), gRingFullCount.load());
+        fprintf(stderr, "JVMTIProfileAgent: %u records in the code log, %llu bytes\n",
+                gJitCodeLog->GetRecordCount(), static_cast<unsigned long long>(gJitCodeLog->GetSize()));
+    }
+} // StopAsyncMode
+
+
+// QueueCompiledMethodLoad
+//
+// Resolves the names and builds the JNC sections of the method while its class is known to be loaded,
+// and copies the code, which is only valid during the callback.
+//
+bool QueueCompiledMethodLoad(jvmtiEnv*                    pJvmtiEnv,
+                             jmethodID                    method,
+                             jint                         codeSize,
+                             const void*                  codeAddr,
+                             jint                         mapLength,
+                             const jvmtiAddrLocationMap*  map,
+                             const void*                  compileInfo,
+                             gtUInt64                     loadTimeStamp)
+{
+    if (nullptr == codeAddr || 0 >= codeSize)
+    {
+        return false;
+    }
+
+    JncSectionBlobs sections;
+
+    if (!BuildJncSectionBlobs(pJvmtiEnv, method, codeSize, codeAddr, mapLength, map, compileInfo, sections))
+    {
+        fprintf(stderr, "Invalid JVMTI_CMLR record type\n");
+        return true;
+    }
+
+    char className[OS_MAX_PATH] = {0};
+    char methodName[OS_MAX_PATH] = {0};
+    char srcFile[OS_MAX_PATH] = {0};
+
+    GetMethodNames(pJvmtiEnv, method, className, methodName, srcFile);
+
+    size_t classNameSize = strlen(className) + 1;
+    size_t methodNameSize = strlen(methodName) + 1;
+    size_t srcFileSize = strlen(srcFile) + 1;
+
+    JitEvent* pEvent = allocateEvent(JIT_EVENT_METHOD_LOAD, loadTimeStamp, codeAddr, codeSize,
+                                     codeSize + classNameSize + methodNameSize + srcFileSize);
+
+    if (nullptr == pEvent)
+    {
+        FreeJncSectionBlobs(sections);
+        return false;
+    }
+
+    char* pData = reinterpret_cast<char*>(pEvent) + ASYNC_EVENT_ALIGN(sizeof(JitEvent));
+
+    memcpy(pData, codeAddr, codeSize);
+    pEvent->pCode = pData;
+    pData += codeSize;
+
+    pEvent->mInfo.pClassSig = static_cast<char*>(memcpy(pData, className, classNameSize));
+    pData += classNameSize;
+
+    pEvent->mInfo.pMethodName = static_cast<char*>(memcpy(pData, methodName, methodNameSize));
+    pData += methodNameSize;
+
+    pEvent->mInfo.pSrcFile = static_cast<char*>(memcpy(pData, srcFile, srcFileSize));
+
+    pEvent->sections = sections;
+
+    queueEvent(pJvmtiEnv, pEvent);
+    return true;
+} // QueueCompiledMethodLoad
+
+
+// QueueCompiledMethodUnload
+//
+// The unload events wait for room in the ring like the loads, since a dropped unload would leave
+// the code range of the method valid, to be attributed to later code at the same addresses.
+//
+bool QueueCompiledMethodUnload(jvmtiEnv* pJvmtiEnv, const void* codeAddr, gtUInt64 unloadTimeStamp)
+{
+    JitEvent* pEvent = allocateEvent(JIT_EVENT_METHOD_UNLOAD, unloadTimeStamp, codeAddr, 0, 0);
+
+    if (nullptr == pEvent)
+    {
+        return false;
+    }
+
+    queueEvent(pJvmtiEnv, pEvent);
+    return true;
+} // QueueCompiledMethodUnload
+
+
+// QueueDynamicCode
+//
+bool QueueDynamicCode(jvmtiEnv* pJvmtiEnv, const char* name, const void* codeAddr, jint codeSize, gtUInt64 loadTimeStamp)
+{
+    if (nullptr == name || nullptr == codeAddr || 0 >= codeSize)
+    {
+        return false;
+    }
+
+    size_t nameSize = strlen(name) + 1;
+
+    JitEvent* pEvent = allocateEvent(JIT_EVENT_DYNAMIC_CODE, loadTimeStamp, codeAddr, codeSize, codeSize + nameSize);
+
+    if (nullptr == pEvent)
+    {
+        return false;
+    }
+
+    char* pData = reinterpret_cast<char*>(pEvent) + ASYNC_EVENT_ALIGN(sizeof(JitEvent));
+
+    memcpy(pData, codeAddr, codeSize);
+    pEvent->pCode = pData;
+
+    memcpy(pData + codeSize, name, nameSize);
+    pEvent->name = pData + codeSize;
+
+    queueEvent(pJvmtiEnv, pEvent);
+    return true;
+} // QueueDynamicCode
@@ -585,6 +585,135 @@ static int WriteJNC(std::wstring* jncFileName,
 } // WriteJNC
 
 
+// The .pc2bc, .stringtable and .bc2src sections of the JNC file of a compiled method
+struct JncSections
+{
+    std::vector<void*>  globalAddressRanges;
+    std::vector<void*>  lineNumberTables;
+    void*               lineInfoBlob;
+    jint                lineInfoBlobSize;
+    void*               methodTableBlob;
+    jint                methodTableBlobSize;
+    void*               stringTableBlob;
+    jint                stringTableSize;
+
+    JncSections() : lineInfoBlob(NULL), lineInfoBlobSize(0),
+        methodTableBlob(NULL), methodTableBlobSize(0),
+        stringTableBlob(NULL), stringTableSize(0)
+    {
+    }
+};
+
+
+// BuildJncSections
+//
+static void BuildJncSections(jvmtiEnv*                             pJvmtiEnv,
+                             jmethodID                             method,
+                             jint                                  codeSize,
+                             const void*                           codeAddr,
+                             jint                                  mapLength,
+                             const jvmtiAddrLocationMap*           map,
+                             jvmtiCompiledMethodLoadInlineRecord*  inlineRec,
+                             JncSections&                          sections)
+{
+    // We need to create the following sections
+    //     - .string_table
+    //     - .bc2src
+    //     - .pc2bc
+
+    // Build Sections
+    jint bytecodeToSourceTableSize = 0;
+
+    if (NULL == inlineRec)
+    {
+        insertAddressRange(method,
+                           codeAddr,
+                           codeSize,
+                           sections.globalAddressRanges,
+                           bytecodeToSourceTableSize);
+    }
+    else
+    {
+        // Build the table to map the inlined method id's to PC address ranges
+        BuildInlineAddressRanges(inlineRec,
+                                 sections.globalAddressRanges,
+                                 bytecodeToSourceTableSize,
+                                 codeAddr,
+                                 codeSize);
+    }
+
+    std::vector<void*>  stringTable;
+    std::vector<jint>   lineNumberTableEntryCounts;
+    jint                lineNumberTableSize = 0;
+
+    buildBytecodeToSourceTable(pJvmtiEnv,
+                               sections.globalAddressRanges,
+                               stringTable,
+                               sections.stringTableSize,
+                               sections.lineNumberTables,
+                               lineNumberTableSize,
+                               lineNumberTableEntryCounts);
+
+    // Create Blobs
+    createStringTableBlob(stringTable,
+                          sections.stringTableSize,
+                          sections.stringTableBlob);
+
+    createMethodTableBlob(pJvmtiEnv,
+                          sections.globalAddressRanges,
+                          bytecodeToSourceTableSize,
+                          sections.lineNumberTables,
+                          lineNumberTableSize,
+                          lineNumberTableEntryCounts,
+                          sections.methodTableBlob,
+                          sections.methodTableBlobSize);
+
+    if (NULL == inlineRec)
+    {
+        createJNCMethodLoadLineInfoBlob(pJvmtiEnv,
+                                        &method,
+                                        map,
+                                        mapLength,
+                                        sections.lineInfoBlob,
+                                        sections.lineInfoBlobSize);
+    }
+    else
+    {
+        sections.lineInfoBlobSize = computeInlineInfoSize(inlineRec);
+        sections.lineInfoBlobSize = CreateInlineDataBlob(inlineRec,
+                                                         sections.lineInfoBlobSize,
+                                                         sections.lineInfoBlob);
+    }
+} // BuildJncSections
+
+
+// FreeJncSections
+//
+static void FreeJncSections(jvmtiEnv* pJvmtiEnv, JncSections& sections)
+{
+    // Free the allocated memory
+    if (NULL != sections.lineInfoBlob)
+    {
+        free(sections.lineInfoBlob);
+        sections.lineInfoBlob = NULL;
+    }
+
+    if (NULL != sections.methodTableBlob)
+    {
+        free(sections.methodTableBlob);
+        sections.methodTableBlob = NULL;
+    }
+
+    if (NULL != sections.stringTableBlob)
+    {
+        free(sections.stringTableBlob);
+        sections.stringTableBlob = NULL;
+    }
+
+    freeMethodTables(pJvmtiEnv, sections.globalAddressRanges, sections.lineNumberTables);
+} // FreeJncSections
+
+
 // WriteJncFile
 //
 void JNICALL WriteJncFile(jvmtiEnv*                    pJvmtiEnv,
@@ -607,7 +736,6 @@ void JNICALL WriteJncFile(jvmtiEnv*                    pJvmtiEnv,
     bool hasInlineInfo = false;
     jvmtiCompiledMethodLoadRecordHeader*  methodLoadRec =
         (jvmtiCompiledMethodLoadRecordHeader*)compileInfo;
-    jvmtiCompiledMethodLoadInlineRecord* inlineRec = NULL;
 
     if (NULL != methodLoadRec)
     {
@@ -679,120 +807,93 @@ void JNICALL WriteJncFile(jvmtiEnv*                    pJvmtiEnv,
 
     } // gJvmtiVerbose
 
-    // We need to create the following sections
-    //     - .string_table
-    //     - .bc2src
-    //     - .pc2bc
-
-    // Build Sections
-    std::vector<void*>  globalAddressRanges;
-    jint           bytecodeToSourceTableSize = 0;
+    JncSections sections;
 
-    if (! hasInlineInfo)
-    {
-        insertAddressRange(method,
-                           codeAddr,
-                           codeSize,
-                           globalAddressRanges,
-                           bytecodeToSourceTableSize);
-    }
-    else
-    {
-        // Build the table to map the inlined method id's to PC address ranges
-        inlineRec = (jvmtiCompiledMethodLoadInlineRecord*)compileInfo;
-
-        BuildInlineAddressRanges(inlineRec,
-                                 globalAddressRanges,
-                                 bytecodeToSourceTableSize,
-                                 codeAddr,
-                                 codeSize);
-    }
-
-    std::vector<void*>  stringTable;
-    std::vector<void*>  lineNumberTables;
-    std::vector<jint>   lineNumberTableEntryCounts;
-    jint           stringTableSize = 0;
-    jint           lineNumberTableSize = 0;
-
-    buildBytecodeToSourceTable(pJvmtiEnv,
-                               globalAddressRanges,
-                               stringTable,
-                               stringTableSize,
-                               lineNumberTables,
-                               lineNumberTableSize,
-                               lineNumberTableEntryCounts);
-
-    // Create Blobs
-    void* stringTableBlob;
-    createStringTableBlob(stringTable,
-                          stringTableSize,
-                          stringTableBlob);
-
-    void*  methodTableBlob = NULL;
-    jint   methodTableBlobSize = 0;
-
-    createMethodTableBlob(pJvmtiEnv,
-                          globalAddressRanges,
-                          bytecodeToSourceTableSize,
-                          lineNumberTables,
-                          lineNumberTableSize,
-                          lineNumberTableEntryCounts,
-                          methodTableBlob,
-                          methodTableBlobSize);
-
-    void*  lineInfoBlob = NULL;
-    jint   lineInfoBlobSize;
-
-    if (! hasInlineInfo)
-    {
-        createJNCMethodLoadLineInfoBlob(pJvmtiEnv,
-                                        &method,
-                                        map,
-                                        mapLength,
-                                        lineInfoBlob,
-                                        lineInfoBlobSize);
-    }
-    else
-    {
-        lineInfoBlobSize = computeInlineInfoSize(inlineRec);
-        lineInfoBlobSize = CreateInlineDataBlob(inlineRec,
-                                                lineInfoBlobSize,
-                                                lineInfoBlob);
-    }
+    BuildJncSections(pJvmtiEnv,
+                     method,
+                     codeSize,
+                     codeAddr,
+                     mapLength,
+                     map,
+                     hasInlineInfo ? (jvmtiCompiledMethodLoadInlineRecord*)compileInfo : NULL,
+                     sections);
 
     // Write JNC file
     WriteJNC(jncFileName,
              strName.c_str(),
              codeAddr,
              codeSize,
-             lineInfoBlob,
-             lineInfoBlobSize,
-             methodTableBlob,
-             methodTableBlobSize,
-             stringTableBlob,
-             stringTableSize);
+             sections.lineInfoBlob,
+             sections.lineInfoBlobSize,
+             sections.methodTableBlob,
+             sections.methodTableBlobSize,
+             sections.stringTableBlob,
+             sections.stringTableSize);
+
+    FreeJncSections(pJvmtiEnv, sections);
+} // WriteJncFile
 
-    // Free the allocated memory
-    if (NULL != lineInfoBlob)
-    {
-        free(lineInfoBlob);
-        lineInfoBlob = NULL;
-    }
 
-    if (NULL != methodTableBlob)
-    {
-        free(methodTableBlob);
-        methodTableBlob = NULL;
-    }
+// BuildJncSectionBlobs
+//
+// The blobs are owned by the caller, to be freed by FreeJncSectionBlobs.
+//
+bool BuildJncSectionBlobs(jvmtiEnv*                    pJvmtiEnv,
+                          jmethodID                    method,
+                          jint                         codeSize,
+                          const void*                  codeAddr,
+                          jint                         mapLength,
+                          const jvmtiAddrLocationMap*  map,
+                          const void*                  compileInfo,
+                          JncSectionBlobs&             blobs)
+{
+    jvmtiCompiledMethodLoadRecordHeader* methodLoadRec = (jvmtiCompiledMethodLoadRecordHeader*)compileInfo;
 
-    if (NULL != stringTableBlob)
+    if (NULL != methodLoadRec && JVMTI_CMLR_INLINE_INFO != methodLoadRec->kind)
     {
-        free(stringTableBlob);
-        stringTableBlob = NULL;
+        return false;
     }
 
-    freeMethodTables(pJvmtiEnv, globalAddressRanges, lineNumberTables);
-} // WriteJncFile
+    JncSections sections;
+
+    BuildJncSections(pJvmtiEnv,
+                     method,
+                     codeSize,
+                     codeAddr,
+                     mapLength,
+                     map,
+                     (jvmtiCompiledMethodLoadInlineRecord*)methodLoadRec,
+                     sections);
+
+    blobs.lineInfoBlob        = sections.lineInfoBlob;
+    blobs.lineInfoBlobSize    = sections.lineInfoBlobSize;
+    blobs.methodTableBlob     = sections.methodTableBlob;
+    blobs.methodTableBlobSize = sections.methodTableBlobSize;
+    blobs.stringTableBlob     = sections.stringTableBlob;
+    blobs.stringTableSize     = sections.stringTableSize;
+
+    // Only the method tables, which hold the line number tables allocated by the JVM, are freed here
+    sections.lineInfoBlob    = NULL;
+    sections.methodTableBlob = NULL;
+    sections.stringTableBlob = NULL;
+
+    FreeJncSections(pJvmtiEnv, sections);
+    return true;
+} // BuildJncSectionBlobs
+
+
+// FreeJncSectionBlobs
+//
+void FreeJncSectionBlobs(JncSectionBlobs& blobs)
+{
+    free(blobs.lineInfoBlob);
+    free(blobs.methodTableBlob);
+    free(blobs.stringTableBlob);
+
+    blobs.lineInfoBlob    = NULL;
+    blobs.methodTableBlob = NULL;
+    blobs.stringTableBlob = NULL;
+} // FreeJncSectionBlobs
 
 
 // WriteNativeToJncFile
@@ -0,0 +1,128 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file JitCodeLog.h
+/// \brief This file contains an interface to write and read the JIT code log file for Java code profiling.
+///
+//==================================================================================
+
+#ifndef _JITCODELOG_H_
+#define _JITCODELOG_H_
+
+#include <vector>
+#include <string>
+#include "ProfilingAgentsDataDLLBuild.h"
+#include <AMDTOSWrappers/Include/osOSDefinitions.h>
+#include <ProfilingAgents/Utils/CrtFile.h>
+
+//
+// The JIT code log holds the native code of all the methods compiled by a JVM, appended one record
+// after the other to a single file, instead of writing one JNC file per method. The jncFileName of
+// the JCL load records references the log file and the offset of the method's record in it:
+//
+//     <log file path>#<record offset in hex>
+//
+// At translation, the code log is moved to the session directory as is, and JavaJncReader reads
+// the records of the used methods in place.
+//
+
+//
+//    Macros
+//
+#define JIT_CODE_LOG_SIGNATURE          "_AMDCODEXL_JCD_"
+#define JIT_CODE_LOG_EXTENSION          L".jcode"
+#define JIT_CODE_LOG_REFERENCE_MARK     L'#'
+
+//
+//   Globals
+//
+const unsigned int JIT_CODE_LOG_VERSION = 0x01;
+
+// JitCodeLogHeader
+// The header of the JIT code log file:
+//
+struct JitCodeLogHeader
+{
+    char     signature[16]; // this always be _AMDCODEXL_JCD_
+    gtUInt32 version;
+    gtInt32  processID;
+};
+
+// JitCodeLogRecord
+// The header of a method's record. It is followed by the symbol name (null terminated),
+// the code bytes and the .pc2bc, .stringtable and .bc2src sections of the JNC file.
+//
+struct JitCodeLogRecord
+{
+    gtUInt32 recordSize;        // including this header
+    gtUInt32 symbolNameSize;    // including the terminating null
+    gtUInt64 codeAddr;
+    gtUInt32 codeSize;
+    gtUInt32 pc2bcSize;
+    gtUInt32 stringTableSize;
+    gtUInt32 bc2srcSize;
+};
+
+
+// Appends the method records to the JIT code log. Not thread safe, the caller serializes the appends.
+class AGENTDATA_API JitCodeLogWriter
+{
+public:
+    JitCodeLogWriter(const wchar_t* pLogName, int pid);
+    ~JitCodeLogWriter();
+
+    bool Initialize();
+
+    // The record is written unbuffered, so it is complete in the file before the JCL load record
+    // referencing it is written.
+    bool AppendRecord(const char*   pSymbolName,
+                      gtUInt64      codeAddr,
+                      const void*   pCode,
+                      unsigned int  codeSize,
+                      const void*   pc2bcBlob,
+                      unsigned int  pc2bcBlobSize,
+                      const void*   stringTableBlob,
+                      unsigned int  stringTableBlobSize,
+                      const void*   methodTableBlob,
+                      unsigned int  methodTableBlobSize,
+                      gtUInt64&     recordOffset);
+
+    // Builds the jncFileName of the JCL load record of a method
+    void FormatReference(gtUInt64 recordOffset, wchar_t* pReference, size_t size) const;
+
+    const wchar_t* GetFileName() const { return m_fileName; }
+    gtUInt64 GetSize() const { return m_offset; }
+    unsigned int GetRecordCount() const { return m_recordCount; }
+
+protected:
+    int           m_fd;
+    int           m_pid;
+    gtUInt64      m_offset;
+    unsigned int  m_recordCount;
+    wchar_t       m_fileName[OS_MAX_PATH];
+};
+
+
+class AGENTDATA_API JitCodeLogReader
+{
+public:
+    JitCodeLogReader(const wchar_t* pLogName);
+    ~JitCodeLogReader();
+
+    bool Open();
+    void Close();
+
+    // Reads the method record at the given offset. The data holds the symbol name, the code bytes
+    // and the sections, as described by the record header.
+    bool ReadRecord(gtUInt64 recordOffset, JitCodeLogRecord& record, std::vector<gtUByte>& data);
+
+    // Splits the jncFileName of a JCL load record, returns false if it is a regular JNC file
+    static bool ParseReference(const wchar_t* pReference, std::wstring& logName, gtUInt64& recordOffset);
+
+protected:
+    CrtFile               m_fileStream;
+    wchar_t               m_fileName[OS_MAX_PATH];
+};
+
+#endif // _JITCODELOG_H_
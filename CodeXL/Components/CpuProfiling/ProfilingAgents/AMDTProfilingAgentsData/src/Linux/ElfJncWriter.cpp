@@ -226,14 +226,20 @@ int ElfJncWriter::ElfUpdate()
 
 
 int ElfJncWriter::init(const char* jncFile, const char* pJittedCodeSymbolName, const void* pJittedCodeAddr, unsigned int jittedCodeSize)
+{
+    return init(jncFile, pJittedCodeSymbolName, pJittedCodeAddr, (gtUInt64)pJittedCodeAddr, jittedCodeSize);
+}
+
+
+int ElfJncWriter::init(const char* jncFile, const char* pJittedCodeSymbolName, const void* pJittedCode, gtUInt64 jittedCodeAddr, unsigned int jittedCodeSize)
 {
     (void)(pJittedCodeSymbolName); // unused
     int  ret = -1;
     bool rv  = false;
 
-    if (regit_map.end() == regit_map.find((gtUInt64)pJittedCodeAddr))
+    if (regit_map.end() == regit_map.find(jittedCodeAddr))
     {
-        regit_map[(gtUInt64)pJittedCodeAddr] = 0;
+        regit_map[jittedCodeAddr] = 0;
     }
 
     rv = ElfCreate(jncFile);
@@ -245,12 +251,12 @@ int ElfJncWriter::init(const char* jncFile, const char* pJittedCodeSymbolName, c
 
     // add the code section
     ret = addSection((const char*)".text",
-                     pJittedCodeAddr,
+                     pJittedCode,
                      jittedCodeSize,
-                     (gtUInt64)pJittedCodeAddr,
+                     jittedCodeAddr,
                      true);
 
-    ++regit_map[(gtUInt64)pJittedCodeAddr];
+    ++regit_map[jittedCodeAddr];
 
     return ret;
 }
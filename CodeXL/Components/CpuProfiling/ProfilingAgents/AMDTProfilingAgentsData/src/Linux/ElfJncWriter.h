@@ -24,6 +24,9 @@ public:
 
     int init(const char* jncFile, const char* pJittedCodeSymbolName, const void* pJittedCodeAddr, unsigned int jittedCodeSize);
 
+    // The code bytes are a copy of the JIT'ed code, which was located at jittedCodeAddr
+    int init(const char* jncFile, const char* pJittedCodeSymbolName, const void* pJittedCode, gtUInt64 jittedCodeAddr, unsigned int jittedCodeSize);
+
     int addSection(const char* name, const void* data, unsigned int size, gtUInt64 vma, bool isProgbits);
 
     int write();
@@ -12,6 +12,7 @@
 #include <AMDTBaseTools/Include/gtAlgorithms.h>
 #include <AMDTOSWrappers/Include/osDebugLog.h>
 #include <JvmsParser.h>
+#include <AMDTProfilingAgentsData/inc/JitCodeLog.h>
 #include "JavaJncReader_Lin.h"
 
 static int gJncReaderVerbose = 0;
@@ -69,6 +70,8 @@ JavaJncReader::Close()
 
     _freePcStackInfo();
     Clear();
+
+    m_codeLogRecord.clear();
 }
 
 
@@ -87,7 +90,6 @@ JavaJncReader::_freePcStackInfo()
 
 bool JavaJncReader::Open(const wchar_t* pWFileName)
 {
-    JncPcStackInfoMap::iterator it;
     char fileName[261];
 
     memset(fileName, 0, sizeof(fileName));
@@ -97,6 +99,15 @@ bool JavaJncReader::Open(const wchar_t* pWFileName)
         return false;
     }
 
+    // The methods written by the agent in the asynchronous mode are records of a JIT code log
+    std::wstring codeLogName;
+    gtUInt64 recordOffset = 0;
+
+    if (JitCodeLogReader::ParseReference(pWFileName, codeLogName, recordOffset))
+    {
+        return Open(codeLogName.c_str(), recordOffset);
+    }
+
     wcstombs(fileName, pWFileName, 260);
 
     ExecutableFile* pExecutable = ExecutableFile::Open(pWFileName);
@@ -124,63 +135,112 @@ bool JavaJncReader::Open(const wchar_t* pWFileName)
         return false;
     }
 
-    // Get the .stringtable
     m_string_table_buf = pExecutable->GetSectionBytes(pExecutable->LookupSectionIndex(".stringtable"));
+    m_pBc2srcBuf = pExecutable->GetSectionBytes(pExecutable->LookupSectionIndex(".bc2src"));
+    m_pPc2bcBuf = pExecutable->GetSectionBytes(pExecutable->LookupSectionIndex(".pc2bc"));
+
+    if (!_process_sections(fileName))
+    {
+        delete pExecutable;
+        return false;
+    }
+
+    m_pExecutable = pExecutable;
+    return true;
+}
+
+
+bool JavaJncReader::Open(const wchar_t* pCodeLogName, gtUInt64 recordOffset)
+{
+    char fileName[261];
+
+    memset(fileName, 0, sizeof(fileName));
+
+    if (nullptr == pCodeLogName)
+    {
+        return false;
+    }
+
+    wcstombs(fileName, pCodeLogName, 260);
+
+    JitCodeLogReader codeLog(pCodeLogName);
+    JitCodeLogRecord record;
+
+    if (!codeLog.Open() || !codeLog.ReadRecord(recordOffset, record, m_codeLogRecord))
+    {
+        m_codeLogRecord.clear();
+        return false;
+    }
+
+    // The record holds the symbol name, the code and the same sections as a JNC file
+    const gtUByte* pData = &m_codeLogRecord[0] + record.symbolNameSize;
+
+    m_pCodeBuf   = pData;
+    m_loadAddr   = record.codeAddr;
+    m_textOffset = 0;
+    m_textSize   = record.codeSize;
+    pData += record.codeSize;
+
+    m_pPc2bcBuf = (0U != record.pc2bcSize) ? pData : nullptr;
+    pData += record.pc2bcSize;
+
+    m_string_table_buf = (0U != record.stringTableSize) ? pData : nullptr;
+    pData += record.stringTableSize;
+
+    m_pBc2srcBuf = (0U != record.bc2srcSize) ? pData : nullptr;
+
+    if (!_process_sections(fileName))
+    {
+        m_codeLogRecord.clear();
+        return false;
+    }
+
+    return true;
+}
+
+
+// Processes the .stringtable, .bc2src and .pc2bc sections, and identifies the main method
+bool JavaJncReader::_process_sections(const char* pFileName)
+{
+    JncPcStackInfoMap::iterator it;
 
     if (nullptr == m_string_table_buf)
     {
         // JNC Files for Native methods won't have stringtable, bc2src and pc2bc sections..
-        m_pExecutable = pExecutable;
         return true;
     }
 
     if (!_process_stringtable_section())
     {
-        delete pExecutable;
-        m_pExecutable = nullptr;
         return false;
     }
 
     // Process .bc2src
-    m_pBc2srcBuf = pExecutable->GetSectionBytes(pExecutable->LookupSectionIndex(".bc2src"));
-
     if (nullptr == m_pBc2srcBuf)
     {
-        delete pExecutable;
-        m_pExecutable = nullptr;
         return false;
     }
 
     if (!_process_bc2src_section())
     {
-        delete pExecutable;
-        m_pExecutable = nullptr;
         return false;
     }
 
     // Process the .pc2bc
-    m_pPc2bcBuf = pExecutable->GetSectionBytes(pExecutable->LookupSectionIndex(".pc2bc"));
-
     if (nullptr == m_pPc2bcBuf)
     {
-        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"Warning: file %hs does not have pc-to-byte code information", fileName);
-        delete pExecutable;
-        m_pExecutable = nullptr;
+        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"Warning: file %hs does not have pc-to-byte code information", pFileName);
         return false;
     }
 
     if (!_process_pc2bc_section())
     {
-        delete pExecutable;
-        m_pExecutable = nullptr;
         return false;
     }
 
     // Setup inline information map
     if (!_process_inline_map())
     {
-        delete pExecutable;
-        m_pExecutable = nullptr;
         return false;
     }
 
@@ -218,7 +278,6 @@ bool JavaJncReader::Open(const wchar_t* pWFileName)
         }
     }
 
-    m_pExecutable = pExecutable;
     return true;
 }
 
@@ -77,6 +77,10 @@ public:
     virtual ~JavaJncReader();
 
     bool Open(const wchar_t* pFileName);
+
+    // Reads the method record at the given offset of a JIT code log, instead of a JNC file.
+    // Open(pFileName) also accepts the "<log>#<offset>" references of the JCL load records.
+    bool Open(const wchar_t* pCodeLogName, gtUInt64 recordOffset);
     void Close();
     void Clear();
     bool GetStringFromOffset(unsigned int offset, std::string& str);
@@ -153,6 +157,7 @@ public:
     const gtUByte* GetCodeBytesOfTextSection(unsigned int* pCodeSize);
 
 private:
+    bool _process_sections(const char* pFileName);
     bool _process_stringtable_section();
     bool _process_bc2src_section();
     bool _process_pc2bc_section();
@@ -174,6 +179,9 @@ private:
     ExecutableFile* m_pExecutable;
     unsigned int m_sectionCounts;
 
+    // The method record, when read from a JIT code log
+    std::vector<gtUByte> m_codeLogRecord;
+
     unsigned int m_string_table_size;
     const gtUByte*  m_string_table_buf;
 
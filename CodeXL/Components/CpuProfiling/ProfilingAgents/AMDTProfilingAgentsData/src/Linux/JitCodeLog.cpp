@@ -0,0 +1,274 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file JitCodeLog.cpp
+/// \brief Implements the JitCodeLogWriter and JitCodeLogReader classes.
+///
+//==================================================================================
+
+// System Headers
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <wchar.h>
+
+#include <AMDTProfilingAgentsData/inc/JitCodeLog.h>
+
+// A record larger than this is considered corrupted
+#define JIT_CODE_LOG_MAX_RECORD_SIZE    (256U * 1024U * 1024U)
+
+static bool WriteAll(int fd, struct iovec* pVec, int count);
+
+
+JitCodeLogWriter::JitCodeLogWriter(const wchar_t* pLogName, int pid) : m_fd(-1),
+                                                                       m_pid(pid),
+                                                                       m_offset(0ULL),
+                                                                       m_recordCount(0U)
+{
+    wcsncpy(m_fileName, pLogName, OS_MAX_PATH - 1);
+    m_fileName[OS_MAX_PATH - 1] = L'\0';
+}
+
+
+JitCodeLogWriter::~JitCodeLogWriter()
+{
+    if (-1 != m_fd)
+    {
+        close(m_fd);
+    }
+}
+
+
+bool JitCodeLogWriter::Initialize()
+{
+    char logName[OS_MAX_PATH] = { '\0' };
+    wcstombs(logName, m_fileName, OS_MAX_PATH - 1);
+
+    m_fd = open(logName, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0666);
+
+    if (-1 == m_fd)
+    {
+        return false;
+    }
+
+    JitCodeLogHeader header;
+    memset(&header, 0, sizeof(header));
+    snprintf(header.signature, 16, "%s", JIT_CODE_LOG_SIGNATURE);
+    header.version   = JIT_CODE_LOG_VERSION;
+    header.processID = m_pid;
+
+    struct iovec vec = { &header, sizeof(header) };
+
+    if (!WriteAll(m_fd, &vec, 1))
+    {
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    m_offset = sizeof(header);
+    return true;
+}
+
+
+bool JitCodeLogWriter::AppendRecord(const char*   pSymbolName,
+                                    gtUInt64      codeAddr,
+                                    const void*   pCode,
+                                    unsigned int  codeSize,
+                                    const void*   pc2bcBlob,
+                                    unsigned int  pc2bcBlobSize,
+                                    const void*   stringTableBlob,
+                                    unsigned int  stringTableBlobSize,
+                                    const void*   methodTableBlob,
+                                    unsigned int  methodTableBlobSize,
+                                    gtUInt64&     recordOffset)
+{
+    if (-1 == m_fd || NULL == pSymbolName || NULL == pCode || 0U == codeSize)
+    {
+        return false;
+    }
+
+    JitCodeLogRecord record;
+    record.symbolNameSize  = static_cast<gtUInt32>(strlen(pSymbolName) + 1);
+    record.codeAddr        = codeAddr;
+    record.codeSize        = codeSize;
+    record.pc2bcSize       = (NULL != pc2bcBlob) ? pc2bcBlobSize : 0U;
+    record.stringTableSize = (NULL != stringTableBlob) ? stringTableBlobSize : 0U;
+    record.bc2srcSize      = (NULL != methodTableBlob) ? methodTableBlobSize : 0U;
+    record.recordSize      = static_cast<gtUInt32>(sizeof(record)) + record.symbolNameSize + record.codeSize +
+                             record.pc2bcSize + record.stringTableSize + record.bc2srcSize;
+
+    struct iovec vec[6] =
+    {
+        { &record, sizeof(record) },
+        { const_cast<char*>(pSymbolName), record.symbolNameSize },
+        { const_cast<void*>(pCode), record.codeSize },
+        { const_cast<void*>(pc2bcBlob), record.pc2bcSize },
+        { const_cast<void*>(stringTableBlob), record.stringTableSize },
+        { const_cast<void*>(methodTableBlob), record.bc2srcSize }
+    };
+
+    if (!WriteAll(m_fd, vec, 6))
+    {
+        return false;
+    }
+
+    recordOffset = m_offset;
+    m_offset += record.recordSize;
+    m_recordCount++;
+    return true;
+}
+
+
+void JitCodeLogWriter::FormatReference(gtUInt64 recordOffset, wchar_t* pReference, size_t size) const
+{
+    swprintf(pReference, size, L"%S%lc%llx", m_fileName, JIT_CODE_LOG_REFERENCE_MARK, static_cast<unsigned long long>(recordOffset));
+}
+
+
+JitCodeLogReader::JitCodeLogReader(const wchar_t* pLogName)
+{
+    wcsncpy(m_fileName, pLogName, OS_MAX_PATH - 1);
+    m_fileName[OS_MAX_PATH - 1] = L'\0';
+}
+
+
+JitCodeLogReader::~JitCodeLogReader()
+{
+    Close();
+}
+
+
+void JitCodeLogReader::Close()
+{
+    if (m_fileStream.isOpened())
+    {
+        m_fileStream.close();
+    }
+}
+
+
+bool JitCodeLogReader::Open()
+{
+    if (!m_fileStream.open(m_fileName, "rb"))
+    {
+        return false;
+    }
+
+    JitCodeLogHeader header;
+    bool ret = m_fileStream.read(header) &&
+               0 == strncmp(header.signature, JIT_CODE_LOG_SIGNATURE, sizeof(header.signature)) &&
+               JIT_CODE_LOG_VERSION == header.version;
+
+    if (!ret)
+    {
+        Close();
+    }
+
+    return ret;
+}
+
+
+bool JitCodeLogReader::ReadRecord(gtUInt64 recordOffset, JitCodeLogRecord& record, std::vector<gtUByte>& data)
+{
+    if (!m_fileStream.isOpened() || !m_fileStream.seekCurrentPosition(CrtFile::ORIGIN_BEGIN, static_cast<long>(recordOffset)))
+    {
+        return false;
+    }
+
+    if (!m_fileStream.read(record))
+    {
+        return false;
+    }
+
+    gtUInt64 dataSize = static_cast<gtUInt64>(record.symbolNameSize) + record.codeSize +
+                        record.pc2bcSize + record.stringTableSize + record.bc2srcSize;
+
+    if (0U == record.symbolNameSize || 0U == record.codeSize || JIT_CODE_LOG_MAX_RECORD_SIZE < record.recordSize ||
+        (sizeof(record) + dataSize) != record.recordSize)
+    {
+        return false;
+    }
+
+    data.resize(static_cast<size_t>(dataSize));
+
+    if (!m_fileStream.read(&data[0], data.size()))
+    {
+        return false;
+    }
+
+    // The symbol name is null terminated
+    return '\0' == data[record.symbolNameSize - 1];
+}
+
+
+bool JitCodeLogReader::ParseReference(const wchar_t* pReference, std::wstring& logName, gtUInt64& recordOffset)
+{
+    const wchar_t* pMark = wcsrchr(pReference, JIT_CODE_LOG_REFERENCE_MARK);
+
+    if (NULL == pMark || L'\0' == pMark[1])
+    {
+        return false;
+    }
+
+    wchar_t* pEnd = NULL;
+    unsigned long long offset = wcstoull(pMark + 1, &pEnd, 16);
+
+    if (L'\0' != *pEnd)
+    {
+        return false;
+    }
+
+    logName.assign(pReference, pMark - pReference);
+    recordOffset = static_cast<gtUInt64>(offset);
+    return true;
+}
+
+
+static bool WriteAll(int fd, struct iovec* pVec, int count)
+{
+    // Skip the empty sections
+    while (0 < count && 0 == pVec->iov_len)
+    {
+        pVec++;
+        count--;
+    }
+
+    while (0 < count)
+    {
+        ssize_t written = writev(fd, pVec, count);
+
+        if (-1 == written)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            return false;
+        }
+
+        // Partial write, continue from where it stopped
+        while (0 < count && static_cast<size_t>(written) >= pVec->iov_len)
+        {
+            written -= pVec->iov_len;
+            pVec++;
+            count--;
+        }
+
+        if (0 < count)
+        {
+            pVec->iov_base = static_cast<char*>(pVec->iov_base) + written;
+            pVec->iov_len -= written;
+        }
+    }
+
+    return true;
+}
@@ -57,7 +57,8 @@ public:
     bool InsertFunctionInfo(const CPAFunctionInfoList& funcList);
 
     bool InsertSamples(const gtVector<AMDTProfileTimelineSample*>& ppSamples);
-    bool InsertSamples(const CPASampeInfoList& sampleList);
+    // isNewContexts tells that the sample contexts are most likely not in the DB yet
+    bool InsertSamples(const CPASampeInfoList& sampleList, bool isNewContexts = false);
 
     bool InsertCallStackFrames(const CPACallStackFrameInfoList& csFrameInfoList);
     bool InsertCallStackLeafs(const CPACallStackLeafInfoList& csLeafInfoList);
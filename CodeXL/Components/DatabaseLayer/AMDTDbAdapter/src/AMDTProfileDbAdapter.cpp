@@ -311,7 +311,7 @@ bool amdtProfileDbAdapter::InsertFunctionInfo(const CPAFunctionInfoList& funcLis
     return ret;
 }
 
-bool amdtProfileDbAdapter::InsertSamples(const CPASampeInfoList& sampleList)
+bool amdtProfileDbAdapter::InsertSamples(const CPASampeInfoList& sampleList, bool isNewContexts)
 {
     bool ret = false;
 
@@ -326,7 +326,7 @@ bool amdtProfileDbAdapter::InsertSamples(const CPASampeInfoList& sampleList)
         sampleData.m_offset = it.m_offset;
         sampleData.m_count = it.m_count;
 
-        ret = m_pDbAccessor->InsertSamples(sampleData);
+        ret = m_pDbAccessor->InsertSamples(sampleData, isNewContexts);
     }
 
     m_pDbAccessor->FlushData();
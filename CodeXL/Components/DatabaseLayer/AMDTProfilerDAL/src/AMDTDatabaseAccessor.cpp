@@ -7,6 +7,10 @@
 //==================================================================================
 
 // C++.
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <string>
 #include <sstream>
 
@@ -20,7 +24,9 @@
 #include <AMDTBaseTools/Include/gtSet.h>
 #include <AMDTOSWrappers/Include/osDebugLog.h>
 #include <AMDTOSWrappers/Include/osTimeInterval.h>
+#include <AMDTOSWrappers/Include/osStopWatch.h>
 #include <AMDTOSWrappers/Include/osFilePath.h>
+#include <AMDTOSWrappers/Include/osProcess.h>
 
 // sqlite.
 #include <sqlite3.h>
@@ -68,7 +74,7 @@
 #define CXL_CLU_EVENT_CLU_PERCENTAGE        0xFF00UL
 #define CXL_CLU_EVENT_L1_EVICTIONS          0xFF04UL
 
-// Create the callstack indices after inserting all the rows
+// Create the secondary and callstack indices after inserting all the rows
 #define CXL_DB_CREATE_INDEX_AFTER_INSERT    1
 
 #ifdef PP_DAL_TEST
@@ -117,7 +123,12 @@ const std::vector<std::string> SQL_CREATE_DB_STMTS_TIMELINE =
     "CREATE TABLE samples (quantizedTimeMs INTEGER NOT NULL, counterId INTEGER NOT NULL, sampledValue REAL);",
     "CREATE INDEX sampleTimeIdx ON samples (quantizedTimeMs);",
     "CREATE INDEX sampleCounterIdx ON samples (counterId);",
-    "CREATE INDEX counterNameIdx ON counters (counterName);"
+    "CREATE INDEX counterNameIdx ON counters (counterName);",
+    "CREATE TABLE sampleBlocks (counterId INTEGER NOT NULL, blockIndex INTEGER NOT NULL, fromTimeMs INTEGER, toTimeMs INTEGER, numSamples INTEGER, numNullValues INTEGER, minValue REAL, maxValue REAL, sumValue REAL, timeData BLOB, valueData BLOB, PRIMARY KEY(counterId, blockIndex));",
+    "CREATE INDEX sampleBlockTimeIdx ON sampleBlocks (counterId, toTimeMs);",
+    "CREATE TABLE sampleSummaries (counterId INTEGER NOT NULL, level INTEGER NOT NULL, summaryIndex INTEGER NOT NULL, fromTimeMs INTEGER, toTimeMs INTEGER, numSamples INTEGER, numNullValues INTEGER, minValue REAL, maxValue REAL, sumValue REAL, PRIMARY KEY(counterId, level, summaryIndex));",
+    "CREATE INDEX sampleSummaryTimeIdx ON sampleSummaries (counterId, level, toTimeMs);",
+    "CREATE TABLE sampleBlockStore (blockSize INTEGER, numSamples INTEGER);"
 };
 
 const std::vector<std::string> SQL_CREATE_DB_STMTS_AGGREGATION =
@@ -140,9 +151,15 @@ const std::vector<std::string> SQL_CREATE_DB_STMTS_AGGREGATION =
     //"CREATE TABLE CallgraphSampleAggregation (callgraphId INTEGER NOT NULL, sampleContextId INTEGER, selfSamples INTEGER, deepSamples INTEGER)", // FOREIGN KEY(callgraphId) REFERENCES Callgraph(id), FOREIGN KEY(sampleContextId) REFERENCES SampleContext(id)
 };
 
+// The unique index is required while inserting, to update the count of an existing sample context
 const std::vector<std::string> SQL_CREATE_INDEX_STMTS_AGGREGATION =
 {
     "CREATE UNIQUE INDEX 'unique_samples' ON SampleContext (processThreadId, moduleInstanceId, coreSamplingConfigurationId, functionId, offset)",
+};
+
+// These indices are only used by the queries, so they can be created after inserting all the rows
+const std::vector<std::string> SQL_CREATE_SECONDARY_INDEX_STMTS_AGGREGATION =
+{
     "CREATE INDEX sampleContextIdx ON SampleContext (functionId, offset)",
     "CREATE INDEX processThreadIdx ON ProcessThread(processId, threadId)",
     "CREATE INDEX processThreadIdx1 ON ProcessThread(id)",
@@ -209,6 +226,282 @@ const std::vector<std::string> SQL_READ_DB_PRAGMAS =
     "PRAGMA cache_size=8192",
 };
 
+// Power profiling sample blocks.
+// The samples of each counter are stored in blocks of up to PP_SAMPLE_BLOCK_SIZE samples. A block holds the
+// delta-of-delta encoded timestamps and the XOR compressed values in two BLOB columns, along with the time range
+// and the min/max values of the block. The timeline queries decode only the blocks which overlap the queried time
+// range. The samples table is only written by the versions which did not have the sample blocks.
+#define PP_SAMPLE_BLOCK_SIZE            256
+#define PP_SAMPLE_VALUE_REPEATED        0x88
+
+// Summary levels of the sample blocks: a level 1 summary holds the min/max/sum of PP_SAMPLE_SUMMARY_FANOUT blocks,
+// and a level 2 summary holds those of PP_SAMPLE_SUMMARY_FANOUT level 1 summaries. The summary i of a level covers
+// the items [i * PP_SAMPLE_SUMMARY_FANOUT, (i + 1) * PP_SAMPLE_SUMMARY_FANOUT) of the level below it.
+#define PP_SAMPLE_SUMMARY_FANOUT        16
+#define PP_SAMPLE_SUMMARY_LEVELS        2
+
+// The stats of a block or of a summary. NaN values were stored as NULL in the samples table, they are counted in
+// m_numNullValues and are not part of the min/max/sum values.
+struct PPSampleSummary
+{
+    int m_index = 0;
+    int m_fromTime = 0;
+    int m_toTime = 0;
+    int m_numSamples = 0;
+    int m_numNullValues = 0;
+    double m_minValue = HUGE_VAL;
+    double m_maxValue = -HUGE_VAL;
+    double m_sumValue = 0.0;
+
+    // The number of lower level items merged into a summary which is being built.
+    int m_numMerged = 0;
+
+    void Merge(const PPSampleSummary& other)
+    {
+        m_fromTime = (0 == m_numSamples || other.m_fromTime < m_fromTime) ? other.m_fromTime : m_fromTime;
+        m_toTime = (0 == m_numSamples || other.m_toTime > m_toTime) ? other.m_toTime : m_toTime;
+        m_numSamples += other.m_numSamples;
+        m_numNullValues += other.m_numNullValues;
+        m_minValue = (other.m_minValue < m_minValue) ? other.m_minValue : m_minValue;
+        m_maxValue = (other.m_maxValue > m_maxValue) ? other.m_maxValue : m_maxValue;
+        m_sumValue += other.m_sumValue;
+        m_numMerged++;
+    }
+};
+
+// The samples of a single counter which were not written to a full block yet, and the summaries which are not full yet.
+struct PPSampleBlockBuilder
+{
+    int m_blockIndex = 0;
+    gtVector<int> m_times;
+    gtVector<double> m_values;
+
+    // The number of samples of the open block which were written by the last InsertOpenSampleBlocks().
+    size_t m_numWrittenSamples = 0;
+
+    PPSampleSummary m_summaries[PP_SAMPLE_SUMMARY_LEVELS];
+};
+
+// A block as it was read from the sampleBlocks table. The time range is the min/max time of the block's samples.
+// The data pointers are valid until the next block is read.
+struct PPSampleBlockRef : public PPSampleSummary
+{
+    const gtUByte* m_pTimeData = nullptr;
+    int m_timeDataSize = 0;
+    const gtUByte* m_pValueData = nullptr;
+    int m_valueDataSize = 0;
+};
+
+static void AppendVarUInt(gtVector<gtUByte>& buffer, gtUInt64 value)
+{
+    while (value >= 0x80)
+    {
+        buffer.push_back(static_cast<gtUByte>(value | 0x80));
+        value >>= 7;
+    }
+
+    buffer.push_back(static_cast<gtUByte>(value));
+}
+
+static bool ReadVarUInt(const gtUByte*& pData, const gtUByte* pEnd, gtUInt64& value)
+{
+    value = 0;
+
+    for (unsigned int shift = 0; (pData < pEnd) && (shift < 64); shift += 7)
+    {
+        gtUByte byte = *pData++;
+        value |= static_cast<gtUInt64>(byte & 0x7F) << shift;
+
+        if (0 == (byte & 0x80))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static gtUInt64 ZigZagEncode(gtInt64 value)
+{
+    return (static_cast<gtUInt64>(value) << 1) ^ static_cast<gtUInt64>(value >> 63);
+}
+
+static gtInt64 ZigZagDecode(gtUInt64 value)
+{
+    return static_cast<gtInt64>(value >> 1) ^ -static_cast<gtInt64>(value & 1);
+}
+
+// With a fixed sampling interval every delta-of-delta is 0, which takes a single byte.
+static void EncodeSampleTimes(const gtVector<int>& times, gtVector<gtUByte>& buffer)
+{
+    gtInt64 prevTime = 0;
+    gtInt64 prevDelta = 0;
+
+    for (size_t i = 0; i < times.size(); ++i)
+    {
+        gtInt64 delta = static_cast<gtInt64>(times[i]) - prevTime;
+        AppendVarUInt(buffer, ZigZagEncode((0 == i) ? delta : (delta - prevDelta)));
+
+        prevTime = times[i];
+        prevDelta = (0 == i) ? 0 : delta;
+    }
+}
+
+// Each value is XOR'ed with the previous one. A repeated value takes a single byte, otherwise a header byte holds
+// the number of leading and trailing zero bytes of the XOR'ed value, followed by its remaining bytes.
+static void EncodeSampleValues(const gtVector<double>& values, gtVector<gtUByte>& buffer)
+{
+    gtUInt64 prevBits = 0;
+
+    for (double value : values)
+    {
+        gtUInt64 bits = 0;
+        memcpy(&bits, &value, sizeof(bits));
+
+        gtUInt64 xorBits = bits ^ prevBits;
+        prevBits = bits;
+
+        if (0 == xorBits)
+        {
+            buffer.push_back(PP_SAMPLE_VALUE_REPEATED);
+        }
+        else
+        {
+            int leadingBytes = 0;
+
+            while (0 == ((xorBits >> (8 * (7 - leadingBytes))) & 0xFF))
+            {
+                ++leadingBytes;
+            }
+
+            int trailingBytes = 0;
+
+            while (0 == ((xorBits >> (8 * trailingBytes)) & 0xFF))
+            {
+                ++trailingBytes;
+            }
+
+            buffer.push_back(static_cast<gtUByte>((leadingBytes << 4) | trailingBytes));
+
+            for (int i = 7 - leadingBytes; i >= trailingBytes; --i)
+            {
+                buffer.push_back(static_cast<gtUByte>(xorBits >> (8 * i)));
+            }
+        }
+    }
+}
+
+// A counter id which appears more than once in the IN() list of the samples table queries is matched once.
+static void GetUniqueCounterIds(const gtVector<int>& counterIds, gtSet<int>& uniqueCounterIds)
+{
+    for (int counterId : counterIds)
+    {
+        uniqueCounterIds.insert(counterId);
+    }
+}
+
+// Same as "cast(sampledValue / bucketWidth as int) * bucketWidth" in the samples table query.
+static double GetSampleValueBucket(double value, unsigned int bucketWidth)
+{
+    // Clamped to the range of gtInt64, as the cast in sqlite does.
+    const double maxBucket = 9.2e18;
+    double bucket = value / bucketWidth;
+    bucket = (bucket < -maxBucket) ? -maxBucket : ((bucket > maxBucket) ? maxBucket : bucket);
+
+    return static_cast<double>(static_cast<gtInt64>(bucket)) * bucketWidth;
+}
+
+// The items of the level below the summaries [firstIndex, lastIndex] which come after the last read summary. Until the
+// profile session ends, the last items of each level are not covered by a summary yet.
+static bool GetItemsAfterSummaries(int firstIndex, int lastIndex, const gtVector<PPSampleSummary>& summaries, int& firstItem, int& lastItem)
+{
+    const gtInt64 maxItem = std::numeric_limits<int>::max();
+    gtInt64 first = (summaries.empty() ? static_cast<gtInt64>(firstIndex) : static_cast<gtInt64>(summaries.back().m_index) + 1) * PP_SAMPLE_SUMMARY_FANOUT;
+    gtInt64 last = static_cast<gtInt64>(lastIndex) * PP_SAMPLE_SUMMARY_FANOUT + PP_SAMPLE_SUMMARY_FANOUT - 1;
+
+    firstItem = static_cast<int>((first < maxItem) ? first : maxItem);
+    lastItem = static_cast<int>((last < maxItem) ? last : maxItem);
+
+    return (first <= last) && (first <= maxItem);
+}
+
+static bool IsEarlierSampledValue(const SampledValue& a, const SampledValue& b)
+{
+    return a.m_sampleTime < b.m_sampleTime;
+}
+
+static bool DecodeSampleBlock(const PPSampleBlockRef& block, gtVector<int>& times, gtVector<double>& values)
+{
+    bool ret = (block.m_numSamples > 0);
+
+    times.clear();
+    values.clear();
+    times.reserve(block.m_numSamples);
+    values.reserve(block.m_numSamples);
+
+    // Timestamps
+    const gtUByte* pData = block.m_pTimeData;
+    const gtUByte* pEnd = pData + block.m_timeDataSize;
+    gtInt64 time = 0;
+    gtInt64 delta = 0;
+
+    for (int i = 0; ret && (i < block.m_numSamples); ++i)
+    {
+        gtUInt64 encoded = 0;
+        ret = ReadVarUInt(pData, pEnd, encoded);
+
+        if (0 == i)
+        {
+            time = ZigZagDecode(encoded);
+        }
+        else
+        {
+            delta += ZigZagDecode(encoded);
+            time += delta;
+        }
+
+        times.push_back(static_cast<int>(time));
+    }
+
+    // Values
+    pData = block.m_pValueData;
+    pEnd = pData + block.m_valueDataSize;
+    gtUInt64 bits = 0;
+
+    for (int i = 0; ret && (i < block.m_numSamples); ++i)
+    {
+        ret = (pData < pEnd);
+
+        if (ret)
+        {
+            gtUByte header = *pData++;
+
+            if (PP_SAMPLE_VALUE_REPEATED != header)
+            {
+                int leadingBytes = header >> 4;
+                int trailingBytes = header & 0x0F;
+                int numBytes = 8 - leadingBytes - trailingBytes;
+                ret = (numBytes > 0) && ((pEnd - pData) >= numBytes);
+
+                gtUInt64 xorBits = 0;
+
+                for (int j = 0; ret && (j < numBytes); ++j)
+                {
+                    xorBits = (xorBits << 8) | *pData++;
+                }
+
+                bits ^= xorBits << (8 * trailingBytes);
+            }
+
+            double value = 0.0;
+            memcpy(&value, &bits, sizeof(value));
+            values.push_back(value);
+        }
+    }
+
+    return ret;
+}
+
 // A reference counter for number of sqlite connections.
 // Will be used to decide whether to shutdown sqlite.
 static int gs_SQLITE_NUM_OF_CLIENTS = 0;
@@ -240,11 +533,17 @@ public:
 
     ~Impl()
     {
+        // Write the samples which did not fill a block yet.
+        if (m_pSampleBlockInsertStmt != nullptr)
+        {
+            FinishSampleBlocks();
+        }
+
         // Create the requried indexes.
         if (m_pWriteDbConn != nullptr)
         {
-            // Create the indices for callstackframe and callstackleaf tables
-            CreateCssIndices();
+            // Create the secondary indices and the indices for callstackframe and callstackleaf tables
+            CreateDeferredIndices();
         }
 
         // Commit pending transactions.
@@ -267,13 +566,14 @@ public:
         if (m_isCreateDb)
         {
             // Finalize the statements for timeline related tables
-            sqlite3_finalize(m_pValsInsertStmt);
             sqlite3_finalize(m_pCounterEnabledAtInsertStmt);
             sqlite3_finalize(m_pSamplingIntervalInsertStmt);
             sqlite3_finalize(m_pDecivceInsertStmt);
             sqlite3_finalize(m_pSubDevicesInsertStmt);
             sqlite3_finalize(m_pCountersInsertStmt);
             sqlite3_finalize(m_pSessionInfoInsertStmt);
+            sqlite3_finalize(m_pSampleBlockInsertStmt);
+            sqlite3_finalize(m_pSampleSummaryInsertStmt);
 
             // Finalize the statements for aggregation related tables
             sqlite3_finalize(m_pCoreInfoInsertStmt);
@@ -318,6 +618,8 @@ public:
             sqlite3_finalize(m_pGetAllSessionInfoStmt);
             sqlite3_finalize(m_pGetSessionSamplingIntervalStmt);
             sqlite3_finalize(m_pGetSessionCounterIdsByNameStmt);
+            sqlite3_finalize(m_pGetSampleBlocksStmt);
+            sqlite3_finalize(m_pGetSampleSummariesStmt);
 
             sqlite3_finalize(m_pSystemModuleQueryStmt);
             sqlite3_finalize(m_pFunctionInfoQueryStmt);
@@ -345,13 +647,28 @@ public:
         m_moduleIdInfoMap.clear();
     }
 
-    bool PrepareInsertPowerProfilingSampleStatement()
+    bool PrepareInsertSampleBlockStatement()
     {
         bool ret = false;
 
-        // Insert power profiling sample statement.
-        const char* pCsSqlCmd = "INSERT INTO samples(quantizedTimeMs, counterId, sampledValue) VALUES(?, ?, ?);";
-        int rc = sqlite3_prepare_v2(m_pWriteDbConn, pCsSqlCmd, -1, &m_pValsInsertStmt, nullptr);
+        // Insert power profiling sample block statement. The open block of a counter is replaced until it is full.
+        const char* pCsSqlCmd = "INSERT OR REPLACE INTO sampleBlocks(counterId, blockIndex, fromTimeMs, toTimeMs, numSamples, numNullValues, minValue, maxValue, sumValue, timeData, valueData) "
+                                "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+        int rc = sqlite3_prepare_v2(m_pWriteDbConn, pCsSqlCmd, -1, &m_pSampleBlockInsertStmt, nullptr);
+        GT_ASSERT(rc == SQLITE_OK);
+        ret = (rc == SQLITE_OK);
+
+        return ret;
+    }
+
+    bool PrepareInsertSampleSummaryStatement()
+    {
+        bool ret = false;
+
+        // Insert power profiling sample summary statement.
+        const char* pCsSqlCmd = "INSERT INTO sampleSummaries(counterId, level, summaryIndex, fromTimeMs, toTimeMs, numSamples, numNullValues, minValue, maxValue, sumValue) "
+                                "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+        int rc = sqlite3_prepare_v2(m_pWriteDbConn, pCsSqlCmd, -1, &m_pSampleSummaryInsertStmt, nullptr);
         GT_ASSERT(rc == SQLITE_OK);
         ret = (rc == SQLITE_OK);
 
@@ -448,7 +765,8 @@ public:
         m_isFirstInsert = true;
 
         bool ret = PrepareInsertSessionInfoStatement()               &&
-                   PrepareInsertPowerProfilingSampleStatement()      &&
+                   PrepareInsertSampleBlockStatement()               &&
+                   PrepareInsertSampleSummaryStatement()             &&
                    PrepareInsertSubDeviceStatement()                 &&
                    PrepareInsertPowerProfilingDeviceStatement()      &&
                    PrepareInsertPowerProfilingCounterStatement()     &&
@@ -961,6 +1279,45 @@ public:
         return ret;
     }
 
+    bool PrepareGetSampleBlocksStatement()
+    {
+        m_isSampleBlockStoreReady = false;
+
+        // The DBs which have the block store row have only the sample blocks, the older DBs have only the samples table.
+        sqlite3_stmt* pStoreStmt = nullptr;
+        int rc = sqlite3_prepare_v2(m_pReadDbConn, "SELECT numSamples FROM sampleBlockStore;", -1, &pStoreStmt, nullptr);
+
+        if ((SQLITE_OK == rc) && (SQLITE_ROW == sqlite3_step(pStoreStmt)))
+        {
+            // The number of samples is set when the profile session ended. Until then, the last blocks of each counter
+            // do not have summaries yet.
+            m_isSampleBlockStoreFinished = (SQLITE_NULL != sqlite3_column_type(pStoreStmt, 0));
+
+            const char* pBlocksSqlCmd = "SELECT blockIndex, fromTimeMs, toTimeMs, numSamples, numNullValues, minValue, maxValue, sumValue, timeData, valueData "
+                                        "FROM sampleBlocks WHERE counterId = ? AND (blockIndex BETWEEN ? AND ?) AND toTimeMs >= ? AND fromTimeMs <= ? ORDER BY blockIndex;";
+            const char* pSummariesSqlCmd = "SELECT summaryIndex, fromTimeMs, toTimeMs, numSamples, numNullValues, minValue, maxValue, sumValue "
+                                           "FROM sampleSummaries WHERE counterId = ? AND level = ? AND (summaryIndex BETWEEN ? AND ?) AND toTimeMs >= ? AND fromTimeMs <= ? ORDER BY summaryIndex;";
+            const char* pRangeSqlCmd = "SELECT MIN(fromTimeMs), MAX(toTimeMs) FROM sampleBlocks;";
+
+            sqlite3_stmt* pRangeStmt = nullptr;
+
+            m_isSampleBlockStoreReady = (SQLITE_OK == sqlite3_prepare_v2(m_pReadDbConn, pBlocksSqlCmd, -1, &m_pGetSampleBlocksStmt, nullptr)) &&
+                                        (SQLITE_OK == sqlite3_prepare_v2(m_pReadDbConn, pSummariesSqlCmd, -1, &m_pGetSampleSummariesStmt, nullptr)) &&
+                                        (SQLITE_OK == sqlite3_prepare_v2(m_pReadDbConn, pRangeSqlCmd, -1, &pRangeStmt, nullptr));
+
+            if (m_isSampleBlockStoreReady)
+            {
+                // The session time range is read from the blocks instead of the samples table.
+                sqlite3_finalize(m_pGetSessionRangeStmt);
+                m_pGetSessionRangeStmt = pRangeStmt;
+            }
+        }
+
+        sqlite3_finalize(pStoreStmt);
+
+        return m_isSampleBlockStoreReady;
+    }
+
     bool PrepareAggregationReadStatements()
     {
         bool ret = true;
@@ -1015,14 +1372,22 @@ public:
         return ret;
     }
 
-    bool CreateCssIndices()
+    bool CreateDeferredIndices()
     {
         bool ret = false;
 
         if (m_isCreateIndex)
         {
-            ret = CreateIndices(SQL_CREATE_CSS_INDEX_STMTS_AGGREGATION);
+            osStopWatch stopWatch;
+            stopWatch.start();
+
+            ret = CreateIndices(SQL_CREATE_SECONDARY_INDEX_STMTS_AGGREGATION);
+            ret = CreateIndices(SQL_CREATE_CSS_INDEX_STMTS_AGGREGATION) && ret;
             m_isCreateIndex = false;
+
+            double elapsedTime = 0.0;
+            stopWatch.getTimeInterval(elapsedTime);
+            OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_INFO, L"Created the deferred DB indices in %.3f sec", elapsedTime);
         }
 
         return ret;
@@ -1089,6 +1454,7 @@ public:
                 {
                     ret = CreateTables(SQL_CREATE_DB_STMTS_TIMELINE);
 
+                    ret = ret && InsertSampleBlockStore();
                     ret = ret && PrepareAllPwrProfWriteStatements();
                 }
 
@@ -1099,11 +1465,28 @@ public:
                     m_isCreateIndex = true;
                     ret = ret && CreateIndices(SQL_CREATE_INDEX_STMTS_AGGREGATION);
 
+                    // The DB can be written without the bulk load, to check that the queries give the same results.
+                    gtString envVal;
+                    bool isBulkLoad = !osGetCurrentProcessEnvVariableValue(L"CODEXL_CPU_DB_NO_BULK_LOAD", envVal);
+
+                    if (!isBulkLoad)
+                    {
+                        ret = ret && CreateDeferredIndices();
+                    }
+
 #ifndef CXL_DB_CREATE_INDEX_AFTER_INSERT
-                    // Indices for CallStackLeaf and CallStackFrame tables
-                    ret = ret && CreateCssIndices();
+                    // Secondary indices and indices for CallStackLeaf and CallStackFrame tables
+                    ret = ret && CreateDeferredIndices();
 #endif
                     ret = ret && PrepareAllCpuProfWriteStatements();
+
+                    if (ret && isBulkLoad)
+                    {
+                        // Bulk load: insert all the rows in large transactions, which are committed
+                        // and begun again by FlushData().
+                        sqlite3_exec(m_pWriteDbConn, SQL_CMD_TX_BEGIN, nullptr, nullptr, nullptr);
+                        m_isFirstInsert = false;
+                    }
                 }
 
                 if (ret)
@@ -1159,6 +1542,9 @@ public:
                 if (ret && ((profileType & AMDT_PROFILE_MODE_TIMELINE) == AMDT_PROFILE_MODE_TIMELINE))
                 {
                     ret = PrepareTimelineReadStatements();
+
+                    // Not having the sample blocks is not an error, the samples table of an older DB is queried instead.
+                    PrepareGetSampleBlocksStatement();
                 }
 
                 if (ret && ((m_profileType & AMDT_PROFILE_MODE_AGGREGATION) == AMDT_PROFILE_MODE_AGGREGATION))
@@ -1224,6 +1610,12 @@ public:
 
         GT_IF_WITH_ASSERT(m_pDbTxCommitThread != nullptr)
         {
+            // The samples are written to the DB only when a block is full, so the open blocks are written as well.
+            if (m_pSampleBlockInsertStmt != nullptr)
+            {
+                InsertOpenSampleBlocks();
+            }
+
             ret = m_pDbTxCommitThread->TriggerDbTxCommit();
         }
 
@@ -1405,20 +1797,234 @@ public:
 
             for (const auto& sample : samples)
             {
-                // Bind the values to the parameters.
-                sqlite3_bind_int(m_pValsInsertStmt, 1, sample.m_quantizedTime);
-                sqlite3_bind_int(m_pValsInsertStmt, 2, sample.m_counterID);
-                sqlite3_bind_double(m_pValsInsertStmt, 3, sample.m_sampleValue);
+                AddToSampleBlock(sample);
+            }
 
-                // Execute the query.
-                int rc = sqlite3_step(m_pValsInsertStmt);
-                GT_ASSERT(rc == SQLITE_DONE);
+            ret = true;
+        }
 
-                // Reset the statement so that it can be reused.
-                sqlite3_reset(m_pValsInsertStmt);
+        return ret;
+    }
+
+    void AddToSampleBlock(const PPSampleData& sample)
+    {
+        PPSampleBlockBuilder& builder = m_sampleBlockBuilders[sample.m_counterID];
+
+        builder.m_times.push_back(sample.m_quantizedTime);
+        builder.m_values.push_back(sample.m_sampleValue);
+
+        if (PP_SAMPLE_BLOCK_SIZE <= builder.m_times.size())
+        {
+            InsertSampleBlock(sample.m_counterID, builder);
+        }
+    }
+
+    // An open block is written with the samples which were added to it so far, and stays open: it is replaced when it
+    // is written again, and its summaries are merged only when it is full.
+    bool InsertSampleBlock(int counterId, PPSampleBlockBuilder& builder, bool isOpenBlock = false)
+    {
+        bool ret = false;
+        const int numSamples = static_cast<int>(builder.m_times.size());
+
+        if (numSamples > 0)
+        {
+            gtVector<gtUByte> timeData;
+            gtVector<gtUByte> valueData;
+            timeData.reserve(numSamples);
+            valueData.reserve(numSamples * 4);
+
+            EncodeSampleTimes(builder.m_times, timeData);
+            EncodeSampleValues(builder.m_values, valueData);
+
+            // The samples are not required to be ordered by time.
+            PPSampleSummary blockSummary;
+            blockSummary.m_index = builder.m_blockIndex;
+            blockSummary.m_fromTime = builder.m_times.front();
+            blockSummary.m_toTime = builder.m_times.front();
+            blockSummary.m_numSamples = numSamples;
+
+            for (int time : builder.m_times)
+            {
+                blockSummary.m_fromTime = (time < blockSummary.m_fromTime) ? time : blockSummary.m_fromTime;
+                blockSummary.m_toTime = (time > blockSummary.m_toTime) ? time : blockSummary.m_toTime;
             }
 
-            ret = true;
+            for (double value : builder.m_values)
+            {
+                if (std::isnan(value))
+                {
+                    blockSummary.m_numNullValues++;
+                }
+                else
+                {
+                    blockSummary.m_minValue = (value < blockSummary.m_minValue) ? value : blockSummary.m_minValue;
+                    blockSummary.m_maxValue = (value > blockSummary.m_maxValue) ? value : blockSummary.m_maxValue;
+                    blockSummary.m_sumValue += value;
+                }
+            }
+
+            // Bind the values to the parameters.
+            sqlite3_bind_int(m_pSampleBlockInsertStmt, 1, counterId);
+            sqlite3_bind_int(m_pSampleBlockInsertStmt, 2, blockSummary.m_index);
+            sqlite3_bind_int(m_pSampleBlockInsertStmt, 3, blockSummary.m_fromTime);
+            sqlite3_bind_int(m_pSampleBlockInsertStmt, 4, blockSummary.m_toTime);
+            sqlite3_bind_int(m_pSampleBlockInsertStmt, 5, blockSummary.m_numSamples);
+            sqlite3_bind_int(m_pSampleBlockInsertStmt, 6, blockSummary.m_numNullValues);
+            sqlite3_bind_double(m_pSampleBlockInsertStmt, 7, blockSummary.m_minValue);
+            sqlite3_bind_double(m_pSampleBlockInsertStmt, 8, blockSummary.m_maxValue);
+            sqlite3_bind_double(m_pSampleBlockInsertStmt, 9, blockSummary.m_sumValue);
+            sqlite3_bind_blob(m_pSampleBlockInsertStmt, 10, &timeData[0], static_cast<int>(timeData.size()), SQLITE_TRANSIENT);
+            sqlite3_bind_blob(m_pSampleBlockInsertStmt, 11, &valueData[0], static_cast<int>(valueData.size()), SQLITE_TRANSIENT);
+
+            // Execute the query.
+            int rc = sqlite3_step(m_pSampleBlockInsertStmt);
+            GT_ASSERT(rc == SQLITE_DONE);
+            ret = (rc == SQLITE_DONE);
+
+            // Reset the statement so that it can be reused.
+            sqlite3_reset(m_pSampleBlockInsertStmt);
+
+            if (isOpenBlock)
+            {
+                builder.m_numWrittenSamples = builder.m_times.size();
+            }
+            else
+            {
+                m_numBlockSamples += numSamples;
+                builder.m_blockIndex++;
+                builder.m_times.clear();
+                builder.m_values.clear();
+                builder.m_numWrittenSamples = 0;
+
+                ret = AddToSampleSummaries(counterId, builder, blockSummary) && ret;
+            }
+        }
+
+        return ret;
+    }
+
+    // Merges the block into the level 1 summary. A full summary is written, and merged into the summary of the next level.
+    bool AddToSampleSummaries(int counterId, PPSampleBlockBuilder& builder, const PPSampleSummary& blockSummary)
+    {
+        bool ret = true;
+        bool isFull = true;
+        PPSampleSummary merged = blockSummary;
+
+        for (int level = 1; ret && isFull && (level <= PP_SAMPLE_SUMMARY_LEVELS); ++level)
+        {
+            PPSampleSummary& summary = builder.m_summaries[level - 1];
+            summary.Merge(merged);
+            isFull = (PP_SAMPLE_SUMMARY_FANOUT <= summary.m_numMerged);
+
+            if (isFull)
+            {
+                ret = InsertSampleSummary(counterId, level, summary);
+
+                merged = summary;
+                summary = PPSampleSummary();
+                summary.m_index = merged.m_index + 1;
+            }
+        }
+
+        return ret;
+    }
+
+    // Writes the summaries which are not full, after the last block of the counter was written.
+    bool FinishSampleSummaries(int counterId, PPSampleBlockBuilder& builder)
+    {
+        bool ret = true;
+
+        for (int level = 1; level <= PP_SAMPLE_SUMMARY_LEVELS; ++level)
+        {
+            const PPSampleSummary& summary = builder.m_summaries[level - 1];
+
+            if (0 < summary.m_numMerged)
+            {
+                ret = InsertSampleSummary(counterId, level, summary) && ret;
+
+                if (level < PP_SAMPLE_SUMMARY_LEVELS)
+                {
+                    builder.m_summaries[level].Merge(summary);
+                }
+            }
+        }
+
+        return ret;
+    }
+
+    bool InsertSampleSummary(int counterId, int level, const PPSampleSummary& summary)
+    {
+        // Bind the values to the parameters.
+        sqlite3_bind_int(m_pSampleSummaryInsertStmt, 1, counterId);
+        sqlite3_bind_int(m_pSampleSummaryInsertStmt, 2, level);
+        sqlite3_bind_int(m_pSampleSummaryInsertStmt, 3, summary.m_index);
+        sqlite3_bind_int(m_pSampleSummaryInsertStmt, 4, summary.m_fromTime);
+        sqlite3_bind_int(m_pSampleSummaryInsertStmt, 5, summary.m_toTime);
+        sqlite3_bind_int(m_pSampleSummaryInsertStmt, 6, summary.m_numSamples);
+        sqlite3_bind_int(m_pSampleSummaryInsertStmt, 7, summary.m_numNullValues);
+        sqlite3_bind_double(m_pSampleSummaryInsertStmt, 8, summary.m_minValue);
+        sqlite3_bind_double(m_pSampleSummaryInsertStmt, 9, summary.m_maxValue);
+        sqlite3_bind_double(m_pSampleSummaryInsertStmt, 10, summary.m_sumValue);
+
+        // Execute the query.
+        int rc = sqlite3_step(m_pSampleSummaryInsertStmt);
+        GT_ASSERT(rc == SQLITE_DONE);
+
+        // Reset the statement so that it can be reused.
+        sqlite3_reset(m_pSampleSummaryInsertStmt);
+
+        return (rc == SQLITE_DONE);
+    }
+
+    // Writes the open blocks which got samples since they were last written, so that the samples are committed along
+    // with the rest of the transaction. Called on the inserting thread, before the COMMIT is triggered.
+    bool InsertOpenSampleBlocks()
+    {
+        bool ret = true;
+
+        for (auto& builder : m_sampleBlockBuilders)
+        {
+            if (builder.second.m_times.size() != builder.second.m_numWrittenSamples)
+            {
+                ret = InsertSampleBlock(builder.first, builder.second, true) && ret;
+            }
+        }
+
+        return ret;
+    }
+
+    // The block store row tells the readers to use the sample blocks. Its number of samples is set by FinishSampleBlocks().
+    bool InsertSampleBlockStore()
+    {
+        std::stringstream query;
+        query << "INSERT INTO sampleBlockStore(blockSize, numSamples) VALUES(" << PP_SAMPLE_BLOCK_SIZE << ", NULL);";
+
+        return (SQLITE_OK == sqlite3_exec(m_pWriteDbConn, query.str().c_str(), nullptr, nullptr, nullptr));
+    }
+
+    // Writes the partial blocks and summaries, and marks the sample blocks as complete.
+    bool FinishSampleBlocks()
+    {
+        bool ret = true;
+
+        for (auto& builder : m_sampleBlockBuilders)
+        {
+            if (!builder.second.m_times.empty())
+            {
+                ret = InsertSampleBlock(builder.first, builder.second) && ret;
+            }
+
+            ret = FinishSampleSummaries(builder.first, builder.second) && ret;
+        }
+
+        m_sampleBlockBuilders.clear();
+
+        if (ret)
+        {
+            std::stringstream query;
+            query << "UPDATE sampleBlockStore SET numSamples = " << m_numBlockSamples << ";";
+
+            ret = (SQLITE_OK == sqlite3_exec(m_pWriteDbConn, query.str().c_str(), nullptr, nullptr, nullptr));
         }
 
         return ret;
@@ -1724,7 +2330,27 @@ public:
         return ret;
     }
 
-    bool InsertSamples(gtUInt64 ptId, gtUInt32 moduleInstanceId, gtUInt64 coreSamplingConfigId, gtUInt32 functionId, gtUInt64 offset, gtUInt64 count)
+    bool InsertSampleContext(gtUInt64 ptId, gtUInt32 moduleInstanceId, gtUInt64 coreSamplingConfigId, gtUInt32 functionId, gtUInt64 offset, gtUInt64 count)
+    {
+        bool ret = false;
+
+        sqlite3_bind_int64(m_pSampleContextInsertStmt, 1, ptId);
+        sqlite3_bind_int(m_pSampleContextInsertStmt, 2, moduleInstanceId);
+        sqlite3_bind_int64(m_pSampleContextInsertStmt, 3, coreSamplingConfigId);
+        sqlite3_bind_int(m_pSampleContextInsertStmt, 4, functionId);
+        sqlite3_bind_int64(m_pSampleContextInsertStmt, 5, offset);
+        sqlite3_bind_int64(m_pSampleContextInsertStmt, 6, count);
+
+        if (SQLITE_DONE == sqlite3_step(m_pSampleContextInsertStmt))
+        {
+            ret = true;
+        }
+
+        sqlite3_reset(m_pSampleContextInsertStmt);
+        return ret;
+    }
+
+    bool InsertSamples(gtUInt64 ptId, gtUInt32 moduleInstanceId, gtUInt64 coreSamplingConfigId, gtUInt32 functionId, gtUInt64 offset, gtUInt64 count, bool isNewContext)
     {
         bool ret = false;
 
@@ -1739,42 +2365,44 @@ public:
                 m_isFirstInsert = false;
             }
 
-            // Try to update the row assuming it is already inserted.
-            sqlite3_bind_int64(m_pSampleContextUpdateStmt, 1, count);
-            sqlite3_bind_int64(m_pSampleContextUpdateStmt, 2, ptId);
-            sqlite3_bind_int(m_pSampleContextUpdateStmt, 3, moduleInstanceId);
-            sqlite3_bind_int64(m_pSampleContextUpdateStmt, 4, coreSamplingConfigId);
-            sqlite3_bind_int(m_pSampleContextUpdateStmt, 5, functionId);
-            sqlite3_bind_int64(m_pSampleContextUpdateStmt, 6, offset);
+            // A new context is inserted first. If the row turns out to exist (the unique index
+            // rejects the insert), it is updated below.
+            if (isNewContext)
+            {
+                ret = InsertSampleContext(ptId, moduleInstanceId, coreSamplingConfigId, functionId, offset, count);
+            }
 
-            if (SQLITE_DONE == sqlite3_step(m_pSampleContextUpdateStmt))
+            if (!ret)
             {
-                int changes = sqlite3_changes(m_pWriteDbConn);
+                int changes = 0;
 
-                // Row update attempt failed, insert a new row.
-                if (0 == changes)
-                {
-                    sqlite3_bind_int64(m_pSampleContextInsertStmt, 1, ptId);
-                    sqlite3_bind_int(m_pSampleContextInsertStmt, 2, moduleInstanceId);
-                    sqlite3_bind_int64(m_pSampleContextInsertStmt, 3, coreSamplingConfigId);
-                    sqlite3_bind_int(m_pSampleContextInsertStmt, 4, functionId);
-                    sqlite3_bind_int64(m_pSampleContextInsertStmt, 5, offset);
-                    sqlite3_bind_int64(m_pSampleContextInsertStmt, 6, count);
-
-                    if (SQLITE_DONE == sqlite3_step(m_pSampleContextInsertStmt))
-                    {
-                        ret = true;
-                    }
+                // Try to update the row assuming it is already inserted.
+                sqlite3_bind_int64(m_pSampleContextUpdateStmt, 1, count);
+                sqlite3_bind_int64(m_pSampleContextUpdateStmt, 2, ptId);
+                sqlite3_bind_int(m_pSampleContextUpdateStmt, 3, moduleInstanceId);
+                sqlite3_bind_int64(m_pSampleContextUpdateStmt, 4, coreSamplingConfigId);
+                sqlite3_bind_int(m_pSampleContextUpdateStmt, 5, functionId);
+                sqlite3_bind_int64(m_pSampleContextUpdateStmt, 6, offset);
 
-                    sqlite3_reset(m_pSampleContextInsertStmt);
+                if (SQLITE_DONE == sqlite3_step(m_pSampleContextUpdateStmt))
+                {
+                    changes = sqlite3_changes(m_pWriteDbConn);
+                    ret = (0 != changes);
                 }
-                else // Row update was successful.
+                else
+                {
+                    // Neither update nor insert the row.
+                    changes = -1;
+                }
+
+                sqlite3_reset(m_pSampleContextUpdateStmt);
+
+                // Row update attempt failed, insert a new row.
+                if (0 == changes && !isNewContext)
                 {
-                    ret = true;
+                    ret = InsertSampleContext(ptId, moduleInstanceId, coreSamplingConfigId, functionId, offset, count);
                 }
             }
-
-            sqlite3_reset(m_pSampleContextUpdateStmt);
         }
 
         return ret;
@@ -2240,7 +2868,247 @@ public:
         return ret;
     }
 
+    bool ReadSampleBlock(PPSampleBlockRef& block)
+    {
+        bool ret = (SQLITE_ROW == sqlite3_step(m_pGetSampleBlocksStmt));
+
+        if (ret)
+        {
+            ReadSampleSummary(m_pGetSampleBlocksStmt, block);
+            block.m_pTimeData = static_cast<const gtUByte*>(sqlite3_column_blob(m_pGetSampleBlocksStmt, 8));
+            block.m_timeDataSize = sqlite3_column_bytes(m_pGetSampleBlocksStmt, 8);
+            block.m_pValueData = static_cast<const gtUByte*>(sqlite3_column_blob(m_pGetSampleBlocksStmt, 9));
+            block.m_valueDataSize = sqlite3_column_bytes(m_pGetSampleBlocksStmt, 9);
+        }
+
+        return ret;
+    }
+
+    // The blocks and the summaries queries return the same first columns.
+    void ReadSampleSummary(sqlite3_stmt* pQueryStmt, PPSampleSummary& summary)
+    {
+        summary.m_index = sqlite3_column_int(pQueryStmt, 0);
+        summary.m_fromTime = sqlite3_column_int(pQueryStmt, 1);
+        summary.m_toTime = sqlite3_column_int(pQueryStmt, 2);
+        summary.m_numSamples = sqlite3_column_int(pQueryStmt, 3);
+        summary.m_numNullValues = sqlite3_column_int(pQueryStmt, 4);
+        summary.m_minValue = sqlite3_column_double(pQueryStmt, 5);
+        summary.m_maxValue = sqlite3_column_double(pQueryStmt, 6);
+        summary.m_sumValue = sqlite3_column_double(pQueryStmt, 7);
+    }
+
+    void BindGetSampleBlocksStatement(int counterId, int firstIndex, int lastIndex, int fromTime, int toTime)
+    {
+        sqlite3_bind_int(m_pGetSampleBlocksStmt, 1, counterId);
+        sqlite3_bind_int(m_pGetSampleBlocksStmt, 2, firstIndex);
+        sqlite3_bind_int(m_pGetSampleBlocksStmt, 3, lastIndex);
+        sqlite3_bind_int(m_pGetSampleBlocksStmt, 4, fromTime);
+        sqlite3_bind_int(m_pGetSampleBlocksStmt, 5, toTime);
+    }
+
+    // The summaries are read before the levels below them are queried.
+    bool GetSampleSummaries(int counterId, int level, int firstIndex, int lastIndex, int fromTime, int toTime, gtVector<PPSampleSummary>& summaries)
+    {
+        sqlite3_bind_int(m_pGetSampleSummariesStmt, 1, counterId);
+        sqlite3_bind_int(m_pGetSampleSummariesStmt, 2, level);
+        sqlite3_bind_int(m_pGetSampleSummariesStmt, 3, firstIndex);
+        sqlite3_bind_int(m_pGetSampleSummariesStmt, 4, lastIndex);
+        sqlite3_bind_int(m_pGetSampleSummariesStmt, 5, fromTime);
+        sqlite3_bind_int(m_pGetSampleSummariesStmt, 6, toTime);
+
+        int rc = SQLITE_ROW;
+
+        while (SQLITE_ROW == (rc = sqlite3_step(m_pGetSampleSummariesStmt)))
+        {
+            PPSampleSummary summary;
+            ReadSampleSummary(m_pGetSampleSummariesStmt, summary);
+            summaries.push_back(summary);
+        }
+
+        sqlite3_reset(m_pGetSampleSummariesStmt);
+
+        return (SQLITE_DONE == rc);
+    }
+
     bool GetBucketizedSamplesByCounterId(unsigned int bucketWidth, const gtVector<int>& counterIds, gtVector<int>& dbCids, gtVector<double>& dbBucketBottoms, gtVector<int>& dbBucketCount)
+    {
+        osStopWatch stopWatch;
+        stopWatch.start();
+
+        const bool useSampleBlocks = m_isSampleBlockStoreReady;
+        bool ret = useSampleBlocks ? GetBucketizedSamplesFromSampleBlocks(bucketWidth, counterIds, dbCids, dbBucketBottoms, dbBucketCount) :
+                   GetBucketizedSamplesFromSamplesTable(bucketWidth, counterIds, dbCids, dbBucketBottoms, dbBucketCount);
+
+        double elapsedTime = 0.0;
+        stopWatch.getTimeInterval(elapsedTime);
+        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_EXTENSIVE, L"GetBucketizedSamplesByCounterId: %d counters, %d buckets in %.3f ms (%ls)",
+                                   static_cast<int>(counterIds.size()), static_cast<int>(dbCids.size()), elapsedTime * 1000.0,
+                                   useSampleBlocks ? L"sample blocks" : L"samples table");
+
+        return ret;
+    }
+
+    // Same as the samples table query: the value of a sample is truncated to a multiple of the bucket width, and
+    // the buckets are ordered by their bottom value. The NULL bucket of the NaN values comes first, with a bottom of 0.
+    // A zero width puts all the samples in the NULL bucket, as the division by zero in the samples table query does.
+    bool GetBucketizedSamplesFromSampleBlocks(unsigned int bucketWidth, const gtVector<int>& counterIds, gtVector<int>& dbCids, gtVector<double>& dbBucketBottoms, gtVector<int>& dbBucketCount)
+    {
+        bool ret = true;
+        gtSet<int> uniqueCounterIds;
+        GetUniqueCounterIds(counterIds, uniqueCounterIds);
+
+        // {bucket bottom, counter id} -> number of samples
+        gtMap<std::pair<double, int>, int> buckets;
+        gtMap<int, int> nanBuckets;
+
+        for (int counterId : uniqueCounterIds)
+        {
+            if (0 == bucketWidth)
+            {
+                PPSampleSummary totals;
+                ret = GetSampleTotals(counterId, PP_SAMPLE_SUMMARY_LEVELS, 0, std::numeric_limits<int>::max(), totals) && ret;
+
+                if (totals.m_numSamples > 0)
+                {
+                    nanBuckets[counterId] = totals.m_numSamples;
+                }
+            }
+            else
+            {
+                ret = AddSampleSummariesToBuckets(counterId, PP_SAMPLE_SUMMARY_LEVELS, 0, std::numeric_limits<int>::max(), bucketWidth, buckets, nanBuckets) && ret;
+            }
+        }
+
+        for (const auto& nanBucket : nanBuckets)
+        {
+            dbCids.push_back(nanBucket.first);
+            dbBucketBottoms.push_back(0.0);
+            dbBucketCount.push_back(nanBucket.second);
+        }
+
+        for (const auto& bucket : buckets)
+        {
+            dbCids.push_back(bucket.first.second);
+            dbBucketBottoms.push_back(bucket.first.first);
+            dbBucketCount.push_back(bucket.second);
+        }
+
+        return ret;
+    }
+
+    // A summary whose min and max values fall in the same bucket is counted as a whole, otherwise the items of the
+    // level below it are used. Only the blocks which have values in more than one bucket are decoded.
+    bool AddSampleSummariesToBuckets(int counterId, int level, int firstIndex, int lastIndex, unsigned int bucketWidth,
+                                     gtMap<std::pair<double, int>, int>& buckets, gtMap<int, int>& nanBuckets)
+    {
+        bool ret = true;
+
+        if (0 == level)
+        {
+            gtVector<int> times;
+            gtVector<double> values;
+            PPSampleBlockRef block;
+
+            BindGetSampleBlocksStatement(counterId, firstIndex, lastIndex, std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+
+            while (ret && ReadSampleBlock(block))
+            {
+                if ((0 == block.m_numNullValues) && (GetSampleValueBucket(block.m_minValue, bucketWidth) == GetSampleValueBucket(block.m_maxValue, bucketWidth)))
+                {
+                    buckets[std::make_pair(GetSampleValueBucket(block.m_minValue, bucketWidth), counterId)] += block.m_numSamples;
+                }
+                else
+                {
+                    ret = DecodeSampleBlock(block, times, values);
+
+                    for (size_t i = 0; ret && (i < values.size()); ++i)
+                    {
+                        if (std::isnan(values[i]))
+                        {
+                            nanBuckets[counterId]++;
+                        }
+                        else
+                        {
+                            buckets[std::make_pair(GetSampleValueBucket(values[i], bucketWidth), counterId)]++;
+                        }
+                    }
+                }
+            }
+
+            sqlite3_reset(m_pGetSampleBlocksStmt);
+        }
+        else
+        {
+            gtVector<PPSampleSummary> summaries;
+            ret = GetSampleSummaries(counterId, level, firstIndex, lastIndex, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), summaries);
+
+            for (const PPSampleSummary& summary : summaries)
+            {
+                if ((0 == summary.m_numNullValues) && (GetSampleValueBucket(summary.m_minValue, bucketWidth) == GetSampleValueBucket(summary.m_maxValue, bucketWidth)))
+                {
+                    buckets[std::make_pair(GetSampleValueBucket(summary.m_minValue, bucketWidth), counterId)] += summary.m_numSamples;
+                }
+                else
+                {
+                    ret = AddSampleSummariesToBuckets(counterId, level - 1, summary.m_index * PP_SAMPLE_SUMMARY_FANOUT,
+                                                      summary.m_index * PP_SAMPLE_SUMMARY_FANOUT + PP_SAMPLE_SUMMARY_FANOUT - 1,
+                                                      bucketWidth, buckets, nanBuckets) && ret;
+                }
+            }
+
+            int firstItem = 0;
+            int lastItem = 0;
+
+            if (!m_isSampleBlockStoreFinished && GetItemsAfterSummaries(firstIndex, lastIndex, summaries, firstItem, lastItem))
+            {
+                ret = AddSampleSummariesToBuckets(counterId, level - 1, firstItem, lastItem, bucketWidth, buckets, nanBuckets) && ret;
+            }
+        }
+
+        return ret;
+    }
+
+    // Merges the stats of all the samples of the counter in the summaries [firstIndex, lastIndex] of the level.
+    bool GetSampleTotals(int counterId, int level, int firstIndex, int lastIndex, PPSampleSummary& totals)
+    {
+        bool ret = true;
+
+        if (0 == level)
+        {
+            PPSampleBlockRef block;
+
+            BindGetSampleBlocksStatement(counterId, firstIndex, lastIndex, std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+
+            while (ReadSampleBlock(block))
+            {
+                totals.Merge(block);
+            }
+
+            sqlite3_reset(m_pGetSampleBlocksStmt);
+        }
+        else
+        {
+            gtVector<PPSampleSummary> summaries;
+            ret = GetSampleSummaries(counterId, level, firstIndex, lastIndex, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), summaries);
+
+            for (const PPSampleSummary& summary : summaries)
+            {
+                totals.Merge(summary);
+            }
+
+            int firstItem = 0;
+            int lastItem = 0;
+
+            if (!m_isSampleBlockStoreFinished && GetItemsAfterSummaries(firstIndex, lastIndex, summaries, firstItem, lastItem))
+            {
+                ret = GetSampleTotals(counterId, level - 1, firstItem, lastItem, totals) && ret;
+            }
+        }
+
+        return ret;
+    }
+
+    bool GetBucketizedSamplesFromSamplesTable(unsigned int bucketWidth, const gtVector<int>& counterIds, gtVector<int>& dbCids, gtVector<double>& dbBucketBottoms, gtVector<int>& dbBucketCount)
     {
         const char* QUERY_SELECT_CLAUSE = "SELECT counterId, cast(sampledValue / ? as int) * ? AS bucket, COUNT(*) AS CNT FROM samples ";
         const char* QUERY_WHERE_CLAUSE_BEGIN = "WHERE counterId IN(";
@@ -2639,6 +3507,38 @@ public:
     }
 
     bool GetSamplesGroupByCounterId(const gtVector<int>& counterIds, gtMap<int, double>& consumptionPerCounterId)
+    {
+        return m_isSampleBlockStoreReady ? GetSamplesGroupByCounterIdFromSampleBlocks(counterIds, consumptionPerCounterId) :
+               GetSamplesGroupByCounterIdFromSamplesTable(counterIds, consumptionPerCounterId);
+    }
+
+    // Same as SUM(sampledValue) in the samples table query, which skips the NULL values of the NaN samples.
+    bool GetSamplesGroupByCounterIdFromSampleBlocks(const gtVector<int>& counterIds, gtMap<int, double>& consumptionPerCounterId)
+    {
+        bool ret = false;
+        gtSet<int> uniqueCounterIds;
+        GetUniqueCounterIds(counterIds, uniqueCounterIds);
+
+        GT_IF_WITH_ASSERT(!uniqueCounterIds.empty())
+        {
+            ret = true;
+
+            for (int counterId : uniqueCounterIds)
+            {
+                PPSampleSummary totals;
+                ret = GetSampleTotals(counterId, PP_SAMPLE_SUMMARY_LEVELS, 0, std::numeric_limits<int>::max(), totals) && ret;
+
+                if (totals.m_numSamples > 0)
+                {
+                    consumptionPerCounterId.insert(std::pair<int, double>(counterId, totals.m_sumValue));
+                }
+            }
+        }
+
+        return ret;
+    }
+
+    bool GetSamplesGroupByCounterIdFromSamplesTable(const gtVector<int>& counterIds, gtMap<int, double>& consumptionPerCounterId)
     {
         bool ret = false;
         const char* QUERY_SELECT_CLAUSE = "SELECT counterId, SUM(sampledValue) FROM samples ";
@@ -2691,6 +3591,38 @@ public:
     }
 
     bool GetSampleCountByCounterId(const gtVector<int>& counterIds, gtMap<int, int>& numberOfSamplesPerCounter)
+    {
+        return m_isSampleBlockStoreReady ? GetSampleCountByCounterIdFromSampleBlocks(counterIds, numberOfSamplesPerCounter) :
+               GetSampleCountByCounterIdFromSamplesTable(counterIds, numberOfSamplesPerCounter);
+    }
+
+    // Same as COUNT(counterId) in the samples table query, which counts the NaN samples too.
+    bool GetSampleCountByCounterIdFromSampleBlocks(const gtVector<int>& counterIds, gtMap<int, int>& numberOfSamplesPerCounter)
+    {
+        bool ret = false;
+        gtSet<int> uniqueCounterIds;
+        GetUniqueCounterIds(counterIds, uniqueCounterIds);
+
+        GT_IF_WITH_ASSERT(!uniqueCounterIds.empty())
+        {
+            ret = true;
+
+            for (int counterId : uniqueCounterIds)
+            {
+                PPSampleSummary totals;
+                ret = GetSampleTotals(counterId, PP_SAMPLE_SUMMARY_LEVELS, 0, std::numeric_limits<int>::max(), totals) && ret;
+
+                if (totals.m_numSamples > 0)
+                {
+                    numberOfSamplesPerCounter.insert(std::pair<int, int>(counterId, totals.m_numSamples));
+                }
+            }
+        }
+
+        return ret;
+    }
+
+    bool GetSampleCountByCounterIdFromSamplesTable(const gtVector<int>& counterIds, gtMap<int, int>& numberOfSamplesPerCounter)
     {
         bool ret = false;
         const char* QUERY_SELECT_CLAUSE = "SELECT counterId, COUNT(counterId) FROM samples ";
@@ -2744,6 +3676,78 @@ public:
 
     bool GetSamplesByCounterIdAndRange(const gtVector<int>& counterIds, const SamplingTimeRange& samplingTimeRange,
                                        gtMap<int, gtVector<SampledValue>>& sampledValuesPerCounter)
+    {
+        osStopWatch stopWatch;
+        stopWatch.start();
+
+        bool ret = m_isSampleBlockStoreReady ? GetSamplesByCounterIdAndRangeFromSampleBlocks(counterIds, samplingTimeRange, sampledValuesPerCounter) :
+                   GetSamplesByCounterIdAndRangeFromSamplesTable(counterIds, samplingTimeRange, sampledValuesPerCounter);
+
+        double elapsedTime = 0.0;
+        stopWatch.getTimeInterval(elapsedTime);
+        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_EXTENSIVE, L"GetSamplesByCounterIdAndRange: %d counters, [%d, %d] in %.3f ms (%ls)",
+                                   static_cast<int>(counterIds.size()), samplingTimeRange.m_fromTime, samplingTimeRange.m_toTime,
+                                   elapsedTime * 1000.0, m_isSampleBlockStoreReady ? L"sample blocks" : L"samples table");
+
+        return ret;
+    }
+
+    bool GetSamplesByCounterIdAndRangeFromSampleBlocks(const gtVector<int>& counterIds, const SamplingTimeRange& samplingTimeRange,
+                                                       gtMap<int, gtVector<SampledValue>>& sampledValuesPerCounter)
+    {
+        bool ret = false;
+        gtSet<int> uniqueCounterIds;
+        GetUniqueCounterIds(counterIds, uniqueCounterIds);
+        const int fromTime = samplingTimeRange.m_fromTime;
+        const int toTime = samplingTimeRange.m_toTime;
+        gtVector<int> times;
+        gtVector<double> values;
+
+        GT_IF_WITH_ASSERT(!uniqueCounterIds.empty())
+        {
+            ret = true;
+
+            for (int counterId : uniqueCounterIds)
+            {
+                BindGetSampleBlocksStatement(counterId, 0, std::numeric_limits<int>::max(), fromTime, toTime);
+
+                PPSampleBlockRef block;
+                gtVector<SampledValue>* pSampledValues = nullptr;
+
+                while (ret && ReadSampleBlock(block))
+                {
+                    ret = DecodeSampleBlock(block, times, values);
+
+                    for (size_t i = 0; ret && (i < times.size()); ++i)
+                    {
+                        if ((times[i] >= fromTime) && (times[i] <= toTime))
+                        {
+                            if (nullptr == pSampledValues)
+                            {
+                                pSampledValues = &sampledValuesPerCounter[counterId];
+                            }
+
+                            // NaN values are stored as NULL in the samples table, which is read as 0.
+                            pSampledValues->push_back(SampledValue(times[i], std::isnan(values[i]) ? 0.0 : values[i]));
+                        }
+                    }
+                }
+
+                sqlite3_reset(m_pGetSampleBlocksStmt);
+
+                // The samples table query orders the samples by time.
+                if ((nullptr != pSampledValues) && !std::is_sorted(pSampledValues->begin(), pSampledValues->end(), IsEarlierSampledValue))
+                {
+                    std::stable_sort(pSampledValues->begin(), pSampledValues->end(), IsEarlierSampledValue);
+                }
+            }
+        }
+
+        return ret;
+    }
+
+    bool GetSamplesByCounterIdAndRangeFromSamplesTable(const gtVector<int>& counterIds, const SamplingTimeRange& samplingTimeRange,
+                                                       gtMap<int, gtVector<SampledValue>>& sampledValuesPerCounter)
     {
         bool ret = false;
         const char* QUERY_SELECT_CLAUSE = "SELECT quantizedTimeMs, counterId, sampledValue FROM samples ";
@@ -2804,6 +3808,123 @@ public:
 
     bool GetMinMaxSampleByCounterId(const gtVector<int>& counterIds, const SamplingTimeRange& samplingTimeRange,
                                     double& minValue, double& maxValue)
+    {
+        osStopWatch stopWatch;
+        stopWatch.start();
+
+        bool ret = m_isSampleBlockStoreReady ? GetMinMaxSampleFromSampleBlocks(counterIds, samplingTimeRange, minValue, maxValue) :
+                   GetMinMaxSampleFromSamplesTable(counterIds, samplingTimeRange, minValue, maxValue);
+
+        double elapsedTime = 0.0;
+        stopWatch.getTimeInterval(elapsedTime);
+        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_EXTENSIVE, L"GetMinMaxSampleByCounterId: %d counters, [%d, %d] in %.3f ms (%ls)",
+                                   static_cast<int>(counterIds.size()), samplingTimeRange.m_fromTime, samplingTimeRange.m_toTime,
+                                   elapsedTime * 1000.0, m_isSampleBlockStoreReady ? L"sample blocks" : L"samples table");
+
+        return ret;
+    }
+
+    bool GetMinMaxSampleFromSampleBlocks(const gtVector<int>& counterIds, const SamplingTimeRange& samplingTimeRange,
+                                         double& minValue, double& maxValue)
+    {
+        bool ret = false;
+        gtSet<int> uniqueCounterIds;
+        GetUniqueCounterIds(counterIds, uniqueCounterIds);
+        double rangeMin = HUGE_VAL;
+        double rangeMax = -HUGE_VAL;
+
+        GT_IF_WITH_ASSERT(!uniqueCounterIds.empty())
+        {
+            ret = true;
+
+            for (int counterId : uniqueCounterIds)
+            {
+                ret = GetMinMaxFromSampleSummaries(counterId, PP_SAMPLE_SUMMARY_LEVELS, 0, std::numeric_limits<int>::max(),
+                                                   samplingTimeRange.m_fromTime, samplingTimeRange.m_toTime, rangeMin, rangeMax) && ret;
+            }
+
+            // MIN/MAX of no samples is NULL, which is read as 0.
+            minValue = (rangeMin <= rangeMax) ? rangeMin : 0.0;
+            maxValue = (rangeMin <= rangeMax) ? rangeMax : 0.0;
+        }
+
+        return ret;
+    }
+
+    // The min/max values of a summary which is entirely in the time range are used, otherwise the items of the level
+    // below it which overlap the time range are used. Only the blocks at the edges of the time range are decoded.
+    bool GetMinMaxFromSampleSummaries(int counterId, int level, int firstIndex, int lastIndex, int fromTime, int toTime,
+                                      double& rangeMin, double& rangeMax)
+    {
+        bool ret = true;
+
+        if (0 == level)
+        {
+            gtVector<int> times;
+            gtVector<double> values;
+            PPSampleBlockRef block;
+
+            BindGetSampleBlocksStatement(counterId, firstIndex, lastIndex, fromTime, toTime);
+
+            while (ret && ReadSampleBlock(block))
+            {
+                if ((block.m_fromTime >= fromTime) && (block.m_toTime <= toTime))
+                {
+                    rangeMin = (block.m_minValue < rangeMin) ? block.m_minValue : rangeMin;
+                    rangeMax = (block.m_maxValue > rangeMax) ? block.m_maxValue : rangeMax;
+                }
+                else
+                {
+                    ret = DecodeSampleBlock(block, times, values);
+
+                    for (size_t i = 0; ret && (i < times.size()); ++i)
+                    {
+                        if ((times[i] >= fromTime) && (times[i] <= toTime) && !std::isnan(values[i]))
+                        {
+                            rangeMin = (values[i] < rangeMin) ? values[i] : rangeMin;
+                            rangeMax = (values[i] > rangeMax) ? values[i] : rangeMax;
+                        }
+                    }
+                }
+            }
+
+            sqlite3_reset(m_pGetSampleBlocksStmt);
+        }
+        else
+        {
+            gtVector<PPSampleSummary> summaries;
+            ret = GetSampleSummaries(counterId, level, firstIndex, lastIndex, fromTime, toTime, summaries);
+
+            for (const PPSampleSummary& summary : summaries)
+            {
+                if ((summary.m_fromTime >= fromTime) && (summary.m_toTime <= toTime))
+                {
+                    rangeMin = (summary.m_minValue < rangeMin) ? summary.m_minValue : rangeMin;
+                    rangeMax = (summary.m_maxValue > rangeMax) ? summary.m_maxValue : rangeMax;
+                }
+                else
+                {
+                    ret = GetMinMaxFromSampleSummaries(counterId, level - 1, summary.m_index * PP_SAMPLE_SUMMARY_FANOUT,
+                                                       summary.m_index * PP_SAMPLE_SUMMARY_FANOUT + PP_SAMPLE_SUMMARY_FANOUT - 1,
+                                                       fromTime, toTime, rangeMin, rangeMax) && ret;
+                }
+            }
+
+            // The items below the summaries which are not in the time range are filtered out by the query of their level.
+            int firstItem = 0;
+            int lastItem = 0;
+
+            if (!m_isSampleBlockStoreFinished && GetItemsAfterSummaries(firstIndex, lastIndex, summaries, firstItem, lastItem))
+            {
+                ret = GetMinMaxFromSampleSummaries(counterId, level - 1, firstItem, lastItem, fromTime, toTime, rangeMin, rangeMax) && ret;
+            }
+        }
+
+        return ret;
+    }
+
+    bool GetMinMaxSampleFromSamplesTable(const gtVector<int>& counterIds, const SamplingTimeRange& samplingTimeRange,
+                                         double& minValue, double& maxValue)
     {
         bool ret = false;
         const char* QUERY_SELECT_CLAUSE = "SELECT MIN(sampledValue), MAX(sampledValue) FROM samples ";
@@ -6560,13 +7681,18 @@ public:
 
     // These objects will be split into two different classes: reader and writer.
     sqlite3*      m_pWriteDbConn = nullptr;
-    sqlite3_stmt* m_pValsInsertStmt = nullptr;
     sqlite3_stmt* m_pCounterEnabledAtInsertStmt = nullptr;
     sqlite3_stmt* m_pSamplingIntervalInsertStmt = nullptr;
     sqlite3_stmt* m_pDecivceInsertStmt = nullptr;
     sqlite3_stmt* m_pSubDevicesInsertStmt = nullptr;
     sqlite3_stmt* m_pCountersInsertStmt = nullptr;
     sqlite3_stmt* m_pSessionInfoInsertStmt = nullptr;
+    sqlite3_stmt* m_pSampleBlockInsertStmt = nullptr;
+    sqlite3_stmt* m_pSampleSummaryInsertStmt = nullptr;
+
+    // The samples of each counter which were not written to a full block yet.
+    gtMap<int, PPSampleBlockBuilder> m_sampleBlockBuilders;
+    gtUInt64 m_numBlockSamples = 0;
 
     sqlite3*      m_pReadDbConn = nullptr;
     sqlite3_stmt* m_pGetSessionRangeStmt = nullptr;
@@ -6585,6 +7711,14 @@ public:
     sqlite3_stmt* m_pGetAllSessionInfoStmt = nullptr;
     sqlite3_stmt* m_pGetSessionSamplingIntervalStmt = nullptr;
     sqlite3_stmt* m_pGetSessionCounterIdsByNameStmt = nullptr;
+    sqlite3_stmt* m_pGetSampleBlocksStmt = nullptr;
+    sqlite3_stmt* m_pGetSampleSummariesStmt = nullptr;
+
+    // True if the samples are read from the sample blocks.
+    bool m_isSampleBlockStoreReady = false;
+
+    // True if the summaries of all the sample blocks were written.
+    bool m_isSampleBlockStoreFinished = false;
 
 
     sqlite3_stmt* m_pCoreInfoInsertStmt = nullptr;
@@ -6937,7 +8071,7 @@ bool AmdtDatabaseAccessor::InsertProcessThreadInfo(gtUInt64 id, gtUInt64 pid, gt
     return ret;
 }
 
-bool AmdtDatabaseAccessor::InsertSamples(const CPSampleData& sampleData)
+bool AmdtDatabaseAccessor::InsertSamples(const CPSampleData& sampleData, bool isNewContext)
 {
     bool ret = false;
 
@@ -6948,7 +8082,8 @@ bool AmdtDatabaseAccessor::InsertSamples(const CPSampleData& sampleData)
                                      sampleData.m_coreSamplingConfigId,
                                      sampleData.m_functionId,
                                      sampleData.m_offset,
-                                     sampleData.m_count);
+                                     sampleData.m_count,
+                                     isNewContext);
     }
 
     return ret;
@@ -6,6 +6,7 @@
 //=============================================================================
 
 #include "APIEntry.h"
+#include "ThreadTraceData.h"
 #include "../misc.h"
 
 //--------------------------------------------------------------------------
@@ -29,8 +30,9 @@ APIEntry::APIEntry(UINT inThreadId, FuncId inFuncId, const std::string& inArgume
 /// \param inThreadId The thread Id that the call was invoked from.
 /// \param inFuncId The function ID of this API call
 /// \param inNumParameters The number of params for this api call
+/// \param pThreadData The trace data of the calling thread, whose arena holds the parameter buffer.
 //--------------------------------------------------------------------------
-APIEntry::APIEntry(UINT inThreadId, FuncId inFuncId, UINT32 inNumParameters)
+APIEntry::APIEntry(UINT inThreadId, FuncId inFuncId, UINT32 inNumParameters, ThreadTraceData* pThreadData)
     : mThreadId(inThreadId)
     , mParameters("")
     , mFunctionId(inFuncId)
@@ -40,7 +42,7 @@ APIEntry::APIEntry(UINT inThreadId, FuncId inFuncId, UINT32 inNumParameters)
 {
     if (inNumParameters != 0)
     {
-        mParameterBuffer = new char[inNumParameters * BYTES_PER_PARAMETER];
+        mParameterBuffer = static_cast<char*>(pThreadData->AllocateFromArena(inNumParameters * BYTES_PER_PARAMETER));
     }
 }
 
@@ -49,7 +51,36 @@ APIEntry::APIEntry(UINT inThreadId, FuncId inFuncId, UINT32 inNumParameters)
 //--------------------------------------------------------------------------
 APIEntry::~APIEntry()
 {
-    SAFE_DELETE_ARRAY(mParameterBuffer);
+    // The parameter buffer lives in the thread's arena, and is reclaimed with it.
+}
+
+//--------------------------------------------------------------------------
+/// APIEntry records are allocated from the arena of the thread they are traced in,
+/// instead of the heap: new (pThreadData) DX12APIEntry(...).
+/// \param inSize The size of the record.
+/// \param pThreadData The trace data of the calling thread.
+/// \returns Memory for the new record.
+//--------------------------------------------------------------------------
+void* APIEntry::operator new(size_t inSize, ThreadTraceData* pThreadData)
+{
+    return pThreadData->AllocateFromArena(inSize);
+}
+
+//--------------------------------------------------------------------------
+/// Matches the arena operator new, in case a constructor throws. The memory is reclaimed with the arena.
+//--------------------------------------------------------------------------
+void APIEntry::operator delete(void* pEntry, ThreadTraceData* pThreadData)
+{
+    PS_UNREFERENCED_PARAMETER(pEntry);
+    PS_UNREFERENCED_PARAMETER(pThreadData);
+}
+
+//--------------------------------------------------------------------------
+/// Deleting a record only destroys it. The memory is reclaimed when the thread's trace data is cleared.
+//--------------------------------------------------------------------------
+void APIEntry::operator delete(void* pEntry)
+{
+    PS_UNREFERENCED_PARAMETER(pEntry);
 }
 
 //-----------------------------------------------------------------------------
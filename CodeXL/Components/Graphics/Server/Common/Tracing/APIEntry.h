@@ -13,6 +13,7 @@
 #include <string>
 
 enum FuncId : int;
+class ThreadTraceData;
 
 //-----------------------------------------------------------------------------
 /// List of parameter types used for the API trace parameters.
@@ -173,14 +174,34 @@ public:
     /// \param inThreadId The thread Id that the call was invoked from.
     /// \param inFuncId The function ID of this API call
     /// \param inNumParameters The number of params for this api call
+    /// \param pThreadData The trace data of the calling thread, whose arena holds the parameter buffer.
     //--------------------------------------------------------------------------
-    APIEntry(UINT inThreadId, FuncId inFuncId, UINT32 inNumParameters);
+    APIEntry(UINT inThreadId, FuncId inFuncId, UINT32 inNumParameters, ThreadTraceData* pThreadData);
 
     //--------------------------------------------------------------------------
     /// Virtual destructor since this is subclassed elsewhere.
     //--------------------------------------------------------------------------
     virtual ~APIEntry();
 
+    //--------------------------------------------------------------------------
+    /// APIEntry records are allocated from the arena of the thread they are traced in,
+    /// instead of the heap: new (pThreadData) DX12APIEntry(...).
+    /// \param inSize The size of the record.
+    /// \param pThreadData The trace data of the calling thread.
+    /// \returns Memory for the new record.
+    //--------------------------------------------------------------------------
+    static void* operator new(size_t inSize, ThreadTraceData* pThreadData);
+
+    //--------------------------------------------------------------------------
+    /// Matches the arena operator new, in case a constructor throws. The memory is reclaimed with the arena.
+    //--------------------------------------------------------------------------
+    static void operator delete(void* pEntry, ThreadTraceData* pThreadData);
+
+    //--------------------------------------------------------------------------
+    /// Deleting a record only destroys it. The memory is reclaimed when the thread's trace data is cleared.
+    //--------------------------------------------------------------------------
+    static void operator delete(void* pEntry);
+
     //--------------------------------------------------------------------------
     /// Use API-specific methods to determine the API name for this entry.
     //--------------------------------------------------------------------------
@@ -33,6 +33,20 @@ static bool sbTracingMultipleFrames = false;
 //-----------------------------------------------------------------------------
 static int sTracedFramesCount = 0;
 
+#ifdef WIN32
+    #define TRACE_THREAD_LOCAL __declspec(thread)
+#elif defined (_LINUX)
+    #define TRACE_THREAD_LOCAL __thread
+#endif
+
+//-----------------------------------------------------------------------------
+/// The calling thread's registered trace data, and the layer and thread Id it
+/// was registered for. Lets each traced call find its buffer without locking.
+//-----------------------------------------------------------------------------
+static TRACE_THREAD_LOCAL const MultithreadedTraceAnalyzerLayer* s_pThreadTraceOwner = nullptr;
+static TRACE_THREAD_LOCAL DWORD s_threadTraceId = 0;
+static TRACE_THREAD_LOCAL ThreadTraceData* s_pThreadTraceData = nullptr;
+
 //--------------------------------------------------------------------------
 /// MultithreadedTraceAnalyzerLayer's default constructor, which initializes CommandResponses.
 //--------------------------------------------------------------------------
@@ -64,8 +78,18 @@ MultithreadedTraceAnalyzerLayer::MultithreadedTraceAnalyzerLayer()
 //--------------------------------------------------------------------------
 MultithreadedTraceAnalyzerLayer::~MultithreadedTraceAnalyzerLayer()
 {
+    ScopeLock threadTraceLock(&mTraceMutex);
+
     // Destroy all of the buffered trace data.
-    ClearCPUThreadTraceData();
+    ThreadIdToTraceData::iterator threadIter;
+
+    for (threadIter = mThreadTraces.begin(); threadIter != mThreadTraces.end(); ++threadIter)
+    {
+        ThreadTraceData* traceData = threadIter->second;
+        SAFE_DELETE(traceData);
+    }
+
+    mThreadTraces.clear();
 }
 
 //--------------------------------------------------------------------------
@@ -249,6 +273,9 @@ void MultithreadedTraceAnalyzerLayer::EndFrame()
         ModernAPIFrameProfilerLayer* frameProfiler = GetParentLayerManager()->GetFrameProfilerLayer();
         frameProfiler->SetProfilingEnabled(false);
 
+        // Swap each thread over to its other buffer, so the frame's calls can be read while the threads keep logging.
+        RetireCPUThreadTraceData();
+
         AfterAPITrace();
         AfterGPUTrace();
 
@@ -368,24 +395,35 @@ bool MultithreadedTraceAnalyzerLayer::LoadTraceFile(const std::string& inTraceFi
 }
 
 //--------------------------------------------------------------------------
-/// Clear and destroy all of the traced thread data.
+/// Clear all of the traced thread data.
 //--------------------------------------------------------------------------
 void MultithreadedTraceAnalyzerLayer::ClearCPUThreadTraceData()
 {
-    if (!mThreadTraces.empty())
+    ScopeLock threadTraceLock(&mTraceMutex);
+
+    // Empty all thread trace buffers so we can start over on the next frame. The buffers stay registered
+    // with their threads, which keep logging to them without looking them up again.
+    ThreadIdToTraceData::iterator threadIter;
+
+    for (threadIter = mThreadTraces.begin(); threadIter != mThreadTraces.end(); ++threadIter)
     {
-        ScopeLock threadTraceLock(&mTraceMutex);
+        threadIter->second->Clear();
+    }
+}
 
-        // Kill all thread trace buffers so we can start over on the next frame, or just to shut the layer down.
-        std::unordered_map<DWORD, ThreadTraceData*>::iterator threadIter;
+//--------------------------------------------------------------------------
+/// Retire the calls that each thread logged during the traced frame, so that they
+/// can be read without racing the threads that logged them.
+//--------------------------------------------------------------------------
+void MultithreadedTraceAnalyzerLayer::RetireCPUThreadTraceData()
+{
+    ScopeLock threadTraceLock(&mTraceMutex);
 
-        for (threadIter = mThreadTraces.begin(); threadIter != mThreadTraces.end(); ++threadIter)
-        {
-            ThreadTraceData* traceData = threadIter->second;
-            SAFE_DELETE(traceData);
-        }
+    ThreadIdToTraceData::iterator threadIter;
 
-        mThreadTraces.clear();
+    for (threadIter = mThreadTraces.begin(); threadIter != mThreadTraces.end(); ++threadIter)
+    {
+        threadIter->second->RetireActiveBuffer();
     }
 }
 
@@ -655,14 +693,24 @@ std::string MultithreadedTraceAnalyzerLayer::GetAPITraceTXT()
     // Concatenate all of the logged call lines into a single string that we can send to the client.
     gtASCIIString appendString = "";
 
-    std::unordered_map<DWORD, ThreadTraceData*>::iterator traceIter;
+    // Merge the threads' buffers at the end of the frame.
+    ScopeLock threadTraceLock(&mTraceMutex);
+
+    ThreadIdToTraceData::iterator traceIter;
 
     for (traceIter = mThreadTraces.begin(); traceIter != mThreadTraces.end(); ++traceIter)
     {
         ThreadTraceData* currentTrace = traceIter->second;
-        const TimingLog& currentTimer = currentTrace->mAPICallTimer;
+        const TimingLog& currentTimer = currentTrace->GetAPICallTimings();
+        const std::vector<APIEntry*>& loggedCalls = currentTrace->GetLoggedCalls();
         GPS_TIMESTAMP timeFrequency = currentTimer.GetTimeFrequency();
-        size_t numEntries = currentTrace->mLoggedCallVector.size();
+        size_t numEntries = loggedCalls.size();
+
+        // Registered threads which didn't make any calls during the frame are left out.
+        if (numEntries == 0)
+        {
+            continue;
+        }
 
         // When using the updated trace format, include a preamble section for each traced thread.
 
@@ -692,7 +740,7 @@ std::string MultithreadedTraceAnalyzerLayer::GetAPITraceTXT()
             double deltaStartTime = (double)((callTiming.m_startTime.QuadPart - frameStartTime.QuadPart) * 1000.0) / dTimeFrequency;
             double deltaEndTime = (double)((callTiming.m_endTime.QuadPart - frameStartTime.QuadPart) * 1000.0) / dTimeFrequency;
 
-            const APIEntry* callEntry = currentTrace->mLoggedCallVector[entryIndex];
+            const APIEntry* callEntry = loggedCalls[entryIndex];
 
             // This exists as a sanity check. If a duration stretches past this point, we can be pretty sure something is messed up.
             // This signal value is basically random, with the goal of it being large enough to catch any obvious duration errors.
@@ -754,12 +802,13 @@ uint32 MultithreadedTraceAnalyzerLayer::GetNumTracedAPICalls()
     uint32 totalAPICalls = 0;
 
     // Step through each ThreadTraceData and add up the total number of API calls.
+    ScopeLock threadTraceLock(&mTraceMutex);
     ThreadIdToTraceData::iterator threadDataIter;
 
     for (threadDataIter = mThreadTraces.begin(); threadDataIter != mThreadTraces.end(); ++threadDataIter)
     {
         ThreadTraceData* traceData = threadDataIter->second;
-        totalAPICalls += static_cast<uint32>(traceData->mLoggedCallVector.size());
+        totalAPICalls += static_cast<uint32>(traceData->GetLoggedCalls().size());
     }
 
     return totalAPICalls;
@@ -774,17 +823,19 @@ uint32 MultithreadedTraceAnalyzerLayer::GetNumTracedDrawCalls()
     uint32 totalDrawCalls = 0;
 
     // Step through each ThreadTraceData and add up the total number of API calls.
+    ScopeLock threadTraceLock(&mTraceMutex);
     ThreadIdToTraceData::iterator threadDataIter;
 
     for (threadDataIter = mThreadTraces.begin(); threadDataIter != mThreadTraces.end(); ++threadDataIter)
     {
         ThreadTraceData* traceData = threadDataIter->second;
 
-        size_t numCalls = traceData->mLoggedCallVector.size();
+        const std::vector<APIEntry*>& loggedCalls = traceData->GetLoggedCalls();
+        size_t numCalls = loggedCalls.size();
 
         for (size_t callIndex = 0; callIndex < numCalls; ++callIndex)
         {
-            APIEntry* currentEntry = traceData->mLoggedCallVector[callIndex];
+            APIEntry* currentEntry = loggedCalls[callIndex];
 
             if (currentEntry->GatheredGpuTime())
             {
@@ -808,7 +859,7 @@ void MultithreadedTraceAnalyzerLayer::BeforeAPICall()
     // leave "this" traced function's start time in the per-thread data.
     DWORD threadId = osGetCurrentThreadId();
     ThreadTraceData* currentThreadData = FindOrCreateThreadData(threadId);
-    currentThreadData->m_startTime = currentThreadData->mAPICallTimer.GetRaw();
+    currentThreadData->m_startTime = mFramestartTimer.GetRaw();
 }
 
 //--------------------------------------------------------------------------
@@ -851,6 +902,7 @@ bool MultithreadedTraceAnalyzerLayer::VerifyUniqueTimestamps() const
     bool bAllUniqueTimestamps = true;
 
     // Step through all results and confirm that all timestamps are unique.
+    ScopeLock threadTraceLock(&mTraceMutex);
     ThreadIdToTraceData::const_iterator tracedThreadIter;
 
     for (tracedThreadIter = mThreadTraces.begin(); tracedThreadIter != mThreadTraces.end(); ++tracedThreadIter)
@@ -860,15 +912,16 @@ bool MultithreadedTraceAnalyzerLayer::VerifyUniqueTimestamps() const
 
         if (bAllUniqueTimestamps)
         {
-            std::vector<APIEntry*>& apiList = tracedThreadData->mLoggedCallVector;
+            const std::vector<APIEntry*>& apiList = tracedThreadData->GetLoggedCalls();
+            const TimingLog& apiTimings = tracedThreadData->GetAPICallTimings();
 
             // We can only verify if timestamps are unique if there are two or more calls in the traced thread's call vector.
             if (apiList.size() > 1)
             {
                 for (size_t apiIndex = 0; apiIndex < (apiList.size() - 1); ++apiIndex)
                 {
-                    const CallsTiming& currentTiming = tracedThreadData->mAPICallTimer.GetTimingByIndex(apiIndex);
-                    const CallsTiming& nextTiming = tracedThreadData->mAPICallTimer.GetTimingByIndex(apiIndex + 1);
+                    const CallsTiming& currentTiming = apiTimings.GetTimingByIndex(apiIndex);
+                    const CallsTiming& nextTiming = apiTimings.GetTimingByIndex(apiIndex + 1);
 
                     const bool startMatches = currentTiming.m_startTime.QuadPart == nextTiming.m_startTime.QuadPart;
                     const bool endMatches = currentTiming.m_endTime.QuadPart == nextTiming.m_endTime.QuadPart;
@@ -913,6 +966,12 @@ void MultithreadedTraceAnalyzerLayer::Clear()
 //--------------------------------------------------------------------------
 ThreadTraceData* MultithreadedTraceAnalyzerLayer::FindOrCreateThreadData(DWORD inThreadId)
 {
+    // A thread registers its trace data once, and finds it in its thread-local slot from then on.
+    if (s_pThreadTraceOwner == this && s_threadTraceId == inThreadId)
+    {
+        return s_pThreadTraceData;
+    }
+
     // Need to lock here to control access into our thread trace map
     ScopeLock mapInsertionLock(&mTraceMutex);
 
@@ -930,6 +989,13 @@ ThreadTraceData* MultithreadedTraceAnalyzerLayer::FindOrCreateThreadData(DWORD i
         mThreadTraces[inThreadId] = resultTraceData;
     }
 
+    if (inThreadId == osGetCurrentThreadId())
+    {
+        s_pThreadTraceOwner = this;
+        s_threadTraceId = inThreadId;
+        s_pThreadTraceData = resultTraceData;
+    }
+
     return resultTraceData;
 }
 
@@ -84,6 +84,14 @@ public:
     //--------------------------------------------------------------------------
     virtual void BeforeAPICall();
 
+    //--------------------------------------------------------------------------
+    /// Find thread-private trace data to dump logged calls into. Each thread's
+    /// data is registered once, and is looked up without locking afterwards.
+    /// \param inThreadId A ThreadId used to lookup or create a corresponding ThreadTraceData instance.
+    /// \returns A new or existing ThreadTraceData instance for use with a specific thread.
+    //--------------------------------------------------------------------------
+    ThreadTraceData* FindOrCreateThreadData(DWORD inThreadId);
+
     //--------------------------------------------------------------------------
     /// Invoked when the MultithreadedTraceAnalyzerLayer is created.
     /// \param inType The incoming type of interface being created.
@@ -222,10 +230,15 @@ protected:
     virtual std::string GetDerivedSettings() { return ""; }
 
     //--------------------------------------------------------------------------
-    /// Clear and destroy all ThreadTraceData instances.
+    /// Clear all ThreadTraceData instances. They stay registered with their threads.
     //--------------------------------------------------------------------------
     void ClearCPUThreadTraceData();
 
+    //--------------------------------------------------------------------------
+    /// Retire the calls each thread logged during the traced frame so they can be read.
+    //--------------------------------------------------------------------------
+    void RetireCPUThreadTraceData();
+
     //--------------------------------------------------------------------------
     /// Generate a trace info block that can be appended to the top of the trace. Included application and system information.
     /// \param outHeaderString A string containing the generated block of header text.
@@ -265,13 +278,6 @@ protected:
     //--------------------------------------------------------------------------
     void SendTraceFile(CommandResponse& cmdGPUTrace);
 
-    //--------------------------------------------------------------------------
-    /// Find thread-private trace data to dump logged calls into.
-    /// \param inThreadId A ThreadId used to lookup or create a corresponding ThreadTraceData instance.
-    /// \returns A new or existing ThreadTraceData instance for use with a specific thread.
-    //--------------------------------------------------------------------------
-    ThreadTraceData* FindOrCreateThreadData(DWORD inThreadId);
-
     //--------------------------------------------------------------------------
     /// Write a trace's metadata file and return the contenst through the out-param.
     /// \param inHeaderString The full response string for a collected linked trace request.
@@ -346,9 +352,10 @@ protected:
     ThreadIdToTraceData mThreadTraces;
 
     //--------------------------------------------------------------------------
-    /// Mutex used in cases where the mThreadTraces map can potentially change.
+    /// Mutex used when a thread registers its trace data in the mThreadTraces map,
+    /// and when the map is traversed at the frame boundaries.
     //--------------------------------------------------------------------------
-    mutex mTraceMutex;
+    mutable mutex mTraceMutex;
 
     //--------------------------------------------------------------------------
     /// A timer used to figure out what time the frame started at.
@@ -8,18 +8,209 @@
 
 #include "ThreadTraceData.h"
 #include "APIEntry.h"
+#include "../Logger.h"
+
+//--------------------------------------------------------------------------
+/// The size of each block of a thread's APIEntry arena.
+//--------------------------------------------------------------------------
+static const size_t s_ArenaBlockSize = 256 * 1024;
+
+//--------------------------------------------------------------------------
+/// The alignment of each allocation made from the arena.
+//--------------------------------------------------------------------------
+static const size_t s_ArenaAlignment = 16;
+
+//--------------------------------------------------------------------------
+/// Default constructor.
+//--------------------------------------------------------------------------
+ThreadTraceData::FrameBuffer::FrameBuffer()
+    : mFirstChunk(new CallChunk)
+    , mAppendCount(0)
+    , mCommittedCount(0)
+    , mReadCount(0)
+    , mArenaBlockIndex(0)
+    , mArenaBlockOffset(0)
+{
+    mFirstChunk->mNext = nullptr;
+    mAppendChunk = mFirstChunk;
+    mReadChunk = mFirstChunk;
+}
+
+//--------------------------------------------------------------------------
+/// Destroy the buffer's entries and rewind its arena, keeping the arena's blocks
+/// and the call chunks.
+//--------------------------------------------------------------------------
+void ThreadTraceData::FrameBuffer::Clear()
+{
+    // Invalidate all entries from the previous run.
+    CallChunk* pChunk = mFirstChunk;
+
+    for (size_t callIndex = 0; callIndex < mAppendCount; ++callIndex)
+    {
+        if (callIndex > 0 && (callIndex % s_CallChunkSize) == 0)
+        {
+            pChunk = pChunk->mNext;
+        }
+
+        // This instance isn't needed anymore, so destroy it. Its memory is reclaimed with the rest of the arena below.
+        APIEntry* thisEntry = pChunk->mCalls[callIndex % s_CallChunkSize].mEntry;
+        SAFE_DELETE(thisEntry);
+    }
+
+    mAppendChunk = mFirstChunk;
+    mAppendCount = 0;
+    mCommittedCount.store(0);
+    mReadChunk = mFirstChunk;
+    mReadCount = 0;
+
+    // Rewind the arena, keeping its blocks for the next traced frame.
+    mArenaBlockIndex = 0;
+    mArenaBlockOffset = 0;
+}
+
+//--------------------------------------------------------------------------
+/// Allocate memory from the buffer's arena.
+/// \param inSize The number of bytes to allocate.
+/// \returns A pointer to the allocated memory.
+//--------------------------------------------------------------------------
+void* ThreadTraceData::FrameBuffer::Allocate(size_t inSize)
+{
+    size_t alignedSize = (inSize + s_ArenaAlignment - 1) & ~(s_ArenaAlignment - 1);
+
+    // Move on to the next block when the current one is full.
+    if (mArenaBlockIndex < mArenaBlocks.size() && mArenaBlockOffset + alignedSize > mArenaBlocks[mArenaBlockIndex].mSize)
+    {
+        ++mArenaBlockIndex;
+        mArenaBlockOffset = 0;
+    }
+
+    // Add a new block when the arena is exhausted, or when the next block is too small for an unusually large record.
+    if (mArenaBlockIndex == mArenaBlocks.size() || alignedSize > mArenaBlocks[mArenaBlockIndex].mSize)
+    {
+        ArenaBlock newBlock;
+        newBlock.mSize = (alignedSize > s_ArenaBlockSize) ? alignedSize : s_ArenaBlockSize;
+        newBlock.mData = new char[newBlock.mSize];
+        mArenaBlocks.insert(mArenaBlocks.begin() + mArenaBlockIndex, newBlock);
+        mArenaBlockOffset = 0;
+    }
+
+    void* pAllocation = mArenaBlocks[mArenaBlockIndex].mData + mArenaBlockOffset;
+    mArenaBlockOffset += alignedSize;
+
+    return pAllocation;
+}
+
+//--------------------------------------------------------------------------
+/// Append a call to the end of the buffer. Only used by the owning thread.
+/// \param inCall The call to append.
+//--------------------------------------------------------------------------
+void ThreadTraceData::FrameBuffer::Append(const LoggedCall& inCall)
+{
+    size_t chunkOffset = mAppendCount % s_CallChunkSize;
+
+    // Move on to the next chunk when the current one is full, adding one if this is the last.
+    if (mAppendCount > 0 && chunkOffset == 0)
+    {
+        if (mAppendChunk->mNext == nullptr)
+        {
+            CallChunk* pNewChunk = new CallChunk;
+            pNewChunk->mNext = nullptr;
+            mAppendChunk->mNext = pNewChunk;
+        }
+
+        mAppendChunk = mAppendChunk->mNext;
+    }
+
+    mAppendChunk->mCalls[chunkOffset] = inCall;
+    ++mAppendCount;
+}
+
+//--------------------------------------------------------------------------
+/// Make the calls appended so far readable. Only used by the owning thread.
+//--------------------------------------------------------------------------
+void ThreadTraceData::FrameBuffer::Commit()
+{
+    // Releases the calls, and the chunk links leading to them, to the trace analyzer's GetCommittedCount.
+    mCommittedCount.store(mAppendCount, std::memory_order_release);
+}
+
+//--------------------------------------------------------------------------
+/// Get the number of calls committed so far. Only used by the trace analyzer.
+/// \returns The number of committed calls.
+//--------------------------------------------------------------------------
+size_t ThreadTraceData::FrameBuffer::GetCommittedCount() const
+{
+    // Acquires the calls, and the chunk links leading to them, released by Commit.
+    return mCommittedCount.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------------------
+/// Read the committed calls that haven't been read yet. Only used by the trace analyzer.
+/// \param inCommittedCount The number of committed calls, from GetCommittedCount.
+/// \param outLoggedCalls The list that the calls are added to.
+/// \param outAPICallTimer The timing log that the calls' timings are added to.
+//--------------------------------------------------------------------------
+void ThreadTraceData::FrameBuffer::ReadCommitted(size_t inCommittedCount, std::vector<APIEntry*>& outLoggedCalls, TimingLog& outAPICallTimer)
+{
+    // The owning thread only appends past the committed calls, and never moves them.
+    for (; mReadCount < inCommittedCount; ++mReadCount)
+    {
+        size_t chunkOffset = mReadCount % s_CallChunkSize;
+
+        if (mReadCount > 0 && chunkOffset == 0)
+        {
+            mReadChunk = mReadChunk->mNext;
+        }
+
+        const LoggedCall& thisCall = mReadChunk->mCalls[chunkOffset];
+        outAPICallTimer.Add(thisCall.mEntry->mThreadId, thisCall.mStartTime, thisCall.mEndTime);
+        outLoggedCalls.push_back(thisCall.mEntry);
+    }
+}
+
+//--------------------------------------------------------------------------
+/// Check for committed calls that haven't been read yet. Only used by the trace analyzer.
+/// \returns True if there are unread calls.
+//--------------------------------------------------------------------------
+bool ThreadTraceData::FrameBuffer::HasUnreadCalls() const
+{
+    return GetCommittedCount() != mReadCount;
+}
+
+//--------------------------------------------------------------------------
+/// Free the arena's blocks and the call chunks. The buffer must already be cleared.
+//--------------------------------------------------------------------------
+void ThreadTraceData::FrameBuffer::FreeBlocks()
+{
+    for (size_t blockIndex = 0; blockIndex < mArenaBlocks.size(); ++blockIndex)
+    {
+        SAFE_DELETE_ARRAY(mArenaBlocks[blockIndex].mData);
+    }
+
+    mArenaBlocks.clear();
+
+    while (mFirstChunk != nullptr)
+    {
+        CallChunk* pNextChunk = mFirstChunk->mNext;
+        SAFE_DELETE(mFirstChunk);
+        mFirstChunk = pNextChunk;
+    }
+
+    mAppendChunk = nullptr;
+    mReadChunk = nullptr;
+}
 
 //--------------------------------------------------------------------------
 /// Default constructor.
 //--------------------------------------------------------------------------
 ThreadTraceData::ThreadTraceData()
+    : mActiveBuffer(0)
+    , mPinnedBuffer(s_NoBuffer)
+    , mWriteBuffer(0)
+    , mPinDepth(0)
 {
     // Initialize this to known garbage so we can check it later. It should *always* be overwritten by real data.
     m_startTime.QuadPart = s_DummyTimestampValue;
-
-    // We should expect a lot of entries within this structure, so make it large enough up front.
-    // @PERFORMANCE @TODO: Do we really need to reserve space for APIEntries?
-    mLoggedCallVector.reserve(2048);
 }
 
 //--------------------------------------------------------------------------
@@ -27,7 +218,63 @@ ThreadTraceData::ThreadTraceData()
 //--------------------------------------------------------------------------
 ThreadTraceData::~ThreadTraceData()
 {
-    Clear();
+    // The owning thread is gone, or is no longer tracing, by the time its data is destroyed.
+    for (unsigned int bufferIndex = 0; bufferIndex < 2; ++bufferIndex)
+    {
+        mBuffers[bufferIndex].Clear();
+        mBuffers[bufferIndex].FreeBlocks();
+    }
+}
+
+//--------------------------------------------------------------------------
+/// Pin the buffer that the calling thread logs to. Called by the owning thread
+/// before an APIEntry is allocated, so that the buffer isn't recycled while the
+/// entry is being built and logged. Calls may be nested.
+//--------------------------------------------------------------------------
+void ThreadTraceData::BeginLoggingCall()
+{
+    if (mPinDepth++ > 0)
+    {
+        // An outer call already pinned the buffer, and nested calls log to it too.
+        return;
+    }
+
+    // Publish the pin, then check that the buffer is still the active one. The trace analyzer flips the
+    // active buffer before checking the pin, so either it sees this pin, or this thread sees the flip.
+    unsigned int bufferIndex = mActiveBuffer.load();
+
+    for (;;)
+    {
+        mPinnedBuffer.store(bufferIndex);
+
+        unsigned int activeIndex = mActiveBuffer.load();
+
+        if (activeIndex == bufferIndex)
+        {
+            break;
+        }
+
+        bufferIndex = activeIndex;
+    }
+
+    mWriteBuffer = bufferIndex;
+}
+
+//--------------------------------------------------------------------------
+/// Release the pin taken by the matching BeginLoggingCall. Called by the owning
+/// thread once it's finished with the APIEntry it logged.
+//--------------------------------------------------------------------------
+void ThreadTraceData::EndLoggingCall()
+{
+    PsAssert(mPinDepth > 0);
+
+    if (mPinDepth > 0 && --mPinDepth == 0)
+    {
+        // The outermost call is finished with its entries, including any logged by nested calls, so they can be
+        // read. They're committed before the pin is released, so a buffer that isn't pinned has nothing left to commit.
+        mBuffers[mWriteBuffer].Commit();
+        mPinnedBuffer.store(s_NoBuffer);
+    }
 }
 
 //--------------------------------------------------------------------------
@@ -38,26 +285,130 @@ ThreadTraceData::~ThreadTraceData()
 //--------------------------------------------------------------------------
 void ThreadTraceData::AddAPIEntry(GPS_TIMESTAMP inStartTime, GPS_TIMESTAMP inEndTime, APIEntry* inNewEntry)
 {
-    // Insert a new logged duration into the call timer.
-    mAPICallTimer.Add(inNewEntry->mThreadId, inStartTime, inEndTime);
+    PsAssert(mPinDepth > 0);
+
+    // The entry can still be updated until the outermost call ends, so it's only committed by EndLoggingCall.
+    LoggedCall newCall;
+    newCall.mEntry = inNewEntry;
+    newCall.mStartTime = inStartTime;
+    newCall.mEndTime = inEndTime;
+
+    mBuffers[mWriteBuffer].Append(newCall);
+}
+
+//--------------------------------------------------------------------------
+/// Allocate memory for an APIEntry record from the arena of the buffer that the
+/// owning thread is logging to. The memory is reclaimed all at once when the
+/// buffer is recycled.
+/// \param inSize The number of bytes to allocate.
+/// \returns A pointer to the allocated memory.
+//--------------------------------------------------------------------------
+void* ThreadTraceData::AllocateFromArena(size_t inSize)
+{
+    PsAssert(mPinDepth > 0);
+
+    return mBuffers[mWriteBuffer].Allocate(inSize);
+}
+
+//--------------------------------------------------------------------------
+/// Recycle a buffer so it can be logged to again. Fails if the owning thread
+/// still has the buffer pinned, or if it holds calls that haven't been read.
+/// \param inBufferIndex The index of the buffer to recycle.
+/// \returns True if the buffer was recycled.
+//--------------------------------------------------------------------------
+bool ThreadTraceData::RecycleBuffer(unsigned int inBufferIndex)
+{
+    // The buffer is never the active one here, so the owning thread can't pin it after this check.
+    if (mPinnedBuffer.load() == inBufferIndex)
+    {
+        return false;
+    }
+
+    // A call that was in flight when the buffer was last read has since been committed to it.
+    if (mBuffers[inBufferIndex].HasUnreadCalls())
+    {
+        return false;
+    }
 
-    // Now insert the APIEntry into the list of traced API calls for this thread.
-    mLoggedCallVector.push_back(inNewEntry);
+    mBuffers[inBufferIndex].Clear();
+    return true;
 }
 
 //--------------------------------------------------------------------------
-/// Clear all logged data in the thread's collection buffer.
+/// Collect the calls that the owning thread has finished logging so they can be
+/// read, and swap it over to the other buffer when that buffer can be recycled.
+/// Never waits for the owning thread. A call still in flight is read by the next
+/// call to RetireActiveBuffer or discarded by Clear. Must be called with the
+/// trace analyzer's trace lock held.
+/// \returns True if any logged calls were collected.
+//--------------------------------------------------------------------------
+bool ThreadTraceData::RetireActiveBuffer()
+{
+    // The calls collected last time are about to be destroyed when their buffer is recycled.
+    mReadLoggedCalls.clear();
+    mReadAPICallTimer.Clear();
+
+    unsigned int activeIndex = mActiveBuffer.load();
+    unsigned int nextIndex = 1 - activeIndex;
+
+    // Calls that start from now on log to the next buffer. If the next buffer can't be recycled yet, the
+    // thread keeps logging to the active one, and the swap is tried again next time.
+    if (RecycleBuffer(nextIndex))
+    {
+        mActiveBuffer.store(nextIndex);
+        activeIndex = nextIndex;
+    }
+
+    if (mPinnedBuffer.load() != s_NoBuffer)
+    {
+        Log(logMESSAGE, "A thread was inside a traced call when its calls were collected. That call is collected the next time the calls are collected.\n");
+    }
+
+    // Read the older buffer first, so the calls stay in the order they were logged. The owning thread commits a
+    // call to the older buffer before it starts logging to the active one, so counting the active buffer's calls
+    // first means that none of them can come before a call that's still missing from the older buffer.
+    FrameBuffer& olderBuffer = mBuffers[1 - activeIndex];
+    FrameBuffer& activeBuffer = mBuffers[activeIndex];
+    size_t activeCommittedCount = activeBuffer.GetCommittedCount();
+
+    olderBuffer.ReadCommitted(olderBuffer.GetCommittedCount(), mReadLoggedCalls, mReadAPICallTimer);
+    activeBuffer.ReadCommitted(activeCommittedCount, mReadLoggedCalls, mReadAPICallTimer);
+
+    return !mReadLoggedCalls.empty();
+}
+
+//--------------------------------------------------------------------------
+/// Clear all logged data in the thread's collection buffers. Must be called
+/// with the trace analyzer's trace lock held.
 //--------------------------------------------------------------------------
 void ThreadTraceData::Clear()
 {
-    // Invalidate all entries from the previous run.
-    for (size_t callIndex = 0; callIndex < mLoggedCallVector.size(); ++callIndex)
+    // Collect everything committed so far, so both buffers can be recycled once their calls in flight end.
+    RetireActiveBuffer();
+
+    if (!mReadLoggedCalls.empty())
     {
-        // This instance isn't needed anymore, so destroy it and reclaim pool memory.
-        APIEntry* thisEntry = mLoggedCallVector[callIndex];
-        SAFE_DELETE(thisEntry);
+        Log(logMESSAGE, "Discarding %u traced calls that were logged before the trace was cleared.\n", (unsigned int)mReadLoggedCalls.size());
     }
 
-    mLoggedCallVector.clear();
-    mAPICallTimer.Clear();
-}
\ No newline at end of file
+    mReadLoggedCalls.clear();
+    mReadAPICallTimer.Clear();
+}
+
+//--------------------------------------------------------------------------
+/// Retrieve the calls collected by the last call to RetireActiveBuffer.
+/// \returns The collected calls, or an empty list if there are none.
+//--------------------------------------------------------------------------
+const std::vector<APIEntry*>& ThreadTraceData::GetLoggedCalls() const
+{
+    return mReadLoggedCalls;
+}
+
+//--------------------------------------------------------------------------
+/// Retrieve the timings of the calls collected by the last call to RetireActiveBuffer.
+/// \returns The collected call timings, indexed the same way as GetLoggedCalls.
+//--------------------------------------------------------------------------
+const TimingLog& ThreadTraceData::GetAPICallTimings() const
+{
+    return mReadAPICallTimer;
+}
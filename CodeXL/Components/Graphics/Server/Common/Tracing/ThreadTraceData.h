@@ -12,6 +12,7 @@
 #include "../CommonTypes.h"
 #include "../TimingLog.h"
 #include <vector>
+#include <atomic>
 
 enum FuncId : int;
     class APIEntry;
@@ -39,6 +40,19 @@ public:
     //--------------------------------------------------------------------------
     virtual ~ThreadTraceData();
 
+    //--------------------------------------------------------------------------
+    /// Pin the buffer that the calling thread logs to. Called by the owning thread
+    /// before an APIEntry is allocated, so that the buffer isn't recycled while the
+    /// entry is being built and logged. Calls may be nested.
+    //--------------------------------------------------------------------------
+    void BeginLoggingCall();
+
+    //--------------------------------------------------------------------------
+    /// Release the pin taken by the matching BeginLoggingCall. Called by the owning
+    /// thread once it's finished with the APIEntry it logged.
+    //--------------------------------------------------------------------------
+    void EndLoggingCall();
+
     //--------------------------------------------------------------------------
     /// Insert the latest API call information into our list of traced calls.
     /// \param inStartTime The timestamp collected directly before the traced API call.
@@ -48,24 +62,202 @@ public:
     void AddAPIEntry(GPS_TIMESTAMP inStartTime, GPS_TIMESTAMP inEndTime, APIEntry* inNewEntry);
 
     //--------------------------------------------------------------------------
-    /// Clear all logged data in the thread's collection buffer.
+    /// Allocate memory for an APIEntry record from the arena of the buffer that the
+    /// owning thread is logging to. The memory is reclaimed all at once when the
+    /// buffer is recycled.
+    /// \param inSize The number of bytes to allocate.
+    /// \returns A pointer to the allocated memory.
+    //--------------------------------------------------------------------------
+    void* AllocateFromArena(size_t inSize);
+
+    //--------------------------------------------------------------------------
+    /// Collect the calls that the owning thread has finished logging so they can be
+    /// read, and swap it over to the other buffer when that buffer can be recycled.
+    /// Never waits for the owning thread. A call still in flight is read by the next
+    /// call to RetireActiveBuffer or discarded by Clear. Must be called with the
+    /// trace analyzer's trace lock held.
+    /// \returns True if any logged calls were collected.
+    //--------------------------------------------------------------------------
+    bool RetireActiveBuffer();
+
+    //--------------------------------------------------------------------------
+    /// Clear all logged data in the thread's collection buffers. Must be called
+    /// with the trace analyzer's trace lock held.
     //--------------------------------------------------------------------------
     void Clear();
 
+    //--------------------------------------------------------------------------
+    /// Retrieve the calls collected by the last call to RetireActiveBuffer.
+    /// \returns The collected calls, or an empty list if there are none.
+    //--------------------------------------------------------------------------
+    const std::vector<APIEntry*>& GetLoggedCalls() const;
+
+    //--------------------------------------------------------------------------
+    /// Retrieve the timings of the calls collected by the last call to RetireActiveBuffer.
+    /// \returns The collected call timings, indexed the same way as GetLoggedCalls.
+    //--------------------------------------------------------------------------
+    const TimingLog& GetAPICallTimings() const;
+
     //--------------------------------------------------------------------------
     /// The start time used in computing the total duration of a logged call.
     //--------------------------------------------------------------------------
     GPS_TIMESTAMP m_startTime;
 
+private:
+    //--------------------------------------------------------------------------
+    /// A block of memory that APIEntry records are allocated from.
+    //--------------------------------------------------------------------------
+    struct ArenaBlock
+    {
+        char* mData;    ///< The block's memory
+        size_t mSize;   ///< The size of the block in bytes
+    };
+
+    //--------------------------------------------------------------------------
+    /// The number of calls stored in each CallChunk.
+    //--------------------------------------------------------------------------
+    static const size_t s_CallChunkSize = 1024;
+
+    //--------------------------------------------------------------------------
+    /// A logged call and its timing.
+    //--------------------------------------------------------------------------
+    struct LoggedCall
+    {
+        APIEntry* mEntry;           ///< The logged call
+        GPS_TIMESTAMP mStartTime;   ///< The timestamp collected directly before the call
+        GPS_TIMESTAMP mEndTime;     ///< The timestamp collected directly after the call
+    };
+
+    //--------------------------------------------------------------------------
+    /// A fixed-size block of logged calls. Chunks are linked rather than stored in a
+    /// vector, so that appending never moves the calls the trace analyzer is reading.
+    //--------------------------------------------------------------------------
+    struct CallChunk
+    {
+        LoggedCall mCalls[s_CallChunkSize];   ///< The chunk's calls
+        CallChunk* mNext;                     ///< The next chunk, or nullptr
+    };
+
+    //--------------------------------------------------------------------------
+    /// One of the two buffers that a thread alternates between. The owning thread
+    /// appends calls to the end of the buffer and commits them once it's finished
+    /// with them, while the trace analyzer reads the committed calls.
+    //--------------------------------------------------------------------------
+    struct FrameBuffer
+    {
+        FrameBuffer();
+
+        //--------------------------------------------------------------------------
+        /// Destroy the buffer's entries and rewind its arena, keeping the arena's blocks
+        /// and the call chunks.
+        //--------------------------------------------------------------------------
+        void Clear();
+
+        //--------------------------------------------------------------------------
+        /// Allocate memory from the buffer's arena.
+        /// \param inSize The number of bytes to allocate.
+        /// \returns A pointer to the allocated memory.
+        //--------------------------------------------------------------------------
+        void* Allocate(size_t inSize);
+
+        //--------------------------------------------------------------------------
+        /// Append a call to the end of the buffer. Only used by the owning thread.
+        /// \param inCall The call to append.
+        //--------------------------------------------------------------------------
+        void Append(const LoggedCall& inCall);
+
+        //--------------------------------------------------------------------------
+        /// Make the calls appended so far readable. Only used by the owning thread.
+        //--------------------------------------------------------------------------
+        void Commit();
+
+        //--------------------------------------------------------------------------
+        /// Get the number of calls committed so far. Only used by the trace analyzer.
+        /// \returns The number of committed calls.
+        //--------------------------------------------------------------------------
+        size_t GetCommittedCount() const;
+
+        //--------------------------------------------------------------------------
+        /// Read the committed calls that haven't been read yet. Only used by the trace analyzer.
+        /// \param inCommittedCount The number of committed calls, from GetCommittedCount.
+        /// \param outLoggedCalls The list that the calls are added to.
+        /// \param outAPICallTimer The timing log that the calls' timings are added to.
+        //--------------------------------------------------------------------------
+        void ReadCommitted(size_t inCommittedCount, std::vector<APIEntry*>& outLoggedCalls, TimingLog& outAPICallTimer);
+
+        //--------------------------------------------------------------------------
+        /// Check for committed calls that haven't been read yet. Only used by the trace analyzer.
+        /// \returns True if there are unread calls.
+        //--------------------------------------------------------------------------
+        bool HasUnreadCalls() const;
+
+        //--------------------------------------------------------------------------
+        /// Free the arena's blocks and the call chunks. The buffer must already be cleared.
+        //--------------------------------------------------------------------------
+        void FreeBlocks();
+
+        CallChunk* mFirstChunk;                 ///< The first call chunk, kept when the buffer is cleared
+        CallChunk* mAppendChunk;                ///< The chunk that calls are appended to
+        size_t mAppendCount;                    ///< The number of calls appended
+        std::atomic<size_t> mCommittedCount;    ///< The number of calls committed, published by the owning thread
+        CallChunk* mReadChunk;                  ///< The chunk that calls are read from
+        size_t mReadCount;                      ///< The number of calls read
+        std::vector<ArenaBlock> mArenaBlocks;   ///< The arena's blocks, kept when the buffer is cleared
+        size_t mArenaBlockIndex;                ///< The index of the block currently being allocated from
+        size_t mArenaBlockOffset;               ///< The number of bytes already allocated from the current block
+    };
+
+    //--------------------------------------------------------------------------
+    /// Recycle a buffer so it can be logged to again. Fails if the owning thread
+    /// still has the buffer pinned, or if it holds calls that haven't been read.
+    /// \param inBufferIndex The index of the buffer to recycle.
+    /// \returns True if the buffer was recycled.
+    //--------------------------------------------------------------------------
+    bool RecycleBuffer(unsigned int inBufferIndex);
+
+    //--------------------------------------------------------------------------
+    /// The value of mPinnedBuffer when no buffer is pinned.
+    //--------------------------------------------------------------------------
+    static const unsigned int s_NoBuffer = 2;
+
+    //--------------------------------------------------------------------------
+    /// The two buffers that the owning thread alternates between.
+    //--------------------------------------------------------------------------
+    FrameBuffer mBuffers[2];
+
+    //--------------------------------------------------------------------------
+    /// The index of the buffer that new calls are logged to. Written by the trace
+    /// analyzer, read by the owning thread when it pins a buffer.
+    //--------------------------------------------------------------------------
+    std::atomic<unsigned int> mActiveBuffer;
+
+    //--------------------------------------------------------------------------
+    /// The index of the buffer that the owning thread is currently logging to, or
+    /// s_NoBuffer when it's between calls. Written by the owning thread, read by
+    /// the trace analyzer before it recycles a buffer.
+    //--------------------------------------------------------------------------
+    std::atomic<unsigned int> mPinnedBuffer;
+
+    //--------------------------------------------------------------------------
+    /// The buffer pinned by the outermost BeginLoggingCall. Only used by the owning thread.
+    //--------------------------------------------------------------------------
+    unsigned int mWriteBuffer;
+
+    //--------------------------------------------------------------------------
+    /// The nesting depth of BeginLoggingCall. Only used by the owning thread.
+    //--------------------------------------------------------------------------
+    unsigned int mPinDepth;
+
     //--------------------------------------------------------------------------
-    /// An array of logged timings that can be linked to a logged call.
+    /// The calls collected by the last call to RetireActiveBuffer. Only used with
+    /// the trace analyzer's trace lock held.
     //--------------------------------------------------------------------------
-    TimingLog mAPICallTimer;
+    std::vector<APIEntry*> mReadLoggedCalls;
 
     //--------------------------------------------------------------------------
-    /// Keep a list of InvocationData structure instances to keep track of CPU calls.
+    /// The timings of the calls in mReadLoggedCalls, linked to them by index.
     //--------------------------------------------------------------------------
-    std::vector<APIEntry*> mLoggedCallVector;
+    TimingLog mReadAPICallTimer;
 };
 
 #endif // THREADTRACEDATA_H
\ No newline at end of file
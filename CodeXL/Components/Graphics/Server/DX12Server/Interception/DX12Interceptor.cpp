@@ -13,6 +13,7 @@
 #include "Objects/DX12ObjectDatabaseProcessor.h"
 #include "Profiling/DX12FrameProfilerLayer.h"
 #include "Tracing/DX12APIEntry.h"
+#include "../../Common/Tracing/ThreadTraceData.h"
 
 #include "../Common/OSWrappers.h"
 #include <AMDTOSWrappers/Include/osFilePath.h>
@@ -46,8 +47,11 @@ DX12APIEntry* DX12Interceptor::PreCall(IUnknown* inWrappedInterface, FuncId inFu
 {
     DX12TraceAnalyzerLayer* pTraceAnalyzerLayer = DX12TraceAnalyzerLayer::Instance();
 
+    // The entry is allocated from the calling thread's trace arena, which stays pinned until PostCall is done with it.
     DWORD threadId = osGetCurrentThreadId();
-    DX12APIEntry* pNewEntry = new DX12APIEntry(threadId, inWrappedInterface, inFunctionId, inNumParameters, pParameters);
+    ThreadTraceData* pThreadData = pTraceAnalyzerLayer->FindOrCreateThreadData(threadId);
+    pThreadData->BeginLoggingCall();
+    DX12APIEntry* pNewEntry = new (pThreadData) DX12APIEntry(threadId, inWrappedInterface, inFunctionId, inNumParameters, pParameters, pThreadData);
 
     // Forward the info to the frame profiler for now. In the future, the DX12Interceptor won't exist, and this will be handled automatically.
     DX12FrameProfilerLayer* frameProfiler = static_cast<DX12FrameProfilerLayer*>(GetParentLayerManager()->GetFrameProfilerLayer());
@@ -82,4 +86,7 @@ void DX12Interceptor::PostCall(DX12APIEntry* pNewEntry, INT64 inReturnValue, Ret
     }
 
     pNewEntry->SetReturnValue(inReturnValue, inReturnValueFlags);
+
+    // The entry is complete, so its buffer can be retired.
+    pTraceAnalyzerLayer->FindOrCreateThreadData(pNewEntry->mThreadId)->EndLoggingCall();
 }
\ No newline at end of file
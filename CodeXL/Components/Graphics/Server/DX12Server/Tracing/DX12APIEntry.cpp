@@ -46,9 +46,10 @@ DX12APIEntry::DX12APIEntry(UINT inThreadId, IUnknown* inInterfaceWrapper, FuncId
 /// \param inFunctionId The FunctionId of the API call.
 /// \param inNumParameters The number of parameters used to invoke this API call.
 /// \param inParameters A ParameterEntry structure describing the parameter metadata for this API call.
+/// \param pThreadData The trace data of the calling thread, whose arena holds the parameters.
 //-----------------------------------------------------------------------------
-DX12APIEntry::DX12APIEntry(UINT inThreadId, IUnknown* inInterfaceWrapper, FuncId inFunctionId, UINT32 inNumParameters, ParameterEntry* inParameters)
-    : APIEntry(inThreadId, inFunctionId, inNumParameters)
+DX12APIEntry::DX12APIEntry(UINT inThreadId, IUnknown* inInterfaceWrapper, FuncId inFunctionId, UINT32 inNumParameters, ParameterEntry* inParameters, ThreadTraceData* pThreadData)
+    : APIEntry(inThreadId, inFunctionId, inNumParameters, pThreadData)
     , mWrapperInterface(inInterfaceWrapper)
     , mReturnValue(FUNCTION_RETURNS_VOID)
     , mReturnValueFlags(RETURN_VALUE_DECIMAL)
@@ -35,8 +35,9 @@ public:
     /// \param inFunctionId The FunctionId of the API call.
     /// \param inNumParameters The number of parameters used to invoke this API call.
     /// \param inParameters A ParameterEntry structure describing the parameter metadata for this API call.
+    /// \param pThreadData The trace data of the calling thread, whose arena holds the parameters.
     //-----------------------------------------------------------------------------
-    DX12APIEntry(UINT inThreadId, IUnknown* inInterfaceWrapper, FuncId inFunctionId, UINT32 inNumParameters, ParameterEntry* inParameters);
+    DX12APIEntry(UINT inThreadId, IUnknown* inInterfaceWrapper, FuncId inFunctionId, UINT32 inNumParameters, ParameterEntry* inParameters, ThreadTraceData* pThreadData);
 
     //-----------------------------------------------------------------------------
     /// Default destructor
@@ -480,8 +480,7 @@ void DX12TraceAnalyzerLayer::LogAPICall(DX12APIEntry* inAPIEntry)
 {
     GPS_TIMESTAMP endTime = mFramestartTimer.GetRaw();
 
-    ScopeLock logAPICallLock(&mTraceMutex);
-
+    // The calling thread logs to its own buffer, so no locking is needed.
     ThreadTraceData* currentThreadData = FindOrCreateThreadData(inAPIEntry->mThreadId);
 
     if (currentThreadData->m_startTime.QuadPart == s_DummyTimestampValue)
@@ -536,8 +535,11 @@ void DX12TraceAnalyzerLayer::OnPresent(UINT SyncInterval, UINT Flags)
 
         // postcall
         DWORD threadId = osGetCurrentThreadId();
-        DX12APIEntry* pNewEntry = new DX12APIEntry(threadId, nullptr, FuncId_IDXGISwapChain_Present, argumentsBuffer, result, RETURN_VALUE_DECIMAL);
+        ThreadTraceData* pThreadData = FindOrCreateThreadData(threadId);
+        pThreadData->BeginLoggingCall();
+        DX12APIEntry* pNewEntry = new (pThreadData) DX12APIEntry(threadId, nullptr, FuncId_IDXGISwapChain_Present, argumentsBuffer, result, RETURN_VALUE_DECIMAL);
         LogAPICall(pNewEntry);
+        pThreadData->EndLoggingCall();
     }
 }
 
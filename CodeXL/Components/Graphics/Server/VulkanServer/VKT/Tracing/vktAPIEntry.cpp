@@ -34,9 +34,10 @@ VktAPIEntry::VktAPIEntry(UINT inThreadId, FuncId inFunctionId, const std::string
 /// \param pParams A list of parameters for this call.
 /// \param paramCount The parameter count for this call.
 /// \param pWrappedCmdBuf The CommandBuffer affected by the API call.
+/// \param pThreadData The trace data of the calling thread, whose arena holds the parameters.
 //-----------------------------------------------------------------------------
-VktAPIEntry::VktAPIEntry(UINT inThreadId, FuncId inFunctionId, ParameterEntry* pParams, UINT32 paramCount, VktWrappedCmdBuf* pWrappedCmdBuf)
-    : APIEntry(inThreadId, inFunctionId, paramCount)
+VktAPIEntry::VktAPIEntry(UINT inThreadId, FuncId inFunctionId, ParameterEntry* pParams, UINT32 paramCount, VktWrappedCmdBuf* pWrappedCmdBuf, ThreadTraceData* pThreadData)
+    : APIEntry(inThreadId, inFunctionId, paramCount, pThreadData)
     , m_sampleId(0)
     , m_returnValue(VK_INCOMPLETE)
     , m_pWrappedCmdBuf(pWrappedCmdBuf)
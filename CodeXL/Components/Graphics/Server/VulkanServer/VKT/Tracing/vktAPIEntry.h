@@ -21,7 +21,7 @@ class VktAPIEntry : public APIEntry
 {
 public:
     VktAPIEntry(UINT inThreadId, FuncId inFunctionId, const std::string& inArguments, VktWrappedCmdBuf* pWrappedCmdBuf);
-    VktAPIEntry(UINT inThreadId, FuncId inFunctionId, ParameterEntry* pParams, UINT32 paramCount, VktWrappedCmdBuf* pWrappedCmdBuf);
+    VktAPIEntry(UINT inThreadId, FuncId inFunctionId, ParameterEntry* pParams, UINT32 paramCount, VktWrappedCmdBuf* pWrappedCmdBuf, ThreadTraceData* pThreadData);
 
     virtual ~VktAPIEntry() {}
 
@@ -17,9 +17,11 @@ VktAPIEntry* VktThreadTraceData::FindInvocationBySampleId(uint64 inSampleId)
 {
     VktAPIEntry* resultInvocation = nullptr;
 
-    for (unsigned int i = 0; i < mLoggedCallVector.size(); i++)
+    const std::vector<APIEntry*>& loggedCalls = GetLoggedCalls();
+
+    for (unsigned int i = 0; i < loggedCalls.size(); i++)
     {
-        VktAPIEntry* entry = static_cast<VktAPIEntry*>(mLoggedCallVector[i]);
+        VktAPIEntry* entry = static_cast<VktAPIEntry*>(loggedCalls[i]);
 
         if (entry->m_sampleId == inSampleId)
         {
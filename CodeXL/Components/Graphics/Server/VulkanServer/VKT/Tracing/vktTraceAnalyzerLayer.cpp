@@ -565,8 +565,7 @@ void VktTraceAnalyzerLayer::LogAPICall(VktAPIEntry* pApiEntry)
 {
     GPS_TIMESTAMP endTime = mFramestartTimer.GetRaw();
 
-    ScopeLock logAPICallLock(&mTraceMutex);
-
+    // The calling thread logs to its own buffer, so no locking is needed.
     ThreadTraceData* pCurrentThreadData = FindOrCreateThreadData(pApiEntry->mThreadId);
 
     UINT64 startTime = pCurrentThreadData->m_startTime.QuadPart;
@@ -612,7 +611,11 @@ void VktTraceAnalyzerLayer::OnPresent(VkQueue queue, const VkPresentInfoKHR* pPr
 
         // postcall
         DWORD threadId = osGetCurrentThreadId();
-        VktAPIEntry* pNewEntry = new VktAPIEntry(threadId, FuncId_vkQueuePresentKHR, parameters, ARRAY_SIZE(parameters), nullptr);
+        ThreadTraceData* pThreadData = FindOrCreateThreadData(threadId);
+
+        // PostCall releases the pin.
+        pThreadData->BeginLoggingCall();
+        VktAPIEntry* pNewEntry = new (pThreadData) VktAPIEntry(threadId, FuncId_vkQueuePresentKHR, parameters, ARRAY_SIZE(parameters), nullptr, pThreadData);
         pInterceptor->PostCall(pNewEntry);
     }
 }
@@ -12,6 +12,7 @@
 
 #include "vktInterceptManager.h"
 #include "Tracing/vktTraceAnalyzerLayer.h"
+#include "../../Common/Tracing/ThreadTraceData.h"
 #include "FrameDebugger/vktFrameDebuggerLayer.h"
 #include "Objects/vktObjectDatabaseProcessor.h"
 #include "Objects/vktInstanceBase.h"
@@ -151,8 +152,11 @@ VktAPIEntry* VktInterceptManager::PreCall(FuncId funcId, ParameterEntry* pParams
 {
     VktTraceAnalyzerLayer* pTraceAnalyzerLayer = VktTraceAnalyzerLayer::Instance();
 
+    // The entry is allocated from the calling thread's trace arena, which stays pinned until PostCall is done with it.
     DWORD threadId = osGetCurrentThreadId();
-    VktAPIEntry* pNewEntry = new VktAPIEntry(threadId, funcId, pParams, paramCount, pWrappedCmdBuf);
+    ThreadTraceData* pThreadData = pTraceAnalyzerLayer->FindOrCreateThreadData(threadId);
+    pThreadData->BeginLoggingCall();
+    VktAPIEntry* pNewEntry = new (pThreadData) VktAPIEntry(threadId, funcId, pParams, paramCount, pWrappedCmdBuf, pThreadData);
 
     if (pWrappedCmdBuf != nullptr)
     {
@@ -181,4 +185,7 @@ void VktInterceptManager::PostCall(VktAPIEntry* pNewEntry, int returnValue)
     }
 
     pNewEntry->SetReturnValue(returnValue);
+
+    // The entry is complete, so its buffer can be retired.
+    pTraceAnalyzerLayer->FindOrCreateThreadData(pNewEntry->mThreadId)->EndLoggingCall();
 }
@@ -11,6 +11,7 @@
 #include <thread>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include <AMDTOSWrappers/Include/osCriticalSection.h>
 #include <AMDTOSWrappers/Include/osCriticalSectionLocker.h>
@@ -24,7 +25,7 @@
 static bool g_isOnline = false;
 static PowerProfileTranslate* g_pTranslate = nullptr;
 static AMDTPwrProfileConfig g_currentCfg;
-static AMDTPwrProcessInfo g_pidInfo[MAX_PID_CNT];
+static std::vector<AMDTPwrProcessInfo> g_pidInfo;
 
 #ifdef LINUX
     #include <Linux/PwrProfTranslateLinux.h>
@@ -258,7 +259,9 @@ AMDTResult GetCummulativePidProfDataInstatant(AMDTUInt32* pPIDCount,
     else
     {
         AMDTUInt32 count = 0;
-        memset(g_pidInfo, 0, sizeof(AMDTUInt32) * MAX_PID_CNT);
+
+        // Any number of processes may have been sampled since the previous call
+        g_pidInfo.assign(entries, AMDTPwrProcessInfo());
 
         for (AMDTUInt32 idx = 0; idx < entries; ++idx)
         {
@@ -288,7 +291,7 @@ AMDTResult GetCummulativePidProfDataInstatant(AMDTUInt32* pPIDCount,
         if (AMD_PWR_ALL_PIDS == pidVal)
         {
             *pPIDCount = count;
-            *ppData = &g_pidInfo[0];
+            *ppData = g_pidInfo.data();
         }
         else
         {
@@ -21,7 +21,6 @@
 #define MAX_PHYSICAL_CORE_CNT (64)
 #define MAX_COUNTER_CNT (250)
 #define MAX_CU_CNT (2)
-#define MAX_PID_CNT (500)
 #define MAX_INSTANCE_CNT (32)
 #define MAX_BIN_CNT (10)
 #define MAX_CONFIG_CNT          (256)
@@ -245,7 +244,7 @@ typedef struct PowerData
     AMDTUInt32       m_numberOfPids;
     AMDTUInt64       m_sampleCnt;
     AMDTFloat32      m_totalIpc;
-    AMDTPwrProcessInfo  m_process[MAX_PID_CNT];
+    gtVector<AMDTPwrProcessInfo> m_process;  // m_numberOfPids processes
 } PowerData;
 
 typedef struct PwrCounterDecodeInfo
@@ -9,9 +9,14 @@
 #ifndef PWR_PROF_LINUX_DATATYPES_H_
 #define PWR_PROF_LINUX_DATATYPES_H_
 
+#include <vector>
+#include <map>
+#include <unordered_map>
+
 namespace PwrProfLinuxDatatypes
 {
-    #define PP_MAX_MODULE_COUNT (500)
+    // Maximum number of refreshes skipped for a process whose /proc/pid/maps does not change
+    #define PP_MAX_MAPS_REFRESH_DELAY (64)
 
     // Module information
     typedef struct ModInfo
@@ -22,21 +27,44 @@ namespace PwrProfLinuxDatatypes
         AMDTUInt64  m_moduleId;
     } ModInfo;
 
+    // Address range of a module in a process, the end address is inclusive
+    typedef struct ModRange
+    {
+        AMDTUInt64  m_startAddress = 0;
+        AMDTUInt64  m_endAddress = 0;
+        AMDTUInt64  m_moduleId = 0;
+    } ModRange;
+
+    // Sample which could not be attributed to a module until /proc/pid/maps is read again
+    typedef struct PendingSample
+    {
+        AMDTUInt64  m_ip = 0;
+        AMDTUInt32  m_threadId = 0;
+        AMDTUInt32  m_componentIdx = 0;
+        bool        m_isKernel = false;
+        AMDTFloat32 m_ipc = 0;
+    } PendingSample;
+
     // table of Process => modules in a process
     typedef struct ProcPidModInfo
     {
-        AMDTUInt64 m_processId;
-        std::vector<ModInfo> m_modInfoTable;
-
-        ProcPidModInfo()
-        {
-            m_modInfoTable.reserve(PP_MAX_MODULE_COUNT);
-        }
-
-        ~ProcPidModInfo()
-        {
-            m_modInfoTable.clear();
-        }
+        AMDTUInt64 m_processId = 0;
+
+        // executable mappings of the process, sorted by start address
+        std::vector<ModRange> m_modRangeTable;
+
+        // hash of the executable mappings read last time from /proc/pid/maps
+        AMDTUInt64 m_mapsHash = 0;
+
+        // samples waiting for /proc/pid/maps to be read again
+        std::vector<PendingSample> m_pendingSamples;
+
+        // number of refreshes to skip, grows while /proc/pid/maps does not change
+        AMDTUInt32 m_refreshDelay = 0;
+        AMDTUInt32 m_refreshWait = 0;
+
+        // samples which were still not in a module after the refresh
+        AMDTUInt64 m_droppedSampleCnt = 0;
     } ProcPidModInfo;
 
     // module profiling info
@@ -51,8 +79,8 @@ namespace PwrProfLinuxDatatypes
         AMDTFloat32 m_power;
     } ModuleSampleData;
 
-    using ProcPidModTable           = std::vector<ProcPidModInfo>;
-    using ProcPidModTableItr        = std::vector<ProcPidModInfo>::iterator;
+    using ProcPidModTable           = std::unordered_map<AMDTUInt64, ProcPidModInfo>;
+    using ProcPidModTableItr        = ProcPidModTable::iterator;
     using ModuleSampleDataMap       = std::map<AMDTUInt64, ModuleSampleData>;
     using ComponentModSampleTable   = std::vector<ModuleSampleDataMap>;
     using ModuleIdInfoMap           = std::map<AMDTUInt64, ModInfo>;
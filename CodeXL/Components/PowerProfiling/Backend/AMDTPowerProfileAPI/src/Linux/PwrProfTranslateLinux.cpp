@@ -4,6 +4,7 @@
 
 // System Headers
 #include <algorithm>
+#include <string>
 
 extern std::list <ProcessName> g_processNames;
 
@@ -204,6 +205,9 @@ AMDTResult PwrProfTranslateLinux::AttributePowerToSample()
     AMDTUInt64 timeSpan = 0;
     AMDTFloat32 load = 0;
 
+    // attribute the samples which were waiting for the module maps
+    RefreshProcPidMaps();
+
     try
     {
         for (AMDTUInt32 compIdx = 0; compIdx < m_phyCoreCnt; ++compIdx)
@@ -288,12 +292,6 @@ AMDTResult PwrProfTranslateLinux::ProcessSample(ContextData* pCtx, AMDTUInt32 co
     AMDTUInt64 rerdMOps = 0;
     AMDTUInt64 cpuNotHltd = 0;
 
-    if (MAX_PID_CNT < m_procPidModTable.size())
-    {
-        ret = AMDT_ERROR_UNEXPECTED;
-        PwrTrace("MAX_PID_CNT reached");
-    }
-
     if (PLATFORM_ZEPPELIN == GetSupportedTargetPlatformId())
     {
         rerdMOps = pCtx->m_pmcData[PMC_EVENT_RETIRED_MICRO_OPS];
@@ -313,31 +311,41 @@ AMDTResult PwrProfTranslateLinux::ProcessSample(ContextData* pCtx, AMDTUInt32 co
     }
 
     // search for the entry in /proc/pid/map details
-    auto pidFound = std::find_if(std::begin(m_procPidModTable),
-                                 std::end(m_procPidModTable),
-    [ = ](const ProcPidModInfo & args) { return (args.m_processId == pCtx->m_processId); });
+    auto pidFound = m_procPidModTable.find(pCtx->m_processId);
 
-    if (pidFound != m_procPidModTable.end())
+    if (pidFound == m_procPidModTable.end())
     {
-        if (AMDT_ERROR_FAIL == UpdateModuleSampleMap(pidFound->m_modInfoTable, pCtx, componentIdx, ipc))
-        {
-            // update module table
-            ReadProcPidMap(pCtx, *pidFound);
+        // insert an entry in process => module module map, the maps are read with the next refresh
+        ProcPidModInfo info;
+        info.m_processId = pCtx->m_processId;
+        pidFound = m_procPidModTable.insert({info.m_processId, std::move(info)}).first;
 
-            // update the sample module table again
-            UpdateModuleSampleMap(pidFound->m_modInfoTable, pCtx, componentIdx, ipc);
+        if (0 == pCtx->m_processId)
+        {
+            // the swapper process has no maps file
+            bool isChanged = false;
+            ReadProcPidMap(pidFound->second, isChanged);
         }
     }
-    else
+
+    ProcPidModInfo& info = pidFound->second;
+
+    if (AMDT_ERROR_FAIL == UpdateModuleSampleMap(info, pCtx->m_threadId, (0 != pCtx->m_isKernel), pCtx->m_ip, componentIdx, ipc))
     {
-        // insert an entry in process => module module map
-        ProcPidModInfo info;
-        info.m_processId = pCtx->m_processId;
-        ReadProcPidMap(pCtx, info);
-        m_procPidModTable.push_back(info);
+        // The module is not known yet, keep the sample until the module table is read again.
+        // /proc/pid/maps is not read here, but once per process for all its pending samples
+        if (info.m_pendingSamples.empty())
+        {
+            m_stalePidList.push_back(info.m_processId);
+        }
 
-        // insert an entry in sample map
-        UpdateModuleSampleMap(info.m_modInfoTable, pCtx, componentIdx, ipc);
+        PendingSample sample;
+        sample.m_ip = pCtx->m_ip;
+        sample.m_threadId = pCtx->m_threadId;
+        sample.m_componentIdx = componentIdx;
+        sample.m_isKernel = (0 != pCtx->m_isKernel);
+        sample.m_ipc = ipc;
+        info.m_pendingSamples.push_back(sample);
     }
 
     m_sampleIpcLoad[componentIdx] += ipc;
@@ -345,33 +353,60 @@ AMDTResult PwrProfTranslateLinux::ProcessSample(ContextData* pCtx, AMDTUInt32 co
     return ret;
 }
 
+// PwrMapsHash: FNV-1a hash of the given bytes
+static AMDTUInt64 PwrMapsHash(AMDTUInt64 hash, const void* pData, size_t size)
+{
+    const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+
+    for (size_t idx = 0; idx < size; idx++)
+    {
+        hash ^= pBytes[idx];
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
 //ReadProcPidMap : Read the /proc/$pid/maps file and populate process ==> module map
 //                  for each process
-AMDTResult PwrProfTranslateLinux::ReadProcPidMap(ContextData* pCtx, ProcPidModInfo& info)
+AMDTResult PwrProfTranslateLinux::ReadProcPidMap(ProcPidModInfo& info, bool& isChanged)
 {
     AMDTResult ret = AMDT_ERROR_FAIL;
+    isChanged = false;
 
-    if ((0 == pCtx->m_processId) && (m_isSwapperPid == false))
+    if (0 == info.m_processId)
     {
-        ModInfo moduleInfo;
-        memcpy(moduleInfo.m_pModulename, PP_UNKNOWN_MODULE, AMDT_PWR_EXE_NAME_LENGTH);
-
-        moduleInfo.m_startAddress = 0;
-        moduleInfo.m_endAddress = 0xFFFFFFFFFFFFFFFF;
-        moduleInfo.m_moduleId = m_moduleCnt;
-        m_moduleIdInfoMap.insert({m_moduleCnt, moduleInfo});
-        m_moduleCnt++;
-        info.m_modInfoTable.push_back(moduleInfo);
-        m_isSwapperPid = true;
+        if (info.m_modRangeTable.empty())
+        {
+            ModInfo moduleInfo;
+            memcpy(moduleInfo.m_pModulename, PP_UNKNOWN_MODULE, sizeof(PP_UNKNOWN_MODULE));
+
+            moduleInfo.m_startAddress = 0;
+            moduleInfo.m_endAddress = 0xFFFFFFFFFFFFFFFF;
+            moduleInfo.m_moduleId = m_moduleCnt;
+            m_moduleIdInfoMap.insert({m_moduleCnt, moduleInfo});
+            m_moduleCnt++;
+
+            ModRange range;
+            range.m_startAddress = moduleInfo.m_startAddress;
+            range.m_endAddress = moduleInfo.m_endAddress;
+            range.m_moduleId = moduleInfo.m_moduleId;
+            info.m_modRangeTable.push_back(range);
+            isChanged = true;
+        }
+
         ret = AMDT_STATUS_OK;
     }
     else
     {
         AMDTUInt64 modStartAddress = 0;
         AMDTUInt64 modEndAddress = 0;
+        AMDTUInt64 hash = 0xCBF29CE484222325ULL;
+        std::vector<ModRange> modRangeTable;
+        std::vector<std::string> modNames;
 
         char filename[OS_MAX_PATH];
-        snprintf(filename, sizeof(filename), "/proc/%d/maps", pCtx->m_processId);
+        snprintf(filename, sizeof(filename), "/proc/%llu/maps", static_cast<unsigned long long>(info.m_processId));
 
         // open /proc/pid/maps file
         FILE* fp = fopen(filename, "r");
@@ -423,56 +458,146 @@ AMDTResult PwrProfTranslateLinux::ReadProcPidMap(ContextData* pCtx, ProcPidModIn
                         continue;
                     }
 
-                    pBuffer += 3;
-
                     size = strlen(execName);
                     execName[size - 1] = '\0'; /* Remove \n*/
 
-                    auto found = std::find_if(std::begin(info.m_modInfoTable),
-                                              std::end(info.m_modInfoTable),
-                    [ = ](const ModInfo & args) {return ((modStartAddress == args.m_startAddress) && (modEndAddress == args.m_endAddress));});
+                    ModRange range;
+                    range.m_startAddress = modStartAddress;
+                    range.m_endAddress = modEndAddress;
+                    modRangeTable.push_back(range);
+                    modNames.push_back(execName);
 
-                    if (found == info.m_modInfoTable.end())
-                    {
-                        ModInfo moduleInfo;
-
-                        memcpy(moduleInfo.m_pModulename, execName, size);
-
-                        moduleInfo.m_startAddress = modStartAddress;
-                        moduleInfo.m_endAddress = modEndAddress;
-                        moduleInfo.m_moduleId = m_moduleCnt;
-                        m_moduleIdInfoMap.insert({m_moduleCnt, moduleInfo});
-                        m_moduleCnt++;
-                        info.m_modInfoTable.push_back(moduleInfo);
-                    }
+                    hash = PwrMapsHash(hash, &modStartAddress, sizeof(modStartAddress));
+                    hash = PwrMapsHash(hash, &modEndAddress, sizeof(modEndAddress));
+                    hash = PwrMapsHash(hash, execName, size);
                 }
             }
 
             ret = AMDT_STATUS_OK;
             fclose(fp);
         }
+
+        // Rebuild the module table only if the executable mappings changed
+        if ((AMDT_STATUS_OK == ret) && ((hash != info.m_mapsHash) || info.m_modRangeTable.empty()))
+        {
+            for (size_t idx = 0; idx < modRangeTable.size(); idx++)
+            {
+                ModRange& range = modRangeTable[idx];
+
+                // A module keeps its id as long as it stays mapped at the same addresses
+                auto found = std::lower_bound(info.m_modRangeTable.begin(),
+                                              info.m_modRangeTable.end(),
+                                              range.m_startAddress,
+                [](const ModRange & args, AMDTUInt64 address) { return args.m_startAddress < address; });
+
+                if ((found != info.m_modRangeTable.end())
+                    && (found->m_startAddress == range.m_startAddress)
+                    && (found->m_endAddress == range.m_endAddress))
+                {
+                    range.m_moduleId = found->m_moduleId;
+                }
+                else
+                {
+                    ModInfo moduleInfo;
+
+                    memset(moduleInfo.m_pModulename, 0, sizeof(moduleInfo.m_pModulename));
+                    memcpy(moduleInfo.m_pModulename, modNames[idx].c_str(), std::min(modNames[idx].size(), sizeof(moduleInfo.m_pModulename) - 1));
+
+                    moduleInfo.m_startAddress = range.m_startAddress;
+                    moduleInfo.m_endAddress = range.m_endAddress;
+                    moduleInfo.m_moduleId = m_moduleCnt;
+                    m_moduleIdInfoMap.insert({m_moduleCnt, moduleInfo});
+                    range.m_moduleId = m_moduleCnt;
+                    m_moduleCnt++;
+                }
+            }
+
+            std::sort(modRangeTable.begin(), modRangeTable.end(),
+            [](const ModRange & a, const ModRange & b) { return a.m_startAddress < b.m_startAddress; });
+
+            info.m_modRangeTable.swap(modRangeTable);
+            info.m_mapsHash = hash;
+            isChanged = true;
+        }
     }
 
     return ret;
 
 }
 
+// RefreshProcPidMaps: Read again the maps of the processes with unattributed samples,
+//                     and attribute those samples
+void PwrProfTranslateLinux::RefreshProcPidMaps()
+{
+    for (AMDTUInt64 pid : m_stalePidList)
+    {
+        auto pidFound = m_procPidModTable.find(pid);
+
+        if (pidFound == m_procPidModTable.end())
+        {
+            continue;
+        }
+
+        ProcPidModInfo& info = pidFound->second;
+        bool isRead = false;
+
+        if (0 == info.m_refreshWait)
+        {
+            bool isChanged = false;
+            isRead = true;
+
+            // Back off from processes which keep sampling outside of their modules (JIT code, exited process)
+            if ((AMDT_STATUS_OK == ReadProcPidMap(info, isChanged)) && isChanged)
+            {
+                info.m_refreshDelay = 0;
+            }
+            else
+            {
+                info.m_refreshDelay = (0 == info.m_refreshDelay) ? 1 : std::min(info.m_refreshDelay * 2, static_cast<AMDTUInt32>(PP_MAX_MAPS_REFRESH_DELAY));
+            }
+
+            info.m_refreshWait = info.m_refreshDelay;
+        }
+        else
+        {
+            info.m_refreshWait--;
+        }
+
+        // The samples were parked because they are outside of the known modules, so while the
+        // process is backed off they stay outside of them. Samples still not in a module are dropped.
+        for (const PendingSample& sample : info.m_pendingSamples)
+        {
+            if (!isRead || (AMDT_ERROR_FAIL == UpdateModuleSampleMap(info, sample.m_threadId, sample.m_isKernel, sample.m_ip, sample.m_componentIdx, sample.m_ipc)))
+            {
+                info.m_droppedSampleCnt++;
+                m_droppedSampleCnt++;
+            }
+        }
+
+        info.m_pendingSamples.clear();
+    }
+
+    m_stalePidList.clear();
+}
+
 // UpdateModuleSampleMap: Update the moduleId ==> moduleInfo map for each sample collected
-AMDTResult PwrProfTranslateLinux::UpdateModuleSampleMap(const std::vector<ModInfo>& modInfoTable,
-                                                        ContextData* pCtx,
+AMDTResult PwrProfTranslateLinux::UpdateModuleSampleMap(const ProcPidModInfo& info,
+                                                        AMDTUInt32 threadId,
+                                                        bool isKernel,
+                                                        AMDTUInt64 ip,
                                                         AMDTUInt32 componentIdx,
                                                         AMDTFloat32 ipc)
 {
     AMDTResult ret = AMDT_STATUS_OK;
-    AMDTUInt64 ip = pCtx->m_ip;
+    const std::vector<ModRange>& modRangeTable = info.m_modRangeTable;
 
-    // true if IP lies within address range
-    auto comp = [ = ](const ModInfo & args) {return ((ip >= args.m_startAddress) && (ip <= args.m_endAddress));};
+    // last module which starts at or below the ip
+    auto moduleTableItr = std::upper_bound(modRangeTable.begin(),
+                                           modRangeTable.end(),
+                                           ip,
+    [](AMDTUInt64 address, const ModRange & args) { return address < args.m_startAddress; });
 
-    //search process ==> module table for ip entry
-    auto moduleTableItr  = std::find_if(std::begin(modInfoTable), std::end(modInfoTable), comp);
-
-    if (moduleTableItr != modInfoTable.end())
+    if ((moduleTableItr != modRangeTable.begin()) && (ip <= (--moduleTableItr)->m_endAddress))
     {
         try
         {
@@ -490,10 +615,10 @@ AMDTResult PwrProfTranslateLinux::UpdateModuleSampleMap(const std::vector<ModInf
             else
             {
                 ModuleSampleData sampleData;
-                sampleData.m_processId  = pCtx->m_processId;
-                sampleData.m_threadId   = pCtx->m_threadId;
-                sampleData.m_isKernel   = pCtx->m_isKernel;
-                sampleData.m_ip         = pCtx->m_ip;
+                sampleData.m_processId  = static_cast<AMDTUInt32>(info.m_processId);
+                sampleData.m_threadId   = threadId;
+                sampleData.m_isKernel   = isKernel;
+                sampleData.m_ip         = ip;
                 sampleData.m_ipc        = ipc;
                 sampleData.m_sampleCnt  = 1;
                 moduleMapItr.insert({moduleTableItr->m_moduleId, sampleData});
@@ -502,7 +627,7 @@ AMDTResult PwrProfTranslateLinux::UpdateModuleSampleMap(const std::vector<ModInf
         catch (const std::out_of_range& oor)
         {
             PwrTrace("Out of range.");
-            ret = AMDT_ERROR_FAIL;
+            ret = AMDT_ERROR_UNEXPECTED;
         }
     }
     else
@@ -517,8 +642,25 @@ AMDTResult PwrProfTranslateLinux::UpdateModuleSampleMap(const std::vector<ModInf
 // CleanupModuleMap: cleanup process profiling structures
 void PwrProfTranslateLinux::CleanupModuleMap()
 {
+    if (0 != m_droppedSampleCnt)
+    {
+        PwrTrace("%llu samples dropped outside of the known modules", static_cast<unsigned long long>(m_droppedSampleCnt));
+
+        for (const auto& pidItr : m_procPidModTable)
+        {
+            if (0 != pidItr.second.m_droppedSampleCnt)
+            {
+                PwrTrace("pid %llu: %llu samples dropped", static_cast<unsigned long long>(pidItr.first),
+                         static_cast<unsigned long long>(pidItr.second.m_droppedSampleCnt));
+            }
+        }
+    }
+
+    m_droppedSampleCnt = 0;
+
     // clear the maps
     m_procPidModTable.clear();
+    m_stalePidList.clear();
     m_modSampleDataTable.clear();
     m_moduleIdInfoMap.clear();
     m_moduleCnt = 0;
@@ -40,11 +40,17 @@ private:
 
     //ReadProcPidMap : Read the /proc/$pid/maps file and populate process ==> module map
     //                  for each process
-    AMDTResult ReadProcPidMap(ContextData* pCtx, ProcPidModInfo& info);
+    AMDTResult ReadProcPidMap(ProcPidModInfo& info, bool& isChanged);
+
+    // RefreshProcPidMaps: Read again the maps of the processes with unattributed samples,
+    //                     and attribute those samples
+    void RefreshProcPidMaps();
 
     // UpdateModuleSampleMap: Update the moduleId ==> moduleInfo map for each sample collected
-    AMDTResult UpdateModuleSampleMap(const std::vector<ModInfo>& modInfoTable,
-                                     ContextData* pCtx,
+    AMDTResult UpdateModuleSampleMap(const ProcPidModInfo& info,
+                                     AMDTUInt32 threadId,
+                                     bool isKernel,
+                                     AMDTUInt64 ip,
                                      AMDTUInt32 componentIdx,
                                      AMDTFloat32 ipc);
 
@@ -56,10 +62,13 @@ private:
 
     // DATA MEMBERS
 
-    // Each process id maps to a vector of module contained by that process
+    // Each process id maps to the sorted address ranges of the modules contained by that process
     // process_id ==> module info maps
     ProcPidModTable m_procPidModTable;
 
+    // Processes with samples waiting for their /proc/pid/maps to be read again
+    std::vector<AMDTUInt64> m_stalePidList;
+
     // Maps all modules of their respective components
     // component number ==> module id ==> sample data of module
     ComponentModSampleTable m_modSampleDataTable;
@@ -74,8 +83,8 @@ private:
     // total number of modules during profing
     AMDTUInt64 m_moduleCnt = 0;
 
-    // set once when module inserted for swapper process (pid = 0)
-    bool m_isSwapperPid = false;
+    // total number of samples which were never attributed to a module
+    AMDTUInt64 m_droppedSampleCnt = 0;
 };
 
 #endif
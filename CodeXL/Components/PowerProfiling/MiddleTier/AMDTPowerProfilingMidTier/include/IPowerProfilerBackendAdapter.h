@@ -20,6 +20,7 @@
 
 // Common DB related structures
 #include <AMDTCommonHeaders/AMDTCommonProfileDataTypes.h>
+#include <AMDTPowerProfilingMidTier/include/PPSamplesRing.h>
 
 // Currently include the API header through a hard-coded path.
 // Should be updated.
@@ -53,7 +54,10 @@ public:
     virtual PPResult DisableCounter(int counterId) = 0;
     virtual PPResult SetTimerSamplingInterval(unsigned int interval) = 0;
     virtual PPResult CloseProfileSession() = 0;
-    virtual PPResult ReadAllEnabledCounters(gtVector<AMDTProfileTimelineSample*>& buffer) = 0;
+
+    // Reads the samples taken since the last call into buffer.
+    // The samples are taken from samplesRing, which owns them.
+    virtual PPResult ReadAllEnabledCounters(PPSamplesRing& samplesRing, gtVector<AMDTProfileTimelineSample*>& buffer) = 0;
 
     // Error handling.
     virtual void GetLastErrorMessage(gtString& msg) = 0;
@@ -57,7 +57,7 @@ public:
 
     virtual PPResult CloseProfileSession();
 
-    virtual PPResult ReadAllEnabledCounters(gtVector<AMDTProfileTimelineSample*>& buffer);
+    virtual PPResult ReadAllEnabledCounters(PPSamplesRing& samplesRing, gtVector<AMDTProfileTimelineSample*>& buffer);
 
     virtual PPResult SetApplicationLaunchDetails(const ApplicationLaunchDetails& appLaunchDetails);
 
@@ -10,6 +10,7 @@
 #define PPPollingThread_h__
 //std
 #include <condition_variable>
+#include <memory>
 
 //Infra
 #include <AMDTOSWrappers/Include/osThread.h>
@@ -17,11 +18,29 @@
 //Local
 #include <AMDTPowerProfilingMidTier/include/PowerProfilerDefs.h>
 #include <AMDTPowerProfilingMidTier/include/IPowerProfilerBackendAdapter.h>
+#include <AMDTPowerProfilingMidTier/include/PPSamplesRing.h>
 #include <AMDTDbAdapter/inc/AMDTProfileDbAdapter.h>
 
 // Forward declarations.
 enum AppLaunchStatus;
 
+// Timing statistics of the polling ticks.
+// The lateness of a tick is the time between its deadline and the time the polling thread woke up.
+struct PPPollingJitterStats
+{
+    PPPollingJitterStats() : m_numOfTicks(0), m_numOfMissedTicks(0), m_maxLatenessUs(0), m_totalLatenessUs(0) {}
+
+    // The number of ticks which were polled.
+    unsigned m_numOfTicks;
+
+    // The number of deadlines which were skipped since the previous tick ended after them.
+    unsigned m_numOfMissedTicks;
+
+    // The maximal and total lateness of the ticks, in microseconds.
+    AMDTUInt64 m_maxLatenessUs;
+    AMDTUInt64 m_totalLatenessUs;
+};
+
 class PPPollingThread :
     public osThread
 {
@@ -46,6 +65,9 @@ public:
     AppLaunchStatus GetApplicationLaunchStatus() const { return m_targetAppLaunchStatus; }
     void requestExit() { m_IsStopped = true; }
 
+    // The timing statistics of the session, valid once the thread ended.
+    const PPPollingJitterStats& GetJitterStats() const { return m_jitterStats; }
+
 protected:
     virtual void beforeTermination() override;
 private:
@@ -69,6 +91,15 @@ private:
     bool m_IsStopped = false;
     bool m_profilingErr;
     PPResult m_profResult;
+
+    // The samples read from the backend, reused in each tick.
+    PPSamplesRing m_samplesRing;
+    gtVector<AMDTProfileTimelineSample*> m_samplesBuffer;
+
+    // The sample values per counter passed to the data callback, reused as long as the callback does not keep it.
+    std::shared_ptr<gtMap<int, PPSampledValuesBatch>> m_pCounterIdToSampleMap;
+
+    PPPollingJitterStats m_jitterStats;
 };
 
 #endif // PPPollingThread_h__
@@ -0,0 +1,45 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file PPSamplesRing.h
+///
+//==================================================================================
+
+#ifndef PPSamplesRing_h__
+#define PPSamplesRing_h__
+
+// Infra.
+#include <AMDTBaseTools/Include/gtVector.h>
+
+// Common DB related structures
+#include <AMDTCommonHeaders/AMDTCommonProfileDataTypes.h>
+
+// A ring of preallocated timeline samples.
+// The samples read in a polling tick are taken from the ring, and the ring is rewound
+// before the next tick. The same sample objects, and the memory of their values, are
+// therefore reused for the whole session.
+class PPSamplesRing
+{
+public:
+    explicit PPSamplesRing(size_t initialCapacity);
+    ~PPSamplesRing();
+
+    // Makes all the samples of the ring available again.
+    // The samples which were acquired before must not be used anymore.
+    void Rewind() { m_nextSample = 0; }
+
+    // Returns the next available sample. The ring grows if all its samples are in use.
+    AMDTProfileTimelineSample* Acquire();
+
+    size_t GetCapacity() const { return m_samples.size(); }
+
+private:
+    PPSamplesRing(const PPSamplesRing&);
+    PPSamplesRing& operator=(const PPSamplesRing&);
+
+    gtVector<AMDTProfileTimelineSample*> m_samples;
+    size_t m_nextSample;
+};
+
+#endif // PPSamplesRing_h__
@@ -15,6 +15,7 @@
 // Infra.
 #include <AMDTBaseTools/Include/gtString.h>
 #include <AMDTBaseTools/Include/gtVector.h>
+#include <AMDTOSWrappers/Include/osCriticalSection.h>
 
 // Common DB related structures
 #include <AMDTCommonHeaders/AMDTCommonProfileDataTypes.h>
@@ -26,7 +27,7 @@ class RemoteBackendAdapter :
     public IPowerProfilerBackendAdapter
 {
 public:
-    RemoteBackendAdapter() {};
+    RemoteBackendAdapter() : m_isProfilingActive(false) {};
     virtual ~RemoteBackendAdapter();
 
     // Set the address of the remote target.
@@ -64,7 +65,7 @@ public:
 
     virtual PPResult CloseProfileSession();
 
-    virtual PPResult ReadAllEnabledCounters(gtVector<AMDTProfileTimelineSample*>& buffer);
+    virtual PPResult ReadAllEnabledCounters(PPSamplesRing& samplesRing, gtVector<AMDTProfileTimelineSample*>& buffer);
 
     virtual PPResult SetApplicationLaunchDetails(const ApplicationLaunchDetails& appLaunchDetails);
 
@@ -73,11 +74,20 @@ public:
     virtual void GetLastErrorMessage(gtString& msg);
 
 private:
+    // Stop streaming the samples, so that other requests can be sent to the remote agent.
+    // Must be called while holding m_requestLock.
+    void StopSamplesStream();
+
     gtString m_remoteHostName;
     unsigned short m_remoteTargetPort;
     ApplicationLaunchDetails m_appLaunchDetails;
     AppLaunchStatus m_appLaunchStatus;
     gtString m_lastErrorMsg;
+
+    // While profiling, the samples are streamed by the remote agent. The stream is started by the polling
+    // thread, and is stopped before any other request is sent, which are serialized by this lock.
+    osCriticalSection m_requestLock;
+    bool m_isProfilingActive;
 };
 
 #endif // __RemoteBackendAdapter_h
@@ -228,7 +228,9 @@ bool BackendDataConvertor::AMDTPwrSampleToPPSample(const AMDTPwrSample* pSample,
 
             // Copy the values from the BE's memory to ours, as that memory will
             // be overridden with the next read operation invocation.
+            // The buffer may be a reused sample: keep its memory, but not its values.
             gtVector<AMDTProfileCounterValue>& bufferSampleVals = buffer.m_sampleValues;
+            bufferSampleVals.clear();
             bufferSampleVals.reserve(numOfValues);
 
             for (size_t i = 0; i < numOfValues; ++i)
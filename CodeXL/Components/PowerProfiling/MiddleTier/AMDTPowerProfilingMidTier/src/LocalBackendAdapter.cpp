@@ -403,7 +403,7 @@ PPResult LocalBackendAdapter::CloseProfileSession()
     return ret;
 }
 
-PPResult LocalBackendAdapter::ReadAllEnabledCounters(gtVector<AMDTProfileTimelineSample*>& buffer)
+PPResult LocalBackendAdapter::ReadAllEnabledCounters(PPSamplesRing& samplesRing, gtVector<AMDTProfileTimelineSample*>& buffer)
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
 
@@ -448,7 +448,7 @@ PPResult LocalBackendAdapter::ReadAllEnabledCounters(gtVector<AMDTProfileTimelin
             // object in our container of samples to use an output.
             for (size_t i = 0; i < numOfSamples; ++i)
             {
-                AMDTProfileTimelineSample* pCurrSample = new AMDTProfileTimelineSample();
+                AMDTProfileTimelineSample* pCurrSample = samplesRing.Acquire();
                 const AMDTPwrSample* pCurrBeSample = (pSamples + i);
                 BackendDataConvertor::AMDTPwrSampleToPPSample(pCurrBeSample, *pCurrSample);
                 buffer.push_back(pCurrSample);
@@ -18,6 +18,14 @@
 
 // C++.
 #include <memory>
+#include <chrono>
+#include <thread>
+
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+    #include <Windows.h>
+    #include <mmsystem.h>
+    #pragma comment(lib, "winmm.lib")
+#endif
 
 // Remote.
 #include <AMDTRemoteClient/Include/CXLDaemonClient.h>
@@ -25,6 +33,14 @@
 // The following value should be the same as PP_MAX_SAMPLING_INTERVAL defined in ppAppController.h
 #define MAX_POLLING_INTERVAL_MILLISECONDS 2000
 
+// The number of samples preallocated in the samples ring
+#define SAMPLES_RING_INITIAL_CAPACITY 64
+
+// Below this polling interval, the timer resolution of the OS is raised for the session
+#define HIGH_RESOLUTION_POLLING_INTERVAL_MILLISECONDS 16
+
+typedef std::chrono::steady_clock PPPollingClock;
+
 PPPollingThread::PPPollingThread(unsigned pollingInterval, PPSamplesDataHandler cb, void* pDataCbParams, PPFatalErrorHandler cbErr, void* pErrorCbParams, IPowerProfilerBackendAdapter* pBeAdapter, amdtProfileDbAdapter* pDataAdapter)
     : osThread(L"PowerProfilingPollingThread")
       // Verify that the polling interval is valid
@@ -40,7 +56,11 @@ PPPollingThread::PPPollingThread(unsigned pollingInterval, PPSamplesDataHandler
     , m_targetAppLaunchStatus(rasUnknown)
     , m_profilingErr(false)
     , m_profResult(PPR_NO_ERROR)
+    , m_samplesRing(SAMPLES_RING_INITIAL_CAPACITY)
+    , m_pCounterIdToSampleMap(new gtMap<int, PPSampledValuesBatch>())
 {
+    m_samplesBuffer.reserve(SAMPLES_RING_INITIAL_CAPACITY);
+
     GT_ASSERT_EX((pollingInterval > 0 && pollingInterval <= MAX_POLLING_INTERVAL_MILLISECONDS), L"Invalid PP Polling interval");
     GT_ASSERT_EX((m_dataCb != NULL), L"Invalid PPSamplesDataHandler");
     GT_ASSERT_EX((m_errorCb != NULL), L"Invalid PPFatalErrorHandler");
@@ -55,6 +75,13 @@ static void CreateCounterToSampleMap(const AMDTProfileTimelineSample& beSample,
     const gtVector<AMDTProfileCounterValue>& beValsVector = beSample.m_sampleValues;
     const AMDTUInt32 elapsedTimeMs = (AMDTUInt32)beSample.m_sampleElapsedTimeMs;
 
+    // The map may hold the batches of the previous sample: reuse them, keeping the memory of their values.
+    for (auto& batch : outMap)
+    {
+        batch.second.m_quantizedTime = elapsedTimeMs;
+        batch.second.m_sampleValues.clear();
+    }
+
     for (size_t i = 0; i < beValsVector.size(); ++i)
     {
         AMDTUInt32 currCounterId = beValsVector[i].m_counterId;
@@ -68,7 +95,20 @@ static void CreateCounterToSampleMap(const AMDTProfileTimelineSample& beSample,
         }
 
         // Add the value to the counter's sampled values batch.
-        outMap[currCounterId].m_sampleValues.push_back(beValsVector[i].m_counterValue);
+        iter->second.m_sampleValues.push_back(beValsVector[i].m_counterValue);
+    }
+
+    // Remove the batches of the counters which are not part of this sample.
+    for (auto iter = outMap.begin(); iter != outMap.end();)
+    {
+        if (iter->second.m_sampleValues.empty())
+        {
+            outMap.erase(iter++);
+        }
+        else
+        {
+            ++iter;
+        }
     }
 }
 
@@ -87,9 +127,6 @@ int PPPollingThread::entryPoint()
 
         GT_IF_WITH_ASSERT(rc < PPR_FIRST_ERROR)
         {
-            // A buffer to hold the samples.
-            gtVector<AMDTProfileTimelineSample*> samplesBuffer;
-
             // Num of ticks.
             unsigned numOfTicks = 1;
 
@@ -106,18 +143,52 @@ int PPPollingThread::entryPoint()
                 timeFactor += 30;
             }
 
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+            // The default timer resolution of Windows is too coarse for short polling intervals.
+            const bool isHighResolutionTimer = (m_pollingInterval < HIGH_RESOLUTION_POLLING_INTERVAL_MILLISECONDS) && (timeBeginPeriod(1) == TIMERR_NOERROR);
+#endif
+
+            // The ticks are scheduled on absolute deadlines, so that the time spent
+            // in a tick does not delay the following ones.
+            const std::chrono::milliseconds pollingInterval(m_pollingInterval);
+            PPPollingClock::time_point deadline = PPPollingClock::now();
+            unsigned tickIndex = 0;
+
             // Poll for new data until we get killed.
             while (m_IsStopped == false)
             {
-                // Sleep for the polling interval.
-                osSleep(m_pollingInterval);
+                // Sleep until the next deadline.
+                deadline += pollingInterval;
+                ++tickIndex;
+                std::this_thread::sleep_until(deadline);
+
+                // Update the jitter statistics.
+                PPPollingClock::duration lateness = PPPollingClock::now() - deadline;
+                AMDTUInt64 latenessUs = static_cast<AMDTUInt64>(std::chrono::duration_cast<std::chrono::microseconds>(lateness).count());
+                m_jitterStats.m_numOfTicks++;
+                m_jitterStats.m_totalLatenessUs += latenessUs;
+
+                if (latenessUs > m_jitterStats.m_maxLatenessUs)
+                {
+                    m_jitterStats.m_maxLatenessUs = latenessUs;
+                }
+
+                if (lateness >= pollingInterval)
+                {
+                    // Skip the deadlines which already passed rather than polling them in a burst.
+                    unsigned numOfMissedTicks = static_cast<unsigned>(lateness / pollingInterval);
+                    deadline += numOfMissedTicks * pollingInterval;
+                    tickIndex += numOfMissedTicks;
+                    m_jitterStats.m_numOfMissedTicks += numOfMissedTicks;
+                }
 
                 // Read the value of the sampled counters.
-                samplesBuffer.clear();
-                rc = m_pBeAdapter->ReadAllEnabledCounters(samplesBuffer);
+                m_samplesRing.Rewind();
+                m_samplesBuffer.clear();
+                rc = m_pBeAdapter->ReadAllEnabledCounters(m_samplesRing, m_samplesBuffer);
 
                 // Time tick.
-                m_quantizedTime += m_pollingInterval;
+                m_quantizedTime = tickIndex * m_pollingInterval;
                 ++numOfTicks;
 
                 if (rc < PPR_FIRST_ERROR)
@@ -125,7 +196,7 @@ int PPPollingThread::entryPoint()
                     if (m_pDataAdapter != NULL)
                     {
                         // Insert the data to the DB.
-                        m_pDataAdapter->InsertSamples(samplesBuffer);
+                        m_pDataAdapter->InsertSamples(m_samplesBuffer);
 
                         if (numOfTicks % timeFactor == 0)
                         {
@@ -133,30 +204,27 @@ int PPPollingThread::entryPoint()
                         }
                     }
 
-                    size_t numOfSamples = samplesBuffer.size();
+                    size_t numOfSamples = m_samplesBuffer.size();
 
                     for (size_t i = 0; i < numOfSamples; ++i)
                     {
-                        const AMDTProfileTimelineSample* pCurrBeSample = samplesBuffer[i];
+                        const AMDTProfileTimelineSample* pCurrBeSample = m_samplesBuffer[i];
 
                         GT_IF_WITH_ASSERT(pCurrBeSample != NULL)
                         {
-                            // Create a map to hold the sample values by counter id.
-                            std::shared_ptr<gtMap<int, PPSampledValuesBatch>> pCounterIdToSampleMap(new gtMap<int, PPSampledValuesBatch>());
+                            // Reuse the map of the previous sample, unless the callback kept a reference to it.
+                            if (m_pCounterIdToSampleMap.use_count() > 1)
+                            {
+                                m_pCounterIdToSampleMap.reset(new gtMap<int, PPSampledValuesBatch>());
+                            }
 
                             // Fill the counter to sample map.
-                            CreateCounterToSampleMap(*pCurrBeSample, *pCounterIdToSampleMap);
+                            CreateCounterToSampleMap(*pCurrBeSample, *m_pCounterIdToSampleMap);
 
                             // Raise the event.
-                            m_dataCb(pCounterIdToSampleMap, m_pDataCbParams);
+                            m_dataCb(m_pCounterIdToSampleMap, m_pDataCbParams);
                         }
                     }
-
-                    for (auto it : samplesBuffer)
-                    {
-                        delete it;
-                    }
-
                 }
                 else
                 {
@@ -174,6 +242,27 @@ int PPPollingThread::entryPoint()
                     }
                 }
             }//while (m_IsStopped == false)
+
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+
+            if (isHighResolutionTimer)
+            {
+                timeEndPeriod(1);
+            }
+
+#endif
+
+            // Log the timing of the session.
+            if (m_jitterStats.m_numOfTicks > 0)
+            {
+                gtString jitterMsg(L"Power profiling polling: interval (ms): ");
+                jitterMsg << m_pollingInterval;
+                jitterMsg << L", ticks: " << m_jitterStats.m_numOfTicks;
+                jitterMsg << L", missed ticks: " << m_jitterStats.m_numOfMissedTicks;
+                jitterMsg << L", average lateness (us): " << static_cast<unsigned>(m_jitterStats.m_totalLatenessUs / m_jitterStats.m_numOfTicks);
+                jitterMsg << L", maximal lateness (us): " << static_cast<unsigned>(m_jitterStats.m_maxLatenessUs);
+                OS_OUTPUT_DEBUG_LOG(jitterMsg.asCharArray(), OS_DEBUG_LOG_INFO);
+            }
         }
     }
 
@@ -0,0 +1,41 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file PPSamplesRing.cpp
+///
+//==================================================================================
+
+#include <AMDTPowerProfilingMidTier/include/PPSamplesRing.h>
+
+PPSamplesRing::PPSamplesRing(size_t initialCapacity) : m_nextSample(0)
+{
+    m_samples.reserve(initialCapacity);
+
+    for (size_t i = 0; i < initialCapacity; ++i)
+    {
+        m_samples.push_back(new AMDTProfileTimelineSample());
+    }
+}
+
+PPSamplesRing::~PPSamplesRing()
+{
+    for (AMDTProfileTimelineSample* pSample : m_samples)
+    {
+        delete pSample;
+    }
+
+    m_samples.clear();
+}
+
+AMDTProfileTimelineSample* PPSamplesRing::Acquire()
+{
+    if (m_nextSample == m_samples.size())
+    {
+        // All the samples are in use in the current tick, grow the ring.
+        // The samples which were already acquired keep their address.
+        m_samples.push_back(new AMDTProfileTimelineSample());
+    }
+
+    return m_samples[m_nextSample++];
+}
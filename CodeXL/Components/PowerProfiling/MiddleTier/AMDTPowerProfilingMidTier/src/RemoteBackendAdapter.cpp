@@ -16,6 +16,7 @@
 // Infra.
 #include <AMDTBaseTools/Include/gtAssert.h>
 #include <AMDTOSWrappers/Include/osDebugLog.h>
+#include <AMDTOSWrappers/Include/osCriticalSectionLocker.h>
 
 // Network.
 #include <AMDTOSWrappers/Include/osPortAddress.h>
@@ -25,6 +26,9 @@ const long READ_TIMEOUT_MS = 1500;
 
 RemoteBackendAdapter::~RemoteBackendAdapter()
 {
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
+
     // Close the connection.
     CXLDaemonClient::Close();
 }
@@ -145,6 +149,8 @@ PPResult RemoteBackendAdapter::InitializeBackend()
 PPResult RemoteBackendAdapter::GetSystemTopology(gtList<PPDevice*>& systemDevices)
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -181,6 +187,8 @@ PPResult RemoteBackendAdapter::GetSystemTopology(gtList<PPDevice*>& systemDevice
 PPResult RemoteBackendAdapter::GetDeviceCounters(int deviceID, gtList<AMDTPwrCounterDesc*>& supportedCounters)
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -226,6 +234,8 @@ PPResult RemoteBackendAdapter::GetDeviceCounters(int deviceID, gtList<AMDTPwrCou
 PPResult RemoteBackendAdapter::GetMinTimerSamplingPeriodMS(unsigned int& samplingPeriodBufferMs)
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -260,6 +270,8 @@ PPResult RemoteBackendAdapter::GetProfilingState(AMDTPwrProfileState& stateBuffe
 PPResult RemoteBackendAdapter::GetCurrentSamplingInterval(unsigned int& samplingIntervalMs)
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -284,6 +296,8 @@ PPResult RemoteBackendAdapter::GetCurrentSamplingInterval(unsigned int& sampling
 PPResult RemoteBackendAdapter::IsCounterEnabled(unsigned int counterId, bool& isEnabled)
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -321,6 +335,8 @@ PPResult RemoteBackendAdapter::GetNumOfEnabledCounters(int& numOfAvailableCounte
 PPResult RemoteBackendAdapter::StartProfiling()
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -330,6 +346,7 @@ PPResult RemoteBackendAdapter::StartProfiling()
         GT_IF_WITH_ASSERT(rc == AMDT_STATUS_OK)
         {
             ret = PPR_NO_ERROR;
+            m_isProfilingActive = true;
         }
         else
         {
@@ -360,6 +377,9 @@ PPResult RemoteBackendAdapter::StartProfiling()
 PPResult RemoteBackendAdapter::StopProfiling()
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
+    m_isProfilingActive = false;
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -386,6 +406,8 @@ PPResult RemoteBackendAdapter::StopProfiling()
 PPResult RemoteBackendAdapter::PauseProfiling()
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -407,6 +429,8 @@ PPResult RemoteBackendAdapter::PauseProfiling()
 PPResult RemoteBackendAdapter::ResumeProfiling()
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -428,6 +452,8 @@ PPResult RemoteBackendAdapter::ResumeProfiling()
 PPResult RemoteBackendAdapter::EnableCounter(int counterId)
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -451,6 +477,8 @@ PPResult RemoteBackendAdapter::EnableCounter(int counterId)
 PPResult RemoteBackendAdapter::DisableCounter(int counterId)
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -474,6 +502,8 @@ PPResult RemoteBackendAdapter::DisableCounter(int counterId)
 PPResult RemoteBackendAdapter::SetTimerSamplingInterval(unsigned int interval)
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -505,6 +535,8 @@ PPResult RemoteBackendAdapter::SetTimerSamplingInterval(unsigned int interval)
 PPResult RemoteBackendAdapter::CloseProfileSession()
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
+    StopSamplesStream();
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -523,9 +555,10 @@ PPResult RemoteBackendAdapter::CloseProfileSession()
     return ret;
 }
 
-PPResult RemoteBackendAdapter::ReadAllEnabledCounters(gtVector<AMDTProfileTimelineSample*>& buffer)
+PPResult RemoteBackendAdapter::ReadAllEnabledCounters(PPSamplesRing& samplesRing, gtVector<AMDTProfileTimelineSample*>& buffer)
 {
     PPResult ret = PPR_UNKNOWN_FAILURE;
+    osCriticalSectionLocker locker(m_requestLock);
     auto pRemoteClient = CXL_DAEMON_CLIENT;
     GT_IF_WITH_ASSERT(pRemoteClient != nullptr)
     {
@@ -536,7 +569,7 @@ PPResult RemoteBackendAdapter::ReadAllEnabledCounters(gtVector<AMDTProfileTimeli
         gtUInt32 numOfSamples = 0;
 
         // The samples array to be filled by the backend.
-        AMDTPwrSample* pSamples;
+        const AMDTPwrSample* pSamples = nullptr;
 
 #ifdef MEASURE_TIME_BETWEEN_CALLS_ON_WINDOWS
         QueryPerformanceCounter((LARGE_INTEGER*)&m_endStopwatch);
@@ -549,8 +582,27 @@ PPResult RemoteBackendAdapter::ReadAllEnabledCounters(gtVector<AMDTProfileTimeli
 
 #endif // MEASURE_TIME_BETWEEN_CALLS_ON_WINDOWS
 
-        // Read the enabled counters from the backend.
-        bool isOk = pRemoteClient->ReadAllEnabledCounters(numOfSamples, pSamples, rcAsInt);
+        bool isOk = true;
+
+        if (m_isProfilingActive && !pRemoteClient->IsPowerSamplesStreamActive())
+        {
+            // Let the remote agent push the samples from now on, instead of requesting them on every tick.
+            isOk = pRemoteClient->StartPowerSamplesStream(rcAsInt);
+            GT_ASSERT_EX(isOk, L"Starting the remote power samples stream.");
+        }
+
+        if (pRemoteClient->IsPowerSamplesStreamActive())
+        {
+            // Take the samples which were received since the previous tick.
+            isOk = pRemoteClient->ReadPowerSamplesStream(numOfSamples, pSamples, rcAsInt);
+        }
+        else if (isOk)
+        {
+            // Read the enabled counters from the backend.
+            AMDTPwrSample* pRequestedSamples = nullptr;
+            isOk = pRemoteClient->ReadAllEnabledCounters(numOfSamples, pRequestedSamples, rcAsInt);
+            pSamples = pRequestedSamples;
+        }
 
         AMDTResult rc = static_cast<AMDTResult>(rcAsInt);
 
@@ -578,7 +630,7 @@ PPResult RemoteBackendAdapter::ReadAllEnabledCounters(gtVector<AMDTProfileTimeli
                     // object in our container of samples to use an output.
                     for (size_t i = 0; i < numOfSamples; ++i)
                     {
-                        AMDTProfileTimelineSample* pCurrSample = new AMDTProfileTimelineSample();
+                        AMDTProfileTimelineSample* pCurrSample = samplesRing.Acquire();
                         const AMDTPwrSample* pCurrBeSample = (pSamples + i);
                         BackendDataConvertor::AMDTPwrSampleToPPSample(pCurrBeSample, *pCurrSample);
                         buffer.push_back(pCurrSample);
@@ -617,6 +669,28 @@ PPResult RemoteBackendAdapter::ReadAllEnabledCounters(gtVector<AMDTProfileTimeli
     return ret;
 }
 
+void RemoteBackendAdapter::StopSamplesStream()
+{
+    auto pRemoteClient = CXL_DAEMON_CLIENT;
+
+    if (pRemoteClient != nullptr && pRemoteClient->IsPowerSamplesStreamActive())
+    {
+        bool isOk = pRemoteClient->StopPowerSamplesStream();
+        GT_ASSERT_EX(isOk, L"Stopping the remote power samples stream.");
+
+        PowerSamplesStreamStats stats;
+        pRemoteClient->GetPowerSamplesStreamStats(stats);
+
+        gtString statsMsg(L"Remote power samples stream: frames: ");
+        statsMsg << static_cast<unsigned>(stats.m_numOfFrames);
+        statsMsg << L", samples: " << static_cast<unsigned>(stats.m_numOfSamples);
+        statsMsg << L", dropped frames: " << static_cast<unsigned>(stats.m_numOfDroppedFrames);
+        statsMsg << L", dropped samples: " << static_cast<unsigned>(stats.m_numOfDroppedSamples);
+        statsMsg << L", maximal backlog (frames): " << stats.m_maxBacklog;
+        OS_OUTPUT_DEBUG_LOG(statsMsg.asCharArray(), OS_DEBUG_LOG_INFO);
+    }
+}
+
 bool RemoteBackendAdapter::SetRemoteTarget(const gtString& remoteTargetHostName, unsigned short remoteTargetPortNumber)
 {
     bool ret = false;
@@ -75,6 +75,10 @@ enum DaemonOpCode
     docIsHSAEnabled,
     docValidateAppPaths,
 
+    // RT power profiling samples stream (appended to keep the wire values of the other op codes).
+    docPowerStartSamplesStream,
+    docPowerStopSamplesStream,
+
     docOpCodeCount
 };
 
@@ -140,6 +144,33 @@ const int DMN_MAX_TIMEOUT_VAL = -1;
 // remote agent terminated itself.
 const unsigned int DMN_SELF_TERMINATION_CODE = 0X7B;
 
+// Files are transferred as file streams:
+// - A header: the file size, the file modification time and the offset from which the file is
+//   sent (all gtUInt64). A transfer is only resumed from a non-zero offset if the size and the
+//   modification time the client sent with the offset match the file, otherwise it restarts from 0.
+// - Chunks: the raw size and the payload size of the chunk (both gtUInt32), followed by
+//   the payload. The payload is zlib compressed iff its size is less than the raw size.
+// - A terminating chunk with a raw size of 0, its payload size holding a DaemonOpStatus.
+const gtUInt32 DMN_FILE_STREAM_CHUNK_SIZE = 1024 * 1024;
+
+// The number of chunks which are read ahead while the previous chunks are sent.
+const unsigned int DMN_FILE_STREAM_PIPELINE_DEPTH = 4;
+
+// Once a power samples stream is started, the agent pushes frames of power samples until the
+// client sends docPowerStopSamplesStream, which is acknowledged by a frame with the end tag.
+// - A header of 5 gtUInt32: the tag, the sequence number of the frame, the backend return code,
+//   the number of samples and the payload size.
+// - The payload: for each sample, its system time seconds and microseconds, elapsed time (ms)
+//   and record id (gtUInt64), its number of values (gtUInt32), and then for each value, the
+//   counter id (gtUInt32) and the counter value (gtFloat32).
+const gtUInt32 DMN_POWER_STREAM_FRAME_TAG = 0x46525750;
+const gtUInt32 DMN_POWER_STREAM_END_TAG = 0x44525750;
+const unsigned int DMN_POWER_STREAM_HEADER_SIZE = 5 * sizeof(gtUInt32);
+const gtUInt32 DMN_POWER_STREAM_MAX_PAYLOAD_SIZE = 16 * 1024 * 1024;
+
+// A frame is pushed at least at this interval, even without samples, to keep the client reading.
+const unsigned int DMN_POWER_STREAM_HEARTBEAT_MS = 500;
+
 // ***************
 // CONSTANTS - END
 // ***************
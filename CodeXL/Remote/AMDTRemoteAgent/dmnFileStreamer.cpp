@@ -0,0 +1,236 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file dmnFileStreamer.cpp
+///
+//==================================================================================
+
+// C++.
+#include <cstring>
+
+// Infra.
+#include <AMDTBaseTools/Include/AMDTDefinitions.h>
+#include <AMDTBaseTools/Include/gtAssert.h>
+#include <AMDTOSWrappers/Include/osThread.h>
+#include <AMDTOSWrappers/Include/osTimeInterval.h>
+
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+    #define ZLIB_WINAPI
+#endif
+
+// For the compression of the chunks.
+#include <zlib.h>
+
+// Local.
+#include <AMDTRemoteAgent/dmnFileStreamer.h>
+
+class dmnFileStreamer::ReaderThread : public osThread
+{
+public:
+    ReaderThread(dmnFileStreamer& streamer) : osThread(gtString(L"DMN File Streamer Reader")), m_streamer(streamer)
+    {
+    }
+
+    virtual ~ReaderThread() {}
+
+protected:
+    virtual int entryPoint()
+    {
+        m_streamer.ReadChunks();
+        return 0;
+    }
+
+private:
+    dmnFileStreamer& m_streamer;
+};
+
+dmnFileStreamer::dmnFileStreamer(const osFilePath& filePath, bool isCompressionRequired) :
+    m_fileSize(0), m_fileTime(0), m_startOffset(0), m_isCompressionRequired(isCompressionRequired),
+    m_chunks(DMN_FILE_STREAM_PIPELINE_DEPTH), m_readChunksCount(0), m_sentChunksCount(0),
+    m_isReadDone(false), m_isReadOk(true), m_isCanceled(false)
+{
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS //on windows we have unicode file names
+    const wchar_t* fname = filePath.asString().asCharArray();
+#else
+    const char* fname = filePath.asString().asASCIICharArray();
+#endif
+    m_file.open(fname, std::ios::binary | std::ios::ate);
+
+    if (m_file.is_open())
+    {
+        m_fileSize = static_cast<gtUInt64>(m_file.tellg());
+
+        // The modification time identifies the file's content together with its size.
+        osStatStructure fileStat;
+
+        if (osWStat(filePath.asString(), fileStat) == 0)
+        {
+            m_fileTime = static_cast<gtUInt64>(fileStat.st_mtime);
+        }
+    }
+}
+
+dmnFileStreamer::~dmnFileStreamer()
+{
+}
+
+bool dmnFileStreamer::Send(osChannel& channel, gtUInt64 startOffset, gtUInt64 expectedFileSize, gtUInt64 expectedFileTime)
+{
+    bool isOk = m_file.is_open();
+    GT_ASSERT_EX(isOk, L"DMN: Failed to open the file to stream.");
+
+    // If the file changed since the client received its part, that part is stale and the whole file is sent again.
+    bool isSameFile = (expectedFileSize == m_fileSize) && (expectedFileTime == m_fileTime);
+    m_startOffset = (isSameFile && startOffset <= m_fileSize) ? startOffset : 0;
+
+    // Send the header.
+    channel << m_fileSize;
+    channel << m_fileTime;
+    channel << m_startOffset;
+
+    if (isOk && m_startOffset < m_fileSize)
+    {
+        // Read and compress the next chunks while the current one is being sent.
+        ReaderThread* pReader = new ReaderThread(*this);
+        pReader->execute();
+
+        for (;;)
+        {
+            Chunk* pChunk = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_condition.wait(lock, [this] { return m_isReadDone || m_sentChunksCount < m_readChunksCount; });
+
+                if (m_sentChunksCount < m_readChunksCount)
+                {
+                    pChunk = &m_chunks[m_sentChunksCount % DMN_FILE_STREAM_PIPELINE_DEPTH];
+                }
+            }
+
+            if (pChunk == nullptr)
+            {
+                isOk = m_isReadOk;
+                GT_ASSERT_EX(isOk, L"DMN: Failed to read the file to stream.");
+                break;
+            }
+
+            channel << pChunk->m_rawSize;
+            channel << pChunk->m_payloadSize;
+            isOk = channel.write(&pChunk->m_payload[0], pChunk->m_payloadSize);
+
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            if (isOk)
+            {
+                ++m_sentChunksCount;
+            }
+            else
+            {
+                m_isCanceled = true;
+            }
+
+            m_condition.notify_all();
+
+            if (!isOk)
+            {
+                break;
+            }
+        }
+
+        // Wait for the reader thread to end.
+        osTimeInterval timeout;
+        timeout.setAsMilliSeconds(100);
+
+        while (pReader->isAlive())
+        {
+            pReader->waitForThreadEnd(timeout);
+        }
+
+        delete pReader;
+    }
+
+    // Send the terminating chunk.
+    gtUInt32 endOfStream = 0;
+    gtUInt32 status = isOk ? dosSuccess : dosFailure;
+    channel << endOfStream;
+    channel << status;
+
+    return isOk;
+}
+
+void dmnFileStreamer::ReadChunks()
+{
+    gtVector<gtByte> rawBuffer;
+
+    if (m_isCompressionRequired)
+    {
+        rawBuffer.resize(DMN_FILE_STREAM_CHUNK_SIZE);
+    }
+
+    bool isOk = m_file.seekg(static_cast<std::streamoff>(m_startOffset), std::ios::beg) ? true : false;
+    gtUInt64 remainingSize = m_fileSize - m_startOffset;
+
+    while (isOk && remainingSize > 0)
+    {
+        Chunk* pChunk = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_condition.wait(lock, [this] { return m_isCanceled || m_readChunksCount - m_sentChunksCount < DMN_FILE_STREAM_PIPELINE_DEPTH; });
+
+            if (m_isCanceled)
+            {
+                break;
+            }
+
+            // The chunk is not accessed by the sender until it is counted as read.
+            pChunk = &m_chunks[m_readChunksCount % DMN_FILE_STREAM_PIPELINE_DEPTH];
+        }
+
+        gtUInt32 rawSize = static_cast<gtUInt32>((remainingSize < DMN_FILE_STREAM_CHUNK_SIZE) ? remainingSize : DMN_FILE_STREAM_CHUNK_SIZE);
+        pChunk->m_rawSize = rawSize;
+        pChunk->m_payloadSize = rawSize;
+
+        if (m_isCompressionRequired)
+        {
+            isOk = m_file.read(&rawBuffer[0], rawSize) ? true : false;
+
+            if (isOk)
+            {
+                uLongf compressedSize = compressBound(rawSize);
+                pChunk->m_payload.resize(compressedSize);
+                int res = compress2(reinterpret_cast<Bytef*>(&pChunk->m_payload[0]), &compressedSize,
+                                    reinterpret_cast<const Bytef*>(&rawBuffer[0]), rawSize, Z_BEST_SPEED);
+
+                if (res == Z_OK && compressedSize < rawSize)
+                {
+                    pChunk->m_payloadSize = static_cast<gtUInt32>(compressedSize);
+                }
+                else
+                {
+                    // Incompressible data is sent as is.
+                    memcpy(&pChunk->m_payload[0], &rawBuffer[0], rawSize);
+                }
+            }
+        }
+        else
+        {
+            pChunk->m_payload.resize(rawSize);
+            isOk = m_file.read(&pChunk->m_payload[0], rawSize) ? true : false;
+        }
+
+        if (isOk)
+        {
+            remainingSize -= rawSize;
+
+            std::lock_guard<std::mutex> lock(m_lock);
+            ++m_readChunksCount;
+            m_condition.notify_all();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_isReadOk = isOk;
+    m_isReadDone = true;
+    m_condition.notify_all();
+}
@@ -0,0 +1,85 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file dmnFileStreamer.h
+///
+//==================================================================================
+
+#ifndef __dmnFileStreamer_h
+#define __dmnFileStreamer_h
+
+// C++.
+#include <fstream>
+#include <mutex>
+#include <condition_variable>
+
+// Infra.
+#include <AMDTBaseTools/Include/gtVector.h>
+#include <AMDTOSWrappers/Include/osChannel.h>
+#include <AMDTOSWrappers/Include/osFilePath.h>
+
+// Local.
+#include <AMDTRemoteAgent/Public Include/dmnDefinitions.h>
+
+// Sends a file to the client as a file stream (see dmnDefinitions.h).
+// The file is read and compressed chunk by chunk by a reader thread, while the
+// previous chunks are sent, so that at most a few chunks are held in memory.
+class dmnFileStreamer
+{
+public:
+
+    // CTOR.
+    dmnFileStreamer(const osFilePath& filePath, bool isCompressionRequired);
+
+    // DTOR.
+    ~dmnFileStreamer();
+
+    // Sends the file from the given offset. The offset is only honored if the file still has the
+    // size and modification time that the client recorded for the part it holds, otherwise the
+    // whole file is sent. A file stream is sent even if the file cannot be read, so that the
+    // client stays in sync with the protocol.
+    bool Send(osChannel& channel, gtUInt64 startOffset, gtUInt64 expectedFileSize, gtUInt64 expectedFileTime);
+
+private:
+
+    class ReaderThread;
+
+    struct Chunk
+    {
+        gtUInt32 m_rawSize;
+        gtUInt32 m_payloadSize;
+        gtVector<gtByte> m_payload;
+    };
+
+    dmnFileStreamer(const dmnFileStreamer&);
+    dmnFileStreamer& operator=(const dmnFileStreamer&);
+
+    // Reads and compresses the chunks of the file, executed by the reader thread.
+    void ReadChunks();
+
+    // The file to send.
+    std::ifstream m_file;
+    gtUInt64 m_fileSize;
+    gtUInt64 m_fileTime;
+    gtUInt64 m_startOffset;
+    bool m_isCompressionRequired;
+
+    // The chunks of the pipeline, used as a ring: chunk i of the file is prepared in
+    // m_chunks[i % DMN_FILE_STREAM_PIPELINE_DEPTH] once chunk i - DEPTH was sent.
+    gtVector<Chunk> m_chunks;
+    gtUInt64 m_readChunksCount;
+    gtUInt64 m_sentChunksCount;
+
+    std::mutex m_lock;
+    std::condition_variable m_condition;
+
+    // Set by the reader thread once it is done, and whether it read the whole file.
+    bool m_isReadDone;
+    bool m_isReadOk;
+
+    // Set when the sending failed, to stop the reader thread.
+    bool m_isCanceled;
+};
+
+#endif // __dmnFileStreamer_h
@@ -8,6 +8,7 @@
 
 // C++.
 #include <sstream>
+#include <cstring>
 
 // Local.
 #include <AMDTRemoteAgent/dmnPowerBackendAdapter.h>
@@ -23,6 +24,7 @@
 #include <AMDTOSWrappers/Include/osProcess.h>
 #include <AMDTOSWrappers/Include/osDebugLog.h>
 #include <AMDTOSWrappers/Include/osThread.h>
+#include <AMDTOSWrappers/Include/osTimeInterval.h>
 
 // ************************************************************************************************
 // Static synchronization mechanism to prevent from multiple threads to access the backend - START.
@@ -45,10 +47,48 @@ static void SetRemoteSessionInProgress(bool isInProgress)
 // Static synchronization mechanism to prevent from multiple threads to access the backend - END.
 // ************************************************************************************************
 
+// Waits for the client's request to stop the samples stream, while the session thread pushes the frames.
+class dmnPowerBackendAdapter::StreamControlThread : public osThread
+{
+public:
+    StreamControlThread(dmnPowerBackendAdapter& adapter) : osThread(gtString(L"DMN POWER STREAM CONTROL THREAD")), m_adapter(adapter)
+    {
+    }
+
+    virtual ~StreamControlThread() {}
+
+protected:
+    virtual int entryPoint()
+    {
+        while (!m_adapter.m_isStreamEnded)
+        {
+            gtInt32 opCode = docUnknown;
+
+            if (m_adapter.m_pConnHandler->read(reinterpret_cast<gtByte*>(&opCode), sizeof(opCode)))
+            {
+                // Nothing but the stop request is expected while streaming.
+                GT_ASSERT_EX(opCode == docPowerStopSamplesStream, L"DMN: Unexpected opcode during a power samples stream.");
+                m_adapter.m_isStreamStopRequested = true;
+                break;
+            }
+            else if (!m_adapter.m_pConnHandler->isOpen())
+            {
+                m_adapter.m_isStreamStopRequested = true;
+                break;
+            }
+        }
+
+        return 0;
+    }
+
+private:
+    dmnPowerBackendAdapter& m_adapter;
+};
+
 dmnPowerBackendAdapter::dmnPowerBackendAdapter(dmnSessionThread* pOwner,
                                                osTCPSocketServerConnectionHandler* pConnHandler) : m_pSessionThread(pOwner),
     m_pConnHandler(pConnHandler), m_procId(0), m_pAppWatcherThread(nullptr), m_isTerminationSafe(false),
-    m_isStopProfile(true)
+    m_isStopProfile(true), m_isStreamStopRequested(false), m_isStreamEnded(true), m_streamSequence(0)
 {
     GT_ASSERT(m_pConnHandler != NULL);
 }
@@ -641,6 +681,142 @@ bool dmnPowerBackendAdapter::handleReadAllEnabledCountersRequest()
     return ret;
 }
 
+template <typename T>
+static void AppendToFrame(gtVector<gtByte>& frame, T value)
+{
+    const gtByte* pValue = reinterpret_cast<const gtByte*>(&value);
+    frame.insert(frame.end(), pValue, pValue + sizeof(T));
+}
+
+bool dmnPowerBackendAdapter::SendSamplesFrame(gtUInt32 tag, gtUInt32 rc, AMDTUInt32 numOfSamples, const AMDTPwrSample* pSamples)
+{
+    // Build the whole frame, so that it is sent by a single write.
+    m_streamFrame.clear();
+    AppendToFrame(m_streamFrame, tag);
+    AppendToFrame(m_streamFrame, m_streamSequence++);
+    AppendToFrame(m_streamFrame, rc);
+    AppendToFrame(m_streamFrame, static_cast<gtUInt32>(numOfSamples));
+    AppendToFrame(m_streamFrame, static_cast<gtUInt32>(0));
+
+    for (AMDTUInt32 i = 0; i < numOfSamples; ++i)
+    {
+        const AMDTPwrSample& sample = pSamples[i];
+        AppendToFrame(m_streamFrame, static_cast<gtUInt64>(sample.m_systemTime.m_second));
+        AppendToFrame(m_streamFrame, static_cast<gtUInt64>(sample.m_systemTime.m_microSecond));
+        AppendToFrame(m_streamFrame, static_cast<gtUInt64>(sample.m_elapsedTimeMs));
+        AppendToFrame(m_streamFrame, static_cast<gtUInt64>(sample.m_recordId));
+
+        gtUInt32 numOfVals = (sample.m_counterValues != NULL) ? sample.m_numOfValues : 0;
+        AppendToFrame(m_streamFrame, numOfVals);
+
+        for (gtUInt32 k = 0; k < numOfVals; ++k)
+        {
+            AppendToFrame(m_streamFrame, static_cast<gtUInt32>(sample.m_counterValues[k].m_counterID));
+            AppendToFrame(m_streamFrame, static_cast<gtFloat32>(sample.m_counterValues[k].m_counterValue));
+        }
+    }
+
+    // Fill in the payload size.
+    gtUInt32 payloadSize = static_cast<gtUInt32>(m_streamFrame.size() - DMN_POWER_STREAM_HEADER_SIZE);
+    memcpy(&m_streamFrame[DMN_POWER_STREAM_HEADER_SIZE - sizeof(gtUInt32)], &payloadSize, sizeof(payloadSize));
+
+    return m_pConnHandler->write(&m_streamFrame[0], m_streamFrame.size());
+}
+
+bool dmnPowerBackendAdapter::handleStartSamplesStreamRequest()
+{
+    bool ret = false;
+    GT_IF_WITH_ASSERT(m_pConnHandler != NULL)
+    {
+        bool isSessionInProgress = IsRemoteSessionInProgress();
+
+        // Transfer the return code.
+        gtUInt32 retAsUnsignedInt = isSessionInProgress ? static_cast<gtUInt32>(AMDT_STATUS_OK) : static_cast<gtUInt32>(DMN_SELF_TERMINATION_CODE);
+        (*m_pConnHandler) << retAsUnsignedInt;
+
+        if (isSessionInProgress)
+        {
+            // Read the backend once per sampling interval, but push a frame at least once per heartbeat.
+            AMDTUInt32 samplingInterval = DMN_POWER_STREAM_HEARTBEAT_MS;
+            AMDTPwrGetTimerSamplingPeriod(&samplingInterval);
+            unsigned int tickMs = (0 < samplingInterval && samplingInterval < DMN_POWER_STREAM_HEARTBEAT_MS) ? samplingInterval : DMN_POWER_STREAM_HEARTBEAT_MS;
+            unsigned int msSinceLastFrame = 0;
+
+            m_streamSequence = 0;
+            m_isStreamStopRequested = false;
+            m_isStreamEnded = false;
+
+            // The agent's reads may be configured to block forever. Bound them while streaming, so that
+            // the control thread re-checks the end of the stream and can be joined after a write failure.
+            long storedReadTimeout = m_pConnHandler->readOperationTimeOut();
+            m_pConnHandler->setReadOperationTimeOut(DMN_POWER_STREAM_HEARTBEAT_MS);
+
+            StreamControlThread* pControlThread = new StreamControlThread(*this);
+            pControlThread->execute();
+
+            ret = true;
+
+            while (ret && !m_isStreamStopRequested)
+            {
+                osSleep(tickMs);
+                msSinceLastFrame += tickMs;
+
+                AMDTUInt32 numOfSamples = 0;
+                AMDTPwrSample* pSamples = NULL;
+                AMDTResult rc = AMDT_ERROR_NODATA;
+
+                if (IsRemoteSessionInProgress())
+                {
+                    rc = AMDTPwrReadAllEnabledCounters(&numOfSamples, &pSamples);
+                }
+                else
+                {
+                    // The target app stopped, let the client know.
+                    rc = static_cast<AMDTResult>(DMN_SELF_TERMINATION_CODE);
+                }
+
+                if (numOfSamples > 0 || (rc != AMDT_ERROR_NODATA && rc != AMDT_STATUS_OK) || msSinceLastFrame >= DMN_POWER_STREAM_HEARTBEAT_MS)
+                {
+                    ret = SendSamplesFrame(DMN_POWER_STREAM_FRAME_TAG, static_cast<gtUInt32>(rc), numOfSamples, pSamples);
+                    msSinceLastFrame = 0;
+
+                    if (ret && static_cast<gtUInt32>(rc) == DMN_SELF_TERMINATION_CODE)
+                    {
+                        // Signal that it is safe to terminate this session.
+                        m_isTerminationSafe = true;
+                    }
+                }
+            }
+
+            // Acknowledge the end of the stream.
+            if (ret)
+            {
+                ret = SendSamplesFrame(DMN_POWER_STREAM_END_TAG, static_cast<gtUInt32>(AMDT_STATUS_OK), 0, NULL);
+            }
+
+            m_isStreamEnded = true;
+
+            osTimeInterval timeout;
+            timeout.setAsMilliSeconds(100);
+
+            while (pControlThread->isAlive())
+            {
+                pControlThread->waitForThreadEnd(timeout);
+            }
+
+            delete pControlThread;
+
+            m_pConnHandler->setReadOperationTimeOut(storedReadTimeout);
+        }
+        else
+        {
+            // Signal that it is safe to terminate this session.
+            m_isTerminationSafe = true;
+        }
+    }
+    return ret;
+}
+
 bool dmnPowerBackendAdapter::handleGetDeviceCountersRequest()
 {
     bool ret = false;
@@ -9,6 +9,9 @@
 #ifndef __dmnPowerBackendAdapter_h
 #define __dmnPowerBackendAdapter_h
 
+// C++.
+#include <atomic>
+
 // Local.
 class dmnSessionThread;
 #include <AMDTRemoteAgent/IAppWatcherObserver.h>
@@ -47,13 +50,21 @@ public:
     bool handleReadAllEnabledCountersRequest();
     bool handleGetDeviceCountersRequest();
 
+    // Pushes frames of power samples to the client until it requests to stop the stream.
+    bool handleStartSamplesStreamRequest();
+
     // IAppWatcherObserver implementations.
     virtual void onAppTerminated() override;
 
 private:
 
+    class StreamControlThread;
+
     gtUInt32 StopPowerProfiling();
 
+    // Sends a frame of the samples stream.
+    bool SendSamplesFrame(gtUInt32 tag, gtUInt32 rc, AMDTUInt32 numOfSamples, const AMDTPwrSample* pSamples);
+
     dmnSessionThread* m_pSessionThread;
 
     // The connection handler.
@@ -73,6 +84,14 @@ private:
     // stop profile status
     bool     m_isStopProfile;
 
+    // Samples stream state. The stop request is set by the stream control thread.
+    std::atomic<bool> m_isStreamStopRequested;
+    std::atomic<bool> m_isStreamEnded;
+    gtUInt32 m_streamSequence;
+
+    // The frame being sent, reused for the whole stream.
+    gtVector<gtByte> m_streamFrame;
+
 };
 #endif // __dmnPowerBackendAdapter_h
 
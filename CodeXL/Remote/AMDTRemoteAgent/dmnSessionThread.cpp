@@ -27,13 +27,6 @@
 #include <AMDTOSWrappers/Include/osStringConstants.h>
 #include <AMDTOSAPIWrappers/Include/oaDriver.h>
 
-#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
-    #define ZLIB_WINAPI
-#endif
-
-// For file compression proxy.
-#include <zlib.h>
-
 
 // C++.
 #include <sstream>
@@ -43,6 +36,7 @@
 // Local.
 #include <AMDTRemoteAgent/dmnSessionThread.h>
 #include <AMDTRemoteAgent/dmnConnectionWatcherThread.h>
+#include <AMDTRemoteAgent/dmnFileStreamer.h>
 #include <AMDTRemoteAgent/Public Include/dmnStringConstants.h>
 #include <AMDTRemoteClient/Include/RemoteClientDataTypes.h>
 
@@ -69,7 +63,6 @@
 const unsigned int OPCODE_BUFFER_SIZE = sizeof(gtInt32);
 const int LOOP_SLEEP_INTERVAL_MS = 100;
 const int FS_REFRESH_INTERVAL_MS = 1000;
-const gtString COMPRESSED_FILE_SUFFIX = L"_zipped";
 
 #define GRAPHIC_SERVER_SHUTDOWN_MAX_WAIT_MS 5000
 
@@ -158,120 +151,26 @@ static bool FillPathBuffers(REMOTE_OPERATION_MODE mode, bool is64BitTarget, osFi
 
 
 
-static bool CompressFile(const osFilePath& fileToCompress, osFilePath& compressedFileBuffer)
+static bool TransferFile(const osFilePath& filePath, osChannel* channel, bool isCompressionRequired = true,
+                         gtUInt64 startOffset = 0, gtUInt64 expectedFileSize = 0, gtUInt64 expectedFileTime = 0)
 {
-    osFilePath compressedFilePath = fileToCompress;
-    gtString compressedFileName;
-    bool ret = fileToCompress.getFileName(compressedFileName);
-    GT_IF_WITH_ASSERT(ret)
-    {
-        compressedFileName.append(COMPRESSED_FILE_SUFFIX);
-        compressedFilePath.setFileName(compressedFileName);
-
-        // First load the original file.
-        osFile src(fileToCompress);
-        ret = src.open(osChannel::OS_BINARY_CHANNEL);
-        GT_ASSERT_EX(ret, L"DMN: Failed to open the file to compress.");
-
-        if (ret)
-        {
-            unsigned long fileSize = 0;
-            ret = src.getSize(fileSize);
-            GT_ASSERT_EX(ret, L"DMN: Failed to the size of the file to compress.");
-
-            if (ret)
-            {
-                gtByte* buffer = new(std::nothrow) gtByte[fileSize]();
-
-                gtSize_t amountRead = 0;
-                ret = src.readAvailableData(buffer, fileSize, amountRead);
-                GT_ASSERT_EX(ret, L"DMN: Unable to read the data of the file to compress.");
-                src.close();
-
-                if (ret)
-                {
-                    // Now compress it.
-                    unsigned long sizeDataCompressed  = amountRead + (amountRead / 10) + 12;
-                    gtByte* dstBuffer = new(std::nothrow) gtByte[sizeDataCompressed]();
-
-                    int res = compress((unsigned char*)dstBuffer, &sizeDataCompressed, (unsigned char*)buffer, amountRead);
-                    ret = (res == Z_OK);
-                    GT_ASSERT_EX(ret, L"DMN: Failed to compress file on compression proxy.");
-
-                    if (ret)
-                    {
-                        // Now let's save the compressed file.
-                        osFile compressedFile;
-                        compressedFile.open(compressedFilePath, osChannel::OS_BINARY_CHANNEL, osFile::OS_OPEN_TO_WRITE);
-                        compressedFile.write(dstBuffer, sizeDataCompressed);
-                        compressedFile.close();
-
-                        // Assign the buffer, since we succeeded.
-                        compressedFileBuffer = compressedFilePath;
-                    }
-
-                    // Clean.
-                    delete[] dstBuffer;
-                    delete[] buffer;
-                }
-            }
-        }
-    }
-    return ret;
-}
-
-
-
-static bool TransferFile(const osFilePath& filePath, osChannel* channel, bool isCompressionRequired = true)
-{
-    bool isOk = true;
-    osFilePath filePathToUse;
-
-    if (isCompressionRequired)
-    {
-        // Save the original file size.
-        // In case compression is required, we need to send it to the remote client.
-        // This represents the upper bound of the size of the decompressed file (after decompression).
-        unsigned long originalFileSize = 0;
-        osFile fileToSend(filePath);
-        isOk = fileToSend.getSize(originalFileSize) && (originalFileSize > 0);
-        GT_ASSERT_EX(isOk, L"DMN: Failed to extract the size of the original file.");
-
-        isOk = CompressFile(filePath, filePathToUse);
-        GT_ASSERT_EX(isOk, L"DMN: Failed to compress flie on file transfer.");
-
-        // First send the original size.
-        gtInt32 fileSizeToSend = static_cast<gtInt32>(originalFileSize);
-        (*channel) << fileSizeToSend;
-
-        // Verify.
-        gtInt32 opStatus = dosFailure;
-        (*channel) >> opStatus;
-        isOk = (opStatus == dosSuccess);
-        GT_ASSERT_EX(isOk, L"DMN: Failed to receive ack for file size of tranferred file.");
-    }
-    else
-    {
-        filePathToUse = filePath;
-    }
+    bool isOk = false;
 
-    if (isOk)
+    GT_IF_WITH_ASSERT(channel != NULL)
     {
-        osRawMemoryBuffer buffer;
-        isOk = buffer.fromFile(filePathToUse);
-        GT_IF_WITH_ASSERT(isOk && channel != NULL)
-        {
-            isOk = buffer.writeSelfIntoChannel(*channel);
-        }
+        // The file is read, compressed and sent in chunks (see dmnFileStreamer).
+        dmnFileStreamer streamer(filePath, isCompressionRequired);
+        isOk = streamer.Send(*channel, startOffset, expectedFileSize, expectedFileTime);
     }
 
     return isOk;
 }
 
-static bool TransferFile(const gtString& fileName, osChannel* channel,  bool isCompressionRequired = true)
+static bool TransferFile(const gtString& fileName, osChannel* channel,  bool isCompressionRequired = true,
+                         gtUInt64 startOffset = 0, gtUInt64 expectedFileSize = 0, gtUInt64 expectedFileTime = 0)
 {
     osFilePath filePath(fileName);
-    return TransferFile(filePath, channel, isCompressionRequired);
+    return TransferFile(filePath, channel, isCompressionRequired, startOffset, expectedFileSize, expectedFileTime);
 }
 
 
@@ -1006,6 +905,13 @@ int dmnSessionThread::entryPoint()
                         break;
                     }
 
+                    case docPowerStartSamplesStream:
+                    {
+                        isOk = m_powerBackendAdapter.handleStartSamplesStreamRequest();
+                        GT_ASSERT_EX(isOk, L"DMN: Failed to stream the power samples.");
+                        break;
+                    }
+
                     case docLaunchGraphicsBeckendServer:
                     {
                         isOk = LaunchGraphicsBeckendServer();
@@ -1475,15 +1381,6 @@ void dmnSessionThread::LaunchProfiler(bool& isTerminationRequired)
                                 (*iter).getFileName(sprofOutfileName);
                                 (*iter).getFileExtension(sprofOutfileExtension);
 
-                                // Currently compressed by default.
-                                // const bool isCompressed = true;
-
-                                // if (isCompressed)
-                                {
-                                    // Concatenate the compressed file suffix.
-                                    sprofOutfileName.append(COMPRESSED_FILE_SUFFIX);
-                                }
-
                                 if (!sprofOutfileExtension.isEmpty())
                                 {
                                     sprofOutfileExtension.prepend(L'.');
@@ -1493,7 +1390,7 @@ void dmnSessionThread::LaunchProfiler(bool& isTerminationRequired)
                                 isOk = m_pConnHandler->writeString(sprofOutfileName);
                                 GT_ASSERT_EX(isOk, L"DMN: Failed transferring CodeXLGpuProfiler file name to the client.");
 
-                                // Transfer the file.
+                                // Transfer the file, compressed.
                                 TransferFile(*iter, m_pConnHandler);
 
                                 // Verify.
@@ -1790,52 +1687,15 @@ bool dmnSessionThread::SendFrameAnalysisFileData(const osFilePath& filePath)
             // Send the isBinary flag to CodeXL client
             (*m_pConnHandler) << isBinary;
 
-            gtVector<gtByte> pBuffer;
-            gtUInt32 fileSize;
-            retVal = ReadFile(filePath, isBinary, pBuffer, fileSize);
-            GT_IF_WITH_ASSERT(retVal)
-            {
-                // Write the file size to the CodeXL client
-                (*m_pConnHandler) << fileSize;
-
-                if (0 < fileSize)
-                {
-                    // Send the binary file content
-                    retVal = m_pConnHandler->write(&pBuffer[0], fileSize);
-                    GT_ASSERT(retVal);
-                }
-            }
+            // Send the file content. The text files are compressed, the binary files (images) are not compressible.
+            retVal = TransferFile(filePath, m_pConnHandler, !isBinary);
+            GT_ASSERT(retVal);
         }
     }
 
     return retVal;
 }
 
-bool dmnSessionThread::ReadFile(const osFilePath& filePath, const bool isBinary, gtVector<gtByte>& pBuffer, gtUInt32& fileSize) const
-{
-    // Read the file size
-#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS //on windows we have unicode file names
-    const wchar_t*   fname = filePath.asString().asCharArray();
-#else
-    const char* fname = filePath.asString().asASCIICharArray();
-#endif
-    std::ifstream file(fname, (isBinary ? (std::ios::binary | std::ios::ate) : std::ios::ate));
-    fileSize = static_cast<unsigned long>(file.tellg());
-    file.seekg(0, std::ios::beg);
-
-    // Allocate a buffer and read the file content into it
-    pBuffer.resize(fileSize);
-
-    bool retVal = true;
-
-    if (0 < fileSize)
-    {
-        retVal = file.read(&(pBuffer[0]), fileSize) ? true : false;
-    }
-
-    return retVal;
-}
-
 void dmnSessionThread::CleanupProcessLeftOvers(const REMOTE_OPERATION_MODE mode) const
 {
 #if AMDT_BUILD_TARGET == AMDT_LINUX_OS
@@ -2300,7 +2160,16 @@ bool dmnSessionThread::GetRemoteFile()
         dmnUtils::LogMessage(stream.str(), OS_DEBUG_LOG_DEBUG);
 
 
-        isOk = TransferFile(fileName, m_pConnHandler, false);
+        // Get the offset from which to send the file, non-zero when the client resumes an interrupted transfer,
+        // and the size and modification time of the file the client's part was received from.
+        gtUInt64 startOffset = 0;
+        gtUInt64 expectedFileSize = 0;
+        gtUInt64 expectedFileTime = 0;
+        (*m_pConnHandler) >> startOffset;
+        (*m_pConnHandler) >> expectedFileSize;
+        (*m_pConnHandler) >> expectedFileTime;
+
+        isOk = TransferFile(fileName, m_pConnHandler, true, startOffset, expectedFileSize, expectedFileTime);
         GT_ASSERT_EX(isOk, L"DMN: Transferring a file to the client.");
 
         // Respond.
@@ -65,6 +65,24 @@ struct ApplicationLaunchDetails
     gtVector<osEnvironmentVariable> m_remoteAppEnvVars;
 };
 
+// Statistics of a power samples stream.
+struct PowerSamplesStreamStats
+{
+    PowerSamplesStreamStats() : m_numOfFrames(0), m_numOfSamples(0), m_numOfDroppedFrames(0), m_numOfDroppedSamples(0), m_backlog(0), m_maxBacklog(0) {}
+
+    // The number of frames and samples which were received.
+    gtUInt64 m_numOfFrames;
+    gtUInt64 m_numOfSamples;
+
+    // The number of frames and samples which were dropped since the backlog was full.
+    gtUInt64 m_numOfDroppedFrames;
+    gtUInt64 m_numOfDroppedSamples;
+
+    // The current and maximal number of frames waiting to be read.
+    gtUInt32 m_backlog;
+    gtUInt32 m_maxBacklog;
+};
+
 enum AppLaunchStatus
 {
     rasUnknown,
@@ -252,6 +270,22 @@ public:
     // Get the consecutive sample.
     bool ReadAllEnabledCounters(gtUInt32& numOfSamples, AMDTPwrSample*& pSamples, gtUInt32& beApiRetVal);
 
+    // Start streaming the power samples: the remote agent pushes the samples as they are taken,
+    // and they are queued until they are read. No other request may be sent while streaming.
+    bool StartPowerSamplesStream(gtUInt32& beApiRetVal);
+
+    // Stop streaming the power samples. The samples which were already received can still be read.
+    bool StopPowerSamplesStream();
+
+    bool IsPowerSamplesStreamActive() const;
+
+    // Get the samples which were streamed since the previous call.
+    // The samples are owned by the client, and are valid until the next call.
+    bool ReadPowerSamplesStream(gtUInt32& numOfSamples, const AMDTPwrSample*& pSamples, gtUInt32& beApiRetVal);
+
+    // Get the statistics of the current power samples stream.
+    void GetPowerSamplesStreamStats(PowerSamplesStreamStats& stats);
+
     // Disconnects from the client, without closing active sessions.
     bool DisconnectWithoutClosing();
 
@@ -17,11 +17,14 @@
 #include <AMDTOSWrappers/Include/osMutex.h>
 #include <AMDTOSWrappers/Include/osMutexLocker.h>
 #include <AMDTOSWrappers/Include/osThread.h>
+#include <AMDTOSWrappers/Include/osTimeInterval.h>
 #include <AMDTOSWrappers/Include/osProductVersion.h>
 #include <AMDTOSWrappers/Include/osApplication.h>
 #include <AMDTOSWrappers/Include/osDebugLog.h>
 #include <AMDTOSWrappers/Include/osTime.h>
 #include <AMDTOSWrappers/Include/osDirectory.h>
+#include <AMDTOSWrappers/Include/osFile.h>
+#include <AMDTBaseTools/Include/gtList.h>
 
 // For RDS's definitions.
 #include <AMDTRemoteDebuggingServer/Include/rdStringConstants.h>
@@ -31,6 +34,8 @@
 
 // C++.
 #include <sstream>
+#include <fstream>
+#include <cstring>
 #include <algorithm>
 
 // Required by zlib to link properly.
@@ -58,6 +63,16 @@ static osMutex gs_InstanceLock;
 const unsigned long TCP_KEEPALIVE_TIMEOUT  = 1000;
 const unsigned long TCP_KEEPALIVE_INTERVAL = 1000;
 
+// The suffix of the files which are being received from the agent.
+const gtString REMOTE_PARTIAL_FILE_SUFFIX = L".partial";
+
+// Holds the size and modification time of the remote file that a partial file was received from.
+const gtString REMOTE_PARTIAL_FILE_IDENTITY_SUFFIX = L".partialid";
+
+// The maximal number of power sample frames which are queued until they are read.
+// When the queue is full, the oldest frame is dropped.
+const size_t POWER_STREAM_MAX_BACKLOG = 256;
+
 static bool IsDifferentAddress(const osPortAddress& first, const osPortAddress& second)
 {
     gtString a = L"";
@@ -73,7 +88,8 @@ static bool IsDifferentAddress(const osPortAddress& first, const osPortAddress&
 class CXLDaemonClient::Impl
 {
 public:
-    Impl(long readTimeout) : m_readTimeout(readTimeout), m_isConnected(false), m_tcpClient(), m_asyncTasks()
+    Impl(long readTimeout) : m_readTimeout(readTimeout), m_isConnected(false), m_tcpClient(), m_asyncTasks(),
+        m_pPowerStreamReceiver(nullptr), m_isPowerStreamBroken(false), m_powerStreamRetVal(0)
     {
     }
 
@@ -82,6 +98,19 @@ public:
         bool isOk = m_tcpClient.close();
         GT_ASSERT_EX(isOk, L"Closing TCP client.");
         CleanAllocatedTasks();
+
+        // The receiver stops reading once the connection is closed.
+        JoinPowerSamplesReceiver();
+
+        for (PowerSamplesFrame* pFrame : m_readyPowerFrames)
+        {
+            delete pFrame;
+        }
+
+        for (PowerSamplesFrame* pFrame : m_freePowerFrames)
+        {
+            delete pFrame;
+        }
     }
 
     bool ConnectToDaemon(osPortAddress& connectionPortBuffer)
@@ -371,23 +400,104 @@ public:
 
                         if (ret)
                         {
-                            osRawMemoryBuffer tmpBuffer;
-                            ret = tmpBuffer.readSelfFromChannel(m_tcpClient);
-                            GT_IF_WITH_ASSERT(ret)
+                            // The file is received into a partial file, which is kept if the transfer is interrupted,
+                            // so that the next request for the same file resumes from where this one stopped. The
+                            // identity of the remote file is kept next to it, so that a part of a file which has
+                            // changed since is not resumed.
+                            osFilePath outputFilePath(localTargetFileName);
+                            gtString partialFileName = localTargetFileName;
+                            partialFileName.append(REMOTE_PARTIAL_FILE_SUFFIX);
+                            osFilePath partialFilePath(partialFileName);
+                            gtString partialIdentityFileName = localTargetFileName;
+                            partialIdentityFileName.append(REMOTE_PARTIAL_FILE_IDENTITY_SUFFIX);
+                            osFilePath partialIdentityFilePath(partialIdentityFileName);
+
+                            gtUInt64 startOffset = 0;
+                            gtUInt64 partialFileSize = 0;
+                            gtUInt64 partialFileTime = 0;
+
+                            if (partialFilePath.exists())
                             {
-                                osFilePath outputFilePath(localTargetFileName);
-                                ret = tmpBuffer.toFile(outputFilePath);
+                                std::ifstream receivedPart(GetStreamFileName(partialFilePath).c_str(), std::ios::binary | std::ios::ate);
+                                std::ifstream receivedPartIdentity(GetStreamFileName(partialIdentityFilePath).c_str(), std::ios::binary);
 
-                                GT_IF_WITH_ASSERT(ret)
+                                if (receivedPart.is_open() &&
+                                    receivedPartIdentity.read(reinterpret_cast<char*>(&partialFileSize), sizeof(partialFileSize)) &&
+                                    receivedPartIdentity.read(reinterpret_cast<char*>(&partialFileTime), sizeof(partialFileTime)))
                                 {
-                                    OS_OUTPUT_DEBUG_LOG(L"DMN Client: A file was successfully received and written to disk.", OS_DEBUG_LOG_INFO);
+                                    startOffset = static_cast<gtUInt64>(receivedPart.tellg());
+                                }
+                            }
 
-                                    // Receive ack.
-                                    m_tcpClient >> opStatus;
-                                    ret = (opStatus == dosSuccess);
-                                    GT_ASSERT_EX(ret, L"On file transfer file successfully sent ACK.");
+                            m_tcpClient << startOffset;
+                            m_tcpClient << partialFileSize;
+                            m_tcpClient << partialFileTime;
+
+                            // The agent restarts from 0 if the remote file is not the one the partial file was received from.
+                            gtUInt64 fileSize = 0;
+                            gtUInt64 fileTime = 0;
+                            gtUInt64 receivedOffset = 0;
+                            ReceiveFileStreamHeader(fileSize, fileTime, receivedOffset);
+
+                            bool isResumed = (receivedOffset > 0);
+                            bool isResumeValid = (receivedOffset == startOffset) && (fileSize == partialFileSize) && (fileTime == partialFileTime);
+                            ret = !isResumed || isResumeValid;
+                            GT_ASSERT_EX(ret, L"DMN Client: The agent resumed the transfer of a different file.");
+
+                            std::ofstream partialFile;
+
+                            if (ret)
+                            {
+                                partialFile.open(GetStreamFileName(partialFilePath).c_str(), std::ios::binary | (isResumed ? std::ios::app : std::ios::trunc));
+                                ret = partialFile.is_open();
+                                GT_ASSERT_EX(ret, L"DMN Client: Failed to create the received file.");
+                            }
+
+                            if (ret && !isResumed)
+                            {
+                                std::ofstream partialIdentityFile(GetStreamFileName(partialIdentityFilePath).c_str(), std::ios::binary | std::ios::trunc);
+                                partialIdentityFile.write(reinterpret_cast<const char*>(&fileSize), sizeof(fileSize));
+                                partialIdentityFile.write(reinterpret_cast<const char*>(&fileTime), sizeof(fileTime));
+                            }
+
+                            // Receive the file, even if it cannot be written, to stay in sync with the agent.
+                            bool isReceived = ReceiveFileStreamChunks(partialFile, fileSize, receivedOffset);
+                            partialFile.close();
+
+                            // Receive ack.
+                            m_tcpClient >> opStatus;
+                            ret = ret && isReceived && (opStatus == dosSuccess);
+                            GT_ASSERT_EX(ret, L"On file transfer file successfully sent ACK.");
+
+                            if (ret)
+                            {
+                                osFile existingFile(outputFilePath);
+
+                                if (existingFile.exists())
+                                {
+                                    existingFile.deleteFile();
+                                }
+
+                                ret = partialFilePath.Rename(localTargetFileName);
+                                GT_ASSERT_EX(ret, L"DMN Client: Failed to rename the received file.");
+
+                                osFile partialIdentityFile(partialIdentityFilePath);
+                                partialIdentityFile.deleteFile();
+
+                                if (ret)
+                                {
+                                    OS_OUTPUT_DEBUG_LOG(L"DMN Client: A file was successfully received and written to disk.", OS_DEBUG_LOG_INFO);
                                 }
                             }
+                            else if (isResumed && !isResumeValid)
+                            {
+                                // The partial file cannot be resumed, so the next request starts over.
+                                osFile stalePartialFile(partialFilePath);
+                                stalePartialFile.deleteFile();
+
+                                osFile stalePartialIdentityFile(partialIdentityFilePath);
+                                stalePartialIdentityFile.deleteFile();
+                            }
                         }
                     }
                 }
@@ -514,79 +624,105 @@ public:
         return ret;
     }
 
-    bool DecompressFile(const osFilePath& originalFile, gtInt32 originalFileSize)
+    // Returns the name of a file to open as a C++ stream.
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS //on windows we have unicode file names
+    static std::wstring GetStreamFileName(const osFilePath& filePath)
     {
-        bool ret = false;
+        return std::wstring(filePath.asString().asCharArray());
+    }
+#else
+    static std::string GetStreamFileName(const osFilePath& filePath)
+    {
+        return std::string(filePath.asString().asASCIICharArray());
+    }
+#endif
 
-        // First read compressed file.
-        osFile compressedFile(originalFile);
-        ret = compressedFile.open(osChannel::OS_BINARY_CHANNEL);
-        GT_ASSERT_EX(ret, L"DMN CLIENT: Failed to open received compressed file.");
+    // Receives a file stream (see dmnDefinitions.h) and writes the (decompressed) content of the file to the output.
+    // The stream is consumed to its end, even if the output fails, to stay in sync with the agent.
+    // Returns true iff the whole file was received and written.
+    bool ReceiveFileStream(std::ostream& output, gtUInt64& fileSize, gtUInt64& startOffset)
+    {
+        gtUInt64 fileTime = 0;
+        ReceiveFileStreamHeader(fileSize, fileTime, startOffset);
+        return ReceiveFileStreamChunks(output, fileSize, startOffset);
+    }
 
-        if (ret)
-        {
-            unsigned long compressedFileSize = 0;
-            ret = compressedFile.getSize(compressedFileSize);
-            GT_ASSERT_EX(ret, L"DMN CLIENT: Failed to get compressed file's size.");
+    // Receives the header of a file stream.
+    void ReceiveFileStreamHeader(gtUInt64& fileSize, gtUInt64& fileTime, gtUInt64& startOffset)
+    {
+        m_tcpClient >> fileSize;
+        m_tcpClient >> fileTime;
+        m_tcpClient >> startOffset;
+    }
 
-            if (ret)
-            {
-                gtByte* dcmpBuffer = new(std::nothrow) gtByte[compressedFileSize];
+    // Receives the chunks of a file stream whose header was received, and writes them to the output.
+    // The stream is consumed to its end, even if the output fails, to stay in sync with the agent.
+    // Returns true iff the rest of the file was received and written.
+    bool ReceiveFileStreamChunks(std::ostream& output, gtUInt64 fileSize, gtUInt64 startOffset)
+    {
+        bool ret = true;
 
-                gtSize_t dcmpAmountRead = 0;
-                compressedFile.readAvailableData(dcmpBuffer, compressedFileSize, dcmpAmountRead);
+        gtVector<gtByte> payload;
+        gtVector<gtByte> rawData;
+        gtUInt64 receivedSize = startOffset;
 
-                // Close and delete the compressed file.
-                compressedFile.close();
-                GT_ASSERT_EX(compressedFile.deleteFile(), L"Deleting compressed file.");
+        for (;;)
+        {
+            gtUInt32 rawSize = 0;
+            gtUInt32 payloadSize = 0;
+            m_tcpClient >> rawSize;
+            m_tcpClient >> payloadSize;
+
+            if (rawSize == 0)
+            {
+                // The terminating chunk holds the status of the stream.
+                ret = ret && (payloadSize == dosSuccess) && (receivedSize == fileSize);
+                break;
+            }
 
-                // IMPORTANT: Note that we are using the ORIGINAL data size.
-                gtByte* restoredFileBuffer = new(std::nothrow) gtByte[originalFileSize];
+            bool isChunkValid = (rawSize <= DMN_FILE_STREAM_CHUNK_SIZE) && (0 < payloadSize) && (payloadSize <= rawSize);
+            payload.resize(payloadSize);
 
-                unsigned long _originalFileSize = originalFileSize;
-                int res = uncompress((unsigned char*)restoredFileBuffer,
-                                     &_originalFileSize, (unsigned char*)dcmpBuffer, dcmpAmountRead);
-                ret = (res == Z_OK);
-                GT_ASSERT_EX(ret, L"DMN CLIENT: Failed to decompress file on compression proxy.");
+            if (!isChunkValid || !m_tcpClient.read(&payload[0], payloadSize))
+            {
+                // This invalidates the communication protocol so we have to close the TCP
+                // connection to avoid losing sync with the remote agent communication stage.
+                GT_ASSERT_EX(false, L"DMN Client: Failed to receive a file chunk.");
+                m_tcpClient.close();
+                ret = false;
+                break;
+            }
 
-                if (ret)
+            if (ret)
+            {
+                if (payloadSize < rawSize)
                 {
-                    // Now save it to disk so that we would be able to verify the correctness.
-                    osFilePath restoredFilePath = originalFile;
-                    gtString restoredFileName;
-                    originalFile.getFileName(restoredFileName);
-
-                    ret = (-1 != restoredFileName.find(L"_zipped") &&
-                           -1 != restoredFileName.replace(0, restoredFileName.length() - 1, L"_zipped", L""));
-                    GT_ASSERT_EX(ret, L"DMN CLIENT: Invalid compressed file name.");
+                    rawData.resize(rawSize);
+                    uLongf decompressedSize = rawSize;
+                    int res = uncompress(reinterpret_cast<Bytef*>(&rawData[0]), &decompressedSize,
+                                         reinterpret_cast<const Bytef*>(&payload[0]), payloadSize);
+                    ret = (res == Z_OK) && (decompressedSize == rawSize);
+                    GT_ASSERT_EX(ret, L"DMN CLIENT: Failed to decompress a received file chunk.");
 
                     if (ret)
                     {
-                        restoredFilePath.setFileName(restoredFileName);
-                        osFile restoredFile;
-                        ret = restoredFile.open(restoredFilePath, osChannel::OS_BINARY_CHANNEL, osFile::OS_OPEN_TO_WRITE);
-                        GT_ASSERT_EX(ret, L"DMN CLIENT: Failed to create decompressed file on disk.");
-
-                        if (ret)
-                        {
-                            ret = restoredFile.write(restoredFileBuffer, _originalFileSize);
-                            GT_ASSERT_EX(ret, L"DMN CLIENT: Failed to write decompressed file to disk.");
-                            restoredFile.close();
-                        }
+                        output.write(&rawData[0], rawSize);
                     }
                 }
+                else
+                {
+                    output.write(&payload[0], rawSize);
+                }
 
-                // Clean.
-                delete[] restoredFileBuffer;
-                delete[] dcmpBuffer;
+                ret = ret && output.good();
+                receivedSize += rawSize;
             }
         }
 
         return ret;
     }
 
-
-    bool ReceiveRemoteFile(const gtString& whereToSave, bool isCompressed = true)
+    bool ReceiveRemoteFile(const gtString& whereToSave)
     {
         bool ret = false;
         OS_DEBUG_LOG_TRACER_WITH_RETVAL(ret);
@@ -595,41 +731,23 @@ public:
         ret = m_tcpClient.readString(sprofOutFileName);
         GT_ASSERT_EX(ret, L"DMN Client: Failed reading CodeXLGpuProfiler output file name.");
 
-        // Now get the original file size.
-        gtInt32 originalFileSize = 0;
-        m_tcpClient >> originalFileSize;
-        ret = (originalFileSize > 0);
+        osFilePath outputFilePath;
+        outputFilePath.setFileDirectory(whereToSave);
+        outputFilePath.setFileName(sprofOutFileName);
 
-        // Report back.
-        gtInt32 report = (ret) ? dosSuccess : dosFailure;
-        m_tcpClient << report;
-
-        if (ret)
-        {
-            // Now read the file.
-            osRawMemoryBuffer tmpBuffer;
-            ret = tmpBuffer.readSelfFromChannel(m_tcpClient);
+        std::ofstream outputFile(GetStreamFileName(outputFilePath).c_str(), std::ios::binary | std::ios::trunc);
+        GT_ASSERT_EX(outputFile.is_open(), L"DMN Client: Failed to create CodeXLGpuProfiler output file.");
 
-            // Report back whether the file was successfully received.
-            report = (ret) ? dosSuccess : dosFailure;
-            m_tcpClient << report;
+        // Now read the file, decompressing it chunk by chunk.
+        gtUInt64 fileSize = 0;
+        gtUInt64 startOffset = 0;
+        ret = ReceiveFileStream(outputFile, fileSize, startOffset) && ret;
+        outputFile.close();
+        GT_ASSERT_EX(ret, L"DMN Client: Failed to receive CodeXLGpuProfiler output file.");
 
-            GT_IF_WITH_ASSERT(ret)
-            {
-                osFilePath outputFilePath;
-                outputFilePath.setFileDirectory(whereToSave);
-                outputFilePath.setFileName(sprofOutFileName);
-                ret = tmpBuffer.toFile(outputFilePath);
-                GT_ASSERT_EX(ret, L"DMN Client: Failed to receive CodeXLGpuProfiler output file.");
-
-                // Now check if we need to decompress the file.
-                if (isCompressed)
-                {
-                    ret = DecompressFile(outputFilePath, originalFileSize);
-                    GT_ASSERT_EX(ret, L"DMN Client: Failed to decompress received file..");
-                }
-            }
-        }
+        // Report back whether the file was successfully received.
+        gtInt32 report = (ret) ? dosSuccess : dosFailure;
+        m_tcpClient << report;
 
         return ret;
     }
@@ -1874,6 +1992,202 @@ public:
         return ret;
     }
 
+    bool StartPowerSamplesStream(gtUInt32& beApiRetVal)
+    {
+        bool ret = false;
+        OS_DEBUG_LOG_TRACER_WITH_RETVAL(ret);
+
+        beApiRetVal = static_cast<gtUInt32>(-1);
+
+        GT_IF_WITH_ASSERT(m_pPowerStreamReceiver == nullptr)
+        {
+            // Transfer the opcode.
+            m_tcpClient << docPowerStartSamplesStream;
+
+            // Verify.
+            gtInt32 opStatus = dosFailure;
+            m_tcpClient >> opStatus;
+            ret = (opStatus == dosSuccess);
+            GT_ASSERT_EX(ret, L"Starting the power samples stream - status query ACK.");
+
+            if (ret)
+            {
+                // Get the return code.
+                m_tcpClient >> beApiRetVal;
+                ret = (beApiRetVal == AMDT_STATUS_OK);
+
+                if (ret)
+                {
+                    {
+                        osMutexLocker locker(m_powerStreamLock);
+                        m_isPowerStreamBroken = false;
+                        m_powerStreamRetVal = AMDT_STATUS_OK;
+                        m_powerStreamStats = PowerSamplesStreamStats();
+
+                        // Frames left unread by a previous stream must not be reported by this one.
+                        for (PowerSamplesFrame* pFrame : m_readyPowerFrames)
+                        {
+                            m_freePowerFrames.push_back(pFrame);
+                        }
+
+                        m_readyPowerFrames.clear();
+                    }
+
+                    // The frames are received asynchronously, until the stream is stopped.
+                    m_pPowerStreamReceiver = new PowerSamplesReceiver(*this);
+                    ret = m_pPowerStreamReceiver->execute();
+                    GT_ASSERT(ret);
+                }
+            }
+            else
+            {
+                beApiRetVal = rceCommunicationFailure;
+            }
+        }
+
+        return ret;
+    }
+
+    bool StopPowerSamplesStream()
+    {
+        bool ret = true;
+
+        if (m_pPowerStreamReceiver != nullptr)
+        {
+            // The agent acknowledges the request with the last frame of the stream.
+            m_tcpClient << docPowerStopSamplesStream;
+            JoinPowerSamplesReceiver();
+
+            osMutexLocker locker(m_powerStreamLock);
+            ret = !m_isPowerStreamBroken;
+        }
+
+        return ret;
+    }
+
+    bool IsPowerSamplesStreamActive() const
+    {
+        return (m_pPowerStreamReceiver != nullptr);
+    }
+
+    bool ReadPowerSamplesStream(gtUInt32& numOfSamples, const AMDTPwrSample*& pSamples, gtUInt32& beApiRetVal)
+    {
+        bool ret = false;
+        numOfSamples = 0;
+        pSamples = nullptr;
+
+        // Take the frames which were received since the previous call.
+        gtList<PowerSamplesFrame*> frames;
+        bool isBroken = false;
+        {
+            osMutexLocker locker(m_powerStreamLock);
+            frames.swap(m_readyPowerFrames);
+            m_powerStreamStats.m_backlog = 0;
+            isBroken = m_isPowerStreamBroken;
+            beApiRetVal = m_powerStreamRetVal;
+        }
+
+        // Decode the samples of the frames into the reused buffers.
+        m_powerStreamSamples.clear();
+        m_powerStreamValues.clear();
+        gtVector<size_t> firstValues;
+
+        for (PowerSamplesFrame* pFrame : frames)
+        {
+            const gtByte* pData = pFrame->m_payload.empty() ? nullptr : &pFrame->m_payload[0];
+            const gtByte* pEnd = pData + pFrame->m_payload.size();
+
+            for (gtUInt32 i = 0; i < pFrame->m_numOfSamples; ++i)
+            {
+                AMDTPwrSample sample;
+                gtUInt64 value64 = 0;
+                bool isValid = ReadFromFrame(pData, pEnd, value64);
+                sample.m_systemTime.m_second = value64;
+                isValid = isValid && ReadFromFrame(pData, pEnd, value64);
+                sample.m_systemTime.m_microSecond = value64;
+                isValid = isValid && ReadFromFrame(pData, pEnd, value64);
+                sample.m_elapsedTimeMs = value64;
+                isValid = isValid && ReadFromFrame(pData, pEnd, value64);
+                sample.m_recordId = value64;
+
+                gtUInt32 numOfValues = 0;
+                isValid = isValid && ReadFromFrame(pData, pEnd, numOfValues);
+                sample.m_numOfValues = numOfValues;
+                sample.m_counterValues = nullptr;
+
+                size_t firstValue = m_powerStreamValues.size();
+
+                for (gtUInt32 k = 0; isValid && k < numOfValues; ++k)
+                {
+                    AMDTPwrCounterValue value;
+                    gtUInt32 counterId = 0;
+                    gtFloat32 counterValue = 0;
+                    isValid = ReadFromFrame(pData, pEnd, counterId) && ReadFromFrame(pData, pEnd, counterValue);
+                    value.m_counterID = counterId;
+                    value.m_counterValue = counterValue;
+                    m_powerStreamValues.push_back(value);
+                }
+
+                GT_IF_WITH_ASSERT(isValid)
+                {
+                    m_powerStreamSamples.push_back(sample);
+                    firstValues.push_back(firstValue);
+                }
+                else
+                {
+                    // Skip the rest of a malformed frame.
+                    m_powerStreamValues.resize(firstValue);
+                    break;
+                }
+            }
+        }
+
+        // The values are stored once all of them were decoded, since the buffer may move while growing.
+        for (size_t i = 0; i < m_powerStreamSamples.size(); ++i)
+        {
+            if (m_powerStreamSamples[i].m_numOfValues > 0)
+            {
+                m_powerStreamSamples[i].m_counterValues = &m_powerStreamValues[firstValues[i]];
+            }
+        }
+
+        // Recycle the frames.
+        {
+            osMutexLocker locker(m_powerStreamLock);
+
+            for (PowerSamplesFrame* pFrame : frames)
+            {
+                m_freePowerFrames.push_back(pFrame);
+            }
+        }
+
+        if (isBroken)
+        {
+            // The communication with the remote agent was lost.
+            beApiRetVal = rceCommunicationFailure;
+            OS_OUTPUT_DEBUG_LOG(L"REMOTE PWR: Communication with remote agent failed.", OS_DEBUG_LOG_ERROR);
+        }
+        else if (beApiRetVal == DMN_SELF_TERMINATION_CODE)
+        {
+            // The remote agent self-terminated the session after the target app had stopped.
+            OS_OUTPUT_DEBUG_LOG(L"REMOTE PWR: Remote target app terminated.", OS_DEBUG_LOG_INFO);
+        }
+        else
+        {
+            numOfSamples = static_cast<gtUInt32>(m_powerStreamSamples.size());
+            pSamples = m_powerStreamSamples.empty() ? nullptr : &m_powerStreamSamples[0];
+            ret = true;
+        }
+
+        return ret;
+    }
+
+    void GetPowerSamplesStreamStats(PowerSamplesStreamStats& stats)
+    {
+        osMutexLocker locker(m_powerStreamLock);
+        stats = m_powerStreamStats;
+    }
+
     bool GetDeviceSupportedCounters(gtUInt32 deviceId, gtUInt32& beApiRetVal, gtUInt32& numOfSupportedCounters, AMDTPwrCounterDesc*& pSupportedCounters)
     {
         bool ret = false;
@@ -1999,85 +2313,53 @@ public:
             gtString extension;
             m_tcpClient >> extension;
             m_tcpClient >> isBinary;
-            gtUInt32 dataSize = 0;
-            if (isBinary)
-            {
-                gtByte* pBuffer = nullptr;
-
-                // Read the data size from the remote agent
-                m_tcpClient >> dataSize;
 
-                message.makeEmpty();
-                message.appendFormattedString(L"ReadFrameFilesData: Reading binary file. dataSize: %d ", (int)dataSize);
-                OS_OUTPUT_DEBUG_LOG(message.asCharArray(), OS_DEBUG_LOG_DEBUG);
+            message.makeEmpty();
+            message.appendFormattedString(L"ReadFrameFilesData: Reading %ls file. %ls ", isBinary ? L"binary" : L"text", extension.asCharArray());
+            OS_OUTPUT_DEBUG_LOG(message.asCharArray(), OS_DEBUG_LOG_DEBUG);
 
+            // Read the file content, the stream is always consumed to avoid breaking the protocol
+            std::ostringstream fileContent;
+            gtUInt64 dataSize = 0;
+            gtUInt64 startOffset = 0;
+            bool rc = ReceiveFileStream(fileContent, dataSize, startOffset);
 
-                // Read the data size from the remote agent
-                pBuffer = new gtByte[dataSize]();
-                bool rc = m_tcpClient.read((gtByte*)pBuffer, dataSize);
+            if (!rc)
+            {
+                gtString msg;
+                msg.appendFormattedString(L"Failed to read file sent from remote agent. File size = %llu. File extension = ", dataSize);
+                msg.append(extension);
+                GT_ASSERT_EX(false, msg.asCharArray());
+                retVal = false;
 
-                if (rc)
+                if (!m_tcpClient.isOpen())
                 {
-                    if (extension.compareNoCase(FRAME_IMAGE_FILE_EXT) == 0)
-                    {
-                        frameData.m_pImageBuffer = reinterpret_cast<unsigned char*>(pBuffer);
-                        frameData.m_imageSize = dataSize;
-                    }
-                    else
-                    {
-                        gtString msg(L"Unsupported file format sent from the remote agent: ");
-                        msg.append(extension);
-                        GT_ASSERT_EX(false, msg.asCharArray());
-                        retVal = false;
-                    }
-                }
-                else
-                {
-                    gtString msg;
-                    msg.appendFormattedString(L"Failed to read binary file sent from remote agent. File size = %d. File extension = ", dataSize);
-                    msg.append(extension);
-                    GT_ASSERT_EX(false, msg.asCharArray());
-                    // Reading the binary file content failed. This invalidates the communication protocol so we have
-                    // to close the TCP connection to avoid losing sync with the remote agent communication stage
-                    m_tcpClient.close();
-                    retVal = false;
                     break;
                 }
             }
+            else if (isBinary && (extension.compareNoCase(FRAME_IMAGE_FILE_EXT) == 0))
+            {
+                const std::string& imageData = fileContent.str();
+                delete [] frameData.m_pImageBuffer;
+                frameData.m_pImageBuffer = new unsigned char[imageData.size()]();
+                memcpy(frameData.m_pImageBuffer, imageData.data(), imageData.size());
+                frameData.m_imageSize = static_cast<unsigned long>(imageData.size());
+            }
+            else if (!isBinary && (extension.compareNoCase(FRAME_DESCRITPION_FILE_EXT) == 0))
+            {
+                // The frame info XML string
+                frameData.m_frameInfoXML = fileContent.str().c_str();
+            }
+            else if (!isBinary && (extension.compareNoCase(FRAME_TRACE_FILE_EXT) == 0))
+            {
+                frameData.m_frameTrace = fileContent.str().c_str();
+            }
             else
             {
-                message.makeEmpty();
-                message.appendFormattedString(L"ReadFrameFilesData: Reading text file. %ls ", extension.asCharArray());
-                OS_OUTPUT_DEBUG_LOG(message.asCharArray(), OS_DEBUG_LOG_DEBUG);
-
-                if (extension.compareNoCase(FRAME_DESCRITPION_FILE_EXT) == 0)
-                {
-                    // Read the frame info XML string from the remote agent
-                    // Read the data size from the remote agent
-                    m_tcpClient >> dataSize;
-                    gtByte* pBuffer = new gtByte[dataSize+1]();
-                    bool rc = m_tcpClient.read((gtByte*)pBuffer, dataSize);
-                    GT_ASSERT(rc == true);
-                    frameData.m_frameInfoXML = pBuffer;
-                    delete [] pBuffer;
-                }
-                else if (extension.compareNoCase(FRAME_TRACE_FILE_EXT) == 0)
-                {
-                    m_tcpClient >> frameData.m_frameTrace;
-                }
-                else
-                {
-                    gtString msg(L"Unsupported file format sent from the remote agent: ");
-                    msg.append(extension);
-                    GT_ASSERT_EX(false, msg.asCharArray());
-
-                    // Read into a temp string (avoid breaking the protocol)
-                    gtASCIIString tempStr;
-                    m_tcpClient >> tempStr;
-
-                    retVal = false;
-
-                }
+                gtString msg(L"Unsupported file format sent from the remote agent: ");
+                msg.append(extension);
+                GT_ASSERT_EX(false, msg.asCharArray());
+                retVal = false;
             }
         }
 
@@ -2189,10 +2471,165 @@ public:
 
 
 private:
+
+    // A frame of power samples, as received from the agent.
+    struct PowerSamplesFrame
+    {
+        gtUInt32 m_numOfSamples;
+        gtVector<gtByte> m_payload;
+    };
+
+    // Receives the frames of the power samples stream.
+    class PowerSamplesReceiver : public osThread
+    {
+    public:
+        PowerSamplesReceiver(Impl& impl) : osThread(L"Power Samples Receiver"), m_impl(impl) {}
+
+        virtual int entryPoint()
+        {
+            m_impl.ReceivePowerSamplesFrames();
+            return 0;
+        }
+
+    private:
+        PowerSamplesReceiver& operator=(const PowerSamplesReceiver&);
+        Impl& m_impl;
+    };
+
+    template <typename T>
+    static bool ReadFromFrame(const gtByte*& pData, const gtByte* pEnd, T& value)
+    {
+        bool ret = (pData != nullptr) && (static_cast<size_t>(pEnd - pData) >= sizeof(T));
+
+        if (ret)
+        {
+            memcpy(&value, pData, sizeof(T));
+            pData += sizeof(T);
+        }
+
+        return ret;
+    }
+
+    // Executed by the receiver thread.
+    void ReceivePowerSamplesFrames()
+    {
+        for (;;)
+        {
+            // Read the header: the tag, sequence number, return code, number of samples and payload size.
+            gtUInt32 header[DMN_POWER_STREAM_HEADER_SIZE / sizeof(gtUInt32)];
+            bool isOk = m_tcpClient.read(reinterpret_cast<gtByte*>(header), sizeof(header));
+
+            if (isOk && header[0] == DMN_POWER_STREAM_END_TAG)
+            {
+                break;
+            }
+
+            isOk = isOk && (header[0] == DMN_POWER_STREAM_FRAME_TAG) && (header[4] <= DMN_POWER_STREAM_MAX_PAYLOAD_SIZE);
+
+            PowerSamplesFrame* pFrame = nullptr;
+
+            if (isOk)
+            {
+                osMutexLocker locker(m_powerStreamLock);
+
+                if (!m_freePowerFrames.empty())
+                {
+                    pFrame = m_freePowerFrames.back();
+                    m_freePowerFrames.pop_back();
+                }
+            }
+
+            if (isOk)
+            {
+                if (pFrame == nullptr)
+                {
+                    pFrame = new PowerSamplesFrame;
+                }
+
+                pFrame->m_numOfSamples = header[3];
+                pFrame->m_payload.resize(header[4]);
+                isOk = pFrame->m_payload.empty() || m_tcpClient.read(&pFrame->m_payload[0], pFrame->m_payload.size());
+            }
+
+            osMutexLocker locker(m_powerStreamLock);
+
+            if (!isOk)
+            {
+                delete pFrame;
+                m_isPowerStreamBroken = true;
+                break;
+            }
+
+            if (header[2] != AMDT_STATUS_OK && header[2] != AMDT_ERROR_NODATA)
+            {
+                m_powerStreamRetVal = header[2];
+            }
+
+            m_powerStreamStats.m_numOfFrames++;
+            m_powerStreamStats.m_numOfSamples += pFrame->m_numOfSamples;
+
+            if (pFrame->m_numOfSamples == 0)
+            {
+                // Nothing to queue in a heartbeat.
+                m_freePowerFrames.push_back(pFrame);
+                continue;
+            }
+
+            m_readyPowerFrames.push_back(pFrame);
+
+            if (m_readyPowerFrames.size() > POWER_STREAM_MAX_BACKLOG)
+            {
+                // The frames are not read fast enough, drop the oldest one.
+                PowerSamplesFrame* pDroppedFrame = m_readyPowerFrames.front();
+                m_readyPowerFrames.pop_front();
+                m_powerStreamStats.m_numOfDroppedFrames++;
+                m_powerStreamStats.m_numOfDroppedSamples += pDroppedFrame->m_numOfSamples;
+                m_freePowerFrames.push_back(pDroppedFrame);
+            }
+
+            m_powerStreamStats.m_backlog = static_cast<gtUInt32>(m_readyPowerFrames.size());
+
+            if (m_powerStreamStats.m_maxBacklog < m_powerStreamStats.m_backlog)
+            {
+                m_powerStreamStats.m_maxBacklog = m_powerStreamStats.m_backlog;
+            }
+        }
+    }
+
+    void JoinPowerSamplesReceiver()
+    {
+        if (m_pPowerStreamReceiver != nullptr)
+        {
+            osTimeInterval timeout;
+            timeout.setAsMilliSeconds(100);
+
+            while (m_pPowerStreamReceiver->isAlive())
+            {
+                m_pPowerStreamReceiver->waitForThreadEnd(timeout);
+            }
+
+            delete m_pPowerStreamReceiver;
+            m_pPowerStreamReceiver = nullptr;
+        }
+    }
+
     long m_readTimeout;
     bool m_isConnected;
     osTCPSocketClient m_tcpClient;
     std::vector<osThread*> m_asyncTasks;
+
+    // Power samples stream.
+    PowerSamplesReceiver* m_pPowerStreamReceiver;
+    osMutex m_powerStreamLock;
+    gtList<PowerSamplesFrame*> m_readyPowerFrames;
+    gtVector<PowerSamplesFrame*> m_freePowerFrames;
+    bool m_isPowerStreamBroken;
+    gtUInt32 m_powerStreamRetVal;
+    PowerSamplesStreamStats m_powerStreamStats;
+
+    // The samples returned by the last ReadPowerSamplesStream().
+    gtVector<AMDTPwrSample> m_powerStreamSamples;
+    gtVector<AMDTPwrCounterValue> m_powerStreamValues;
 };
 
 
@@ -2778,6 +3215,62 @@ bool CXLDaemonClient::ReadAllEnabledCounters(gtUInt32& numOfSamples, AMDTPwrSamp
     return ret;
 }
 
+bool CXLDaemonClient::StartPowerSamplesStream(gtUInt32& beApiRetVal)
+{
+    bool ret = false;
+
+    if (m_pImpl != NULL)
+    {
+        ret = m_pImpl->StartPowerSamplesStream(beApiRetVal);
+    }
+
+    return ret;
+}
+
+bool CXLDaemonClient::StopPowerSamplesStream()
+{
+    bool ret = false;
+
+    if (m_pImpl != NULL)
+    {
+        ret = m_pImpl->StopPowerSamplesStream();
+    }
+
+    return ret;
+}
+
+bool CXLDaemonClient::IsPowerSamplesStreamActive() const
+{
+    bool ret = false;
+
+    if (m_pImpl != NULL)
+    {
+        ret = m_pImpl->IsPowerSamplesStreamActive();
+    }
+
+    return ret;
+}
+
+bool CXLDaemonClient::ReadPowerSamplesStream(gtUInt32& numOfSamples, const AMDTPwrSample*& pSamples, gtUInt32& beApiRetVal)
+{
+    bool ret = false;
+
+    if (m_pImpl != NULL)
+    {
+        ret = m_pImpl->ReadPowerSamplesStream(numOfSamples, pSamples, beApiRetVal);
+    }
+
+    return ret;
+}
+
+void CXLDaemonClient::GetPowerSamplesStreamStats(PowerSamplesStreamStats& stats)
+{
+    if (m_pImpl != NULL)
+    {
+        m_pImpl->GetPowerSamplesStreamStats(stats);
+    }
+}
+
 bool CXLDaemonClient::GetDeviceSupportedCounters(gtUInt32 deviceId, gtUInt32& beApiRetVal, gtUInt32& numOfSupportedCounters, AMDTPwrCounterDesc*& pSupportedCounters)
 {
     bool ret = false;
@@ -18,9 +18,31 @@
 
 #include "Disassembler.h"
 #include "Disasm.h"
+#include <vector>
 
 class CDisasmwrapper;
 
+// BatchInstInfoType flags
+#define BATCH_INST_BAD_DASM     0x01    // The bytes could not be decoded, the instruction is a single byte
+#define BATCH_INST_DISP_DATA    0x02
+#define BATCH_INST_PC_RELATIVE  0x04
+#define BATCH_INST_MEM_OP       0x08
+
+// The instructions of a code range, as decoded by BatchDecode(). Each vector holds
+// one entry per instruction, so that a field can be scanned without touching the others.
+typedef struct
+{
+    std::vector<unsigned int>   Offsets;        // offset of the instruction from the start of the code
+    std::vector<BYTE>           Lengths;        // number of bytes used
+    std::vector<BYTE>           OpCodeBytes;
+    std::vector<BYTE>           Flags;          // BATCH_INST_*
+    std::vector<BYTE>           NumOperands;
+    std::vector<BYTE>           MemAccessSizes; // size of the first memory operand
+    std::vector<unsigned int>   DispDataValues;
+    std::vector<eSpecies>       Species;
+    std::vector<const char*>    Mnemonics;      // points to the static opcode tables, no need to free
+} BatchInstInfoType;
+
 /////////////////////////////////////////////////////////////////////////////
 // K86Disasm
 /////////////////////////////////////////////////////////////////////////////
@@ -51,6 +73,24 @@ public:
                                    /*[in, out]*/ unsigned int* StrLength,
                                    /*[out, size_is(*StrLength)]*/ BYTE* ASCIICode,
                                    /*[out]*/ UIInstInfoType* pDisasmInfo, /*[out]*/ BYTE* ErrorCode);
+
+    // Decodes the instructions starting in the first CodeSize bytes of the code, without
+    // generating their text. No more than BufferSize bytes of the code are read. Bytes which
+    // cannot be decoded are recorded as single byte instructions flagged BATCH_INST_BAD_DASM.
+    // Stops after MaxInsts instructions, unless MaxInsts is 0.
+    HRESULT BatchDecode(/*[in]*/ const BYTE* pCode,
+                                 /*[in]*/ unsigned int CodeSize,
+                                 /*[in]*/ unsigned int BufferSize,
+                                 /*[in]*/ unsigned int MaxInsts,
+                                 /*[out]*/ BatchInstInfoType* pBatchInfo);
+
+    // Generates the text of the instruction at Index of a batch decoded from pCode.
+    HRESULT BatchDisassemble(/*[in]*/ const BYTE* pCode,
+                                      /*[in]*/ const BatchInstInfoType* pBatchInfo,
+                                      /*[in]*/ unsigned int Index,
+                                      /*[in, out]*/ unsigned int* StrLength,
+                                      /*[out, size_is(*StrLength)]*/ BYTE* ASCIICode);
+
     HRESULT SetProcessorType(/*[in]*/ eProcType CurrentProcType);
     HRESULT SetLongMode(/*[in]*/ BOOL DefaultIs32Bits);
 
@@ -58,6 +98,7 @@ public:
     HRESULT SetDefaultSegSize(/*[in]*/ BOOL DefaultIs32Bits);
 
 private:
+    void GetUIInstInfo(UIInstInfoType* pDisasmInfo);
     void ResetEffectiveAddr();
     void WriteEffectiveAddr(UINT64* pEffAddr);
     CDisasmwrapper*  m_pWrapper;
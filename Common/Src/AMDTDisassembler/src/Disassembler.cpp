@@ -99,6 +99,7 @@ CDisassembler::CDisassembler() : m_hexPostfix("h"), m_opcodeSeperator(" ")
     m_dbit = true;
     m_bShowSize = false;
     m_bCalculateRipRelative = false;
+    m_rip = 0;
     m_alternateDecodings = 0;
     RestoreMnemonicBuffer();
 }
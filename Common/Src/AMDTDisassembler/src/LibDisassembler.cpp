@@ -129,110 +129,269 @@ HRESULT LibDisassembler::UIDisassemble(
 
         if (pDisasmString != NULL)
         {
-            pDisasmInfo->NumBytesUsed = (BYTE)m_pWrapper->GetLength();
+            GetUIInstInfo(pDisasmInfo);
 
-            pDisasmInfo->NumOpCodeBytes = (BYTE)m_pWrapper->GetNumOpcodeBytes();
-            pDisasmInfo->OpCodeByte = m_pWrapper->GetOpcode(0);
+            *ErrorCode = NoError;
 
-            if (m_pWrapper->HasDisplacement())
-            {
-                pDisasmInfo->bHasDispData = TRUE;
-                pDisasmInfo->DispDataValue = (unsigned int) m_pWrapper->GetDisplacement();
-            }
-            else
-            {
-                pDisasmInfo->bHasDispData = FALSE;
-            }
+            strncpy_s((char*)ASCIICode, *StrLength, pDisasmString, strlen(pDisasmString));
+            *StrLength = static_cast<UINT>(strlen((char*)ASCIICode));
+        }
+        else
+        {
+            *ErrorCode = ErrInDE;
+        }
+    }
 
-            for (int i = 0; i < m_pWrapper->GetNumOperands(); i++)
-            {
-                int type = m_pWrapper->GetOperandType(i);
+    if (*ErrorCode)
+    {
+        return E_FAIL;
+    }
+    else
+    {
+        return S_OK;
+    }
 
-                if ((n_Disassembler::OPERANDTYPE_RIPRELATIVE == type)
-                    || (n_Disassembler::OPERANDTYPE_PCOFFSET == type))
-                {
-                    pDisasmInfo->bIsPCRelative = TRUE;
-                    //              break;
-                }
+}
 
-                if ((n_Disassembler::OPERANDTYPE_RIPRELATIVE == type)
-                    || (n_Disassembler::OPERANDTYPE_PCOFFSET == type)
-                    || (n_Disassembler::OPERANDTYPE_MEMORY == type))
-                {
-                    if (pDisasmInfo->bHasMemOp[i])
-                    {
-                        continue;
-                    }
+HRESULT LibDisassembler::BatchDecode(
+    const BYTE* pCode,
+    unsigned int CodeSize,
+    unsigned int BufferSize,
+    unsigned int MaxInsts,
+    BatchInstInfoType* pBatchInfo)
+{
+    pBatchInfo->Offsets.clear();
+    pBatchInfo->Lengths.clear();
+    pBatchInfo->OpCodeBytes.clear();
+    pBatchInfo->Flags.clear();
+    pBatchInfo->NumOperands.clear();
+    pBatchInfo->MemAccessSizes.clear();
+    pBatchInfo->DispDataValues.clear();
+    pBatchInfo->Species.clear();
+    pBatchInfo->Mnemonics.clear();
+
+    if (NULL == m_pWrapper || NULL == pCode)
+    {
+        return E_FAIL;
+    }
 
-                    pDisasmInfo->bHasMemOp[i] = TRUE;
+    if (CodeSize > BufferSize)
+    {
+        CodeSize = BufferSize;
+    }
 
-                    switch (m_pWrapper->GetOperandSize(i))
-                    {
-                        case n_Disassembler::OPERANDSIZE_8:
-                            pDisasmInfo->MemAccessSize[i] = 1;
-                            break;
+    // Instructions are 2-4 bytes long on average
+    size_t numReserve = CodeSize / 3 + 1;
 
-                        case n_Disassembler::OPERANDSIZE_16:
-                            pDisasmInfo->MemAccessSize[i] = 2;
-                            break;
+    if (0 != MaxInsts && numReserve > MaxInsts)
+    {
+        numReserve = MaxInsts;
+    }
 
-                        case n_Disassembler::OPERANDSIZE_32:
-                            pDisasmInfo->MemAccessSize[i] = 4;
-                            break;
+    pBatchInfo->Offsets.reserve(numReserve);
+    pBatchInfo->Lengths.reserve(numReserve);
+    pBatchInfo->OpCodeBytes.reserve(numReserve);
+    pBatchInfo->Flags.reserve(numReserve);
+    pBatchInfo->NumOperands.reserve(numReserve);
+    pBatchInfo->MemAccessSizes.reserve(numReserve);
+    pBatchInfo->DispDataValues.reserve(numReserve);
+    pBatchInfo->Species.reserve(numReserve);
+    pBatchInfo->Mnemonics.reserve(numReserve);
 
-                        case n_Disassembler::OPERANDSIZE_48:
-                            pDisasmInfo->MemAccessSize[i] = 6;
-                            break;
+    unsigned int offset = 0;
+    unsigned int numInsts = 0;
 
-                        case n_Disassembler::OPERANDSIZE_64:
-                            pDisasmInfo->MemAccessSize[i] = 8;
-                            break;
+    while (offset < CodeSize && (0 == MaxInsts || numInsts < MaxInsts))
+    {
+        unsigned int bufferLength = BufferSize - offset;
 
-                        case n_Disassembler::OPERANDSIZE_80:
-                            pDisasmInfo->MemAccessSize[i] = 10;
-                            break;
+        if (bufferLength > MAX_INSTRUCTION_BYTES)
+        {
+            bufferLength = MAX_INSTRUCTION_BYTES;
+        }
 
-                        case n_Disassembler::OPERANDSIZE_128:
-                            pDisasmInfo->MemAccessSize[i] = 16;
-                            break;
+        BYTE length = 1;
+        BYTE opCodeByte = pCode[offset];
+        BYTE flags = BATCH_INST_BAD_DASM;
+        BYTE numOperands = 0;
+        BYTE memAccessSize = 0;
+        unsigned int dispDataValue = 0;
+        eSpecies species = evNASpecies;
+        const char* pMnemonic = NULL;
+
+        // Only decode, the text is generated by BatchDisassemble() when needed
+        if (m_pWrapper->Decode(pCode + offset, static_cast<int>(bufferLength)))
+        {
+            UIInstInfoType instInfo;
+            memset(&instInfo, 0, sizeof(instInfo));
+            GetUIInstInfo(&instInfo);
 
-                        case n_Disassembler::OPERANDSIZE_256:
-                            pDisasmInfo->MemAccessSize[i] = 32;
-                            break;
+            length = instInfo.NumBytesUsed;
+            opCodeByte = instInfo.OpCodeByte;
+            flags = 0;
+            numOperands = static_cast<BYTE>(m_pWrapper->GetNumOperands());
+            dispDataValue = instInfo.DispDataValue;
 
-                        case n_Disassembler::OPERANDSIZE_NONE:
-                            pDisasmInfo->MemAccessSize[i] = 0;
-                            break;
+            if (instInfo.bHasDispData)
+            {
+                flags |= BATCH_INST_DISP_DATA;
+            }
 
-                        default:
-                            pDisasmInfo->MemAccessSize[i] = 0;
-                            break;
-                    }
+            if (instInfo.bIsPCRelative)
+            {
+                flags |= BATCH_INST_PC_RELATIVE;
+            }
 
-                    //              break;
+            for (int i = 0; i < MAX_OPERANDS; i++)
+            {
+                if (instInfo.bHasMemOp[i])
+                {
+                    flags |= BATCH_INST_MEM_OP;
+                    memAccessSize = static_cast<BYTE>(instInfo.MemAccessSize[i]);
+                    break;
                 }
             }
 
-            *ErrorCode = NoError;
+            CInstr_ExtraCodes* extracodes = (CInstr_ExtraCodes*)(m_pWrapper->GetExtraInfoPtr());
 
-            strncpy_s((char*)ASCIICode, *StrLength, pDisasmString, strlen(pDisasmString));
-            *StrLength = static_cast<UINT>(strlen((char*)ASCIICode));
-        }
-        else
-        {
-            *ErrorCode = ErrInDE;
+            if (NULL != extracodes)
+            {
+                species = extracodes->instr_table.InstSpecies;
+                pMnemonic = extracodes->instr_table.Mnemonic;
+            }
         }
+
+        pBatchInfo->Offsets.push_back(offset);
+        pBatchInfo->Lengths.push_back(length);
+        pBatchInfo->OpCodeBytes.push_back(opCodeByte);
+        pBatchInfo->Flags.push_back(flags);
+        pBatchInfo->NumOperands.push_back(numOperands);
+        pBatchInfo->MemAccessSizes.push_back(memAccessSize);
+        pBatchInfo->DispDataValues.push_back(dispDataValue);
+        pBatchInfo->Species.push_back(species);
+        pBatchInfo->Mnemonics.push_back(pMnemonic);
+
+        offset += length;
+        numInsts++;
     }
 
-    if (*ErrorCode)
+    return S_OK;
+}
+
+HRESULT LibDisassembler::BatchDisassemble(
+    const BYTE* pCode,
+    const BatchInstInfoType* pBatchInfo,
+    unsigned int Index,
+    unsigned int* StrLength,
+    BYTE* ASCIICode)
+{
+    memset(ASCIICode, 0, *StrLength);
+
+    if (NULL == m_pWrapper || Index >= pBatchInfo->Offsets.size() || 0 != (pBatchInfo->Flags[Index] & BATCH_INST_BAD_DASM))
     {
         return E_FAIL;
     }
+
+    // The instruction is decoded again, limited to its own bytes
+    if (!m_pWrapper->Decode(pCode + pBatchInfo->Offsets[Index], static_cast<int>(pBatchInfo->Lengths[Index])))
+    {
+        return E_FAIL;
+    }
+
+    char* pDisasmString = m_pWrapper->Disassemble();
+
+    strncpy_s((char*)ASCIICode, *StrLength, pDisasmString, strlen(pDisasmString));
+    *StrLength = static_cast<UINT>(strlen((char*)ASCIICode));
+
+    return S_OK;
+}
+
+// Fills the instruction info of the last decoded instruction
+void LibDisassembler::GetUIInstInfo(UIInstInfoType* pDisasmInfo)
+{
+    pDisasmInfo->NumBytesUsed = (BYTE)m_pWrapper->GetLength();
+
+    pDisasmInfo->NumOpCodeBytes = (BYTE)m_pWrapper->GetNumOpcodeBytes();
+    pDisasmInfo->OpCodeByte = m_pWrapper->GetOpcode(0);
+
+    if (m_pWrapper->HasDisplacement())
+    {
+        pDisasmInfo->bHasDispData = TRUE;
+        pDisasmInfo->DispDataValue = (unsigned int) m_pWrapper->GetDisplacement();
+    }
     else
     {
-        return S_OK;
+        pDisasmInfo->bHasDispData = FALSE;
     }
 
+    for (int i = 0; i < m_pWrapper->GetNumOperands(); i++)
+    {
+        int type = m_pWrapper->GetOperandType(i);
+
+        if ((n_Disassembler::OPERANDTYPE_RIPRELATIVE == type)
+            || (n_Disassembler::OPERANDTYPE_PCOFFSET == type))
+        {
+            pDisasmInfo->bIsPCRelative = TRUE;
+            //              break;
+        }
+
+        if ((n_Disassembler::OPERANDTYPE_RIPRELATIVE == type)
+            || (n_Disassembler::OPERANDTYPE_PCOFFSET == type)
+            || (n_Disassembler::OPERANDTYPE_MEMORY == type))
+        {
+            if (pDisasmInfo->bHasMemOp[i])
+            {
+                continue;
+            }
+
+            pDisasmInfo->bHasMemOp[i] = TRUE;
+
+            switch (m_pWrapper->GetOperandSize(i))
+            {
+                case n_Disassembler::OPERANDSIZE_8:
+                    pDisasmInfo->MemAccessSize[i] = 1;
+                    break;
+
+                case n_Disassembler::OPERANDSIZE_16:
+                    pDisasmInfo->MemAccessSize[i] = 2;
+                    break;
+
+                case n_Disassembler::OPERANDSIZE_32:
+                    pDisasmInfo->MemAccessSize[i] = 4;
+                    break;
+
+                case n_Disassembler::OPERANDSIZE_48:
+                    pDisasmInfo->MemAccessSize[i] = 6;
+                    break;
+
+                case n_Disassembler::OPERANDSIZE_64:
+                    pDisasmInfo->MemAccessSize[i] = 8;
+                    break;
+
+                case n_Disassembler::OPERANDSIZE_80:
+                    pDisasmInfo->MemAccessSize[i] = 10;
+                    break;
+
+                case n_Disassembler::OPERANDSIZE_128:
+                    pDisasmInfo->MemAccessSize[i] = 16;
+                    break;
+
+                case n_Disassembler::OPERANDSIZE_256:
+                    pDisasmInfo->MemAccessSize[i] = 32;
+                    break;
+
+                case n_Disassembler::OPERANDSIZE_NONE:
+                    pDisasmInfo->MemAccessSize[i] = 0;
+                    break;
+
+                default:
+                    pDisasmInfo->MemAccessSize[i] = 0;
+                    break;
+            }
+
+            //              break;
+        }
+    }
 }
 
 void LibDisassembler::ResetEffectiveAddr()
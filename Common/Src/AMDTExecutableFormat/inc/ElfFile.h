@@ -205,10 +205,23 @@ public:
     virtual gtRVAddr GetCodeBase() const;
     virtual gtUInt32 GetCodeSize() const;
 
+    /// -----------------------------------------------------------------------------------------------
+    /// \brief Retrieves the number of symbol cache lookups made by the ELF files of the process.
+    ///
+    /// The symbol cache directory is set by the CODEXL_SYMBOL_CACHE_DIR environment variable, or else it is
+    /// the SymbolCache subdirectory of the cache path given to InitializeSymbolEngine().
+    ///
+    /// \param[out] numHits The number of executables whose symbols were loaded from the cache.
+    /// \param[out] numMisses The number of executables whose cache file was missing or invalid.
+    /// -----------------------------------------------------------------------------------------------
+    static void GetSymbolCacheStatistics(gtUInt32& numHits, gtUInt32& numMisses);
+
 private:
     // ElfSymbolEngine is a friend class, as it is actually an integral part of the ELF format.
     friend class ElfSymbolEngine;
 
+    bool GetSymbolCacheFilePath(const wchar_t* pCachePath, wchar_t* pBuffer) const;
+
     gtUInt64 m_imageBase;                ///< The image base address
 
     struct _Elf* m_pElf;
@@ -10,6 +10,7 @@
 #define _PROCESSWORKINGSET_H_
 
 #include "ExecutableFile.h"
+#include <atomic>
 
 class osReadWriteLock;
 
@@ -43,7 +44,37 @@ class EXE_API ProcessWorkingSet
 private:
     typedef gtMap<VAddrRange, ExecutableFile*> ModulesMap;
 
+    struct LoadedModule
+    {
+        VAddrRange m_range;
+        ExecutableFile* m_pExe;
+    };
+
+    // The loaded modules are also kept in an immutable snapshot, which is searched without locking.
+    // The snapshot is a list of levels sorted by address, each one smaller than the one before. Loading a module
+    // publishes a new snapshot with the module as a new last level, merged with the last levels while they are not
+    // larger, so a load copies O(log N) modules on average and a lookup searches O(log N) levels.
+    typedef gtVector<LoadedModule> ModulesLevel;
+
+    enum { MAX_MODULES_LEVELS = 64 };
+
+    struct ModulesSnapshot
+    {
+        unsigned m_levelsCount;
+        const ModulesLevel* m_pLevels[MAX_MODULES_LEVELS];
+    };
+
+    // A replaced snapshot or a merged level, which lookups that started before the epoch m_epoch may still read
+    struct RetiredModules
+    {
+        gtUInt64 m_epoch;
+        const ModulesSnapshot* m_pSnapshot;
+        const ModulesLevel* m_pLevel;
+    };
+
     ModulesMap m_modulesMap;
+    std::atomic<const ModulesSnapshot*> m_pLoadedModules;
+    gtVector<RetiredModules> m_retiredModules;
     union
     {
         gtUIntPtr m_noSymbols;
@@ -53,8 +84,10 @@ private:
     wchar_t* m_pCachePath;
     osReadWriteLock* m_pLock;
 
-    bool LoadModule(ExecutableFile* pExe, gtVAddr baseVa) const;
     ExecutableFile* FindModuleInternal(gtVAddr va, osReadWriteLock* pLock);
+    ExecutableFile* FindLoadedModule(gtVAddr va) const;
+    void PublishLoadedModule(const VAddrRange& range, ExecutableFile* pExe);
+    void FreeRetiredModules(bool all);
 
 public:
     explicit ProcessWorkingSet(bool initSymbolEngine,
@@ -66,8 +99,18 @@ public:
     ~ProcessWorkingSet();
 
     ExecutableFile* AddModule(gtVAddr imageBase, gtUInt32 imageSize, const wchar_t* pImageName);
+    // Lookups of modules that are already loaded take no lock, and may run concurrently with the loading of other modules
     ExecutableFile* FindModule(gtVAddr va);
 
+    // Opens the executable and initializes its symbols, as done when a module is first found.
+    // Does not touch the working set, so it may be used to load the module ahead of time.
+    bool LoadModule(ExecutableFile* pExe, gtVAddr baseVa) const;
+
+    // Takes the ownership of an executable created by the caller, which may be already loaded.
+    // Returns false (and the caller keeps the ownership) if the range is already in the working set.
+    bool AdoptModule(ExecutableFile* pExe, gtVAddr imageBase, gtUInt32 imageSize);
+
+    // Must not run concurrently with any lookup
     void Clear();
 
     void SetLock(osReadWriteLock* pLock);
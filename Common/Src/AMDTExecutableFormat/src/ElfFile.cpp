@@ -12,6 +12,7 @@
 #include "SymbolEngines/Formats/DwarfSymbolEngine.h"
 #include "SymbolEngines/Formats/StabsSymbolEngine.h"
 #include "SymbolEngines/Generics/ProxySymbolEngine.h"
+#include "SymbolEngines/Generics/CachedSymbolEngine.h"
 #include <gelf.h>
 #include <fcntl.h>
 #if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
@@ -21,6 +22,9 @@
 #endif
 
 #include <AMDTOSWrappers/Include/osDebugLog.h>
+#include <AMDTOSWrappers/Include/osDirectory.h>
+#include <AMDTOSWrappers/Include/osProcess.h>
+#include <AMDTBaseTools/Include/gtString.h>
 
 static Elf64_Addr ExtractImageBase(Elf* pElf);
 static Elf_Scn* LookupSectionByName(Elf* pElf, const char* pName, GElf_Shdr& shdr);
@@ -404,7 +408,6 @@ bool ElfFile::InitializeSymbolEngine(const wchar_t* pSearchPath,
                                      const wchar_t* pCachePath)
 {
     (void)pServerList; // Unused
-    (void)pCachePath;  // Unused
 
     OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"Executable (ELF) %ls started Symbol Engine initialization", m_modulePath);
 
@@ -438,22 +441,61 @@ bool ElfFile::InitializeSymbolEngine(const wchar_t* pSearchPath,
 
     GElf_Shdr shdr;
 
+    // The symbol cache holds the functions, the inlined functions and the source lines of the DWARF information.
+    // A debug file linked by the module caches its own DWARF information, when it gets initialized below.
+    wchar_t cacheFilePath[OS_MAX_PATH];
+    bool isSymbolCacheHit = false;
+
     if (NULL != LookupSectionByName(m_pElf, ".debug_abbrev", shdr) && NULL != LookupSectionByName(m_pElf, ".debug_info", shdr))
     {
-        DwarfSymbolEngine* pDwarfEngine = new DwarfSymbolEngine();
+        bool isSymbolCacheUsed = GetSymbolCacheFilePath(pCachePath, cacheFilePath);
 
-        if (pDwarfEngine->Initialize(*this, pElfEngine, m_pElf))
+        if (isSymbolCacheUsed)
         {
-            m_pSymbolEngine = pDwarfEngine;
-            m_isDebugInfoAvailable = true;
+            CachedSymbolEngine* pCachedEngine = new CachedSymbolEngine();
+
+            if (pCachedEngine->Initialize(*this, cacheFilePath, m_signature))
+            {
+                // The cached symbols already include the ELF symbols
+                delete pElfEngine;
+                pElfEngine = NULL;
+
+                m_pSymbolEngine = pCachedEngine;
+                m_isDebugInfoAvailable = true;
+                isSymbolCacheHit = true;
 
-            OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"Executable (ELF) %ls initialized Symbol Engine: DWARF", m_modulePath);
+                OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"Executable (ELF) %ls initialized Symbol Engine: DWARF (cached)", m_modulePath);
+            }
+            else
+            {
+                delete pCachedEngine;
+            }
         }
-        else
+
+        if (!isSymbolCacheHit)
         {
-            delete pDwarfEngine;
+            DwarfSymbolEngine* pDwarfEngine = new DwarfSymbolEngine();
+
+            if (pDwarfEngine->Initialize(*this, pElfEngine, m_pElf))
+            {
+                m_pSymbolEngine = pDwarfEngine;
+                m_isDebugInfoAvailable = true;
+
+                // The cache file is written once the source lines are first queried. If a linked debug file
+                // replaces this engine before that, no cache file is written.
+                if (isSymbolCacheUsed)
+                {
+                    pDwarfEngine->SetSymbolCacheFile(cacheFilePath, m_signature);
+                }
 
-            OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"Executable (ELF) %ls failed to initialize Symbol Engine: DWAF", m_modulePath);
+                OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"Executable (ELF) %ls initialized Symbol Engine: DWARF", m_modulePath);
+            }
+            else
+            {
+                delete pDwarfEngine;
+
+                OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"Executable (ELF) %ls failed to initialize Symbol Engine: DWAF", m_modulePath);
+            }
         }
     }
     else
@@ -485,7 +527,8 @@ bool ElfFile::InitializeSymbolEngine(const wchar_t* pSearchPath,
         }
     }
 
-    unsigned debuglinkIndex = LookupSectionIndex(".gnu_debuglink");
+    // A cache file is only written when no debug link was followed, so there is no debug link to follow on a hit
+    unsigned debuglinkIndex = isSymbolCacheHit ? sectionsCount : LookupSectionIndex(".gnu_debuglink");
 
     if (debuglinkIndex < sectionsCount)
     {
@@ -526,7 +569,7 @@ bool ElfFile::InitializeSymbolEngine(const wchar_t* pSearchPath,
                         {
                             ProxySymbolEngine<ElfFile>* pProxyEngine = new ProxySymbolEngine<ElfFile>(imagePath);
 
-                            if (pProxyEngine->Initialize(m_loadAddress))
+                            if (pProxyEngine->Initialize(m_loadAddress, pCachePath))
                             {
                                 if (NULL != m_pSymbolEngine)
                                 {
@@ -551,6 +594,68 @@ bool ElfFile::InitializeSymbolEngine(const wchar_t* pSearchPath,
     return NULL != m_pSymbolEngine;
 }
 
+bool ElfFile::GetSymbolCacheFilePath(const wchar_t* pCachePath, wchar_t* pBuffer) const
+{
+    gtString cacheDir;
+
+    if (!osGetCurrentProcessEnvVariableValue(L"CODEXL_SYMBOL_CACHE_DIR", cacheDir) || cacheDir.isEmpty())
+    {
+        if (NULL == pCachePath || L'\0' == pCachePath[0])
+        {
+            return false;
+        }
+
+        // The symbol cache files are kept apart from the downloaded symbol files
+        cacheDir = pCachePath;
+
+        if (osFilePath::osPathSeparator != cacheDir[cacheDir.length() - 1])
+        {
+            cacheDir.append(osFilePath::osPathSeparator);
+        }
+
+        cacheDir.append(L"SymbolCache");
+    }
+
+    osDirectory cacheDirectory;
+    cacheDirectory.setDirectoryFullPathFromString(cacheDir);
+
+    if (!cacheDirectory.exists() && !cacheDirectory.create())
+    {
+        return false;
+    }
+
+    // Find the filename in modulepath
+    const wchar_t* pModuleFileName = wcsrchr(m_modulePath, osFilePath::osPathSeparator);
+    pModuleFileName = (NULL != pModuleFileName) ? (pModuleFileName + 1) : m_modulePath;
+
+    // The file name only helps telling the cache files apart, the signature is what keys them
+    wchar_t signatureStr[24];
+    swprintf(signatureStr, 24, L"%016llx", static_cast<unsigned long long>(m_signature));
+
+    gtString cacheFilePath = cacheDir;
+
+    if (osFilePath::osPathSeparator != cacheFilePath[cacheFilePath.length() - 1])
+    {
+        cacheFilePath.append(osFilePath::osPathSeparator);
+    }
+
+    cacheFilePath.append(pModuleFileName).append(L'.').append(signatureStr).append(L".sym");
+
+    bool ret = cacheFilePath.length() < OS_MAX_PATH;
+
+    if (ret)
+    {
+        wcscpy(pBuffer, cacheFilePath.asCharArray());
+    }
+
+    return ret;
+}
+
+void ElfFile::GetSymbolCacheStatistics(gtUInt32& numHits, gtUInt32& numMisses)
+{
+    CachedSymbolEngine::GetStatistics(numHits, numMisses);
+}
+
 
 static Elf64_Addr ExtractImageBase(Elf* pElf)
 {
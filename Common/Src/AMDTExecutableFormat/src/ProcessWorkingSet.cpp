@@ -8,6 +8,8 @@
 
 #include <ProcessWorkingSet.h>
 #include <AMDTOSWrappers/Include/osReadWriteLock.h>
+#include <algorithm>
+#include <iterator>
 
 #include <ElfFile.h>
 
@@ -24,11 +26,49 @@ static inline void LockWrite(osReadWriteLock* pLock);
 static inline void UnlockWrite(osReadWriteLock* pLock);
 
 
+// The lock-free lookups of all the working sets are tracked with epochs. While a lookup reads a snapshot, its thread's
+// slot holds the epoch at which the lookup started. A replaced snapshot is retired with the epoch that follows its
+// replacement, and is freed once no slot holds an older epoch, as later lookups can only see the replacement.
+#define READER_SLOTS_COUNT 128
+
+struct ReaderSlot
+{
+    std::atomic<gtUInt64> m_epoch; // 0 while the thread is not reading a snapshot
+    std::atomic<bool> m_isTaken;
+    char m_padding[64 - sizeof(std::atomic<gtUInt64>) - sizeof(std::atomic<bool>)]; // Keep the slots in separate cache lines
+};
+
+static ReaderSlot s_readerSlots[READER_SLOTS_COUNT];
+static std::atomic<gtUInt64> s_lookupsEpoch(1);
+
+// Takes a reader slot for the thread on its first lookup, and gives it back when the thread exits
+class ThreadReaderSlot
+{
+public:
+    ThreadReaderSlot() : m_pSlot(NULL), m_isExhausted(false) {}
+    ~ThreadReaderSlot();
+
+    ReaderSlot* Take();
+
+private:
+    ReaderSlot* m_pSlot;
+    bool m_isExhausted;
+};
+
+static thread_local ThreadReaderSlot t_readerSlotOwner;
+// The slot taken by t_readerSlotOwner. A plain pointer is cheaper to reach than an object with a destructor.
+static thread_local ReaderSlot* t_pReaderSlot = NULL;
+
+static inline ReaderSlot* EnterLookup();
+static inline void LeaveLookup(ReaderSlot* pSlot);
+static gtUInt64 GetOldestLookupEpoch();
+
+
 ProcessWorkingSet::ProcessWorkingSet(bool initSymbolEngine,
                                      const wchar_t* pSearchPath,
                                      const wchar_t* pServerList,
                                      const wchar_t* pCachePath,
-                                     osReadWriteLock* pLock)
+                                     osReadWriteLock* pLock) : m_pLoadedModules(NULL)
 {
     m_pSearchPath = DuplicatePathList(pSearchPath);
     m_pServerList = DuplicatePathList(pServerList);
@@ -176,9 +216,190 @@ ExecutableFile* ProcessWorkingSet::AddModule(gtVAddr imageBase, gtUInt32 imageSi
     return pExe;
 }
 
+bool ProcessWorkingSet::AdoptModule(ExecutableFile* pExe, gtVAddr imageBase, gtUInt32 imageSize)
+{
+    bool ret = false;
+
+    if (0 == imageSize)
+    {
+        if (pExe->IsOpen())
+        {
+            imageSize = pExe->GetImageSize();
+        }
+        else if (pExe->Open(imageBase))
+        {
+            imageSize = pExe->GetImageSize();
+            pExe->Close();
+        }
+    }
+
+    if (0 != imageSize)
+    {
+        VAddrRange range = { imageBase, imageBase };
+        LockWrite(m_pLock);
+
+        if (m_modulesMap.end() == m_modulesMap.find(range))
+        {
+            range.m_max += static_cast<gtVAddr>(imageSize - 1);
+            m_modulesMap.insert(ModulesMap::value_type(range, pExe));
+            ret = true;
+
+            if (pExe->IsOpen())
+            {
+                PublishLoadedModule(range, pExe);
+            }
+        }
+
+        UnlockWrite(m_pLock);
+    }
+
+    return ret;
+}
+
 ExecutableFile* ProcessWorkingSet::FindModule(gtVAddr va)
 {
-    return FindModuleInternal(va, m_pLock);
+    ExecutableFile* pExe = NULL;
+    ReaderSlot* pSlot = EnterLookup();
+
+    if (NULL != pSlot)
+    {
+        pExe = FindLoadedModule(va);
+        LeaveLookup(pSlot);
+    }
+
+    // The module is not loaded yet, or the address is outside any module
+    if (NULL == pExe)
+    {
+        pExe = FindModuleInternal(va, m_pLock);
+    }
+
+    return pExe;
+}
+
+ExecutableFile* ProcessWorkingSet::FindLoadedModule(gtVAddr va) const
+{
+    ExecutableFile* pExe = NULL;
+    const ModulesSnapshot* pSnapshot = m_pLoadedModules.load();
+
+    if (NULL != pSnapshot)
+    {
+        for (unsigned i = 0; i < pSnapshot->m_levelsCount && NULL == pExe; ++i)
+        {
+            const ModulesLevel& level = *pSnapshot->m_pLevels[i];
+
+            // Find the last module starting at or below the address. The halving has no data dependent branch,
+            // as the addresses of the samples are too scattered for the branches to be predicted.
+            const LoadedModule* pModule = &level[0];
+            size_t count = level.size();
+
+            while (1 < count)
+            {
+                size_t half = count / 2;
+                pModule = (pModule[half].m_range.m_min <= va) ? pModule + half : pModule;
+                count -= half;
+            }
+
+            if (pModule->m_range.m_min <= va && va <= pModule->m_range.m_max)
+            {
+                pExe = pModule->m_pExe;
+            }
+        }
+    }
+
+    return pExe;
+}
+
+// Must be called with the write lock held
+void ProcessWorkingSet::PublishLoadedModule(const VAddrRange& range, ExecutableFile* pExe)
+{
+    const ModulesSnapshot* pOldSnapshot = m_pLoadedModules.load();
+    ModulesSnapshot* pSnapshot = new ModulesSnapshot;
+    pSnapshot->m_levelsCount = 0;
+
+    if (NULL != pOldSnapshot)
+    {
+        *pSnapshot = *pOldSnapshot;
+    }
+
+    ModulesLevel* pLevel = new ModulesLevel;
+    LoadedModule module = { range, pExe };
+    pLevel->push_back(module);
+
+    RetiredModules retired = { 0, NULL, NULL };
+    gtVector<RetiredModules> mergedLevels;
+
+    while (0 < pSnapshot->m_levelsCount && pSnapshot->m_pLevels[pSnapshot->m_levelsCount - 1]->size() <= pLevel->size())
+    {
+        const ModulesLevel* pLastLevel = pSnapshot->m_pLevels[--pSnapshot->m_levelsCount];
+
+        ModulesLevel* pMergedLevel = new ModulesLevel;
+        pMergedLevel->reserve(pLastLevel->size() + pLevel->size());
+        std::merge(pLastLevel->begin(), pLastLevel->end(), pLevel->begin(), pLevel->end(), std::back_inserter(*pMergedLevel),
+                   [](const LoadedModule& left, const LoadedModule& right)
+        {
+            return left.m_range.m_min < right.m_range.m_min;
+        });
+
+        // The new level was never published, but the last one may be read by lookups of the old snapshot
+        delete pLevel;
+        pLevel = pMergedLevel;
+
+        retired.m_pLevel = pLastLevel;
+        mergedLevels.push_back(retired);
+    }
+
+    // The levels only get smaller, so they run out only when they hold more than 2^64 modules
+    pSnapshot->m_pLevels[pSnapshot->m_levelsCount++] = pLevel;
+    m_pLoadedModules.store(pSnapshot);
+
+    // Lookups that start from now on can only see the new snapshot
+    gtUInt64 retiredEpoch = s_lookupsEpoch.fetch_add(1) + 1;
+
+    for (gtVector<RetiredModules>::iterator it = mergedLevels.begin(), itEnd = mergedLevels.end(); it != itEnd; ++it)
+    {
+        it->m_epoch = retiredEpoch;
+        m_retiredModules.push_back(*it);
+    }
+
+    if (NULL != pOldSnapshot)
+    {
+        retired.m_epoch = retiredEpoch;
+        retired.m_pSnapshot = pOldSnapshot;
+        retired.m_pLevel = NULL;
+        m_retiredModules.push_back(retired);
+    }
+
+    FreeRetiredModules(false);
+}
+
+// Must be called with the write lock held. When all is true, no lookup may be running.
+void ProcessWorkingSet::FreeRetiredModules(bool all)
+{
+    gtUInt64 oldestEpoch = all ? GT_UINT64_MAX : GetOldestLookupEpoch();
+    gtVector<RetiredModules>::iterator itKeep = m_retiredModules.begin();
+
+    for (gtVector<RetiredModules>::iterator it = m_retiredModules.begin(), itEnd = m_retiredModules.end(); it != itEnd; ++it)
+    {
+        // Lookups that started at the retire epoch or later never saw the retired snapshot or level
+        if (it->m_epoch <= oldestEpoch)
+        {
+            if (NULL != it->m_pSnapshot)
+            {
+                delete it->m_pSnapshot;
+            }
+
+            if (NULL != it->m_pLevel)
+            {
+                delete it->m_pLevel;
+            }
+        }
+        else
+        {
+            *itKeep++ = *it;
+        }
+    }
+
+    m_retiredModules.erase(itKeep, m_retiredModules.end());
 }
 
 ExecutableFile* ProcessWorkingSet::FindModuleInternal(gtVAddr va, osReadWriteLock* pLock)
@@ -204,7 +425,11 @@ ExecutableFile* ProcessWorkingSet::FindModuleInternal(gtVAddr va, osReadWriteLoc
                 pExe = FindModuleInternal(va, NULL);
                 pLock->unlockWrite();
             }
-            else if (!LoadModule(pExe, it->first.m_min))
+            else if (LoadModule(pExe, it->first.m_min))
+            {
+                PublishLoadedModule(it->first, pExe);
+            }
+            else
             {
                 delete pExe;
                 m_modulesMap.erase(it);
@@ -224,6 +449,20 @@ void ProcessWorkingSet::Clear()
 {
     LockWrite(m_pLock);
 
+    const ModulesSnapshot* pSnapshot = m_pLoadedModules.exchange(NULL);
+
+    if (NULL != pSnapshot)
+    {
+        for (unsigned i = 0; i < pSnapshot->m_levelsCount; ++i)
+        {
+            delete pSnapshot->m_pLevels[i];
+        }
+
+        delete pSnapshot;
+    }
+
+    FreeRetiredModules(true);
+
     for (ModulesMap::iterator it = m_modulesMap.begin(), itEnd = m_modulesMap.end(); it != itEnd; ++it)
     {
         ExecutableFile* pExe = it->second;
@@ -317,3 +556,78 @@ static inline void UnlockWrite(osReadWriteLock* pLock)
         pLock->unlockWrite();
     }
 }
+
+
+ThreadReaderSlot::~ThreadReaderSlot()
+{
+    if (NULL != m_pSlot)
+    {
+        t_pReaderSlot = NULL;
+        m_pSlot->m_isTaken.store(false, std::memory_order_release);
+    }
+}
+
+ReaderSlot* ThreadReaderSlot::Take()
+{
+    // When all the slots are taken, the thread's lookups always take the lock
+    if (NULL == m_pSlot && !m_isExhausted)
+    {
+        for (unsigned i = 0; i < READER_SLOTS_COUNT; ++i)
+        {
+            bool isTaken = false;
+
+            if (!s_readerSlots[i].m_isTaken.load(std::memory_order_relaxed) &&
+                s_readerSlots[i].m_isTaken.compare_exchange_strong(isTaken, true, std::memory_order_acquire))
+            {
+                m_pSlot = &s_readerSlots[i];
+                break;
+            }
+        }
+
+        m_isExhausted = (NULL == m_pSlot);
+        t_pReaderSlot = m_pSlot;
+    }
+
+    return m_pSlot;
+}
+
+static inline ReaderSlot* EnterLookup()
+{
+    ReaderSlot* pSlot = t_pReaderSlot;
+
+    if (NULL == pSlot)
+    {
+        pSlot = t_readerSlotOwner.Take();
+    }
+
+    if (NULL != pSlot)
+    {
+        // Sequentially consistent, so that either the snapshot is read after this store,
+        // or the writer that retires it sees the epoch stored here
+        pSlot->m_epoch.store(s_lookupsEpoch.load());
+    }
+
+    return pSlot;
+}
+
+static inline void LeaveLookup(ReaderSlot* pSlot)
+{
+    pSlot->m_epoch.store(0, std::memory_order_release);
+}
+
+static gtUInt64 GetOldestLookupEpoch()
+{
+    gtUInt64 oldestEpoch = GT_UINT64_MAX;
+
+    for (unsigned i = 0; i < READER_SLOTS_COUNT; ++i)
+    {
+        gtUInt64 epoch = s_readerSlots[i].m_epoch.load();
+
+        if (0 != epoch && epoch < oldestEpoch)
+        {
+            oldestEpoch = epoch;
+        }
+    }
+
+    return oldestEpoch;
+}
@@ -7,13 +7,17 @@
 ///
 //==================================================================================
 
+#include <algorithm>
 #include <AMDTBaseTools/Include/gtAlgorithms.h>
 #include <AMDTBaseTools/Include/gtString.h>
 #include <AMDTBaseTools/Include/gtQueue.h>
 #include <AMDTOSWrappers/Include/osCriticalSectionLocker.h>
 #include <AMDTOSWrappers/Include/osAtomic.h>
+#include <AMDTOSWrappers/Include/osDebugLog.h>
+#include <AMDTOSWrappers/Include/osStopWatch.h>
 #include <ExecutableFile.h>
 #include "DwarfSymbolEngine.h"
+#include "../Generics/CachedSymbolEngine.h"
 
 extern "C"
 {
@@ -51,7 +55,7 @@ static void InitCompilationUnit(Dwarf_Debug dbg);
 #endif
 
 DwarfSymbolEngine::DwarfSymbolEngine() : m_pExe(NULL), m_dbg(NULL), m_pBuffers(NULL), m_pAuxSymEngine(NULL),
-    m_processInlineSamples(false), m_aggregateInlineSamples(false)
+    m_processInlineSamples(false), m_aggregateInlineSamples(false), m_isSourceLineTableBuilt(false), m_symbolCacheSignature(0ULL)
 {
 }
 
@@ -356,71 +360,116 @@ bool DwarfSymbolEngine::ForeachCompilationUnit(bool (DwarfSymbolEngine::* pfnPro
     return ret;
 }
 
-bool DwarfSymbolEngine::TraverseSourceLines(Dwarf_Die cuDie, void* pData)
+unsigned DwarfSymbolEngine::AcquireSourceFileIndex(const char* pFilePath)
 {
-    std::pair<const char*, SrcLineInstanceMap*>* pFullData = static_cast<std::pair<const char*, SrcLineInstanceMap*>*>(pData);
-    const char* pSourceFilePath = pFullData->first;
-    SrcLineInstanceMap& srcLineInstanceMap = *pFullData->second;
+    std::pair<gtMap<std::string, unsigned>::iterator, bool> res =
+        m_sourceFileIndices.insert(gtMap<std::string, unsigned>::value_type(pFilePath, static_cast<unsigned>(m_sourceFiles.size())));
 
-    // Do not call dwarf_dealloc() routines on this pointer. _dwarf_deinit() does the deallocation.
-    char** srcFiles = NULL;
-    Dwarf_Signed srcCount;
+    if (res.second)
+    {
+        m_sourceFiles.push_back(pFilePath);
+    }
+
+    return res.first->second;
+}
 
-    if (DW_DLV_OK == dwarf_srcfiles(cuDie, &srcFiles, &srcCount, NULL))
+bool DwarfSymbolEngine::TraverseSourceLineTable(Dwarf_Die cuDie, void*)
+{
+    Dwarf_Line* pLineBuf;
+    Dwarf_Signed lineCount = 0;
+
+    if (DW_DLV_OK == dwarf_srclines(cuDie, &pLineBuf, &lineCount, NULL))
     {
-        for (int srcIndex = 0, sources = static_cast<int>(srcCount); srcIndex < sources; ++srcIndex)
+        Dwarf_Addr imageBase = static_cast<Dwarf_Addr>(m_pExe->GetImageBase());
+
+        // The lines of a source file share the file path string
+        char* pPrevLineSrc = NULL;
+        unsigned fileIndex = 0;
+
+        for (int lineIndex = 0, lines = static_cast<int>(lineCount); lineIndex < lines; ++lineIndex)
         {
-            if (0 == strcmp(pSourceFilePath, srcFiles[srcIndex]))
-            {
-                Dwarf_Line* pLineBuf;
-                Dwarf_Signed lineCount = 0;
+            // Check if this is end of text sequence
+            Dwarf_Bool lineEndSeq = 0;
 
-                if (DW_DLV_OK == dwarf_srclines(cuDie, &pLineBuf, &lineCount, NULL))
+            if (DW_DLV_OK == dwarf_lineendsequence(pLineBuf[lineIndex], &lineEndSeq, NULL))
+            {
+                if (lineEndSeq)
                 {
-                    for (int lineIndex = 0, lines = static_cast<int>(lineCount); lineIndex < lines; ++lineIndex)
-                    {
-                        // Check if this is end of text sequence
-                        Dwarf_Bool lineEndSeq = 0;
+                    continue;
+                }
+            }
 
-                        if (DW_DLV_OK == dwarf_lineendsequence(pLineBuf[lineIndex], &lineEndSeq, NULL))
-                        {
-                            if (lineEndSeq)
-                            {
-                                continue;
-                            }
-                        }
+            Dwarf_Addr lineAddr;
 
-                        // Skip lines NOT in pSourceFilePath
-                        //
-                        // Note that this can happen when we are looking at lines from other source files
-                        // that are inlined into pSourceFilePath
-                        Dwarf_Unsigned lineFileNo = 0;
+            if (DW_DLV_OK != dwarf_lineaddr(pLineBuf[lineIndex], &lineAddr, NULL) || lineAddr < imageBase)
+            {
+                continue;
+            }
 
-                        if (DW_DLV_OK != dwarf_line_srcfileno(pLineBuf[lineIndex], &lineFileNo, NULL) ||
-                            (lineFileNo - 1) != static_cast<Dwarf_Unsigned>(srcIndex))
-                        {
-                            continue;
-                        }
+            char* pLineSrc = NULL;
+            dwarf_linesrc(pLineBuf[lineIndex], &pLineSrc, NULL);
 
-                        Dwarf_Unsigned lineNo;
-                        dwarf_lineno(pLineBuf[lineIndex], &lineNo, NULL);
+            if (NULL == pLineSrc)
+            {
+                continue;
+            }
 
-                        Dwarf_Addr lineAddr;
-                        dwarf_lineaddr(pLineBuf[lineIndex], &lineAddr, NULL);
+            Dwarf_Unsigned lineNo;
 
-                        gtRVAddr rva = static_cast<gtRVAddr>(lineAddr - m_pExe->GetImageBase());
-                        srcLineInstanceMap[rva] = static_cast<unsigned>(lineNo);
-                    }
+            if (DW_DLV_OK != dwarf_lineno(pLineBuf[lineIndex], &lineNo, NULL))
+            {
+                continue;
+            }
 
-                    dwarf_srclines_dealloc(m_dbg, pLineBuf, lineCount);
-                }
+            if (pLineSrc != pPrevLineSrc)
+            {
+                fileIndex = AcquireSourceFileIndex(pLineSrc);
+                pPrevLineSrc = pLineSrc;
             }
+
+            SourceLineEntry entry;
+            entry.m_rva = static_cast<gtRVAddr>(lineAddr - imageBase);
+            entry.m_line = static_cast<unsigned>(lineNo);
+            entry.m_fileIndex = fileIndex;
+            m_sourceLines.push_back(entry);
         }
+
+        dwarf_srclines_dealloc(m_dbg, pLineBuf, lineCount);
     }
 
     return true;
 }
 
+void DwarfSymbolEngine::BuildSourceLineTable()
+{
+    ACQUIRE_DWARF_LOCK(m_dwarfLock);
+
+    if (!m_isSourceLineTableBuilt)
+    {
+        osStopWatch stopWatch;
+        stopWatch.start();
+
+        // The line programs are walked once, instead of for every query. The libdwarf handle cannot
+        // be shared by threads, so the compilation units are walked serially.
+        ForeachCompilationUnit(&DwarfSymbolEngine::TraverseSourceLineTable);
+        std::stable_sort(m_sourceLines.begin(), m_sourceLines.end());
+
+        m_isSourceLineTableBuilt = true;
+
+        double buildTime = 0.0;
+        stopWatch.getTimeInterval(buildTime);
+
+        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"DWARF source line table: %u lines of %u files built in %.3f sec",
+                                   static_cast<unsigned>(m_sourceLines.size()), static_cast<unsigned>(m_sourceFiles.size()), buildTime);
+
+        if (!m_symbolCacheFilePath.isEmpty())
+        {
+            WriteSymbolCache();
+            m_symbolCacheFilePath.makeEmpty();
+        }
+    }
+}
+
 bool DwarfSymbolEngine::EnumerateSourceLineInstances(const wchar_t* pSourceFilePath, SrcLineInstanceMap& srcLineInstanceMap, bool handleInline)
 {
     GT_UNREFERENCED_PARAMETER(handleInline);
@@ -437,171 +486,245 @@ bool DwarfSymbolEngine::EnumerateSourceLineInstances(const wchar_t* pSourceFileP
 
         if ((size_t)(-1) != wcstombs(sourceFilePathMb, pSourceFilePath, OS_MAX_PATH))
         {
-            std::pair<const char*, SrcLineInstanceMap*> data(sourceFilePathMb, &srcLineInstanceMap);
-            ForeachCompilationUnit(&DwarfSymbolEngine::TraverseSourceLines, &data);
+            if (!m_isSourceLineTableBuilt)
+            {
+                BuildSourceLineTable();
+            }
+
+            gtMap<std::string, unsigned>::const_iterator it = m_sourceFileIndices.find(sourceFilePathMb);
+
+            if (it != m_sourceFileIndices.end())
+            {
+                unsigned fileIndex = it->second;
+
+                // The lines inlined from other source files are left out
+                for (gtVector<SourceLineEntry>::const_iterator lit = m_sourceLines.begin(), litEnd = m_sourceLines.end(); lit != litEnd; ++lit)
+                {
+                    if (fileIndex == lit->m_fileIndex)
+                    {
+                        srcLineInstanceMap[lit->m_rva] = lit->m_line;
+                    }
+                }
+            }
         }
     }
 
     return ret;
 }
 
-bool DwarfSymbolEngine::TraverseSourceLineInfo(Dwarf_Die cuDie, void* pData)
+bool DwarfSymbolEngine::FindSourceLine(gtRVAddr rva, SourceLineInfo& sourceLine, bool handleInline)
 {
-    SourceLineInfo& sourceLine = *static_cast<SourceLineInfo*>(pData);
+    bool ret = false;
 
-    Dwarf_Die die;
-    int r = dwarf_child(cuDie, &die, NULL);
-    bool ret = (DW_DLV_OK == r) ? true : false;
+    if (NULL != m_pAuxSymEngine)
+    {
+        ret = m_pAuxSymEngine->FindSourceLine(rva, sourceLine, handleInline);
+    }
 
-    if (DW_DLV_OK == r)
+    if (!ret)
     {
-        Dwarf_Addr addr = static_cast<Dwarf_Addr>(sourceLine.m_rva) + m_pExe->GetImageBase();
+        const FunctionSymbolInfo* pFuncInfo = LookupFunction(rva, NULL, handleInline);
 
-        // We are looking for symbol information that belong to a function (subprogram) which stays at level 1.
-        // Therefore, we only need to iterate over the level 1 siblings.
-        do
+        if (NULL != pFuncInfo)
         {
-            Dwarf_Half tag;
-
-            if (dwarf_tag(die, &tag, NULL) != DW_DLV_OK)
+            if (!m_isSourceLineTableBuilt)
             {
-                ret = false;
-                break;
+                BuildSourceLineTable();
             }
 
-            if (DW_TAG_subprogram == tag)
+            sourceLine.m_filePath[0] = L'\0';
+
+            // The closest line at or before the RVA, the first one of the line programs if there are several
+            SourceLineEntry key;
+            key.m_rva = rva;
+            gtVector<SourceLineEntry>::const_iterator it = std::upper_bound(m_sourceLines.begin(), m_sourceLines.end(), key);
+
+            if (it != m_sourceLines.begin())
             {
-                Dwarf_Addr addrLow, addrHigh;
+                gtRVAddr lineRva = (--it)->m_rva;
 
-                if (dwarf_lowpc(die, &addrLow , NULL) == DW_DLV_OK && dwarf_highpc(die, &addrHigh , NULL) == DW_DLV_OK)
+                while (it != m_sourceLines.begin() && (it - 1)->m_rva == lineRva)
                 {
-                    if (addrLow > addrHigh)
-                    {
-                        addrHigh += addrLow;
-                    }
+                    --it;
+                }
 
-                    if (addrLow <= addr && addr <= addrHigh)
-                    {
-                        Dwarf_Line* pLineBuf;
-                        Dwarf_Signed lineCount = 0;
+                if ((size_t)(-1) != mbstowcs(sourceLine.m_filePath, m_sourceFiles[it->m_fileIndex].c_str(), OS_MAX_PATH))
+                {
+                    sourceLine.m_offset = rva - lineRva;
+                    sourceLine.m_line = it->m_line;
+                }
+                else
+                {
+                    sourceLine.m_filePath[0] = L'\0';
+                }
+            }
 
-                        if (DW_DLV_OK == dwarf_srclines(cuDie, &pLineBuf, &lineCount, NULL))
-                        {
-                            sourceLine.m_offset = sourceLine.m_rva + 1;
-                            char* pSrcFilePath = NULL;
+            sourceLine.m_rva = pFuncInfo->m_rva;
 
-                            for (int lineIndex = 0, lines = static_cast<int>(lineCount); lineIndex < lines; ++lineIndex)
-                            {
-                                // Check if this is end of text sequence
-                                Dwarf_Bool lineEndSeq = 0;
-
-                                if (DW_DLV_OK == dwarf_lineendsequence(pLineBuf[lineIndex], &lineEndSeq, NULL))
-                                {
-                                    if (lineEndSeq)
-                                    {
-                                        continue;
-                                    }
-                                }
-
-                                Dwarf_Addr lineAddr;
-
-                                if (DW_DLV_OK != dwarf_lineaddr(pLineBuf[lineIndex], &lineAddr, NULL))
-                                {
-                                    continue;
-                                }
-
-                                gtRVAddr offset = static_cast<gtRVAddr>(addr - lineAddr);
-
-                                if (offset >= sourceLine.m_offset)
-                                {
-                                    continue;
-                                }
-
-                                char* pLineSrc = NULL;
-                                dwarf_linesrc(pLineBuf[lineIndex], &pLineSrc, NULL);
-
-                                if (NULL == pLineSrc)
-                                {
-                                    continue;
-                                }
-
-                                Dwarf_Unsigned lineNo;
-
-                                if (DW_DLV_OK != dwarf_lineno(pLineBuf[lineIndex], &lineNo, NULL))
-                                {
-                                    continue;
-                                }
-
-                                sourceLine.m_offset = offset;
-                                sourceLine.m_line = static_cast<unsigned>(lineNo);
-                                pSrcFilePath = pLineSrc;
-
-                                if (0 == offset)
-                                {
-                                    break;
-                                }
-                            }
+            if (L'\0' != sourceLine.m_filePath[0])
+            {
+                ret = true;
+            }
+        }
+    }
 
-                            dwarf_srclines_dealloc(m_dbg, pLineBuf, lineCount);
+    return ret;
+}
 
-                            if (NULL != pSrcFilePath && (size_t)(-1) != mbstowcs(sourceLine.m_filePath, pSrcFilePath, OS_MAX_PATH))
-                            {
-                                sourceLine.m_rva -= sourceLine.m_offset;
-                            }
-                        }
+void DwarfSymbolEngine::SetSymbolCacheFile(const wchar_t* pCacheFilePath, gtUInt64 signature)
+{
+    m_symbolCacheFilePath = pCacheFilePath;
+    m_symbolCacheSignature = signature;
+}
 
-                        ret = false;
-                        break;
-                    }
-                }
+bool DwarfSymbolEngine::WriteSymbolCache()
+{
+    // The source lines of an auxiliary symbol engine are not cached
+    if (NULL != m_pAuxSymEngine || NULL == m_pFuncsInfoVec)
+    {
+        return false;
+    }
+
+    gtVector<SymbolCacheLine> sourceLines;
+    sourceLines.reserve(m_sourceLines.size());
+
+    for (gtVector<SourceLineEntry>::const_iterator it = m_sourceLines.begin(), itEnd = m_sourceLines.end(); it != itEnd; ++it)
+    {
+        SymbolCacheLine line;
+        line.m_rva = it->m_rva;
+        line.m_line = it->m_line;
+        line.m_fileIndex = it->m_fileIndex;
+        sourceLines.push_back(line);
+    }
+
+    // The inlined functions are otherwise extracted on demand, so all of them are walked for the cache
+    SymbolCacheInlinedFunctions inlinedFuncs;
+    SymbolCacheInlinedFunctions* pInlinedFuncs = NULL;
+
+    if (m_processInlineSamples && ForeachCompilationUnit(&DwarfSymbolEngine::TraverseInlinedSubroutines, &inlinedFuncs))
+    {
+        pInlinedFuncs = &inlinedFuncs;
+    }
+
+    bool ret = false;
+
+    // An executable processing the inlined functions would not accept a cache file missing them
+    if (!m_processInlineSamples || NULL != pInlinedFuncs)
+    {
+        ret = CachedSymbolEngine::Write(m_symbolCacheFilePath.asCharArray(), m_symbolCacheSignature, *m_pFuncsInfoVec, pInlinedFuncs,
+                                        sourceLines, m_sourceFiles);
+    }
+
+    return ret;
+}
+
+bool DwarfSymbolEngine::TraverseInlinedSubroutines(Dwarf_Die cuDie, void* pData)
+{
+    SymbolCacheInlinedFunctions& inlinedFuncs = *static_cast<SymbolCacheInlinedFunctions*>(pData);
+    Dwarf_Addr cuAddrLow = 0, addrLow = 0, addrHigh = 0;
+    DieFindLowHighAddress(cuDie, DW_TAG_compile_unit, cuAddrLow, addrLow, addrHigh, NULL);
+
+    Dwarf_Die die;
+    int r = dwarf_child(cuDie, &die, NULL);
+
+    if (DW_DLV_OK == r)
+    {
+        do
+        {
+            Dwarf_Half tag;
+
+            if (dwarf_tag(die, &tag, NULL) == DW_DLV_OK && DW_TAG_subprogram == tag &&
+                DieFindLowHighAddress(die, tag, cuAddrLow, addrLow, addrHigh, NULL) && addrLow < addrHigh)
+            {
+                gtRVAddr callerRva = static_cast<gtRVAddr>(addrLow - m_pExe->GetImageBase());
+                gtUInt32 callerSize = static_cast<gtUInt32>(addrHigh - addrLow);
+                CollectInlinedSubroutines(die, cuAddrLow, callerRva, callerSize, SYMBOL_CACHE_NO_PARENT, inlinedFuncs);
             }
 
             Dwarf_Die siblingDie = NULL;
             r = dwarf_siblingof(m_dbg, die, &siblingDie, NULL);
             dwarf_dealloc(m_dbg, die, DW_DLA_DIE);
             die = siblingDie;
-
-            ret = DW_DLV_ERROR != r;
         }
         while (DW_DLV_OK == r);
-
-        if (NULL != die)
-        {
-            dwarf_dealloc(m_dbg, die, DW_DLA_DIE);
-        }
     }
 
-    return ret;
+    // A compilation unit without children has no inlined functions
+    return DW_DLV_ERROR != r;
 }
 
-bool DwarfSymbolEngine::FindSourceLine(gtRVAddr rva, SourceLineInfo& sourceLine, bool handleInline)
+// Walk the DIE tree of a subprogram the same way ProcessInlinedFunctionInfo does, keeping the nesting of the inlined instances
+void DwarfSymbolEngine::CollectInlinedSubroutines(Dwarf_Die parentDie, Dwarf_Addr cuAddrLow, gtRVAddr callerRva, gtUInt32 callerSize,
+                                                  gtUInt32 parentIndex, SymbolCacheInlinedFunctions& inlinedFuncs) const
 {
-    bool ret = false;
-
-    if (NULL != m_pAuxSymEngine)
-    {
-        ret = m_pAuxSymEngine->FindSourceLine(rva, sourceLine, handleInline);
-    }
+    Dwarf_Die die;
 
-    if (!ret)
+    if (dwarf_child(parentDie, &die, NULL) == DW_DLV_OK)
     {
-        const FunctionSymbolInfo* pFuncInfo = LookupFunction(rva, NULL, handleInline);
+        int r;
 
-        if (NULL != pFuncInfo)
+        do
         {
-            sourceLine.m_filePath[0] = L'\0';
-            sourceLine.m_rva = rva;
-            ForeachCompilationUnit(&DwarfSymbolEngine::TraverseSourceLineInfo, &sourceLine);
-            sourceLine.m_rva = pFuncInfo->m_rva;
+            Dwarf_Half tag;
 
-            if (L'\0' != sourceLine.m_filePath[0])
+            if (dwarf_tag(die, &tag, NULL) != DW_DLV_OK)
             {
-                ret = true;
+                dwarf_dealloc(m_dbg, die, DW_DLA_DIE);
+                break;
+            }
+
+            if (DW_TAG_subprogram == tag || DW_TAG_lexical_block == tag)
+            {
+                CollectInlinedSubroutines(die, cuAddrLow, callerRva, callerSize, parentIndex, inlinedFuncs);
+            }
+            else if (DW_TAG_inlined_subroutine == tag)
+            {
+                gtUInt32 index = parentIndex;
+                Dwarf_Addr addrLow = 0, addrHigh = 0;
+                gtVector<FuncAddressRange> addrRanges;
+
+                if (DieFindLowHighAddress(die, tag, cuAddrLow, addrLow, addrHigh, &addrRanges))
+                {
+                    gtSort(addrRanges.begin(), addrRanges.end());
+
+                    FunctionSymbolInfo funcInfo;
+                    funcInfo.m_pName = ExtractSubprogramName(m_dbg, die);
+
+                    SymbolCacheInlinedFunction inlined;
+                    inlined.m_rva = static_cast<gtUInt32>(addrLow - m_pExe->GetImageBase());
+                    inlined.m_size = static_cast<gtUInt32>(addrHigh - addrLow);
+                    inlined.m_callerRva = callerRva;
+                    inlined.m_callerSize = callerSize;
+                    inlined.m_parentIndex = parentIndex;
+                    inlined.m_firstRange = static_cast<gtUInt32>(inlinedFuncs.m_ranges.size());
+                    inlined.m_numRanges = static_cast<gtUInt32>(addrRanges.size());
+                    inlined.m_nameOffset = SYMBOL_CACHE_NO_NAME;
+
+                    if (NULL != funcInfo.m_pName)
+                    {
+                        UpdateInlinedFunctionName(funcInfo);
+                        inlined.m_nameOffset = static_cast<gtUInt32>(inlinedFuncs.m_names.size());
+                        inlinedFuncs.m_names.insert(inlinedFuncs.m_names.end(), funcInfo.m_pName, funcInfo.m_pName + wcslen(funcInfo.m_pName) + 1);
+                        delete [] funcInfo.m_pName;
+                    }
+
+                    inlinedFuncs.m_ranges.insert(inlinedFuncs.m_ranges.end(), addrRanges.begin(), addrRanges.end());
+
+                    index = static_cast<gtUInt32>(inlinedFuncs.m_funcs.size());
+                    inlinedFuncs.m_funcs.push_back(inlined);
+                }
+
+                // inlined_subroutine might contain another inlined_subroutine
+                CollectInlinedSubroutines(die, cuAddrLow, callerRva, callerSize, index, inlinedFuncs);
             }
+
+            Dwarf_Die siblingDie = NULL;
+            r = dwarf_siblingof(m_dbg, die, &siblingDie, NULL);
+            dwarf_dealloc(m_dbg, die, DW_DLA_DIE);
+            die = siblingDie;
         }
+        while (DW_DLV_OK == r);
     }
-
-    return ret;
 }
 
 gtByte* DwarfSymbolEngine::AllocateBuffer(unsigned size)
@@ -655,6 +778,11 @@ void DwarfSymbolEngine::Clear(bool deinit)
     {
         ClearInlinedFunctionInfo();
     }
+
+    m_sourceLines.clear();
+    m_sourceFiles.clear();
+    m_sourceFileIndices.clear();
+    m_isSourceLineTableBuilt = false;
 }
 
 void DwarfSymbolEngine::ClearInlinedFunctionInfo()
@@ -11,6 +11,7 @@
 #define _DWARFSYMBOLENGINE_H_
 
 #include "../Generics/ModularSymbolEngine.h"
+#include <AMDTBaseTools/Include/gtString.h>
 #include <AMDTBaseTools/Include/gtHashMap.h>
 #include <AMDTOSWrappers/Include/osReadWriteLock.h>
 #include <AMDTOSWrappers/Include/osCriticalSection.h>
@@ -21,6 +22,7 @@ extern "C"
 }
 
 class ExecutableFile;
+struct SymbolCacheInlinedFunctions;
 
 class DwarfSymbolEngine : public ModularSymbolEngine
 {
@@ -108,13 +110,26 @@ public:
     /// -----------------------------------------------------------------------------------------------
     virtual gtVector<gtRVAddr> FindNestedInlineFunctions(gtRVAddr rva) const;
 
+    /// -----------------------------------------------------------------------------------------------
+    /// \brief Sets the symbol cache file to write the symbols to, once the source line table gets built.
+    ///
+    /// \param[in] pCacheFilePath The full name of the symbol cache file.
+    /// \param[in] signature The signature of the executable.
+    /// -----------------------------------------------------------------------------------------------
+    void SetSymbolCacheFile(const wchar_t* pCacheFilePath, gtUInt64 signature);
+
     const ExecutableFile* GetExecutable() const { return m_pExe; }
     gtByte* AllocateBuffer(unsigned size);
 
 private:
     bool TraverseSubprograms(struct _Dwarf_Die* cuDie, void* pData);
-    bool TraverseSourceLines(struct _Dwarf_Die* cuDie, void* pData);
-    bool TraverseSourceLineInfo(struct _Dwarf_Die* cuDie, void* pData);
+    bool TraverseSourceLineTable(struct _Dwarf_Die* cuDie, void* pData);
+    bool TraverseInlinedSubroutines(struct _Dwarf_Die* cuDie, void* pData);
+    void CollectInlinedSubroutines(Dwarf_Die parentDie, Dwarf_Addr cuAddrLow, gtRVAddr callerRva, gtUInt32 callerSize,
+                                   gtUInt32 parentIndex, SymbolCacheInlinedFunctions& inlinedFuncs) const;
+    void BuildSourceLineTable();
+    bool WriteSymbolCache();
+    unsigned AcquireSourceFileIndex(const char* pFilePath);
     bool ForeachCompilationUnit(bool (DwarfSymbolEngine::*pfnProcess)(struct _Dwarf_Die*, void*), void* pData = NULL);
     bool IsElf() const;
     void Clear(bool deinit = true);
@@ -150,6 +165,28 @@ private:
 
     typedef gtHashMap<gtRVAddr, gtVector<gtRVAddr>> NestedFuncMap;
     mutable NestedFuncMap m_nestedFuncMap;
+
+    // An entry of the line programs of all the compilation units
+    struct SourceLineEntry
+    {
+        gtRVAddr m_rva;
+        unsigned m_line;
+        unsigned m_fileIndex;
+
+        bool operator<(const SourceLineEntry& other) const { return m_rva < other.m_rva; }
+    };
+
+    // The line table of the module, built on the first source line query and sorted by RVA.
+    // Entries of the same RVA keep the order of the line programs.
+    gtVector<SourceLineEntry> m_sourceLines;
+    gtVector<std::string> m_sourceFiles;
+    gtMap<std::string, unsigned> m_sourceFileIndices;
+    volatile bool m_isSourceLineTableBuilt;
+
+    // The symbol cache file is written along with the source line table, so a module whose source lines
+    // are never queried does not pay for it
+    gtString m_symbolCacheFilePath;
+    gtUInt64 m_symbolCacheSignature;
 };
 
 #endif // _DWARFSYMBOLENGINE_H_
\ No newline at end of file
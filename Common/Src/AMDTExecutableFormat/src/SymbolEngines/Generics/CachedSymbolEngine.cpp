@@ -0,0 +1,918 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file CachedSymbolEngine.cpp
+/// \brief This file contains the class for querying the symbols of an on-disk symbol cache file.
+///
+//==================================================================================
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <AMDTBaseTools/Include/gtMap.h>
+#include <AMDTBaseTools/Include/gtString.h>
+#include <AMDTOSWrappers/Include/osAtomic.h>
+#include <AMDTOSWrappers/Include/osDebugLog.h>
+#include <AMDTOSWrappers/Include/osProcess.h>
+#include <ExecutableFile.h>
+#include "CachedSymbolEngine.h"
+
+#if AMDT_BUILD_TARGET != AMDT_WINDOWS_OS
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#define SYMBOL_CACHE_MAGIC              0x43535843U // "CXSC"
+#define SYMBOL_CACHE_VERSION            2
+#define SYMBOL_CACHE_FUNC_HAS_INLINES   0x1U
+#define SYMBOL_CACHE_HAS_INLINED_FUNCS  0x1U
+
+// The layout of a symbol cache file:
+//   SymbolCacheHeader
+//   SymbolCacheFunction[m_numFunctions]                - sorted by RVA
+//   SymbolCacheInlinedFunction[m_numInlinedFuncs]      - in the order of the debug information entries
+//   SymbolCacheRange[m_numInlinedRanges]               - address ranges of the inlined functions
+//   SymbolCacheLine[m_numSourceLines]                  - sorted by RVA
+//   gtUInt32[m_numSourceFiles]                         - offsets of the source file paths
+//   wchar_t[m_namesLength]                             - null terminated function and inlined function names
+//   char[m_sourceFilePathsSize]                        - null terminated source file paths
+struct SymbolCacheHeader
+{
+    gtUInt32 m_magic;
+    gtUInt16 m_version;
+    gtUInt16 m_charSize;
+    gtUInt64 m_signature;
+    gtUInt32 m_numFunctions;
+    gtUInt32 m_numInlinedFuncs;
+    gtUInt32 m_numInlinedRanges;
+    gtUInt32 m_numSourceLines;
+    gtUInt32 m_numSourceFiles;
+    gtUInt32 m_namesLength;
+    gtUInt32 m_sourceFilePathsSize;
+    gtUInt32 m_flags;
+};
+
+struct SymbolCacheFunction
+{
+    gtUInt32 m_rva;
+    gtUInt32 m_size;
+    gtUInt32 m_nameOffset;
+    gtUInt32 m_flags;
+};
+
+struct SymbolCacheRange
+{
+    gtUInt32 m_rvaStart;
+    gtUInt32 m_rvaEnd;
+};
+
+struct WideStringLess
+{
+    bool operator()(const wchar_t* pLeft, const wchar_t* pRight) const { return wcscmp(pLeft, pRight) < 0; }
+};
+
+static volatile gtInt32 s_numCacheHits = 0;
+static volatile gtInt32 s_numCacheMisses = 0;
+static volatile gtInt32 s_numTempFiles = 0;
+
+static FILE* OpenCacheFile(const wchar_t* pFilePath, const char* pMode);
+static bool RenameCacheFile(const wchar_t* pOldFilePath, const wchar_t* pNewFilePath);
+static void RemoveCacheFile(const wchar_t* pFilePath);
+static bool IsInInlinedInstance(const FunctionSymbolInfo& funcInfo, gtRVAddr rva);
+
+
+CachedSymbolEngine::CachedSymbolEngine() : m_pExe(NULL), m_processInlineSamples(false),
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+    m_hFile(INVALID_HANDLE_VALUE),
+    m_hFileMapping(NULL),
+#endif
+    m_pFileBase(NULL),
+    m_fileSize(0ULL),
+    m_pSourceLines(NULL),
+    m_numSourceLines(0U),
+    m_pSourceFileOffsets(NULL),
+    m_numSourceFiles(0U),
+    m_pSourceFilePaths(NULL),
+    m_sourceFilePathsSize(0U)
+{
+}
+
+CachedSymbolEngine::~CachedSymbolEngine()
+{
+    Clear();
+}
+
+bool CachedSymbolEngine::Initialize(const ExecutableFile& exe, const wchar_t* pCacheFilePath, gtUInt64 signature)
+{
+    bool ret = false;
+    m_pExe = &exe;
+    m_processInlineSamples = exe.IsProcessInlineInfo();
+
+    if (MapFile(pCacheFilePath))
+    {
+        const SymbolCacheHeader* pHeader = reinterpret_cast<const SymbolCacheHeader*>(m_pFileBase);
+
+        // A cache file written without the inlined functions does not serve an executable processing them
+        if (SYMBOL_CACHE_MAGIC == pHeader->m_magic &&
+            SYMBOL_CACHE_VERSION == pHeader->m_version &&
+            sizeof(wchar_t) == pHeader->m_charSize &&
+            signature == pHeader->m_signature &&
+            (!m_processInlineSamples || 0U != (pHeader->m_flags & SYMBOL_CACHE_HAS_INLINED_FUNCS)))
+        {
+            gtUInt64 funcsOffset = sizeof(SymbolCacheHeader);
+            gtUInt64 inlinedFuncsOffset = funcsOffset + static_cast<gtUInt64>(pHeader->m_numFunctions) * sizeof(SymbolCacheFunction);
+            gtUInt64 rangesOffset = inlinedFuncsOffset + static_cast<gtUInt64>(pHeader->m_numInlinedFuncs) * sizeof(SymbolCacheInlinedFunction);
+            gtUInt64 linesOffset = rangesOffset + static_cast<gtUInt64>(pHeader->m_numInlinedRanges) * sizeof(SymbolCacheRange);
+            gtUInt64 fileOffsetsOffset = linesOffset + static_cast<gtUInt64>(pHeader->m_numSourceLines) * sizeof(SymbolCacheLine);
+            gtUInt64 namesOffset = fileOffsetsOffset + static_cast<gtUInt64>(pHeader->m_numSourceFiles) * sizeof(gtUInt32);
+            gtUInt64 filePathsOffset = namesOffset + static_cast<gtUInt64>(pHeader->m_namesLength) * sizeof(wchar_t);
+
+            if ((filePathsOffset + pHeader->m_sourceFilePathsSize) == m_fileSize)
+            {
+                m_pSourceLines = reinterpret_cast<const SymbolCacheLine*>(m_pFileBase + linesOffset);
+                m_numSourceLines = pHeader->m_numSourceLines;
+                m_pSourceFileOffsets = reinterpret_cast<const gtUInt32*>(m_pFileBase + fileOffsetsOffset);
+                m_numSourceFiles = pHeader->m_numSourceFiles;
+                m_pSourceFilePaths = reinterpret_cast<const char*>(m_pFileBase + filePathsOffset);
+                m_sourceFilePathsSize = pHeader->m_sourceFilePathsSize;
+
+                ret = (0U == m_sourceFilePathsSize || '\0' == m_pSourceFilePaths[m_sourceFilePathsSize - 1]);
+
+                for (gtUInt32 i = 0; ret && i < m_numSourceFiles; ++i)
+                {
+                    ret = m_pSourceFileOffsets[i] < m_sourceFilePathsSize;
+                }
+
+                ret = ret && LoadFunctionsInfo(m_pFileBase + funcsOffset, m_pFileBase + namesOffset, pHeader->m_namesLength);
+
+                if (ret && m_processInlineSamples)
+                {
+                    ret = LoadInlinedFunctions(m_pFileBase + inlinedFuncsOffset, m_pFileBase + rangesOffset,
+                                               m_pFileBase + namesOffset, pHeader->m_namesLength);
+                }
+            }
+        }
+
+        if (!ret)
+        {
+            OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"Symbol cache file %ls is stale or corrupted", pCacheFilePath);
+            Clear();
+        }
+    }
+
+    gtInt32 numHits, numMisses;
+
+    if (ret)
+    {
+        numHits = AtomicAdd(s_numCacheHits, 1) + 1;
+        numMisses = s_numCacheMisses;
+    }
+    else
+    {
+        numHits = s_numCacheHits;
+        numMisses = AtomicAdd(s_numCacheMisses, 1) + 1;
+    }
+
+    OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"Symbol cache %ls for %ls (hits: %d, misses: %d)",
+                               ret ? L"hit" : L"miss", pCacheFilePath, numHits, numMisses);
+
+    return ret;
+}
+
+bool CachedSymbolEngine::LoadFunctionsInfo(const gtUByte* pFuncs, const gtUByte* pNames, gtUInt32 namesLength)
+{
+    const SymbolCacheHeader* pHeader = reinterpret_cast<const SymbolCacheHeader*>(m_pFileBase);
+    const SymbolCacheFunction* pFunc = reinterpret_cast<const SymbolCacheFunction*>(pFuncs);
+    const SymbolCacheFunction* pFuncEnd = pFunc + pHeader->m_numFunctions;
+    const wchar_t* pNamesBegin = reinterpret_cast<const wchar_t*>(pNames);
+
+    if (0U != namesLength && L'\0' != pNamesBegin[namesLength - 1])
+    {
+        return false;
+    }
+
+    InitializeFunctionsInfo();
+    m_pFuncsInfoVec->reserve(pHeader->m_numFunctions);
+
+    for (; pFunc != pFuncEnd; ++pFunc)
+    {
+        FunctionSymbolInfo funcInfo;
+        FUNCSYM_OFFSET_SUPPORT(funcInfo.m_offset = 0U;)
+        funcInfo.m_rva = pFunc->m_rva;
+        funcInfo.m_size = pFunc->m_size;
+        funcInfo.m_hasInlines = (0U != (pFunc->m_flags & SYMBOL_CACHE_FUNC_HAS_INLINES));
+        funcInfo.m_addrRanges = NULL;
+
+        // The names are copied, as the functions may be spliced with those of another symbol engine
+        if (SYMBOL_CACHE_NO_NAME == pFunc->m_nameOffset)
+        {
+            funcInfo.m_pName = NULL;
+        }
+        else if (pFunc->m_nameOffset < namesLength)
+        {
+            const wchar_t* pName = pNamesBegin + pFunc->m_nameOffset;
+            size_t len = wcslen(pName);
+            funcInfo.m_pName = new wchar_t[len + 1];
+            memcpy(funcInfo.m_pName, pName, (len + 1) * sizeof(wchar_t));
+        }
+        else
+        {
+            return false;
+        }
+
+        funcInfo.m_funcId = AtomicAdd(m_nextFuncId, 1);
+        m_pFuncsInfoVec->push_back(funcInfo);
+    }
+
+    return true;
+}
+
+bool CachedSymbolEngine::LoadInlinedFunctions(const gtUByte* pInlinedFuncs, const gtUByte* pRanges, const gtUByte* pNames, gtUInt32 namesLength)
+{
+    const SymbolCacheHeader* pHeader = reinterpret_cast<const SymbolCacheHeader*>(m_pFileBase);
+    const SymbolCacheInlinedFunction* pInlinedFuncsBegin = reinterpret_cast<const SymbolCacheInlinedFunction*>(pInlinedFuncs);
+    const SymbolCacheRange* pRangesBegin = reinterpret_cast<const SymbolCacheRange*>(pRanges);
+    wchar_t* pNamesBegin = const_cast<wchar_t*>(reinterpret_cast<const wchar_t*>(pNames));
+
+    gtUInt32 numInlinedFuncs = pHeader->m_numInlinedFuncs;
+    m_inlinedFuncs.reserve(numInlinedFuncs);
+
+    // All the instances of a function are aggregated to the one of the lowest address
+    gtMap<const wchar_t*, gtUInt32, WideStringLess> aggrIndices;
+
+    for (gtUInt32 i = 0; i < numInlinedFuncs; ++i)
+    {
+        const SymbolCacheInlinedFunction& cacheFunc = pInlinedFuncsBegin[i];
+
+        // An instance only refers to the instances enclosing it, which come before it
+        if ((SYMBOL_CACHE_NO_PARENT != cacheFunc.m_parentIndex && i <= cacheFunc.m_parentIndex) ||
+            (static_cast<gtUInt64>(cacheFunc.m_firstRange) + cacheFunc.m_numRanges) > pHeader->m_numInlinedRanges ||
+            (SYMBOL_CACHE_NO_NAME != cacheFunc.m_nameOffset && namesLength <= cacheFunc.m_nameOffset))
+        {
+            return false;
+        }
+
+        InlinedFunction inlined;
+        FUNCSYM_OFFSET_SUPPORT(inlined.m_funcInfo.m_offset = 0U;)
+        inlined.m_funcInfo.m_rva = cacheFunc.m_rva;
+        inlined.m_funcInfo.m_size = cacheFunc.m_size;
+        inlined.m_funcInfo.m_hasInlines = false;
+        inlined.m_funcInfo.m_addrRanges = NULL;
+        inlined.m_funcInfo.m_funcId = AtomicAdd(m_nextFuncId, 1);
+        inlined.m_callerRva = cacheFunc.m_callerRva;
+        inlined.m_callerSize = cacheFunc.m_callerSize;
+        inlined.m_parentIndex = cacheFunc.m_parentIndex;
+        inlined.m_aggrIndex = i;
+
+        // The inlined functions are never spliced, so their names are used in place, from the mapped file
+        inlined.m_funcInfo.m_pName = (SYMBOL_CACHE_NO_NAME != cacheFunc.m_nameOffset) ? (pNamesBegin + cacheFunc.m_nameOffset) : NULL;
+
+        if (0U != cacheFunc.m_numRanges)
+        {
+            inlined.m_funcInfo.m_addrRanges = new gtVector<FuncAddressRange>;
+            inlined.m_funcInfo.m_addrRanges->reserve(cacheFunc.m_numRanges);
+
+            for (const SymbolCacheRange* pRange = pRangesBegin + cacheFunc.m_firstRange, *pRangeEnd = pRange + cacheFunc.m_numRanges;
+                 pRange != pRangeEnd; ++pRange)
+            {
+                inlined.m_funcInfo.m_addrRanges->push_back(FuncAddressRange(pRange->m_rvaStart, pRange->m_rvaEnd));
+            }
+        }
+
+        m_inlinedFuncs.push_back(inlined);
+
+        if (NULL != inlined.m_funcInfo.m_pName)
+        {
+            auto res = aggrIndices.insert(gtMap<const wchar_t*, gtUInt32, WideStringLess>::value_type(inlined.m_funcInfo.m_pName, i));
+
+            if (!res.second && cacheFunc.m_rva < m_inlinedFuncs[res.first->second].m_funcInfo.m_rva)
+            {
+                res.first->second = i;
+            }
+        }
+    }
+
+    m_inlinedFuncsByCaller.reserve(numInlinedFuncs);
+
+    for (gtUInt32 i = 0; i < numInlinedFuncs; ++i)
+    {
+        InlinedFunction& inlined = m_inlinedFuncs[i];
+
+        if (NULL != inlined.m_funcInfo.m_pName)
+        {
+            inlined.m_aggrIndex = aggrIndices[inlined.m_funcInfo.m_pName];
+        }
+
+        m_inlinedFuncsByCaller.push_back(i);
+    }
+
+    // The instances of a caller keep the order of the file
+    std::stable_sort(m_inlinedFuncsByCaller.begin(), m_inlinedFuncsByCaller.end(), [this](gtUInt32 left, gtUInt32 right)
+    {
+        return m_inlinedFuncs[left].m_callerRva < m_inlinedFuncs[right].m_callerRva;
+    });
+
+    return true;
+}
+
+bool CachedSymbolEngine::MapFile(const wchar_t* pCacheFilePath)
+{
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+    m_hFile = CreateFileW(pCacheFilePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, NULL);
+
+    if (INVALID_HANDLE_VALUE != m_hFile)
+    {
+        LARGE_INTEGER fileSize;
+
+        if (GetFileSizeEx(m_hFile, &fileSize) && sizeof(SymbolCacheHeader) <= static_cast<gtUInt64>(fileSize.QuadPart))
+        {
+            m_hFileMapping = CreateFileMappingW(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+            if (NULL != m_hFileMapping)
+            {
+                m_pFileBase = static_cast<const gtUByte*>(MapViewOfFile(m_hFileMapping, FILE_MAP_READ, 0, 0, 0));
+
+                if (NULL != m_pFileBase)
+                {
+                    m_fileSize = static_cast<gtUInt64>(fileSize.QuadPart);
+                }
+            }
+        }
+    }
+#else
+    char cacheFilePathMb[OS_MAX_PATH];
+
+    if (size_t(-1) != wcstombs(cacheFilePathMb, pCacheFilePath, OS_MAX_PATH))
+    {
+        int fd = open(cacheFilePathMb, O_RDONLY);
+
+        if (fd >= 0)
+        {
+            struct stat fileStat;
+
+            if (0 == fstat(fd, &fileStat) && sizeof(SymbolCacheHeader) <= static_cast<gtUInt64>(fileStat.st_size))
+            {
+                void* pFileBase = mmap(NULL, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+                if (MAP_FAILED != pFileBase)
+                {
+                    m_pFileBase = static_cast<const gtUByte*>(pFileBase);
+                    m_fileSize = static_cast<gtUInt64>(fileStat.st_size);
+                }
+            }
+
+            // The mapping outlives the file descriptor
+            close(fd);
+        }
+    }
+#endif
+
+    if (NULL == m_pFileBase)
+    {
+        Clear();
+    }
+
+    return NULL != m_pFileBase;
+}
+
+void CachedSymbolEngine::Clear()
+{
+    if (NULL != m_pFuncsInfoVec)
+    {
+        ClearFunctionsInfo();
+    }
+
+    for (gtVector<InlinedFunction>::iterator it = m_inlinedFuncs.begin(), itEnd = m_inlinedFuncs.end(); it != itEnd; ++it)
+    {
+        if (NULL != it->m_funcInfo.m_addrRanges)
+        {
+            delete it->m_funcInfo.m_addrRanges;
+        }
+    }
+
+    m_inlinedFuncs.clear();
+    m_inlinedFuncsByCaller.clear();
+
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+
+    if (NULL != m_pFileBase)
+    {
+        UnmapViewOfFile(m_pFileBase);
+    }
+
+    if (NULL != m_hFileMapping)
+    {
+        CloseHandle(m_hFileMapping);
+        m_hFileMapping = NULL;
+    }
+
+    if (INVALID_HANDLE_VALUE != m_hFile)
+    {
+        CloseHandle(m_hFile);
+        m_hFile = INVALID_HANDLE_VALUE;
+    }
+
+#else
+
+    if (NULL != m_pFileBase)
+    {
+        munmap(const_cast<gtUByte*>(m_pFileBase), static_cast<size_t>(m_fileSize));
+    }
+
+#endif
+
+    m_pFileBase = NULL;
+    m_fileSize = 0ULL;
+    m_pSourceLines = NULL;
+    m_numSourceLines = 0U;
+    m_pSourceFileOffsets = NULL;
+    m_numSourceFiles = 0U;
+    m_pSourceFilePaths = NULL;
+    m_sourceFilePathsSize = 0U;
+}
+
+const FunctionSymbolInfo* CachedSymbolEngine::LookupFunction(gtRVAddr rva, gtRVAddr* pNextRva, bool handleInline) const
+{
+    const FunctionSymbolInfo* pFunc = LookupBoundingFunction(rva, pNextRva, handleInline);
+
+    if (NULL != pFunc)
+    {
+        if (0 == pFunc->m_size)
+        {
+            if (m_pExe->LookupSectionIndex(pFunc->m_rva) != m_pExe->LookupSectionIndex(rva))
+            {
+                pFunc = NULL;
+            }
+        }
+        else if (false == handleInline && (pFunc->m_rva + pFunc->m_size) <= rva)
+        {
+            pFunc = NULL;
+        }
+    }
+
+    return pFunc;
+}
+
+void CachedSymbolEngine::FindCallerInlinedInstances(gtRVAddr rva, const gtUInt32*& pBegin, const gtUInt32*& pEnd) const
+{
+    pBegin = NULL;
+    pEnd = NULL;
+
+    if (!m_inlinedFuncsByCaller.empty())
+    {
+        const gtUInt32* pIndicesBegin = m_inlinedFuncsByCaller.data();
+        const gtUInt32* pIndicesEnd = pIndicesBegin + m_inlinedFuncsByCaller.size();
+
+        // The instances of the last caller starting at or before the RVA
+        const gtUInt32* pIt = std::upper_bound(pIndicesBegin, pIndicesEnd, rva, [this](gtRVAddr value, gtUInt32 index)
+        {
+            return value < m_inlinedFuncs[index].m_callerRva;
+        });
+
+        if (pIndicesBegin != pIt)
+        {
+            const InlinedFunction& caller = m_inlinedFuncs[*(pIt - 1)];
+
+            if ((rva - caller.m_callerRva) < caller.m_callerSize)
+            {
+                gtRVAddr callerRva = caller.m_callerRva;
+                pEnd = pIt;
+                pBegin = std::lower_bound(pIndicesBegin, pIt, callerRva, [this](gtUInt32 index, gtRVAddr value)
+                {
+                    return m_inlinedFuncs[index].m_callerRva < value;
+                });
+            }
+        }
+    }
+}
+
+const CachedSymbolEngine::InlinedFunction* CachedSymbolEngine::FindInlinedInstance(gtRVAddr rva) const
+{
+    const InlinedFunction* pMatch = NULL;
+    const gtUInt32* pIt;
+    const gtUInt32* pEnd;
+    FindCallerInlinedInstances(rva, pIt, pEnd);
+
+    for (; pIt != pEnd; ++pIt)
+    {
+        const InlinedFunction& inlined = m_inlinedFuncs[*pIt];
+
+        // The instance starting the closest to the RVA, the innermost one if several start at the same address
+        if (IsInInlinedInstance(inlined.m_funcInfo, rva) && (NULL == pMatch || pMatch->m_funcInfo.m_rva <= inlined.m_funcInfo.m_rva))
+        {
+            pMatch = &inlined;
+        }
+    }
+
+    return pMatch;
+}
+
+const FunctionSymbolInfo* CachedSymbolEngine::LookupInlinedFunction(gtRVAddr rva) const
+{
+    const FunctionSymbolInfo* pFunc = NULL;
+
+    if (m_processInlineSamples)
+    {
+        const InlinedFunction* pInlined = FindInlinedInstance(rva);
+
+        if (NULL != pInlined)
+        {
+            pFunc = &m_inlinedFuncs[pInlined->m_aggrIndex].m_funcInfo;
+        }
+    }
+
+    return pFunc;
+}
+
+gtRVAddr CachedSymbolEngine::TranslateToInlineeRVA(gtRVAddr rva) const
+{
+    gtRVAddr funcRva = rva;
+    const InlinedFunction* pInlined = FindInlinedInstance(rva);
+
+    if (NULL != pInlined && pInlined->m_aggrIndex != static_cast<gtUInt32>(pInlined - m_inlinedFuncs.data()))
+    {
+        const FunctionSymbolInfo* pMatchFunc = &pInlined->m_funcInfo;
+        const FunctionSymbolInfo* pFunc = &m_inlinedFuncs[pInlined->m_aggrIndex].m_funcInfo;
+        funcRva = pFunc->m_rva;
+        gtRVAddr offset = 0;
+
+        if (NULL != pMatchFunc->m_addrRanges)
+        {
+            // calculate offset from the ranges
+            for (auto& it : * (pMatchFunc->m_addrRanges))
+            {
+                if (rva < it.m_rvaStart)
+                {
+                    break;
+                }
+
+                if (rva < it.m_rvaEnd)
+                {
+                    offset += rva - it.m_rvaStart;
+                }
+                else
+                {
+                    offset += it.m_rvaEnd - it.m_rvaStart;
+                }
+            }
+        }
+        else
+        {
+            offset = rva - pMatchFunc->m_rva;
+        }
+
+        if (NULL != pFunc->m_addrRanges)
+        {
+            for (auto& it : * (pFunc->m_addrRanges))
+            {
+                if (offset >= (it.m_rvaEnd - it.m_rvaStart))
+                {
+                    offset -= (it.m_rvaEnd - it.m_rvaStart);
+                }
+                else
+                {
+                    funcRva = it.m_rvaStart + offset;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            funcRva += offset;
+        }
+    }
+
+    return funcRva;
+}
+
+gtVector<gtRVAddr> CachedSymbolEngine::FindNestedInlineFunctions(gtRVAddr rva) const
+{
+    gtVector<gtRVAddr> list;
+
+    if (NULL != LookupInlinedFunction(rva))
+    {
+        const gtUInt32* pIt;
+        const gtUInt32* pEnd;
+        FindCallerInlinedInstances(rva, pIt, pEnd);
+
+        // Follow the first instance containing the RVA, from the outermost inlined function to the innermost one
+        gtUInt32 parentIndex = SYMBOL_CACHE_NO_PARENT;
+
+        for (; pIt != pEnd; ++pIt)
+        {
+            const InlinedFunction& inlined = m_inlinedFuncs[*pIt];
+
+            if (parentIndex == inlined.m_parentIndex &&
+                inlined.m_funcInfo.m_rva <= rva && rva < (inlined.m_funcInfo.m_rva + inlined.m_funcInfo.m_size))
+            {
+                if (list.empty())
+                {
+                    list.push_back(inlined.m_callerRva);
+                }
+
+                list.push_back(TranslateToInlineeRVA(inlined.m_funcInfo.m_rva));
+                parentIndex = *pIt;
+            }
+        }
+    }
+
+    if (list.empty())
+    {
+        // failed to find any list. just return the same rva back.
+        list.push_back(rva);
+    }
+
+    return list;
+}
+
+bool CachedSymbolEngine::EnumerateSourceLineInstances(const wchar_t* pSourceFilePath, SrcLineInstanceMap& srcLineInstanceMap, bool handleInline)
+{
+    GT_UNREFERENCED_PARAMETER(handleInline);
+    char sourceFilePathMb[OS_MAX_PATH];
+
+    if ((size_t)(-1) != wcstombs(sourceFilePathMb, pSourceFilePath, OS_MAX_PATH))
+    {
+        for (gtUInt32 fileIndex = 0; fileIndex < m_numSourceFiles; ++fileIndex)
+        {
+            if (0 == strcmp(sourceFilePathMb, m_pSourceFilePaths + m_pSourceFileOffsets[fileIndex]))
+            {
+                for (const SymbolCacheLine* pLine = m_pSourceLines, *pLineEnd = m_pSourceLines + m_numSourceLines; pLine != pLineEnd; ++pLine)
+                {
+                    if (fileIndex == pLine->m_fileIndex)
+                    {
+                        srcLineInstanceMap[pLine->m_rva] = pLine->m_line;
+                    }
+                }
+
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool CachedSymbolEngine::FindSourceLine(gtRVAddr rva, SourceLineInfo& sourceLine, bool handleInline)
+{
+    bool ret = false;
+    const FunctionSymbolInfo* pFuncInfo = LookupFunction(rva, NULL, handleInline);
+
+    if (NULL != pFuncInfo)
+    {
+        // The closest line at or before the RVA, the first one of the line programs if there are several
+        const SymbolCacheLine* pLinesEnd = m_pSourceLines + m_numSourceLines;
+        const SymbolCacheLine* pLine = std::upper_bound(m_pSourceLines, pLinesEnd, rva, [](gtRVAddr value, const SymbolCacheLine& line)
+        {
+            return value < line.m_rva;
+        });
+
+        if (m_pSourceLines != pLine)
+        {
+            gtRVAddr lineRva = (--pLine)->m_rva;
+
+            while (m_pSourceLines != pLine && (pLine - 1)->m_rva == lineRva)
+            {
+                --pLine;
+            }
+
+            if (pLine->m_fileIndex < m_numSourceFiles &&
+                (size_t)(-1) != mbstowcs(sourceLine.m_filePath, m_pSourceFilePaths + m_pSourceFileOffsets[pLine->m_fileIndex], OS_MAX_PATH))
+            {
+                sourceLine.m_rva = pFuncInfo->m_rva;
+                sourceLine.m_offset = rva - lineRva;
+                sourceLine.m_line = pLine->m_line;
+                ret = true;
+            }
+        }
+    }
+
+    return ret;
+}
+
+bool CachedSymbolEngine::Write(const wchar_t* pCacheFilePath, gtUInt64 signature, const gtVector<FunctionSymbolInfo>& funcsInfo,
+                               const SymbolCacheInlinedFunctions* pInlinedFuncs,
+                               const gtVector<SymbolCacheLine>& sourceLines, const gtVector<std::string>& sourceFiles)
+{
+    gtVector<SymbolCacheFunction> funcs;
+    gtVector<wchar_t> names;
+    funcs.reserve(funcsInfo.size());
+
+    for (gtVector<FunctionSymbolInfo>::const_iterator it = funcsInfo.begin(), itEnd = funcsInfo.end(); it != itEnd; ++it)
+    {
+        SymbolCacheFunction func;
+        func.m_rva = it->m_rva;
+        func.m_size = it->m_size;
+        func.m_flags = it->m_hasInlines ? SYMBOL_CACHE_FUNC_HAS_INLINES : 0U;
+
+        if (NULL != it->m_pName)
+        {
+            func.m_nameOffset = static_cast<gtUInt32>(names.size());
+            names.insert(names.end(), it->m_pName, it->m_pName + wcslen(it->m_pName) + 1);
+        }
+        else
+        {
+            func.m_nameOffset = SYMBOL_CACHE_NO_NAME;
+        }
+
+        funcs.push_back(func);
+    }
+
+    gtVector<SymbolCacheInlinedFunction> inlinedFuncs;
+    gtVector<SymbolCacheRange> ranges;
+
+    if (NULL != pInlinedFuncs)
+    {
+        // The inlined function names follow the function names
+        gtUInt32 inlinedNamesOffset = static_cast<gtUInt32>(names.size());
+        names.insert(names.end(), pInlinedFuncs->m_names.begin(), pInlinedFuncs->m_names.end());
+
+        inlinedFuncs = pInlinedFuncs->m_funcs;
+
+        for (gtVector<SymbolCacheInlinedFunction>::iterator it = inlinedFuncs.begin(), itEnd = inlinedFuncs.end(); it != itEnd; ++it)
+        {
+            if (SYMBOL_CACHE_NO_NAME != it->m_nameOffset)
+            {
+                it->m_nameOffset += inlinedNamesOffset;
+            }
+        }
+
+        ranges.reserve(pInlinedFuncs->m_ranges.size());
+
+        for (gtVector<FuncAddressRange>::const_iterator it = pInlinedFuncs->m_ranges.begin(), itEnd = pInlinedFuncs->m_ranges.end(); it != itEnd; ++it)
+        {
+            SymbolCacheRange range;
+            range.m_rvaStart = it->m_rvaStart;
+            range.m_rvaEnd = it->m_rvaEnd;
+            ranges.push_back(range);
+        }
+    }
+
+    gtVector<gtUInt32> fileOffsets;
+    gtVector<char> filePaths;
+    fileOffsets.reserve(sourceFiles.size());
+
+    for (gtVector<std::string>::const_iterator it = sourceFiles.begin(), itEnd = sourceFiles.end(); it != itEnd; ++it)
+    {
+        fileOffsets.push_back(static_cast<gtUInt32>(filePaths.size()));
+        filePaths.insert(filePaths.end(), it->c_str(), it->c_str() + it->size() + 1);
+    }
+
+    SymbolCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.m_magic = SYMBOL_CACHE_MAGIC;
+    header.m_version = SYMBOL_CACHE_VERSION;
+    header.m_charSize = static_cast<gtUInt16>(sizeof(wchar_t));
+    header.m_signature = signature;
+    header.m_numFunctions = static_cast<gtUInt32>(funcs.size());
+    header.m_numInlinedFuncs = static_cast<gtUInt32>(inlinedFuncs.size());
+    header.m_numInlinedRanges = static_cast<gtUInt32>(ranges.size());
+    header.m_numSourceLines = static_cast<gtUInt32>(sourceLines.size());
+    header.m_numSourceFiles = static_cast<gtUInt32>(fileOffsets.size());
+    header.m_namesLength = static_cast<gtUInt32>(names.size());
+    header.m_sourceFilePathsSize = static_cast<gtUInt32>(filePaths.size());
+    header.m_flags = (NULL != pInlinedFuncs) ? SYMBOL_CACHE_HAS_INLINED_FUNCS : 0U;
+
+    // Other translations may map the cache file at any time, so it is written aside and then renamed.
+    // The threads of a process may write the same cache file concurrently, so each one gets its own temporary file.
+    gtString tempFilePath(pCacheFilePath);
+    tempFilePath.append(L'.').appendUnsignedIntNumber(static_cast<unsigned int>(osGetCurrentProcessId()));
+    tempFilePath.append(L'.').appendUnsignedIntNumber(static_cast<unsigned int>(AtomicAdd(s_numTempFiles, 1))).append(L".tmp");
+
+    bool ret = false;
+    FILE* pFile = OpenCacheFile(tempFilePath.asCharArray(), "wb");
+
+    if (NULL != pFile)
+    {
+        ret = (1 == fwrite(&header, sizeof(header), 1, pFile));
+        ret = ret && (funcs.size() == fwrite(funcs.data(), sizeof(SymbolCacheFunction), funcs.size(), pFile));
+        ret = ret && (inlinedFuncs.size() == fwrite(inlinedFuncs.data(), sizeof(SymbolCacheInlinedFunction), inlinedFuncs.size(), pFile));
+        ret = ret && (ranges.size() == fwrite(ranges.data(), sizeof(SymbolCacheRange), ranges.size(), pFile));
+        ret = ret && (sourceLines.size() == fwrite(sourceLines.data(), sizeof(SymbolCacheLine), sourceLines.size(), pFile));
+        ret = ret && (fileOffsets.size() == fwrite(fileOffsets.data(), sizeof(gtUInt32), fileOffsets.size(), pFile));
+        ret = ret && (names.size() == fwrite(names.data(), sizeof(wchar_t), names.size(), pFile));
+        ret = ret && (filePaths.size() == fwrite(filePaths.data(), sizeof(char), filePaths.size(), pFile));
+        ret = (0 == fclose(pFile)) && ret;
+
+        ret = ret && RenameCacheFile(tempFilePath.asCharArray(), pCacheFilePath);
+
+        if (!ret)
+        {
+            RemoveCacheFile(tempFilePath.asCharArray());
+        }
+    }
+
+    if (ret)
+    {
+        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_DEBUG, L"Symbol cache file %ls written: %u functions, %u inlined functions, %u lines of %u files",
+                                   pCacheFilePath, header.m_numFunctions, header.m_numInlinedFuncs, header.m_numSourceLines, header.m_numSourceFiles);
+    }
+    else
+    {
+        OS_OUTPUT_FORMAT_DEBUG_LOG(OS_DEBUG_LOG_ERROR, L"Failed to write the symbol cache file %ls", pCacheFilePath);
+    }
+
+    return ret;
+}
+
+void CachedSymbolEngine::GetStatistics(gtUInt32& numHits, gtUInt32& numMisses)
+{
+    numHits = static_cast<gtUInt32>(s_numCacheHits);
+    numMisses = static_cast<gtUInt32>(s_numCacheMisses);
+}
+
+
+static FILE* OpenCacheFile(const wchar_t* pFilePath, const char* pMode)
+{
+    FILE* pFile = NULL;
+
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+    wchar_t mode[8];
+
+    if ((size_t)(-1) != mbstowcs(mode, pMode, 8))
+    {
+        pFile = _wfopen(pFilePath, mode);
+    }
+
+#else
+    char filePathMb[OS_MAX_PATH];
+
+    if ((size_t)(-1) != wcstombs(filePathMb, pFilePath, OS_MAX_PATH))
+    {
+        pFile = fopen(filePathMb, pMode);
+    }
+
+#endif
+
+    return pFile;
+}
+
+static bool RenameCacheFile(const wchar_t* pOldFilePath, const wchar_t* pNewFilePath)
+{
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+    return FALSE != MoveFileExW(pOldFilePath, pNewFilePath, MOVEFILE_REPLACE_EXISTING);
+#else
+    bool ret = false;
+    char oldFilePathMb[OS_MAX_PATH];
+    char newFilePathMb[OS_MAX_PATH];
+
+    if ((size_t)(-1) != wcstombs(oldFilePathMb, pOldFilePath, OS_MAX_PATH) &&
+        (size_t)(-1) != wcstombs(newFilePathMb, pNewFilePath, OS_MAX_PATH))
+    {
+        ret = (0 == rename(oldFilePathMb, newFilePathMb));
+    }
+
+    return ret;
+#endif
+}
+
+static void RemoveCacheFile(const wchar_t* pFilePath)
+{
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+    _wremove(pFilePath);
+#else
+    char filePathMb[OS_MAX_PATH];
+
+    if ((size_t)(-1) != wcstombs(filePathMb, pFilePath, OS_MAX_PATH))
+    {
+        remove(filePathMb);
+    }
+
+#endif
+}
+
+static bool IsInInlinedInstance(const FunctionSymbolInfo& funcInfo, gtRVAddr rva)
+{
+    bool matchFound = false;
+
+    if (funcInfo.m_rva <= rva)
+    {
+        if (NULL != funcInfo.m_addrRanges)
+        {
+            // do a linear search in the addr range vector
+            for (auto& it : * (funcInfo.m_addrRanges))
+            {
+                if (it.m_rvaStart <= rva && rva < it.m_rvaEnd)
+                {
+                    matchFound = true;
+                    break;
+                }
+
+                // no further search needed
+                if (rva < it.m_rvaStart)
+                {
+                    break;
+                }
+            }
+        }
+
+        if (!matchFound)
+        {
+            matchFound = rva < (funcInfo.m_rva + funcInfo.m_size);
+        }
+    }
+
+    return matchFound;
+}
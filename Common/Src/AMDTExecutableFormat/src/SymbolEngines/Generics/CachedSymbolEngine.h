@@ -0,0 +1,209 @@
+//==================================================================================
+// Copyright (c) 2016 , Advanced Micro Devices, Inc.  All rights reserved.
+//
+/// \author AMD Developer Tools Team
+/// \file CachedSymbolEngine.h
+/// \brief This file contains the class for querying the symbols of an on-disk symbol cache file.
+///
+//==================================================================================
+
+#ifndef _CACHEDSYMBOLENGINE_H_
+#define _CACHEDSYMBOLENGINE_H_
+
+#include "ModularSymbolEngine.h"
+#include <string>
+
+class ExecutableFile;
+
+/// -----------------------------------------------------------------------------------------------
+/// \struct SymbolCacheLine
+/// \brief A source line entry, as stored in the symbol cache file.
+/// -----------------------------------------------------------------------------------------------
+struct SymbolCacheLine
+{
+    gtUInt32 m_rva;       ///< The relative virtual address to the image base
+    gtUInt32 m_line;      ///< The line number
+    gtUInt32 m_fileIndex; ///< The index of the source file path
+};
+
+/// -----------------------------------------------------------------------------------------------
+/// \struct SymbolCacheInlinedFunction
+/// \brief An inlined function instance, as stored in the symbol cache file.
+/// -----------------------------------------------------------------------------------------------
+struct SymbolCacheInlinedFunction
+{
+    gtUInt32 m_rva;         ///< The low address of the instance, relative to the image base
+    gtUInt32 m_size;        ///< The size of the instance, from its low to its high address
+    gtUInt32 m_callerRva;   ///< The low address of the function the instance is inlined in
+    gtUInt32 m_callerSize;  ///< The size of the function the instance is inlined in
+    gtUInt32 m_parentIndex; ///< The index of the enclosing inlined instance, SYMBOL_CACHE_NO_PARENT for none
+    gtUInt32 m_firstRange;  ///< The index of the first address range of the instance
+    gtUInt32 m_numRanges;   ///< The number of address ranges of the instance, sorted by address
+    gtUInt32 m_nameOffset;  ///< The offset of the name, SYMBOL_CACHE_NO_NAME for none
+};
+
+/// -----------------------------------------------------------------------------------------------
+/// \struct SymbolCacheInlinedFunctions
+/// \brief The inlined function instances of all the functions of a module, in the order of the debug
+///        information entries, so an instance always comes after the instances enclosing it.
+/// -----------------------------------------------------------------------------------------------
+struct SymbolCacheInlinedFunctions
+{
+    gtVector<SymbolCacheInlinedFunction> m_funcs;
+    gtVector<FuncAddressRange> m_ranges;
+    gtVector<wchar_t> m_names;          ///< The null terminated names indexed by the instances
+};
+
+#define SYMBOL_CACHE_NO_NAME            0xFFFFFFFFU
+#define SYMBOL_CACHE_NO_PARENT          0xFFFFFFFFU
+
+class CachedSymbolEngine : public ModularSymbolEngine
+{
+public:
+    CachedSymbolEngine();
+    virtual ~CachedSymbolEngine();
+
+    /// -----------------------------------------------------------------------------------------------
+    /// \brief Maps the symbol cache file of the image file.
+    ///
+    /// \param[in] exe The executable to load the symbols for.
+    /// \param[in] pCacheFilePath The full name of the symbol cache file.
+    /// \param[in] signature The signature of the executable, which the cache file must match.
+    ///
+    /// \return A boolean value indicating whether a valid cache file was mapped.
+    /// -----------------------------------------------------------------------------------------------
+    bool Initialize(const ExecutableFile& exe, const wchar_t* pCacheFilePath, gtUInt64 signature);
+
+    /// -----------------------------------------------------------------------------------------------
+    /// \brief Searches for the information of the function containing the RVA.
+    ///
+    /// \param[in] rva The image relative virtual address.
+    /// \param[out] pNextRva The image relative virtual address of the following FunctionSymbolInfo.
+    /// \param[in] handleInline Return inlined function (true) or caller function (false).
+    ///
+    /// \return The FunctionSymbolInfo of the function containing the RVA.
+    /// -----------------------------------------------------------------------------------------------
+    virtual const FunctionSymbolInfo* LookupFunction(gtRVAddr rva, gtRVAddr* pNextRva = NULL, bool handleInline = false) const;
+
+    /// -----------------------------------------------------------------------------------------------
+    /// \brief Searches for the information of the inlined function containing the RVA.
+    ///
+    /// \param[in] rva The image relative virtual address.
+    ///
+    /// \return The FunctionSymbolInfo of the inlined function containing the RVA, if such exists.
+    /// -----------------------------------------------------------------------------------------------
+    virtual const FunctionSymbolInfo* LookupInlinedFunction(gtRVAddr rva) const;
+
+    /// -----------------------------------------------------------------------------------------------
+    /// \brief Enumerates and associate a given source file line numbers with the corresponding image RVAs.
+    ///
+    /// \param[in] pSourceFilePath The full name of the source file's lines to enumerate.
+    /// \param[out] srcLineInstanceMap The map of the image RVAs to line numbers.
+    /// \param[in] handleInline Include inlined function (true) or caller function (false).
+    ///
+    /// \return A boolean value indicating success or failure of the enumeration.
+    /// -----------------------------------------------------------------------------------------------
+    virtual bool EnumerateSourceLineInstances(const wchar_t* pSourceFilePath, SrcLineInstanceMap& srcLineInstanceMap, bool handleInline = false);
+
+    /// -----------------------------------------------------------------------------------------------
+    /// \brief Searches for the source line information of a RVA.
+    ///
+    /// \param[in] rva The image relative virtual address.
+    /// \param[out] sourceLine The found source line information.
+    /// \param[in] handleInline Include inlined function (true) or caller function (false).
+    ///
+    /// \return A boolean value indicating whether the a source line information was found.
+    /// -----------------------------------------------------------------------------------------------
+    virtual bool FindSourceLine(gtRVAddr rva, SourceLineInfo& sourceLine, bool handleInline = false);
+
+    /// -----------------------------------------------------------------------------------------------
+    /// \brief Check if the symbols are complete (or partial).
+    ///
+    /// \return A boolean value indicating whether the symbols are complete.
+    /// -----------------------------------------------------------------------------------------------
+    virtual bool IsComplete() const { return true; }
+
+    /// -----------------------------------------------------------------------------------------------
+    /// \brief Convert the inlined RVA in the calling function to the corresponding RVA of inline function.
+    ///
+    /// \param[in] rva The RVA to be converted.
+    ///
+    /// \return The coverted RVA. If RVA is not the inlined code then return same RVA.
+    /// -----------------------------------------------------------------------------------------------
+    virtual gtRVAddr TranslateToInlineeRVA(gtRVAddr rva) const;
+
+    /// -----------------------------------------------------------------------------------------------
+    /// \brief Find all the nested inlined caller function RVAs for given inlined callee function RVA.
+    ///
+    /// \param[in] rva The RVA to be searched.
+    ///
+    /// \return The list of RVAs. If input RVA is not inlined then return same RVA in the list.
+    /// -----------------------------------------------------------------------------------------------
+    virtual gtVector<gtRVAddr> FindNestedInlineFunctions(gtRVAddr rva) const;
+
+    /// -----------------------------------------------------------------------------------------------
+    /// \brief Writes a symbol cache file.
+    ///
+    /// \param[in] pCacheFilePath The full name of the symbol cache file.
+    /// \param[in] signature The signature of the executable.
+    /// \param[in] funcsInfo The functions information, sorted by RVA.
+    /// \param[in] pInlinedFuncs The inlined function instances, or NULL if the inlined functions are not processed.
+    /// \param[in] sourceLines The source line table, sorted by RVA.
+    /// \param[in] sourceFiles The source file paths indexed by the source line table.
+    ///
+    /// \return A boolean value indicating success or failure of writing the file.
+    /// -----------------------------------------------------------------------------------------------
+    static bool Write(const wchar_t* pCacheFilePath, gtUInt64 signature, const gtVector<FunctionSymbolInfo>& funcsInfo,
+                      const SymbolCacheInlinedFunctions* pInlinedFuncs,
+                      const gtVector<SymbolCacheLine>& sourceLines, const gtVector<std::string>& sourceFiles);
+
+    /// -----------------------------------------------------------------------------------------------
+    /// \brief Retrieves the number of symbol cache lookups of the process.
+    ///
+    /// \param[out] numHits The number of executables whose symbols were loaded from the cache.
+    /// \param[out] numMisses The number of executables whose cache file was missing or invalid.
+    /// -----------------------------------------------------------------------------------------------
+    static void GetStatistics(gtUInt32& numHits, gtUInt32& numMisses);
+
+private:
+    // An inlined function instance, with the FunctionSymbolInfo returned by the queries
+    struct InlinedFunction
+    {
+        FunctionSymbolInfo m_funcInfo;
+        gtRVAddr m_callerRva;
+        gtUInt32 m_callerSize;
+        gtUInt32 m_parentIndex;
+        gtUInt32 m_aggrIndex;   ///< The instance all the instances of the same name are aggregated to
+    };
+
+    bool MapFile(const wchar_t* pCacheFilePath);
+    bool LoadFunctionsInfo(const gtUByte* pFuncs, const gtUByte* pNames, gtUInt32 namesLength);
+    bool LoadInlinedFunctions(const gtUByte* pInlinedFuncs, const gtUByte* pRanges, const gtUByte* pNames, gtUInt32 namesLength);
+    const InlinedFunction* FindInlinedInstance(gtRVAddr rva) const;
+    void FindCallerInlinedInstances(gtRVAddr rva, const gtUInt32*& pBegin, const gtUInt32*& pEnd) const;
+    void Clear();
+
+    const ExecutableFile* m_pExe;
+    bool m_processInlineSamples;
+
+#if AMDT_BUILD_TARGET == AMDT_WINDOWS_OS
+    HANDLE m_hFile;
+    HANDLE m_hFileMapping;
+#endif
+    const gtUByte* m_pFileBase;
+    gtUInt64 m_fileSize;
+
+    // The source line table is used in place, from the mapped file
+    const SymbolCacheLine* m_pSourceLines;
+    gtUInt32 m_numSourceLines;
+    const gtUInt32* m_pSourceFileOffsets;
+    gtUInt32 m_numSourceFiles;
+    const char* m_pSourceFilePaths;
+    gtUInt32 m_sourceFilePathsSize;
+
+    // The inlined function instances, in the order of the file, and their indices sorted by caller
+    gtVector<InlinedFunction> m_inlinedFuncs;
+    gtVector<gtUInt32> m_inlinedFuncsByCaller;
+};
+
+#endif // _CACHEDSYMBOLENGINE_H_
@@ -27,15 +27,18 @@ public:
     /// -----------------------------------------------------------------------------------------------
     /// \brief Initializes the functions information of the image file.
     ///
+    /// \param[in] loadAddress The address the image file is loaded at.
+    /// \param[in] pCachePath The directory where to download the symbol file to.
+    ///
     /// \return A boolean value indicating success or failure of the initialization.
     /// -----------------------------------------------------------------------------------------------
-    bool Initialize(gtVAddr loadAddress = GT_INVALID_VADDR)
+    bool Initialize(gtVAddr loadAddress = GT_INVALID_VADDR, const wchar_t* pCachePath = NULL)
     {
         bool ret = false;
 
         if (m_exe.Open(loadAddress))
         {
-            if (m_exe.InitializeSymbolEngine())
+            if (m_exe.InitializeSymbolEngine(NULL, NULL, pCachePath))
             {
                 ret = true;
             }